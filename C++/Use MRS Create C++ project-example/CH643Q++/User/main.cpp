@@ -15,15 +15,41 @@
  *USART Print debugging routine:
  *USART1_Tx(PB10).
  *This example demonstrates using USART1(PB10) as a print debug port output.
+ *It also prints the USB descriptors of usb_desc.hpp, which are generated by
+ *the compiler from usbd_desc.hpp and stored in flash like a hand-written table.
  *
  */
 
 #include "debug.h"
+#include "usb_desc.hpp"
 
 /* Global define */
 
 /* Global Variable */
 
+/*********************************************************************
+ * @fn      Desc_Print
+ *
+ * @brief   Print one descriptor block with its flash address.
+ *
+ * @param   name - descriptor name
+ *          pbuf - descriptor
+ *          len - length
+ *
+ * @return  none
+ */
+static void Desc_Print(const char *name, const uint8_t *pbuf, uint16_t len)
+{
+    uint16_t i;
+
+    printf("%s @%08x, %d bytes:", name, (unsigned int)pbuf, len);
+    for(i = 0; i < len; i++)
+    {
+        printf("%s%02x", (i % 16) ? " " : "\r\n  ", pbuf[i]);
+    }
+    printf("\r\n");
+}
+
 /*********************************************************************
  * @fn      main
  *
@@ -40,6 +66,14 @@ int main(void)
     printf("SystemClk:%d\r\n", SystemCoreClock);
     printf( "ChipID:%08x\r\n", DBGMCU_GetCHIPID() );
     printf("This is printf example\r\n");
+
+    Desc_Print("Device", MyDevDescr.data(), MyDevDescr.size());
+    Desc_Print("Configuration", MyCfgDescr.data(), MyCfgDescr.size());
+    for(uint8_t i = 0; i < MyStrDescr.count(); i++)
+    {
+        printf("String %d", i);
+        Desc_Print("", MyStrDescr.get(i), MyStrDescr.get(i)[0]);
+    }
     while(1)
     {
     }
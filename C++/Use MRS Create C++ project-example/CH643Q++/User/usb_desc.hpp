@@ -0,0 +1,97 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : usb_desc.hpp
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Descriptors of the keyboard and mouse composite device
+ *                      (USB/USBFS/DEVICE/CompositeKM) built with usbd_desc.hpp.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef __USB_DESC_HPP
+#define __USB_DESC_HPP
+
+#include "usbd_desc.hpp"
+
+/* USB Device Info */
+#define DEF_USB_VID                   0x1A86
+#define DEF_USB_PID                   0xFE00
+#define DEF_IC_PRG_VER                0x01
+#define DEF_USBD_UEP0_SIZE            64
+
+#define DEF_USBD_REPORT_DESC_LEN_KB   0x3E
+#define DEF_USBD_REPORT_DESC_LEN_MS   0x34
+
+/* Device Descriptor */
+static constexpr auto MyDevDescr = usbd::device( 0x0200, 0x00, 0x00, 0x00, DEF_USBD_UEP0_SIZE,
+                                                 DEF_USB_VID, DEF_USB_PID, DEF_IC_PRG_VER << 8, 1, 2, 3 );
+
+/* Configuration Descriptor Set */
+static constexpr auto MyCfgDescr = usbd::configuration(
+    usbd::CFG_BUS_POWERED | usbd::CFG_REMOTE_WAKEUP, 100,
+
+    /* Keyboard */
+    usbd::interface( 0x03, 0x01, 0x01 ),
+    usbd::hid( DEF_USBD_REPORT_DESC_LEN_KB, 0x0111 ),
+    usbd::endpoint_in( usbd::EP_INTERRUPT, 8, 1 ),
+
+    /* Mouse */
+    usbd::interface( 0x03, 0x01, 0x02 ),
+    usbd::hid( DEF_USBD_REPORT_DESC_LEN_MS, 0x0110 ),
+    usbd::endpoint_in( usbd::EP_INTERRUPT, 8, 1 ) );
+
+/* HID descriptors inside the set, for GET_DESCRIPTOR(HID) */
+#define DEF_USBD_HID_DESC_OFS_KB      18
+#define DEF_USBD_HID_DESC_OFS_MS      43
+
+/* String Descriptors: language, manufacturer, product, serial number */
+static constexpr auto MyStrDescr = usbd::strings( 0x0409, "wch.cn", "CH643", "0123456789" );
+
+/*******************************************************************************/
+/* Compile-time check against the hand-written tables of CompositeKM/User/usb_desc.c */
+namespace usb_desc_ref
+{
+constexpr uint8_t DevDescr[ ] =
+{
+    0x12, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x40, 0x86, 0x1A, 0x00, 0xFE, 0x00, 0x01, 0x01, 0x02, 0x03, 0x01
+};
+
+constexpr uint8_t CfgDescr[ ] =
+{
+    0x09, 0x02, 0x3B, 0x00, 0x02, 0x01, 0x00, 0xA0, 0x32,
+    0x09, 0x04, 0x00, 0x00, 0x01, 0x03, 0x01, 0x01, 0x00,
+    0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, 0x3E, 0x00,
+    0x07, 0x05, 0x81, 0x03, 0x08, 0x00, 0x01,
+    0x09, 0x04, 0x01, 0x00, 0x01, 0x03, 0x01, 0x02, 0x00,
+    0x09, 0x21, 0x10, 0x01, 0x00, 0x01, 0x22, 0x34, 0x00,
+    0x07, 0x05, 0x82, 0x03, 0x08, 0x00, 0x01
+};
+
+constexpr uint8_t ManuInfo[ ] =
+{
+    0x0E, 0x03, 'w', 0, 'c', 0, 'h', 0, '.', 0, 'c', 0, 'n', 0
+};
+
+constexpr uint8_t ProdInfo[ ] =
+{
+    0x0C, 0x03, 'C', 0, 'H', 0, '6', 0, '4', 0, '3', 0
+};
+
+constexpr uint8_t SerNumInfo[ ] =
+{
+    0x16, 0x03, '0', 0, '1', 0, '2', 0, '3', 0, '4', 0, '5', 0, '6', 0, '7', 0, '8', 0, '9', 0
+};
+}
+
+static_assert( usbd::equal( MyDevDescr, usb_desc_ref::DevDescr ), "device descriptor differs" );
+static_assert( usbd::equal( MyCfgDescr, usb_desc_ref::CfgDescr ), "configuration descriptor differs" );
+static_assert( usbd::equal( MyStrDescr.get( 1 ), usb_desc_ref::ManuInfo ), "manufacturer string differs" );
+static_assert( usbd::equal( MyStrDescr.get( 2 ), usb_desc_ref::ProdInfo ), "product string differs" );
+static_assert( usbd::equal( MyStrDescr.get( 3 ), usb_desc_ref::SerNumInfo ), "serial number string differs" );
+static_assert( MyCfgDescr[ DEF_USBD_HID_DESC_OFS_KB + 1 ] == usbd::DESC_HID, "keyboard HID descriptor offset" );
+static_assert( MyCfgDescr[ DEF_USBD_HID_DESC_OFS_MS + 1 ] == usbd::DESC_HID, "mouse HID descriptor offset" );
+
+#endif
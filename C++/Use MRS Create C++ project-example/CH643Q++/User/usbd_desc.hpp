@@ -0,0 +1,315 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : usbd_desc.hpp
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Compile-time USB descriptor builder (C++14).
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ * Every function here is constexpr, so a descriptor declared as
+ *     static constexpr auto CfgDescr = usbd::configuration( ... );
+ * is evaluated by the compiler and placed in .rodata (flash) as plain bytes:
+ * no constructor runs at startup and nothing is copied to RAM.
+ *
+ * configuration() fills in what the hand-written tables keep by hand:
+ *   - wTotalLength and bNumInterfaces,
+ *   - bInterfaceNumber, counting interfaces in order (an alternate setting
+ *     keeps the number of the interface before it),
+ *   - bNumEndpoints of each interface,
+ *   - bFirstInterface of an interface association,
+ *   - endpoint numbers given as 0, one above the highest number used so far
+ *     in the same direction.
+ */
+
+#ifndef __USBD_DESC_HPP
+#define __USBD_DESC_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace usbd
+{
+
+/* Descriptor types */
+enum : uint8_t
+{
+    DESC_DEVICE    = 0x01,
+    DESC_CONFIG    = 0x02,
+    DESC_STRING    = 0x03,
+    DESC_INTERFACE = 0x04,
+    DESC_ENDPOINT  = 0x05,
+    DESC_IAD       = 0x0B,
+    DESC_HID       = 0x21,
+    DESC_REPORT    = 0x22,
+};
+
+/* Endpoint bmAttributes */
+enum : uint8_t
+{
+    EP_CONTROL     = 0x00,
+    EP_ISOCHRONOUS = 0x01,
+    EP_BULK        = 0x02,
+    EP_INTERRUPT   = 0x03,
+};
+
+/* Configuration bmAttributes */
+enum : uint8_t
+{
+    CFG_BUS_POWERED   = 0x80,
+    CFG_SELF_POWERED  = 0xC0,
+    CFG_REMOTE_WAKEUP = 0x20,
+};
+
+/* Descriptor bytes. A plain aggregate, so a constexpr instance is
+ * constant-initialized and its array can be handed to C code. */
+template< size_t N >
+struct Desc
+{
+    uint8_t d[ N ];
+
+    static constexpr size_t Size = N;
+    constexpr size_t size( void ) const { return N; }
+    constexpr const uint8_t *data( void ) const { return d; }
+    constexpr uint8_t operator[ ]( size_t i ) const { return d[ i ]; }
+};
+
+constexpr uint8_t lo( uint16_t v ) { return (uint8_t)v; }
+constexpr uint8_t hi( uint16_t v ) { return (uint8_t)( v >> 8 ); }
+
+/* Concatenation */
+template< size_t A, size_t B >
+constexpr Desc< A + B > operator+( const Desc< A > &a, const Desc< B > &b )
+{
+    Desc< A + B > r{ };
+    for( size_t i = 0; i < A; i++ )
+    {
+        r.d[ i ] = a.d[ i ];
+    }
+    for( size_t i = 0; i < B; i++ )
+    {
+        r.d[ A + i ] = b.d[ i ];
+    }
+    return r;
+}
+
+template< size_t A >
+constexpr Desc< A > cat( const Desc< A > &a )
+{
+    return a;
+}
+
+template< size_t A, typename... T >
+constexpr auto cat( const Desc< A > &a, const T &... t )
+{
+    return a + cat( t... );
+}
+
+/* Byte-wise comparison, e.g. against a hand-written table in a static_assert */
+template< size_t N, size_t M >
+constexpr bool equal( const Desc< N > &a, const uint8_t ( &b )[ M ] )
+{
+    if( N != M )
+    {
+        return false;
+    }
+    for( size_t i = 0; i < N; i++ )
+    {
+        if( a.d[ i ] != b[ i ] )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Same for a descriptor given by address, its length being its first byte */
+template< size_t M >
+constexpr bool equal( const uint8_t *a, const uint8_t ( &b )[ M ] )
+{
+    if( ( a == nullptr ) || ( a[ 0 ] != M ) )
+    {
+        return false;
+    }
+    for( size_t i = 0; i < M; i++ )
+    {
+        if( a[ i ] != b[ i ] )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*******************************************************************************/
+/* Device */
+constexpr Desc< 18 > device( uint16_t bcd_usb, uint8_t cls, uint8_t sub, uint8_t proto, uint8_t ep0_size,
+                             uint16_t vid, uint16_t pid, uint16_t bcd_dev,
+                             uint8_t i_manu, uint8_t i_prod, uint8_t i_sn, uint8_t num_cfg = 1 )
+{
+    return Desc< 18 >{ { 18, DESC_DEVICE, lo( bcd_usb ), hi( bcd_usb ), cls, sub, proto, ep0_size,
+                         lo( vid ), hi( vid ), lo( pid ), hi( pid ), lo( bcd_dev ), hi( bcd_dev ),
+                         i_manu, i_prod, i_sn, num_cfg } };
+}
+
+/* Interface; bInterfaceNumber and bNumEndpoints are filled in by configuration() */
+constexpr Desc< 9 > interface( uint8_t cls, uint8_t sub, uint8_t proto, uint8_t alt = 0, uint8_t i_itf = 0 )
+{
+    return Desc< 9 >{ { 9, DESC_INTERFACE, 0, alt, 0, cls, sub, proto, i_itf } };
+}
+
+/* Interface association; bFirstInterface is filled in by configuration() */
+constexpr Desc< 8 > iad( uint8_t itf_count, uint8_t cls, uint8_t sub, uint8_t proto, uint8_t i_func = 0 )
+{
+    return Desc< 8 >{ { 8, DESC_IAD, 0, itf_count, cls, sub, proto, i_func } };
+}
+
+/* Endpoints; num 0 lets configuration() choose the number */
+constexpr Desc< 7 > endpoint_in( uint8_t attr, uint16_t size, uint8_t interval, uint8_t num = 0 )
+{
+    return Desc< 7 >{ { 7, DESC_ENDPOINT, (uint8_t)( 0x80 | num ), attr, lo( size ), hi( size ), interval } };
+}
+
+constexpr Desc< 7 > endpoint_out( uint8_t attr, uint16_t size, uint8_t interval, uint8_t num = 0 )
+{
+    return Desc< 7 >{ { 7, DESC_ENDPOINT, num, attr, lo( size ), hi( size ), interval } };
+}
+
+/* HID class descriptor with one report descriptor */
+constexpr Desc< 9 > hid( uint16_t report_len, uint16_t bcd_hid = 0x0111, uint8_t country = 0 )
+{
+    return Desc< 9 >{ { 9, DESC_HID, lo( bcd_hid ), hi( bcd_hid ), country, 1,
+                        DESC_REPORT, lo( report_len ), hi( report_len ) } };
+}
+
+/* Fill in the numbering and totals of a configuration descriptor set */
+template< size_t N >
+constexpr Desc< N > number( Desc< N > c )
+{
+    size_t  i = 9;
+    size_t  itf_pos = 0;
+    uint8_t itf_next = 0, itf_cur = 0;
+    uint8_t ep_in = 0, ep_out = 0;
+    uint8_t num = 0;
+
+    for( i = 9; ( i + 1 < N ) && c.d[ i ]; i += c.d[ i ] )
+    {
+        switch( c.d[ i + 1 ] )
+        {
+            case DESC_IAD:
+                c.d[ i + 2 ] = itf_next;
+                break;
+
+            case DESC_INTERFACE:
+                if( c.d[ i + 3 ] == 0 )
+                {
+                    itf_cur = itf_next++;
+                }
+                c.d[ i + 2 ] = itf_cur;
+                c.d[ i + 4 ] = 0;
+                itf_pos = i;
+                break;
+
+            case DESC_ENDPOINT:
+                num = c.d[ i + 2 ] & 0x0F;
+                if( c.d[ i + 2 ] & 0x80 )
+                {
+                    num = num ? num : (uint8_t)( ep_in + 1 );
+                    ep_in = ( num > ep_in ) ? num : ep_in;
+                    c.d[ i + 2 ] = 0x80 | num;
+                }
+                else
+                {
+                    num = num ? num : (uint8_t)( ep_out + 1 );
+                    ep_out = ( num > ep_out ) ? num : ep_out;
+                    c.d[ i + 2 ] = num;
+                }
+                if( itf_pos )
+                {
+                    c.d[ itf_pos + 4 ]++;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+    c.d[ 2 ] = lo( N );
+    c.d[ 3 ] = hi( N );
+    c.d[ 4 ] = itf_next;
+    return c;
+}
+
+/* Configuration descriptor followed by its interfaces, endpoints and
+ * class descriptors, in the order given */
+template< typename... T >
+constexpr auto configuration( uint8_t attr, uint16_t power_ma, const T &... parts )
+{
+    return number( cat( Desc< 9 >{ { 9, DESC_CONFIG, 0, 0, 0, 1, 0, attr, (uint8_t)( power_ma / 2 ) } }, parts... ) );
+}
+
+/*******************************************************************************/
+/* Strings */
+constexpr Desc< 4 > language( uint16_t lang_id = 0x0409 )
+{
+    return Desc< 4 >{ { 4, DESC_STRING, lo( lang_id ), hi( lang_id ) } };
+}
+
+/* ASCII text to a UTF-16LE string descriptor; N counts the terminator */
+template< size_t N >
+constexpr Desc< 2 * N > string( const char ( &s )[ N ] )
+{
+    Desc< 2 * N > r{ };
+    r.d[ 0 ] = 2 * N;
+    r.d[ 1 ] = DESC_STRING;
+    for( size_t i = 0; i + 1 < N; i++ )
+    {
+        r.d[ 2 + 2 * i ] = (uint8_t)s[ i ];
+    }
+    return r;
+}
+
+/* All string descriptors of a device in one flash block, index 0 being
+ * the language descriptor. get() is what a GET_DESCRIPTOR(STRING)
+ * handler needs; the length is the first byte. */
+template< size_t N, size_t K >
+struct StrTable
+{
+    Desc< N > Buf;
+    uint16_t  Off[ K ];
+
+    constexpr size_t count( void ) const { return K; }
+    constexpr const uint8_t *get( uint8_t idx ) const
+    {
+        return ( idx < K ) ? &Buf.d[ Off[ idx ] ] : nullptr;
+    }
+};
+
+template< size_t N, size_t K >
+constexpr StrTable< N, K > str_index( const Desc< N > &buf )
+{
+    StrTable< N, K > t{ buf, { } };
+    size_t i = 0;
+
+    for( size_t k = 0; k < K; k++ )
+    {
+        t.Off[ k ] = (uint16_t)i;
+        i += buf.d[ i ];
+    }
+    return t;
+}
+
+template< typename... T >
+constexpr auto strings( uint16_t lang_id, const T &... s )
+{
+    return str_index< decltype( cat( language( lang_id ), string( s )... ) )::Size, 1 + sizeof...( T ) >(
+               cat( language( lang_id ), string( s )... ) );
+}
+
+} /* namespace usbd */
+
+#endif
@@ -0,0 +1,313 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : desc_test.cpp
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Unit tests of usbd_desc.hpp, built for the PC.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * usb_desc.hpp of CH643Q++ is compared byte by byte with the tables of
+ * USB/USBFS/DEVICE/CompositeKM/User/usb_desc.c, which is compiled in as it
+ * is, including the lengths the firmware takes from the first bytes. The
+ * other cases build descriptor sets that use what CompositeKM does not:
+ * interface associations, class-specific descriptors, alternate settings,
+ * automatic and explicit endpoint numbers and a wTotalLength above 255.
+ *
+ * Build:
+ *   g++ -std=c++14 -O2 -Wall -I../CH643Q++/User -o desc_test desc_test.cpp
+ *
+ * Usage:
+ *   desc_test    runs every case, exits non-zero if one fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+/* The hand-written tables, in their own namespace; stdint.h is already in */
+namespace km
+{
+#include "../../../EVT/EXAM/USB/USBFS/DEVICE/CompositeKM/User/usb_desc.c"
+}
+#undef DEF_IC_PRG_VER
+
+#include "usb_desc.hpp"
+
+static int Test_Fail;
+
+/*********************************************************************
+ * @fn      Test_Bytes
+ *
+ * @brief   Compare a generated descriptor with the expected bytes and
+ *          print the first difference.
+ *
+ * @param   name - what is compared
+ *          pa - generated bytes
+ *          na - their length
+ *          pb - expected bytes
+ *          nb - their length
+ *
+ * @return  none
+ */
+static void Test_Bytes( const char *name, const uint8_t *pa, size_t na, const uint8_t *pb, size_t nb )
+{
+    size_t i;
+
+    if( pa == nullptr )
+    {
+        printf( "  %s: no descriptor\n", name );
+        Test_Fail++;
+        return;
+    }
+    if( na != nb )
+    {
+        printf( "  %s: %u bytes, expected %u\n", name, (unsigned)na, (unsigned)nb );
+        Test_Fail++;
+        return;
+    }
+    for( i = 0; i < na; i++ )
+    {
+        if( pa[ i ] != pb[ i ] )
+        {
+            printf( "  %s: byte %u is %02x, expected %02x\n", name, (unsigned)i, pa[ i ], pb[ i ] );
+            Test_Fail++;
+            return;
+        }
+    }
+}
+
+#define TEST_DESC( name, d, ref )       Test_Bytes( name, ( d ).data( ), ( d ).size( ), ref, sizeof( ref ) )
+#define TEST_STR( name, p, ref )        Test_Bytes( name, p, ( p ) ? ( p )[ 0 ] : 0, ref, sizeof( ref ) )
+#define TEST( cond )                                                    \
+    do                                                                  \
+    {                                                                   \
+        if( !( cond ) )                                                 \
+        {                                                               \
+            printf( "  line %d: %s\n", __LINE__, #cond );               \
+            Test_Fail++;                                                \
+        }                                                               \
+    } while( 0 )
+
+/*********************************************************************
+ * @fn      Test_CompositeKM
+ *
+ * @brief   usb_desc.hpp against CompositeKM/User/usb_desc.c.
+ *
+ * @return  none
+ */
+static void Test_CompositeKM( void )
+{
+    TEST_DESC( "device", MyDevDescr, km::MyDevDescr );
+    TEST_DESC( "configuration", MyCfgDescr, km::MyCfgDescr );
+    TEST_STR( "language", MyStrDescr.get( 0 ), km::MyLangDescr );
+    TEST_STR( "manufacturer", MyStrDescr.get( 1 ), km::MyManuInfo );
+    TEST_STR( "product", MyStrDescr.get( 2 ), km::MyProdInfo );
+    TEST_STR( "serial number", MyStrDescr.get( 3 ), km::MySerNumInfo );
+    TEST( MyStrDescr.count( ) == 4 );
+    TEST( MyStrDescr.get( 4 ) == nullptr );
+
+    /* What the firmware sends is the length it finds in the table */
+    TEST( km::MyDevDescr[ 0 ] == sizeof( km::MyDevDescr ) );
+    TEST( ( km::MyCfgDescr[ 2 ] | ( km::MyCfgDescr[ 3 ] << 8 ) ) == sizeof( km::MyCfgDescr ) );
+    TEST( km::MyLangDescr[ 0 ] == sizeof( km::MyLangDescr ) );
+    TEST( km::MyManuInfo[ 0 ] == sizeof( km::MyManuInfo ) );
+    TEST( km::MyProdInfo[ 0 ] == sizeof( km::MyProdInfo ) );
+    TEST( km::MySerNumInfo[ 0 ] == sizeof( km::MySerNumInfo ) );
+
+    /* HID descriptors and report descriptor lengths */
+    TEST( DEF_USBD_REPORT_DESC_LEN_KB == sizeof( km::KeyRepDesc ) );
+    TEST( DEF_USBD_REPORT_DESC_LEN_MS == sizeof( km::MouseRepDesc ) );
+    TEST( memcmp( &MyCfgDescr.data( )[ DEF_USBD_HID_DESC_OFS_KB ], &km::MyCfgDescr[ DEF_USBD_HID_DESC_OFS_KB ], 9 ) == 0 );
+    TEST( memcmp( &MyCfgDescr.data( )[ DEF_USBD_HID_DESC_OFS_MS ], &km::MyCfgDescr[ DEF_USBD_HID_DESC_OFS_MS ], 9 ) == 0 );
+}
+
+/*********************************************************************
+ * @fn      Test_Cdc_Hid
+ *
+ * @brief   The SimulateCDC-HID set: an interface association, CDC
+ *          functional descriptors and explicit endpoint numbers.
+ *
+ * @return  none
+ */
+static void Test_Cdc_Hid( void )
+{
+    static constexpr auto cfg = usbd::configuration(
+        usbd::CFG_BUS_POWERED, 100,
+        usbd::iad( 2, 0x02, 0x02, 0x01 ),
+        usbd::interface( 0x02, 0x02, 0x01 ),
+        usbd::Desc< 5 >{ { 0x05, 0x24, 0x00, 0x10, 0x01 } },
+        usbd::Desc< 5 >{ { 0x05, 0x24, 0x01, 0x00, 0x01 } },
+        usbd::Desc< 4 >{ { 0x04, 0x24, 0x02, 0x02 } },
+        usbd::Desc< 5 >{ { 0x05, 0x24, 0x06, 0x00, 0x01 } },
+        usbd::endpoint_in( usbd::EP_INTERRUPT, 64, 1, 1 ),
+        usbd::interface( 0x0A, 0x00, 0x00 ),
+        usbd::endpoint_out( usbd::EP_BULK, 64, 0, 2 ),
+        usbd::endpoint_in( usbd::EP_BULK, 64, 0, 3 ),
+        usbd::interface( 0x03, 0x00, 0x00 ),
+        usbd::hid( 34, 0x0100 ),
+        usbd::endpoint_in( usbd::EP_INTERRUPT, 64, 1, 4 ),
+        usbd::endpoint_out( usbd::EP_INTERRUPT, 64, 1, 4 ) );
+
+    static const uint8_t ref[ ] =
+    {
+        0x09, 0x02, 0x6B, 0x00, 0x03, 0x01, 0x00, 0x80, 0x32,
+        0x08, 0x0B, 0x00, 0x02, 0x02, 0x02, 0x01, 0x00,
+        0x09, 0x04, 0x00, 0x00, 0x01, 0x02, 0x02, 0x01, 0x00,
+        0x05, 0x24, 0x00, 0x10, 0x01,
+        0x05, 0x24, 0x01, 0x00, 0x01,
+        0x04, 0x24, 0x02, 0x02,
+        0x05, 0x24, 0x06, 0x00, 0x01,
+        0x07, 0x05, 0x81, 0x03, 0x40, 0x00, 0x01,
+        0x09, 0x04, 0x01, 0x00, 0x02, 0x0A, 0x00, 0x00, 0x00,
+        0x07, 0x05, 0x02, 0x02, 0x40, 0x00, 0x00,
+        0x07, 0x05, 0x83, 0x02, 0x40, 0x00, 0x00,
+        0x09, 0x04, 0x02, 0x00, 0x02, 0x03, 0x00, 0x00, 0x00,
+        0x09, 0x21, 0x00, 0x01, 0x00, 0x01, 0x22, 0x22, 0x00,
+        0x07, 0x05, 0x84, 0x03, 0x40, 0x00, 0x01,
+        0x07, 0x05, 0x04, 0x03, 0x40, 0x00, 0x01,
+    };
+
+    TEST_DESC( "configuration", cfg, ref );
+}
+
+/*********************************************************************
+ * @fn      Test_Numbering
+ *
+ * @brief   Automatic endpoint numbers, an alternate setting with an
+ *          explicit endpoint, an association placed after it.
+ *
+ * @return  none
+ */
+static void Test_Numbering( void )
+{
+    static constexpr auto cfg = usbd::configuration(
+        usbd::CFG_BUS_POWERED, 500,
+        usbd::interface( 0xFF, 0x00, 0x00 ),
+        usbd::endpoint_in( usbd::EP_BULK, 64, 0 ),
+        usbd::endpoint_out( usbd::EP_BULK, 64, 0 ),
+        usbd::endpoint_in( usbd::EP_INTERRUPT, 8, 1 ),
+        usbd::interface( 0xFF, 0x00, 0x00, 1 ),
+        usbd::endpoint_in( usbd::EP_ISOCHRONOUS, 1023, 1, 1 ),
+        usbd::iad( 2, 0x01, 0x00, 0x00 ),
+        usbd::interface( 0x01, 0x01, 0x00 ),
+        usbd::interface( 0x01, 0x02, 0x00 ),
+        usbd::endpoint_out( usbd::EP_ISOCHRONOUS, 1023, 1 ) );
+
+    static const uint8_t ref[ ] =
+    {
+        0x09, 0x02, 0x58, 0x00, 0x03, 0x01, 0x00, 0x80, 0xFA,
+        0x09, 0x04, 0x00, 0x00, 0x03, 0xFF, 0x00, 0x00, 0x00,
+        0x07, 0x05, 0x81, 0x02, 0x40, 0x00, 0x00,
+        0x07, 0x05, 0x01, 0x02, 0x40, 0x00, 0x00,
+        0x07, 0x05, 0x82, 0x03, 0x08, 0x00, 0x01,
+        0x09, 0x04, 0x00, 0x01, 0x01, 0xFF, 0x00, 0x00, 0x00,
+        0x07, 0x05, 0x81, 0x01, 0xFF, 0x03, 0x01,
+        0x08, 0x0B, 0x01, 0x02, 0x01, 0x00, 0x00, 0x00,
+        0x09, 0x04, 0x01, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00,
+        0x09, 0x04, 0x02, 0x00, 0x01, 0x01, 0x02, 0x00, 0x00,
+        0x07, 0x05, 0x02, 0x01, 0xFF, 0x03, 0x01,
+    };
+
+    TEST_DESC( "configuration", cfg, ref );
+}
+
+/*********************************************************************
+ * @fn      Test_Long
+ *
+ * @brief   wTotalLength above 255, numbering past a large class block.
+ *
+ * @return  none
+ */
+static void Test_Long( void )
+{
+    static constexpr auto cfg = usbd::configuration(
+        usbd::CFG_SELF_POWERED, 0,
+        usbd::interface( 0xFF, 0x00, 0x00 ),
+        usbd::Desc< 250 >{ { 250, 0x24 } },
+        usbd::endpoint_in( usbd::EP_BULK, 512, 0 ) );
+
+    TEST( cfg.size( ) == 275 );
+    TEST( cfg[ 2 ] == 0x13 );
+    TEST( cfg[ 3 ] == 0x01 );
+    TEST( cfg[ 4 ] == 1 );
+    TEST( cfg[ 7 ] == 0xC0 );
+    TEST( cfg[ 8 ] == 0 );
+    TEST( cfg[ 9 + 4 ] == 1 );
+    TEST( cfg[ 268 + 2 ] == 0x81 );
+    TEST( cfg[ 268 + 4 ] == 0x00 );
+    TEST( cfg[ 268 + 5 ] == 0x02 );
+}
+
+/*********************************************************************
+ * @fn      Test_Strings
+ *
+ * @brief   string(), strings() and equal() on their own.
+ *
+ * @return  none
+ */
+static void Test_Strings( void )
+{
+    static constexpr auto s = usbd::strings( 0x0804, "", "A" );
+    static const uint8_t lang[ ] = { 0x04, 0x03, 0x04, 0x08 };
+    static const uint8_t empty[ ] = { 0x02, 0x03 };
+    static const uint8_t one[ ] = { 0x04, 0x03, 'A', 0 };
+    static const uint8_t other[ ] = { 0x04, 0x03, 'B', 0 };
+    static const uint8_t longer[ ] = { 0x06, 0x03, 'A', 0, 'B', 0 };
+
+    TEST_STR( "language", s.get( 0 ), lang );
+    TEST_STR( "empty", s.get( 1 ), empty );
+    TEST_STR( "one character", s.get( 2 ), one );
+    TEST( s.count( ) == 3 );
+    TEST( s.get( 3 ) == nullptr );
+    TEST( sizeof( s.Buf.d ) == sizeof( lang ) + sizeof( empty ) + sizeof( one ) );
+
+    TEST( usbd::equal( s.get( 2 ), one ) );
+    TEST( !usbd::equal( s.get( 2 ), other ) );
+    TEST( !usbd::equal( s.get( 2 ), longer ) );
+    TEST( !usbd::equal( s.get( 3 ), one ) );
+    TEST( usbd::equal( usbd::string( "A" ), one ) );
+    TEST( !usbd::equal( usbd::string( "A" ), longer ) );
+    TEST( !usbd::equal( usbd::string( "B" ), one ) );
+}
+
+int main( void )
+{
+    static const struct
+    {
+        const char *Name;
+        void ( *Run )( void );
+    } test[ ] =
+    {
+        { "CompositeKM tables", Test_CompositeKM },
+        { "SimulateCDC-HID configuration", Test_Cdc_Hid },
+        { "interface and endpoint numbering", Test_Numbering },
+        { "configuration above 255 bytes", Test_Long },
+        { "strings and equal()", Test_Strings },
+    };
+    size_t i;
+    int fail = 0, last;
+
+    for( i = 0; i < sizeof( test ) / sizeof( test[ 0 ] ); i++ )
+    {
+        printf( "%s\n", test[ i ].Name );
+        last = Test_Fail;
+        test[ i ].Run( );
+        if( Test_Fail != last )
+        {
+            printf( "  FAIL\n" );
+            fail++;
+        }
+        else
+        {
+            printf( "  ok\n" );
+        }
+    }
+    printf( "%s\n", fail ? "tests FAILED" : "tests passed" );
+    return fail ? 1 : 0;
+}
@@ -0,0 +1,612 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : kv_store.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Log-structured key-value store on fast-programmed
+ *                      internal flash pages. Records are appended to a page
+ *                      in RAM that is programmed on commit; the oldest pages
+ *                      are packed into a new one and erased in the background.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#include "debug.h"
+#include "kv_store.h"
+#include <string.h>
+
+#define KV_PG_BAD         3                               // Does not erase, never used again
+#define KV_BUF_PAGE       KV_PAGE_NUM                     // Page number of Buf in a location
+
+#define KV_PAGE_ADDR(p)   ( KV_FLASH_BASE + (uint32_t)(p) * KV_PAGE_SIZE )
+#define KV_PAGE_PTR(p)    ( (const uint8_t *)(uintptr_t)KV_PAGE_ADDR(p) )
+#define KV_LOC(p, off)    ( (uint16_t)( ( (p) << 8 ) | (off) ) )
+#define KV_LOC_PAGE(loc)  ( (loc) >> 8 )
+#define KV_LOC_OFF(loc)   ( (loc) & 0xFF )
+
+KV_STORE Kv;
+
+/*********************************************************************
+ * @fn      KV_Crc32
+ *
+ * @brief   CRC32 (IEEE 802.3) without a table.
+ *
+ * @return  CRC32
+ */
+static uint32_t KV_Crc32(const uint8_t *pbuf, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t i;
+
+    while(len--){
+        crc ^= *pbuf++;
+        for(i = 0; i < 8; i++){
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+/*********************************************************************
+ * @fn      KV_Rec
+ *
+ * @brief   Record at a location, in flash or in Buf.
+ *
+ * @return  record
+ */
+static const uint8_t *KV_Rec(uint16_t loc)
+{
+    if(KV_LOC_PAGE(loc) == KV_BUF_PAGE){
+        return (const uint8_t *)Kv.Buf + KV_LOC_OFF(loc);
+    }
+    return KV_PAGE_PTR(KV_LOC_PAGE(loc)) + KV_LOC_OFF(loc);
+}
+
+static uint16_t KV_Rec_Key(const uint8_t *prec)
+{
+    return prec[0] | (prec[1] << 8);
+}
+
+static uint16_t KV_Rec_Len(const uint8_t *prec)
+{
+    return prec[2] | (prec[3] << 8);
+}
+
+static uint16_t KV_Rec_Bytes(const uint8_t *prec)
+{
+    uint16_t len = KV_Rec_Len(prec);
+
+    return (len == KV_LEN_DEL) ? 4 : KV_REC_SIZE(len);
+}
+
+/* Bytes a record takes when moved: a deletion is never moved */
+static uint16_t KV_Rec_Live(const uint8_t *prec)
+{
+    return (KV_Rec_Len(prec) == KV_LEN_DEL) ? 0 : KV_Rec_Bytes(prec);
+}
+
+/*********************************************************************
+ * @fn      KV_Link
+ *
+ * @brief   Make a record the newest of its key, keeping the live bytes
+ *          of the pages.
+ *
+ * @param   loc - the record, or KV_LOC_NONE to forget the key
+ *
+ * @return  none
+ */
+static void KV_Link(uint16_t key, uint16_t loc)
+{
+    uint16_t old = Kv.Index[key];
+    uint16_t n;
+
+    if(old != KV_LOC_NONE){
+        n = KV_Rec_Live(KV_Rec(old));
+        Kv.Live[KV_LOC_PAGE(old)] -= n;
+        Kv.Live_Total -= n;
+    }
+    Kv.Index[key] = loc;
+    if(loc != KV_LOC_NONE){
+        n = KV_Rec_Live(KV_Rec(loc));
+        Kv.Live[KV_LOC_PAGE(loc)] += n;
+        Kv.Live_Total += n;
+    }
+}
+
+/*********************************************************************
+ * @fn      KV_State
+ *
+ * @brief   Change the state of a page, keeping the counts.
+ *
+ * @return  none
+ */
+static void KV_State(uint8_t p, uint8_t state)
+{
+    Kv.Blank -= (Kv.State[p] == KV_PG_BLANK);
+    Kv.Dirty -= (Kv.State[p] == KV_PG_DIRTY);
+    Kv.State[p] = state;
+    Kv.Blank += (state == KV_PG_BLANK);
+    Kv.Dirty += (state == KV_PG_DIRTY);
+}
+
+/*********************************************************************
+ * @fn      KV_Page_Valid
+ *
+ * @brief   Check a page was programmed completely.
+ *
+ * @return  1 - valid
+ */
+static uint8_t KV_Page_Valid(uint8_t p)
+{
+    const uint32_t *pw = (const uint32_t *)KV_PAGE_PTR(p);
+
+    if((pw[0] != KV_PAGE_MAGIC) || (pw[2] > KV_PAYLOAD) || (pw[2] & 3)){
+        return 0;
+    }
+    return KV_Crc32((const uint8_t *)pw, KV_PAGE_SIZE - 4) == pw[KV_PAGE_SIZE / 4 - 1];
+}
+
+/*********************************************************************
+ * @fn      KV_Page_Blank
+ *
+ * @brief   Check a page is erased: all words alike, which a programmed
+ *          page never is, whatever erased flash reads as.
+ *
+ * @return  1 - erased
+ */
+static uint8_t KV_Page_Blank(uint8_t p)
+{
+    const uint32_t *pw = (const uint32_t *)KV_PAGE_PTR(p);
+    uint16_t i;
+
+    for(i = 1; i < KV_PAGE_SIZE / 4; i++){
+        if(pw[i] != pw[0]){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*********************************************************************
+ * @fn      KV_Next_Page
+ *
+ * @brief   Used page written first after a sequence number.
+ *
+ * @return  page, or KV_PAGE_NUM if none
+ */
+static uint8_t KV_Next_Page(uint32_t seq)
+{
+    uint8_t p, next = KV_PAGE_NUM;
+
+    for(p = 0; p < KV_PAGE_NUM; p++){
+        if((Kv.State[p] == KV_PG_USED) && (Kv.Seq[p] > seq) &&
+           ((next == KV_PAGE_NUM) || (Kv.Seq[p] < Kv.Seq[next]))){
+            next = p;
+        }
+    }
+    return next;
+}
+
+/*********************************************************************
+ * @fn      KV_Erase
+ *
+ * @brief   Erase a page, giving it up if it does not erase.
+ *
+ * @return  none
+ */
+static void KV_Erase(uint8_t p)
+{
+    FLASH_Unlock_Fast();
+    FLASH_ErasePage_Fast(KV_PAGE_ADDR(p));
+    FLASH_Lock_Fast();
+    Kv.Erase_Cnt++;
+
+    Kv.Erased[p] = 1;
+    Kv.Seq[p] = 0;
+    KV_State(p, KV_Page_Blank(p) ? KV_PG_BLANK : KV_PG_BAD);
+}
+
+/*********************************************************************
+ * @fn      KV_Erase_Dirty
+ *
+ * @brief   Erase the dirty page written first, so a value is never left
+ *          behind once a newer page deleting it is erased.
+ *
+ * @return  none
+ */
+static void KV_Erase_Dirty(void)
+{
+    uint8_t p, q = KV_PAGE_NUM;
+
+    for(p = 0; p < KV_PAGE_NUM; p++){
+        if((Kv.State[p] == KV_PG_DIRTY) && ((q == KV_PAGE_NUM) || (Kv.Seq[p] < Kv.Seq[q]))){
+            q = p;
+        }
+    }
+    if(q < KV_PAGE_NUM){
+        KV_Erase(q);
+    }
+}
+
+/*********************************************************************
+ * @fn      KV_Write
+ *
+ * @brief   Close Buf as the next page and program it into an erased page.
+ *
+ * @return  1 - programmed and read back
+ */
+static uint8_t KV_Write(uint8_t p)
+{
+    uint8_t *pbuf = (uint8_t *)Kv.Buf;
+    uint32_t addr = KV_PAGE_ADDR(p);
+    uint16_t i;
+
+    Kv.Buf[0] = KV_PAGE_MAGIC;
+    Kv.Buf[1] = Kv.Seq_Next++;
+    Kv.Buf[2] = Kv.Used;
+    memset(pbuf + KV_HEAD_LEN + Kv.Used, 0, KV_PAYLOAD - Kv.Used);
+    Kv.Buf[KV_PAGE_SIZE / 4 - 1] = KV_Crc32(pbuf, KV_PAGE_SIZE - 4);
+
+    FLASH_Unlock_Fast();
+    FLASH_BufReset();
+    for(i = 0; i < KV_PAGE_SIZE / 4; i++){
+        FLASH_BufLoad(addr + 4 * i, Kv.Buf[i]);
+    }
+    FLASH_ProgramPage_Fast(addr);
+    FLASH_Lock_Fast();
+    Kv.Prog_Cnt++;
+    Kv.Erased[p] = 0;
+
+    return memcmp(KV_PAGE_PTR(p), pbuf, KV_PAGE_SIZE) == 0;
+}
+
+/*********************************************************************
+ * @fn      KV_Program
+ *
+ * @brief   Program Buf into the next erased page round the area, and
+ *          move the records in it there.
+ *
+ * @return  KV_OK, or KV_ERR_FULL if no erased page took it
+ */
+static uint8_t KV_Program(void)
+{
+    uint16_t i;
+    uint8_t p;
+
+    for(p = (Kv.Last + 1) % KV_PAGE_NUM; Kv.Blank; p = (p + 1) % KV_PAGE_NUM){
+        if(Kv.State[p] != KV_PG_BLANK){
+            continue;
+        }
+        if(!Kv.Erased[p]){
+            KV_Erase(p);
+            if(Kv.State[p] != KV_PG_BLANK){
+                continue;
+            }
+        }
+        if(!KV_Write(p)){
+            /* Did not read back: worn, erase it once more */
+            KV_Erase(p);
+            if((Kv.State[p] != KV_PG_BLANK) || !KV_Write(p)){
+                KV_State(p, KV_PG_DIRTY);
+                continue;
+            }
+        }
+        Kv.Seq[p] = Kv.Buf[1];
+        Kv.Last = p;
+        KV_State(p, KV_PG_USED);
+
+        Kv.Live[p] = Kv.Live[KV_BUF_PAGE];
+        Kv.Live[KV_BUF_PAGE] = 0;
+        for(i = 0; i < KV_KEY_NUM; i++){
+            if((Kv.Index[i] != KV_LOC_NONE) && (KV_LOC_PAGE(Kv.Index[i]) == KV_BUF_PAGE)){
+                Kv.Index[i] = KV_LOC(p, KV_LOC_OFF(Kv.Index[i]));
+            }
+        }
+        Kv.Used = 0;
+        return KV_OK;
+    }
+    return KV_ERR_FULL;
+}
+
+/*********************************************************************
+ * @fn      KV_Move
+ *
+ * @brief   Copy the newest records of a page into Buf. Deletions are
+ *          dropped: the page is the oldest left, no value is under them,
+ *          so a page holding nothing but deletions is free to erase.
+ *
+ * @return  none
+ */
+static void KV_Move(uint8_t p)
+{
+    const uint8_t *pbase = KV_PAGE_PTR(p);
+    uint16_t end = KV_HEAD_LEN + ((const uint32_t *)pbase)[2];
+    uint16_t off, key, n;
+
+    for(off = KV_HEAD_LEN; off < end; off += n){
+        key = KV_Rec_Key(pbase + off);
+        n = KV_Rec_Bytes(pbase + off);
+        if((key >= KV_KEY_NUM) || (Kv.Index[key] != KV_LOC(p, off))){
+            continue;
+        }
+        if(KV_Rec_Len(pbase + off) == KV_LEN_DEL){
+            KV_Link(key, KV_LOC_NONE);
+            continue;
+        }
+        memcpy((uint8_t *)Kv.Buf + KV_HEAD_LEN + Kv.Used, pbase + off, n);
+        KV_Link(key, KV_LOC(KV_BUF_PAGE, KV_HEAD_LEN + Kv.Used));
+        Kv.Used += n;
+    }
+}
+
+/*********************************************************************
+ * @fn      KV_Compact
+ *
+ * @brief   Pack the records left in the oldest pages into one page and
+ *          have those pages erased. Only while no commit is open and no
+ *          page waits to be erased.
+ *
+ * @param   force - also when no page is gained, turning the oldest page
+ *                  over so the next ones get packed
+ *
+ * @return  pages to be erased
+ */
+static uint8_t KV_Compact(uint8_t force)
+{
+    uint8_t v[ KV_PAGE_NUM ];
+    uint32_t seq = 0;
+    uint16_t sum = 0;
+    uint8_t n = 0, p, i;
+
+    if(Kv.Used || Kv.Dirty){
+        return 0;
+    }
+    /* With no page erased, only pages holding nothing live are taken */
+    for(p = KV_Next_Page(0); p < KV_PAGE_NUM; p = KV_Next_Page(seq)){
+        if((sum + Kv.Live[p] > KV_PAYLOAD) || (Kv.Live[p] && !Kv.Blank)){
+            break;
+        }
+        sum += Kv.Live[p];
+        seq = Kv.Seq[p];
+        v[n++] = p;
+    }
+    if((n == 0) || ((n == 1) && sum && !force)){
+        return 0;
+    }
+
+    for(i = 0; i < n; i++){
+        KV_Move(v[i]);
+    }
+    if(Kv.Used && (KV_Program() != KV_OK)){
+        return 0;
+    }
+    for(i = 0; i < n; i++){
+        KV_State(v[i], KV_PG_DIRTY);
+    }
+    return n;
+}
+
+/*********************************************************************
+ * @fn      KV_Reclaim
+ *
+ * @brief   Get KV_FREE_MIN pages erased before a commit starts.
+ *
+ * @return  KV_OK, or KV_ERR_FULL
+ */
+static uint8_t KV_Reclaim(void)
+{
+    uint8_t i;
+
+    for(i = 0; (Kv.Blank < KV_FREE_MIN) && (i < 4 * KV_PAGE_NUM); i++){
+        if(Kv.Dirty){
+            KV_Erase_Dirty();
+        }
+        else{
+            KV_Compact(1);
+        }
+    }
+    return (Kv.Blank >= KV_FREE_MIN) ? KV_OK : KV_ERR_FULL;
+}
+
+/*********************************************************************
+ * @fn      KV_Append
+ *
+ * @brief   Add a record to the commit, starting one if needed. A commit
+ *          is one page: a record that does not fit is refused, the
+ *          commit staying open as it was.
+ *
+ * @param   len - value length, or KV_LEN_DEL
+ *
+ * @return  KV_OK, KV_ERR_LEN - the commit is full, or KV_ERR_FULL
+ */
+static uint8_t KV_Append(uint16_t key, const void *pbuf, uint16_t len)
+{
+    uint16_t n = (len == KV_LEN_DEL) ? 4 : KV_REC_SIZE(len);
+    uint16_t live = (len == KV_LEN_DEL) ? 0 : n;
+    uint16_t old = 0;
+    uint8_t *prec;
+
+    if(Kv.Index[key] != KV_LOC_NONE){
+        old = KV_Rec_Live(KV_Rec(Kv.Index[key]));
+    }
+    if(Kv.Live_Total - old + live > KV_LIVE_MAX){
+        return KV_ERR_FULL;
+    }
+    if(Kv.Used + n > KV_PAYLOAD){
+        return KV_ERR_LEN;
+    }
+    if((Kv.Used == 0) && (KV_Reclaim() != KV_OK)){
+        return KV_ERR_FULL;
+    }
+
+    prec = (uint8_t *)Kv.Buf + KV_HEAD_LEN + Kv.Used;
+    prec[0] = (uint8_t)key;
+    prec[1] = (uint8_t)(key >> 8);
+    prec[2] = (uint8_t)len;
+    prec[3] = (uint8_t)(len >> 8);
+    if(len != KV_LEN_DEL){
+        memcpy(prec + 4, pbuf, len);
+        memset(prec + 4 + len, 0, n - 4 - len);
+    }
+    KV_Link(key, KV_LOC(KV_BUF_PAGE, KV_HEAD_LEN + Kv.Used));
+    Kv.Used += n;
+    return KV_OK;
+}
+
+/*********************************************************************
+ * @fn      KV_Init
+ *
+ * @brief   Mount the store: replay the valid pages in the order they were
+ *          written into the index, and have the others erased.
+ *
+ * @return  KV_OK
+ */
+uint8_t KV_Init(void)
+{
+    const uint8_t *pbase;
+    uint32_t seq = 0;
+    uint16_t off, end, n;
+    uint8_t p;
+
+    memset(&Kv, 0, sizeof(Kv));
+    memset(Kv.Index, 0xFF, sizeof(Kv.Index));
+    for(p = 0; p < KV_PAGE_NUM; p++){
+        Kv.State[p] = KV_PG_BAD;
+        if(KV_Page_Valid(p)){
+            Kv.Seq[p] = ((const uint32_t *)KV_PAGE_PTR(p))[1];
+            KV_State(p, KV_PG_USED);
+        }
+        else{
+            KV_State(p, KV_Page_Blank(p) ? KV_PG_BLANK : KV_PG_DIRTY);
+        }
+    }
+
+    Kv.Last = KV_PAGE_NUM - 1;
+    for(p = KV_Next_Page(0); p < KV_PAGE_NUM; p = KV_Next_Page(seq)){
+        pbase = KV_PAGE_PTR(p);
+        end = KV_HEAD_LEN + ((const uint32_t *)pbase)[2];
+        for(off = KV_HEAD_LEN; off + 4 <= end; off += n){
+            n = KV_Rec_Bytes(pbase + off);
+            if(off + n > end){
+                break;
+            }
+            if(KV_Rec_Key(pbase + off) < KV_KEY_NUM){
+                KV_Link(KV_Rec_Key(pbase + off), KV_LOC(p, off));
+            }
+        }
+        seq = Kv.Seq[p];
+        Kv.Last = p;
+    }
+    Kv.Seq_Next = seq + 1;
+    return KV_OK;
+}
+
+/*********************************************************************
+ * @fn      KV_Get
+ *
+ * @brief   Read the value of a key, the commit in progress included.
+ *
+ * @param   pbuf - value
+ *          size - room in pbuf, a longer value is cut
+ *          plen - length of the value
+ *
+ * @return  KV_OK, KV_ERR_KEY or KV_ERR_NONE
+ */
+uint8_t KV_Get(uint16_t key, void *pbuf, uint16_t size, uint16_t *plen)
+{
+    const uint8_t *prec;
+    uint16_t len;
+
+    if(key >= KV_KEY_NUM){
+        return KV_ERR_KEY;
+    }
+    if(Kv.Index[key] == KV_LOC_NONE){
+        return KV_ERR_NONE;
+    }
+    prec = KV_Rec(Kv.Index[key]);
+    len = KV_Rec_Len(prec);
+    if(len == KV_LEN_DEL){
+        return KV_ERR_NONE;
+    }
+    memcpy(pbuf, prec + 4, (len < size) ? len : size);
+    *plen = len;
+    return KV_OK;
+}
+
+/*********************************************************************
+ * @fn      KV_Set
+ *
+ * @brief   Set the value of a key. It is kept in flash once committed,
+ *          together with the other records of the commit. KV_ERR_LEN is
+ *          also returned when the commit has no room left for it.
+ *
+ * @return  KV_OK, KV_ERR_KEY, KV_ERR_LEN or KV_ERR_FULL
+ */
+uint8_t KV_Set(uint16_t key, const void *pbuf, uint16_t len)
+{
+    if(key >= KV_KEY_NUM){
+        return KV_ERR_KEY;
+    }
+    if(len > KV_VALUE_MAX){
+        return KV_ERR_LEN;
+    }
+    return KV_Append(key, pbuf, len);
+}
+
+/*********************************************************************
+ * @fn      KV_Del
+ *
+ * @brief   Delete a key, once committed.
+ *
+ * @return  KV_OK, KV_ERR_KEY, KV_ERR_LEN or KV_ERR_FULL
+ */
+uint8_t KV_Del(uint16_t key)
+{
+    if(key >= KV_KEY_NUM){
+        return KV_ERR_KEY;
+    }
+    if((Kv.Index[key] == KV_LOC_NONE) || (KV_Rec_Len(KV_Rec(Kv.Index[key])) == KV_LEN_DEL)){
+        return KV_OK;
+    }
+    return KV_Append(key, NULL, KV_LEN_DEL);
+}
+
+/*********************************************************************
+ * @fn      KV_Commit
+ *
+ * @brief   Program the records set since the last commit into one page.
+ *          A reset keeps all of them or none. A record that would make
+ *          the commit longer than a page is refused by KV_Set/KV_Del.
+ *
+ * @return  KV_OK, or KV_ERR_FULL
+ */
+uint8_t KV_Commit(void)
+{
+    if(Kv.Used == 0){
+        return KV_OK;
+    }
+    return KV_Program();
+}
+
+/*********************************************************************
+ * @fn      KV_Poll
+ *
+ * @brief   Background work, from the main loop: erase a page, or pack the
+ *          oldest pages once few are erased. Does nothing while a commit
+ *          is open.
+ *
+ * @return  none
+ */
+void KV_Poll(void)
+{
+    if(Kv.Used){
+        return;
+    }
+    if(Kv.Dirty){
+        KV_Erase_Dirty();
+    }
+    else if(Kv.Blank < KV_FREE_BG){
+        KV_Compact(0);
+    }
+}
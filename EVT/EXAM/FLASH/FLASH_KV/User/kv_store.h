@@ -0,0 +1,105 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : kv_store.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Log-structured key-value store on fast-programmed
+ *                      internal flash pages.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#ifndef __KV_STORE_H
+#define __KV_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Flash area, KV_PAGE_NUM fast pages kept out of the code by Ld/Link.ld (FLASH LENGTH = 58K) */
+#define KV_FLASH_BASE     0x0800E800
+#define KV_PAGE_NUM       16
+#define KV_PAGE_SIZE      256
+
+/* Keys are 0 to KV_KEY_NUM - 1, values up to KV_VALUE_MAX bytes */
+#define KV_KEY_NUM        32
+#define KV_VALUE_MAX      64
+
+/*
+ * Page format, all numbers little endian:
+ *   magic (4 bytes) - KV_PAGE_MAGIC
+ *   seq (4 bytes)   - order the pages were written in
+ *   used (4 bytes)  - bytes of records that follow
+ *   records, each a key (2 bytes), a length (2 bytes, KV_LEN_DEL for a
+ *   deleted key) and the value padded to 4 bytes
+ *   crc (4 bytes)   - CRC32 (IEEE 802.3) of the rest of the page, last
+ * A page is programmed once after it is erased, so a commit is all the
+ * records of one page: a page cut by a reset fails its CRC and is dropped.
+ * A page found blank on mount may be an erase or a program cut after its
+ * cells already read erased, so it is erased again before it is used.
+ * The newest record of a key is its value.
+ */
+#define KV_PAGE_MAGIC     0x50564B57                      // "WKVP"
+#define KV_HEAD_LEN       12
+#define KV_PAYLOAD        ( KV_PAGE_SIZE - KV_HEAD_LEN - 4 )
+#define KV_LEN_DEL        0xFFFF
+#define KV_REC_SIZE(len)  ( 4 + ( ( (len) + 3 ) & ~3 ) )
+
+/* Live records are kept under this, so the oldest pages can always be
+ * packed into fewer pages once the store runs out of erased ones */
+#define KV_LIVE_MAX       ( ( KV_PAGE_NUM - 1 ) / 2 * KV_PAYLOAD )
+
+/* Erased pages KV_Set keeps before it starts a commit: one to commit
+ * into and one to compact into. KV_Poll tries to keep KV_FREE_BG. */
+#define KV_FREE_MIN       2
+#define KV_FREE_BG        4
+
+/* Return codes */
+#define KV_OK             0
+#define KV_ERR_KEY        1                               // Key out of range
+#define KV_ERR_LEN        2                               // Value too long, or no room left in the commit
+#define KV_ERR_NONE       3                               // No value for the key
+#define KV_ERR_FULL       4                               // No room, or flash worn out
+
+/* Page state */
+#define KV_PG_BLANK       0
+#define KV_PG_USED        1
+#define KV_PG_DIRTY       2                               // To be erased
+
+#define KV_LOC_NONE       0xFFFF
+
+typedef struct _KV_STORE
+{
+    uint16_t Index[ KV_KEY_NUM ];                         // Newest record of a key, page << 8 | offset
+    uint16_t Live[ KV_PAGE_NUM + 1 ];                     // Bytes of newest values per page, the last for Buf
+    uint32_t Seq[ KV_PAGE_NUM ];
+    uint8_t  State[ KV_PAGE_NUM ];
+    uint8_t  Erased[ KV_PAGE_NUM ];                       // Erased since the mount, a blank page may only look it
+    uint8_t  Last;                                        // Page written last, pages are taken round it
+    uint8_t  Blank;
+    uint8_t  Dirty;
+    uint16_t Used;                                        // Bytes of records in Buf
+    uint32_t Live_Total;
+    uint32_t Seq_Next;
+    uint32_t Erase_Cnt;
+    uint32_t Prog_Cnt;
+    uint32_t Buf[ KV_PAGE_SIZE / 4 ];                     // Page being filled, the commit in progress
+} KV_STORE;
+
+extern KV_STORE Kv;
+
+extern uint8_t KV_Init( void );
+extern uint8_t KV_Get( uint16_t key, void *pbuf, uint16_t size, uint16_t *plen );
+extern uint8_t KV_Set( uint16_t key, const void *pbuf, uint16_t len );
+extern uint8_t KV_Del( uint16_t key );
+extern uint8_t KV_Commit( void );
+extern void KV_Poll( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
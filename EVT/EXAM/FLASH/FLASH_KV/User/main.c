@@ -0,0 +1,99 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : main.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Main program body.
+ *********************************************************************************
+ * Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+ * Attention: This software (modified or not) and binary are used for
+ * microcontroller manufactured by Nanjing Qinheng Microelectronics.
+ *******************************************************************************/
+
+/*
+ *@Note
+ *Key-value store on internal flash (kv_store.c):
+ *Settings are kept in KV_PAGE_NUM fast pages (256 bytes) from KV_FLASH_BASE instead of
+ *erasing and rewriting one page with FLASH_ROM_ERASE/FLASH_ROM_WRITE on each change.
+ *Records are appended to a page in RAM and KV_Commit programs it into the next erased
+ *page, so a commit costs one page program and the erases are spread over all pages.
+ *A page cut by a reset fails its CRC and is dropped, so a commit is kept whole or not at all.
+ *KV_Poll, called from the main loop, erases pages and packs the oldest ones.
+ *FLASH in Ld/Link.ld of this example ends at KV_FLASH_BASE (LENGTH = 58K), so the link fails
+ *before code grows into the area; an application using the store shall do the same.
+ *
+*/
+
+#include "debug.h"
+#include "kv_store.h"
+
+/* Global define */
+#define KEY_BOOT     0
+#define KEY_COUNT    1
+#define KEY_NAME     2
+
+/*********************************************************************
+ * @fn      KV_Test
+ *
+ * @brief   Count the resets and update settings as an application would.
+ *
+ * @return  none
+ */
+void KV_Test(void)
+{
+    u32 boot = 0, count = 0, i;
+    u16 len;
+    char name[16];
+
+    if(KV_Get(KEY_BOOT, &boot, sizeof(boot), &len) != KV_OK){
+        boot = 0;
+    }
+    boot++;
+    KV_Set(KEY_BOOT, &boot, sizeof(boot));
+    KV_Commit();
+    printf("Boot %d\r\n", boot);
+
+    if(KV_Get(KEY_NAME, name, sizeof(name), &len) == KV_OK){
+        printf("Name %.*s\r\n", len, name);
+    }
+
+    /* Both keys are committed together */
+    for(i = 0; i < 1000; i++){
+        KV_Get(KEY_COUNT, &count, sizeof(count), &len);
+        count++;
+        KV_Set(KEY_COUNT, &count, sizeof(count));
+        len = sprintf(name, "CH643-%d", count % 100);
+        KV_Set(KEY_NAME, name, len);
+        if(KV_Commit() != KV_OK){
+            printf("Commit Fail\r\n");
+            return;
+        }
+        KV_Poll();
+    }
+    printf("Count %d, %d pages programmed, %d erased\r\n", count, Kv.Prog_Cnt, Kv.Erase_Cnt);
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Main program.
+ *
+ * @return  none
+ */
+int main(void)
+{
+    SystemCoreClockUpdate();
+    Delay_Init();
+
+    Delay_Ms(1000);
+    USART_Printf_Init(115200);
+    printf("SystemClk:%d\r\n", SystemCoreClock);
+    printf( "ChipID:%08x\r\n", DBGMCU_GetCHIPID() );
+
+    KV_Init();
+    KV_Test();
+
+    while(1){
+        KV_Poll();
+    }
+}
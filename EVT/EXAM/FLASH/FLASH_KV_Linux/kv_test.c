@@ -0,0 +1,715 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : kv_test.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : The key-value store of FLASH_KV built for the PC on a
+ *                      flash model that enforces erase before program and
+ *                      loses power part way through erases and programs.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * kv_store.c is compiled in as it is. Flash is 64KB mapped at 0x08000000
+ * and only the KV pages may be erased or programmed, unlocked. Erased
+ * words read 0xE339E339, not 0xFF, as the store must not depend on it.
+ * A page may only be programmed once after each completed erase:
+ * programming it again, or programming a page that was never erased or
+ * whose erase was cut, is counted as an erase-before-write violation and
+ * only clears bits.
+ * Power is lost at a random flash operation now and then: an erase is cut
+ * after a random number of words with one word left half erased, a program
+ * after a random number of words with one word half programmed. The store
+ * is then mounted again and must hold the last committed state, or, for a
+ * loss inside KV_Commit, either that state or the one being committed.
+ * The reference is a model in RAM of the committed and pending values.
+ *
+ * kv_test -t runs the self-tests:
+ *   - 20000 random transactions of 1 to 4 sets and deletes, with power
+ *     lost in about one in 50: flash starting as garbage, flash starting
+ *     as zero words that look erased, and values of 57 to 64 bytes. Every
+ *     mount matches the model, KV_Poll runs at random, the live byte count
+ *     matches the pages, no fault and no erase-before-write violation.
+ *   - A record that does not fit in the open commit is refused with
+ *     KV_ERR_LEN, the records already in it kept and committed together.
+ *   - Values set until KV_ERR_FULL: refused only once the live bytes would
+ *     pass KV_LIVE_MAX, all still there after a mount, and room back after
+ *     deleting.
+ * Without -t, random transactions are run and the resets, erases per page
+ * and programs per commit are printed.
+ *
+ * Build:
+ *   gcc -O2 -Wall -I../FLASH_KV/User -I../../SRC/Core
+ *       -I../../SRC/Debug -I../../SRC/Peripheral/inc
+ *       -o kv_test kv_test.c
+ *
+ * Usage:
+ *   kv_test [-n transactions] [-s seed] [-z] [-b] | -t
+ *   -n  transactions, 100000 by default
+ *   -s  seed, 1 by default
+ *   -z  flash starting as zero words instead of garbage
+ *   -b  values of 57 to 64 bytes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* The store and the peripheral headers as they are, minus the RISC-V bits */
+#define interrupt( x )      unused
+#include "debug.h"
+#include "kv_store.c"
+
+#define SIM_FLASH_ADDR      0x08000000
+#define SIM_FLASH_SIZE      0x10000
+#define SIM_ERASED          0xE339E339
+#define SIM_WORDS           ( KV_PAGE_SIZE / 4 )
+
+/*******************************************************************************/
+/* Flash model */
+static uint32_t Sim_Page[ SIM_WORDS ];
+static uint8_t  Sim_Erased[ KV_PAGE_NUM ];                  // Erased since its last program
+static uint32_t Sim_Wear[ KV_PAGE_NUM ];
+static int      Sim_Locked = 1;
+static uint32_t Sim_Fault, Sim_Overwrite, Sim_Prog;
+static long     Sim_Ops, Sim_Cut_At = -1;
+static jmp_buf  Sim_Reset_Jmp;
+
+/*********************************************************************
+ * @fn      Sim_Page_Of
+ *
+ * @brief   KV page of an erase or program, counting a fault for a locked
+ *          flash or an address outside the KV area.
+ *
+ * @return  page, -1 on a fault
+ */
+static int Sim_Page_Of( uint32_t adr )
+{
+    if( Sim_Locked || ( adr & ( KV_PAGE_SIZE - 1 ) ) || ( adr < KV_FLASH_BASE ) ||
+        ( adr >= KV_FLASH_BASE + KV_PAGE_NUM * KV_PAGE_SIZE ) )
+    {
+        printf( "  flash operation at %08x%s\n", adr, Sim_Locked ? ", locked" : "" );
+        Sim_Fault++;
+        return -1;
+    }
+    return ( adr - KV_FLASH_BASE ) / KV_PAGE_SIZE;
+}
+
+/*********************************************************************
+ * @fn      Sim_Power_Lost
+ *
+ * @brief   Check whether power is lost at this flash operation.
+ *
+ * @return  1 - lost, the operation is to be cut and Sim_Reset called
+ */
+static int Sim_Power_Lost( void )
+{
+    if( ( Sim_Cut_At >= 0 ) && ( Sim_Ops == Sim_Cut_At ) )
+    {
+        Sim_Cut_At = -1;
+        return 1;
+    }
+    Sim_Ops++;
+    return 0;
+}
+
+static void Sim_Reset( void )
+{
+    Sim_Locked = 1;
+    longjmp( Sim_Reset_Jmp, 1 );
+}
+
+void FLASH_Unlock_Fast( void ) { Sim_Locked = 0; }
+void FLASH_Lock_Fast( void ) { Sim_Locked = 1; }
+void FLASH_BufReset( void ) { memset( Sim_Page, 0, sizeof( Sim_Page ) ); }
+
+void FLASH_BufLoad( uint32_t adr, uint32_t data )
+{
+    if( Sim_Locked )
+    {
+        Sim_Fault++;
+    }
+    Sim_Page[ ( adr & ( KV_PAGE_SIZE - 1 ) ) / 4 ] = data;
+}
+
+void FLASH_ErasePage_Fast( uint32_t adr )
+{
+    uint32_t *pw = (uint32_t *)(uintptr_t)adr;
+    int p = Sim_Page_Of( adr ), i, k;
+
+    if( p < 0 )
+    {
+        return;
+    }
+    Sim_Wear[ p ]++;
+    if( Sim_Power_Lost( ) )
+    {
+        k = rand( ) % SIM_WORDS;
+        for( i = 0; i < k; i++ )
+        {
+            pw[ i ] = SIM_ERASED;
+        }
+        pw[ k ] |= SIM_ERASED & rand( );
+        Sim_Erased[ p ] = 0;
+        Sim_Reset( );
+    }
+    for( i = 0; i < SIM_WORDS; i++ )
+    {
+        pw[ i ] = SIM_ERASED;
+    }
+    Sim_Erased[ p ] = 1;
+}
+
+void FLASH_ProgramPage_Fast( uint32_t adr )
+{
+    uint32_t *pw = (uint32_t *)(uintptr_t)adr;
+    int p = Sim_Page_Of( adr ), i, k;
+
+    if( p < 0 )
+    {
+        return;
+    }
+    if( !Sim_Erased[ p ] )
+    {
+        /* Bits only ever go away from the erased state */
+        printf( "  page %d programmed without an erase\n", p );
+        Sim_Overwrite++;
+        for( i = 0; i < SIM_WORDS; i++ )
+        {
+            pw[ i ] &= Sim_Page[ i ] | ~SIM_ERASED;
+        }
+        return;
+    }
+    Sim_Erased[ p ] = 0;
+    Sim_Prog++;
+    if( Sim_Power_Lost( ) )
+    {
+        k = rand( ) % SIM_WORDS;
+        for( i = 0; i < k; i++ )
+        {
+            pw[ i ] = Sim_Page[ i ];
+        }
+        pw[ k ] &= Sim_Page[ k ] | rand( );
+        Sim_Reset( );
+    }
+    memcpy( pw, Sim_Page, KV_PAGE_SIZE );
+}
+
+/*********************************************************************
+ * @fn      Sim_Flash_Open
+ *
+ * @brief   Map the flash, full of garbage or of zero words.
+ *
+ * @return  0, -1 if the address is taken
+ */
+static int Sim_Flash_Open( int zero )
+{
+    uint8_t *p;
+    int i;
+
+    p = mmap( (void *)SIM_FLASH_ADDR, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0 );
+    if( p == MAP_FAILED )
+    {
+        perror( "flash" );
+        return -1;
+    }
+    if( p != (uint8_t *)SIM_FLASH_ADDR )
+    {
+        fprintf( stderr, "flash address %08x is taken\n", SIM_FLASH_ADDR );
+        return -1;
+    }
+    for( i = 0; i < SIM_FLASH_SIZE; i++ )
+    {
+        p[ i ] = zero ? 0 : rand( );
+    }
+    return 0;
+}
+
+/*******************************************************************************/
+/* Reference of the committed values and of the open commit */
+static int     Ref_Len[ KV_KEY_NUM ];                       // -1 for no value
+static uint8_t Ref_Val[ KV_KEY_NUM ][ KV_VALUE_MAX ];
+static int     Pend[ KV_KEY_NUM ];
+static int     Pend_Len[ KV_KEY_NUM ];
+static uint8_t Pend_Val[ KV_KEY_NUM ][ KV_VALUE_MAX ];
+
+/*********************************************************************
+ * @fn      Ref_Match
+ *
+ * @brief   Compare the store with the committed values, with the open
+ *          commit over them if pend is set.
+ *
+ * @return  1 - same
+ */
+static int Ref_Match( int pend )
+{
+    uint8_t buf[ KV_VALUE_MAX ];
+    uint16_t len;
+    uint8_t s;
+    int k, n;
+    const uint8_t *pv;
+
+    for( k = 0; k < KV_KEY_NUM; k++ )
+    {
+        n = ( pend && Pend[ k ] ) ? Pend_Len[ k ] : Ref_Len[ k ];
+        pv = ( pend && Pend[ k ] ) ? Pend_Val[ k ] : Ref_Val[ k ];
+        s = KV_Get( k, buf, sizeof( buf ), &len );
+        if( n < 0 )
+        {
+            if( s != KV_ERR_NONE )
+            {
+                return 0;
+            }
+        }
+        else if( ( s != KV_OK ) || ( len != n ) || memcmp( buf, pv, n ) )
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void Ref_Commit( void )
+{
+    int k;
+
+    for( k = 0; k < KV_KEY_NUM; k++ )
+    {
+        if( Pend[ k ] )
+        {
+            Ref_Len[ k ] = Pend_Len[ k ];
+            memcpy( Ref_Val[ k ], Pend_Val[ k ], KV_VALUE_MAX );
+        }
+    }
+    memset( Pend, 0, sizeof( Pend ) );
+}
+
+/*********************************************************************
+ * @fn      Kv_Live_Ok
+ *
+ * @brief   Check the live bytes of the pages add up to Live_Total.
+ *
+ * @return  1 - they do
+ */
+static int Kv_Live_Ok( void )
+{
+    uint32_t sum = 0;
+    int p;
+
+    for( p = 0; p <= KV_PAGE_NUM; p++ )
+    {
+        sum += Kv.Live[ p ];
+    }
+    return sum == Kv.Live_Total;
+}
+
+/*******************************************************************************/
+/* Random transactions */
+typedef struct _KV_RUN
+{
+    long     Commits;
+    long     Resets;
+    long     Resets_Commit;                                 // Power lost inside KV_Commit
+    long     Newer;                                         // Of those, the new state kept
+    long     Full;                                          // Transactions cut by KV_ERR_FULL
+    long     No_Room;                                       // Records refused by KV_ERR_LEN
+} KV_RUN;
+
+/*********************************************************************
+ * @fn      Kv_Run
+ *
+ * @brief   Random transactions of sets and deletes, with power lost at a
+ *          random flash operation in about one transaction in 50.
+ *
+ * @param   big - values of KV_VALUE_MAX - 7 to KV_VALUE_MAX bytes
+ *
+ * @return  number of failures
+ */
+static int Kv_Run( long num, int big, KV_RUN *prun )
+{
+    static volatile int in_commit;
+    static volatile long it;
+    uint8_t buf[ KV_VALUE_MAX ];
+    uint8_t s;
+    int j, k, n, len, i;
+
+    memset( prun, 0, sizeof( KV_RUN ) );
+    for( k = 0; k < KV_KEY_NUM; k++ )
+    {
+        Ref_Len[ k ] = -1;
+    }
+    memset( Pend, 0, sizeof( Pend ) );
+    KV_Init( );
+    for( it = 0; it < num; it++ )
+    {
+        in_commit = 0;
+        if( rand( ) % 50 == 0 )
+        {
+            Sim_Cut_At = Sim_Ops + rand( ) % 6;
+        }
+        if( setjmp( Sim_Reset_Jmp ) )
+        {
+            prun->Resets++;
+            KV_Init( );
+            if( !Kv_Live_Ok( ) )
+            {
+                printf( "  transaction %ld: live bytes do not add up after a mount\n", it );
+                return 1;
+            }
+            if( Ref_Match( 0 ) )
+            {
+                memset( Pend, 0, sizeof( Pend ) );
+            }
+            else if( in_commit && Ref_Match( 1 ) )
+            {
+                prun->Newer++;
+                Ref_Commit( );
+            }
+            else
+            {
+                printf( "  transaction %ld: state after a reset%s matches neither\n", it, in_commit ? " in the commit" : "" );
+                return 1;
+            }
+            prun->Resets_Commit += in_commit;
+            continue;
+        }
+
+        n = 1 + rand( ) % 4;
+        for( j = 0; j < n; j++ )
+        {
+            k = rand( ) % KV_KEY_NUM;
+            if( rand( ) % 8 == 0 )
+            {
+                s = KV_Del( k );
+                len = -1;
+            }
+            else
+            {
+                len = big ? KV_VALUE_MAX - rand( ) % 8 : rand( ) % ( ( rand( ) % 4 ) ? KV_VALUE_MAX / 4 + 1 : KV_VALUE_MAX + 1 );
+                for( i = 0; i < len; i++ )
+                {
+                    buf[ i ] = rand( );
+                }
+                s = KV_Set( k, buf, len );
+            }
+            if( s == KV_ERR_LEN )
+            {
+                prun->No_Room++;
+                break;
+            }
+            if( s == KV_ERR_FULL )
+            {
+                prun->Full++;
+                break;
+            }
+            if( s != KV_OK )
+            {
+                printf( "  transaction %ld: error %d\n", it, s );
+                return 1;
+            }
+            Pend[ k ] = 1;
+            Pend_Len[ k ] = len;
+            if( len > 0 )
+            {
+                memcpy( Pend_Val[ k ], buf, len );
+            }
+        }
+        if( !Ref_Match( 1 ) )
+        {
+            printf( "  transaction %ld: open commit not read back\n", it );
+            return 1;
+        }
+        in_commit = 1;
+        if( KV_Commit( ) != KV_OK )
+        {
+            printf( "  transaction %ld: commit failed\n", it );
+            return 1;
+        }
+        in_commit = 0;
+        Ref_Commit( );
+        prun->Commits++;
+        for( j = rand( ) % 3; j > 0; j-- )
+        {
+            KV_Poll( );
+        }
+        if( !Ref_Match( 0 ) || !Kv_Live_Ok( ) )
+        {
+            printf( "  transaction %ld: state differs after the commit\n", it );
+            return 1;
+        }
+        if( rand( ) % 500 == 0 )
+        {
+            KV_Init( );
+            if( !Ref_Match( 0 ) )
+            {
+                printf( "  transaction %ld: state differs after a mount\n", it );
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Kv_Test_Random
+ *
+ * @brief   20000 random transactions: no fault and no erase-before-write
+ *          violation.
+ *
+ * @return  number of failures
+ */
+static int Kv_Test_Random( int zero, int big )
+{
+    KV_RUN run;
+    int bad;
+
+    if( Sim_Flash_Open( zero ) )
+    {
+        return 1;
+    }
+    bad = Kv_Run( 20000, big, &run );
+    if( run.Resets < 100 )
+    {
+        printf( "  only %ld resets\n", run.Resets );
+        bad++;
+    }
+    if( Sim_Fault || Sim_Overwrite )
+    {
+        printf( "  %u faults, %u violations\n", Sim_Fault, Sim_Overwrite );
+        bad++;
+    }
+    return bad;
+}
+
+static int Kv_Test_Garbage( void ) { return Kv_Test_Random( 0, 0 ); }
+static int Kv_Test_Zero( void ) { return Kv_Test_Random( 1, 0 ); }
+static int Kv_Test_Big( void ) { return Kv_Test_Random( 0, 1 ); }
+
+/*********************************************************************
+ * @fn      Kv_Test_No_Room
+ *
+ * @brief   Fill the open commit until a record is refused: KV_ERR_LEN,
+ *          nothing programmed yet, then all the records committed in one
+ *          page and the refused one taken by the next commit.
+ *
+ * @return  number of failures
+ */
+static int Kv_Test_No_Room( void )
+{
+    uint8_t buf[ KV_VALUE_MAX ];
+    uint16_t len;
+    uint32_t progs;
+    int k, bad = 0;
+
+    if( Sim_Flash_Open( 0 ) )
+    {
+        return 1;
+    }
+    KV_Init( );
+    progs = Kv.Prog_Cnt;
+    for( k = 0; k < KV_KEY_NUM; k++ )
+    {
+        memset( buf, k, sizeof( buf ) );
+        if( KV_Set( k, buf, sizeof( buf ) ) != KV_OK )
+        {
+            break;
+        }
+    }
+    /* Three 68 byte records fit in the 236 bytes of a page */
+    if( ( k != KV_PAYLOAD / KV_REC_SIZE( KV_VALUE_MAX ) ) || ( KV_Set( k, buf, sizeof( buf ) ) != KV_ERR_LEN ) )
+    {
+        printf( "  %d records taken\n", k );
+        bad++;
+    }
+    if( ( Kv.Prog_Cnt != progs ) || ( KV_Get( k, buf, sizeof( buf ), &len ) != KV_ERR_NONE ) )
+    {
+        printf( "  the refused record was kept, or a page programmed\n" );
+        bad++;
+    }
+    if( ( KV_Commit( ) != KV_OK ) || ( Kv.Prog_Cnt != progs + 1 ) )
+    {
+        printf( "  commit took %u pages\n", Kv.Prog_Cnt - progs );
+        bad++;
+    }
+    memset( buf, k, sizeof( buf ) );
+    if( ( KV_Set( k, buf, sizeof( buf ) ) != KV_OK ) || ( KV_Commit( ) != KV_OK ) )
+    {
+        bad++;
+    }
+    KV_Init( );
+    for( k = 0; k <= KV_PAYLOAD / KV_REC_SIZE( KV_VALUE_MAX ); k++ )
+    {
+        if( ( KV_Get( k, buf, sizeof( buf ), &len ) != KV_OK ) || ( len != KV_VALUE_MAX ) || ( buf[ 0 ] != k ) )
+        {
+            printf( "  key %d lost\n", k );
+            bad++;
+        }
+    }
+    return bad + Sim_Fault + Sim_Overwrite;
+}
+
+/*********************************************************************
+ * @fn      Kv_Test_Full
+ *
+ * @brief   Set values of new keys, one per commit, until KV_ERR_FULL: it
+ *          only comes once KV_LIVE_MAX would be passed, every value is
+ *          still there after a mount, and deleting gives the room back.
+ *
+ * @return  number of failures
+ */
+static int Kv_Test_Full( void )
+{
+    uint8_t buf[ KV_VALUE_MAX ];
+    uint16_t len;
+    uint8_t s = KV_OK;
+    int k, n, bad = 0;
+
+    if( Sim_Flash_Open( 0 ) )
+    {
+        return 1;
+    }
+    KV_Init( );
+    for( k = 0; k < KV_KEY_NUM; k++ )
+    {
+        memset( buf, k, sizeof( buf ) );
+        s = KV_Set( k, buf, sizeof( buf ) );
+        if( s != KV_OK )
+        {
+            break;
+        }
+        KV_Commit( );
+        KV_Poll( );
+    }
+    n = k;
+    if( ( s != KV_ERR_FULL ) || ( Kv.Live_Total + KV_REC_SIZE( KV_VALUE_MAX ) <= KV_LIVE_MAX ) )
+    {
+        printf( "  stopped at key %d with %u live bytes, error %d\n", n, Kv.Live_Total, s );
+        bad++;
+    }
+    KV_Init( );
+    for( k = 0; k < n; k++ )
+    {
+        if( ( KV_Get( k, buf, sizeof( buf ), &len ) != KV_OK ) || ( buf[ 0 ] != k ) )
+        {
+            printf( "  key %d lost\n", k );
+            bad++;
+        }
+    }
+    if( ( KV_Del( 0 ) != KV_OK ) || ( KV_Commit( ) != KV_OK ) )
+    {
+        bad++;
+    }
+    memset( buf, n, sizeof( buf ) );
+    if( ( KV_Set( n, buf, sizeof( buf ) ) != KV_OK ) || ( KV_Commit( ) != KV_OK ) )
+    {
+        printf( "  no room after a delete\n" );
+        bad++;
+    }
+    return bad + Sim_Fault + Sim_Overwrite;
+}
+
+/*********************************************************************
+ * @fn      Kv_Self_Test
+ *
+ * @brief   Run every self-test case, each in its own process.
+ *
+ * @return  number of failed cases
+ */
+static int Kv_Self_Test( void )
+{
+    static const struct
+    {
+        const char *Name;
+        int ( *Run )( void );
+    } test[ ] =
+    {
+        { "random transactions with power loss, flash of garbage", Kv_Test_Garbage },
+        { "random transactions with power loss, flash of zero words", Kv_Test_Zero },
+        { "random transactions with power loss, values of 57 to 64 bytes", Kv_Test_Big },
+        { "record with no room in the open commit: KV_ERR_LEN", Kv_Test_No_Room },
+        { "store full: KV_ERR_FULL at KV_LIVE_MAX, room back after a delete", Kv_Test_Full },
+    };
+    pid_t pid;
+    int i, st, fail = 0;
+
+    for( i = 0; i < (int)( sizeof( test ) / sizeof( test[ 0 ] ) ); i++ )
+    {
+        printf( "%s\n", test[ i ].Name );
+        fflush( stdout );
+        pid = fork( );
+        if( pid == 0 )
+        {
+            srand( i + 1 );
+            st = test[ i ].Run( );
+            fflush( stdout );
+            _exit( st ? 1 : 0 );
+        }
+        if( ( pid < 0 ) || ( waitpid( pid, &st, 0 ) != pid ) || !WIFEXITED( st ) || WEXITSTATUS( st ) )
+        {
+            printf( "  FAIL\n" );
+            fail++;
+        }
+        else
+        {
+            printf( "  ok\n" );
+        }
+    }
+    printf( "%s\n", fail ? "self-test FAILED" : "self-test passed" );
+    return fail;
+}
+
+int main( int argc, char **argv )
+{
+    KV_RUN run;
+    long num = 100000;
+    uint32_t lo = ~0u, hi = 0, sum = 0;
+    int c, seed = 1, zero = 0, big = 0, p;
+
+    while( ( c = getopt( argc, argv, "n:s:zbt" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 'n': num = atol( optarg ); break;
+            case 's': seed = atoi( optarg ); break;
+            case 'z': zero = 1; break;
+            case 'b': big = 1; break;
+            case 't': return Kv_Self_Test( ) ? 1 : 0;
+            default:
+                fprintf( stderr, "usage: %s [-n transactions] [-s seed] [-z] [-b] | -t\n", argv[ 0 ] );
+                return 2;
+        }
+    }
+    srand( seed );
+    if( Sim_Flash_Open( zero ) )
+    {
+        return 1;
+    }
+    if( Kv_Run( num, big, &run ) )
+    {
+        printf( "FAILED\n" );
+        return 1;
+    }
+    for( p = 0; p < KV_PAGE_NUM; p++ )
+    {
+        lo = ( Sim_Wear[ p ] < lo ) ? Sim_Wear[ p ] : lo;
+        hi = ( Sim_Wear[ p ] > hi ) ? Sim_Wear[ p ] : hi;
+        sum += Sim_Wear[ p ];
+    }
+    printf( "%ld commits, %ld resets (%ld in a commit, %ld of them kept the new state)\n",
+            run.Commits, run.Resets, run.Resets_Commit, run.Newer );
+    printf( "%ld records refused for no room in the commit, %ld transactions cut by a full store\n",
+            run.No_Room, run.Full );
+    printf( "erases per page %u to %u (%.2f%% apart), %.3f erases and %.3f programs per commit\n",
+            lo, hi, 100.0 * ( hi - lo ) / hi, (double)sum / run.Commits, (double)Sim_Prog / run.Commits );
+    printf( "%u faults, %u erase-before-write violations\n", Sim_Fault, Sim_Overwrite );
+    return ( Sim_Fault || Sim_Overwrite ) ? 1 : 0;
+}
@@ -14,6 +14,7 @@
  *@Note
  *FLASH erase/read/write, fast programming and OptionBytes programming:
  *Includes Fast Erase and Program.
+ *FLASH_ROM_UPDATE writes without a separate erase, and only erases and programs the pages that change.
  *
 */
 
@@ -112,6 +113,26 @@ void Flash_Test_Fast(void)
         printf("%d Byte Verify Suc\r\n", (Fsize*4));
 }
 
+/*********************************************************************
+ * @fn      Flash_Test_Update
+ *
+ * @brief   Flash Update Test, after Flash_Test_Fast: saving the same data
+ *          again costs nothing, a changed word one page.
+ *
+ * @return  none
+ */
+void Flash_Test_Update(void)
+{
+    FLASH_Status s;
+
+    s = FLASH_ROM_UPDATE(Fadr, buf, Fsize*4);
+    printf("Update unchanged %d\r\n", s);
+
+    buf[3] = 0x12345678;
+    s = FLASH_ROM_UPDATE(Fadr, buf, Fsize*4);
+    printf("Update one word %d, adr-%08x v-%08x\r\n", s, Fadr + 4*3, *(u32*)(Fadr + 4*3));
+}
+
 /*********************************************************************
  * @fn      main
  *
@@ -129,6 +150,7 @@ int main(void)
     printf("SystemClk:%d\r\n", SystemCoreClock);
     printf( "ChipID:%08x\r\n", DBGMCU_GetCHIPID() );
     Flash_Test_Fast();
+    Flash_Test_Update();
     Option_Byte_CFG();
 
     while(1);
@@ -0,0 +1,637 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : rom_update_sim.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : FLASH_ROM_UPDATE, FLASH_ROM_ERASE and FLASH_ROM_WRITE
+ *                      of ch643_flash.c built for the PC against a simulated
+ *                      flash controller.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * ch643_flash.c is compiled in as it is. The flash controller registers are
+ * simulated: KEYR and MODEKEYR unlock with the two keys, LOCK and FLOCK in
+ * CTLR lock again, and setting STRT erases a 32KB block (BER32), a 1KB page
+ * (PER) or a 256 byte page (PAGE_ER) at ADDR, or programs the 256 byte page
+ * at ADDR from the 64 words written to it with BUF_LOAD (PAGE_PG).
+ * The 62KB of user flash is mapped at 0x08000000 and erased words read
+ * 0xE339E339, not 0xFF. A page may only be programmed once after each
+ * erase: programming it again is counted and only clears bits. A locked
+ * or misaligned operation, an address outside user flash, a program
+ * without its 64 loads and a write to flash outside the page being loaded
+ * are counted as faults.
+ *
+ * rom_update_sim -t runs the self-tests:
+ *   - a full write over old data: one 32KB block and 30 1KB erases, 248
+ *     page programs;
+ *   - the same 62KB written again: no erase, no program;
+ *   - 3 words changed in 2 pages: 2 page erases and 2 page programs;
+ *   - a page of zero words before any erase: erased (the erased value is
+ *     not known yet); pages erased beforehand: programmed only;
+ *   - a page programmed with words that read as erased: programmed over,
+ *     read back, erased and programmed again (the only program over a
+ *     page not erased in all the tests);
+ *   - 2000 random updates of random ranges with random runs of changed
+ *     words: flash equal to the data, and only the changed pages that do
+ *     not read as erased are erased, plus the pages between them in a run
+ *     and the pages that only read as erased, once programmed over;
+ *   - misaligned or out of range arguments: the error code and no flash
+ *     operation.
+ * Without -t, the full write, the same write again and the 3 word change
+ * are run and their erases and programs printed.
+ *
+ * Build:
+ *   gcc -O2 -Wall -I../FLASH_Program/User -I../../SRC/Core
+ *       -I../../SRC/Debug -I../../SRC/Peripheral/inc -I../../SRC/Peripheral/src
+ *       -o rom_update_sim rom_update_sim.c
+ *
+ * Usage:
+ *   rom_update_sim [-s seed] | -t
+ *   -s  seed of the data, 1 by default
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* The library and the peripheral headers as they are, minus the RISC-V bits */
+#define interrupt( x )      unused
+#include "debug.h"
+
+static FLASH_TypeDef *Sim_Flash_Get( void );
+
+/* Every register access of the library goes through Sim_Flash_Get first */
+#undef FLASH
+#define FLASH               ( Sim_Flash_Get( ) )
+
+/* Flash addresses are kept in uint32_t and dereferenced */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wint-to-pointer-cast"
+#include "ch643_flash.c"
+#pragma GCC diagnostic pop
+
+#define SIM_FLASH_SIZE      0xF800
+#define SIM_MAP_SIZE        0x10000
+#define SIM_PAGES           ( SIM_FLASH_SIZE / Size_256B )
+#define SIM_ERASED          0xE339E339
+#define SIM_WORDS           ( SIM_FLASH_SIZE / 4 )
+
+static FLASH_TypeDef Sim_Reg;
+static uint32_t *Sim_Map;                                   // What the CPU reads at FLASH_BASE
+static uint32_t Sim_Cell[ SIM_WORDS ];                      // What the cells hold
+static uint8_t  Sim_Erased[ SIM_PAGES ];                    // Erased since its last program
+static uint8_t  Sim_Erase_Map[ SIM_PAGES ];                 // Erased by the operation under test
+static uint32_t Sim_Last_Key, Sim_Last_Mode_Key, Sim_Loads;
+static uint32_t Sim_Erase_32K, Sim_Erase_1K, Sim_Erase_256, Sim_Prog, Sim_Over, Sim_Fault;
+
+/*********************************************************************
+ * @fn      Sim_Erase
+ *
+ * @brief   Erase len bytes of cells at adr.
+ *
+ * @return  none
+ */
+static void Sim_Erase( uint32_t adr, uint32_t len )
+{
+    uint32_t w = ( adr - FLASH_BASE ) / 4, i;
+
+    if( ( adr & ( len - 1 ) ) || ( adr < FLASH_BASE ) || ( adr + len > FLASH_BASE + SIM_FLASH_SIZE ) )
+    {
+        printf( "  erase of %x bytes at %08x\n", len, adr );
+        Sim_Fault++;
+        return;
+    }
+    for( i = 0; i < len / 4; i++ )
+    {
+        Sim_Cell[ w + i ] = SIM_ERASED;
+        Sim_Map[ w + i ] = SIM_ERASED;
+    }
+    for( i = 0; i < len / Size_256B; i++ )
+    {
+        Sim_Erased[ w / 64 + i ] = 1;
+        Sim_Erase_Map[ w / 64 + i ] = 1;
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Program
+ *
+ * @brief   Program the page at adr from the 64 words the CPU wrote to it.
+ *          Any other word that differs from the cells was written by a
+ *          stray pointer, and is put back.
+ *
+ * @return  none
+ */
+static void Sim_Program( uint32_t adr )
+{
+    uint32_t w = ( adr - FLASH_BASE ) / 4, i;
+
+    if( ( adr & ( Size_256B - 1 ) ) || ( adr < FLASH_BASE ) || ( adr >= FLASH_BASE + SIM_FLASH_SIZE ) || ( Sim_Loads != 64 ) )
+    {
+        printf( "  program at %08x after %u loads\n", adr, Sim_Loads );
+        Sim_Fault++;
+        return;
+    }
+    for( i = 0; i < SIM_WORDS; i++ )
+    {
+        if( ( ( i < w ) || ( i >= w + 64 ) ) && ( Sim_Map[ i ] != Sim_Cell[ i ] ) )
+        {
+            printf( "  write to %08x while loading %08x\n", FLASH_BASE + 4 * i, adr );
+            Sim_Map[ i ] = Sim_Cell[ i ];
+            Sim_Fault++;
+        }
+    }
+    if( !Sim_Erased[ w / 64 ] )
+    {
+        /* Bits only ever go away from the erased state */
+        Sim_Over++;
+        for( i = 0; i < 64; i++ )
+        {
+            Sim_Cell[ w + i ] &= Sim_Map[ w + i ] | ~SIM_ERASED;
+        }
+    }
+    else
+    {
+        memcpy( &Sim_Cell[ w ], &Sim_Map[ w ], Size_256B );
+    }
+    memcpy( &Sim_Map[ w ], &Sim_Cell[ w ], Size_256B );
+    Sim_Erased[ w / 64 ] = 0;
+    Sim_Prog++;
+}
+
+/*********************************************************************
+ * @fn      Sim_Flash_Get
+ *
+ * @brief   Carry out what the library wrote to the registers since the
+ *          last access: keys, buffer reset and load, and STRT. The
+ *          controller is never busy.
+ *
+ * @return  the registers
+ */
+static FLASH_TypeDef *Sim_Flash_Get( void )
+{
+    uint32_t mode;
+
+    if( Sim_Reg.KEYR )
+    {
+        if( ( Sim_Last_Key == FLASH_KEY1 ) && ( Sim_Reg.KEYR == FLASH_KEY2 ) )
+        {
+            Sim_Reg.CTLR &= ~CR_LOCK_Set;
+        }
+        Sim_Last_Key = Sim_Reg.KEYR;
+        Sim_Reg.KEYR = 0;
+    }
+    if( Sim_Reg.MODEKEYR )
+    {
+        if( ( Sim_Last_Mode_Key == FLASH_KEY1 ) && ( Sim_Reg.MODEKEYR == FLASH_KEY2 ) )
+        {
+            Sim_Reg.CTLR &= ~CR_FLOCK_Set;
+        }
+        Sim_Last_Mode_Key = Sim_Reg.MODEKEYR;
+        Sim_Reg.MODEKEYR = 0;
+    }
+    if( Sim_Reg.CTLR & CR_BUF_RST )
+    {
+        Sim_Reg.CTLR &= ~CR_BUF_RST;
+        Sim_Loads = 0;
+    }
+    if( Sim_Reg.CTLR & CR_BUF_LOAD )
+    {
+        Sim_Reg.CTLR &= ~CR_BUF_LOAD;
+        Sim_Loads++;
+    }
+    if( Sim_Reg.CTLR & CR_STRT_Set )
+    {
+        Sim_Reg.CTLR &= ~CR_STRT_Set;
+        mode = Sim_Reg.CTLR & ( CR_BER32 | CR_PER_Set | CR_PAGE_ER | CR_PAGE_PG );
+        if( Sim_Reg.CTLR & ( CR_LOCK_Set | CR_FLOCK_Set ) )
+        {
+            printf( "  start while locked\n" );
+            Sim_Fault++;
+        }
+        else if( mode == CR_BER32 )
+        {
+            Sim_Erase( Sim_Reg.ADDR, Size_32KB );
+            Sim_Erase_32K++;
+        }
+        else if( mode == CR_PER_Set )
+        {
+            Sim_Erase( Sim_Reg.ADDR, Size_1KB );
+            Sim_Erase_1K++;
+        }
+        else if( mode == CR_PAGE_ER )
+        {
+            Sim_Erase( Sim_Reg.ADDR, Size_256B );
+            Sim_Erase_256++;
+        }
+        else if( mode == CR_PAGE_PG )
+        {
+            Sim_Program( Sim_Reg.ADDR );
+        }
+        else
+        {
+            printf( "  start with CTLR %08x\n", Sim_Reg.CTLR );
+            Sim_Fault++;
+        }
+    }
+    Sim_Reg.STATR = 0;
+    return &Sim_Reg;
+}
+
+/*********************************************************************
+ * @fn      Sim_Open
+ *
+ * @brief   Map user flash at FLASH_BASE, full of old data, and lock it.
+ *
+ * @return  0, -1 if the address is taken
+ */
+static int Sim_Open( void )
+{
+    uint32_t i;
+
+    Sim_Map = mmap( (void *)(uintptr_t)FLASH_BASE, SIM_MAP_SIZE, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0 );
+    if( Sim_Map == MAP_FAILED )
+    {
+        perror( "flash" );
+        return -1;
+    }
+    if( Sim_Map != (uint32_t *)(uintptr_t)FLASH_BASE )
+    {
+        fprintf( stderr, "flash address %08x is taken\n", FLASH_BASE );
+        return -1;
+    }
+    for( i = 0; i < SIM_WORDS; i++ )
+    {
+        Sim_Cell[ i ] = Sim_Map[ i ] = rand( );
+    }
+    Sim_Reg.CTLR = CR_LOCK_Set | CR_FLOCK_Set;
+    return 0;
+}
+
+static void Sim_Clear( void )
+{
+    Sim_Erase_32K = Sim_Erase_1K = Sim_Erase_256 = Sim_Prog = Sim_Over = 0;
+    memset( Sim_Erase_Map, 0, sizeof( Sim_Erase_Map ) );
+}
+
+static uint32_t Sim_Ops( void )
+{
+    return Sim_Erase_32K + Sim_Erase_1K + Sim_Erase_256 + Sim_Prog;
+}
+
+/*******************************************************************************/
+/* Self-test */
+static uint32_t Test_Buf[ SIM_WORDS ];
+
+/*********************************************************************
+ * @fn      Test_Update
+ *
+ * @brief   FLASH_ROM_UPDATE of Test_Buf from a word offset, checking the
+ *          flash reads the data afterwards.
+ *
+ * @return  number of failures
+ */
+static int Test_Update( uint32_t word, uint32_t len )
+{
+    FLASH_Status s = FLASH_ROM_UPDATE( FLASH_BASE + 4 * word, &Test_Buf[ word ], len );
+
+    if( ( s != FLASH_COMPLETE ) || memcmp( &Sim_Map[ word ], &Test_Buf[ word ], len ) ||
+        memcmp( Sim_Map, Sim_Cell, SIM_FLASH_SIZE ) )
+    {
+        printf( "  update of %x bytes at %08x: status %d, flash differs\n", len, FLASH_BASE + 4 * word, s );
+        return 1;
+    }
+    return Sim_Fault;
+}
+
+static void Test_Fill( void )
+{
+    uint32_t i;
+
+    for( i = 0; i < SIM_WORDS; i++ )
+    {
+        Test_Buf[ i ] = rand( );
+    }
+}
+
+/*********************************************************************
+ * @fn      Test_Counts
+ *
+ * @brief   Compare the operations of the last update with the expected.
+ *
+ * @return  1 - different
+ */
+static int Test_Counts( const char *pname, uint32_t e32k, uint32_t e1k, uint32_t e256, uint32_t prog )
+{
+    printf( "  %s: erased 32KB x%u 1KB x%u 256B x%u, %u pages programmed\n",
+            pname, Sim_Erase_32K, Sim_Erase_1K, Sim_Erase_256, Sim_Prog );
+    return ( Sim_Erase_32K != e32k ) || ( Sim_Erase_1K != e1k ) || ( Sim_Erase_256 != e256 ) || ( Sim_Prog != prog ) || Sim_Over;
+}
+
+/*********************************************************************
+ * @fn      Test_Whole
+ *
+ * @brief   The whole of user flash: written over old data, written again
+ *          unchanged, and with 3 words changed in 2 pages.
+ *
+ * @return  number of failures
+ */
+static int Test_Whole( void )
+{
+    int bad = 0;
+
+    Test_Fill( );
+    Sim_Clear( );
+    bad += Test_Update( 0, SIM_FLASH_SIZE );
+    bad += Test_Counts( "full write", 1, 30, 0, SIM_PAGES );
+
+    Sim_Clear( );
+    bad += Test_Update( 0, SIM_FLASH_SIZE );
+    bad += Test_Counts( "same data", 0, 0, 0, 0 );
+
+    Test_Buf[ 5 ] ^= 1;
+    Test_Buf[ 0x1234 ] ^= 1;
+    Test_Buf[ 0x1235 ] ^= 1;
+    Sim_Clear( );
+    bad += Test_Update( 0, SIM_FLASH_SIZE );
+    bad += Test_Counts( "3 words", 0, 0, 2, 2 );
+    return bad;
+}
+
+/*********************************************************************
+ * @fn      Test_Pre_Erased
+ *
+ * @brief   Before any erase, a page of zero words is not taken for
+ *          erased. After one, a range erased beforehand is only
+ *          programmed.
+ *
+ * @return  number of failures
+ */
+static int Test_Pre_Erased( void )
+{
+    uint32_t i;
+    int bad = 0;
+
+    Test_Fill( );
+    memset( Sim_Cell, 0, Size_256B );
+    memset( Sim_Map, 0, Size_256B );
+    Sim_Clear( );
+    bad += Test_Update( 0, Size_256B );
+    bad += Test_Counts( "zero page", 0, 0, 1, 1 );
+
+    bad += Test_Update( 0, Size_1KB );
+    FLASH_ROM_ERASE( FLASH_BASE + 0x4000, 0x800 );
+    for( i = 0; i < 0x200; i++ )
+    {
+        Test_Buf[ 0x1000 + i ] = i;
+    }
+    Sim_Clear( );
+    bad += Test_Update( 0x1000, 0x800 );
+    bad += Test_Counts( "erased range", 0, 0, 0, 8 );
+    return bad;
+}
+
+/*********************************************************************
+ * @fn      Test_Look_Erased
+ *
+ * @brief   A page programmed with words that read as erased is taken for
+ *          erased, programmed, found wrong on reading back, erased and
+ *          programmed again.
+ *
+ * @return  number of failures
+ */
+static int Test_Look_Erased( void )
+{
+    uint32_t i;
+    int bad = 0;
+
+    Test_Fill( );
+    bad += Test_Update( 0, Size_1KB );
+    for( i = 0; i < 64; i++ )
+    {
+        Test_Buf[ 0x1800 + i ] = SIM_ERASED;
+    }
+    bad += Test_Update( 0x1800, Size_256B );
+    for( i = 0; i < 64; i++ )
+    {
+        Test_Buf[ 0x1800 + i ] = 7 + i;
+    }
+    Sim_Clear( );
+    bad += Test_Update( 0x1800, Size_256B );
+    printf( "  erased 256B x%u, %u pages programmed, %u over a page not erased\n", Sim_Erase_256, Sim_Prog, Sim_Over );
+    return bad + ( Sim_Erase_256 != 1 ) + ( Sim_Prog != 2 ) + ( Sim_Over != 1 );
+}
+
+/*********************************************************************
+ * @fn      Test_Random
+ *
+ * @brief   Random updates of random ranges, with runs of changed words,
+ *          some left erased, and now and then pages erased beforehand:
+ *          each run of changed pages is erased from its first to its last
+ *          page that does not read as erased, and a page that only reads
+ *          as erased is erased after it is programmed over. No 32KB or 1KB
+ *          erase reaches past them.
+ *
+ * @return  number of failures
+ */
+static int Test_Random( void )
+{
+    uint8_t want[ SIM_PAGES ];
+    uint32_t it, p0, p1, p, i, n, v, w, run, first, last;
+    uint32_t blank = 0, over = 0, over0;
+    int bad = 0;
+
+    Test_Fill( );
+    bad += Test_Update( 0, SIM_FLASH_SIZE );
+    for( it = 0; ( it < 2000 ) && !bad; it++ )
+    {
+        p0 = rand( ) % SIM_PAGES;
+        p1 = p0 + 1 + rand( ) % ( SIM_PAGES - p0 );
+        if( ( rand( ) % 8 ) == 0 )
+        {
+            /* Some pages erased beforehand */
+            p = rand( ) % SIM_PAGES;
+            FLASH_ROM_ERASE( FLASH_BASE + p * Size_256B, ( 1 + rand( ) % ( SIM_PAGES - p ) ) * Size_256B );
+        }
+        for( n = rand( ) % 4; n > 0; n-- )
+        {
+            /* One run in four is left erased */
+            v = rand( ) % 4;
+            w = p0 * 64 + rand( ) % ( ( p1 - p0 ) * 64 );
+            for( i = rand( ) % ( ( rand( ) % 8 ) ? 64 : 0x2000 ); ( i > 0 ) && ( w < p1 * 64 ); i--, w++ )
+            {
+                Test_Buf[ w ] = v ? (uint32_t)rand( ) : SIM_ERASED;
+            }
+        }
+        over0 = over;
+        /* Each run of changed pages is erased from its first to its last
+         * page that does not read as erased */
+        memset( want, 0, sizeof( want ) );
+        for( p = p0; p < p1; p = run )
+        {
+            for( ; ( p < p1 ) && !memcmp( &Sim_Map[ p * 64 ], &Test_Buf[ p * 64 ], Size_256B ); p++ )
+            {
+            }
+            first = last = 0;
+            for( run = p; ( run < p1 ) && memcmp( &Sim_Map[ run * 64 ], &Test_Buf[ run * 64 ], Size_256B ); run++ )
+            {
+                for( i = 0; ( i < 64 ) && ( Sim_Map[ run * 64 + i ] == SIM_ERASED ); i++ )
+                {
+                }
+                if( i < 64 )
+                {
+                    first = last ? first : run;
+                    last = run + 1;
+                }
+            }
+            for( ; p < run; p++ )
+            {
+                want[ p ] = ( p >= first ) && ( p < last );
+                if( !want[ p ] )
+                {
+                    /* Written earlier with erased words: programmed over,
+                     * then erased and programmed again */
+                    blank += Sim_Erased[ p ];
+                    over += !Sim_Erased[ p ];
+                    want[ p ] = !Sim_Erased[ p ];
+                }
+            }
+        }
+        Sim_Clear( );
+        bad += Test_Update( p0 * 64, ( p1 - p0 ) * Size_256B );
+        if( memcmp( want, Sim_Erase_Map, sizeof( want ) ) || ( Sim_Over != over - over0 ) )
+        {
+            printf( "  update %u of pages %u to %u: wrong pages erased, %u programs over a page not erased\n", it, p0, p1 - 1, Sim_Over );
+            bad++;
+        }
+    }
+    printf( "  %u changed pages erased beforehand were only programmed, %u only read as erased\n", blank, over );
+    return bad;
+}
+
+/*********************************************************************
+ * @fn      Test_Args
+ *
+ * @brief   Misaligned and out of range arguments: the error code and no
+ *          flash operation.
+ *
+ * @return  number of failures
+ */
+static int Test_Args( void )
+{
+    static const struct
+    {
+        uint32_t     Addr;
+        uint32_t     Len;
+        FLASH_Status Status;
+    } arg[ ] =
+    {
+        { FLASH_BASE - Size_256B, Size_256B, FLASH_ADR_RANGE_ERROR },
+        { FLASH_BASE + SIM_FLASH_SIZE, Size_256B, FLASH_ADR_RANGE_ERROR },
+        { FLASH_BASE + SIM_FLASH_SIZE - Size_256B, 2 * Size_256B, FLASH_OP_RANGE_ERROR },
+        { FLASH_BASE + 4, Size_256B, FLASH_ALIGN_ERROR },
+        { FLASH_BASE, Size_256B + 4, FLASH_ALIGN_ERROR },
+        { FLASH_BASE, 0, FLASH_ALIGN_ERROR },
+    };
+    FLASH_Status s;
+    int i, bad = 0;
+
+    Test_Fill( );
+    Sim_Clear( );
+    for( i = 0; i < (int)( sizeof( arg ) / sizeof( arg[ 0 ] ) ); i++ )
+    {
+        s = FLASH_ROM_UPDATE( arg[ i ].Addr, Test_Buf, arg[ i ].Len );
+        if( s != arg[ i ].Status )
+        {
+            printf( "  %08x+%x: status %d, expected %d\n", arg[ i ].Addr, arg[ i ].Len, s, arg[ i ].Status );
+            bad++;
+        }
+    }
+    return bad + ( Sim_Ops( ) != 0 ) + Sim_Fault;
+}
+
+/*********************************************************************
+ * @fn      Test_Self
+ *
+ * @brief   Run every self-test case, each in its own process.
+ *
+ * @return  number of failed cases
+ */
+static int Test_Self( void )
+{
+    static const struct
+    {
+        const char *Name;
+        int ( *Run )( void );
+    } test[ ] =
+    {
+        { "whole flash: written, written again unchanged, 3 words changed", Test_Whole },
+        { "zero page erased, range erased beforehand programmed only", Test_Pre_Erased },
+        { "page reading as erased: read back, erased and programmed again", Test_Look_Erased },
+        { "2000 random updates: only the changed pages erased", Test_Random },
+        { "misaligned or out of range: error, no flash operation", Test_Args },
+    };
+    pid_t pid;
+    int i, st, fail = 0;
+
+    for( i = 0; i < (int)( sizeof( test ) / sizeof( test[ 0 ] ) ); i++ )
+    {
+        printf( "%s\n", test[ i ].Name );
+        fflush( stdout );
+        pid = fork( );
+        if( pid == 0 )
+        {
+            srand( i + 1 );
+            st = ( Sim_Open( ) == 0 ) ? test[ i ].Run( ) : 1;
+            fflush( stdout );
+            _exit( st ? 1 : 0 );
+        }
+        if( ( pid < 0 ) || ( waitpid( pid, &st, 0 ) != pid ) || !WIFEXITED( st ) || WEXITSTATUS( st ) )
+        {
+            printf( "  FAIL\n" );
+            fail++;
+        }
+        else
+        {
+            printf( "  ok\n" );
+        }
+    }
+    printf( "%s\n", fail ? "self-test FAILED" : "self-test passed" );
+    return fail;
+}
+
+int main( int argc, char **argv )
+{
+    int c, seed = 1;
+
+    while( ( c = getopt( argc, argv, "s:t" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 's':
+                seed = atoi( optarg );
+                break;
+            case 't':
+                return Test_Self( ) ? 1 : 0;
+            default:
+                fprintf( stderr, "usage: %s [-s seed] | -t\n", argv[ 0 ] );
+                return 2;
+        }
+    }
+    srand( seed );
+    if( Sim_Open( ) )
+    {
+        return 1;
+    }
+    return Test_Whole( ) ? 1 : 0;
+}
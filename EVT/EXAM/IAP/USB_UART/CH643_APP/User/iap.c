@@ -68,6 +68,33 @@ void Program_Buf_Modify(void)
     }
 }
 
+/*********************************************************************
+ * @fn      IAP_Boot_Confirm
+ *
+ * @brief   Confirm an image on trial, so the IAP keeps starting it. Call
+ *          once the application is known to work.
+ *
+ * @return  none
+ */
+void IAP_Boot_Confirm(void)
+{
+    IAP_IMAGE_INFO *pinfo = (IAP_IMAGE_INFO *)(CalAddr & 0xFFFFFF00);
+
+    if ((pinfo->Magic != IAP_IMAGE_MAGIC) || (pinfo->Boot == IAP_BOOT_OK)) {
+        return;
+    }
+    for (int i = 0; i < 64; i++) {
+        Program_Buf[i] = *(uint32_t*)((CalAddr & 0xFFFFFF00) + 4 * i);
+    }
+    ((IAP_IMAGE_INFO *)Program_Buf)->Boot = IAP_BOOT_OK;
+
+    FLASH_Unlock_Fast();
+    FLASH_ErasePage_Fast(CalAddr & 0xFFFFFF00);
+    CH32_IAP_Program(CalAddr & 0xFFFFFF00, (u32*)Program_Buf);
+    FLASH->CTLR |= ((uint32_t)0x00008000);
+    FLASH->CTLR |= ((uint32_t)0x00000080);
+}
+
 /*********************************************************************
  * @fn      RecData_Deal
  *
@@ -14,7 +14,9 @@
 
 #include "ch643.h"
 #include "stdio.h"
-#include "ch643_usbfs_device.h"
+#include "debug.h"
+#include "string.h"
+#include "iap_image.h"
 
 #define USBD_DATA_SIZE    64
 #define FLASH_Base        0x08005000
@@ -75,6 +77,7 @@ extern u8 EP2_Rx_Buffer[USBD_DATA_SIZE+4];
 extern u8 End_Flag;
 
 u8 RecData_Deal(void);
+void IAP_Boot_Confirm(void);
 void USART2_CFG(u32 baudrate);
 
 void UART_Rx_Deal(void);
@@ -0,0 +1,57 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_image.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Image header and image record shared by the
+ *                      bootloader, the application and the host tools.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#ifndef __IAP_IMAGE_H
+#define __IAP_IMAGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*
+ * Image header, put before a plain image by the host, all numbers little
+ * endian; the header itself is not programmed:
+ *   'W' 'C' 'H' 'I' - magic, a plain image never starts like this
+ *   size (4 bytes)  - length of the image
+ *   crc (4 bytes)   - CRC32 (IEEE 802.3) of the image
+ * The bootloader computes the CRC32 of each page as it is programmed, so
+ * the image is checked without being sent back. Compressed and delta
+ * images carry the same two numbers in their own headers.
+ */
+#define IAP_IMAGE_HEAD_LEN    12
+#define IAP_IMAGE_MAGIC       0x49484357                      // "WCHI"
+
+/*
+ * Image record, at the start of the flag page. The bootloader writes it
+ * once an image is checked and starts the application only while the
+ * CRC32 of flash matches it. A new image is on trial: each start counts
+ * down Boot, and once no try is left the bootloader keeps control until
+ * the application confirms itself by setting Boot to IAP_BOOT_OK.
+ */
+#define IAP_BOOT_OK           0x4B4F4B4F                      // "OKOK"
+#define IAP_BOOT_TRIES        3
+
+typedef struct _IAP_IMAGE_INFO
+{
+    uint32_t Magic;                                           // IAP_IMAGE_MAGIC
+    uint32_t Len;
+    uint32_t Crc;
+    uint32_t Boot;                                            // IAP_BOOT_OK, or tries left
+} IAP_IMAGE_INFO;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
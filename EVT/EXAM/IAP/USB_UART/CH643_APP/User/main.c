@@ -16,13 +16,24 @@
  * Key  parameters: CalAddr - address in flash(same in IAP), note that this address needs to be unused.
  *                  CheckNum - The value of 'CalAddr' that needs to be modified.
  * Tips :the routine need IAP software version 1.50.
+ * The IAP starts a new image a few times only, until it confirms itself with
+ * IAP_Boot_Confirm; the image record it keeps is in the same flag page.
+ * Functions named in Ld/hot_code.ld run from RAM: Link.ld puts them in .highcode and
+ * Startup/startup_ch643.S copies it, the startup of SRC/Startup does not and is not
+ * linked into this project. pc_prof.c comes from RunInRam/Prof_Lib. With APP_PROF
+ * set to 1, the PC is sampled for APP_PROF_TICKS turns of the main loop while the
+ * USB and UART links are used, then the histogram is printed; make Ld/hot_code.ld from
+ * it with RunInRam/RunInRAM_Profile/Tool/hot_code as that example describes.
  */
 
-#include "ch643_usbfs_device.h"
 #include "debug.h"
 #include "iap.h"
+#include "usbd_iap.h"
+#include "pc_prof.h"
 
 /* Global define */
+#define APP_PROF            0
+#define APP_PROF_TICKS      40                        // 250ms turns of the main loop sampled
 
 /* Global Variable */
 
@@ -90,6 +101,9 @@ void USART2_IT_CFG(void)
 int main(void)
 {
     u8 i = 0;
+#if APP_PROF
+    u32 n = 0;
+#endif
 
     NVIC_PriorityGroupConfig(NVIC_PriorityGroup_1);
     SystemCoreClockUpdate();
@@ -102,13 +116,28 @@ int main(void)
     GPIO_Toggle_INIT();
 
     /* Usb Init */
+    USBFS_Class_Register( &IAP_Class_Drv );
     USBFS_RCC_Init( );
     USBFS_Device_Init( ENABLE ,PWR_VDD_SupplyVoltage());
     USART2_CFG(460800);
     USART2_IT_CFG();
+    /* Up and running: keep being started by the IAP */
+    IAP_Boot_Confirm();
+#if APP_PROF
+    /* After every NVIC set-up, so that they are all moved below TIM3 */
+    PC_Prof_Init( );
+    PC_Prof_Start( );
+#endif
     while(1)
     {
         Delay_Ms(250);
+#if APP_PROF
+        if( ++n == APP_PROF_TICKS )
+        {
+            PC_Prof_Stop( );
+            PC_Prof_Dump( );
+        }
+#endif
         GPIO_WriteBit(GPIOB, GPIO_Pin_0, (i == 0) ? (i = Bit_SET) : (i = Bit_RESET));
         if(*(uint32_t*)CalAddr == CheckNum)
         {
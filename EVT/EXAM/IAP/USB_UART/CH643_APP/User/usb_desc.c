@@ -0,0 +1,74 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : usb_desc.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : usb device descriptor,configuration descriptor,
+ *                      string descriptors and other descriptors.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "usb_desc.h"
+
+/* Device Descriptor */
+const uint8_t  MyDevDescr[] =
+{
+    0x12,       // bLength
+    0x01,       // bDescriptorType (Device)
+    0x10, 0x01, // bcdUSB 1.10
+    0xFF,       // bDeviceClass
+    0x80,       // bDeviceSubClass
+    0x55,       // bDeviceProtocol
+    DEF_USBD_UEP0_SIZE,   // bMaxPacketSize0 64
+    (uint8_t)DEF_USB_VID, (uint8_t)(DEF_USB_VID >> 8),  // idVendor  0x1A86
+    (uint8_t)DEF_USB_PID, (uint8_t)(DEF_USB_PID >> 8),  // idProduct 0x55E0
+    (uint8_t)DEF_IC_PRG_VER, (uint8_t)(DEF_IC_PRG_VER >> 8), // bcdDevice 1.00
+    0x00,       // iManufacturer (String Index)
+    0x00,       // iProduct (String Index)
+    0x00,       // iSerialNumber (String Index)
+    0x01,       // bNumConfigurations 1
+};
+
+/* Configuration Descriptor: vendor IAP interface 0 */
+const uint8_t  MyCfgDescr[] =
+{
+    /* Configure descriptor */
+    0x09, 0x02, 0x20, 0x00, 0x01, 0x01, 0x00, 0x80, 0x32,
+
+    /* Interface 0 (vendor IAP) descriptor */
+    0x09, 0x04, 0x00, 0x00, 0x02, 0xFF, 0x80, 0x55, 0x00,
+
+    /* Endpoint descriptor */
+    0x07, 0x05, 0x82, 0x02, (uint8_t)DEF_USBD_ENDP2_SIZE, (uint8_t)( DEF_USBD_ENDP2_SIZE >> 8 ), 0x00,
+
+    /* Endpoint descriptor */
+    0x07, 0x05, 0x02, 0x02, (uint8_t)DEF_USBD_ENDP2_SIZE, (uint8_t)( DEF_USBD_ENDP2_SIZE >> 8 ), 0x00,
+};
+
+/* Language Descriptor */
+const uint8_t  MyLangDescr[] =
+{
+    0x04, 0x03, 0x09, 0x04
+};
+
+/* The device descriptor names no strings, these are left empty */
+/* Manufacturer Descriptor */
+const uint8_t  MyManuInfo[] =
+{
+    0x02, 0x03
+};
+
+/* Product Information */
+const uint8_t  MyProdInfo[] =
+{
+    0x02, 0x03
+};
+
+/* Serial Number Information */
+const uint8_t  MySerNumInfo[] =
+{
+    0x02, 0x03
+};
@@ -0,0 +1,344 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : dfu.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : USB DFU 1.1 (DFU mode) firmware download and upload of
+ *                      the user code area, usable with dfu-util. Requests are
+ *                      answered in the USBFS interrupt, the flash is written
+ *                      by DFU_Process in the main loop.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#include "dfu.h"
+#include "iap_lz.h"
+#include "string.h"
+
+/******************************************************************************/
+DFU_CTL Dfu;
+
+/* One block is received into one buffer while the other is programmed */
+__attribute__ ((aligned(4))) u8 DFU_Buf[ DEF_DFU_BUF_NUM ][ DEF_DFU_XFER_SIZE ];
+
+/*********************************************************************
+ * @fn      DFU_Init
+ *
+ * @brief   Reset the DFU state machine to dfuIDLE.
+ *
+ * @return  none
+ */
+void DFU_Init(void)
+{
+    memset(&Dfu, 0, sizeof(Dfu));
+    Dfu.State = DFU_STA_IDLE;
+    Dfu.Status = DFU_OK;
+}
+
+/*********************************************************************
+ * @fn      DFU_Stall
+ *
+ * @brief   Refuse a request, entering dfuERROR.
+ *
+ * @param   status - bStatus reported by the next DFU_GETSTATUS
+ *
+ * @return  DEF_USBD_REQ_ERR
+ */
+static u8 DFU_Stall(u8 status)
+{
+    Dfu.Status = status;
+    Dfu.State = DFU_STA_ERROR;
+    return DEF_USBD_REQ_ERR;
+}
+
+/*********************************************************************
+ * @fn      DFU_Status
+ *
+ * @brief   Move on from a SYNC state and build the DFU_GETSTATUS reply.
+ *
+ * @return  none
+ */
+static void DFU_Status(void)
+{
+    u8 poll = 0;
+
+    switch (Dfu.State) {
+    case DFU_STA_DNLOAD_SYNC:
+    case DFU_STA_DNBUSY:
+        /* The host polls again after bwPollTimeout, so dfuDNBUSY is
+         * left here rather than on a timer */
+        if (Dfu.Prog_Err != DFU_OK) {
+            Dfu.Status = Dfu.Prog_Err;
+            Dfu.State = DFU_STA_ERROR;
+        } else if (Dfu.Buf_Busy[Dfu.Rx_Idx] == 0) {
+            Dfu.State = DFU_STA_DNLOAD_IDLE;
+        } else {
+            Dfu.State = DFU_STA_DNBUSY;
+            poll = DEF_DFU_POLL_MS;
+        }
+        break;
+
+    case DFU_STA_MANIFEST_SYNC:
+        Dfu.Manifest = 1;
+        Dfu.State = DFU_STA_MANIFEST;
+        poll = DEF_DFU_POLL_MS;
+        break;
+
+    case DFU_STA_MANIFEST:
+        if (Dfu.Manifest) {
+            poll = DEF_DFU_POLL_MS;
+        } else if (Dfu.Prog_Err != DFU_OK) {
+            Dfu.Status = Dfu.Prog_Err;
+            Dfu.State = DFU_STA_ERROR;
+        } else {
+            Dfu.State = DFU_STA_IDLE;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    USBFS_EP0_4Buf[0] = Dfu.Status;
+    USBFS_EP0_4Buf[1] = poll;
+    USBFS_EP0_4Buf[2] = 0x00;
+    USBFS_EP0_4Buf[3] = 0x00;
+    USBFS_EP0_4Buf[4] = Dfu.State;
+    USBFS_EP0_4Buf[5] = 0x00;
+}
+
+/*********************************************************************
+ * @fn      DFU_Setup
+ *
+ * @brief   Handle one DFU class request addressed to DEF_DFU_ITF,
+ *          called from the SETUP stage.
+ *
+ * @return  DEF_USBD_REQ_OK or DEF_USBD_REQ_ERR
+ */
+static u8 DFU_Setup(const uint8_t **ppbuf, uint16_t *plen)
+{
+    u16 len;
+
+    if ((USBFS_SetupReqType & (USB_REQ_TYP_MASK | USB_REQ_RECIP_MASK)) != (USB_REQ_TYP_CLASS | USB_REQ_RECIP_INTERF)) {
+        return DEF_USBD_REQ_ERR;
+    }
+
+    switch (USBFS_SetupReqCode) {
+    case DFU_DNLOAD:
+        if ((Dfu.State != DFU_STA_IDLE) && (Dfu.State != DFU_STA_DNLOAD_IDLE)) {
+            return DFU_Stall(DFU_ERR_STALLEDPKT);
+        }
+        if (USBFS_SetupReqLen == 0) {
+            /* Zero length block: end of the image */
+            if (Dfu.State == DFU_STA_IDLE) {
+                return DFU_Stall(DFU_ERR_STALLEDPKT);
+            }
+            Dfu.State = DFU_STA_MANIFEST_SYNC;
+            return DEF_USBD_REQ_OK;
+        }
+        if (Dfu.State == DFU_STA_IDLE) {
+            Dfu.Dn_Off = 0;
+            Dfu.Crc = 0;
+            Dfu.Done = 0;
+        }
+        if (USBFS_SetupReqLen > DEF_DFU_XFER_SIZE) {
+            return DFU_Stall(DFU_ERR_STALLEDPKT);
+        }
+        /* Only the last block may be shorter than a page */
+        if ((Dfu.Dn_Off & (DEF_DFU_PAGE_SIZE - 1))
+                || (Dfu.Dn_Off + USBFS_SetupReqLen > DEF_DFU_APP_SIZE)) {
+            return DFU_Stall(DFU_ERR_ADDRESS);
+        }
+        if (Dfu.Buf_Busy[Dfu.Rx_Idx]) {
+            return DFU_Stall(DFU_ERR_STALLEDPKT);
+        }
+        Dfu.Rx_Len = 0;
+        Dfu.Rx_Total = USBFS_SetupReqLen;
+        break;
+
+    case DFU_UPLOAD:
+        if ((Dfu.State != DFU_STA_IDLE) && (Dfu.State != DFU_STA_UPLOAD_IDLE)) {
+            return DFU_Stall(DFU_ERR_STALLEDPKT);
+        }
+        if (Dfu.State == DFU_STA_IDLE) {
+            Dfu.Up_Off = 0;
+        }
+        /* Sent straight from the flash, a short block ends the upload */
+        len = USBFS_SetupReqLen;
+        if (len > DEF_DFU_XFER_SIZE) {
+            len = DEF_DFU_XFER_SIZE;
+        }
+        if (len > DEF_DFU_APP_SIZE - Dfu.Up_Off) {
+            len = DEF_DFU_APP_SIZE - Dfu.Up_Off;
+        }
+        Dfu.State = (len < USBFS_SetupReqLen) ? DFU_STA_IDLE : DFU_STA_UPLOAD_IDLE;
+        *ppbuf = (const uint8_t *)(FLASH_Base + Dfu.Up_Off);
+        *plen = len;
+        Dfu.Up_Off += len;
+        break;
+
+    case DFU_GETSTATUS:
+        DFU_Status();
+        if (USBFS_SetupReqLen > 6) {
+            USBFS_SetupReqLen = 6;
+        }
+        break;
+
+    case DFU_CLRSTATUS:
+        if (Dfu.State != DFU_STA_ERROR) {
+            return DFU_Stall(DFU_ERR_STALLEDPKT);
+        }
+        Dfu.Status = DFU_OK;
+        Dfu.Prog_Err = DFU_OK;
+        Dfu.State = DFU_STA_IDLE;
+        break;
+
+    case DFU_GETSTATE:
+        USBFS_EP0_4Buf[0] = Dfu.State;
+        if (USBFS_SetupReqLen > 1) {
+            USBFS_SetupReqLen = 1;
+        }
+        break;
+
+    case DFU_ABORT:
+        if (Dfu.State == DFU_STA_ERROR) {
+            return DEF_USBD_REQ_ERR;
+        }
+        Dfu.Rx_Total = 0;
+        Dfu.State = DFU_STA_IDLE;
+        break;
+
+    case DFU_DETACH:
+        /* Leave DFU mode once a complete image has been written */
+        if ((Dfu.State != DFU_STA_IDLE) || (Dfu.Done == 0)) {
+            return DFU_Stall(DFU_ERR_STALLEDPKT);
+        }
+        End_Flag = 1;
+        break;
+
+    default:
+        return DFU_Stall(DFU_ERR_STALLEDPKT);
+    }
+    return DEF_USBD_REQ_OK;
+}
+
+/*********************************************************************
+ * @fn      DFU_EP0_Out
+ *
+ * @brief   Collect the data stage of DFU_DNLOAD, handing the block to
+ *          the main loop once complete.
+ *
+ * @param   pbuf - packet
+ *          len - packet length
+ *
+ * @return  none
+ */
+static void DFU_EP0_Out(u8 *pbuf, u16 len)
+{
+    u8 i = Dfu.Rx_Idx;
+
+    if (Dfu.Rx_Total == 0) {
+        return;
+    }
+    if (len > Dfu.Rx_Total - Dfu.Rx_Len) {
+        len = Dfu.Rx_Total - Dfu.Rx_Len;
+    }
+    memcpy(&DFU_Buf[i][Dfu.Rx_Len], pbuf, len);
+    Dfu.Rx_Len += len;
+
+    if (Dfu.Rx_Len == Dfu.Rx_Total) {
+        Dfu.Buf_Addr[i] = FLASH_Base + Dfu.Dn_Off;
+        Dfu.Buf_Len[i] = Dfu.Rx_Total;
+        Dfu.Buf_Busy[i] = 1;
+        Dfu.Dn_Off += Dfu.Rx_Total;
+        Dfu.Rx_Idx = i ^ 1;
+        Dfu.Rx_Total = 0;
+        Dfu.State = DFU_STA_DNLOAD_SYNC;
+    }
+}
+
+/*********************************************************************
+ * @fn      DFU_Bus_Reset
+ *
+ * @brief   USB bus reset: start a manifested image, else back to dfuIDLE.
+ *          Also called once by USBFS_Device_Init, after DFU_Init.
+ *
+ * @return  none
+ */
+static void DFU_Bus_Reset(void)
+{
+    if (Dfu.Done && (Dfu.State == DFU_STA_IDLE)) {
+        End_Flag = 1;
+    } else if ((Dfu.State != DFU_STA_MANIFEST) && (Dfu.State != DFU_STA_ERROR)) {
+        Dfu.Rx_Total = 0;
+        Dfu.State = DFU_STA_IDLE;
+    }
+}
+
+/*********************************************************************
+ * @fn      DFU_Process
+ *
+ * @brief   Program the received blocks in order and finish the image
+ *          with its record, called from the main loop.
+ *
+ * @return  none
+ */
+void DFU_Process(void)
+{
+    u8  i = Dfu.Prog_Idx;
+    u32 addr;
+    u16 len, n, off;
+    IAP_IMAGE_INFO info;
+
+    if (Dfu.Buf_Busy[i]) {
+        if (Dfu.Prog_Err == DFU_OK) {
+            addr = Dfu.Buf_Addr[i];
+            len = Dfu.Buf_Len[i];
+
+            /* Pad the last block to whole pages */
+            n = (len + DEF_DFU_PAGE_SIZE - 1) & ~(DEF_DFU_PAGE_SIZE - 1);
+            memset(&DFU_Buf[i][len], 0xFF, n - len);
+
+            IAP_Flag_Mark();
+            FLASH_Unlock_Fast();
+            for (off = 0; off < n; off += DEF_DFU_PAGE_SIZE) {
+                FLASH_ErasePage_Fast(addr + off);
+                CH32_IAP_Program(addr + off, (u32*) &DFU_Buf[i][off]);
+            }
+            if (memcmp((void *) addr, DFU_Buf[i], len)) {
+                Dfu.Prog_Err = DFU_ERR_VERIFY;
+            }
+            Dfu.Crc = IAP_LZ_Crc32(Dfu.Crc, (const uint8_t *) addr, len);
+        }
+        Dfu.Buf_Busy[i] = 0;
+        Dfu.Prog_Idx = i ^ 1;
+    } else if (Dfu.Manifest) {
+        /* Blocks are programmed in order, so none is pending now */
+        if (Dfu.Prog_Err == DFU_OK) {
+            info.Magic = IAP_IMAGE_MAGIC;
+            info.Len = Dfu.Dn_Off;
+            info.Crc = Dfu.Crc;
+            info.Boot = IAP_BOOT_TRIES;
+            IAP_Info_Write(&info, 0xFFFFFFFF);
+            Dfu.Done = 1;
+        }
+        FLASH->CTLR |= ((uint32_t)0x00008000);  //FLASH_Lock_Fast
+        FLASH->CTLR |= ((uint32_t)0x00000080);  //FLASH_Lock
+        Dfu.Manifest = 0;
+    }
+}
+
+/* Class driver, interface 1 has no endpoints */
+const USBFS_CLASS_DRV DFU_Class_Drv =
+{
+    DEF_DFU_ITF, 1,
+    0,
+    DFU_Bus_Reset,
+    DFU_Setup,
+    DFU_EP0_Out,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+};
@@ -0,0 +1,94 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : dfu.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : USB DFU 1.1 (DFU mode) interface of the IAP
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#ifndef __DFU_H
+#define __DFU_H
+
+#include <ch643_usbfs_device.h>
+#include "iap.h"
+
+/* DFU interface, next to the vendor IAP interface 0 */
+#define DEF_DFU_ITF             0x01
+
+/* wTransferSize, whole fast-programming pages. One block is programmed
+ * from the main loop while the host sends the next into the other buffer. */
+#define DEF_DFU_PAGE_SIZE       256
+#define DEF_DFU_XFER_SIZE       ( 4 * DEF_DFU_PAGE_SIZE )
+#define DEF_DFU_BUF_NUM         2
+
+/* The image goes to FLASH_Base up to the page holding the IAP flag */
+#define DEF_DFU_APP_SIZE        ( ( CalAddr & 0xFFFFFF00 ) - FLASH_Base )
+
+/* bmAttributes: bitCanDnload | bitCanUpload | bitManifestationTolerant.
+ * The device stays in DFU mode after the image is manifested, so it can be
+ * read back, and starts it on DFU_DETACH or the next bus reset. */
+#define DEF_DFU_ATTR            0x07
+#define DEF_DFU_DETACH_TIMEOUT  255
+#define DEF_DFU_POLL_MS         5                  /* bwPollTimeout while both buffers are being programmed */
+
+/* Class requests */
+#define DFU_DETACH              0x00
+#define DFU_DNLOAD              0x01
+#define DFU_UPLOAD              0x02
+#define DFU_GETSTATUS           0x03
+#define DFU_CLRSTATUS           0x04
+#define DFU_GETSTATE            0x05
+#define DFU_ABORT               0x06
+
+/* bState */
+#define DFU_STA_APP_IDLE        0x00
+#define DFU_STA_APP_DETACH      0x01
+#define DFU_STA_IDLE            0x02
+#define DFU_STA_DNLOAD_SYNC     0x03
+#define DFU_STA_DNBUSY          0x04
+#define DFU_STA_DNLOAD_IDLE     0x05
+#define DFU_STA_MANIFEST_SYNC   0x06
+#define DFU_STA_MANIFEST        0x07
+#define DFU_STA_MANIFEST_WAIT   0x08
+#define DFU_STA_UPLOAD_IDLE     0x09
+#define DFU_STA_ERROR           0x0A
+
+/* bStatus */
+#define DFU_OK                  0x00
+#define DFU_ERR_WRITE           0x03
+#define DFU_ERR_ERASE           0x04
+#define DFU_ERR_PROG            0x06
+#define DFU_ERR_VERIFY          0x07
+#define DFU_ERR_ADDRESS         0x08
+#define DFU_ERR_NOTDONE         0x09
+#define DFU_ERR_STALLEDPKT      0x0F
+
+typedef struct _DFU_CTL
+{
+    volatile u8 State;                             /* DFU_STA_xx */
+    u8  Status;                                    /* DFU_OK, DFU_ERR_xx */
+    volatile u8 Prog_Err;                          /* Programming failure, reported on the next GETSTATUS */
+    volatile u8 Manifest;                          /* Image complete, main loop to finish it */
+    volatile u8 Done;                              /* Image manifested, start it on detach or bus reset */
+    u32 Dn_Off;                                    /* Image offset of the next DNLOAD block */
+    u32 Up_Off;                                    /* Image offset of the next UPLOAD block */
+    u32 Crc;                                       /* CRC32 of the blocks programmed */
+    u16 Rx_Len;                                    /* Bytes of the current DNLOAD block received */
+    u16 Rx_Total;                                  /* wLength of the current DNLOAD block */
+    u8  Rx_Idx;                                    /* Buffer the host fills next */
+    u8  Prog_Idx;                                  /* Buffer programmed next, blocks are programmed in order */
+    volatile u8 Buf_Busy[ DEF_DFU_BUF_NUM ];       /* Buffer holds a block not yet programmed */
+    u32 Buf_Addr[ DEF_DFU_BUF_NUM ];
+    u16 Buf_Len[ DEF_DFU_BUF_NUM ];
+} DFU_CTL;
+
+extern DFU_CTL Dfu;
+extern const USBFS_CLASS_DRV DFU_Class_Drv;
+
+void DFU_Init(void);
+void DFU_Process(void);
+
+#endif
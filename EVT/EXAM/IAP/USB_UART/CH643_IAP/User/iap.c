@@ -10,19 +10,37 @@
 * microcontroller manufactured by Nanjing Qinheng Microelectronics.
 *******************************************************************************/
 #include "iap.h"
+#include "iap_lz.h"
+#include "iap_delta.h"
+#include "iap_image.h"
 #include "string.h"
 #include "core_riscv.h"
 
 /******************************************************************************/
 
 iapfun jump2app;
-u32 Program_addr = FLASH_Base;
 u32 Verify_addr = FLASH_Base;
 u32 User_APP_Addr_offset = 0x5000;
 u8 Verify_Star_flag = 0;
-u8 Fast_Program_Buf[390];
-u32 CodeLen = 0;
+__attribute__((aligned(4))) u8 Prog_Buf[IAP_BUF_PAGES * IAP_PAGE_SIZE];
+u32 Rx_Cnt = 0;                    /* image bytes received */
+volatile u32 Prog_Cnt = 0;         /* image bytes programmed, whole pages */
+u32 Erase_addr = FLASH_Base;       /* flash is erased up to here */
+volatile u8 IAP_Pend = 0;          /* USB command waiting for IAP_Process */
+IAP_LZ_DEC Lz_Dec;                 /* decoder of a compressed image, Prog_Buf is its window */
+u8 Lz_Flag = 0;                    /* 1 - the image being received is compressed */
+u8 Lz_In_Pos = 0;                  /* bytes of the current packet already decoded */
+IAP_DELTA Delta;                   /* applier of a delta image, pages are built in Prog_Buf */
+u8 Delta_Flag = 0;                 /* 1 - the image being received is a delta */
+u8 Delta_In_Pos = 0;               /* bytes of the current packet already applied */
+u32 Img_Len = 0;                   /* image bytes received, the padding of the last page excluded */
+u32 Img_Crc = 0;                   /* CRC32 of the image bytes programmed so far */
+u8 Head_Flag = 0;                  /* 1 - the plain image came with the IAP_IMAGE header */
+u32 Head_Len = 0;
+u32 Head_Crc = 0;
 u8 End_Flag = 0;
+__attribute__((aligned(4))) u8 Uart_Rx_Ring[UART_RX_RING_LEN];
+u16 Uart_Rx_Tail = 0;
 u8 EP2_Rx_Buffer[USBD_DATA_SIZE+4];
 #define  isp_cmd_t   ((isp_cmd  *)EP2_Rx_Buffer)
 
@@ -45,6 +63,447 @@ void CH32_IAP_Program(u32 adr, u32* buf)
     FLASH_ProgramPage_Fast(adr);
 }
 
+/*********************************************************************
+ * @fn      IAP_Erase
+ *
+ * @brief   Erase ahead from a page, with the biggest unit that starts
+ *          there and stays inside the user code area: a 32K block, a
+ *          1K page or a 256 byte page.
+ *
+ * @param   adr - page address
+ *
+ * @return  none
+ */
+static void IAP_Erase(u32 adr)
+{
+    if (((adr & 0x7FFF) == 0) && (adr + 0x8000 <= IAP_APP_END)) {
+        FLASH_EraseBlock_32K_Fast(adr);
+        Erase_addr = adr + 0x8000;
+    } else if (((adr & 0x3FF) == 0) && (adr + 0x400 <= IAP_APP_END)) {
+        FLASH_ErasePage(adr);
+        Erase_addr = adr + 0x400;
+    } else {
+        FLASH_ErasePage_Fast(adr);
+        Erase_addr = adr + IAP_PAGE_SIZE;
+    }
+}
+
+/*********************************************************************
+ * @fn      IAP_Reset
+ *
+ * @brief   Start a new image. Only called with no whole page waiting,
+ *          so IAP_Process is not using the counters.
+ *
+ * @return  none
+ */
+static void IAP_Reset(void)
+{
+    Rx_Cnt = 0;
+    Prog_Cnt = 0;
+    Erase_addr = FLASH_Base;
+    Verify_Star_flag = 0;
+    Verify_addr = FLASH_Base;
+    Lz_Flag = 0;
+    Lz_In_Pos = 0;
+    Delta_Flag = 0;
+    Delta_In_Pos = 0;
+    Img_Len = 0;
+    Img_Crc = 0;
+    Head_Flag = 0;
+}
+
+/*********************************************************************
+ * @fn      IAP_Get32
+ *
+ * @brief   Little endian word at any alignment.
+ *
+ * @return  word
+ */
+static u32 IAP_Get32(const u8 *p)
+{
+    return p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+/*********************************************************************
+ * @fn      IAP_Page_Pending
+ *
+ * @brief   Check for a whole page waiting for IAP_Process.
+ *
+ * @return  1 - waiting, 0 - none
+ */
+static u8 IAP_Page_Pending(void)
+{
+    return (Rx_Cnt - Prog_Cnt >= IAP_PAGE_SIZE) || (Delta_Flag && (Delta.State == IAP_DELTA_ST_READY));
+}
+
+/*********************************************************************
+ * @fn      IAP_Rx_Lz
+ *
+ * @brief   Decode a packet of a compressed image into the page ring. A
+ *          packet that does not fit is taken in parts, the same packet
+ *          being passed again after ERR_Busy.
+ *
+ * @param   pbuf - compressed code
+ *          len - length
+ *
+ * @return  ERR_SUCCESS, ERR_Busy - ring full, ERR_ERROR - damaged or too long
+ */
+static u8 IAP_Rx_Lz(u8 *pbuf, u8 len)
+{
+    Lz_Dec.Limit = Prog_Cnt + sizeof(Prog_Buf);
+    Lz_In_Pos += IAP_LZ_Decode(&Lz_Dec, pbuf + Lz_In_Pos, len - Lz_In_Pos);
+    Rx_Cnt = Lz_Dec.Out;
+    Img_Len = Rx_Cnt;
+
+    if ((Lz_Dec.State == IAP_LZ_ST_ERR) ||
+        ((Lz_Dec.State != IAP_LZ_ST_HEAD) && (Lz_Dec.Size > IAP_APP_END - FLASH_Base))) {
+        Lz_Dec.State = IAP_LZ_ST_ERR;
+        Lz_In_Pos = 0;
+        return ERR_ERROR;
+    }
+    if (((Lz_In_Pos < len) && (Lz_Dec.State != IAP_LZ_ST_DONE)) || Lz_Dec.Len) {
+        return ERR_Busy;
+    }
+    Lz_In_Pos = 0;
+
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      IAP_Rx_Delta
+ *
+ * @brief   Apply a packet of a delta image. The packet is taken again
+ *          after ERR_Busy each time a page it completes is programmed.
+ *
+ * @param   pbuf - delta data
+ *          len - length
+ *
+ * @return  ERR_SUCCESS, ERR_Busy - page waiting, ERR_ERROR - not made for
+ *          this flash or damaged
+ */
+static u8 IAP_Rx_Delta(u8 *pbuf, u8 len)
+{
+    Delta_In_Pos += IAP_Delta_Apply(&Delta, pbuf + Delta_In_Pos, len - Delta_In_Pos);
+
+    if (Delta.State == IAP_DELTA_ST_ERR) {
+        Delta_In_Pos = 0;
+        return ERR_ERROR;
+    }
+    if (Delta.State == IAP_DELTA_ST_READY) {
+        return ERR_Busy;
+    }
+    Delta_In_Pos = 0;
+
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      IAP_Rx_Data
+ *
+ * @brief   Put received code into the page ring. An image starting with
+ *          the IAP_LZ header is decoded on the way, the IAP_IMAGE header
+ *          of a plain image is kept aside.
+ *
+ * @param   pbuf - code
+ *          len - length
+ *
+ * @return  ERR_SUCCESS, ERR_Busy - ring full, ERR_ERROR - past the user code area
+ */
+static u8 IAP_Rx_Data(u8 *pbuf, u8 len)
+{
+    u8 i;
+
+    if ((Rx_Cnt == 0) && (Lz_Flag == 0) && (Delta_Flag == 0)) {
+        if (IAP_LZ_Check(pbuf, len)) {
+            IAP_LZ_Init(&Lz_Dec, Prog_Buf, sizeof(Prog_Buf));
+            Lz_Flag = 1;
+        } else if (IAP_Delta_Check(pbuf, len)) {
+            IAP_Delta_Init(&Delta, (const uint8_t *)FLASH_Base, IAP_DELTA_SPARE - FLASH_Base, Prog_Buf);
+            Delta_Flag = 1;
+        } else if ((Head_Flag == 0) && (len >= IAP_IMAGE_HEAD_LEN) && (IAP_Get32(pbuf) == IAP_IMAGE_MAGIC)) {
+            /* The ring is empty, so this packet is never passed again */
+            Head_Len = IAP_Get32(pbuf + 4);
+            Head_Crc = IAP_Get32(pbuf + 8);
+            Head_Flag = 1;
+            pbuf += IAP_IMAGE_HEAD_LEN;
+            len -= IAP_IMAGE_HEAD_LEN;
+        }
+    }
+    if (Lz_Flag) {
+        return IAP_Rx_Lz(pbuf, len);
+    }
+    if (Delta_Flag) {
+        return IAP_Rx_Delta(pbuf, len);
+    }
+
+    if (Rx_Cnt + len > IAP_APP_END - FLASH_Base) {
+        return ERR_ERROR;
+    }
+    if (Rx_Cnt + len - Prog_Cnt > sizeof(Prog_Buf)) {
+        return ERR_Busy;
+    }
+    for (i = 0; i < len; i++) {
+        Prog_Buf[(Rx_Cnt + i) & (sizeof(Prog_Buf) - 1)] = pbuf[i];
+    }
+    Rx_Cnt += len;
+    Img_Len = Rx_Cnt;
+
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      IAP_Rx_Flush
+ *
+ * @brief   Pad the last page with 0xFF once, then wait until every page
+ *          is programmed.
+ *
+ * @return  ERR_SUCCESS, ERR_Busy - pages still waiting
+ */
+static u8 IAP_Rx_Flush(void)
+{
+    if (Verify_Star_flag == 0) {
+        Verify_Star_flag = 1;
+        while (Rx_Cnt & (IAP_PAGE_SIZE - 1)) {
+            Prog_Buf[Rx_Cnt & (sizeof(Prog_Buf) - 1)] = 0xff;
+            Rx_Cnt++;
+        }
+    }
+
+    return (Prog_Cnt == Rx_Cnt) ? ERR_SUCCESS : ERR_Busy;
+}
+
+/*********************************************************************
+ * @fn      IAP_Image_Check
+ *
+ * @brief   Check the image once every page is programmed. A compressed,
+ *          delta or headed image must be complete and match the CRC32 of
+ *          its header; a plain image is checked by the host byte by byte.
+ *
+ * @param   pinfo - takes the length and CRC32 of the image
+ *
+ * @return  ERR_SUCCESS, ERR_ERROR
+ */
+static u8 IAP_Image_Check(IAP_IMAGE_INFO *pinfo)
+{
+    if (Delta_Flag) {
+        /* Pages that already held their new content were not programmed */
+        pinfo->Len = Delta.New_Len;
+        pinfo->Crc = Delta.Crc;
+        if ((Delta.State != IAP_DELTA_ST_DONE) ||
+            (IAP_LZ_Crc32(0, (const uint8_t *)FLASH_Base, Delta.New_Len) != Delta.Crc)) {
+            return ERR_ERROR;
+        }
+        return ERR_SUCCESS;
+    }
+
+    pinfo->Len = Img_Len;
+    pinfo->Crc = Img_Crc;
+    if (Lz_Flag && ((Lz_Dec.State != IAP_LZ_ST_DONE) || (Img_Crc != Lz_Dec.Crc))) {
+        return ERR_ERROR;
+    }
+    if (Head_Flag && ((Img_Len != Head_Len) || (Img_Crc != Head_Crc))) {
+        return ERR_ERROR;
+    }
+
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      IAP_Info_Write
+ *
+ * @brief   Rewrite the flag page with a new image record, keeping the
+ *          rest of the page.
+ *
+ * @param   pinfo - image record
+ *          check - new value of the word at CalAddr
+ *
+ * @return  none
+ */
+void IAP_Info_Write(const IAP_IMAGE_INFO *pinfo, u32 check)
+{
+    u32 buf[IAP_PAGE_SIZE / 4];
+
+    memcpy(buf, (const void *)IAP_APP_END, IAP_PAGE_SIZE);
+    memcpy(buf, pinfo, sizeof(IAP_IMAGE_INFO));
+    buf[(CalAddr - IAP_APP_END) / 4] = check;
+
+    FLASH_Unlock_Fast();
+    FLASH_ErasePage_Fast(IAP_APP_END);
+    CH32_IAP_Program(IAP_APP_END, buf);
+    FLASH->CTLR |= ((uint32_t)0x00008000);  //FLASH_Lock_Fast
+    FLASH->CTLR |= ((uint32_t)0x00000080);  //FLASH_Lock
+}
+
+/*********************************************************************
+ * @fn      IAP_Flag_Blank
+ *
+ * @brief   Check for a blank flag page: all its words equal, whatever the
+ *          erased value. WCH-Link and MounRiver leave it so, and so did
+ *          the bootloaders from before the image record, which erased it
+ *          at CMD_IAP_END.
+ *
+ * @return  1 - blank, 0 - not
+ */
+static u8 IAP_Flag_Blank(void)
+{
+    const u32 *p = (const u32 *)IAP_APP_END;
+    u32 i;
+
+    for (i = 1; i < IAP_PAGE_SIZE / 4; i++) {
+        if (p[i] != p[0]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*********************************************************************
+ * @fn      IAP_Flag_Mark
+ *
+ * @brief   Called before the user code area is changed. A blank flag
+ *          page gets CheckNum at CalAddr, so that an update cut short is
+ *          not taken for a legacy application (IAP_Boot_Check).
+ *
+ * @return  none
+ */
+void IAP_Flag_Mark(void)
+{
+    IAP_IMAGE_INFO info = {0};
+
+    if (IAP_Flag_Blank()) {
+        IAP_Info_Write(&info, CheckNum);
+    }
+}
+
+/*********************************************************************
+ * @fn      IAP_Boot_Check
+ *
+ * @brief   Decide whether the application may be started: its record
+ *          must match the CRC32 of flash, and an image on trial must
+ *          have a try left, which is used up here. With a blank flag page
+ *          (IAP_Flag_Blank) the application has no record at all, and is
+ *          started as confirmed unless the user code area is blank too,
+ *          so units updated to this bootloader keep starting their code.
+ *
+ * @return  1 - start the application, 0 - stay in IAP
+ */
+u8 IAP_Boot_Check(void)
+{
+    IAP_IMAGE_INFO info = *(const IAP_IMAGE_INFO *)IAP_APP_END;
+
+    if (IAP_Flag_Blank()) {
+        return *(const u32 *)FLASH_Base != *(const u32 *)IAP_APP_END;
+    }
+    if ((info.Magic != IAP_IMAGE_MAGIC) || (info.Len == 0) || (info.Len > IAP_APP_END - FLASH_Base) ||
+        (IAP_LZ_Crc32(0, (const uint8_t *)FLASH_Base, info.Len) != info.Crc)) {
+        return 0;
+    }
+    if (info.Boot == IAP_BOOT_OK) {
+        return 1;
+    }
+    if ((info.Boot == 0) || (info.Boot > IAP_BOOT_TRIES)) {
+        return 0;
+    }
+    info.Boot--;
+    IAP_Info_Write(&info, *(u32 *)CalAddr);
+
+    return 1;
+}
+
+/*********************************************************************
+ * @fn      IAP_End
+ *
+ * @brief   Finish the image: once every page is programmed and the image
+ *          checked, write its record, on trial, in place of the IAP flag.
+ *
+ * @return  ERR_End, ERR_Busy - pages still waiting, ERR_ERROR - the image
+ *          is incomplete or damaged, and the IAP stays in charge
+ */
+static u8 IAP_End(void)
+{
+    IAP_IMAGE_INFO info;
+
+    if (IAP_Page_Pending() || (IAP_Rx_Flush() == ERR_Busy)) {
+        return ERR_Busy;
+    }
+    if (IAP_Image_Check(&info) != ERR_SUCCESS) {
+        return ERR_ERROR;
+    }
+    info.Magic = IAP_IMAGE_MAGIC;
+    info.Boot = IAP_BOOT_TRIES;
+    IAP_Info_Write(&info, 0xFFFFFFFF);
+
+    End_Flag = 1;
+    IAP_Reset();
+
+    return ERR_End;
+}
+
+/*********************************************************************
+ * @fn      IAP_Delta_Program
+ *
+ * @brief   Program the page built by the delta applier, saving it in the
+ *          spare page first when it was built from itself.
+ *
+ * @return  none
+ */
+static void IAP_Delta_Program(void)
+{
+    u32 adr = FLASH_Base + (u32)Delta.Page * IAP_PAGE_SIZE;
+
+    IAP_Flag_Mark();
+    FLASH_Unlock_Fast();
+    if (Delta.Flags & IAP_DELTA_F_BACKUP) {
+        FLASH_ErasePage_Fast((u32)(uintptr_t)Delta.pSpare);
+        CH32_IAP_Program((u32)(uintptr_t)Delta.pSpare, (u32*) Prog_Buf);
+    }
+    FLASH_ErasePage_Fast(adr);
+    CH32_IAP_Program(adr, (u32*) Prog_Buf);
+    if (memcmp((const void *)(uintptr_t)adr, Prog_Buf, IAP_PAGE_SIZE)) {
+        Delta.State = IAP_DELTA_ST_ERR;
+        return;
+    }
+    IAP_Delta_Next(&Delta);
+}
+
+/*********************************************************************
+ * @fn      IAP_Process
+ *
+ * @brief   Program the next received page, erasing ahead as needed and
+ *          adding it to the CRC32 of the image, or the next page of a
+ *          delta image, and answer a USB command that waited for it.
+ *          Called from the main loop and while waiting for UART bytes.
+ *
+ * @return  none
+ */
+void IAP_Process(void)
+{
+    u32 adr, n;
+
+    if (Delta_Flag && (Delta.State == IAP_DELTA_ST_READY)) {
+        IAP_Delta_Program();
+    } else if (Rx_Cnt - Prog_Cnt >= IAP_PAGE_SIZE) {
+        adr = FLASH_Base + Prog_Cnt;
+        if (Prog_Cnt == 0) {
+            IAP_Flag_Mark();
+        }
+        FLASH_Unlock_Fast();
+        if (adr >= Erase_addr) {
+            IAP_Erase(adr);
+        }
+        CH32_IAP_Program(adr, (u32*) &Prog_Buf[Prog_Cnt & (sizeof(Prog_Buf) - 1)]);
+        /* The CRC32 is taken from flash, so it covers what was written */
+        n = Img_Len - Prog_Cnt;
+        Img_Crc = IAP_LZ_Crc32(Img_Crc, (const uint8_t *)(uintptr_t)adr, (n < IAP_PAGE_SIZE) ? n : IAP_PAGE_SIZE);
+        Prog_Cnt += IAP_PAGE_SIZE;
+    }
+    if (IAP_Pend) {
+        IAP_Pend = 0;
+        DevEP2_OUT_Resume();
+    }
+}
+
 /*********************************************************************
  * @fn      RecData_Deal
  *
@@ -58,53 +517,40 @@ void CH32_IAP_Program(u32 adr, u32* buf)
 u8 RecData_Deal(void)
 {
      u8 i, s, Lenth;
+     IAP_IMAGE_INFO info;
 
      Lenth = isp_cmd_t->other.buf[1];
 
      switch ( isp_cmd_t->other.buf[0]) {
      case CMD_IAP_ERASE:
+         if (IAP_Page_Pending()) {
+             s = ERR_Busy;
+             break;
+         }
+         IAP_Reset();
          FLASH_Unlock_Fast();
          s = ERR_SUCCESS;
          break;
 
      case CMD_IAP_PROM:
-         for (i = 0; i < Lenth; i++) {
-             Fast_Program_Buf[CodeLen + i] = isp_cmd_t->program.data[i];
-         }
-         CodeLen += Lenth;
-         if (CodeLen >= 256) {
-             FLASH_Unlock_Fast();
-             FLASH_ErasePage_Fast(Program_addr);
-             CH32_IAP_Program(Program_addr, (u32*) Fast_Program_Buf);
-             CodeLen -= 256;
-             for (i = 0; i < CodeLen; i++) {
-                 Fast_Program_Buf[i] = Fast_Program_Buf[256 + i];
-             }
-
-             Program_addr += 0x100;
-
-         }
-         s = ERR_SUCCESS;
+         s = IAP_Rx_Data(isp_cmd_t->program.data, Lenth);
          break;
 
      case CMD_IAP_VERIFY:
-         if (Verify_Star_flag == 0) {
-             Verify_Star_flag = 1;
-            if(CodeLen != 0)
-            {
-                for (i = 0; i < (256 - CodeLen); i++) {
-                    Fast_Program_Buf[CodeLen + i] = 0xff;
-                }
-
-                FLASH_ErasePage_Fast(Program_addr);
-                CH32_IAP_Program(Program_addr, (u32*) Fast_Program_Buf);
-                CodeLen = 0;            
-            }
+         if (IAP_Rx_Flush() == ERR_Busy) {
+             s = ERR_Busy;
+             break;
+         }
+         /* An empty verify checks the image as a whole, against the
+          * CRC32 of its header */
+         if (Lenth == 0) {
+             s = IAP_Image_Check(&info);
+             break;
          }
 
          s = ERR_SUCCESS;
          for (i = 0; i < Lenth; i++) {
-             if (isp_cmd_t->verify.data[i] != *(u8*) (Verify_addr + i)) {
+             if (isp_cmd_t->verify.data[i] != *(u8*)(uintptr_t)(Verify_addr + i)) {
                  s = ERR_ERROR;
                  break;
              }
@@ -115,15 +561,8 @@ u8 RecData_Deal(void)
          break;
 
      case CMD_IAP_END:
-         Verify_Star_flag = 0;
-         End_Flag = 1;
-         Program_addr = FLASH_Base;
-         Verify_addr = FLASH_Base;
-         FLASH_ErasePage_Fast(CalAddr & 0xFFFFFF00);
-         FLASH->CTLR |= ((uint32_t)0x00008000);  //FLASH_Lock_Fast
-         FLASH->CTLR |= ((uint32_t)0x00000080);  //FLASH_Lock
-
-         s = ERR_End;
+         /* An image cut short or damaged keeps the bootloader, to be sent again */
+         s = IAP_End();
          break;
 
      case CMD_JUMP_IAP:
@@ -151,54 +590,36 @@ u8 RecData_Deal(void)
 u8 UART_RecData_Deal(void)
 {
     u8 i, s, Lenth;
+    IAP_IMAGE_INFO info;
 
     Lenth = isp_cmd_t->UART.Len;
     switch ( isp_cmd_t->UART.Cmd) {
     case CMD_IAP_ERASE:
-
+        if (IAP_Page_Pending()) {
+            s = ERR_Busy;
+            break;
+        }
+        IAP_Reset();
         FLASH_Unlock_Fast();
         s = ERR_SUCCESS;
         break;
 
     case CMD_IAP_PROM:
-        for (i = 0; i < Lenth; i++) {
-            Fast_Program_Buf[CodeLen + i] = isp_cmd_t->UART.data[i];
-        }
-        CodeLen += Lenth;
-        if (CodeLen >= 256) {
-            FLASH_Unlock_Fast();
-            FLASH_ErasePage_Fast(Program_addr);
-            CH32_IAP_Program(Program_addr, (u32*) Fast_Program_Buf);
-            CodeLen -= 256;
-            for (i = 0; i < CodeLen; i++) {
-                Fast_Program_Buf[i] = Fast_Program_Buf[256 + i];
-            }
-
-            Program_addr += 0x100;
-
-        }
-        s = ERR_SUCCESS;
+        s = IAP_Rx_Data(isp_cmd_t->UART.data, Lenth);
         break;
 
     case CMD_IAP_VERIFY:
-
-        if (Verify_Star_flag == 0)
-        {
-        Verify_Star_flag = 1;
-          if(CodeLen != 0)
-          {
-            for (i = 0; i < (256 - CodeLen); i++)
-            {
-                Fast_Program_Buf[CodeLen + i] = 0xff;
-            }
-            FLASH_ErasePage_Fast(Program_addr);
-            CH32_IAP_Program(Program_addr, (u32*) Fast_Program_Buf);
-            CodeLen = 0;
-          }
+        if (IAP_Rx_Flush() == ERR_Busy) {
+            s = ERR_Busy;
+            break;
+        }
+        if (Lenth == 0) {
+            s = IAP_Image_Check(&info);
+            break;
         }
         s = ERR_SUCCESS;
         for (i = 0; i < Lenth; i++) {
-            if (isp_cmd_t->UART.data[i] != *(u8*) (Verify_addr + i)) {
+            if (isp_cmd_t->UART.data[i] != *(u8*)(uintptr_t)(Verify_addr + i)) {
                 s = ERR_ERROR;
                 break;
             }
@@ -208,15 +629,7 @@ u8 UART_RecData_Deal(void)
         break;
 
     case CMD_IAP_END:
-        Verify_Star_flag = 0;
-        End_Flag = 1;
-        Program_addr = FLASH_Base;
-        Verify_addr = FLASH_Base;
-        FLASH_ErasePage_Fast(CalAddr & 0xFFFFFF00);
-        FLASH->CTLR |= ((uint32_t)0x00008000);
-        FLASH->CTLR |= ((uint32_t)0x00000080);
-
-        s = ERR_End;
+        s = IAP_End();
         break;
 
     case CMD_JUMP_IAP:
@@ -296,6 +709,7 @@ void USART2_CFG(u32 baudrate)
 {
     GPIO_InitTypeDef GPIO_InitStructure = {0};
     USART_InitTypeDef USART_InitStructure = {0};
+    DMA_InitTypeDef DMA_InitStructure = {0};
 
     RCC_APB2PeriphClockCmd( RCC_APB2Periph_GPIOA, ENABLE);
     RCC_APB1PeriphClockCmd(RCC_APB1Periph_USART2,ENABLE);
@@ -317,6 +731,27 @@ void USART2_CFG(u32 baudrate)
     USART_InitStructure.USART_Mode = USART_Mode_Tx | USART_Mode_Rx;
 
     USART_Init(USART2, &USART_InitStructure);
+
+    /* Receive into a ring by DMA, so bytes are not lost while the CPU
+     * waits for a flash erase or program */
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+    DMA_DeInit(DMA1_Channel6);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)(uintptr_t)(&USART2->DATAR);
+    DMA_InitStructure.DMA_MemoryBaseAddr = (u32)(uintptr_t)Uart_Rx_Ring;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = UART_RX_RING_LEN;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA1_Channel6, &DMA_InitStructure);
+    Uart_Rx_Tail = 0;
+    DMA_Cmd(DMA1_Channel6, ENABLE);
+    USART_DMACmd(USART2, USART_DMAReq_Rx, ENABLE);
+
     USART_Cmd(USART2, ENABLE);
 }
 /*********************************************************************
@@ -355,17 +790,37 @@ void UART2_SendData(u8 data)
     USART_SendData(USART2, data);
 }
 
+/*********************************************************************
+ * @fn      Uart2_Rx_Ready
+ *
+ * @brief   Check the USART2 receive ring
+ *
+ * @return  1 - a byte is waiting
+ *          0 - empty
+ */
+u8 Uart2_Rx_Ready(void)
+{
+    return (UART_RX_RING_LEN - DMA_GetCurrDataCounter(DMA1_Channel6)) != Uart_Rx_Tail;
+}
+
 /*********************************************************************
  * @fn      Uart2_Rx
  *
- * @brief   Uart2 receive date
+ * @brief   Uart2 receive date, programming received pages meanwhile
  *
  * @return  none
  */
 u8 Uart2_Rx(void)
 {
-    while( USART_GetFlagStatus(USART2, USART_FLAG_RXNE) == RESET);
-    return USART_ReceiveData( USART2);
+    u8 d;
+
+    while (Uart2_Rx_Ready() == 0) {
+        IAP_Process();
+    }
+    d = Uart_Rx_Ring[Uart_Rx_Tail];
+    Uart_Rx_Tail = (Uart_Rx_Tail + 1) & (UART_RX_RING_LEN - 1);
+
+    return d;
 }
 
 /*********************************************************************
@@ -415,7 +870,9 @@ void UART_Rx_Deal(void)
                     {
                         if (Uart2_Rx() == Uart_Sync_Head1)
                         {
-                            s = UART_RecData_Deal();
+                            while ((s = UART_RecData_Deal()) == ERR_Busy) {
+                                IAP_Process();
+                            }
 
                             if (s != ERR_End)
                             {
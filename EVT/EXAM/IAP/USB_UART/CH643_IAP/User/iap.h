@@ -14,7 +14,9 @@
 
 #include "ch643.h"
 #include "stdio.h"
-#include "ch643_usbfs_device.h"
+#include "debug.h"
+#include "string.h"
+#include "iap_image.h"
 
 #define USBD_DATA_SIZE    64
 #define FLASH_Base        0x08005000
@@ -31,10 +33,21 @@
 #define ERR_SUCCESS       0x00
 #define ERR_ERROR         0x01
 #define ERR_End           0x02
+#define ERR_Busy          0x03     /* command kept, answered once the pages ahead of it are programmed */
 
 #define CalAddr           (0x0800F800-4)
 #define CheckNum          (0x5aa55aa5)
 
+/* Received code waits in a ring of pages and is programmed from the main
+ * loop, so a packet is answered as soon as it is buffered */
+#define IAP_PAGE_SIZE     256
+#define IAP_BUF_PAGES     2
+#define IAP_APP_END       (CalAddr & 0xFFFFFF00)   /* the flag page, holding the image record (see iap_image.h) */
+#define IAP_DELTA_SPARE   (IAP_APP_END - IAP_PAGE_SIZE)   /* delta images end below, the pages after them are spare (see iap_delta.h) */
+
+/* USART2 receive ring filled by DMA, keeps taking bytes while flash is busy */
+#define UART_RX_RING_LEN  512
+
 typedef union __attribute__ ((aligned(4)))_ISP_CMD {
 
 struct{
@@ -74,7 +87,16 @@ extern u16 EP2_Tx_Cnt;
 extern u8 EP2_Rx_Buffer[USBD_DATA_SIZE+4];
 extern u8 End_Flag;
 
+extern volatile u8 IAP_Pend;
+
+void CH32_IAP_Program(u32 adr, u32* buf);
 u8 RecData_Deal(void);
+void IAP_Process(void);
+void DevEP2_OUT_Resume(void);
+void IAP_Info_Write(const IAP_IMAGE_INFO *pinfo, u32 check);
+void IAP_Flag_Mark(void);
+u8 IAP_Boot_Check(void);
+u8 Uart2_Rx_Ready(void);
 void GPIO_Cfg_init(void);
 void GPIO_Cfg_Float(void);
 u8 PA0_Check(void);
@@ -0,0 +1,306 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_delta.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Applier of delta IAP images. The caller programs
+ *                      each page it builds; nothing else is written.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#include "iap_delta.h"
+#include "iap_lz.h"
+#include <string.h>
+
+static const uint8_t IAP_Delta_Magic[ 4 ] = { 'W', 'C', 'H', 'D' };
+
+#define DELTA_DONE(pd, p)   ((pd)->Done[(p) >> 3] & (1 << ((p) & 7)))
+
+/*********************************************************************
+ * @fn      IAP_Delta_Check
+ *
+ * @brief   Check whether received data starts a delta image.
+ *
+ * @param   pbuf - first bytes of the image
+ *          len - length
+ *
+ * @return  1 - delta, 0 - not
+ */
+uint8_t IAP_Delta_Check(const uint8_t *pbuf, uint32_t len)
+{
+    return (len >= sizeof(IAP_Delta_Magic)) && (memcmp(pbuf, IAP_Delta_Magic, sizeof(IAP_Delta_Magic)) == 0);
+}
+
+/*********************************************************************
+ * @fn      IAP_Delta_Init
+ *
+ * @brief   Start applying an image, header included.
+ *
+ * @param   parea - code area holding the old image
+ *          area_len - bytes the images may use, a multiple of
+ *                     IAP_DELTA_PAGE; the page after them is kept free
+ *          ppage - IAP_DELTA_PAGE bytes of RAM to build pages in
+ *
+ * @return  none
+ */
+void IAP_Delta_Init(IAP_DELTA *pd, const uint8_t *parea, uint32_t area_len, uint8_t *ppage)
+{
+    memset(pd, 0, sizeof(IAP_DELTA));
+    pd->pArea = parea;
+    pd->Area_Len = area_len;
+    pd->pPage = ppage;
+    pd->First = IAP_DELTA_NONE;
+    pd->State = IAP_DELTA_ST_HEAD;
+}
+
+/*********************************************************************
+ * @fn      Delta_Head
+ *
+ * @brief   Take the header: both images must fit in the area.
+ *
+ * @return  none
+ */
+static void Delta_Head(IAP_DELTA *pd)
+{
+    pd->Old_Pages = (pd->Old_Len + IAP_DELTA_PAGE - 1) / IAP_DELTA_PAGE;
+    pd->New_Pages = (pd->New_Len + IAP_DELTA_PAGE - 1) / IAP_DELTA_PAGE;
+    pd->Pages = (pd->Old_Pages > pd->New_Pages) ? pd->Old_Pages : pd->New_Pages;
+    if ((pd->Old_Len > pd->Area_Len) || (pd->New_Len > pd->Area_Len) || (pd->Pages > IAP_DELTA_MAX_PAGES)) {
+        pd->State = IAP_DELTA_ST_ERR;
+        return;
+    }
+    pd->Cnt = 0;
+    pd->State = pd->Pages ? IAP_DELTA_ST_TABLE : IAP_DELTA_ST_DONE;
+}
+
+/*********************************************************************
+ * @fn      Delta_Spare
+ *
+ * @brief   Spare page of a page: one of the pages past both images.
+ *
+ * @return  spare page in flash
+ */
+static const uint8_t *Delta_Spare(IAP_DELTA *pd, uint16_t page)
+{
+    uint16_t free = pd->Area_Len / IAP_DELTA_PAGE + 1 - pd->Pages;
+
+    return pd->pArea + (uint32_t)(pd->Pages + page % free) * IAP_DELTA_PAGE;
+}
+
+/*********************************************************************
+ * @fn      Delta_Entry
+ *
+ * @brief   Check a page against its table entry. Pages holding their new
+ *          content come first, then at most one page cut while it was
+ *          rewritten, then pages holding their old content.
+ *
+ * @return  none
+ */
+static void Delta_Entry(IAP_DELTA *pd)
+{
+    uint16_t p = pd->Page;
+    uint32_t crc = IAP_LZ_Crc32(0, pd->pArea + (uint32_t)p * IAP_DELTA_PAGE, IAP_DELTA_PAGE);
+    uint8_t is_old = (p >= pd->Old_Pages) || (crc == pd->Entry[0]);
+    uint8_t is_new = (crc == pd->Entry[1]);
+
+    if (p < pd->New_Pages) {
+        pd->Page_Crc[p] = pd->Entry[1];
+    }
+    if ((pd->First != IAP_DELTA_NONE) && !is_old) {
+        pd->State = IAP_DELTA_ST_ERR;
+        return;
+    }
+    if (is_new) {
+        pd->Done[p >> 3] |= 1 << (p & 7);
+    } else if (pd->First == IAP_DELTA_NONE) {
+        pd->First = p;
+        if (!is_old) {
+            if (p >= pd->New_Pages) {
+                pd->State = IAP_DELTA_ST_ERR;
+                return;
+            }
+            pd->pSpare = Delta_Spare(pd, p);
+            pd->Flags = (IAP_LZ_Crc32(0, pd->pSpare, IAP_DELTA_PAGE) == pd->Entry[1]) ? IAP_DELTA_F_RESTORE : IAP_DELTA_F_CUT;
+        }
+    }
+
+    pd->Entry[0] = 0;
+    pd->Entry[1] = 0;
+    pd->Cnt = 0;
+    if (++pd->Page == pd->Pages) {
+        pd->Page = 0;
+        pd->Pos = 0;
+        pd->State = pd->New_Pages ? IAP_DELTA_ST_OP : IAP_DELTA_ST_DONE;
+    }
+}
+
+/*********************************************************************
+ * @fn      Delta_Build
+ *
+ * @brief   Whether the page being parsed is built, or only skipped.
+ *
+ * @return  1 - built
+ */
+static uint8_t Delta_Build(IAP_DELTA *pd)
+{
+    return !DELTA_DONE(pd, pd->Page) && !((pd->Page == pd->First) && (pd->Flags & IAP_DELTA_F_RESTORE));
+}
+
+/*********************************************************************
+ * @fn      Delta_Copy
+ *
+ * @brief   Copy Cnt bytes from Src into the page.
+ *
+ * @return  none
+ */
+static void Delta_Copy(IAP_DELTA *pd)
+{
+    uint32_t start = (uint32_t)pd->Page * IAP_DELTA_PAGE;
+    uint32_t end = (uint32_t)pd->Src + pd->Cnt;
+    uint32_t lim = ((pd->Page > pd->Old_Pages) ? pd->Page : pd->Old_Pages) * (uint32_t)IAP_DELTA_PAGE;
+
+    if (end > lim) {
+        pd->State = IAP_DELTA_ST_ERR;
+        return;
+    }
+    if (Delta_Build(pd)) {
+        if ((pd->Src < start + IAP_DELTA_PAGE) && (end > start)) {
+            if ((pd->Page == pd->First) && (pd->Flags & IAP_DELTA_F_CUT)) {
+                pd->State = IAP_DELTA_ST_ERR;
+                return;
+            }
+            pd->Flags |= IAP_DELTA_F_BACKUP;
+        }
+        memcpy(pd->pPage + pd->Pos, pd->pArea + pd->Src, pd->Cnt);
+    }
+    pd->Pos += pd->Cnt;
+    pd->Cnt = 0;
+    pd->State = IAP_DELTA_ST_OP;
+}
+
+/*********************************************************************
+ * @fn      Delta_Page_End
+ *
+ * @brief   A page is parsed: skip it, or have it programmed if its
+ *          CRC32 matches.
+ *
+ * @return  none
+ */
+static void Delta_Page_End(IAP_DELTA *pd)
+{
+    if (DELTA_DONE(pd, pd->Page)) {
+        IAP_Delta_Next(pd);
+        return;
+    }
+    pd->pSpare = Delta_Spare(pd, pd->Page);
+    if ((pd->Page == pd->First) && (pd->Flags & IAP_DELTA_F_RESTORE)) {
+        memcpy(pd->pPage, pd->pSpare, IAP_DELTA_PAGE);
+    }
+    if (IAP_LZ_Crc32(0, pd->pPage, IAP_DELTA_PAGE) != pd->Page_Crc[pd->Page]) {
+        pd->State = IAP_DELTA_ST_ERR;
+        return;
+    }
+    pd->State = IAP_DELTA_ST_READY;
+}
+
+/*********************************************************************
+ * @fn      IAP_Delta_Apply
+ *
+ * @brief   Parse the image until the input is used up, a page is ready
+ *          to be programmed or the image is complete. Once the page is
+ *          programmed, IAP_Delta_Next lets parsing go on.
+ *
+ * @param   pbuf - delta image data
+ *          len - length
+ *
+ * @return  bytes of input used
+ */
+uint32_t IAP_Delta_Apply(IAP_DELTA *pd, const uint8_t *pbuf, uint32_t len)
+{
+    uint32_t n = 0;
+    uint8_t c;
+
+    while (pd->State < IAP_DELTA_ST_READY) {
+        if ((pd->State == IAP_DELTA_ST_OP) && (pd->Pos == IAP_DELTA_PAGE)) {
+            Delta_Page_End(pd);
+            continue;
+        }
+        if (n == len) {
+            break;
+        }
+        c = pbuf[n++];
+
+        switch (pd->State) {
+        case IAP_DELTA_ST_HEAD:
+            if (pd->Cnt < 4) {
+                if (c != IAP_Delta_Magic[pd->Cnt]) {
+                    pd->State = IAP_DELTA_ST_ERR;
+                }
+            } else if (pd->Cnt < 8) {
+                pd->Old_Len |= (uint32_t)c << (8 * (pd->Cnt - 4));
+            } else if (pd->Cnt < 12) {
+                pd->New_Len |= (uint32_t)c << (8 * (pd->Cnt - 8));
+            } else {
+                pd->Crc |= (uint32_t)c << (8 * (pd->Cnt - 12));
+            }
+            if (++pd->Cnt == IAP_DELTA_HEAD_LEN) {
+                Delta_Head(pd);
+            }
+            break;
+
+        case IAP_DELTA_ST_TABLE:
+            pd->Entry[pd->Cnt >> 2] |= (uint32_t)c << (8 * (pd->Cnt & 3));
+            if (++pd->Cnt == IAP_DELTA_ENTRY_LEN) {
+                Delta_Entry(pd);
+            }
+            break;
+
+        case IAP_DELTA_ST_OP:
+            pd->Cnt = (c & 0x7F) + 1;
+            if (pd->Pos + pd->Cnt > IAP_DELTA_PAGE) {
+                pd->State = IAP_DELTA_ST_ERR;
+                break;
+            }
+            pd->State = (c & 0x80) ? IAP_DELTA_ST_SRC_LO : IAP_DELTA_ST_LIT;
+            break;
+
+        case IAP_DELTA_ST_LIT:
+            if (Delta_Build(pd)) {
+                pd->pPage[pd->Pos] = c;
+            }
+            pd->Pos++;
+            if (--pd->Cnt == 0) {
+                pd->State = IAP_DELTA_ST_OP;
+            }
+            break;
+
+        case IAP_DELTA_ST_SRC_LO:
+            pd->Src = c;
+            pd->State = IAP_DELTA_ST_SRC_HI;
+            break;
+
+        case IAP_DELTA_ST_SRC_HI:
+            pd->Src |= (uint16_t)c << 8;
+            Delta_Copy(pd);
+            break;
+        }
+    }
+
+    return n;
+}
+
+/*********************************************************************
+ * @fn      IAP_Delta_Next
+ *
+ * @brief   Go on with the next page, the one ready being programmed.
+ *
+ * @return  none
+ */
+void IAP_Delta_Next(IAP_DELTA *pd)
+{
+    pd->Flags &= ~IAP_DELTA_F_BACKUP;
+    pd->Pos = 0;
+    pd->State = (++pd->Page == pd->New_Pages) ? IAP_DELTA_ST_DONE : IAP_DELTA_ST_OP;
+}
@@ -0,0 +1,104 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_delta.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Applier of delta IAP images, rebuilding the new
+ *                      application page by page over the old one.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#ifndef __IAP_DELTA_H
+#define __IAP_DELTA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*
+ * Image format, all numbers little endian, pages of 256 bytes padded with
+ * 0xFF:
+ *   'W' 'C' 'H' 'D' - magic
+ *   old size (4 bytes), new size (4 bytes)
+ *   crc (4 bytes)   - CRC32 (IEEE 802.3) of the new image
+ *   a table, one entry per page of the longer image: CRC32 of the old
+ *   page, then of the new one (of the old one past the end of the new image)
+ *   then for every page of the new image, ops giving exactly 256 bytes:
+ *   0x00 - 0x7F n   - n+1 literal bytes follow
+ *   0x80 - 0xFF n   - copy (n & 0x7F)+1 bytes from the 2 byte offset that
+ *                     follows, in the code area as it is when the page is
+ *                     built: the new image below the page, the old image
+ *                     from the page on, the page itself included.
+ *
+ * The table is checked against flash before anything is written. A page
+ * already holding its new content is skipped, so an update cut by a power
+ * loss is finished by sending the same image again. A page is programmed
+ * only if its CRC32 matches, and a page reading itself is first saved in a
+ * spare page, which stands in for it if it is cut while rewritten. The
+ * spare page is taken in turn among the pages past both images, the page
+ * after the area included, to spread the wear.
+ */
+#define IAP_DELTA_HEAD_LEN     16
+#define IAP_DELTA_ENTRY_LEN    8
+#define IAP_DELTA_PAGE         256
+#define IAP_DELTA_MAX_RUN      128
+#ifndef IAP_DELTA_MAX_PAGES
+#define IAP_DELTA_MAX_PAGES    168                              // 42K of code
+#endif
+
+/* State */
+#define IAP_DELTA_ST_HEAD      0
+#define IAP_DELTA_ST_TABLE     1
+#define IAP_DELTA_ST_OP        2
+#define IAP_DELTA_ST_LIT       3
+#define IAP_DELTA_ST_SRC_LO    4
+#define IAP_DELTA_ST_SRC_HI    5
+#define IAP_DELTA_ST_READY     6                                // pPage holds page Page, to be programmed
+#define IAP_DELTA_ST_DONE      7
+#define IAP_DELTA_ST_ERR       8
+
+/* Flags */
+#define IAP_DELTA_F_RESTORE    0x01                             // Page First was cut, the spare page holds it
+#define IAP_DELTA_F_CUT        0x02                             // Page First was cut, it may not read itself
+#define IAP_DELTA_F_BACKUP     0x04                             // Page built reads itself: save it in the spare page first
+
+#define IAP_DELTA_NONE         0xFFFF
+
+typedef struct _IAP_DELTA
+{
+    const uint8_t *pArea;                                       // Code area in flash
+    const uint8_t *pSpare;                                      // Spare page of the page ready or cut
+    uint8_t  *pPage;                                            // Page being built
+    uint32_t Area_Len;                                          // Bytes of the code area the images may use
+    uint32_t Old_Len;
+    uint32_t New_Len;
+    uint32_t Crc;
+    uint32_t Entry[ 2 ];                                        // Table entry being read
+    uint16_t Pages;                                             // Table entries
+    uint16_t Old_Pages;
+    uint16_t New_Pages;
+    uint16_t Page;                                              // Table entry or page being built
+    uint16_t First;                                             // First page not holding its new content
+    uint16_t Pos;                                               // Bytes of the page built
+    uint16_t Src;
+    uint8_t  State;
+    uint8_t  Cnt;                                               // Header or entry bytes read, bytes left of an op
+    uint8_t  Flags;
+    uint8_t  Done[ ( IAP_DELTA_MAX_PAGES + 7 ) / 8 ];           // Page already holds its new content
+    uint32_t Page_Crc[ IAP_DELTA_MAX_PAGES ];                   // CRC32 of the new pages
+} IAP_DELTA;
+
+extern uint8_t  IAP_Delta_Check( const uint8_t *pbuf, uint32_t len );
+extern void     IAP_Delta_Init( IAP_DELTA *pd, const uint8_t *parea, uint32_t area_len, uint8_t *ppage );
+extern uint32_t IAP_Delta_Apply( IAP_DELTA *pd, const uint8_t *pbuf, uint32_t len );
+extern void     IAP_Delta_Next( IAP_DELTA *pd );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
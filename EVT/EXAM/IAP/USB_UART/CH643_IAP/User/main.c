@@ -16,11 +16,39 @@
  * Key  parameters: CalAddr - address in flash (same in APP), note that this address needs to be unused.
  *                  CheckNum - The value of 'CalAddr' that needs to be modified.
  * Tips :the routine need IAP software version 1.50.
+ * Received code is answered once buffered and programmed from the main loop
+ * (IAP_Process) while the next packets arrive, erasing ahead by 32K blocks
+ * or 1K pages where they fit inside the user code area.
+ * An image packed by WCHMcuIAP_Linux/wch_lzpack (see iap_lz.h) is decoded
+ * while it is received, with Prog_Buf as the decoding window; an empty
+ * CMD_IAP_VERIFY then checks it against the CRC32 in its header.
+ * A delta made by WCHMcuIAP_Linux/wch_delta (see iap_delta.h) rebuilds the
+ * new code page by page from the old one, writing only the pages that
+ * change. It is checked against flash before anything is written, and an
+ * update cut by a power loss is finished by sending the same delta again:
+ * CalAddr still holds CheckNum until CMD_IAP_END, so the IAP stays in charge.
+ * Each image is checked against a CRC32 taken page by page while it is
+ * programmed: the IAP_IMAGE header wch_iap puts before a plain image, or the
+ * header of a compressed or delta image, so an empty CMD_IAP_VERIFY replaces
+ * sending the image back. CMD_IAP_END then writes the image record (see
+ * iap_image.h) to the flag page, and the application is started only while
+ * the CRC32 of flash matches it. A new image gets IAP_BOOT_TRIES starts to
+ * confirm itself (IAP_Boot_Confirm in CH643_APP), after which the IAP keeps
+ * control and waits for another image.
+ * An application with no record, written by WCH-Link or MounRiver or by an
+ * older IAP (which erased the flag page at CMD_IAP_END), is still started as
+ * long as the flag page is blank and the user code area is not: devices that
+ * get this IAP keep running their code. Such an image has no CRC32 check and
+ * no trial; the next update through this IAP gives it a record.
+ * The USB port also offers a DFU 1.1 interface (interface 1), e.g.
+ *   dfu-util -d 1a86:55e0 -a 0 -D app.bin -R
+ * downloads app.bin to the user code area and starts it, -U reads it back.
  */
 
-#include "ch643_usbfs_device.h"
 #include "debug.h"
 #include "iap.h"
+#include "usbd_iap.h"
+#include "dfu.h"
 
 extern u8 End_Flag;
 #define UPGRADE_MODE_COMMAND   0
@@ -64,16 +92,16 @@ int main(void)
     printf("ChipID:%08x\r\n", DBGMCU_GetCHIPID() );
     printf("IAP\r\n");
 #if UPGRADE_MODE == UPGRADE_MODE_COMMAND
-    if(*(uint32_t*)FLASH_Base  != 0xFFFFFFFF )
+    if(*(uint32_t*)CalAddr != CheckNum)
     {
-        if(*(uint32_t*)CalAddr != CheckNum)
+        if(IAP_Boot_Check())
         {
             IAP_2_APP();
             while(1);
         }
     }
 #elif UPGRADE_MODE == UPGRADE_MODE_IO
-    if(PA0_Check() == 0)
+    if((PA0_Check() == 0) && IAP_Boot_Check())
     {
         IAP_2_APP();
         while(1);
@@ -81,15 +109,20 @@ int main(void)
 #endif
 
     /* Usb Init */
+    DFU_Init( );
+    USBFS_Class_Register( &IAP_Class_Drv );
+    USBFS_Class_Register( &DFU_Class_Drv );
     USBFS_RCC_Init( );
     USBFS_Device_Init( ENABLE ,PWR_VDD_SupplyVoltage());
 
     USART2_CFG(460800);
     while(1)
     {
-        if( USART_GetFlagStatus(USART2, USART_FLAG_RXNE) != RESET) {
+        if (Uart2_Rx_Ready()) {
             UART_Rx_Deal();
         }
+        IAP_Process( );
+        DFU_Process( );
 #if UPGRADE_MODE == UPGRADE_MODE_COMMAND
         if (End_Flag)
         {
@@ -0,0 +1,114 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : usbd_iap.c
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: Vendor IAP class driver (interface 0) on the shared USBFS
+ *              device core. Each command received on endpoint 2 OUT is
+ *              answered on endpoint 2 IN.
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "usbd_iap.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+/* Answer to a command, read by the core until endpoint 2 IN is done */
+__attribute__ ((aligned(4))) u8 EP2_Tx_Buffer[2];
+
+/*********************************************************************
+ * @fn      IAP_Init
+ *
+ * @brief   Open endpoint 2 OUT/IN, called on device init and bus reset.
+ *
+ * @return  none
+ */
+static void IAP_Init( void )
+{
+    USBFS_Endp_Open( DEF_UEP2, USBFSD_UEP_RX_EN | USBFSD_UEP_TX_EN, DEF_USBD_ENDP2_SIZE );
+}
+
+/*********************************************************************
+ * @fn      DevEP2_Reply
+ *
+ * @brief   Answer an Endpoint 2 command.
+ *
+ * @param   s - RecData_Deal result.
+ *
+ * @return  none
+ */
+static void DevEP2_Reply( uint8_t s )
+{
+    if (s == ERR_Busy) {
+        /* No room yet, IAP_Process answers once it has programmed a page;
+         * endpoint 2 OUT NAKs until then */
+        IAP_Pend = 1;
+        return;
+    }
+    if (s == ERR_End) {
+        USBFS_Endp_RxDone( DEF_UEP2 );
+    } else {
+        /* The next command is NAKed until the host has read this answer,
+         * so a host keeping several commands queued loses none of them */
+        EP2_Tx_Buffer[0] = 0x00;
+        EP2_Tx_Buffer[1] = (s == ERR_ERROR) ? 0x01 : 0x00;
+        USBFS_Endp_Transmit( DEF_UEP2, EP2_Tx_Buffer, 2, 0 );
+    }
+}
+
+/*********************************************************************
+ * @fn      IAP_Out
+ *
+ * @brief   Deal device Endpoint 2 OUT.
+ *
+ * @return  none
+ */
+static void IAP_Out( uint8_t endp, uint8_t *pbuf, uint16_t len )
+{
+    memcpy(EP2_Rx_Buffer, pbuf, len);
+    DevEP2_Reply(RecData_Deal());
+}
+
+/*********************************************************************
+ * @fn      IAP_In
+ *
+ * @brief   Answer read by the host, take the next command.
+ *
+ * @return  none
+ */
+static void IAP_In( uint8_t endp )
+{
+    USBFS_Endp_RxDone( DEF_UEP2 );
+}
+
+/*********************************************************************
+ * @fn      DevEP2_OUT_Resume
+ *
+ * @brief   Deal the command that found the page ring full, called
+ *          from the main loop; Endpoint 2 OUT is NAKed meanwhile.
+ *
+ * @return  none
+ */
+void DevEP2_OUT_Resume( void )
+{
+    NVIC_DisableIRQ( USBFS_IRQn );
+    DevEP2_Reply(RecData_Deal());
+    NVIC_EnableIRQ( USBFS_IRQn );
+}
+
+/* Class driver */
+const USBFS_CLASS_DRV IAP_Class_Drv =
+{
+    0, 1,
+    ( 1 << DEF_UEP2 ),
+    IAP_Init,
+    NULL,
+    NULL,
+    IAP_Out,
+    IAP_In,
+    NULL,
+    NULL,
+};
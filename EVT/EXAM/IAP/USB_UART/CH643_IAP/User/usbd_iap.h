@@ -0,0 +1,23 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : usbd_iap.h
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: header file of usbd_iap.c
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef USER_USBD_IAP_H_
+#define USER_USBD_IAP_H_
+
+#include <ch643_usbfs_device.h>
+#include "iap.h"
+
+/******************************************************************************/
+/* external variables */
+extern const USBFS_CLASS_DRV IAP_Class_Drv;
+
+#endif /* USER_USBD_IAP_H_ */
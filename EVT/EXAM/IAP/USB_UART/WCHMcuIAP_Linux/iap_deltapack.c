@@ -0,0 +1,342 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_deltapack.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Encoder of delta IAP images, and a simulated
+ *                      bootloader driving its own iap_delta.c on flash kept
+ *                      in memory, power losses included.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "iap_lz.h"
+#include "iap_delta.h"
+#include "iap_deltapack.h"
+
+#define PACK_MIN_COPY       4
+#define PACK_HASH_BITS      16
+#define PACK_CHAIN_DEPTH    256
+
+typedef struct _PACK_CTX
+{
+    uint8_t  *pOld;                                             // Both images padded to whole pages
+    uint8_t  *pNew;
+    uint32_t Old_End;
+    uint32_t New_End;
+    uint32_t Start;                                             // Page being encoded
+    uint32_t Rep;                                               // End of the last copy
+    int32_t  *pHead_Old, *pPrev_Old;
+    int32_t  *pHead_New, *pPrev_New;
+} PACK_CTX;
+
+/*********************************************************************
+ * @fn      Pack_Hash
+ *
+ * @brief   Hash of the 4 bytes at p.
+ *
+ * @return  hash
+ */
+static uint32_t Pack_Hash( const uint8_t *p )
+{
+    uint32_t v = (uint32_t)p[ 0 ] << 24 | p[ 1 ] << 16 | p[ 2 ] << 8 | p[ 3 ];
+
+    return ( v * 2654435761u ) >> ( 32 - PACK_HASH_BITS );
+}
+
+/*********************************************************************
+ * @fn      Pack_Len
+ *
+ * @brief   Length of the match of the new image at t with the code area
+ *          at s, as the bootloader sees it while building the page.
+ *
+ * @return  length
+ */
+static uint32_t Pack_Len( const PACK_CTX *pc, uint32_t s, uint32_t t, uint32_t max )
+{
+    uint32_t lim = ( pc->Start > pc->Old_End ) ? pc->Start : pc->Old_End;
+    uint32_t l;
+
+    for( l = 0; ( l < max ) && ( s + l < lim ); l++ )
+    {
+        if( ( ( s + l < pc->Start ) ? pc->pNew[ s + l ] : pc->pOld[ s + l ] ) != pc->pNew[ t + l ] )
+        {
+            break;
+        }
+    }
+    return l;
+}
+
+/*********************************************************************
+ * @fn      Pack_Match
+ *
+ * @brief   Longest copy for position t: tried from where the last copy
+ *          ended, from the same offset, then from the hash chains of the
+ *          old image from the page on and of the new image below it.
+ *
+ * @return  length, 0 if shorter than PACK_MIN_COPY
+ */
+static uint32_t Pack_Match( const PACK_CTX *pc, uint32_t t, uint32_t max, uint32_t *psrc )
+{
+    uint32_t best = 0, l, h, depth;
+    int32_t s;
+
+    if( max < PACK_MIN_COPY )
+    {
+        return 0;
+    }
+    l = Pack_Len( pc, pc->Rep, t, max );
+    if( l > best )
+    {
+        best = l;
+        *psrc = pc->Rep;
+    }
+    l = Pack_Len( pc, t, t, max );
+    if( l > best )
+    {
+        best = l;
+        *psrc = t;
+    }
+    h = Pack_Hash( pc->pNew + t );
+    for( s = pc->pHead_Old[ h ], depth = 0; ( s >= (int32_t)pc->Start ) && ( depth < PACK_CHAIN_DEPTH ) && ( best < max ); s = pc->pPrev_Old[ s ], depth++ )
+    {
+        l = Pack_Len( pc, s, t, max );
+        if( l > best )
+        {
+            best = l;
+            *psrc = s;
+        }
+    }
+    for( s = pc->pHead_New[ h ], depth = 0; ( s >= 0 ) && ( depth < PACK_CHAIN_DEPTH ) && ( best < max ); s = pc->pPrev_New[ s ], depth++ )
+    {
+        l = Pack_Len( pc, s, t, max );
+        if( l > best )
+        {
+            best = l;
+            *psrc = s;
+        }
+    }
+    return ( best >= PACK_MIN_COPY ) ? best : 0;
+}
+
+/*********************************************************************
+ * @fn      Pack_Literals
+ *
+ * @brief   Write the literals gathered, in runs of up to 128.
+ *
+ * @return  bytes written
+ */
+static uint32_t Pack_Literals( const uint8_t *plit, uint32_t cnt, uint8_t *pout )
+{
+    uint32_t n = 0, run;
+
+    while( cnt )
+    {
+        run = ( cnt > IAP_DELTA_MAX_RUN ) ? IAP_DELTA_MAX_RUN : cnt;
+        pout[ n++ ] = (uint8_t)( run - 1 );
+        memcpy( pout + n, plit, run );
+        n += run;
+        plit += run;
+        cnt -= run;
+    }
+    return n;
+}
+
+/*********************************************************************
+ * @fn      IAP_Delta_Pack
+ *
+ * @brief   Encode the new image against the old one, taking a copy only
+ *          when the next byte does not start a longer one.
+ *
+ * @param   pout - at least IAP_DELTA_PACK_MAX( old_len, new_len ) bytes
+ *
+ * @return  delta length, 0 if an image does not fit in IAP_DELTA_MAX_PAGES
+ */
+uint32_t IAP_Delta_Pack( const uint8_t *pold, uint32_t old_len, const uint8_t *pnew, uint32_t new_len, uint8_t *pout )
+{
+    PACK_CTX pc;
+    uint32_t old_pages = ( old_len + IAP_DELTA_PAGE - 1 ) / IAP_DELTA_PAGE;
+    uint32_t new_pages = ( new_len + IAP_DELTA_PAGE - 1 ) / IAP_DELTA_PAGE;
+    uint32_t pages = ( old_pages > new_pages ) ? old_pages : new_pages;
+    uint32_t crc = IAP_LZ_Crc32( 0, pnew, new_len );
+    uint32_t n = IAP_DELTA_HEAD_LEN, p, i, t, l, l2, max, src = 0, src2, ins = 0, lits;
+    uint8_t lit[ IAP_DELTA_PAGE ];
+    uint32_t oc, nc;
+
+    if( pages > IAP_DELTA_MAX_PAGES )
+    {
+        return 0;
+    }
+    memset( &pc, 0, sizeof( pc ) );
+    pc.Old_End = old_pages * IAP_DELTA_PAGE;
+    pc.New_End = new_pages * IAP_DELTA_PAGE;
+    pc.pOld = malloc( pc.Old_End + 4 );
+    pc.pNew = malloc( pc.New_End + 4 );
+    pc.pHead_Old = malloc( sizeof( int32_t ) << PACK_HASH_BITS );
+    pc.pHead_New = malloc( sizeof( int32_t ) << PACK_HASH_BITS );
+    pc.pPrev_Old = malloc( sizeof( int32_t ) * ( pc.Old_End + 1 ) );
+    pc.pPrev_New = malloc( sizeof( int32_t ) * ( pc.New_End + 1 ) );
+    memset( pc.pOld, 0xFF, pc.Old_End + 4 );
+    memset( pc.pNew, 0xFF, pc.New_End + 4 );
+    memcpy( pc.pOld, pold, old_len );
+    memcpy( pc.pNew, pnew, new_len );
+    memset( pc.pHead_Old, 0xFF, sizeof( int32_t ) << PACK_HASH_BITS );
+    memset( pc.pHead_New, 0xFF, sizeof( int32_t ) << PACK_HASH_BITS );
+    for( i = 0; i + 4 <= pc.Old_End; i++ )
+    {
+        l = Pack_Hash( pc.pOld + i );
+        pc.pPrev_Old[ i ] = pc.pHead_Old[ l ];
+        pc.pHead_Old[ l ] = i;
+    }
+
+    memcpy( pout, "WCHD", 4 );
+    for( i = 0; i < 4; i++ )
+    {
+        pout[ 4 + i ] = (uint8_t)( old_len >> ( 8 * i ) );
+        pout[ 8 + i ] = (uint8_t)( new_len >> ( 8 * i ) );
+        pout[ 12 + i ] = (uint8_t)( crc >> ( 8 * i ) );
+    }
+    for( p = 0; p < pages; p++ )
+    {
+        oc = ( p < old_pages ) ? IAP_LZ_Crc32( 0, pc.pOld + p * IAP_DELTA_PAGE, IAP_DELTA_PAGE ) : 0;
+        nc = ( p < new_pages ) ? IAP_LZ_Crc32( 0, pc.pNew + p * IAP_DELTA_PAGE, IAP_DELTA_PAGE ) : oc;
+        for( i = 0; i < 4; i++ )
+        {
+            pout[ n + i ] = (uint8_t)( oc >> ( 8 * i ) );
+            pout[ n + 4 + i ] = (uint8_t)( nc >> ( 8 * i ) );
+        }
+        n += IAP_DELTA_ENTRY_LEN;
+    }
+
+    for( p = 0; p < new_pages; p++ )
+    {
+        pc.Start = p * IAP_DELTA_PAGE;
+        for( ; ins + 4 <= pc.Start; ins++ )
+        {
+            l = Pack_Hash( pc.pNew + ins );
+            pc.pPrev_New[ ins ] = pc.pHead_New[ l ];
+            pc.pHead_New[ l ] = ins;
+        }
+        lits = 0;
+        for( t = pc.Start; t < pc.Start + IAP_DELTA_PAGE; )
+        {
+            max = pc.Start + IAP_DELTA_PAGE - t;
+            max = ( max > IAP_DELTA_MAX_RUN ) ? IAP_DELTA_MAX_RUN : max;
+            l = Pack_Match( &pc, t, max, &src );
+            if( l && ( l < max ) )
+            {
+                l2 = pc.Start + IAP_DELTA_PAGE - t - 1;
+                l2 = Pack_Match( &pc, t + 1, ( l2 > IAP_DELTA_MAX_RUN ) ? IAP_DELTA_MAX_RUN : l2, &src2 );
+                if( l2 > l + 1 )
+                {
+                    l = 0;
+                }
+            }
+            if( l )
+            {
+                n += Pack_Literals( lit, lits, pout + n );
+                lits = 0;
+                pout[ n++ ] = (uint8_t)( 0x80 | ( l - 1 ) );
+                pout[ n++ ] = (uint8_t)src;
+                pout[ n++ ] = (uint8_t)( src >> 8 );
+                pc.Rep = src + l;
+                t += l;
+            }
+            else
+            {
+                lit[ lits++ ] = pc.pNew[ t++ ];
+            }
+        }
+        n += Pack_Literals( lit, lits, pout + n );
+    }
+
+    free( pc.pOld );
+    free( pc.pNew );
+    free( pc.pHead_Old );
+    free( pc.pHead_New );
+    free( pc.pPrev_Old );
+    free( pc.pPrev_New );
+    return n;
+}
+
+/*********************************************************************
+ * @fn      Sim_Write
+ *
+ * @brief   Erase and program a page, unless power is lost meanwhile: the
+ *          page is then left partly erased and partly programmed.
+ *
+ * @return  0 - written, 1 - power lost
+ */
+static int Sim_Write( uint8_t *pdst, const uint8_t *psrc, int *pcut, int *pwrites )
+{
+    int i;
+
+    if( ( *pcut > 0 ) && ( --*pcut == 0 ) )
+    {
+        for( i = 0; i < IAP_DELTA_PAGE; i++ )
+        {
+            pdst[ i ] = ( rand( ) & 1 ) ? 0xFF : ( psrc[ i ] & (uint8_t)rand( ) );
+        }
+        return 1;
+    }
+    memcpy( pdst, psrc, IAP_DELTA_PAGE );
+    ( *pwrites )++;
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      IAP_Delta_Sim
+ *
+ * @brief   Apply a delta image the way CH643_IAP does, feeding it in
+ *          uneven pieces.
+ *
+ * @param   pflash - code area, followed by a spare page
+ *          area_len - bytes of the code area
+ *          pcut - page writes before power is lost, 0 for none
+ *          pwrites - counts the page writes
+ *
+ * @return  0 - applied and checked, 1 - power lost, -1 - refused
+ */
+int IAP_Delta_Sim( uint8_t *pflash, uint32_t area_len, const uint8_t *pin, uint32_t len, int *pcut, int *pwrites )
+{
+    static IAP_DELTA d;
+    uint8_t page[ IAP_DELTA_PAGE ];
+    uint32_t pos = 0, step;
+
+    IAP_Delta_Init( &d, pflash, area_len, page );
+    while( ( d.State != IAP_DELTA_ST_DONE ) && ( d.State != IAP_DELTA_ST_ERR ) )
+    {
+        if( d.State == IAP_DELTA_ST_READY )
+        {
+            if( ( d.Flags & IAP_DELTA_F_BACKUP ) && Sim_Write( (uint8_t *)d.pSpare, page, pcut, pwrites ) )
+            {
+                return 1;
+            }
+            if( Sim_Write( pflash + d.Page * IAP_DELTA_PAGE, page, pcut, pwrites ) )
+            {
+                return 1;
+            }
+            IAP_Delta_Next( &d );
+            continue;
+        }
+        if( pos == len )
+        {
+            break;
+        }
+        step = 1 + rand( ) % 62;
+        if( step > len - pos )
+        {
+            step = len - pos;
+        }
+        pos += IAP_Delta_Apply( &d, pin + pos, step );
+    }
+    if( ( d.State != IAP_DELTA_ST_DONE ) || ( IAP_LZ_Crc32( 0, pflash, d.New_Len ) != d.Crc ) )
+    {
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_deltapack.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Encoder of delta IAP images, see
+ *                      CH643_IAP/User/iap_delta.h for the format.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef __IAP_DELTAPACK_H
+#define __IAP_DELTAPACK_H
+
+#include <stdint.h>
+
+/* Code area of CH643_IAP a delta image may use: up to its spare page */
+#define IAP_DELTA_AREA_LEN  ( 0x0800F600 - 0x08005000 )
+
+/* Worst case: header, table, and every page as literals */
+#define IAP_DELTA_PACK_MAX( old_len, new_len ) \
+    ( 16 + 8 * ( ( ( old_len ) > ( new_len ) ? ( old_len ) : ( new_len ) ) / 256 + 1 ) + ( ( new_len ) / 256 + 1 ) * 258 )
+
+extern uint32_t IAP_Delta_Pack( const uint8_t *pold, uint32_t old_len, const uint8_t *pnew, uint32_t new_len, uint8_t *pout );
+extern int IAP_Delta_Sim( uint8_t *pflash, uint32_t area_len, const uint8_t *pin, uint32_t len, int *pcut, int *pwrites );
+
+#endif
@@ -0,0 +1,65 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_link.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Transports of the Linux IAP tool.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef __IAP_LINK_H
+#define __IAP_LINK_H
+
+#include <stdint.h>
+
+/* Commands, as in CH643_IAP/User/iap.h */
+#define CMD_IAP_PROM        0x80
+#define CMD_IAP_ERASE       0x81
+#define CMD_IAP_VERIFY      0x82
+#define CMD_IAP_END         0x83
+#define CMD_JUMP_IAP        0x84
+
+/* USB device of the bootloader and of CH643_APP */
+#define IAP_USB_VID         0x1A86
+#define IAP_USB_PID         0x55E0
+#define IAP_USB_EP_OUT      0x02
+#define IAP_USB_EP_IN       0x82
+#define IAP_USB_PKT         64
+
+/* Bytes of code in one CMD_IAP_PROM and one CMD_IAP_VERIFY packet */
+#define IAP_PROM_LEN        60
+#define IAP_VERIFY_LEN      56
+
+/* UART_RX_RING_LEN of the bootloader: every unanswered frame waits there */
+#define IAP_UART_RING       512
+#define IAP_UART_BAUD       460800
+
+/* Replies */
+#define IAP_REPLY_OK        0
+#define IAP_REPLY_ERR       1
+#define IAP_REPLY_TIMEOUT   (-1)
+
+/* A command is sent as the USB packet [cmd][len][addr 4 bytes for ERASE and
+ * VERIFY][data]; the UART transport adds its own head, sum and tail. Replies
+ * come back in the order the commands were sent. */
+typedef struct _IAP_LINK
+{
+    const char *Name;
+    int  Window_Max;                                            // Commands the device can hold unanswered
+    int  ( *Send )( struct _IAP_LINK *plink, const uint8_t *pcmd, int len );
+    int  ( *Recv )( struct _IAP_LINK *plink, int timeout_ms );  // Reply to the oldest command
+    void ( *Close )( struct _IAP_LINK *plink );                 // Waits for commands still being sent
+    void *pCtx;
+} IAP_LINK;
+
+extern IAP_LINK *IAP_USB_Open( int wait_ms );
+extern IAP_LINK *IAP_UART_Open( const char *ptty, int baud );
+#ifdef IAP_SIM
+extern IAP_LINK *IAP_Sim_Open( int uart );
+extern int IAP_Sim_Test( void );
+#endif
+
+#endif
@@ -0,0 +1,180 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_lzpack.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Encoder of compressed IAP images, and a decoder
+ *                      driving the bootloader's own iap_lz.c the way the
+ *                      bootloader does.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "iap_lz.h"
+#include "iap_lzpack.h"
+
+/*********************************************************************
+ * @fn      Pack_Match
+ *
+ * @brief   Longest match for position i within the window, the nearest
+ *          one on a tie.
+ *
+ * @return  length, 0 if shorter than IAP_LZ_MIN_MATCH
+ */
+static uint32_t Pack_Match( const uint8_t *pin, uint32_t len, uint32_t i, uint32_t *pdist )
+{
+    uint32_t d, l, best = 0, max = len - i;
+
+    if( max > IAP_LZ_MAX_MATCH )
+    {
+        max = IAP_LZ_MAX_MATCH;
+    }
+    for( d = 1; ( d <= IAP_LZ_WINDOW ) && ( d <= i ); d++ )
+    {
+        if( pin[ i - d + best ] != pin[ i + best ] )
+        {
+            continue;
+        }
+        for( l = 0; ( l < max ) && ( pin[ i - d + l ] == pin[ i + l ] ); l++ )
+        {
+        }
+        if( l > best )
+        {
+            best = l;
+            *pdist = d;
+            if( best == max )
+            {
+                break;
+            }
+        }
+    }
+    return ( best >= IAP_LZ_MIN_MATCH ) ? best : 0;
+}
+
+/*********************************************************************
+ * @fn      IAP_LZ_Pack
+ *
+ * @brief   Compress an image, taking a match only when the next byte
+ *          does not start a longer one.
+ *
+ * @param   pout - at least IAP_LZ_PACK_MAX( len ) bytes
+ *
+ * @return  compressed length
+ */
+uint32_t IAP_LZ_Pack( const uint8_t *pin, uint32_t len, uint8_t *pout )
+{
+    uint32_t i = 0, n = IAP_LZ_HEAD_LEN, flag = 0, bit = 8;
+    uint32_t crc = IAP_LZ_Crc32( 0, pin, len );
+    uint32_t l, d = 0, d2;
+
+    memcpy( pout, "WCHZ", 4 );
+    for( l = 0; l < 4; l++ )
+    {
+        pout[ 4 + l ] = (uint8_t)( len >> ( 8 * l ) );
+        pout[ 8 + l ] = (uint8_t)( crc >> ( 8 * l ) );
+    }
+
+    while( i < len )
+    {
+        if( bit == 8 )
+        {
+            flag = n++;
+            pout[ flag ] = 0;
+            bit = 0;
+        }
+        l = Pack_Match( pin, len, i, &d );
+        if( l && ( l < IAP_LZ_MAX_MATCH ) && ( i + 1 < len ) && ( Pack_Match( pin, len, i + 1, &d2 ) > l + 1 ) )
+        {
+            l = 0;
+        }
+        if( l )
+        {
+            pout[ flag ] |= 1 << bit;
+            pout[ n++ ] = (uint8_t)( d - 1 );
+            pout[ n++ ] = (uint8_t)( ( ( l - IAP_LZ_MIN_MATCH ) << 1 ) | ( ( d - 1 ) >> 8 ) );
+            i += l;
+        }
+        else
+        {
+            pout[ n++ ] = pin[ i++ ];
+        }
+        bit++;
+    }
+    return n;
+}
+
+/*********************************************************************
+ * @fn      IAP_LZ_Unpack
+ *
+ * @brief   Decode with iap_lz.c through a ring of the bootloader's size,
+ *          feeding the input and freeing ring space in uneven pieces.
+ *
+ * @param   max - size of pout
+ *
+ * @return  decoded length, -1 if the data is damaged or too long
+ */
+int IAP_LZ_Unpack( const uint8_t *pin, uint32_t len, uint8_t *pout, uint32_t max )
+{
+    uint8_t ring[ IAP_LZ_WINDOW ];
+    IAP_LZ_DEC dec;
+    uint32_t pos = 0, done = 0, n, step;
+
+    IAP_LZ_Init( &dec, ring, sizeof( ring ) );
+    while( dec.State < IAP_LZ_ST_DONE )
+    {
+        step = 1 + rand( ) % 64;
+        if( step > len - pos )
+        {
+            step = len - pos;
+        }
+        n = IAP_LZ_Decode( &dec, pin + pos, step );
+        pos += n;
+
+        /* The bootloader programs whole pages out of the ring */
+        while( done < dec.Out )
+        {
+            step = 1 + rand( ) % 256;
+            if( step > dec.Out - done )
+            {
+                step = dec.Out - done;
+            }
+            if( done + step > max )
+            {
+                return -1;
+            }
+            for( n = 0; n < step; n++, done++ )
+            {
+                pout[ done ] = ring[ done & ( sizeof( ring ) - 1 ) ];
+            }
+            if( rand( ) & 1 )
+            {
+                break;
+            }
+        }
+        dec.Limit = done + sizeof( ring );
+        if( ( pos == len ) && ( dec.Len == 0 ) && ( dec.State < IAP_LZ_ST_DONE ) && ( done == dec.Out ) )
+        {
+            return -1;
+        }
+    }
+    if( dec.State == IAP_LZ_ST_DONE )
+    {
+        if( dec.Out > max )
+        {
+            return -1;
+        }
+        for( ; done < dec.Out; done++ )
+        {
+            pout[ done ] = ring[ done & ( sizeof( ring ) - 1 ) ];
+        }
+    }
+    if( ( dec.State != IAP_LZ_ST_DONE ) || ( IAP_LZ_Crc32( 0, pout, dec.Out ) != dec.Crc ) )
+    {
+        return -1;
+    }
+    return (int)dec.Out;
+}
@@ -0,0 +1,25 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_lzpack.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Encoder of compressed IAP images, see
+ *                      CH643_IAP/User/iap_lz.h for the format.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef __IAP_LZPACK_H
+#define __IAP_LZPACK_H
+
+#include <stdint.h>
+
+/* Worst case: every byte a literal, one flag byte per 8 */
+#define IAP_LZ_PACK_MAX( len )  ( 12 + ( len ) + ( ( len ) + 7 ) / 8 )
+
+extern uint32_t IAP_LZ_Pack( const uint8_t *pin, uint32_t len, uint8_t *pout );
+extern int IAP_LZ_Unpack( const uint8_t *pin, uint32_t len, uint8_t *pout, uint32_t max );
+
+#endif
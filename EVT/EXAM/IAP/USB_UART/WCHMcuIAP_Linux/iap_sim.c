@@ -0,0 +1,866 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_sim.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Simulated device of the Linux IAP tool: the command
+ *                      handler of CH643_IAP/User/iap.c built for the PC, on
+ *                      flash kept in memory. Only compiled with -DIAP_SIM.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifdef IAP_SIM
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* iap.c and the peripheral headers as they are, minus the RISC-V bits */
+#define interrupt( x )      unused
+#define __asm( x )
+#include "iap.h"
+#undef FLASH
+static FLASH_TypeDef Sim_Flash_Reg;
+#define FLASH               ( &Sim_Flash_Reg )
+#include "iap.c"
+#undef CMD_IAP_PROM
+#undef CMD_IAP_ERASE
+#undef CMD_IAP_VERIFY
+#undef CMD_IAP_END
+#undef CMD_JUMP_IAP
+#include "iap_link.h"
+
+#define SIM_FLASH_ADDR      0x08000000
+#define SIM_FLASH_SIZE      0x10000
+#define SIM_QUEUE_LEN       64
+
+typedef struct _SIM_CTX
+{
+    IAP_LINK Link;
+    int      Uart;
+    uint8_t  Queue[ SIM_QUEUE_LEN ][ USBD_DATA_SIZE ];      // USB packets NAKed by the device
+    int      Queue_Len[ SIM_QUEUE_LEN ];
+    int      Head, Cnt;
+    uint32_t Rx_Head;                                        // Bytes put in the UART ring
+    uint8_t  Tx[ 6 ];
+    int      Tx_Len;
+} SIM_CTX;
+
+static SIM_CTX *Sim;
+static uint8_t Sim_Page[ IAP_PAGE_SIZE ];
+static int Sim_Erase_32K, Sim_Erase_1K, Sim_Erase_Page, Sim_Prog, Sim_Fault;
+
+/*********************************************************************
+ * @fn      Sim_Erase
+ *
+ * @brief   Erase emulated flash, refusing anything outside the user code
+ *          area or the flag page.
+ *
+ * @return  none
+ */
+static void Sim_Erase( uint32_t adr, uint32_t len )
+{
+    if( ( adr != ( CalAddr & 0xFFFFFF00 ) ) && ( ( adr < FLASH_Base ) || ( adr + len > IAP_APP_END ) ) )
+    {
+        fprintf( stderr, "sim: erase %08x+%x outside the user code area\n", adr, len );
+        Sim_Fault++;
+        return;
+    }
+    memset( (void *)(uintptr_t)adr, 0xFF, len );
+}
+
+void FLASH_Unlock_Fast( void ) { }
+void FLASH_BufReset( void ) { }
+void FLASH_BufLoad( uint32_t adr, uint32_t data ) { memcpy( Sim_Page + ( adr & ( IAP_PAGE_SIZE - 1 ) ), &data, 4 ); }
+void FLASH_ErasePage_Fast( uint32_t adr ) { Sim_Erase( adr, IAP_PAGE_SIZE ); Sim_Erase_Page++; }
+FLASH_Status FLASH_ErasePage( uint32_t adr ) { Sim_Erase( adr, 1024 ); Sim_Erase_1K++; return FLASH_COMPLETE; }
+void FLASH_EraseBlock_32K_Fast( uint32_t adr ) { Sim_Erase( adr, 0x8000 ); Sim_Erase_32K++; }
+
+void FLASH_ProgramPage_Fast( uint32_t adr )
+{
+    uint8_t *p = (uint8_t *)(uintptr_t)adr;
+    int i;
+
+    for( i = 0; i < IAP_PAGE_SIZE; i++ )
+    {
+        if( p[ i ] != 0xFF )
+        {
+            Sim_Fault++;
+        }
+        p[ i ] &= Sim_Page[ i ];
+    }
+    Sim_Prog++;
+}
+
+/* The USB reply is given by Sim_Recv, which already retries busy commands */
+void DevEP2_OUT_Resume( void ) { }
+
+/* USART2 receive DMA: the ring is filled by Sim_Send */
+uint16_t DMA_GetCurrDataCounter( DMA_Channel_TypeDef *DMAy_Channelx )
+{
+    return UART_RX_RING_LEN - ( Sim->Rx_Head & ( UART_RX_RING_LEN - 1 ) );
+}
+
+FlagStatus USART_GetFlagStatus( USART_TypeDef *USARTx, uint16_t USART_FLAG ) { return SET; }
+
+void USART_SendData( USART_TypeDef *USARTx, uint16_t Data )
+{
+    if( Sim->Tx_Len < (int)sizeof( Sim->Tx ) )
+    {
+        Sim->Tx[ Sim->Tx_Len++ ] = (uint8_t)Data;
+    }
+}
+
+/* Pin and UART set-up of iap.c, never reached from the command handler */
+void RCC_AHBPeriphClockCmd( uint32_t RCC_AHBPeriph, FunctionalState NewState ) { }
+void RCC_APB1PeriphClockCmd( uint32_t RCC_APB1Periph, FunctionalState NewState ) { }
+void RCC_APB2PeriphClockCmd( uint32_t RCC_APB2Periph, FunctionalState NewState ) { }
+void GPIO_DeInit( GPIO_TypeDef *GPIOx ) { }
+void GPIO_AFIODeInit( void ) { }
+void GPIO_Init( GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct ) { }
+uint8_t GPIO_ReadInputDataBit( GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin ) { return 1; }
+void USART_Init( USART_TypeDef *USARTx, USART_InitTypeDef *USART_InitStruct ) { }
+void USART_Cmd( USART_TypeDef *USARTx, FunctionalState NewState ) { }
+void USART_DMACmd( USART_TypeDef *USARTx, uint16_t USART_DMAReq, FunctionalState NewState ) { }
+void DMA_DeInit( DMA_Channel_TypeDef *DMAy_Channelx ) { }
+void DMA_Init( DMA_Channel_TypeDef *DMAy_Channelx, DMA_InitTypeDef *DMA_InitStruct ) { }
+void DMA_Cmd( DMA_Channel_TypeDef *DMAy_Channelx, FunctionalState NewState ) { }
+void Delay_Ms( uint32_t n ) { }
+
+/*********************************************************************
+ * @fn      Sim_Rx_Pending
+ *
+ * @brief   Bytes in the UART ring not taken by UART_Rx_Deal yet.
+ *
+ * @return  count
+ */
+static uint32_t Sim_Rx_Pending( void )
+{
+    return ( Sim->Rx_Head - Uart_Rx_Tail ) & ( UART_RX_RING_LEN - 1 );
+}
+
+/*********************************************************************
+ * @fn      Sim_Send
+ *
+ * @brief   USB: queue the packet as the host controller would while the
+ *          device NAKs it. UART: put the frame into the receive ring,
+ *          failing if the bootloader would have lost bytes.
+ *
+ * @return  0 - sent, -1 - overrun
+ */
+static int Sim_Send( IAP_LINK *plink, const uint8_t *pcmd, int len )
+{
+    uint8_t frame[ USBD_DATA_SIZE + 8 ];
+    uint16_t sum = 0;
+    int i, n = 0;
+
+    if( Sim->Uart == 0 )
+    {
+        if( Sim->Cnt == SIM_QUEUE_LEN )
+        {
+            return -1;
+        }
+        i = ( Sim->Head + Sim->Cnt++ ) % SIM_QUEUE_LEN;
+        memcpy( Sim->Queue[ i ], pcmd, len );
+        Sim->Queue_Len[ i ] = len;
+        return 0;
+    }
+
+    frame[ n++ ] = Uart_Sync_Head1;
+    frame[ n++ ] = Uart_Sync_Head2;
+    for( i = 0; i < len; i++ )
+    {
+        frame[ n++ ] = pcmd[ i ];
+        sum += pcmd[ i ];
+    }
+    frame[ n++ ] = (uint8_t)sum;
+    frame[ n++ ] = (uint8_t)( sum >> 8 );
+    frame[ n++ ] = Uart_Sync_Head2;
+    frame[ n++ ] = Uart_Sync_Head1;
+    if( Sim_Rx_Pending( ) + n >= UART_RX_RING_LEN )
+    {
+        fprintf( stderr, "sim: UART receive ring overrun\n" );
+        return -1;
+    }
+    for( i = 0; i < n; i++ )
+    {
+        Uart_Rx_Ring[ Sim->Rx_Head++ & ( UART_RX_RING_LEN - 1 ) ] = frame[ i ];
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Recv
+ *
+ * @brief   Let the device handle the oldest command and return its reply,
+ *          with the main loop programming pages in between.
+ *
+ * @return  IAP_REPLY_OK, IAP_REPLY_ERR or IAP_REPLY_TIMEOUT
+ */
+static int Sim_Recv( IAP_LINK *plink, int timeout_ms )
+{
+    uint8_t s;
+
+    if( rand( ) & 1 )
+    {
+        IAP_Process( );
+    }
+
+    if( Sim->Uart )
+    {
+        Sim->Tx_Len = 0;
+        while( ( Sim->Tx_Len < 6 ) && Sim_Rx_Pending( ) )
+        {
+            UART_Rx_Deal( );
+        }
+        if( Sim->Tx_Len < 6 )
+        {
+            return IAP_REPLY_TIMEOUT;
+        }
+        return Sim->Tx[ 3 ] ? IAP_REPLY_ERR : IAP_REPLY_OK;
+    }
+
+    while( Sim->Cnt )
+    {
+        memcpy( EP2_Rx_Buffer, Sim->Queue[ Sim->Head ], Sim->Queue_Len[ Sim->Head ] );
+        Sim->Head = ( Sim->Head + 1 ) % SIM_QUEUE_LEN;
+        Sim->Cnt--;
+        while( ( s = RecData_Deal( ) ) == ERR_Busy )
+        {
+            IAP_Process( );
+        }
+        if( s != ERR_End )
+        {
+            return ( s == ERR_ERROR ) ? IAP_REPLY_ERR : IAP_REPLY_OK;
+        }
+    }
+    return IAP_REPLY_TIMEOUT;
+}
+
+/*********************************************************************
+ * @fn      Sim_Close
+ *
+ * @brief   Hand the device what is still queued (CMD_IAP_END), report
+ *          what it went through and what a reset would start, and keep
+ *          the flash in $IAP_SIM_FLASH if set.
+ *
+ * @return  none
+ */
+static void Sim_Close( IAP_LINK *plink )
+{
+    const char *pname = getenv( "IAP_SIM_FLASH" );
+    FILE *f;
+
+    Sim_Recv( plink, 0 );
+    printf( "sim: %s, end %s, %d pages programmed, erased 32K x%d 1K x%d 256B x%d, %d flash faults\n",
+            Sim->Uart ? "uart" : "usb", End_Flag ? "seen" : "missing",
+            Sim_Prog, Sim_Erase_32K, Sim_Erase_1K, Sim_Erase_Page, Sim_Fault );
+    /* What main() would do on the next reset, using up a try */
+    printf( "sim: a reset now %s\n",
+            ( ( *(uint32_t *)CalAddr != CheckNum ) && IAP_Boot_Check( ) ) ? "starts the application" : "stays in IAP" );
+    if( pname && ( ( f = fopen( pname, "wb" ) ) != NULL ) )
+    {
+        fwrite( (void *)SIM_FLASH_ADDR, 1, SIM_FLASH_SIZE, f );
+        fclose( f );
+    }
+    free( Sim );
+    Sim = NULL;
+}
+
+/*********************************************************************
+ * @fn      IAP_Sim_Open
+ *
+ * @brief   Start the simulated bootloader on the flash kept in
+ *          $IAP_SIM_FLASH, or else on blank-ish flash.
+ *
+ * @param   uart - 1 - frames go through UART_Rx_Deal, 0 - USB packets
+ *          through RecData_Deal
+ *
+ * @return  link, NULL on error
+ */
+IAP_LINK *IAP_Sim_Open( int uart )
+{
+    const char *pname = getenv( "IAP_SIM_FLASH" );
+    FILE *f;
+    void *p;
+
+    p = mmap( (void *)SIM_FLASH_ADDR, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0 );
+    if( p == MAP_FAILED )
+    {
+        perror( "sim: flash" );
+        return NULL;
+    }
+    /* Kernels before 4.17 take the flag as a hint and map elsewhere */
+    if( p != (void *)SIM_FLASH_ADDR )
+    {
+        fprintf( stderr, "sim: flash address %08x is taken\n", SIM_FLASH_ADDR );
+        munmap( p, SIM_FLASH_SIZE );
+        return NULL;
+    }
+    /* Old code the erase has to clear */
+    memset( p, 0x5A, SIM_FLASH_SIZE );
+    if( pname && ( ( f = fopen( pname, "rb" ) ) != NULL ) )
+    {
+        if( fread( p, 1, SIM_FLASH_SIZE, f ) != SIM_FLASH_SIZE )
+        {
+            fprintf( stderr, "sim: %s is short\n", pname );
+        }
+        fclose( f );
+    }
+
+    Sim = calloc( 1, sizeof( SIM_CTX ) );
+    Sim->Uart = uart;
+    Sim->Link.Name = uart ? "sim-uart" : "sim";
+    Sim->Link.Window_Max = uart ? IAP_UART_RING / ( IAP_PROM_LEN + 8 ) : SIM_QUEUE_LEN;
+    Sim->Link.Send = Sim_Send;
+    Sim->Link.Recv = Sim_Recv;
+    Sim->Link.Close = Sim_Close;
+    Sim->Link.pCtx = Sim;
+    return &Sim->Link;
+}
+
+/* Self-test: images sent to the command handler as the tool would, with
+ * the main loop getting its turns at random */
+static uint8_t Sim_Test_Img[ IAP_IMAGE_HEAD_LEN + 0xA800 ];
+
+/*********************************************************************
+ * @fn      Sim_Test_Reset
+ *
+ * @brief   Old code all over flash and CheckNum at CalAddr, as left by an
+ *          application asking for an update, counters cleared.
+ *
+ * @return  none
+ */
+static void Sim_Test_Reset( void )
+{
+    memset( (void *)SIM_FLASH_ADDR, 0x5A, SIM_FLASH_SIZE );
+    *(uint32_t *)CalAddr = CheckNum;
+    Sim_Erase_32K = Sim_Erase_1K = Sim_Erase_Page = Sim_Prog = Sim_Fault = 0;
+    End_Flag = 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Fill
+ *
+ * @brief   Random code, and the IAP_IMAGE header ahead of it if head is
+ *          set, the CRC32 spoilt if bad is set.
+ *
+ * @return  bytes to send
+ */
+static uint32_t Sim_Test_Fill( uint32_t len, int seed, int head, int bad )
+{
+    uint8_t *p = Sim_Test_Img + IAP_IMAGE_HEAD_LEN;
+    uint32_t crc, i;
+
+    srand( seed );
+    for( i = 0; i < len; i++ )
+    {
+        p[ i ] = rand( );
+    }
+    if( head == 0 )
+    {
+        memmove( Sim_Test_Img, p, len );
+        return len;
+    }
+    crc = IAP_LZ_Crc32( 0, p, len ) ^ ( bad ? 1 : 0 );
+    for( i = 0; i < 4; i++ )
+    {
+        Sim_Test_Img[ i ] = (uint8_t)( IAP_IMAGE_MAGIC >> ( 8 * i ) );
+        Sim_Test_Img[ 4 + i ] = (uint8_t)( len >> ( 8 * i ) );
+        Sim_Test_Img[ 8 + i ] = (uint8_t)( crc >> ( 8 * i ) );
+    }
+    return IAP_IMAGE_HEAD_LEN + len;
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Cmd
+ *
+ * @brief   Hand a USB packet to RecData_Deal, programming pages while it
+ *          is kept busy, as the USB interrupt and IAP_Process would.
+ *
+ * @return  reply of RecData_Deal
+ */
+static uint8_t Sim_Test_Cmd( uint8_t cmd, const uint8_t *pdata, uint32_t len )
+{
+    uint8_t s;
+
+    memset( EP2_Rx_Buffer, 0, 6 );
+    EP2_Rx_Buffer[ 0 ] = cmd;
+    EP2_Rx_Buffer[ 1 ] = len;
+    if( cmd == CMD_IAP_PROM )
+    {
+        memcpy( isp_cmd_t->program.data, pdata, len );
+    }
+    else if( cmd == CMD_IAP_VERIFY )
+    {
+        memcpy( isp_cmd_t->verify.data, pdata, len );
+    }
+    while( ( s = RecData_Deal( ) ) == ERR_Busy )
+    {
+        IAP_Process( );
+    }
+    /* The page ring never holds more than it has room for */
+    if( Rx_Cnt - Prog_Cnt > sizeof( Prog_Buf ) )
+    {
+        fprintf( stderr, "sim: %u bytes in the page ring\n", Rx_Cnt - Prog_Cnt );
+        Sim_Fault++;
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Send
+ *
+ * @brief   CMD_IAP_ERASE, then the first len bytes of Sim_Test_Img in
+ *          CMD_IAP_PROM packets.
+ *
+ * @return  offset of the first refused packet, len if none
+ */
+static uint32_t Sim_Test_Send( uint32_t len )
+{
+    uint32_t off, n;
+
+    Sim_Test_Cmd( CMD_IAP_ERASE, NULL, 0 );
+    for( off = 0; off < len; off += n )
+    {
+        n = ( len - off < IAP_PROM_LEN ) ? len - off : IAP_PROM_LEN;
+        if( Sim_Test_Cmd( CMD_IAP_PROM, Sim_Test_Img + off, n ) != ERR_SUCCESS )
+        {
+            return off;
+        }
+        if( rand( ) % 3 == 0 )
+        {
+            IAP_Process( );
+        }
+    }
+    return len;
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Sizes
+ *
+ * @brief   Plain images of 100 B to the whole user code area: verified
+ *          byte by byte, padded with 0xFF, erased ahead with the biggest
+ *          unit that fits and never programmed over old code.
+ *
+ * @return  number of failures
+ */
+static int Sim_Test_Sizes( void )
+{
+    static const uint32_t size[ ] = { 100, 255, 256, 257, 1000, 1024, 1025, 30000, 41984, 42000, 42751, 42752 };
+    uint32_t len, off, n, pages, k1, k256;
+    uint8_t *pflash = (uint8_t *)(uintptr_t)FLASH_Base;
+    int i, bad = 0;
+
+    for( i = 0; i < (int)( sizeof( size ) / sizeof( size[ 0 ] ) ); i++ )
+    {
+        len = size[ i ];
+        Sim_Test_Reset( );
+        Sim_Test_Fill( len, len, 0, 0 );
+        if( Sim_Test_Send( len ) != len )
+        {
+            printf( "  %u B: refused\n", len );
+            bad++;
+            continue;
+        }
+        for( off = 0; off < len; off += n )
+        {
+            n = ( len - off < IAP_VERIFY_LEN ) ? len - off : IAP_VERIFY_LEN;
+            if( Sim_Test_Cmd( CMD_IAP_VERIFY, Sim_Test_Img + off, n ) != ERR_SUCCESS )
+            {
+                printf( "  %u B: verify failed at %u\n", len, off );
+                bad++;
+                break;
+            }
+        }
+        /* 1K pages from FLASH_Base while they stay below the flag page,
+         * 256 byte pages for the rest; no 32K block starts in the area */
+        pages = ( len + IAP_PAGE_SIZE - 1 ) / IAP_PAGE_SIZE;
+        k1 = ( pages + 3 ) / 4;
+        if( k1 > ( IAP_APP_END - FLASH_Base ) / 1024 )
+        {
+            k1 = ( IAP_APP_END - FLASH_Base ) / 1024;
+        }
+        k256 = ( pages > 4 * k1 ) ? pages - 4 * k1 : 0;
+        if( ( Sim_Prog != (int)pages ) || ( Sim_Erase_32K != 0 ) || ( Sim_Erase_1K != (int)k1 ) || ( Sim_Erase_Page != (int)k256 ) )
+        {
+            printf( "  %u B: %d pages, erased 32K x%d 1K x%d 256B x%d, expected %u pages, 1K x%u 256B x%u\n",
+                    len, Sim_Prog, Sim_Erase_32K, Sim_Erase_1K, Sim_Erase_Page, pages, k1, k256 );
+            bad++;
+        }
+        if( len == IAP_APP_END - FLASH_Base )
+        {
+            printf( "  %u B: %d pages, erased 32K x%d 1K x%d 256B x%d\n",
+                    len, Sim_Prog, Sim_Erase_32K, Sim_Erase_1K, Sim_Erase_Page );
+        }
+        if( Sim_Test_Cmd( CMD_IAP_END, NULL, 0 ) != ERR_End )
+        {
+            printf( "  %u B: end refused\n", len );
+            bad++;
+        }
+        if( memcmp( pflash, Sim_Test_Img, len ) )
+        {
+            printf( "  %u B: flash differs\n", len );
+            bad++;
+        }
+        for( off = len; off < pages * IAP_PAGE_SIZE; off++ )
+        {
+            if( pflash[ off ] != 0xFF )
+            {
+                printf( "  %u B: padding %02x at %u\n", len, pflash[ off ], off );
+                bad++;
+                break;
+            }
+        }
+        if( ( *(uint32_t *)CalAddr != 0xFFFFFFFF ) || !IAP_Boot_Check( ) )
+        {
+            printf( "  %u B: a reset would not start it\n", len );
+            bad++;
+        }
+        bad += Sim_Fault;
+    }
+    return bad;
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Ring
+ *
+ * @brief   Eight packets fill the two page ring, the ninth is held busy
+ *          until the main loop programs a page, and VERIFY and END wait
+ *          for every page.
+ *
+ * @return  number of failures
+ */
+static int Sim_Test_Ring( void )
+{
+    int i, bad = 0;
+
+    Sim_Test_Reset( );
+    Sim_Test_Fill( 9 * IAP_PROM_LEN, 1, 0, 0 );
+    Sim_Test_Cmd( CMD_IAP_ERASE, NULL, 0 );
+    for( i = 0; i < 9; i++ )
+    {
+        EP2_Rx_Buffer[ 0 ] = CMD_IAP_PROM;
+        EP2_Rx_Buffer[ 1 ] = IAP_PROM_LEN;
+        memcpy( isp_cmd_t->program.data, Sim_Test_Img + i * IAP_PROM_LEN, IAP_PROM_LEN );
+        if( RecData_Deal( ) != ( ( i < 8 ) ? ERR_SUCCESS : ERR_Busy ) )
+        {
+            printf( "  packet %d: wrong reply\n", i );
+            bad++;
+        }
+    }
+    if( Sim_Prog != 0 )
+    {
+        bad++;
+    }
+    IAP_Process( );
+    if( ( Sim_Prog != 1 ) || ( RecData_Deal( ) != ERR_SUCCESS ) )
+    {
+        printf( "  ninth packet not taken after a page\n" );
+        bad++;
+    }
+    EP2_Rx_Buffer[ 0 ] = CMD_IAP_VERIFY;
+    EP2_Rx_Buffer[ 1 ] = 0;
+    if( RecData_Deal( ) != ERR_Busy )
+    {
+        printf( "  verify not held for the pages ahead\n" );
+        bad++;
+    }
+    EP2_Rx_Buffer[ 0 ] = CMD_IAP_END;
+    if( RecData_Deal( ) != ERR_Busy )
+    {
+        printf( "  end not held for the pages ahead\n" );
+        bad++;
+    }
+    if( Sim_Test_Cmd( CMD_IAP_END, NULL, 0 ) != ERR_End )
+    {
+        bad++;
+    }
+    /* Three pages and the image record */
+    if( ( Sim_Prog != 4 ) || memcmp( (void *)(uintptr_t)FLASH_Base, Sim_Test_Img, 9 * IAP_PROM_LEN ) )
+    {
+        printf( "  %d pages programmed\n", Sim_Prog );
+        bad++;
+    }
+    return bad + Sim_Fault;
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Over
+ *
+ * @brief   An image one byte longer than the user code area is refused
+ *          at its last packet, and the flag page is left alone.
+ *
+ * @return  number of failures
+ */
+static int Sim_Test_Over( void )
+{
+    uint8_t flag[ IAP_PAGE_SIZE ];
+    uint32_t len = IAP_APP_END - FLASH_Base + 1, off;
+    int bad = 0;
+
+    Sim_Test_Reset( );
+    memcpy( flag, (void *)(uintptr_t)IAP_APP_END, IAP_PAGE_SIZE );
+    Sim_Test_Fill( len, 2, 0, 0 );
+    off = Sim_Test_Send( len );
+    if( off != ( len - 1 ) / IAP_PROM_LEN * IAP_PROM_LEN )
+    {
+        printf( "  refused at %u\n", off );
+        bad++;
+    }
+    while( Rx_Cnt - Prog_Cnt >= IAP_PAGE_SIZE )
+    {
+        IAP_Process( );
+    }
+    if( memcmp( flag, (void *)(uintptr_t)IAP_APP_END, IAP_PAGE_SIZE ) )
+    {
+        printf( "  flag page changed\n" );
+        bad++;
+    }
+    return bad + Sim_Fault;
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Cut
+ *
+ * @brief   An update cut short leaves the flag page as it was, and a
+ *          reset then stays in the bootloader.
+ *
+ * @return  number of failures
+ */
+static int Sim_Test_Cut( void )
+{
+    uint8_t flag[ IAP_PAGE_SIZE ];
+    int bad = 0;
+
+    Sim_Test_Reset( );
+    Sim_Test_Fill( 30000, 3, 0, 0 );
+    Sim_Test_Send( 30000 );
+    if( ( Sim_Test_Cmd( CMD_IAP_END, NULL, 0 ) != ERR_End ) || !IAP_Boot_Check( ) )
+    {
+        printf( "  first image not started\n" );
+        bad++;
+    }
+    memcpy( flag, (void *)(uintptr_t)IAP_APP_END, IAP_PAGE_SIZE );
+    Sim_Test_Fill( 20000, 4, 0, 0 );
+    Sim_Test_Send( 10020 );
+    while( Rx_Cnt - Prog_Cnt >= IAP_PAGE_SIZE )
+    {
+        IAP_Process( );
+    }
+    if( memcmp( flag, (void *)(uintptr_t)IAP_APP_END, IAP_PAGE_SIZE ) )
+    {
+        printf( "  flag page changed\n" );
+        bad++;
+    }
+    if( IAP_Boot_Check( ) )
+    {
+        printf( "  a reset would start the half written image\n" );
+        bad++;
+    }
+    return bad + Sim_Fault;
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Legacy
+ *
+ * @brief   A blank flag page: old code with no record is started, a
+ *          blank user code area is not. An update cut short then marks
+ *          the flag page and stays in the bootloader, and a finished one
+ *          is started by its record.
+ *
+ * @return  number of failures
+ */
+static int Sim_Test_Legacy( void )
+{
+    int bad = 0;
+
+    Sim_Test_Reset( );
+    memset( (void *)(uintptr_t)IAP_APP_END, 0xFF, IAP_PAGE_SIZE );
+    if( !IAP_Boot_Check( ) )
+    {
+        printf( "  legacy application not started\n" );
+        bad++;
+    }
+    memset( (void *)(uintptr_t)FLASH_Base, 0xFF, IAP_APP_END - FLASH_Base );
+    if( IAP_Boot_Check( ) )
+    {
+        printf( "  blank user code area started\n" );
+        bad++;
+    }
+    memset( (void *)(uintptr_t)FLASH_Base, 0x5A, IAP_APP_END - FLASH_Base );
+    Sim_Test_Fill( 20000, 5, 0, 0 );
+    Sim_Test_Send( 10020 );
+    while( Rx_Cnt - Prog_Cnt >= IAP_PAGE_SIZE )
+    {
+        IAP_Process( );
+    }
+    if( ( *(uint32_t *)CalAddr != CheckNum ) || IAP_Boot_Check( ) )
+    {
+        printf( "  a reset would start the half written image\n" );
+        bad++;
+    }
+    Sim_Test_Reset( );
+    memset( (void *)(uintptr_t)IAP_APP_END, 0xFF, IAP_PAGE_SIZE );
+    Sim_Test_Fill( 20000, 6, 0, 0 );
+    Sim_Test_Send( 20000 );
+    if( ( Sim_Test_Cmd( CMD_IAP_END, NULL, 0 ) != ERR_End ) || !IAP_Boot_Check( ) ||
+        ( *(uint32_t *)IAP_APP_END != IAP_IMAGE_MAGIC ) )
+    {
+        printf( "  image over a legacy application not started by its record\n" );
+        bad++;
+    }
+    return bad + Sim_Fault;
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Link
+ *
+ * @brief   A headed image through Sim_Send and Sim_Recv, commands kept in
+ *          flight as wch_iap does: checked by the empty verify and
+ *          started, then a second image with a bad CRC32 refused at the
+ *          verify and the end.
+ *
+ * @return  number of failures
+ */
+static int Sim_Test_Link( int uart )
+{
+    IAP_LINK *plink = &Sim->Link;
+    uint8_t pcmd[ USBD_DATA_SIZE ];
+    uint32_t len, off, n, i, num, wait = 0;
+    int r[ 2 ], pass, win, bad = 0;
+
+    /* The link was opened for USB, the UART window is that of IAP_Sim_Open */
+    Sim->Uart = uart;
+    win = uart ? IAP_UART_RING / ( IAP_PROM_LEN + 8 ) : 8;
+    Sim_Test_Reset( );
+    for( pass = 0; pass < 2; pass++ )
+    {
+        len = Sim_Test_Fill( 30000, 5 + pass, 1, pass );
+        num = 2 + ( len + IAP_PROM_LEN - 1 ) / IAP_PROM_LEN;
+        r[ 0 ] = r[ 1 ] = 0;
+        for( i = 0; i < num; i++ )
+        {
+            memset( pcmd, 0, 6 );
+            n = 6;
+            if( i == 0 )
+            {
+                pcmd[ 0 ] = CMD_IAP_ERASE;
+            }
+            else if( i == num - 1 )
+            {
+                pcmd[ 0 ] = CMD_IAP_VERIFY;
+            }
+            else
+            {
+                off = ( i - 1 ) * IAP_PROM_LEN;
+                n = ( len - off < IAP_PROM_LEN ) ? len - off : IAP_PROM_LEN;
+                pcmd[ 0 ] = CMD_IAP_PROM;
+                pcmd[ 1 ] = n;
+                memcpy( pcmd + 2, Sim_Test_Img + off, n );
+                n += 2;
+            }
+            if( wait == (uint32_t)win )
+            {
+                r[ plink->Recv( plink, 0 ) != IAP_REPLY_OK ]++;
+                wait--;
+            }
+            if( plink->Send( plink, pcmd, n ) )
+            {
+                bad++;
+            }
+            wait++;
+        }
+        for( ; wait > 1; wait-- )
+        {
+            r[ plink->Recv( plink, 0 ) != IAP_REPLY_OK ]++;
+        }
+        /* Only the last reply, the empty verify, is wrong for the bad CRC32 */
+        wait = 0;
+        n = ( plink->Recv( plink, 0 ) == IAP_REPLY_OK );
+        if( r[ 1 ] || ( n != ( pass == 0 ) ) )
+        {
+            printf( "  pass %d: %d errors, verify %s\n", pass, r[ 1 ], n ? "passed" : "failed" );
+            bad++;
+        }
+        pcmd[ 0 ] = CMD_IAP_END;
+        pcmd[ 1 ] = 0;
+        plink->Send( plink, pcmd, 2 );
+        n = plink->Recv( plink, 0 );
+        if( ( End_Flag != ( pass == 0 ) ) || ( IAP_Boot_Check( ) != ( pass == 0 ) ) ||
+            ( ( pass == 1 ) && ( n != IAP_REPLY_ERR ) ) )
+        {
+            printf( "  pass %d: end %s, reply %d\n", pass, End_Flag ? "seen" : "missing", (int)n );
+            bad++;
+        }
+        End_Flag = 0;
+    }
+    return bad + Sim_Fault;
+}
+
+static int Sim_Test_Usb( void ) { return Sim_Test_Link( 0 ); }
+static int Sim_Test_Uart( void ) { return Sim_Test_Link( 1 ); }
+
+/*********************************************************************
+ * @fn      IAP_Sim_Test
+ *
+ * @brief   Run every self-test case, each in its own process.
+ *
+ * @return  number of failed cases
+ */
+int IAP_Sim_Test( void )
+{
+    static const struct
+    {
+        const char *Name;
+        int ( *Run )( void );
+    } test[ ] =
+    {
+        { "plain images of 100 B to 42752 B: data, padding, erase units", Sim_Test_Sizes },
+        { "page ring: ninth packet held until a page is programmed", Sim_Test_Ring },
+        { "image one byte too long: refused, flag page kept", Sim_Test_Over },
+        { "update cut short: flag page kept, a reset stays in IAP", Sim_Test_Cut },
+        { "no record: legacy code started, cut update stays in IAP", Sim_Test_Legacy },
+        { "headed image over USB: checked by CRC32, bad CRC32 refused", Sim_Test_Usb },
+        { "headed image over UART: checked by CRC32, bad CRC32 refused", Sim_Test_Uart },
+    };
+    pid_t pid;
+    int i, st, fail = 0;
+
+    unsetenv( "IAP_SIM_FLASH" );
+    if( IAP_Sim_Open( 0 ) == NULL )
+    {
+        return 1;
+    }
+    for( i = 0; i < (int)( sizeof( test ) / sizeof( test[ 0 ] ) ); i++ )
+    {
+        printf( "%s\n", test[ i ].Name );
+        fflush( stdout );
+        pid = fork( );
+        if( pid == 0 )
+        {
+            srand( i + 1 );
+            st = test[ i ].Run( );
+            fflush( stdout );
+            _exit( st ? 1 : 0 );
+        }
+        if( ( pid < 0 ) || ( waitpid( pid, &st, 0 ) != pid ) || !WIFEXITED( st ) || WEXITSTATUS( st ) )
+        {
+            printf( "  FAIL\n" );
+            fail++;
+        }
+        else
+        {
+            printf( "  ok\n" );
+        }
+    }
+    printf( "%s\n", fail ? "self-test FAILED" : "self-test passed" );
+    return fail;
+}
+
+#endif
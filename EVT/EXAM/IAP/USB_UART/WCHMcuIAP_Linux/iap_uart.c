@@ -0,0 +1,214 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_uart.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : UART transport of the Linux IAP tool.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+#include "iap_link.h"
+
+#define UART_SYNC_HEAD1     0xAA
+#define UART_SYNC_HEAD2     0x55
+
+/* Frame: aa 55 cmd len [addr 4] [data] sum_l sum_h 55 aa, reply: aa 55 00 status 55 aa */
+#define UART_FRAME_MAX      ( 2 + IAP_USB_PKT + 2 + 2 )
+
+typedef struct _UART_CTX
+{
+    IAP_LINK Link;
+    int      Fd;
+    uint8_t  Reply[ 6 ];
+    int      Reply_Len;
+} UART_CTX;
+
+/*********************************************************************
+ * @fn      UART_Send
+ *
+ * @brief   Frame a command and write it out.
+ *
+ * @return  0 - written, -1 - error
+ */
+static int UART_Send( IAP_LINK *plink, const uint8_t *pcmd, int len )
+{
+    UART_CTX *pctx = plink->pCtx;
+    uint8_t frame[ UART_FRAME_MAX ];
+    uint16_t sum = 0;
+    int i, n = 0, w;
+
+    frame[ n++ ] = UART_SYNC_HEAD1;
+    frame[ n++ ] = UART_SYNC_HEAD2;
+    for( i = 0; i < len; i++ )
+    {
+        frame[ n++ ] = pcmd[ i ];
+        sum += pcmd[ i ];
+    }
+    frame[ n++ ] = (uint8_t)sum;
+    frame[ n++ ] = (uint8_t)( sum >> 8 );
+    frame[ n++ ] = UART_SYNC_HEAD2;
+    frame[ n++ ] = UART_SYNC_HEAD1;
+
+    for( i = 0; i < n; i += w )
+    {
+        w = write( pctx->Fd, frame + i, n - i );
+        if( ( w < 0 ) && ( errno != EINTR ) )
+        {
+            fprintf( stderr, "uart: write, %s\n", strerror( errno ) );
+            return -1;
+        }
+        w = ( w < 0 ) ? 0 : w;
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      UART_Recv
+ *
+ * @brief   Wait for the reply to the oldest command, skipping anything
+ *          that is not a reply frame.
+ *
+ * @return  IAP_REPLY_OK, IAP_REPLY_ERR or IAP_REPLY_TIMEOUT
+ */
+static int UART_Recv( IAP_LINK *plink, int timeout_ms )
+{
+    static const uint8_t sync[ 6 ] = { UART_SYNC_HEAD1, UART_SYNC_HEAD2, 0x00, 0x00, UART_SYNC_HEAD2, UART_SYNC_HEAD1 };
+    UART_CTX *pctx = plink->pCtx;
+    struct pollfd pfd;
+    uint8_t c;
+    int n;
+
+    pfd.fd = pctx->Fd;
+    pfd.events = POLLIN;
+    while( 1 )
+    {
+        n = read( pctx->Fd, &c, 1 );
+        if( n <= 0 )
+        {
+            if( poll( &pfd, 1, timeout_ms ) <= 0 )
+            {
+                return IAP_REPLY_TIMEOUT;
+            }
+            continue;
+        }
+
+        /* Byte 3 is the status, the others must match */
+        if( ( pctx->Reply_Len != 3 ) && ( c != sync[ pctx->Reply_Len ] ) )
+        {
+            pctx->Reply_Len = ( c == UART_SYNC_HEAD1 ) ? 1 : 0;
+            continue;
+        }
+        pctx->Reply[ pctx->Reply_Len++ ] = c;
+        if( pctx->Reply_Len == 6 )
+        {
+            pctx->Reply_Len = 0;
+            return pctx->Reply[ 3 ] ? IAP_REPLY_ERR : IAP_REPLY_OK;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      UART_Close
+ *
+ * @brief   Wait until the last frame is out and close the port.
+ *
+ * @return  none
+ */
+static void UART_Close( IAP_LINK *plink )
+{
+    UART_CTX *pctx = plink->pCtx;
+
+    tcdrain( pctx->Fd );
+    close( pctx->Fd );
+    free( pctx );
+}
+
+/*********************************************************************
+ * @fn      UART_Speed
+ *
+ * @brief   termios constant of a baud rate.
+ *
+ * @return  speed, 0 if not supported
+ */
+static speed_t UART_Speed( int baud )
+{
+    switch( baud )
+    {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+        default:      return 0;
+    }
+}
+
+/*********************************************************************
+ * @fn      IAP_UART_Open
+ *
+ * @brief   Open a serial port wired to USART2 of the bootloader.
+ *
+ * @param   ptty - device, e.g. /dev/ttyUSB0
+ *          baud - baud rate, 460800 unless the bootloader was changed
+ *
+ * @return  link, NULL on error
+ */
+IAP_LINK *IAP_UART_Open( const char *ptty, int baud )
+{
+    UART_CTX *pctx;
+    struct termios t;
+    speed_t sp = UART_Speed( baud );
+    int fd;
+
+    if( sp == 0 )
+    {
+        fprintf( stderr, "uart: %d baud not supported\n", baud );
+        return NULL;
+    }
+    fd = open( ptty, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC );
+    if( fd < 0 )
+    {
+        fprintf( stderr, "%s: %s\n", ptty, strerror( errno ) );
+        return NULL;
+    }
+    if( tcgetattr( fd, &t ) < 0 )
+    {
+        fprintf( stderr, "%s: %s\n", ptty, strerror( errno ) );
+        close( fd );
+        return NULL;
+    }
+    cfmakeraw( &t );
+    t.c_cflag |= CLOCAL | CREAD;
+    t.c_cflag &= ~( CSTOPB | CRTSCTS );
+    t.c_cc[ VMIN ] = 0;
+    t.c_cc[ VTIME ] = 0;
+    cfsetispeed( &t, sp );
+    cfsetospeed( &t, sp );
+    tcsetattr( fd, TCSANOW, &t );
+    tcflush( fd, TCIOFLUSH );
+
+    pctx = calloc( 1, sizeof( UART_CTX ) );
+    pctx->Fd = fd;
+    pctx->Link.Name = "uart";
+    /* Frames not answered yet wait in the receive ring of the bootloader */
+    pctx->Link.Window_Max = IAP_UART_RING / ( IAP_PROM_LEN + 8 );
+    pctx->Link.Send = UART_Send;
+    pctx->Link.Recv = UART_Recv;
+    pctx->Link.Close = UART_Close;
+    pctx->Link.pCtx = pctx;
+    return &pctx->Link;
+}
@@ -0,0 +1,349 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_usb.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : USB transport of the Linux IAP tool, on usbdevfs so
+ *                      no library is needed.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <linux/usbdevice_fs.h>
+#include "iap_link.h"
+
+/* Each command takes one bulk OUT and one bulk IN URB. The bootloader NAKs
+ * the next OUT until the reply of the current one has been read, so the
+ * queued URBs wait in the host controller instead of being lost. */
+#define USB_URB_NUM         16
+
+typedef struct _USB_URB
+{
+    struct usbdevfs_urb Urb;
+    uint8_t Buf[ IAP_USB_PKT ];
+    int     Busy;
+} USB_URB;
+
+typedef struct _USB_CTX
+{
+    IAP_LINK Link;
+    int      Fd;
+    USB_URB  Out[ USB_URB_NUM ];
+    USB_URB  In[ USB_URB_NUM ];
+    int      In_Head;                                           // Oldest IN URB not reaped yet
+    int      In_Tail;
+    int      Out_Busy;
+} USB_CTX;
+
+/*********************************************************************
+ * @fn      USB_Now_Ms
+ *
+ * @brief   Monotonic time.
+ *
+ * @return  milliseconds
+ */
+static long USB_Now_Ms( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/*********************************************************************
+ * @fn      USB_Read_Attr
+ *
+ * @brief   Read a hexadecimal or decimal sysfs attribute.
+ *
+ * @return  value, -1 if it can not be read
+ */
+static long USB_Read_Attr( const char *pdev, const char *pattr, int base )
+{
+    char path[ 300 ], buf[ 32 ];
+    FILE *f;
+    long v = -1;
+
+    snprintf( path, sizeof( path ), "/sys/bus/usb/devices/%s/%s", pdev, pattr );
+    f = fopen( path, "r" );
+    if( f )
+    {
+        if( fgets( buf, sizeof( buf ), f ) )
+        {
+            v = strtol( buf, NULL, base );
+        }
+        fclose( f );
+    }
+    return v;
+}
+
+/*********************************************************************
+ * @fn      USB_Find
+ *
+ * @brief   Look for the bootloader and open its usbfs node.
+ *
+ * @return  file descriptor, -1 if not found
+ */
+static int USB_Find( void )
+{
+    DIR *d;
+    struct dirent *e;
+    char path[ 64 ];
+    long bus, dev;
+    int fd = -1;
+
+    d = opendir( "/sys/bus/usb/devices" );
+    if( d == NULL )
+    {
+        return -1;
+    }
+    while( ( fd < 0 ) && ( e = readdir( d ) ) )
+    {
+        if( ( e->d_name[ 0 ] == '.' ) || strchr( e->d_name, ':' ) )
+        {
+            continue;
+        }
+        if( ( USB_Read_Attr( e->d_name, "idVendor", 16 ) != IAP_USB_VID ) ||
+            ( USB_Read_Attr( e->d_name, "idProduct", 16 ) != IAP_USB_PID ) )
+        {
+            continue;
+        }
+        bus = USB_Read_Attr( e->d_name, "busnum", 10 );
+        dev = USB_Read_Attr( e->d_name, "devnum", 10 );
+        snprintf( path, sizeof( path ), "/dev/bus/usb/%03ld/%03ld", bus, dev );
+        fd = open( path, O_RDWR | O_CLOEXEC );
+        if( fd < 0 )
+        {
+            fprintf( stderr, "%s: %s\n", path, strerror( errno ) );
+        }
+    }
+    closedir( d );
+    return fd;
+}
+
+/*********************************************************************
+ * @fn      USB_Reap
+ *
+ * @brief   Take back one finished URB.
+ *
+ * @param   timeout_ms - time to wait for it
+ *
+ * @return  0 - reaped, -1 - timeout or error
+ */
+static int USB_Reap( USB_CTX *pctx, int timeout_ms )
+{
+    struct usbdevfs_urb *purb;
+    struct pollfd pfd;
+    USB_URB *p;
+
+    pfd.fd = pctx->Fd;
+    pfd.events = POLLOUT;
+    while( ioctl( pctx->Fd, USBDEVFS_REAPURBNDELAY, &purb ) < 0 )
+    {
+        if( ( errno != EAGAIN ) || ( poll( &pfd, 1, timeout_ms ) <= 0 ) )
+        {
+            return -1;
+        }
+    }
+    p = purb->usercontext;
+    p->Busy = 0;
+    if( purb->endpoint == IAP_USB_EP_OUT )
+    {
+        pctx->Out_Busy--;
+        if( purb->status )
+        {
+            fprintf( stderr, "usb: OUT failed, %s\n", strerror( -purb->status ) );
+        }
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      USB_Submit
+ *
+ * @brief   Queue a bulk URB.
+ *
+ * @return  0 - queued, -1 - error
+ */
+static int USB_Submit( USB_CTX *pctx, USB_URB *p, uint8_t ep, int len )
+{
+    memset( &p->Urb, 0, sizeof( p->Urb ) );
+    p->Urb.type = USBDEVFS_URB_TYPE_BULK;
+    p->Urb.endpoint = ep;
+    p->Urb.buffer = p->Buf;
+    p->Urb.buffer_length = len;
+    p->Urb.usercontext = p;
+    if( ioctl( pctx->Fd, USBDEVFS_SUBMITURB, &p->Urb ) < 0 )
+    {
+        fprintf( stderr, "usb: submit, %s\n", strerror( errno ) );
+        return -1;
+    }
+    p->Busy = 1;
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      USB_Send
+ *
+ * @brief   Queue a command and the read of its reply.
+ *
+ * @return  0 - queued, -1 - error
+ */
+static int USB_Send( IAP_LINK *plink, const uint8_t *pcmd, int len )
+{
+    USB_CTX *pctx = plink->pCtx;
+    USB_URB *p;
+    int i;
+
+    for( i = 0; pctx->Out[ i ].Busy; )
+    {
+        if( ++i == USB_URB_NUM )
+        {
+            if( USB_Reap( pctx, 1000 ) )
+            {
+                return -1;
+            }
+            i = 0;
+        }
+    }
+    p = &pctx->Out[ i ];
+    memcpy( p->Buf, pcmd, len );
+    if( USB_Submit( pctx, p, IAP_USB_EP_OUT, len ) )
+    {
+        return -1;
+    }
+    pctx->Out_Busy++;
+
+    /* END is not answered */
+    if( pcmd[ 0 ] == CMD_IAP_END )
+    {
+        return 0;
+    }
+    p = &pctx->In[ pctx->In_Tail ];
+    if( p->Busy || USB_Submit( pctx, p, IAP_USB_EP_IN, IAP_USB_PKT ) )
+    {
+        return -1;
+    }
+    pctx->In_Tail = ( pctx->In_Tail + 1 ) % USB_URB_NUM;
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      USB_Recv
+ *
+ * @brief   Wait for the reply to the oldest command.
+ *
+ * @return  IAP_REPLY_OK, IAP_REPLY_ERR or IAP_REPLY_TIMEOUT
+ */
+static int USB_Recv( IAP_LINK *plink, int timeout_ms )
+{
+    USB_CTX *pctx = plink->pCtx;
+    USB_URB *p = &pctx->In[ pctx->In_Head ];
+    long end = USB_Now_Ms( ) + timeout_ms;
+    long left;
+
+    while( p->Busy )
+    {
+        left = end - USB_Now_Ms( );
+        if( ( left < 0 ) || USB_Reap( pctx, (int)left ) )
+        {
+            return IAP_REPLY_TIMEOUT;
+        }
+    }
+    pctx->In_Head = ( pctx->In_Head + 1 ) % USB_URB_NUM;
+    if( ( p->Urb.status != 0 ) || ( p->Urb.actual_length < 2 ) )
+    {
+        return IAP_REPLY_ERR;
+    }
+    return p->Buf[ 1 ] ? IAP_REPLY_ERR : IAP_REPLY_OK;
+}
+
+/*********************************************************************
+ * @fn      USB_Close
+ *
+ * @brief   Let the last OUT packets go, drop unread replies and give the
+ *          device back.
+ *
+ * @return  none
+ */
+static void USB_Close( IAP_LINK *plink )
+{
+    USB_CTX *pctx = plink->pCtx;
+    unsigned int itf = 0;
+    int i;
+
+    while( pctx->Out_Busy && ( USB_Reap( pctx, 1000 ) == 0 ) )
+    {
+    }
+    for( i = 0; i < USB_URB_NUM; i++ )
+    {
+        if( pctx->Out[ i ].Busy )
+        {
+            ioctl( pctx->Fd, USBDEVFS_DISCARDURB, &pctx->Out[ i ].Urb );
+        }
+        if( pctx->In[ i ].Busy )
+        {
+            ioctl( pctx->Fd, USBDEVFS_DISCARDURB, &pctx->In[ i ].Urb );
+        }
+    }
+    while( USB_Reap( pctx, 100 ) == 0 )
+    {
+    }
+    ioctl( pctx->Fd, USBDEVFS_RELEASEINTERFACE, &itf );
+    close( pctx->Fd );
+    free( pctx );
+}
+
+/*********************************************************************
+ * @fn      IAP_USB_Open
+ *
+ * @brief   Open the first bootloader (or CH643_APP) found on USB.
+ *
+ * @param   wait_ms - time to wait for it to show up
+ *
+ * @return  link, NULL if not found
+ */
+IAP_LINK *IAP_USB_Open( int wait_ms )
+{
+    USB_CTX *pctx;
+    unsigned int itf = 0;
+    long end = USB_Now_Ms( ) + wait_ms;
+    int fd;
+
+    while( ( fd = USB_Find( ) ) < 0 )
+    {
+        if( USB_Now_Ms( ) >= end )
+        {
+            fprintf( stderr, "usb: no %04x:%04x device\n", IAP_USB_VID, IAP_USB_PID );
+            return NULL;
+        }
+        usleep( 100000 );
+    }
+    if( ioctl( fd, USBDEVFS_CLAIMINTERFACE, &itf ) < 0 )
+    {
+        fprintf( stderr, "usb: claim interface, %s\n", strerror( errno ) );
+        close( fd );
+        return NULL;
+    }
+
+    pctx = calloc( 1, sizeof( USB_CTX ) );
+    pctx->Fd = fd;
+    pctx->Link.Name = "usb";
+    pctx->Link.Window_Max = USB_URB_NUM;
+    pctx->Link.Send = USB_Send;
+    pctx->Link.Recv = USB_Recv;
+    pctx->Link.Close = USB_Close;
+    pctx->Link.pCtx = pctx;
+    return &pctx->Link;
+}
@@ -0,0 +1,366 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : wch_delta.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Maker of delta IAP images for CH643_IAP, updating
+ *                      the application in place from the one it runs.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * Encodes app_new.bin as copies from app_old.bin, the image in the device,
+ * and literals. Every delta made is applied again with the bootloader's
+ * iap_delta.c on a copy of the old image before it is written out.
+ * A delta only fits the exact old image it was made from; the bootloader
+ * refuses it on any other before writing anything. If power is lost during
+ * the update, the bootloader stays in IAP mode and sending the same delta
+ * again finishes it.
+ *
+ * Build:
+ *   gcc -O2 -I../CH643_IAP/User -o wch_delta wch_delta.c iap_deltapack.c
+ *       ../CH643_IAP/User/iap_delta.c ../CH643_IAP/User/iap_lz.c
+ *
+ * Usage:
+ *   wch_delta app_old.bin app_new.bin delta.bin   make, then send delta.bin
+ *                                                 with wch_iap
+ *   wch_delta -t                                  built-in tests, with power
+ *                                                 lost at every page write
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "iap_lz.h"
+#include "iap_delta.h"
+#include "iap_deltapack.h"
+
+#define FLASH_LEN           ( IAP_DELTA_AREA_LEN + IAP_DELTA_PAGE )
+
+/*********************************************************************
+ * @fn      Read_File
+ *
+ * @brief   Read a whole file.
+ *
+ * @return  length, -1 on error
+ */
+static long Read_File( const char *pname, uint8_t *pbuf, long max )
+{
+    FILE *f = fopen( pname, "rb" );
+    long n;
+
+    if( f == NULL )
+    {
+        perror( pname );
+        return -1;
+    }
+    n = fread( pbuf, 1, max, f );
+    if( fgetc( f ) != EOF )
+    {
+        fprintf( stderr, "%s: larger than %ld bytes\n", pname, max );
+        n = -1;
+    }
+    fclose( f );
+    return n;
+}
+
+/*********************************************************************
+ * @fn      Write_File
+ *
+ * @brief   Write a whole file.
+ *
+ * @return  0 - ok, -1 on error
+ */
+static int Write_File( const char *pname, const uint8_t *pbuf, long len )
+{
+    FILE *f = fopen( pname, "wb" );
+
+    if( ( f == NULL ) || ( fwrite( pbuf, 1, len, f ) != (size_t)len ) || fclose( f ) )
+    {
+        perror( pname );
+        return -1;
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Load_Old
+ *
+ * @brief   Flash holding the old image, as programmed by the bootloader:
+ *          its last page padded with 0xFF, anything after it.
+ *
+ * @return  none
+ */
+static void Load_Old( uint8_t *pflash, const uint8_t *pold, uint32_t old_len )
+{
+    uint32_t i;
+
+    for( i = 0; i < FLASH_LEN; i++ )
+    {
+        pflash[ i ] = rand( );
+    }
+    memcpy( pflash, pold, old_len );
+    for( i = old_len; i & ( IAP_DELTA_PAGE - 1 ); i++ )
+    {
+        pflash[ i ] = 0xFF;
+    }
+}
+
+/*********************************************************************
+ * @fn      Is_New
+ *
+ * @brief   Check that flash holds the new image.
+ *
+ * @return  1 - it does
+ */
+static int Is_New( const uint8_t *pflash, const uint8_t *pnew, uint32_t new_len )
+{
+    uint32_t i;
+
+    for( i = new_len; i & ( IAP_DELTA_PAGE - 1 ); i++ )
+    {
+        if( pflash[ i ] != 0xFF )
+        {
+            return 0;
+        }
+    }
+    return memcmp( pflash, pnew, new_len ) == 0;
+}
+
+/*********************************************************************
+ * @fn      Round_Trip
+ *
+ * @brief   Make a delta and apply it: straight, with power lost at each
+ *          page write and then at random ones, on a damaged old image,
+ *          and damaged itself. A refused delta must leave every page
+ *          holding its old or its new content.
+ *
+ * @return  delta length, 0 if a check failed
+ */
+static uint32_t Round_Trip( const char *pname, const uint8_t *pold, uint32_t old_len,
+                            const uint8_t *pnew, uint32_t new_len, int *pwrites )
+{
+    static uint8_t d[ IAP_DELTA_PACK_MAX( FLASH_LEN, FLASH_LEN ) ], flash[ FLASH_LEN ], ref[ FLASH_LEN ];
+    uint32_t dlen = IAP_Delta_Pack( pold, old_len, pnew, new_len, d );
+    int cut, writes = 0, rc, i, n, pos;
+    uint32_t p;
+    uint8_t bit;
+
+    Load_Old( flash, pold, old_len );
+    cut = 0;
+    if( ( IAP_Delta_Sim( flash, IAP_DELTA_AREA_LEN, d, dlen, &cut, &writes ) != 0 ) || !Is_New( flash, pnew, new_len ) )
+    {
+        fprintf( stderr, "%s: not applied\n", pname );
+        return 0;
+    }
+    *pwrites = writes;
+    n = 0;
+    if( ( IAP_Delta_Sim( flash, IAP_DELTA_AREA_LEN, d, dlen, &cut, &n ) != 0 ) || n )
+    {
+        fprintf( stderr, "%s: not applied again without writes\n", pname );
+        return 0;
+    }
+
+    for( i = 1; i <= writes; i++ )
+    {
+        Load_Old( flash, pold, old_len );
+        cut = i;
+        rc = IAP_Delta_Sim( flash, IAP_DELTA_AREA_LEN, d, dlen, &cut, &n );
+        while( rc == 1 )
+        {
+            cut = ( rand( ) % 4 ) ? 0 : 1 + rand( ) % ( writes + 1 );
+            rc = IAP_Delta_Sim( flash, IAP_DELTA_AREA_LEN, d, dlen, &cut, &n );
+        }
+        if( ( rc != 0 ) || !Is_New( flash, pnew, new_len ) )
+        {
+            fprintf( stderr, "%s: not finished after power lost at write %d\n", pname, i );
+            return 0;
+        }
+    }
+
+    for( i = 0; ( i < 100 ) && old_len; i++ )
+    {
+        Load_Old( flash, pold, old_len );
+        flash[ rand( ) % old_len ] ^= 1 << ( rand( ) % 8 );
+        memcpy( ref, flash, FLASH_LEN );
+        cut = 0;
+        rc = IAP_Delta_Sim( flash, IAP_DELTA_AREA_LEN, d, dlen, &cut, &n );
+        if( ( rc == 0 ) ? !Is_New( flash, pnew, new_len ) : memcmp( flash, ref, FLASH_LEN ) )
+        {
+            fprintf( stderr, "%s: damaged old image %s\n", pname, rc ? "written" : "not refused" );
+            return 0;
+        }
+    }
+
+    for( i = 0; ( i < 200 ) && ( dlen > IAP_DELTA_HEAD_LEN ); i++ )
+    {
+        Load_Old( flash, pold, old_len );
+        memcpy( ref, flash, FLASH_LEN );
+        pos = IAP_DELTA_HEAD_LEN + rand( ) % ( dlen - IAP_DELTA_HEAD_LEN );
+        bit = 1 << ( rand( ) % 8 );
+        d[ pos ] ^= bit;
+        cut = 0;
+        rc = IAP_Delta_Sim( flash, IAP_DELTA_AREA_LEN, d, dlen - ( i & 1 ), &cut, &n );
+        d[ pos ] ^= bit;
+        if( ( rc == 0 ) && !Is_New( flash, pnew, new_len ) )
+        {
+            fprintf( stderr, "%s: damage at %d not detected\n", pname, pos );
+            return 0;
+        }
+        for( p = 0; p < ( ( old_len > new_len ) ? old_len : new_len ); p += IAP_DELTA_PAGE )
+        {
+            if( memcmp( flash + p, ref + p, IAP_DELTA_PAGE ) &&
+                ( ( p >= new_len ) || memcmp( flash + p, pnew + p, ( new_len - p < IAP_DELTA_PAGE ) ? new_len - p : IAP_DELTA_PAGE ) ) )
+            {
+                fprintf( stderr, "%s: damage at %d wrote page %u\n", pname, pos, p / IAP_DELTA_PAGE );
+                return 0;
+            }
+        }
+        cut = 0;
+        if( ( IAP_Delta_Sim( flash, IAP_DELTA_AREA_LEN, d, dlen, &cut, &n ) != 0 ) || !Is_New( flash, pnew, new_len ) )
+        {
+            fprintf( stderr, "%s: not applied after damage at %d\n", pname, pos );
+            return 0;
+        }
+    }
+    return dlen;
+}
+
+/*********************************************************************
+ * @fn      Make_Code
+ *
+ * @brief   Synthetic code: runs copied from nearby, mixed with new bytes.
+ *
+ * @return  none
+ */
+static void Make_Code( uint8_t *pbuf, uint32_t len )
+{
+    uint32_t i;
+
+    for( i = 0; i < len; i++ )
+    {
+        pbuf[ i ] = ( ( i > 64 ) && ( rand( ) % 8 ) ) ? pbuf[ i - 4 * ( 1 + ( i / 16 ) % 16 ) ] : rand( );
+    }
+}
+
+/*********************************************************************
+ * @fn      Self_Test
+ *
+ * @brief   Round trip of synthetic updates: bytes patched, code inserted
+ *          and removed, images grown, shrunk, created and replaced.
+ *
+ * @return  0 - passed, 1 - failed
+ */
+static int Self_Test( void )
+{
+    static uint8_t old[ FLASH_LEN ], new[ FLASH_LEN ];
+    static const char *name[ ] = { "same", "patch", "insert", "remove", "grow", "shrink", "empty", "noise", "full" };
+    uint32_t k, i, old_len, new_len, dlen, at;
+    int fail = 0, writes;
+
+    srand( 1 );
+    for( k = 0; k < sizeof( name ) / sizeof( name[ 0 ] ); k++ )
+    {
+        old_len = 20000 + rand( ) % 4000;
+        Make_Code( old, old_len );
+        memcpy( new, old, old_len );
+        new_len = old_len;
+        at = old_len / 3 + rand( ) % ( old_len / 3 );
+        switch( k )
+        {
+            case 1:
+                for( i = 0; i < 6; i++ )
+                {
+                    new[ rand( ) % old_len ] ^= 0x5A;
+                }
+                break;
+            case 2:
+                memmove( new + at + 37, old + at, old_len - at );
+                Make_Code( new + at, 37 );
+                new_len += 37;
+                break;
+            case 3:
+                memmove( new + at, old + at + 300, old_len - at - 300 );
+                new_len -= 300;
+                break;
+            case 4:
+                Make_Code( new + old_len, 5000 );
+                new_len += 5000;
+                break;
+            case 5:
+                new_len = old_len / 2 + 7;
+                break;
+            case 6:
+                old_len = 0;
+                break;
+            case 7:
+                for( i = 0; i < new_len; i++ )
+                {
+                    new[ i ] = rand( );
+                }
+                break;
+            case 8:
+                old_len = IAP_DELTA_AREA_LEN;
+                Make_Code( old, old_len );
+                memcpy( new, old, old_len );
+                memmove( new + at + 1, old + at, old_len - at - 1 );
+                new_len = old_len;
+                break;
+        }
+        writes = 0;
+        dlen = Round_Trip( name[ k ], old, old_len, new, new_len, &writes );
+        if( dlen == 0 )
+        {
+            fail = 1;
+        }
+        printf( "%-6s %5u -> %5u bytes: delta %5u, %3d page writes %s\n", name[ k ], old_len, new_len, dlen, writes, dlen ? "ok" : "FAILED" );
+    }
+    printf( "%s\n", fail ? "FAILED" : "all passed" );
+    return fail;
+}
+
+int main( int argc, char **argv )
+{
+    static uint8_t old[ FLASH_LEN ], new[ FLASH_LEN ], flash[ FLASH_LEN ];
+    static uint8_t d[ IAP_DELTA_PACK_MAX( FLASH_LEN, FLASH_LEN ) ];
+    long old_len, new_len;
+    uint32_t dlen;
+    int cut = 0, writes = 0;
+
+    if( ( argc == 2 ) && !strcmp( argv[ 1 ], "-t" ) )
+    {
+        return Self_Test( );
+    }
+    if( argc != 4 )
+    {
+        fprintf( stderr, "usage: %s app_old.bin app_new.bin delta.bin | -t\n", argv[ 0 ] );
+        return 2;
+    }
+
+    old_len = Read_File( argv[ 1 ], old, IAP_DELTA_AREA_LEN );
+    new_len = Read_File( argv[ 2 ], new, IAP_DELTA_AREA_LEN );
+    if( ( old_len < 0 ) || ( new_len < 0 ) )
+    {
+        return 1;
+    }
+    if( IAP_LZ_Check( old, old_len ) || IAP_Delta_Check( old, old_len ) ||
+        IAP_LZ_Check( new, new_len ) || IAP_Delta_Check( new, new_len ) )
+    {
+        fprintf( stderr, "plain .bin images are needed\n" );
+        return 1;
+    }
+    dlen = IAP_Delta_Pack( old, old_len, new, new_len, d );
+    Load_Old( flash, old, old_len );
+    if( ( IAP_Delta_Sim( flash, IAP_DELTA_AREA_LEN, d, dlen, &cut, &writes ) != 0 ) || !Is_New( flash, new, new_len ) )
+    {
+        fprintf( stderr, "%s: applying the delta failed\n", argv[ 3 ] );
+        return 1;
+    }
+    printf( "%s: %ld -> %ld bytes, delta %u bytes (%.1f%%), %d page writes for %ld pages\n", argv[ 3 ], old_len, new_len,
+            dlen, new_len ? 100.0 * dlen / new_len : 0.0, writes, ( new_len + IAP_DELTA_PAGE - 1 ) / IAP_DELTA_PAGE );
+    return Write_File( argv[ 3 ], d, dlen ) ? 1 : 0;
+}
@@ -0,0 +1,632 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : wch_iap.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Command line IAP tool for Linux, talking to
+ *                      CH643_IAP over USB or UART.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * Same commands as WCHMcuIAP_WinAPP.exe, but several commands are kept in
+ * flight (-w) instead of waiting for each reply before sending the next.
+ * The bootloader answers a packet as soon as it is buffered and programs
+ * flash from its main loop, so the link stays busy while pages are written.
+ *
+ * Build:
+ *   gcc -O2 -I../CH643_IAP/User -o wch_iap wch_iap.c iap_usb.c iap_uart.c
+ *       iap_lzpack.c ../CH643_IAP/User/iap_lz.c ../CH643_IAP/User/iap_delta.c
+ * Build against the real command handler, with flash kept in memory:
+ *   gcc -O2 -DIAP_SIM -I../CH643_IAP/User -I../../../SRC/Core
+ *       -I../../../SRC/Debug -I../../../SRC/Peripheral/inc
+ *       -o wch_iap_sim wch_iap.c iap_usb.c iap_uart.c iap_sim.c
+ *       iap_lzpack.c ../CH643_IAP/User/iap_lz.c ../CH643_IAP/User/iap_delta.c
+ *   The simulated flash is kept between runs in $IAP_SIM_FLASH if set.
+ *   wch_iap_sim -t runs the self-tests of the command handler:
+ *   - plain images of 100 B to 42752 B (the whole user code area): verified
+ *     byte by byte, 0xFF after the end of the last page, erased with 1K
+ *     pages while they stay below the flag page and 256 byte pages after
+ *     that, never programmed over old code;
+ *   - the two page ring: the ninth 60 byte packet is held busy until the
+ *     main loop programs a page, VERIFY and END wait for every page;
+ *   - a 42753 B image is refused at its last packet, the flag page kept;
+ *   - an update cut short keeps the flag page, a reset stays in IAP;
+ *   - a blank flag page: old code with no record is started, a blank user
+ *     code area is not, an update cut short marks the page and stays in
+ *     IAP, a finished one is started by its record;
+ *   - a headed image over USB and over UART, commands kept in flight:
+ *     checked by the empty verify and started, a bad CRC32 refused.
+ *
+ * Usage:
+ *   wch_iap [-p usb|/dev/ttyUSBx|sim|sim-uart] [-b baud] [-w window]
+ *           [-B base] [-j] [-n] [-z] [-l] app.hex|app.bin
+ *   -p  transport, usb by default
+ *   -b  UART baud rate, 460800 by default
+ *   -w  commands in flight, 1 waits for every reply like the Windows tool
+ *   -B  address of a .bin file, 0x08005000 by default
+ *   -j  ask a running CH643_APP to go to the bootloader first
+ *   -n  skip the verify pass
+ *   -z  send the image packed (see wch_lzpack.c) when that is shorter. Files
+ *       packed by wch_lzpack are always sent as they are.
+ *   -l  for bootloaders older than the image header: send a plain image
+ *       without it and verify by sending the image back
+ * A plain image is sent after the IAP_IMAGE header (see iap_image.h), so
+ * the verify pass is a single empty CMD_IAP_VERIFY: the bootloader checks
+ * the CRC32 it took while programming against the header.
+ * Delta files made by wch_delta are sent as they are too, and checked the
+ * same way; the bootloader refuses one not made from the code it holds.
+ * USB access needs write permission on /dev/bus/usb, e.g. a udev rule for
+ * 1a86:55e0.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+#include "iap_link.h"
+#include "iap_lz.h"
+#include "iap_lzpack.h"
+#include "iap_delta.h"
+#include "iap_image.h"
+
+/* Layout of CH643_IAP: code from FLASH_Base up to the flag page */
+#define APP_BASE            0x08005000
+#define APP_END             0x0800F700
+#define APP_ALIAS           0x08000000                      // Flash is also seen from address 0
+
+#define REPLY_TIMEOUT_MS    2000
+
+typedef struct _IMAGE
+{
+    uint8_t  *pBuf;
+    uint32_t Addr;
+    uint32_t Len;
+    uint8_t  *pSend;                                            // What CMD_IAP_PROM carries: pBuf, or pBuf packed
+    uint32_t Send_Len;
+    int      Packed;
+    int      Crc_Check;                                         // Checked by the bootloader against a CRC32 it was sent
+} IMAGE;
+
+typedef struct _PHASE
+{
+    const char *Name;
+    double   Ms;
+    uint32_t Cmds;
+} PHASE;
+
+static int Window = 8;
+
+/*********************************************************************
+ * @fn      Now_Ms
+ *
+ * @brief   Monotonic time.
+ *
+ * @return  milliseconds
+ */
+static double Now_Ms( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/*********************************************************************
+ * @fn      Image_Put
+ *
+ * @brief   Place bytes at an absolute address, growing the image and
+ *          filling holes with 0xFF.
+ *
+ * @return  0 - ok, -1 - outside the user code area
+ */
+static int Image_Put( IMAGE *pimg, uint32_t addr, const uint8_t *pdata, uint32_t len )
+{
+    if( addr < APP_BASE - APP_ALIAS )
+    {
+        return -1;
+    }
+    if( addr < APP_ALIAS )
+    {
+        addr += APP_ALIAS;
+    }
+    if( ( addr < APP_BASE ) || ( addr + len > APP_END ) )
+    {
+        return -1;
+    }
+    if( pimg->pBuf == NULL )
+    {
+        pimg->pBuf = malloc( APP_END - APP_BASE );
+        memset( pimg->pBuf, 0xFF, APP_END - APP_BASE );
+        pimg->Addr = APP_BASE;
+    }
+    memcpy( pimg->pBuf + addr - APP_BASE, pdata, len );
+    if( addr + len - APP_BASE > pimg->Len )
+    {
+        pimg->Len = addr + len - APP_BASE;
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Hex_Byte
+ *
+ * @brief   Two hex digits.
+ *
+ * @return  value, -1 if not hex
+ */
+static int Hex_Byte( const char *p )
+{
+    char t[ 3 ] = { p[ 0 ], p[ 1 ], 0 };
+    char *e;
+    long v = strtol( t, &e, 16 );
+
+    return ( *e || ( e != t + 2 ) ) ? -1 : (int)v;
+}
+
+/*********************************************************************
+ * @fn      Load_Hex
+ *
+ * @brief   Read an Intel HEX file: data, end, extended segment and
+ *          extended linear address records; start records are ignored.
+ *
+ * @return  0 - ok, -1 - error
+ */
+static int Load_Hex( FILE *f, IMAGE *pimg )
+{
+    char line[ 600 ];
+    uint8_t rec[ 260 ];
+    uint32_t base = 0;
+    int n, i, b, sum, ln = 0;
+
+    while( fgets( line, sizeof( line ), f ) )
+    {
+        ln++;
+        if( line[ 0 ] != ':' )
+        {
+            continue;
+        }
+        n = Hex_Byte( line + 1 );
+        if( ( n < 0 ) || ( strlen( line ) < (size_t)( 11 + 2 * n ) ) )
+        {
+            fprintf( stderr, "hex line %d: bad record\n", ln );
+            return -1;
+        }
+        for( i = 0, sum = 0; i < n + 5; i++ )
+        {
+            b = Hex_Byte( line + 1 + 2 * i );
+            if( b < 0 )
+            {
+                fprintf( stderr, "hex line %d: bad digit\n", ln );
+                return -1;
+            }
+            rec[ i ] = b;
+            sum += b;
+        }
+        if( sum & 0xFF )
+        {
+            fprintf( stderr, "hex line %d: checksum\n", ln );
+            return -1;
+        }
+
+        switch( rec[ 3 ] )
+        {
+            case 0x00:
+                if( Image_Put( pimg, base + ( rec[ 1 ] << 8 | rec[ 2 ] ), rec + 4, n ) )
+                {
+                    fprintf( stderr, "hex line %d: %08x is outside %08x-%08x\n", ln,
+                             base + ( rec[ 1 ] << 8 | rec[ 2 ] ), APP_BASE, APP_END );
+                    return -1;
+                }
+                break;
+            case 0x01:
+                return 0;
+            case 0x02:
+                base = (uint32_t)( rec[ 4 ] << 8 | rec[ 5 ] ) << 4;
+                break;
+            case 0x04:
+                base = (uint32_t)( rec[ 4 ] << 8 | rec[ 5 ] ) << 16;
+                break;
+            case 0x03:
+            case 0x05:
+                break;
+            default:
+                fprintf( stderr, "hex line %d: record type %02x\n", ln, rec[ 3 ] );
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Load_Image
+ *
+ * @brief   Read a .hex file, or any other file as raw binary at base.
+ *
+ * @return  0 - ok, -1 - error
+ */
+static int Load_Image( const char *pname, uint32_t base, IMAGE *pimg )
+{
+    const char *ext = strrchr( pname, '.' );
+    uint8_t buf[ 4096 ];
+    FILE *f;
+    size_t n;
+    int r = 0;
+
+    f = fopen( pname, ( ext && !strcasecmp( ext, ".hex" ) ) ? "r" : "rb" );
+    if( f == NULL )
+    {
+        perror( pname );
+        return -1;
+    }
+    if( ext && !strcasecmp( ext, ".hex" ) )
+    {
+        r = Load_Hex( f, pimg );
+    }
+    else
+    {
+        while( ( r == 0 ) && ( n = fread( buf, 1, sizeof( buf ), f ) ) )
+        {
+            if( Image_Put( pimg, base, buf, n ) )
+            {
+                fprintf( stderr, "%s: does not fit in %08x-%08x\n", pname, APP_BASE, APP_END );
+                r = -1;
+            }
+            base += n;
+        }
+    }
+    fclose( f );
+    if( ( r == 0 ) && ( pimg->Len == 0 ) )
+    {
+        fprintf( stderr, "%s: no data\n", pname );
+        r = -1;
+    }
+    return r;
+}
+
+/*********************************************************************
+ * @fn      Run_Cmds
+ *
+ * @brief   Send n commands made by pmake, keeping up to Window of them
+ *          unanswered, and check the replies in order.
+ *
+ * @param   pmake - builds command i into a packet, returns its length
+ *
+ * @return  0 - all answered ok, -1 - error reply or timeout
+ */
+static int Run_Cmds( IAP_LINK *plink, PHASE *pph, uint32_t n,
+                     int ( *pmake )( const IMAGE *pimg, uint32_t i, uint8_t *pcmd ),
+                     const IMAGE *pimg )
+{
+    uint8_t cmd[ IAP_USB_PKT ];
+    uint32_t sent = 0, done = 0;
+    int w = ( Window < plink->Window_Max ) ? Window : plink->Window_Max;
+    int len, r;
+    double t = Now_Ms( );
+
+    while( done < n )
+    {
+        while( ( sent < n ) && ( sent - done < (uint32_t)w ) )
+        {
+            len = pmake( pimg, sent, cmd );
+            if( plink->Send( plink, cmd, len ) )
+            {
+                fprintf( stderr, "%s: send failed at command %u\n", pph->Name, sent );
+                return -1;
+            }
+            sent++;
+        }
+        r = plink->Recv( plink, REPLY_TIMEOUT_MS );
+        if( r != IAP_REPLY_OK )
+        {
+            fprintf( stderr, "%s: %s at command %u\n", pph->Name,
+                     ( r == IAP_REPLY_TIMEOUT ) ? "no reply" : "error reply", done );
+            return -1;
+        }
+        done++;
+    }
+    pph->Cmds += n;
+    pph->Ms += Now_Ms( ) - t;
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Make_Erase
+ *
+ * @brief   CMD_IAP_ERASE, the address field carries the image length.
+ *
+ * @return  packet length
+ */
+static int Make_Erase( const IMAGE *pimg, uint32_t i, uint8_t *pcmd )
+{
+    pcmd[ 0 ] = CMD_IAP_ERASE;
+    pcmd[ 1 ] = 0;
+    pcmd[ 2 ] = (uint8_t)pimg->Len;
+    pcmd[ 3 ] = (uint8_t)( pimg->Len >> 8 );
+    pcmd[ 4 ] = (uint8_t)( pimg->Len >> 16 );
+    pcmd[ 5 ] = (uint8_t)( pimg->Len >> 24 );
+    return 6;
+}
+
+/*********************************************************************
+ * @fn      Make_Prom
+ *
+ * @brief   CMD_IAP_PROM with the i-th piece of code, packed or not.
+ *
+ * @return  packet length
+ */
+static int Make_Prom( const IMAGE *pimg, uint32_t i, uint8_t *pcmd )
+{
+    uint32_t off = i * IAP_PROM_LEN;
+    uint32_t n = ( pimg->Send_Len - off < IAP_PROM_LEN ) ? pimg->Send_Len - off : IAP_PROM_LEN;
+
+    pcmd[ 0 ] = CMD_IAP_PROM;
+    pcmd[ 1 ] = n;
+    memcpy( pcmd + 2, pimg->pSend + off, n );
+    return 2 + n;
+}
+
+/*********************************************************************
+ * @fn      Make_Verify
+ *
+ * @brief   CMD_IAP_VERIFY with the i-th piece of code. The bootloader
+ *          compares in order, the address is for the reader of a trace.
+ *
+ * @return  packet length
+ */
+static int Make_Verify( const IMAGE *pimg, uint32_t i, uint8_t *pcmd )
+{
+    uint32_t off = i * IAP_VERIFY_LEN;
+    uint32_t n = ( pimg->Len - off < IAP_VERIFY_LEN ) ? pimg->Len - off : IAP_VERIFY_LEN;
+    uint32_t addr = pimg->Addr + off;
+
+    pcmd[ 0 ] = CMD_IAP_VERIFY;
+    pcmd[ 1 ] = n;
+    pcmd[ 2 ] = (uint8_t)addr;
+    pcmd[ 3 ] = (uint8_t)( addr >> 8 );
+    pcmd[ 4 ] = (uint8_t)( addr >> 16 );
+    pcmd[ 5 ] = (uint8_t)( addr >> 24 );
+    memcpy( pcmd + 6, pimg->pBuf + off, n );
+    return 6 + n;
+}
+
+/*********************************************************************
+ * @fn      Make_Check
+ *
+ * @brief   Empty CMD_IAP_VERIFY: the bootloader checks the image against
+ *          the CRC32 of its header.
+ *
+ * @return  packet length
+ */
+static int Make_Check( const IMAGE *pimg, uint32_t i, uint8_t *pcmd )
+{
+    memset( pcmd, 0, 6 );
+    pcmd[ 0 ] = CMD_IAP_VERIFY;
+    return 6;
+}
+
+/*********************************************************************
+ * @fn      Pack_Image
+ *
+ * @brief   Choose what to send: a packed or delta file as it is, the
+ *          image packed with -z when that is shorter, or the image after
+ *          the IAP_IMAGE header unless legacy is set.
+ *
+ * @return  none
+ */
+static void Pack_Image( IMAGE *pimg, int pack, int legacy )
+{
+    uint8_t *pz;
+    uint32_t zlen, crc, i;
+
+    pimg->pSend = pimg->pBuf;
+    pimg->Send_Len = pimg->Len;
+    if( IAP_LZ_Check( pimg->pBuf, pimg->Len ) || IAP_Delta_Check( pimg->pBuf, pimg->Len ) )
+    {
+        /* Decoded length from the header, after the old one in a delta */
+        i = IAP_LZ_Check( pimg->pBuf, pimg->Len ) ? 4 : 8;
+        pimg->Packed = 1;
+        pimg->Crc_Check = 1;
+        pimg->Len = pimg->pBuf[ i ] | pimg->pBuf[ i + 1 ] << 8 | pimg->pBuf[ i + 2 ] << 16 | (uint32_t)pimg->pBuf[ i + 3 ] << 24;
+        return;
+    }
+    if( pack )
+    {
+        pz = malloc( IAP_LZ_PACK_MAX( pimg->Len ) );
+        zlen = IAP_LZ_Pack( pimg->pBuf, pimg->Len, pz );
+        if( zlen < pimg->Len )
+        {
+            pimg->pSend = pz;
+            pimg->Send_Len = zlen;
+            pimg->Packed = 1;
+            pimg->Crc_Check = 1;
+            return;
+        }
+        free( pz );
+    }
+    if( !legacy )
+    {
+        pz = malloc( IAP_IMAGE_HEAD_LEN + pimg->Len );
+        crc = IAP_LZ_Crc32( 0, pimg->pBuf, pimg->Len );
+        for( i = 0; i < 4; i++ )
+        {
+            pz[ i ] = (uint8_t)( IAP_IMAGE_MAGIC >> ( 8 * i ) );
+            pz[ 4 + i ] = (uint8_t)( pimg->Len >> ( 8 * i ) );
+            pz[ 8 + i ] = (uint8_t)( crc >> ( 8 * i ) );
+        }
+        memcpy( pz + IAP_IMAGE_HEAD_LEN, pimg->pBuf, pimg->Len );
+        pimg->pSend = pz;
+        pimg->Send_Len = IAP_IMAGE_HEAD_LEN + pimg->Len;
+        pimg->Crc_Check = 1;
+    }
+}
+
+/*********************************************************************
+ * @fn      Make_Jump
+ *
+ * @brief   CMD_JUMP_IAP for CH643_APP.
+ *
+ * @return  packet length
+ */
+static int Make_Jump( const IMAGE *pimg, uint32_t i, uint8_t *pcmd )
+{
+    pcmd[ 0 ] = CMD_JUMP_IAP;
+    pcmd[ 1 ] = 0;
+    return 2;
+}
+
+/*********************************************************************
+ * @fn      Open_Link
+ *
+ * @brief   Open the transport named by -p.
+ *
+ * @return  link, NULL on error
+ */
+static IAP_LINK *Open_Link( const char *pport, int baud, int wait_ms )
+{
+    if( !strcmp( pport, "usb" ) )
+    {
+        return IAP_USB_Open( wait_ms );
+    }
+#ifdef IAP_SIM
+    if( !strcmp( pport, "sim" ) )
+    {
+        return IAP_Sim_Open( 0 );
+    }
+    if( !strcmp( pport, "sim-uart" ) )
+    {
+        return IAP_Sim_Open( 1 );
+    }
+#endif
+    return IAP_UART_Open( pport, baud );
+}
+
+/*********************************************************************
+ * @fn      Print_Phase
+ *
+ * @brief   Time and rate of one phase.
+ *
+ * @return  none
+ */
+static void Print_Phase( const PHASE *pph, uint32_t code )
+{
+    printf( "%-8s %6u cmds %9.1f ms", pph->Name, pph->Cmds, pph->Ms );
+    if( code && ( pph->Ms > 0 ) )
+    {
+        printf( " %8.1f KB/s", code / pph->Ms * 1000.0 / 1024.0 );
+    }
+    printf( "\n" );
+}
+
+int main( int argc, char **argv )
+{
+    PHASE erase = { "erase" }, prog = { "program" }, verify = { "verify" }, end = { "end" };
+    IMAGE img = { 0 };
+    IAP_LINK *plink;
+    const char *port = "usb";
+    uint32_t base = APP_BASE;
+    uint8_t cmd[ 2 ] = { CMD_IAP_END, 0 };
+    int baud = IAP_UART_BAUD, jump = 0, no_verify = 0, pack = 0, legacy = 0, c, r = 0;
+    double t;
+
+    while( ( c = getopt( argc, argv, "p:b:w:B:jnzlth" ) ) != -1 )
+    {
+        switch( c )
+        {
+#ifdef IAP_SIM
+            case 't': return IAP_Sim_Test( ) ? 1 : 0;
+#endif
+            case 'p': port = optarg; break;
+            case 'b': baud = atoi( optarg ); break;
+            case 'w': Window = atoi( optarg ); break;
+            case 'B': base = strtoul( optarg, NULL, 0 ); break;
+            case 'j': jump = 1; break;
+            case 'n': no_verify = 1; break;
+            case 'z': pack = 1; break;
+            case 'l': legacy = 1; break;
+            default:
+                fprintf( stderr, "usage: %s [-p usb|/dev/ttyUSBx] [-b baud] [-w window] [-B base] [-j] [-n] [-z] [-l] app.hex|app.bin\n", argv[ 0 ] );
+                return 2;
+        }
+    }
+    if( ( optind != argc - 1 ) || ( Window < 1 ) )
+    {
+        fprintf( stderr, "usage: %s [-p usb|/dev/ttyUSBx] [-b baud] [-w window] [-B base] [-j] [-n] [-z] [-l] app.hex|app.bin\n", argv[ 0 ] );
+        return 2;
+    }
+    if( Load_Image( argv[ optind ], base, &img ) )
+    {
+        return 1;
+    }
+    Pack_Image( &img, pack, legacy );
+    printf( "%s: %u bytes at %08x", argv[ optind ], img.Len, img.Addr );
+    if( img.Packed )
+    {
+        printf( ", %u packed", img.Send_Len );
+    }
+    printf( "\n" );
+
+    if( jump )
+    {
+        PHASE ph = { "jump" };
+
+        plink = Open_Link( port, baud, 0 );
+        if( ( plink == NULL ) || Run_Cmds( plink, &ph, 1, Make_Jump, &img ) )
+        {
+            return 1;
+        }
+        plink->Close( plink );
+        usleep( 200000 );
+    }
+
+    plink = Open_Link( port, baud, jump ? 5000 : 0 );
+    if( plink == NULL )
+    {
+        return 1;
+    }
+    printf( "%s, window %d\n", plink->Name, ( Window < plink->Window_Max ) ? Window : plink->Window_Max );
+
+    if( Run_Cmds( plink, &erase, 1, Make_Erase, &img ) ||
+        Run_Cmds( plink, &prog, ( img.Send_Len + IAP_PROM_LEN - 1 ) / IAP_PROM_LEN, Make_Prom, &img ) ||
+        ( !no_verify && !img.Crc_Check && Run_Cmds( plink, &verify, ( img.Len + IAP_VERIFY_LEN - 1 ) / IAP_VERIFY_LEN, Make_Verify, &img ) ) ||
+        ( !no_verify && img.Crc_Check && Run_Cmds( plink, &verify, 1, Make_Check, &img ) ) )
+    {
+        r = 1;
+    }
+    else
+    {
+        /* Not answered: the bootloader starts the application */
+        t = Now_Ms( );
+        r = plink->Send( plink, cmd, 2 ) ? 1 : 0;
+        plink->Close( plink );
+        plink = NULL;
+        end.Cmds = 1;
+        end.Ms = Now_Ms( ) - t;
+    }
+    if( plink )
+    {
+        plink->Close( plink );
+    }
+
+    Print_Phase( &erase, 0 );
+    Print_Phase( &prog, img.Len );
+    if( !no_verify )
+    {
+        /* A single empty verify sends no code, so it has no rate */
+        Print_Phase( &verify, img.Crc_Check ? 0 : img.Len );
+    }
+    Print_Phase( &end, 0 );
+    printf( "%s\n", r ? "FAILED" : "done" );
+    if( img.pSend != img.pBuf )
+    {
+        free( img.pSend );
+    }
+    free( img.pBuf );
+    return r;
+}
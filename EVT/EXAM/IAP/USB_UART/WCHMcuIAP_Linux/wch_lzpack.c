@@ -0,0 +1,222 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : wch_lzpack.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Packer of compressed IAP images for CH643_IAP and
+ *                      HOST_IAP.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * Compresses an application .bin so that it is decoded by the bootloader
+ * while it is programmed. Every image packed is decoded again with the
+ * bootloader's iap_lz.c before it is written out.
+ *
+ * Build:
+ *   gcc -O2 -I../CH643_IAP/User -o wch_lzpack wch_lzpack.c iap_lzpack.c
+ *       ../CH643_IAP/User/iap_lz.c
+ *
+ * Usage:
+ *   wch_lzpack app.bin app_z.bin   pack, e.g. for wch_iap or as APP.BIN on
+ *                                  the U-disk of HOST_IAP
+ *   wch_lzpack -d app_z.bin app.bin unpack
+ *   wch_lzpack -t                   round trip of built-in test images,
+ *                                  damaged ones included
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "iap_lz.h"
+#include "iap_lzpack.h"
+
+/* Largest image of CH643_IAP */
+#define PACK_MAX_IMAGE      0x10000
+
+/*********************************************************************
+ * @fn      Read_File
+ *
+ * @brief   Read a whole file.
+ *
+ * @return  length, -1 on error
+ */
+static long Read_File( const char *pname, uint8_t *pbuf, long max )
+{
+    FILE *f = fopen( pname, "rb" );
+    long n;
+
+    if( f == NULL )
+    {
+        perror( pname );
+        return -1;
+    }
+    n = fread( pbuf, 1, max, f );
+    if( fgetc( f ) != EOF )
+    {
+        fprintf( stderr, "%s: larger than %ld bytes\n", pname, max );
+        n = -1;
+    }
+    fclose( f );
+    return n;
+}
+
+/*********************************************************************
+ * @fn      Write_File
+ *
+ * @brief   Write a whole file.
+ *
+ * @return  0 - ok, -1 on error
+ */
+static int Write_File( const char *pname, const uint8_t *pbuf, long len )
+{
+    FILE *f = fopen( pname, "wb" );
+
+    if( ( f == NULL ) || ( fwrite( pbuf, 1, len, f ) != (size_t)len ) || fclose( f ) )
+    {
+        perror( pname );
+        return -1;
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Round_Trip
+ *
+ * @brief   Pack, unpack several times with different pieces and compare.
+ *          Then damage the packed data: it must be refused, unless the
+ *          bit hit does not change the image (a flag past the end).
+ *
+ * @return  packed length, 0 if a check failed
+ */
+static uint32_t Round_Trip( const char *pname, const uint8_t *pin, uint32_t len, int damage )
+{
+    static uint8_t z[ IAP_LZ_PACK_MAX( PACK_MAX_IMAGE ) ], out[ PACK_MAX_IMAGE ];
+    uint32_t zlen = IAP_LZ_Pack( pin, len, z );
+    int i, n, pos;
+    uint8_t bit;
+
+    for( i = 0; i < 8; i++ )
+    {
+        n = IAP_LZ_Unpack( z, zlen, out, sizeof( out ) );
+        if( ( n != (int)len ) || memcmp( out, pin, len ) )
+        {
+            fprintf( stderr, "%s: round trip failed (%d of %u bytes)\n", pname, n, len );
+            return 0;
+        }
+    }
+    for( i = 0; damage && ( i < 200 ) && ( zlen > IAP_LZ_HEAD_LEN ); i++ )
+    {
+        pos = IAP_LZ_HEAD_LEN + rand( ) % ( zlen - IAP_LZ_HEAD_LEN );
+        bit = 1 << ( rand( ) % 8 );
+        z[ pos ] ^= bit;
+        n = IAP_LZ_Unpack( z, zlen - ( i & 1 ), out, sizeof( out ) );
+        z[ pos ] ^= bit;
+        if( ( n >= 0 ) && ( ( n != (int)len ) || memcmp( out, pin, len ) ) )
+        {
+            fprintf( stderr, "%s: damage at %d not detected\n", pname, pos );
+            return 0;
+        }
+    }
+    return zlen;
+}
+
+/*********************************************************************
+ * @fn      Self_Test
+ *
+ * @brief   Round trip of synthetic images shaped like code, constant
+ *          fill, text and noise.
+ *
+ * @return  0 - passed, 1 - failed
+ */
+static int Self_Test( void )
+{
+    static uint8_t img[ PACK_MAX_IMAGE ];
+    static const uint32_t sizes[ ] = { 0, 1, 2, 3, 130, 131, 511, 512, 513, 4096, 30001, 42752 };
+    const char *name[ ] = { "code", "fill", "text", "noise" };
+    uint32_t s, k, i, zlen;
+    int fail = 0;
+
+    srand( 1 );
+    for( k = 0; k < 4; k++ )
+    {
+        for( s = 0; s < sizeof( sizes ) / sizeof( sizes[ 0 ] ); s++ )
+        {
+            for( i = 0; i < sizes[ s ]; i++ )
+            {
+                switch( k )
+                {
+                    /* Runs copied from nearby code, mixed with new bytes */
+                    case 0: img[ i ] = ( ( i > 64 ) && ( rand( ) % 8 ) ) ? img[ i - 4 * ( 1 + ( i / 16 ) % 16 ) ] : rand( ); break;
+                    case 1: img[ i ] = ( i < sizes[ s ] / 2 ) ? 0x00 : 0xFF; break;
+                    case 2: img[ i ] = "printf(\"IAP %d\\r\\n\", i);\n"[ i % 26 ] + ( i / 997 ) % 3; break;
+                    default: img[ i ] = rand( ); break;
+                }
+            }
+            zlen = Round_Trip( name[ k ], img, sizes[ s ], 1 );
+            if( ( zlen == 0 ) && sizes[ s ] )
+            {
+                fail = 1;
+            }
+            printf( "%-6s %6u -> %6u bytes %s\n", name[ k ], sizes[ s ], zlen, zlen ? "ok" : "FAILED" );
+        }
+    }
+    printf( "%s\n", fail ? "FAILED" : "all passed" );
+    return fail;
+}
+
+int main( int argc, char **argv )
+{
+    static uint8_t in[ IAP_LZ_PACK_MAX( PACK_MAX_IMAGE ) ], out[ IAP_LZ_PACK_MAX( PACK_MAX_IMAGE ) ];
+    long len;
+    uint32_t zlen;
+    int n;
+
+    if( ( argc == 2 ) && !strcmp( argv[ 1 ], "-t" ) )
+    {
+        return Self_Test( );
+    }
+    if( ( argc == 4 ) && !strcmp( argv[ 1 ], "-d" ) )
+    {
+        len = Read_File( argv[ 2 ], in, sizeof( in ) );
+        if( len < 0 )
+        {
+            return 1;
+        }
+        n = IAP_LZ_Unpack( in, len, out, PACK_MAX_IMAGE );
+        if( n < 0 )
+        {
+            fprintf( stderr, "%s: not a valid packed image\n", argv[ 2 ] );
+            return 1;
+        }
+        return Write_File( argv[ 3 ], out, n ) ? 1 : 0;
+    }
+    if( argc != 3 )
+    {
+        fprintf( stderr, "usage: %s app.bin packed.bin | -d packed.bin app.bin | -t\n", argv[ 0 ] );
+        return 2;
+    }
+
+    len = Read_File( argv[ 1 ], in, PACK_MAX_IMAGE );
+    if( len < 0 )
+    {
+        return 1;
+    }
+    if( IAP_LZ_Check( in, len ) )
+    {
+        fprintf( stderr, "%s: already packed\n", argv[ 1 ] );
+        return 1;
+    }
+    zlen = Round_Trip( argv[ 1 ], in, len, 0 );
+    if( zlen == 0 )
+    {
+        return 1;
+    }
+    IAP_LZ_Pack( in, len, out );
+    printf( "%s: %ld -> %u bytes (%.1f%%)\n", argv[ 2 ], len, zlen, len ? 100.0 * zlen / len : 0.0 );
+    return Write_File( argv[ 2 ], out, zlen ) ? 1 : 0;
+}
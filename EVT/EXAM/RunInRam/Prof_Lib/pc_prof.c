@@ -0,0 +1,184 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : pc_prof.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : PC-sampling profiler. TIM3 interrupts the program at
+ *                      a fixed rate and counts where it was (mepc) in a
+ *                      histogram of the flash, PC_Prof_Dump prints it for
+ *                      RunInRAM_Profile/Tool/hot_code.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#include "debug.h"
+#include "pc_prof.h"
+#include <string.h>
+
+PC_PROF Pc_Prof;
+
+/* Start of the code copied to RAM, Link.ld */
+extern uint8_t _highcode_vma_start[ ];
+
+/* Priorities of the other interrupts while sampling, bit 7 is the
+ * preemption priority with NVIC_PriorityGroup_1 */
+static uint8_t Pc_Prof_Prior[ TIM3_IRQn ];
+
+void TIM3_IRQHandler( void ) __attribute__( ( interrupt( "WCH-Interrupt-fast" ) ) );
+
+/*********************************************************************
+ * @fn      PC_Prof_Count
+ *
+ * @brief   Count one sample in a bucket, the count stops at 0xFFFF.
+ *
+ * @return  none
+ */
+static void PC_Prof_Count( uint16_t *p )
+{
+    if( *p != 0xFFFF )
+    {
+        ( *p )++;
+    }
+}
+
+/*********************************************************************
+ * @fn      TIM3_IRQHandler
+ *
+ * @brief   Take one sample. While sampling, TIM3 is the only interrupt
+ *          with preemption priority 0, so the code of other interrupts
+ *          is sampled too.
+ *
+ * @return  none
+ */
+void TIM3_IRQHandler( void )
+{
+    uint32_t pc, ram;
+
+    pc = __get_MEPC( );
+    ram = pc - (uint32_t)_highcode_vma_start;
+    if( pc < PC_PROF_FLASH_SIZE )
+    {
+        PC_Prof_Count( &Pc_Prof.Hist[ pc >> PC_PROF_SHIFT ] );
+    }
+    else if( ram < PC_PROF_RAM_SIZE )
+    {
+        PC_Prof_Count( &Pc_Prof.Ram_Hist[ ram >> PC_PROF_SHIFT ] );
+    }
+    else
+    {
+        Pc_Prof.Other++;
+    }
+    Pc_Prof.Total++;
+
+    TIM_ClearITPendingBit( TIM3, TIM_IT_Update );
+}
+
+/*********************************************************************
+ * @fn      PC_Prof_Init
+ *
+ * @brief   Set TIM3 to interrupt every PC_PROF_PERIOD uS, at preemption
+ *          priority 0, and clear the histogram. The timer clock is taken
+ *          to be HCLK. Needs NVIC_PriorityGroup_1 and interrupt nesting.
+ *
+ * @return  none
+ */
+void PC_Prof_Init( void )
+{
+    NVIC_InitTypeDef NVIC_InitStructure = {0};
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseInitStructure = {0};
+
+    memset( &Pc_Prof, 0, sizeof( Pc_Prof ) );
+
+    RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM3, ENABLE );
+
+    TIM_TimeBaseInitStructure.TIM_Period = PC_PROF_PERIOD - 1;
+    TIM_TimeBaseInitStructure.TIM_Prescaler = SystemCoreClock / 1000000 - 1;
+    TIM_TimeBaseInitStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseInitStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseInit( TIM3, &TIM_TimeBaseInitStructure );
+    TIM_ClearITPendingBit( TIM3, TIM_IT_Update );
+
+    NVIC_InitStructure.NVIC_IRQChannel = TIM3_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init( &NVIC_InitStructure );
+
+    TIM_ITConfig( TIM3, TIM_IT_Update, ENABLE );
+}
+
+/*********************************************************************
+ * @fn      PC_Prof_Start
+ *
+ * @brief   Start sampling, the histogram keeps counting from where
+ *          PC_Prof_Stop left it. Every other interrupt from SysTick on is
+ *          moved to preemption priority 1, keeping its subpriority, so
+ *          that TIM3 preempts it; an interrupt set up with NVIC_Init after
+ *          this is not moved.
+ *
+ * @return  none
+ */
+void PC_Prof_Start( void )
+{
+    uint32_t i;
+
+    for( i = SysTick_IRQn; i < TIM3_IRQn; i++ )
+    {
+        Pc_Prof_Prior[ i ] = NVIC->IPRIOR[ i ];
+        NVIC_SetPriority( (IRQn_Type)i, Pc_Prof_Prior[ i ] | 0x80 );
+    }
+    TIM_Cmd( TIM3, ENABLE );
+}
+
+/*********************************************************************
+ * @fn      PC_Prof_Stop
+ *
+ * @brief   Stop sampling and give the other interrupts back their
+ *          priorities.
+ *
+ * @return  none
+ */
+void PC_Prof_Stop( void )
+{
+    uint32_t i;
+
+    TIM_Cmd( TIM3, DISABLE );
+    for( i = SysTick_IRQn; i < TIM3_IRQn; i++ )
+    {
+        NVIC_SetPriority( (IRQn_Type)i, Pc_Prof_Prior[ i ] );
+    }
+}
+
+/*********************************************************************
+ * @fn      PC_Prof_Dump
+ *
+ * @brief   Print the histogram for RunInRAM_Profile/Tool/hot_code:
+ *            PCPROF <shift> <total> <other>
+ *            <bucket address, hex> <samples>    - one line per bucket hit
+ *            PCPROF END
+ *          Other lines of the log are skipped by the tool.
+ *
+ * @return  none
+ */
+void PC_Prof_Dump( void )
+{
+    uint32_t i;
+
+    printf( "PCPROF %d %d %d\r\n", PC_PROF_SHIFT, Pc_Prof.Total, Pc_Prof.Other );
+    for( i = 0; i < PC_PROF_BUCKETS; i++ )
+    {
+        if( Pc_Prof.Hist[ i ] )
+        {
+            printf( "%08x %d\r\n", i << PC_PROF_SHIFT, Pc_Prof.Hist[ i ] );
+        }
+    }
+    for( i = 0; i < PC_PROF_RAM_BUCKETS; i++ )
+    {
+        if( Pc_Prof.Ram_Hist[ i ] )
+        {
+            printf( "%08x %d\r\n", (uint32_t)_highcode_vma_start + ( i << PC_PROF_SHIFT ), Pc_Prof.Ram_Hist[ i ] );
+        }
+    }
+    printf( "PCPROF END\r\n" );
+}
@@ -0,0 +1,54 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : pc_prof.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : PC-sampling profiler, finds the functions worth
+ *                      running from RAM.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#ifndef __PC_PROF_H
+#define __PC_PROF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Code is linked from 0, each bucket counts the samples of 1 << PC_PROF_SHIFT bytes */
+#define PC_PROF_FLASH_SIZE    ( 62 * 1024 )
+#define PC_PROF_SHIFT         5
+#define PC_PROF_BUCKETS       ( PC_PROF_FLASH_SIZE >> PC_PROF_SHIFT )
+
+/* Code in RAM from _highcode_vma_start, __highcode_size of Link.ld */
+#define PC_PROF_RAM_SIZE      4096
+#define PC_PROF_RAM_BUCKETS   ( PC_PROF_RAM_SIZE >> PC_PROF_SHIFT )
+
+/* Sample period in timer clocks of 1MHz, not a round number so that
+ * the samples do not lock onto a loop running at a round period */
+#define PC_PROF_PERIOD        97
+
+typedef struct _PC_PROF
+{
+    uint16_t Hist[ PC_PROF_BUCKETS ];
+    uint16_t Ram_Hist[ PC_PROF_RAM_BUCKETS ];
+    uint32_t Total;
+    uint32_t Other;                                       // Samples out of both
+} PC_PROF;
+
+extern PC_PROF Pc_Prof;
+
+extern void PC_Prof_Init( void );
+extern void PC_Prof_Start( void );
+extern void PC_Prof_Stop( void );
+extern void PC_Prof_Dump( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,263 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : hot_code.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Picks the functions to run from RAM out of a
+ *                      PC_Prof_Dump log and writes them as Ld/hot_code.ld.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * The samples of each bucket are shared out over the functions of the
+ * symbol table by the bytes they cover. Functions are then taken by
+ * samples per byte, the best first, as long as they fit the budget and
+ * hold at least the minimum share of the samples.
+ * Link.ld includes the output in .highcode, so a function is moved by
+ * the name of its section, .text.<name> of -ffunction-sections. Functions
+ * of assembly files and of libraries have no such section: the linker
+ * leaves them in flash, though they are counted in the budget.
+ *
+ * Build:
+ *   gcc -O2 -o hot_code hot_code.c
+ *
+ * Usage:
+ *   riscv-none-embed-nm -S --defined-only obj/RunInRAM_Profile.elf > syms.txt
+ *   hot_code [-b bytes] [-m permille] syms.txt prof.log > ../Ld/hot_code.ld
+ *     -b  bytes for the functions, __highcode_size of Link.ld less the
+ *         code put in .highcode by hand, 4096 by default
+ *     -m  least share of the samples a function needs, 1/1000, 5 by default
+ *   prof.log is the serial log of the profiled run, other lines included.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define HOT_MAX_FUNC        4096
+#define HOT_NAME_LEN        128
+
+/* Code the startup code calls with jal, which does not reach RAM */
+static const char *Hot_Keep[ ] = { "SystemInit" };
+
+typedef struct _HOT_FUNC
+{
+    char     Name[ HOT_NAME_LEN ];
+    uint32_t Addr;
+    uint32_t Size;
+    double   Samples;
+    int      Take;
+} HOT_FUNC;
+
+static HOT_FUNC Func[ HOT_MAX_FUNC ];
+static HOT_FUNC *Order[ HOT_MAX_FUNC ];
+static int Func_Num;
+
+/*********************************************************************
+ * @fn      Read_Syms
+ *
+ * @brief   Read the functions of "nm -S" output: address, size, type
+ *          and name. Symbols without a size and aliases of a function
+ *          already read are skipped.
+ *
+ * @return  0 - ok, -1 on error
+ */
+static int Read_Syms( const char *pname )
+{
+    FILE *f = fopen( pname, "r" );
+    char line[ 256 ], type, name[ HOT_NAME_LEN ];
+    unsigned long addr, size;
+    int i;
+
+    if( f == NULL )
+    {
+        perror( pname );
+        return -1;
+    }
+    while( fgets( line, sizeof( line ), f ) )
+    {
+        if( ( sscanf( line, "%lx %lx %c %127s", &addr, &size, &type, name ) != 4 ) || ( size == 0 ) )
+        {
+            continue;
+        }
+        if( ( type != 't' ) && ( type != 'T' ) && ( type != 'w' ) && ( type != 'W' ) )
+        {
+            continue;
+        }
+        for( i = 0; ( i < Func_Num ) && ( Func[ i ].Addr != addr ); i++ )
+        {
+        }
+        if( i < Func_Num )
+        {
+            continue;
+        }
+        if( Func_Num == HOT_MAX_FUNC )
+        {
+            fprintf( stderr, "%s: more than %d functions\n", pname, HOT_MAX_FUNC );
+            fclose( f );
+            return -1;
+        }
+        strcpy( Func[ Func_Num ].Name, name );
+        Func[ Func_Num ].Addr = addr;
+        Func[ Func_Num ].Size = size;
+        Func_Num++;
+    }
+    fclose( f );
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Read_Prof
+ *
+ * @brief   Find the histogram in a serial log and share the samples of
+ *          each bucket out over the functions it overlaps.
+ *
+ * @return  samples in the histogram, -1 on error
+ */
+static long Read_Prof( const char *pname, long *ptotal )
+{
+    FILE *f = fopen( pname, "r" );
+    char line[ 256 ];
+    unsigned long addr, cnt, total, other, lo, hi;
+    long sum = -1;
+    int shift = 0, i;
+
+    if( f == NULL )
+    {
+        perror( pname );
+        return -1;
+    }
+    while( fgets( line, sizeof( line ), f ) )
+    {
+        if( sum < 0 )
+        {
+            if( sscanf( line, "PCPROF %d %lu %lu", &shift, &total, &other ) == 3 )
+            {
+                *ptotal = total;
+                sum = 0;
+            }
+            continue;
+        }
+        if( !strncmp( line, "PCPROF END", 10 ) )
+        {
+            break;
+        }
+        if( sscanf( line, "%lx %lu", &addr, &cnt ) != 2 )
+        {
+            continue;
+        }
+        sum += cnt;
+        for( i = 0; i < Func_Num; i++ )
+        {
+            lo = ( Func[ i ].Addr > addr ) ? Func[ i ].Addr : addr;
+            hi = ( Func[ i ].Addr + Func[ i ].Size < addr + ( 1UL << shift ) ) ? Func[ i ].Addr + Func[ i ].Size : addr + ( 1UL << shift );
+            if( lo < hi )
+            {
+                Func[ i ].Samples += (double)cnt * ( hi - lo ) / ( 1UL << shift );
+            }
+        }
+    }
+    fclose( f );
+    if( sum < 0 )
+    {
+        fprintf( stderr, "%s: no PCPROF histogram\n", pname );
+    }
+    return sum;
+}
+
+/*********************************************************************
+ * @fn      Cmp_Density
+ *
+ * @brief   Order by samples per byte, the most first.
+ */
+static int Cmp_Density( const void *pa, const void *pb )
+{
+    const HOT_FUNC *a = *(HOT_FUNC * const *)pa, *b = *(HOT_FUNC * const *)pb;
+    double da = a->Samples / a->Size, db = b->Samples / b->Size;
+
+    return ( da < db ) ? 1 : ( da > db ) ? -1 : strcmp( a->Name, b->Name );
+}
+
+int main( int argc, char **argv )
+{
+    unsigned long budget = 4096, permille = 5, used = 0, size;
+    long sum, total = 0;
+    double taken = 0;
+    int i, k, keep;
+
+    while( ( argc > 2 ) && ( argv[ 1 ][ 0 ] == '-' ) )
+    {
+        if( !strcmp( argv[ 1 ], "-b" ) )
+        {
+            budget = strtoul( argv[ 2 ], NULL, 0 );
+        }
+        else if( !strcmp( argv[ 1 ], "-m" ) )
+        {
+            permille = strtoul( argv[ 2 ], NULL, 0 );
+        }
+        else
+        {
+            break;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+    if( argc != 3 )
+    {
+        fprintf( stderr, "usage: %s [-b bytes] [-m permille] syms.txt prof.log\n", argv[ 0 ] );
+        return 1;
+    }
+    if( Read_Syms( argv[ 1 ] ) || ( ( sum = Read_Prof( argv[ 2 ], &total ) ) < 0 ) )
+    {
+        return 1;
+    }
+    if( sum == 0 )
+    {
+        fprintf( stderr, "%s: no samples\n", argv[ 2 ] );
+        return 1;
+    }
+
+    for( i = 0; i < Func_Num; i++ )
+    {
+        Order[ i ] = &Func[ i ];
+    }
+    qsort( Order, Func_Num, sizeof( Order[ 0 ] ), Cmp_Density );
+
+    /* Sizes rounded up to 4 bytes for the alignment of the functions */
+    for( i = 0; i < Func_Num; i++ )
+    {
+        for( k = 0, keep = 0; k < (int)( sizeof( Hot_Keep ) / sizeof( Hot_Keep[ 0 ] ) ); k++ )
+        {
+            keep |= !strcmp( Order[ i ]->Name, Hot_Keep[ k ] );
+        }
+        size = ( Order[ i ]->Size + 3 ) & ~3UL;
+        if( keep || ( Order[ i ]->Samples * 1000 < (double)sum * permille ) || ( used + size > budget ) )
+        {
+            continue;
+        }
+        Order[ i ]->Take = 1;
+        used += size;
+        taken += Order[ i ]->Samples;
+    }
+
+    printf( "/*\n" );
+    printf( " * Hot functions of %s, made by hot_code: %lu of %lu bytes,\n", argv[ 2 ], used, budget );
+    printf( " * %.1f%% of %ld samples (%ld taken in all).\n", taken * 100 / sum, sum, total );
+    printf( " */\n" );
+    for( i = 0; i < Func_Num; i++ )
+    {
+        if( Order[ i ]->Take )
+        {
+            printf( "*(.text.%s)%*s/* %5u bytes %5.1f%% */\n", Order[ i ]->Name,
+                    (int)( strlen( Order[ i ]->Name ) < 32 ? 32 - strlen( Order[ i ]->Name ) : 1 ), "",
+                    Order[ i ]->Size, Order[ i ]->Samples * 100 / sum );
+        }
+    }
+    fprintf( stderr, "%lu of %lu bytes, %.1f%% of the samples\n", used, budget, taken * 100 / sum );
+    return 0;
+}
@@ -0,0 +1,156 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : main.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Main program body.
+ *********************************************************************************
+ * Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+ * Attention: This software (modified or not) and binary are used for
+ * microcontroller manufactured by Nanjing Qinheng Microelectronics.
+ *******************************************************************************/
+
+/*
+ *@Note
+ *RunInRAM_Profile:
+ * Instead of marking functions with __attribute__((section(".highcode"))) by hand
+ * (RunInRAM_Select), the functions to run from RAM are found by profiling.
+ * pc_prof.c of Prof_Lib (RunInRam/Prof_Lib, linked into the project) samples the PC
+ * with TIM3 and prints a histogram, Tool/hot_code picks the functions with the most
+ * samples per byte and writes Ld/hot_code.ld, which Link.ld
+ * includes in .highcode. __highcode_size in Link.ld is the RAM they may take, the link
+ * fails if they take more.
+ * 1. Build with the Ld/hot_code.ld shipped, run and save the serial log as prof.log.
+ * 2. riscv-none-embed-nm -S --defined-only obj/RunInRAM_Profile.elf > syms.txt
+ *    hot_code syms.txt prof.log > Ld/hot_code.ld
+ * 3. Build again, LED_Encode is timed before and after.
+ * Other projects (USB, PD...) use the same flow with Ld/ and Startup/ of this project
+ * and a link to Prof_Lib: the startup code copies .highcode to RAM, the one of
+ * SRC/Startup does not, so the project must not link SRC/Startup.
+ * IAP/USB_UART/CH643_APP does so for its USB and UART links, see APP_PROF there.
+ * PC_Prof_Start moves the other interrupts below TIM3, call it after setting them up.
+ *
+ */
+
+#include "debug.h"
+#include "pc_prof.h"
+
+/* Global define */
+#define LED_NUM          64
+#define LED_FRAMES       5000
+
+/* Global Variable */
+u8 LED_Rgb[ LED_NUM * 3 ];
+u8 LED_Spi[ LED_NUM * 3 * 3 ];
+
+/*********************************************************************
+ * @fn      LED_Encode
+ *
+ * @brief   Encode GRB bytes of WS2812 LEDs for SPI at 3 bits per LED bit,
+ *          110 for a 1 and 100 for a 0.
+ *
+ * @param   prgb - GRB bytes.
+ *          pspi - 3 bytes for each of prgb.
+ *          len - number of GRB bytes.
+ *
+ * @return  none
+ */
+void LED_Encode( const u8 *prgb, u8 *pspi, u16 len )
+{
+    u32 w;
+    u8  c, b;
+
+    while( len-- )
+    {
+        c = *prgb++;
+        w = 0;
+        for( b = 0; b < 8; b++ )
+        {
+            w = ( w << 3 ) | ( ( c & 0x80 ) ? 6 : 4 );
+            c <<= 1;
+        }
+        *pspi++ = (u8)( w >> 16 );
+        *pspi++ = (u8)( w >> 8 );
+        *pspi++ = (u8)w;
+    }
+}
+
+/*********************************************************************
+ * @fn      LED_Frame
+ *
+ * @brief   Next frame of a colour wheel running along the LEDs.
+ *
+ * @param   n - frame number.
+ *
+ * @return  none
+ */
+void LED_Frame( u32 n )
+{
+    u32 i;
+    u8  p;
+
+    for( i = 0; i < LED_NUM; i++ )
+    {
+        p = (u8)( n + i * 4 );
+        LED_Rgb[ i * 3 ] = ( p < 128 ) ? p * 2 : 255 - ( p - 128 ) * 2;
+        LED_Rgb[ i * 3 + 1 ] = 255 - LED_Rgb[ i * 3 ];
+        LED_Rgb[ i * 3 + 2 ] = p;
+    }
+}
+
+/*********************************************************************
+ * @fn      LED_Encode_Cycles
+ *
+ * @brief   Time one LED_Encode of all LEDs with SysTick counting up at HCLK.
+ *
+ * @return  HCLK cycles
+ */
+u32 LED_Encode_Cycles( void )
+{
+    u32 ticks;
+
+    SysTick->CTLR = 0;
+    SysTick->SR = 0;
+    SysTick->CTLR = ( 1 << 5 ) | ( 1 << 2 ) | ( 1 << 0 );
+    LED_Encode( LED_Rgb, LED_Spi, sizeof( LED_Rgb ) );
+    ticks = (u32)SysTick->CNT;
+    SysTick->CTLR = 0;
+
+    return ticks;
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Main program.
+ *
+ * @return  none
+ */
+int main(void)
+{
+    u32 n;
+
+    NVIC_PriorityGroupConfig(NVIC_PriorityGroup_1);
+    SystemCoreClockUpdate();
+    Delay_Init();
+    USART_Printf_Init(115200);
+    printf("SystemClk:%d\r\n", SystemCoreClock);
+    printf("ChipID:%08x\r\n", DBGMCU_GetCHIPID());
+
+    LED_Frame( 0 );
+    printf( "LED_Encode at %08x: %d cycles\r\n", (u32)LED_Encode, LED_Encode_Cycles( ) );
+
+    PC_Prof_Init( );
+    PC_Prof_Start( );
+    for( n = 0; n < LED_FRAMES; n++ )
+    {
+        LED_Frame( n );
+        LED_Encode( LED_Rgb, LED_Spi, sizeof( LED_Rgb ) );
+    }
+    PC_Prof_Stop( );
+    PC_Prof_Dump( );
+
+    while(1)
+    {
+    }
+}
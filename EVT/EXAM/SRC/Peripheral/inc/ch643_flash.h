@@ -136,10 +136,12 @@ void         FLASH_Lock_Fast(void);
 void         FLASH_BufReset(void);
 void         FLASH_BufLoad(uint32_t Address, uint32_t Data0);
 void         FLASH_ErasePage_Fast(uint32_t Page_Address);
+void         FLASH_EraseBlock_32K_Fast(uint32_t Block_Address);
 void         FLASH_ProgramPage_Fast(uint32_t Page_Address);
 void         SystemReset_StartMode(uint32_t Mode);
 FLASH_Status FLASH_ROM_ERASE(uint32_t StartAddr, uint32_t Length);
 FLASH_Status FLASH_ROM_WRITE(uint32_t StartAddr, uint32_t *pbuf, uint32_t Length);
+FLASH_Status FLASH_ROM_UPDATE(uint32_t StartAddr, uint32_t *pbuf, uint32_t Length);
 
 #ifdef __cplusplus
 }
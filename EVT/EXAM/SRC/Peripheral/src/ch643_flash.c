@@ -64,6 +64,10 @@
 #define Size_1KB                   0x400
 #define Size_32KB                  0x8000
 
+/* What erased FLASH reads as, once an erase has shown it */
+static uint32_t ROM_Erased_Val;
+static uint8_t  ROM_Erased_Known = 0;
+
 /********************************************************************************
   * @fn            FLASH_SetLatency
   *
@@ -1036,3 +1040,121 @@ FLASH_Status FLASH_ROM_WRITE(uint32_t StartAddr, uint32_t *pbuf, uint32_t Length
 
     return status;
 }
+
+/*********************************************************************
+ * @fn      ROM_PAGE_CMP
+ *
+ * @brief   Compares a FLASH page with a buffer, or with erased FLASH.
+ *
+ * @param   Addr - page address(Addr%256 == 0).
+ *          pbuf - 256 bytes, or NULL for erased FLASH.
+ *
+ * @return  1 - same, 0 - different.
+ */
+static uint8_t ROM_PAGE_CMP(uint32_t Addr, uint32_t *pbuf)
+{
+    uint8_t i;
+
+    for(i = 0; i < 64; i++)
+    {
+        if(*(uint32_t *)(Addr + 4 * i) != (pbuf ? pbuf[i] : ROM_Erased_Val))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*********************************************************************
+ * @fn      FLASH_ROM_UPDATE
+ *
+ * @brief   Writes a specified FLASH, erasing it as needed: pages that
+ *          already hold the data are neither erased nor programmed, and
+ *          pages already erased are only programmed. Each run of pages
+ *          to write is erased at once, taking whole 32KB blocks and 1KB
+ *          pages where they fit in it (see FLASH_ROM_ERASE).
+ *          The FLASH can not be programmed again without an erase, so a
+ *          changed page is always programmed whole.
+ *
+ * @param   StartAddr - Writes Flash start address(StartAddr%256 == 0).
+ *          Length - Writes Flash start Length(Length%256 == 0).
+ *          pbuf - Writes Flash value buffer.
+ *
+ * @return  FLASH Status - The returned value can be: FLASH_ADR_RANGE_ERROR,
+ *        FLASH_ALIGN_ERROR, FLASH_OP_RANGE_ERROR, FLASH_ERROR_PG or
+ *        FLASH_COMPLETE.
+ */
+FLASH_Status FLASH_ROM_UPDATE(uint32_t StartAddr, uint32_t *pbuf, uint32_t Length)
+{
+    uint32_t adr, end, run, erase0 = 0, erase1;
+    uint32_t *prun;
+
+    if((StartAddr < ValidAddrStart) || (StartAddr >= ValidAddrEnd))
+    {
+        return FLASH_ADR_RANGE_ERROR;
+    }
+
+    if((StartAddr + Length) > ValidAddrEnd)
+    {
+        return FLASH_OP_RANGE_ERROR;
+    }
+
+    if((StartAddr & (Size_256B-1)) || (Length & (Size_256B-1)) || (Length == 0))
+    {
+        return FLASH_ALIGN_ERROR;
+    }
+
+    adr = StartAddr;
+    end = StartAddr + Length;
+    while(adr < end)
+    {
+        if(ROM_PAGE_CMP(adr, pbuf))
+        {
+            adr += Size_256B;
+            pbuf += 64;
+            continue;
+        }
+
+        /* Run of pages to write, and the part of it to erase */
+        run = adr;
+        prun = pbuf;
+        erase1 = 0;
+        while((adr < end) && !ROM_PAGE_CMP(adr, pbuf))
+        {
+            if(!ROM_Erased_Known || !ROM_PAGE_CMP(adr, NULL))
+            {
+                if(erase1 == 0)
+                {
+                    erase0 = adr;
+                }
+                erase1 = adr + Size_256B;
+            }
+            adr += Size_256B;
+            pbuf += 64;
+        }
+
+        if(erase1)
+        {
+            FLASH_ROM_ERASE(erase0, erase1 - erase0);
+            ROM_Erased_Val = *(uint32_t *)erase0;
+            ROM_Erased_Known = 1;
+        }
+        FLASH_ROM_WRITE(run, prun, adr - run);
+
+        /* A page that only read as erased is erased and written again */
+        for(; run < adr; run += Size_256B, prun += 64)
+        {
+            if(!ROM_PAGE_CMP(run, prun))
+            {
+                FLASH_ROM_ERASE(run, Size_256B);
+                FLASH_ROM_WRITE(run, prun, Size_256B);
+                if(!ROM_PAGE_CMP(run, prun))
+                {
+                    return FLASH_ERROR_PG;
+                }
+            }
+        }
+    }
+
+    return FLASH_COMPLETE;
+}
@@ -15,33 +15,16 @@
   with endpoints 1/3/5 downloading data and uploading it via endpoints 2/4/6 respectively
   where endpoint 1/2 is implemented via a ring buffer and the data is not inverted,
   and endpoints 3/4 and 5/6 are directly copied and inverted for upload.
+  The vendor class (usbd_ch372.c) is a class driver on the shared USBFS device core
+  (../USBD_Lib), endpoint 2 IN runs double-buffered.
   The device can be operated using Bushund or other upper computer software.
   Note: This routine needs to be demonstrated in conjunction with the host software.
 */
 
 #include <ch643_usbfs_device.h>
+#include "usbd_ch372.h"
 #include "debug.h"
 
-/*********************************************************************
- * @fn      Var_Init
- *
- * @brief   Software parameter initialisation
- *
- * @return  none
- */
-void Var_Init(void)
-{
-    uint16_t i;
-    RingBuffer_Comm.LoadPtr = 0;
-    RingBuffer_Comm.StopFlag = 0;
-    RingBuffer_Comm.DealPtr = 0;
-    RingBuffer_Comm.RemainPack = 0;
-    for(i=0; i<DEF_Ring_Buffer_Max_Blks; i++)
-    {
-        RingBuffer_Comm.PackLen[i] = 0;
-    }
-}
-
 /*********************************************************************
  * @fn      main
  *
@@ -59,10 +42,8 @@ int main(void)
     printf("SystemClk:%d\r\n", SystemCoreClock);
     printf("ChipID:%08x\r\n", DBGMCU_GetCHIPID() );
 
-    /* Variables init */
-    Var_Init( );
-
     /* Usb Init */
+    USBFS_Class_Register( &CH372_Class_Drv );
     USBFS_RCC_Init( );
     USBFS_Device_Init( ENABLE , PWR_VDD_SupplyVoltage());
 
@@ -97,7 +78,7 @@ int main(void)
                     NVIC_DisableIRQ(USBFS_IRQn);
                     RingBuffer_Comm.StopFlag = 0;
                     NVIC_EnableIRQ(USBFS_IRQn);
-                    USBFSD->UEP1_CTRL_H = (USBFSD->UEP1_CTRL_H & ~USBFS_UEP_R_RES_MASK) | USBFS_UEP_R_RES_ACK;
+                    USBFS_Endp_RxDone( DEF_UEP1 );
                 }
             }
         }
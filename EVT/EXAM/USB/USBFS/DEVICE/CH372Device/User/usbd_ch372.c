@@ -0,0 +1,138 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : usbd_ch372.c
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: CH372 vendor class driver on the shared USBFS device core.
+ *              Endpoint 1 OUT is received into a ring buffer and sent back
+ *              from the main loop on double-buffered endpoint 2 IN.
+ *              Endpoint 3/5 OUT is inverted and sent back on endpoint 4/6 IN.
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "usbd_ch372.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+/* Ring buffer */
+RING_BUFF_COMM  RingBuffer_Comm;
+__attribute__ ((aligned(4))) uint8_t Data_Buffer[DEF_RING_BUFFER_SIZE];
+
+/* Inverted data of endpoint 3/5, read by the core until endpoint 4/6 IN is done */
+__attribute__ ((aligned(4))) uint8_t Endp4_Tx_Buf[DEF_USBD_ENDP4_SIZE];
+__attribute__ ((aligned(4))) uint8_t Endp6_Tx_Buf[DEF_USBD_ENDP6_SIZE];
+
+/*********************************************************************
+ * @fn      CH372_Init
+ *
+ * @brief   Open the vendor endpoints, called on device init and bus reset.
+ *
+ * @return  none
+ */
+static void CH372_Init( void )
+{
+    uint8_t i;
+
+    RingBuffer_Comm.LoadPtr = 0;
+    RingBuffer_Comm.StopFlag = 0;
+    RingBuffer_Comm.DealPtr = 0;
+    RingBuffer_Comm.RemainPack = 0;
+    for(i=0; i<DEF_Ring_Buffer_Max_Blks; i++)
+    {
+        RingBuffer_Comm.PackLen[i] = 0;
+    }
+
+    USBFS_Endp_Open( DEF_UEP1, USBFSD_UEP_RX_EN, DEF_USBD_ENDP1_SIZE );
+    USBFS_Endp_Open( DEF_UEP2, USBFSD_UEP_TX_EN | USBFSD_UEP_BUF_MOD, DEF_USBD_ENDP2_SIZE );
+    USBFS_Endp_Open( DEF_UEP3, USBFSD_UEP_RX_EN, DEF_USBD_ENDP3_SIZE );
+    USBFS_Endp_Open( DEF_UEP4, USBFSD_UEP_TX_EN, DEF_USBD_ENDP4_SIZE );
+    USBFS_Endp_Open( DEF_UEP5, USBFSD_UEP_RX_EN, DEF_USBD_ENDP5_SIZE );
+    USBFS_Endp_Open( DEF_UEP6, USBFSD_UEP_TX_EN, DEF_USBD_ENDP6_SIZE );
+
+    /* Endpoint 1 receives straight into the ring buffer */
+    USBFS_Endp_RxBuf_Set( DEF_UEP1, Data_Buffer );
+}
+
+/*********************************************************************
+ * @fn      CH372_Out
+ *
+ * @brief   OUT packet received on endpoint 1/3/5.
+ *
+ * @return  none
+ */
+static void CH372_Out( uint8_t endp, uint8_t *pbuf, uint16_t len )
+{
+    uint8_t  *buf;
+    uint16_t i;
+
+    switch( endp )
+    {
+        case DEF_UEP1:
+            /* Write In Buffer */
+            RingBuffer_Comm.PackLen[ RingBuffer_Comm.LoadPtr ] = len;
+            RingBuffer_Comm.LoadPtr ++;
+            if(RingBuffer_Comm.LoadPtr == DEF_Ring_Buffer_Max_Blks)
+            {
+                RingBuffer_Comm.LoadPtr = 0;
+            }
+            USBFS_Endp_RxBuf_Set( DEF_UEP1, &Data_Buffer[ (RingBuffer_Comm.LoadPtr) * DEF_USBD_FS_PACK_SIZE] );
+            RingBuffer_Comm.RemainPack ++;
+            if(RingBuffer_Comm.RemainPack >= DEF_Ring_Buffer_Max_Blks-DEF_RING_BUFFER_REMINE)
+            {
+                /* Keep NAKing until the main loop has drained the ring */
+                RingBuffer_Comm.StopFlag = 1;
+            }
+            else
+            {
+                USBFS_Endp_RxDone( DEF_UEP1 );
+            }
+            break;
+
+        case DEF_UEP3:
+        case DEF_UEP5:
+            /* Endpoint stays NAK until the inverted data has been sent back */
+            buf = ( endp == DEF_UEP3 )? Endp4_Tx_Buf : Endp6_Tx_Buf;
+            for(i=0; i<len; i++)
+            {
+                buf[i] = ~pbuf[i];
+            }
+            USBFS_Endp_Transmit( endp + 1, buf, len, 0 );
+            break;
+
+        default:
+            USBFS_Endp_RxDone( endp );
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      CH372_In
+ *
+ * @brief   IN transfer done on endpoint 2/4/6.
+ *
+ * @return  none
+ */
+static void CH372_In( uint8_t endp )
+{
+    if( ( endp == DEF_UEP4 ) || ( endp == DEF_UEP6 ) )
+    {
+        USBFS_Endp_RxDone( endp - 1 );
+    }
+}
+
+/* Class driver */
+const USBFS_CLASS_DRV CH372_Class_Drv =
+{
+    0, 1,
+    ( 1 << DEF_UEP1 ) | ( 1 << DEF_UEP2 ) | ( 1 << DEF_UEP3 ) | ( 1 << DEF_UEP4 ) | ( 1 << DEF_UEP5 ) | ( 1 << DEF_UEP6 ),
+    CH372_Init,
+    NULL,
+    NULL,
+    CH372_Out,
+    CH372_In,
+    NULL,
+    NULL,
+};
@@ -0,0 +1,41 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : usbd_ch372.h
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: header file of usbd_ch372.c
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef USER_USBD_CH372_H_
+#define USER_USBD_CH372_H_
+
+#include <ch643_usbfs_device.h>
+
+/******************************************************************************/
+/* Ringbuffer define  */
+#define DEF_Ring_Buffer_Max_Blks      16
+#define DEF_RING_BUFFER_SIZE          (DEF_Ring_Buffer_Max_Blks*DEF_USBD_FS_PACK_SIZE)
+#define DEF_RING_BUFFER_REMINE        4
+#define DEF_RING_BUFFER_RESTART       10
+
+/* Ring Buffer typedef */
+typedef struct __PACKED _RING_BUFF_COMM
+{
+    volatile uint8_t LoadPtr;
+    volatile uint8_t DealPtr;
+    volatile uint8_t RemainPack;
+    volatile uint8_t PackLen[DEF_Ring_Buffer_Max_Blks];
+    volatile uint8_t StopFlag;
+} RING_BUFF_COMM, pRING_BUFF_COMM;
+
+/******************************************************************************/
+/* external variables */
+extern const USBFS_CLASS_DRV CH372_Class_Drv;
+extern RING_BUFF_COMM  RingBuffer_Comm;
+extern __attribute__ ((aligned(4))) uint8_t Data_Buffer[ ];
+
+#endif /* USER_USBD_CH372_H_ */
@@ -33,27 +33,6 @@
 #include "debug.h"
 #include "usbd_compatibility_hid.h"
 
-/*********************************************************************
- * @fn      Var_Init
- *
- * @brief   Software parameter initialisation
- *
- * @return  none
- */
-void Var_Init(void)
-{
-    uint16_t i;
-    RingBuffer_Comm.LoadPtr = 0;
-    RingBuffer_Comm.StopFlag = 0;
-    RingBuffer_Comm.DealPtr = 0;
-    RingBuffer_Comm.RemainPack = 0;
-    for(i=0; i<DEF_Ring_Buffer_Max_Blks; i++)
-    {
-        RingBuffer_Comm.PackLen[i] = 0;
-    }
-}
-
-
 /*********************************************************************
  * @fn      main
  *
@@ -70,15 +49,13 @@ int main(void)
     printf("SystemClk:%d\r\n", SystemCoreClock);
     printf("ChipID:%08x\r\n", DBGMCU_GetCHIPID() );
 
-    /* Variables init */
-    Var_Init( );
-
     /* UART2 init */
     UART2_Init();
     UART2_DMA_Init();
 
     TIM3_Init();
     /* Usb Init */
+    USBFS_Class_Register( &HID_Class_Drv );
     USBFS_RCC_Init( );
     USBFS_Device_Init( ENABLE , PWR_VDD_SupplyVoltage());
     while(1)
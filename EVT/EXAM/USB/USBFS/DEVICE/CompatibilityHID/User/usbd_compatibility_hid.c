@@ -16,7 +16,16 @@
 
 void TIM3_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
 
+/* Ring buffer */
+RING_BUFF_COMM  RingBuffer_Comm;
+__attribute__ ((aligned(4))) uint8_t Data_Buffer[DEF_RING_BUFFER_SIZE];
+
+/* HID Class Command */
+volatile uint8_t USBFS_HidIdle;
+volatile uint8_t USBFS_HidProtocol;
+
 __attribute__ ((aligned(4))) uint8_t UART2_RxBuffer[DEF_UART2_BUF_SIZE];  // UART2 Rx Buffer
+__attribute__ ((aligned(4))) uint8_t UART2_Up_Buf[DEF_USB_EP2_FS_SIZE];   // Endpoint 2 packet, read by the core until it is sent
 __attribute__ ((aligned(4))) uint8_t  HID_Report_Buffer[64];              // HID Report Buffer
 volatile uint8_t HID_Set_Report_Flag = SET_REPORT_DEAL_OVER;               // HID SetReport flag
 
@@ -28,6 +37,184 @@ volatile uint16_t UART2_RX_LastCnt = 0;                                    // UA
 volatile uint16_t UART2_Rx_RemainLen = 0;                                  // UART2 RX data remain len
 volatile uint16_t UART2_Rx_Deal_Ptr = 0;                                   // UART2 RX data deal pointer
 
+/*********************************************************************
+ * @fn      HID_Init
+ *
+ * @brief   Empty the ring buffer and open endpoint 1 OUT / endpoint 2 IN,
+ *          called on device init and bus reset.
+ *
+ * @return  none
+ */
+static void HID_Init( void )
+{
+    uint8_t i;
+
+    RingBuffer_Comm.LoadPtr = 0;
+    RingBuffer_Comm.StopFlag = 0;
+    RingBuffer_Comm.DealPtr = 0;
+    RingBuffer_Comm.RemainPack = 0;
+    for(i=0; i<DEF_Ring_Buffer_Max_Blks; i++)
+    {
+        RingBuffer_Comm.PackLen[i] = 0;
+    }
+
+    USBFS_Endp_Open( DEF_UEP1, USBFSD_UEP_RX_EN, DEF_USB_EP1_FS_SIZE );
+    USBFS_Endp_Open( DEF_UEP2, USBFSD_UEP_TX_EN, DEF_USB_EP2_FS_SIZE );
+
+    /* Endpoint 1 receives straight into the ring buffer */
+    USBFS_Endp_RxBuf_Set( DEF_UEP1, Data_Buffer );
+}
+
+/*********************************************************************
+ * @fn      HID_Setup
+ *
+ * @brief   HID class requests and the HID/report descriptors of
+ *          interface 0.
+ *
+ * @return  DEF_USBD_REQ_OK or DEF_USBD_REQ_ERR
+ */
+static uint8_t HID_Setup( const uint8_t **ppbuf, uint16_t *plen )
+{
+    if( USBFS_SetupReqIndex != 0x00 )
+    {
+        return DEF_USBD_REQ_ERR;
+    }
+
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_STANDARD )
+    {
+        if( USBFS_SetupReqCode != USB_GET_DESCRIPTOR )
+        {
+            return DEF_USBD_REQ_ERR;
+        }
+        switch( (uint8_t)(USBFS_SetupReqValue>>8) )
+        {
+            /* get usb report descriptor */
+            case USB_DESCR_TYP_REPORT:
+                *ppbuf = MyHIDReportDesc;
+                *plen = DEF_USBD_REPORT_DESC_LEN;
+                break;
+
+            /* get hid descriptor */
+            case USB_DESCR_TYP_HID:
+                *ppbuf = &MyCfgDescr[18];
+                *plen = 0x09;
+                break;
+
+            default:
+                return DEF_USBD_REQ_ERR;
+        }
+        return DEF_USBD_REQ_OK;
+    }
+
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) != USB_REQ_TYP_CLASS )
+    {
+        return DEF_USBD_REQ_ERR;
+    }
+    switch( USBFS_SetupReqCode )
+    {
+        case HID_SET_REPORT:
+            break;
+
+        case HID_GET_REPORT:
+            *ppbuf = HID_Report_Buffer;
+            *plen = sizeof( HID_Report_Buffer );
+            break;
+
+        case HID_SET_IDLE:
+            USBFS_HidIdle = (uint8_t)( USBFS_SetupReqValue >> 8 );
+            break;
+
+        case HID_SET_PROTOCOL:
+            USBFS_HidProtocol = (uint8_t)USBFS_SetupReqValue;
+            break;
+
+        case HID_GET_IDLE:
+            USBFS_EP0_4Buf[ 0 ] = USBFS_HidIdle;
+            if( USBFS_SetupReqLen > 1 )
+            {
+                USBFS_SetupReqLen = 1;
+            }
+            break;
+
+        case HID_GET_PROTOCOL:
+            USBFS_EP0_4Buf[ 0 ] = USBFS_HidProtocol;
+            if( USBFS_SetupReqLen > 1 )
+            {
+                USBFS_SetupReqLen = 1;
+            }
+            break;
+
+        default:
+            return DEF_USBD_REQ_ERR;
+    }
+    return DEF_USBD_REQ_OK;
+}
+
+/*********************************************************************
+ * @fn      HID_EP0_Out
+ *
+ * @brief   Set_Report data, printed from the main loop by
+ *          HID_Set_Report_Deal, which then ACKs the status stage.
+ *
+ * @return  none
+ */
+static void HID_EP0_Out( uint8_t *pbuf, uint16_t len )
+{
+    if( ( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_CLASS ) && ( USBFS_SetupReqCode == HID_SET_REPORT ) )
+    {
+        if( len > sizeof( HID_Report_Buffer ) )
+        {
+            len = sizeof( HID_Report_Buffer );
+        }
+        memcpy( HID_Report_Buffer, pbuf, len );
+        HID_Set_Report_Flag = SET_REPORT_WAIT_DEAL;
+        USBFS_EP0_Status_Hold( );
+    }
+}
+
+/*********************************************************************
+ * @fn      HID_Out
+ *
+ * @brief   Endpoint 1 OUT packet received into the ring buffer.
+ *
+ * @return  none
+ */
+static void HID_Out( uint8_t endp, uint8_t *pbuf, uint16_t len )
+{
+    /* Write In Buffer */
+    RingBuffer_Comm.PackLen[ RingBuffer_Comm.LoadPtr ] = len;
+    RingBuffer_Comm.LoadPtr ++;
+    if(RingBuffer_Comm.LoadPtr == DEF_Ring_Buffer_Max_Blks)
+    {
+        RingBuffer_Comm.LoadPtr = 0;
+    }
+    USBFS_Endp_RxBuf_Set( DEF_UEP1, &Data_Buffer[ (RingBuffer_Comm.LoadPtr) * DEF_USBD_FS_PACK_SIZE] );
+    RingBuffer_Comm.RemainPack ++;
+    if(RingBuffer_Comm.RemainPack >= DEF_Ring_Buffer_Max_Blks-DEF_RING_BUFFER_REMINE)
+    {
+        /* Keep NAKing until UART2_Tx_Service has drained the ring */
+        RingBuffer_Comm.StopFlag = 1;
+    }
+    else
+    {
+        USBFS_Endp_RxDone( DEF_UEP1 );
+    }
+}
+
+/* Class driver */
+const USBFS_CLASS_DRV HID_Class_Drv =
+{
+    0, 1,
+    ( 1 << DEF_UEP1 ) | ( 1 << DEF_UEP2 ),
+    HID_Init,
+    HID_Setup,
+    HID_EP0_Out,
+    HID_Out,
+    NULL,
+    NULL,
+    NULL,
+};
+
 /*********************************************************************
  * @fn      TIM3_Init
  *
@@ -230,12 +417,9 @@ void UART2_Rx_Service( void )
             /* Upload packet via USB. */
             if (pkg_len)
             {
-                USBFSD->UEP2_DMA = (uint16_t)(uint32_t)USBFS_EP2_Buf;
-                USBFS_EP2_Buf[0] = pkg_len;
-                memcpy(USBFS_EP2_Buf + 1,&UART2_RxBuffer[UART2_Rx_Deal_Ptr],pkg_len);
-                USBFSD->UEP2_TX_LEN = pkg_len + 1;
-                USBFS_Endp_Busy[DEF_UEP2] = 1;
-                USBFSD->UEP2_CTRL_H = (USBFSD->UEP2_CTRL_H & ~USBFS_UEP_T_RES_MASK) | USBFS_UEP_T_RES_ACK;            // Start Upload
+                UART2_Up_Buf[0] = pkg_len;
+                memcpy(UART2_Up_Buf + 1,&UART2_RxBuffer[UART2_Rx_Deal_Ptr],pkg_len);
+                USBFS_Endp_Transmit(DEF_UEP2, UART2_Up_Buf, pkg_len + 1, 0);                  // Start Upload
                 UART2_Rx_RemainLen -= pkg_len;
                 UART2_Rx_Deal_Ptr += pkg_len;
 
@@ -317,7 +501,7 @@ void UART2_Tx_Service( void )
         {
             printf("USB ring buffer full, stop receiving further data.\r\n");
             RingBuffer_Comm.StopFlag = 0;
-            USBFSD->UEP1_CTRL_H = (USBFSD->UEP1_CTRL_H & ~USBFS_UEP_R_RES_MASK) | USBFS_UEP_R_RES_ACK;
+            USBFS_Endp_RxDone( DEF_UEP1 );
         }
     }
 
@@ -342,8 +526,7 @@ void HID_Set_Report_Deal( void )
         }
         printf("\r\n");
         HID_Set_Report_Flag = SET_REPORT_DEAL_OVER;
-        USBFSD->UEP0_TX_LEN  = 0;
-        USBFSD->UEP0_CTRL_H = (USBFSD->UEP0_CTRL_H & ~USBFS_UEP_T_RES_MASK) | USBFS_UEP_T_TOG | USBFS_UEP_T_RES_ACK;
+        USBFS_EP0_Status_Send( );
     }
 }
 
@@ -13,6 +13,24 @@
 #ifndef USER_USBD_COMPATIBILITY_HID_H_
 #define USER_USBD_COMPATIBILITY_HID_H_
 
+#include <ch643_usbfs_device.h>
+
+/******************************************************************************/
+/* Ringbuffer define  */
+#define DEF_Ring_Buffer_Max_Blks      16
+#define DEF_RING_BUFFER_SIZE          (DEF_Ring_Buffer_Max_Blks*DEF_USBD_FS_PACK_SIZE)
+#define DEF_RING_BUFFER_REMINE        4
+#define DEF_RING_BUFFER_RESTART       10
+
+/* Ring Buffer typedef */
+typedef struct __PACKED _RING_BUFF_COMM
+{
+    volatile uint8_t LoadPtr;
+    volatile uint8_t DealPtr;
+    volatile uint8_t RemainPack;
+    volatile uint8_t PackLen[DEF_Ring_Buffer_Max_Blks];
+    volatile uint8_t StopFlag;
+} RING_BUFF_COMM, pRING_BUFF_COMM;
 
 #define DEF_UART2_BUF_SIZE            2048
 #define DEF_UART2_TOUT_TIME           30             // NOTE: the timeout time should be set according to the actual baud rate.
@@ -21,6 +39,9 @@
 #define SET_REPORT_WAIT_DEAL          0x01
 
 
+extern const USBFS_CLASS_DRV HID_Class_Drv;
+extern RING_BUFF_COMM  RingBuffer_Comm;
+extern __attribute__ ((aligned(4))) uint8_t Data_Buffer[ ];
 extern uint8_t  HID_Report_Buffer[64];               // HID Report Buffer
 extern volatile uint8_t HID_Set_Report_Flag;
 
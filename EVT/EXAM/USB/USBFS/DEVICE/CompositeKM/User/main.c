@@ -22,11 +22,27 @@
  * 'A' -> 0x04
  * 'S' -> 0x16
  * 'D' -> 0x07
+ * Both interrupt endpoints are polled every 1ms. Reports go through small
+ * queues (usbd_hid_tx.c): mouse movements scanned between two polls are summed,
+ * and the time from the first scan of a change to the host's ACK is kept in a
+ * histogram, printed after 2s without input.
+ * On bus suspend the main loop puts the chip into Stop mode, whether or not the
+ * host enabled remote wakeup. A falling edge on PB12-PB15 or PA4-PA7 wakes it and,
+ * if remote wakeup is enabled, signals resume; otherwise it goes back to Stop.
+ * Host resume wakes it through the USBFS wake-up event (EXTI line 28). The time
+ * from the suspend interrupt to Stop, the clock restore time and the time from
+ * wake-up to the first report ACKed are printed with the report statistics.
+ * Suspend current is measured on VBUS with an ammeter while the host is asleep;
+ * disconnect the WCH-Link and USART adapter first, they feed the I/O pins.
  */
 
 #include <ch643_usbfs_device.h>
 #include "debug.h"
 #include "usbd_composite_km.h"
+#include "usbd_hid_tx.h"
+
+/* Statistics are printed after this long without new reports */
+#define DEF_HID_STAT_IDLE_US    2000000
 
 
 /*********************************************************************
@@ -38,6 +54,10 @@
  */
 int main(void)
 {
+    uint32_t sent, sent_last = 0;
+    uint32_t idle_us = 0;
+    uint16_t now, last;
+    uint8_t  stat_new = 0;
 
     NVIC_PriorityGroupConfig(NVIC_PriorityGroup_1);
     SystemCoreClockUpdate();
@@ -65,10 +85,14 @@ int main(void)
     printf( "TIM3 Init OK!\r\n" );
 
 
+    /* Initialize report queues and their time base */
+    HID_Tx_Init( );
+    last = HID_Tx_Time( );
+
     /* Usb Init */
+    USBFS_Class_Register( &KM_Class_Drv );
     USBFS_RCC_Init( );
     USBFS_Device_Init( ENABLE , PWR_VDD_SupplyVoltage());
-    USB_Sleep_Wakeup_CFG( );
     while(1)
     {
         /* Determine if enumeration is complete, perform data transfer if completed */
@@ -89,5 +113,27 @@ int main(void)
                 USART2_Receive_Handle( );
             }
         }
+
+        /* Bus suspended, enter Stop mode until resumed */
+        USBFS_Device_Sleep( );
+        USB_Wake_Check( );
+
+        /* Print the latency statistics once input has stopped, printf blocks the loop */
+        now = HID_Tx_Time( );
+        idle_us += (uint16_t)( now - last );
+        last = now;
+        sent = HID_Tx_Q[ DEF_HID_TX_KB ].Sent + HID_Tx_Q[ DEF_HID_TX_MS ].Sent;
+        if( sent != sent_last )
+        {
+            sent_last = sent;
+            idle_us = 0;
+            stat_new = 1;
+        }
+        else if( stat_new && ( idle_us >= DEF_HID_STAT_IDLE_US ) )
+        {
+            stat_new = 0;
+            HID_Tx_Stat_Print( );
+            USB_Sleep_Stat_Print( );
+        }
     }
 }
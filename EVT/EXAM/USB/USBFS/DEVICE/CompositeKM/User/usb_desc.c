@@ -74,7 +74,7 @@ const uint8_t MyCfgDescr[ ] =
     0x81,                                                   // bEndpointAddress: IN Endpoint 1
     0x03,                                                   // bmAttributes
     0x08, 0x00,                                             // wMaxPacketSize
-    0x0A,                                                   // bInterval: 10mS
+    0x01,                                                   // bInterval: 1mS
 
     /* Interface Descriptor (Mouse) */
     0x09,                                                   // bLength
@@ -218,7 +218,7 @@ const uint8_t MyManuInfo[ ] =
 /* Product Information */
 const uint8_t MyProdInfo[ ]  =
 {
-    0x12,
+    0x0C,
     0x03,
     'C',
     0,
@@ -15,6 +15,7 @@
 
 /*******************************************************************************/
 /* Header Files */
+#include <ch643_usbfs_device.h>
 #include "debug.h"
 #include "string.h"
 #include "usb_desc.h"
@@ -26,10 +27,30 @@
 #define DEF_KEY_CHAR_S              0x16                                        /* "S" */
 #define DEF_KEY_CHAR_D              0x07                                        /* "D" */
 
+/*******************************************************************************/
+/* Suspend: inputs that signal remote wakeup, PB12-PB15 and PA4-PA7 */
+#define DEF_WAKEUP_EXTI_LINES       ( EXTI_Line4 | EXTI_Line5 | EXTI_Line6 | EXTI_Line7 | \
+                                      EXTI_Line12 | EXTI_Line13 | EXTI_Line14 | EXTI_Line15 )
+
+/*******************************************************************************/
+/* Type Definition */
+typedef struct _USB_SLEEP_STAT
+{
+    uint32_t Suspend;                                                           /* Stop mode entries */
+    uint32_t Remote_Wake;                                                       /* Woken by input, resume signalled */
+    uint32_t Host_Resume;                                                       /* Woken by the host */
+    uint16_t Entry_Max;                                                         /* Us, suspend interrupt to Stop mode */
+    uint16_t Restore_Max;                                                       /* Us, wake-up to clocks restored */
+    uint16_t First_Max;                                                         /* Us, wake-up to first report ACKed */
+} USB_SLEEP_STAT;
+
 /*******************************************************************************/
 /* Global Variable Declaration */
 extern volatile uint8_t  KB_LED_Last_Status;
 extern volatile uint8_t  KB_LED_Cur_Status;
+extern volatile uint16_t USB_Suspend_Stamp;
+extern USB_SLEEP_STAT USB_Sleep_Stat;
+extern const USBFS_CLASS_DRV KM_Class_Drv;
 
 
 /*******************************************************************************/
@@ -46,8 +67,8 @@ extern void MS_Scan_Init( void );
 extern void MS_Sleep_Wakeup_Cfg( void );
 extern void MS_Scan( void );
 extern void MS_Scan_Handle( void );
-extern void USB_Sleep_Wakeup_CFG( void );
-extern void MCU_Sleep_Wakeup_Operate( void );
+extern void USB_Wake_Check( void );
+extern void USB_Sleep_Stat_Print( void );
 
 
 #endif
@@ -15,6 +15,7 @@
 /* Header Files */
 #include <ch643_usbfs_device.h>
 #include "usbd_composite_km.h"
+#include "usbd_hid_tx.h"
 
 /*******************************************************************************/
 /* Global Variable Definition */
@@ -22,16 +23,28 @@
 /* Mouse */
 volatile uint8_t  MS_Scan_Done = 0x00;                                          // Mouse Movement Scan Done
 volatile uint16_t MS_Scan_Result = 0x00F0;                                      // Mouse Movement Scan Result
-uint8_t  MS_Data_Pack[ 4 ] = { 0x00 };                                          // Mouse IN Data Packet
+volatile uint16_t MS_Scan_Stamp;                                                // Mouse Movement First Sampled (HID_Tx_Time)
 
 /* Keyboard */
 volatile uint8_t  KB_Scan_Done = 0x00;                                          // Keyboard Keys Scan Done
 volatile uint16_t KB_Scan_Result = 0xF000;                                      // Keyboard Keys Current Scan Result
 volatile uint16_t KB_Scan_Last_Result = 0xF000;                                 // Keyboard Keys Last Scan Result
+volatile uint16_t KB_Scan_Stamp;                                                // Keyboard Keys First Sampled (HID_Tx_Time)
 uint8_t  KB_Data_Pack[ 8 ] = { 0x00 };                                          // Keyboard IN Data Packet
 volatile uint8_t  KB_LED_Last_Status = 0x00;                                    // Keyboard LED Last Result
 volatile uint8_t  KB_LED_Cur_Status = 0x00;                                     // Keyboard LED Current Result
 
+/* HID Class Command, one per interface */
+volatile uint8_t  USBFS_HidIdle[ 2 ];
+volatile uint8_t  USBFS_HidProtocol[ 2 ];
+
+/* Suspend */
+volatile uint16_t USB_Suspend_Stamp;                                            // Suspend Interrupt Time (HID_Tx_Time)
+uint16_t USB_Wake_Stamp;                                                        // Last Wake-up From Stop (HID_Tx_Time)
+uint32_t USB_Wake_Sent;                                                         // Reports ACKed Before The Wake-up
+uint8_t  USB_Wake_Pending;                                                      // Waiting For The First Report After Wake-up
+USB_SLEEP_STAT USB_Sleep_Stat;
+
 /* USART */
 volatile uint8_t  USART_Recv_Dat = 0x00;
 volatile uint8_t  USART_Send_Flag = 0x00;
@@ -196,10 +209,10 @@ void USART2_Receive_Handle( void )
     }
     else if( flag == 1 )
     {
-        /* Load keyboard data to endpoint 1 */
-        status = USBFS_Endp_DataUp( DEF_UEP1, KB_Data_Pack, sizeof( KB_Data_Pack ), DEF_UEP_CPY_LOAD );
+        /* Queue keyboard data for endpoint 1 */
+        status = HID_Tx_Keyboard( KB_Data_Pack, HID_Tx_Time( ) );
 
-        if( status == READY )
+        if( status != DEF_HID_TX_DROPPED )
         {
             /* Enable timing for uploading the key value */
             USART_Send_Cnt = 0;
@@ -221,11 +234,11 @@ void USART2_Receive_Handle( void )
     }
     else if( flag == 3 )
     {
-        /* Load keyboard data to endpoint 1 */
-        status = USBFS_Endp_DataUp( DEF_UEP1, KB_Data_Pack, sizeof( KB_Data_Pack ), DEF_UEP_CPY_LOAD );
+        /* Queue keyboard data for endpoint 1 */
+        status = HID_Tx_Keyboard( KB_Data_Pack, HID_Tx_Time( ) );
 
         /* Clear variables for next reception */
-        if( status == READY )
+        if( status != DEF_HID_TX_DROPPED )
         {
             USART_Recv_Dat = 0;
             flag = 0;
@@ -310,6 +323,7 @@ void KB_Scan( void )
 {
     static uint16_t scan_cnt = 0;
     static uint16_t scan_result = 0;
+    static uint16_t scan_stamp = 0;
 
     scan_cnt++;
     if( ( scan_cnt % 10 ) == 0 )
@@ -319,6 +333,7 @@ void KB_Scan( void )
         /* Determine whether the two scan results are consistent */
         if( scan_result == ( GPIO_ReadInputData( GPIOB ) & 0xF000 ) )
         {
+            KB_Scan_Stamp = scan_stamp;
             KB_Scan_Done = 1;
             KB_Scan_Result = scan_result;
         }
@@ -327,6 +342,7 @@ void KB_Scan( void )
     {
         /* Save the first scan result */
         scan_result = ( GPIO_ReadInputData( GPIOB ) & 0xF000 );
+        scan_stamp = HID_Tx_Time( );
     }
 }
 
@@ -340,9 +356,7 @@ void KB_Scan( void )
 void KB_Scan_Handle( void )
 {
     uint8_t i, j;
-    uint8_t status;
     static uint8_t key_cnt = 0x00;
-    static uint8_t flag = 0x00;
 
     if( KB_Scan_Done )
     {
@@ -432,21 +446,9 @@ void KB_Scan_Handle( void )
                 }
             }
 
-            /* Copy the keyboard data to the buffer of endpoint 1 and set the data uploading flag */
+            /* Queue the keyboard data for endpoint 1 */
             KB_Scan_Last_Result = KB_Scan_Result;
-            flag = 1;
-        }
-    }
-
-    if( flag )
-    {
-        /* Load keyboard data to endpoint 1 */
-        status = USBFS_Endp_DataUp( DEF_UEP1, KB_Data_Pack, sizeof( KB_Data_Pack ), DEF_UEP_CPY_LOAD );
-
-        if( status == READY )
-        {
-            /* Clear flag after successful loading */
-            flag = 0;
+            HID_Tx_Keyboard( KB_Data_Pack, KB_Scan_Stamp );
         }
     }
 }
@@ -577,6 +579,7 @@ void MS_Scan( void )
 {
     static uint16_t scan_cnt = 0;
     static uint16_t scan_result = 0;
+    static uint16_t scan_stamp = 0;
 
     scan_cnt++;
     if( scan_cnt >= 2 )
@@ -586,6 +589,7 @@ void MS_Scan( void )
         /* Determine whether the two scan results are consistent */
         if( scan_result == ( GPIO_ReadInputData( GPIOA ) & 0x00F0 ) )
         {
+            MS_Scan_Stamp = scan_stamp;
             MS_Scan_Result = scan_result;
             MS_Scan_Done = 1;
         }
@@ -594,6 +598,7 @@ void MS_Scan( void )
     {
         /* Save the first scan result */
         scan_result = ( GPIO_ReadInputData( GPIOA ) & 0x00F0 );
+        scan_stamp = HID_Tx_Time( );
     }
 }
 
@@ -607,15 +612,14 @@ void MS_Scan( void )
 void MS_Scan_Handle( void )
 {
     uint8_t i;
-    uint8_t status;
-    static uint8_t flag = 0x00;
+    int8_t  dx, dy;
 
     if( MS_Scan_Done )
     {
         MS_Scan_Done = 0;
 
-        memset( MS_Data_Pack, 0x00, sizeof( MS_Data_Pack ) );
-
+        dx = 0;
+        dy = 0;
         for( i = 4; i < 8; i++ )
         {
             /* Determine that the mouse is moved */
@@ -623,87 +627,296 @@ void MS_Scan_Handle( void )
             {
                 if( i == 4 )
                 {
-                    MS_Data_Pack[ 1 ] += 0x02;
+                    dx += 2;
                 }
                 else if( i == 5 )
                 {
-                    MS_Data_Pack[ 1 ] += 0xFE;
+                    dx -= 2;
                 }
                 else if( i == 6 )
                 {
-                    MS_Data_Pack[ 2 ] += 0x02;
+                    dy += 2;
                 }
                 else if( i == 7 )
                 {
-                    MS_Data_Pack[ 2 ] += 0xFE;
+                    dy -= 2;
                 }
-
-                /* Set the data uploading flag */
-                flag = 1;
             }
         }
+
+        /* Queue the movement for endpoint 2, scans between two polls are summed */
+        if( ( MS_Scan_Result & 0x00F0 ) != 0x00F0 )
+        {
+            HID_Tx_Mouse( 0x00, dx, dy, 0, MS_Scan_Stamp );
+        }
     }
+}
+
+/*********************************************************************
+ * @fn      KM_Init
+ *
+ * @brief   Open the keyboard and mouse IN endpoints and drop any queued
+ *          report, called on device init and bus reset.
+ *
+ * @return  none
+ */
+static void KM_Init( void )
+{
+    USBFS_Endp_Open( DEF_UEP1, USBFSD_UEP_TX_EN, DEF_USB_EP1_FS_SIZE );
+    USBFS_Endp_Open( DEF_UEP2, USBFSD_UEP_TX_EN, DEF_USB_EP2_FS_SIZE );
+    HID_Tx_Reset( );
+}
 
-    if( flag )
+/*********************************************************************
+ * @fn      KM_Setup
+ *
+ * @brief   HID class requests and the HID/report descriptors of
+ *          interface 0 (keyboard) and interface 1 (mouse).
+ *
+ * @return  DEF_USBD_REQ_OK or DEF_USBD_REQ_ERR
+ */
+static uint8_t KM_Setup( const uint8_t **ppbuf, uint16_t *plen )
+{
+    uint8_t itf = (uint8_t)USBFS_SetupReqIndex;
+
+    if( ( ( USBFS_SetupReqType & USB_REQ_RECIP_MASK ) != USB_REQ_RECIP_INTERF ) || ( itf > 1 ) )
     {
-        /* Load mouse data to endpoint 2 */
-        status = USBFS_Endp_DataUp( DEF_UEP2, MS_Data_Pack, sizeof( MS_Data_Pack ), DEF_UEP_CPY_LOAD );
+        return DEF_USBD_REQ_ERR;
+    }
 
-        if( status == READY )
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_STANDARD )
+    {
+        if( USBFS_SetupReqCode != USB_GET_DESCRIPTOR )
         {
-            /* Clear flag after successful loading */
-            flag = 0;
+            return DEF_USBD_REQ_ERR;
+        }
+        switch( (uint8_t)( USBFS_SetupReqValue >> 8 ) )
+        {
+            /* get usb hid descriptor */
+            case USB_DESCR_TYP_HID:
+                *ppbuf = ( itf == 0 ) ? &MyCfgDescr[ 18 ] : &MyCfgDescr[ 43 ];
+                *plen = 9;
+                break;
+
+            /* get usb report descriptor */
+            case USB_DESCR_TYP_REPORT:
+                if( itf == 0 )
+                {
+                    *ppbuf = KeyRepDesc;
+                    *plen = DEF_USBD_REPORT_DESC_LEN_KB;
+                }
+                else
+                {
+                    *ppbuf = MouseRepDesc;
+                    *plen = DEF_USBD_REPORT_DESC_LEN_MS;
+                }
+                break;
+
+            default:
+                return DEF_USBD_REQ_ERR;
         }
+        return DEF_USBD_REQ_OK;
+    }
+
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) != USB_REQ_TYP_CLASS )
+    {
+        return DEF_USBD_REQ_ERR;
+    }
+    switch( USBFS_SetupReqCode )
+    {
+        case HID_SET_REPORT:
+            break;
+
+        case HID_SET_IDLE:
+            USBFS_HidIdle[ itf ] = (uint8_t)( USBFS_SetupReqValue >> 8 );
+            break;
+
+        case HID_SET_PROTOCOL:
+            USBFS_HidProtocol[ itf ] = (uint8_t)USBFS_SetupReqValue;
+            break;
+
+        case HID_GET_IDLE:
+            USBFS_EP0_4Buf[ 0 ] = USBFS_HidIdle[ itf ];
+            if( USBFS_SetupReqLen > 1 )
+            {
+                USBFS_SetupReqLen = 1;
+            }
+            break;
+
+        case HID_GET_PROTOCOL:
+            USBFS_EP0_4Buf[ 0 ] = USBFS_HidProtocol[ itf ];
+            if( USBFS_SetupReqLen > 1 )
+            {
+                USBFS_SetupReqLen = 1;
+            }
+            break;
+
+        default:
+            return DEF_USBD_REQ_ERR;
     }
+    return DEF_USBD_REQ_OK;
 }
 
 /*********************************************************************
- * @fn      USB_Sleep_Wakeup_CFG
+ * @fn      KM_EP0_Out
  *
- * @brief   Configure USB wake up mode
+ * @brief   Set_Report data of the keyboard, the LED state.
  *
  * @return  none
  */
-void USB_Sleep_Wakeup_CFG( void )
+static void KM_EP0_Out( uint8_t *pbuf, uint16_t len )
 {
-    EXTI_InitTypeDef EXTI_InitStructure = { 0 };
-
-    EXTI_InitStructure.EXTI_Line = EXTI_Line28;
-    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Event;
-    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising;
-    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
-    EXTI_Init( &EXTI_InitStructure );
+    if( ( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_CLASS ) &&
+        ( USBFS_SetupReqCode == HID_SET_REPORT ) && ( USBFS_SetupReqIndex == 0 ) && len )
+    {
+        KB_LED_Cur_Status = pbuf[ 0 ];
+    }
 }
 
 /*********************************************************************
- * @fn      MCU_Sleep_Wakeup_Operate
+ * @fn      KM_In
  *
- * @brief   Perform sleep operation
+ * @brief   Report ACKed on endpoint 1 or 2, load the next one.
  *
  * @return  none
  */
-void MCU_Sleep_Wakeup_Operate( void )
+static void KM_In( uint8_t endp )
 {
-    printf( "Sleep\r\n" );
-    __disable_irq();
-    EXTI_ClearFlag( EXTI_Line12 | EXTI_Line13 | EXTI_Line14 | EXTI_Line15 );
-    EXTI_ClearFlag( EXTI_Line4 | EXTI_Line5 | EXTI_Line6 | EXTI_Line7 );
+    HID_Tx_Done( endp );
+}
 
-    PWR_EnterSTOPMode(PWR_STOPEntry_WFE);
-    SystemInit();
-    SystemCoreClockUpdate();
-    USBFS_RCC_Init();
+/*********************************************************************
+ * @fn      KM_Sleep
+ *
+ * @brief   Suspend statistics, and remote wakeup from a falling edge on
+ *          PB12-PB15 or PA4-PA7. The device must draw suspend current
+ *          at most 7ms after the suspend interrupt (10ms after the bus
+ *          went idle).
+ *
+ * @param   evt - DEF_USBD_SLEEP_xx
+ *
+ * @return  1 - key or mouse input woke the chip (DEF_USBD_SLEEP_WAKE)
+ */
+static uint8_t KM_Sleep( uint8_t evt )
+{
+    uint16_t t;
 
-    if( EXTI_GetFlagStatus( EXTI_Line12 | EXTI_Line13 | EXTI_Line14 | EXTI_Line15 ) != RESET  )
+    switch( evt )
     {
-        EXTI_ClearFlag( EXTI_Line12 | EXTI_Line13 | EXTI_Line14 | EXTI_Line15 );
-        USBFS_Send_Resume( );
+        case DEF_USBD_SLEEP_SUSPEND:
+            USB_Suspend_Stamp = HID_Tx_Time( );
+            USB_Sleep_Stat.Suspend++;
+            break;
+
+        case DEF_USBD_SLEEP_STOP:
+            EXTI_ClearFlag( DEF_WAKEUP_EXTI_LINES );
+            t = HID_Tx_Time( ) - USB_Suspend_Stamp;
+            if( t > USB_Sleep_Stat.Entry_Max )
+            {
+                USB_Sleep_Stat.Entry_Max = t;
+            }
+            break;
+
+        case DEF_USBD_SLEEP_EXIT:
+            USB_Wake_Stamp = HID_Tx_Time( );
+            break;
+
+        case DEF_USBD_SLEEP_WAKE:
+            t = HID_Tx_Time( ) - USB_Wake_Stamp;
+            if( t > USB_Sleep_Stat.Restore_Max )
+            {
+                USB_Sleep_Stat.Restore_Max = t;
+            }
+            if( EXTI_GetFlagStatus( DEF_WAKEUP_EXTI_LINES ) != RESET )
+            {
+                if( USBFS_DevSleepStatus & 0x01 )
+                {
+                    return 1;
+                }
+                /* Remote wakeup not enabled by the host, stay suspended */
+                USB_Suspend_Stamp = HID_Tx_Time( );
+            }
+            break;
+
+        case DEF_USBD_SLEEP_RESUME:
+        case DEF_USBD_SLEEP_REMOTE:
+            EXTI_ClearFlag( DEF_WAKEUP_EXTI_LINES );
+            if( evt == DEF_USBD_SLEEP_REMOTE )
+            {
+                USB_Sleep_Stat.Remote_Wake++;
+            }
+            else
+            {
+                USB_Sleep_Stat.Host_Resume++;
+            }
+            USB_Wake_Sent = HID_Tx_Q[ DEF_HID_TX_KB ].Sent + HID_Tx_Q[ DEF_HID_TX_MS ].Sent;
+            USB_Wake_Pending = 1;
+            break;
+
+        default:
+            break;
+    }
+    return 0;
+}
+
+/* Class driver, interface 0 keyboard on endpoint 1, interface 1 mouse on endpoint 2 */
+const USBFS_CLASS_DRV KM_Class_Drv =
+{
+    0, 2,
+    ( 1 << DEF_UEP1 ) | ( 1 << DEF_UEP2 ),
+    KM_Init,
+    KM_Setup,
+    KM_EP0_Out,
+    NULL,
+    KM_In,
+    NULL,
+    KM_Sleep,
+};
+
+/*********************************************************************
+ * @fn      USB_Wake_Check
+ *
+ * @brief   Record the time from the last wake-up to the first report
+ *          the host ACKed after it. Called from the main loop.
+ *
+ * @return  none
+ */
+void USB_Wake_Check( void )
+{
+    uint32_t t;
+
+    if( USB_Wake_Pending == 0 )
+    {
+        return;
     }
-    else if( EXTI_GetFlagStatus( EXTI_Line4 | EXTI_Line5 | EXTI_Line6 | EXTI_Line7 ) != RESET )
+    if( USB_Wake_Sent != HID_Tx_Q[ DEF_HID_TX_KB ].Sent + HID_Tx_Q[ DEF_HID_TX_MS ].Sent )
     {
-        EXTI_ClearFlag( EXTI_Line4 | EXTI_Line5 | EXTI_Line6 | EXTI_Line7 );
-        USBFS_Send_Resume( );
+        USB_Wake_Pending = 0;
+        t = (uint16_t)( HID_Tx_Time( ) - USB_Wake_Stamp );
+        if( t > USB_Sleep_Stat.First_Max )
+        {
+            USB_Sleep_Stat.First_Max = t;
+        }
     }
-    __enable_irq();
-    printf( "Wake\r\n" );
+    else if( (uint16_t)( HID_Tx_Time( ) - USB_Wake_Stamp ) > 60000 )
+    {
+        /* Out of range of the 16-bit time base, e.g. host resume without input */
+        USB_Wake_Pending = 0;
+    }
+}
+
+/*********************************************************************
+ * @fn      USB_Sleep_Stat_Print
+ *
+ * @brief   Print the suspend and resume counters and timings.
+ *
+ * @return  none
+ */
+void USB_Sleep_Stat_Print( void )
+{
+    printf( "Suspend %d, remote wakeup %d, host resume %d\r\n",
+            USB_Sleep_Stat.Suspend, USB_Sleep_Stat.Remote_Wake, USB_Sleep_Stat.Host_Resume );
+    printf( "  suspend irq to stop max %dus\r\n", USB_Sleep_Stat.Entry_Max );
+    printf( "  clock restore max %dus\r\n", USB_Sleep_Stat.Restore_Max );
+    printf( "  wake to first report max %dus\r\n", USB_Sleep_Stat.First_Max );
 }
@@ -0,0 +1,341 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : usbd_hid_tx.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : HID interrupt-IN report queues. Reports are queued
+ *                      from the main loop and handed to USBFS_Endp_Transmit
+ *                      from the class driver's In callback as soon as the
+ *                      previous one is ACKed, so each 1ms poll carries the
+ *                      newest state.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Header Files */
+#include <ch643_usbfs_device.h>
+#include "usbd_hid_tx.h"
+
+/*******************************************************************************/
+/* Global Variable Definition */
+HID_TX_Q HID_Tx_Q[ DEF_HID_TX_NUM ];
+
+/*********************************************************************
+ * @fn      HID_Tx_Init
+ *
+ * @brief   Start the 1MHz time base and empty the report queues.
+ *
+ * @return  none
+ */
+void HID_Tx_Init( void )
+{
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure = { 0 };
+
+    /* Timer2 free-running at 1MHz, read by HID_Tx_Time */
+    RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM2, ENABLE );
+    TIM_TimeBaseStructure.TIM_Period = 0xFFFF;
+    TIM_TimeBaseStructure.TIM_Prescaler = SystemCoreClock / 1000000 - 1;
+    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseInit( TIM2, &TIM_TimeBaseStructure );
+    TIM_Cmd( TIM2, ENABLE );
+
+    memset( HID_Tx_Q, 0x00, sizeof( HID_Tx_Q ) );
+    HID_Tx_Q[ DEF_HID_TX_KB ].Endp = DEF_UEP1;
+    HID_Tx_Q[ DEF_HID_TX_KB ].Len = 8;
+    HID_Tx_Q[ DEF_HID_TX_MS ].Endp = DEF_UEP2;
+    HID_Tx_Q[ DEF_HID_TX_MS ].Len = 4;
+}
+
+/*********************************************************************
+ * @fn      HID_Tx_Time
+ *
+ * @brief   Current time stamp, 1us per count, wraps every 65.5ms.
+ *
+ * @return  time stamp
+ */
+uint16_t HID_Tx_Time( void )
+{
+    return (uint16_t)TIM2->CNT;
+}
+
+/*********************************************************************
+ * @fn      HID_Tx_Load
+ *
+ * @brief   Queue the head report on its endpoint if the endpoint is
+ *          free. Called with the USBFS interrupt masked or from it.
+ *
+ * @return  none
+ */
+static void HID_Tx_Load( HID_TX_Q *q )
+{
+    if( ( q->Busy == 0 ) && q->Cnt )
+    {
+        /* Busy before the load, the core unmasks its interrupt on return.
+         * The head report is not touched again until its In callback. */
+        q->Busy = 1;
+        if( USBFS_Endp_Transmit( q->Endp, q->Q[ q->Head ].Buf, q->Len, 0 ) != 0 )
+        {
+            q->Busy = 0;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      HID_Tx_Tail
+ *
+ * @brief   Newest report still open for coalescing, i.e. queued but not
+ *          yet loaded onto the endpoint.
+ *
+ * @return  report, NULL - none
+ */
+static HID_TX_REP *HID_Tx_Tail( HID_TX_Q *q )
+{
+    if( q->Cnt > q->Busy )
+    {
+        return &q->Q[ ( q->Head + q->Cnt - 1 ) % DEF_HID_TXQ_DEPTH ];
+    }
+    return NULL;
+}
+
+/*********************************************************************
+ * @fn      HID_Tx_Push
+ *
+ * @brief   Append one report and start it if the endpoint is idle.
+ *
+ * @return  DEF_HID_TX_QUEUED, DEF_HID_TX_DROPPED
+ */
+static uint8_t HID_Tx_Push( HID_TX_Q *q, const uint8_t *pbuf, uint16_t stamp )
+{
+    HID_TX_REP *p;
+
+    if( q->Cnt >= DEF_HID_TXQ_DEPTH )
+    {
+        q->Dropped++;
+        return DEF_HID_TX_DROPPED;
+    }
+    p = &q->Q[ ( q->Head + q->Cnt ) % DEF_HID_TXQ_DEPTH ];
+    memcpy( p->Buf, pbuf, q->Len );
+    p->Stamp = stamp;
+    q->Cnt++;
+    HID_Tx_Load( q );
+    return DEF_HID_TX_QUEUED;
+}
+
+/*********************************************************************
+ * @fn      HID_Tx_Keys_Held
+ *
+ * @brief   Whether every modifier and key pressed in one boot keyboard
+ *          report is still pressed in another, so the first report can
+ *          be replaced by the second without losing a key press.
+ *
+ * @return  1 - yes, 0 - no
+ */
+static uint8_t HID_Tx_Keys_Held( const uint8_t *old, const uint8_t *cur )
+{
+    uint8_t i, j;
+
+    if( ( old[ 0 ] & cur[ 0 ] ) != old[ 0 ] )
+    {
+        return 0;
+    }
+    for( i = 2; i < 8; i++ )
+    {
+        if( old[ i ] == 0 )
+        {
+            continue;
+        }
+        for( j = 2; j < 8; j++ )
+        {
+            if( cur[ j ] == old[ i ] )
+            {
+                break;
+            }
+        }
+        if( j == 8 )
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*********************************************************************
+ * @fn      HID_Tx_Keyboard
+ *
+ * @brief   Queue one 8-byte boot keyboard report. A report that only
+ *          adds keys replaces the newest unsent one, a report equal to
+ *          the last one queued is dropped.
+ *
+ * @param   pbuf - report
+ *          stamp - HID_Tx_Time when the key change was detected
+ *
+ * @return  DEF_HID_TX_QUEUED, DEF_HID_TX_MERGED, DEF_HID_TX_DROPPED
+ */
+uint8_t HID_Tx_Keyboard( const uint8_t *pbuf, uint16_t stamp )
+{
+    HID_TX_Q   *q = &HID_Tx_Q[ DEF_HID_TX_KB ];
+    HID_TX_REP *p;
+    uint8_t    ret = DEF_HID_TX_MERGED;
+
+    NVIC_DisableIRQ( USBFS_IRQn );
+    p = HID_Tx_Tail( q );
+    if( q->Cnt && ( memcmp( q->Q[ ( q->Head + q->Cnt - 1 ) % DEF_HID_TXQ_DEPTH ].Buf, pbuf, q->Len ) == 0 ) )
+    {
+        /* No change */
+    }
+    else if( p && HID_Tx_Keys_Held( p->Buf, pbuf ) )
+    {
+        memcpy( p->Buf, pbuf, q->Len );
+        q->Merged++;
+    }
+    else
+    {
+        ret = HID_Tx_Push( q, pbuf, stamp );
+    }
+    NVIC_EnableIRQ( USBFS_IRQn );
+
+    return ret;
+}
+
+/*********************************************************************
+ * @fn      HID_Tx_Mouse
+ *
+ * @brief   Queue one relative mouse movement. Movements with unchanged
+ *          buttons are summed into the newest unsent report while the
+ *          sums fit in a report.
+ *
+ * @param   btn - button bits
+ *          dx, dy, wheel - relative movement
+ *          stamp - HID_Tx_Time when the movement was detected
+ *
+ * @return  DEF_HID_TX_QUEUED, DEF_HID_TX_MERGED, DEF_HID_TX_DROPPED
+ */
+uint8_t HID_Tx_Mouse( uint8_t btn, int8_t dx, int8_t dy, int8_t wheel, uint16_t stamp )
+{
+    HID_TX_Q   *q = &HID_Tx_Q[ DEF_HID_TX_MS ];
+    HID_TX_REP *p;
+    int16_t    x, y, w;
+    uint8_t    rep[ 4 ];
+    uint8_t    ret;
+
+    NVIC_DisableIRQ( USBFS_IRQn );
+    p = HID_Tx_Tail( q );
+    if( p && ( p->Buf[ 0 ] == btn ) )
+    {
+        x = (int8_t)p->Buf[ 1 ] + dx;
+        y = (int8_t)p->Buf[ 2 ] + dy;
+        w = (int8_t)p->Buf[ 3 ] + wheel;
+        if( ( x >= -127 ) && ( x <= 127 ) && ( y >= -127 ) && ( y <= 127 ) && ( w >= -127 ) && ( w <= 127 ) )
+        {
+            p->Buf[ 1 ] = (uint8_t)x;
+            p->Buf[ 2 ] = (uint8_t)y;
+            p->Buf[ 3 ] = (uint8_t)w;
+            q->Merged++;
+            NVIC_EnableIRQ( USBFS_IRQn );
+            return DEF_HID_TX_MERGED;
+        }
+    }
+    rep[ 0 ] = btn;
+    rep[ 1 ] = (uint8_t)dx;
+    rep[ 2 ] = (uint8_t)dy;
+    rep[ 3 ] = (uint8_t)wheel;
+    ret = HID_Tx_Push( q, rep, stamp );
+    NVIC_EnableIRQ( USBFS_IRQn );
+
+    return ret;
+}
+
+/*********************************************************************
+ * @fn      HID_Tx_Done
+ *
+ * @brief   The report on one endpoint has been ACKed: record its latency
+ *          and load the next one. Called from the USBFS interrupt.
+ *
+ * @param   endp - endpoint number
+ *
+ * @return  none
+ */
+void HID_Tx_Done( uint8_t endp )
+{
+    HID_TX_Q *q;
+    uint16_t lat;
+    uint8_t  i;
+
+    for( i = 0; i < DEF_HID_TX_NUM; i++ )
+    {
+        q = &HID_Tx_Q[ i ];
+        if( ( q->Endp != endp ) || ( q->Busy == 0 ) )
+        {
+            continue;
+        }
+
+        lat = HID_Tx_Time( ) - q->Q[ q->Head ].Stamp;
+        if( lat > q->Lat_Max )
+        {
+            q->Lat_Max = lat;
+        }
+        lat /= DEF_HID_LAT_BIN_US;
+        q->Lat_Hist[ ( lat < DEF_HID_LAT_BINS ) ? lat : ( DEF_HID_LAT_BINS - 1 ) ]++;
+        q->Sent++;
+
+        q->Head = ( q->Head + 1 ) % DEF_HID_TXQ_DEPTH;
+        q->Cnt--;
+        q->Busy = 0;
+        HID_Tx_Load( q );
+    }
+}
+
+/*********************************************************************
+ * @fn      HID_Tx_Reset
+ *
+ * @brief   Drop every queued report, called on usb bus reset.
+ *
+ * @return  none
+ */
+void HID_Tx_Reset( void )
+{
+    uint8_t i;
+
+    for( i = 0; i < DEF_HID_TX_NUM; i++ )
+    {
+        HID_Tx_Q[ i ].Head = 0;
+        HID_Tx_Q[ i ].Cnt = 0;
+        HID_Tx_Q[ i ].Busy = 0;
+    }
+}
+
+/*********************************************************************
+ * @fn      HID_Tx_Stat_Print
+ *
+ * @brief   Print the report counters and latency histograms.
+ *
+ * @return  none
+ */
+void HID_Tx_Stat_Print( void )
+{
+    HID_TX_Q *q;
+    uint8_t  i, j;
+
+    for( i = 0; i < DEF_HID_TX_NUM; i++ )
+    {
+        q = &HID_Tx_Q[ i ];
+        printf( "%s sent %d merged %d dropped %d max %dus\r\n", ( i == DEF_HID_TX_KB ) ? "KB" : "MS",
+                q->Sent, q->Merged, q->Dropped, q->Lat_Max );
+        for( j = 0; j < DEF_HID_LAT_BINS; j++ )
+        {
+            if( j < DEF_HID_LAT_BINS - 1 )
+            {
+                printf( "  <%4dus: %d\r\n", ( j + 1 ) * DEF_HID_LAT_BIN_US, q->Lat_Hist[ j ] );
+            }
+            else
+            {
+                printf( " >=%4dus: %d\r\n", j * DEF_HID_LAT_BIN_US, q->Lat_Hist[ j ] );
+            }
+        }
+    }
+}
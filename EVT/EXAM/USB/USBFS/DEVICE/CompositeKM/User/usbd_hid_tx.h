@@ -0,0 +1,86 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : usbd_hid_tx.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : HID interrupt-IN report queues with coalescing and
+ *                      event-to-ACK latency statistics.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef __USBD_HID_TX_H
+#define __USBD_HID_TX_H
+
+/*******************************************************************************/
+/* Header Files */
+#include "debug.h"
+#include "string.h"
+
+/*******************************************************************************/
+/* Macro Definition */
+
+/* Report queues, one per interrupt IN endpoint */
+#define DEF_HID_TX_KB               0                                           /* Keyboard, endpoint 1 */
+#define DEF_HID_TX_MS               1                                           /* Mouse, endpoint 2 */
+#define DEF_HID_TX_NUM              2
+
+#define DEF_HID_TXQ_DEPTH           4                                           /* Reports per queue, including the one on the endpoint */
+#define DEF_HID_REPORT_MAX          8                                           /* Longest report */
+
+/* Latency histogram, event to endpoint ACK: DEF_HID_LAT_BINS - 1 bins of
+ * DEF_HID_LAT_BIN_US each, the last bin takes everything slower */
+#define DEF_HID_LAT_BIN_US          250
+#define DEF_HID_LAT_BINS            10
+
+/* Return value of HID_Tx_Keyboard / HID_Tx_Mouse */
+#define DEF_HID_TX_QUEUED           0x00                                        /* New report queued */
+#define DEF_HID_TX_MERGED           0x01                                        /* Folded into a report not yet sent */
+#define DEF_HID_TX_DROPPED          0x02                                        /* Queue full, report lost */
+
+/*******************************************************************************/
+/* Type Definition */
+
+/* One queued report */
+typedef struct _HID_TX_REP
+{
+    uint8_t  Buf[ DEF_HID_REPORT_MAX ];
+    uint16_t Stamp;                                                             /* HID_Tx_Time of the oldest event folded in */
+} HID_TX_REP;
+
+/* One report queue. Head is on the endpoint while Busy is set, entries
+ * behind it are still open for coalescing. */
+typedef struct _HID_TX_Q
+{
+    uint8_t  Endp;
+    uint8_t  Len;                                                               /* Report length */
+    HID_TX_REP Q[ DEF_HID_TXQ_DEPTH ];
+    uint8_t  Head;
+    volatile uint8_t Cnt;
+    volatile uint8_t Busy;
+
+    /* Statistics */
+    uint32_t Sent;
+    uint32_t Merged;
+    uint32_t Dropped;
+    uint16_t Lat_Max;                                                           /* Us */
+    uint32_t Lat_Hist[ DEF_HID_LAT_BINS ];
+} HID_TX_Q;
+
+/*******************************************************************************/
+/* Global Variable Declaration */
+extern HID_TX_Q HID_Tx_Q[ DEF_HID_TX_NUM ];
+
+/*******************************************************************************/
+/* Function Declaration */
+extern void     HID_Tx_Init( void );
+extern uint16_t HID_Tx_Time( void );
+extern uint8_t  HID_Tx_Keyboard( const uint8_t *pbuf, uint16_t stamp );
+extern uint8_t  HID_Tx_Mouse( uint8_t btn, int8_t dx, int8_t dy, int8_t wheel, uint16_t stamp );
+extern void     HID_Tx_Done( uint8_t endp );
+extern void     HID_Tx_Reset( void );
+extern void     HID_Tx_Stat_Print( void );
+
+#endif
@@ -22,6 +22,10 @@
  * 'A' -> 0x04
  * 'S' -> 0x16
  * 'D' -> 0x07
+ * On bus suspend the main loop puts the chip into Stop mode. A falling edge on
+ * PB12-PB15 or PA4-PA7 wakes it and, if the host enabled remote wakeup, signals
+ * resume; otherwise it goes back to Stop. Host resume wakes it through the USBFS
+ * wake-up event (EXTI line 28).
  */
 
 #include <ch643_usbfs_device.h>
@@ -66,9 +70,9 @@ int main(void)
 
 
     /* Usb Init */
+    USBFS_Class_Register( &KM_Class_Drv );
     USBFS_RCC_Init( );
     USBFS_Device_Init( ENABLE , PWR_VDD_SupplyVoltage());
-    USB_Sleep_Wakeup_CFG( );
 
     while(1)
     {
@@ -90,5 +94,8 @@ int main(void)
                 USART2_Receive_Handle( );
             }
         }
+
+        /* Bus suspended, enter Stop mode until resumed */
+        USBFS_Device_Sleep( );
     }
 }
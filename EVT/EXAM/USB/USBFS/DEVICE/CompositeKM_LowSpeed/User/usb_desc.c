@@ -218,7 +218,7 @@ const uint8_t MyManuInfo[ ] =
 /* Product Information */
 const uint8_t MyProdInfo[ ]  =
 {
-    0x12,
+    0x0C,
     0x03,
     'C',
     0,
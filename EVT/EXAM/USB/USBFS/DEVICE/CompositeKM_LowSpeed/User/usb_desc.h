@@ -31,6 +31,9 @@
 /* USB Device Descriptor, Device Serial Number(bcdDevice) */
 #define DEF_IC_PRG_VER                DEF_FILE_VERSION
 
+/* Low speed device, see USBD_Lib */
+#define DEF_USBD_LOW_SPEED            1
+
 /* USB Device Endpoint Size */
 #define DEF_USBD_UEP0_SIZE            8     /* usb hs/fs device end-point 0 size */
 /* HS */
@@ -15,6 +15,7 @@
 
 /*******************************************************************************/
 /* Header Files */
+#include <ch643_usbfs_device.h>
 #include "debug.h"
 #include "string.h"
 #include "usb_desc.h"
@@ -26,10 +27,16 @@
 #define DEF_KEY_CHAR_S              0x16                                        /* "S" */
 #define DEF_KEY_CHAR_D              0x07                                        /* "D" */
 
+/*******************************************************************************/
+/* Suspend: inputs that signal remote wakeup, PB12-PB15 and PA4-PA7 */
+#define DEF_WAKEUP_EXTI_LINES       ( EXTI_Line4 | EXTI_Line5 | EXTI_Line6 | EXTI_Line7 | \
+                                      EXTI_Line12 | EXTI_Line13 | EXTI_Line14 | EXTI_Line15 )
+
 /*******************************************************************************/
 /* Global Variable Declaration */
 extern volatile uint8_t  KB_LED_Last_Status;
 extern volatile uint8_t  KB_LED_Cur_Status;
+extern const USBFS_CLASS_DRV KM_Class_Drv;
 
 
 /*******************************************************************************/
@@ -46,8 +53,6 @@ extern void MS_Scan_Init( void );
 extern void MS_Sleep_Wakeup_Cfg( void );
 extern void MS_Scan( void );
 extern void MS_Scan_Handle( void );
-extern void USB_Sleep_Wakeup_CFG( void );
-extern void MCU_Sleep_Wakeup_Operate( void );
 
 
 #endif
@@ -32,6 +32,10 @@ uint8_t  KB_Data_Pack[ 8 ] = { 0x00 };
 volatile uint8_t  KB_LED_Last_Status = 0x00;                                    // Keyboard LED Last Result
 volatile uint8_t  KB_LED_Cur_Status = 0x00;                                     // Keyboard LED Current Result
 
+/* HID Class Command, one per interface */
+volatile uint8_t  USBFS_HidIdle[ 2 ];
+volatile uint8_t  USBFS_HidProtocol[ 2 ];
+
 /* USART */
 volatile uint8_t  USART_Recv_Dat = 0x00;
 volatile uint8_t  USART_Send_Flag = 0x00;
@@ -199,7 +203,7 @@ void USART2_Receive_Handle( void )
         /* Load keyboard data to endpoint 1 */
         status = USBFS_Endp_DataUp( DEF_UEP1, KB_Data_Pack, sizeof( KB_Data_Pack ), DEF_UEP_CPY_LOAD );
 
-        if( status == READY )
+        if( status == 0 )
         {
             /* Enable timing for uploading the key value */
             USART_Send_Cnt = 0;
@@ -225,7 +229,7 @@ void USART2_Receive_Handle( void )
         status = USBFS_Endp_DataUp( DEF_UEP1, KB_Data_Pack, sizeof( KB_Data_Pack ), DEF_UEP_CPY_LOAD );
 
         /* Clear variables for next reception */
-        if( status == READY )
+        if( status == 0 )
         {
             USART_Recv_Dat = 0;
             flag = 0;
@@ -443,7 +447,7 @@ void KB_Scan_Handle( void )
         /* Load keyboard data to endpoint 1 */
         status = USBFS_Endp_DataUp( DEF_UEP1, KB_Data_Pack, sizeof( KB_Data_Pack ), DEF_UEP_CPY_LOAD );
 
-        if( status == READY )
+        if( status == 0 )
         {
             /* Clear flag after successful loading */
             flag = 0;
@@ -649,7 +653,7 @@ void MS_Scan_Handle( void )
         /* Load mouse data to endpoint 2 */
         status = USBFS_Endp_DataUp( DEF_UEP2, MS_Data_Pack, sizeof( MS_Data_Pack ), DEF_UEP_CPY_LOAD );
 
-        if( status == READY )
+        if( status == 0 )
         {
             /* Clear flag after successful loading */
             flag = 0;
@@ -658,52 +662,167 @@ void MS_Scan_Handle( void )
 }
 
 /*********************************************************************
- * @fn      USB_Sleep_Wakeup_CFG
+ * @fn      KM_Init
  *
- * @brief   Configure USB wake up mode
+ * @brief   Open the keyboard and mouse IN endpoints, called on device
+ *          init and bus reset.
  *
  * @return  none
  */
-void USB_Sleep_Wakeup_CFG( void )
+static void KM_Init( void )
 {
-    EXTI_InitTypeDef EXTI_InitStructure = { 0 };
-
-    EXTI_InitStructure.EXTI_Line = EXTI_Line28;
-    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Event;
-    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising;
-    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
-    EXTI_Init( &EXTI_InitStructure );
+    USBFS_Endp_Open( DEF_UEP1, USBFSD_UEP_TX_EN, DEF_USB_EP1_LS_SIZE );
+    USBFS_Endp_Open( DEF_UEP2, USBFSD_UEP_TX_EN, DEF_USB_EP2_LS_SIZE );
 }
 
 /*********************************************************************
- * @fn      MCU_Sleep_Wakeup_Operate
+ * @fn      KM_Setup
  *
- * @brief   Perform sleep operation
+ * @brief   HID class requests and the HID/report descriptors of
+ *          interface 0 (keyboard) and interface 1 (mouse).
  *
- * @return  none
+ * @return  DEF_USBD_REQ_OK or DEF_USBD_REQ_ERR
  */
-void MCU_Sleep_Wakeup_Operate( void )
+static uint8_t KM_Setup( const uint8_t **ppbuf, uint16_t *plen )
 {
-    printf( "Sleep\r\n" );
-    __disable_irq();
-    EXTI_ClearFlag( EXTI_Line12 | EXTI_Line13 | EXTI_Line14 | EXTI_Line15 );
-    EXTI_ClearFlag( EXTI_Line4 | EXTI_Line5 | EXTI_Line6 | EXTI_Line7 );
+    uint8_t itf = (uint8_t)USBFS_SetupReqIndex;
 
-    PWR_EnterSTOPMode(PWR_STOPEntry_WFE);
-    SystemInit();
-    SystemCoreClockUpdate();
-    USBFS_RCC_Init();
+    if( ( ( USBFS_SetupReqType & USB_REQ_RECIP_MASK ) != USB_REQ_RECIP_INTERF ) || ( itf > 1 ) )
+    {
+        return DEF_USBD_REQ_ERR;
+    }
 
-    if( EXTI_GetFlagStatus( EXTI_Line12 | EXTI_Line13 | EXTI_Line14 | EXTI_Line15 ) != RESET  )
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_STANDARD )
     {
-        EXTI_ClearFlag( EXTI_Line12 | EXTI_Line13 | EXTI_Line14 | EXTI_Line15 );
-        USBFS_Send_Resume( );
+        if( USBFS_SetupReqCode != USB_GET_DESCRIPTOR )
+        {
+            return DEF_USBD_REQ_ERR;
+        }
+        switch( (uint8_t)( USBFS_SetupReqValue >> 8 ) )
+        {
+            /* get usb hid descriptor */
+            case USB_DESCR_TYP_HID:
+                *ppbuf = ( itf == 0 ) ? &MyCfgDescr[ 18 ] : &MyCfgDescr[ 43 ];
+                *plen = 9;
+                break;
+
+            /* get usb report descriptor */
+            case USB_DESCR_TYP_REPORT:
+                if( itf == 0 )
+                {
+                    *ppbuf = KeyRepDesc;
+                    *plen = DEF_USBD_REPORT_DESC_LEN_KB;
+                }
+                else
+                {
+                    *ppbuf = MouseRepDesc;
+                    *plen = DEF_USBD_REPORT_DESC_LEN_MS;
+                }
+                break;
+
+            default:
+                return DEF_USBD_REQ_ERR;
+        }
+        return DEF_USBD_REQ_OK;
     }
-    else if( EXTI_GetFlagStatus( EXTI_Line4 | EXTI_Line5 | EXTI_Line6 | EXTI_Line7 ) != RESET )
+
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) != USB_REQ_TYP_CLASS )
     {
-        EXTI_ClearFlag( EXTI_Line4 | EXTI_Line5 | EXTI_Line6 | EXTI_Line7 );
-        USBFS_Send_Resume( );
+        return DEF_USBD_REQ_ERR;
+    }
+    switch( USBFS_SetupReqCode )
+    {
+        case HID_SET_REPORT:
+            break;
+
+        case HID_SET_IDLE:
+            USBFS_HidIdle[ itf ] = (uint8_t)( USBFS_SetupReqValue >> 8 );
+            break;
+
+        case HID_SET_PROTOCOL:
+            USBFS_HidProtocol[ itf ] = (uint8_t)USBFS_SetupReqValue;
+            break;
+
+        case HID_GET_IDLE:
+            USBFS_EP0_4Buf[ 0 ] = USBFS_HidIdle[ itf ];
+            if( USBFS_SetupReqLen > 1 )
+            {
+                USBFS_SetupReqLen = 1;
+            }
+            break;
+
+        case HID_GET_PROTOCOL:
+            USBFS_EP0_4Buf[ 0 ] = USBFS_HidProtocol[ itf ];
+            if( USBFS_SetupReqLen > 1 )
+            {
+                USBFS_SetupReqLen = 1;
+            }
+            break;
+
+        default:
+            return DEF_USBD_REQ_ERR;
+    }
+    return DEF_USBD_REQ_OK;
+}
+
+/*********************************************************************
+ * @fn      KM_EP0_Out
+ *
+ * @brief   Set_Report data of the keyboard, the LED state.
+ *
+ * @return  none
+ */
+static void KM_EP0_Out( uint8_t *pbuf, uint16_t len )
+{
+    if( ( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_CLASS ) &&
+        ( USBFS_SetupReqCode == HID_SET_REPORT ) && ( USBFS_SetupReqIndex == 0 ) && len )
+    {
+        KB_LED_Cur_Status = pbuf[ 0 ];
     }
-    __enable_irq();
-    printf( "Wake\r\n" );
 }
+
+/*********************************************************************
+ * @fn      KM_Sleep
+ *
+ * @brief   Remote wakeup from a falling edge on PB12-PB15 or PA4-PA7.
+ *
+ * @param   evt - DEF_USBD_SLEEP_xx
+ *
+ * @return  1 - key or mouse input woke the chip (DEF_USBD_SLEEP_WAKE)
+ */
+static uint8_t KM_Sleep( uint8_t evt )
+{
+    switch( evt )
+    {
+        case DEF_USBD_SLEEP_STOP:
+        case DEF_USBD_SLEEP_RESUME:
+        case DEF_USBD_SLEEP_REMOTE:
+            EXTI_ClearFlag( DEF_WAKEUP_EXTI_LINES );
+            break;
+
+        case DEF_USBD_SLEEP_WAKE:
+            if( EXTI_GetFlagStatus( DEF_WAKEUP_EXTI_LINES ) != RESET )
+            {
+                return 1;
+            }
+            break;
+
+        default:
+            break;
+    }
+    return 0;
+}
+
+/* Class driver, interface 0 keyboard on endpoint 1, interface 1 mouse on endpoint 2 */
+const USBFS_CLASS_DRV KM_Class_Drv =
+{
+    0, 2,
+    ( 1 << DEF_UEP1 ) | ( 1 << DEF_UEP2 ),
+    KM_Init,
+    KM_Setup,
+    KM_EP0_Out,
+    NULL,
+    NULL,
+    NULL,
+    KM_Sleep,
+};
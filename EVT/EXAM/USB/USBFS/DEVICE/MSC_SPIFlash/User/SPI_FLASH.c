@@ -0,0 +1,328 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : SPI_FLASH.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Winbond W25Qxx SPI flash driver (from SPI/SPI_FLASH).
+ *                      Sector buffering is left to the disk cache, so there
+ *                      is no read-erase-rewrite SPI_Flash_Write here.
+ *********************************************************************************
+ * Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+ * Attention: This software (modified or not) and binary are used for
+ * microcontroller manufactured by Nanjing Qinheng Microelectronics.
+ *******************************************************************************/
+
+#include "SPI_FLASH.h"
+
+/*********************************************************************
+ * @fn      SPI1_ReadWriteByte
+ *
+ * @brief   SPI1 read or write one byte.
+ *
+ * @param   TxData - write one byte data.
+ *
+ * @return  Read one byte data.
+ */
+static u8 SPI1_ReadWriteByte(u8 TxData)
+{
+    u8 i = 0;
+
+    while(SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE) == RESET)
+    {
+        i++;
+        if(i > 200)
+            return 0;
+    }
+
+    SPI_I2S_SendData(SPI1, TxData);
+    i = 0;
+
+    while(SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE) == RESET)
+    {
+        i++;
+        if(i > 200)
+            return 0;
+    }
+
+    return SPI_I2S_ReceiveData(SPI1);
+}
+
+/*********************************************************************
+ * @fn      SPI_Flash_Init
+ *
+ * @brief   Configuring the SPI for operation flash.
+ *
+ * @return  none
+ */
+void SPI_Flash_Init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure = {0};
+    SPI_InitTypeDef  SPI_InitStructure = {0};
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA | RCC_APB2Periph_SPI1, ENABLE);
+
+    GPIO_InitStructure.GPIO_Pin = DEF_FLASH_CS_PIN;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(DEF_FLASH_CS_PORT, &GPIO_InitStructure);
+    FLASH_CS_HIGH( );
+
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_5;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(GPIOA, &GPIO_InitStructure);
+
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_6;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
+    GPIO_Init(GPIOA, &GPIO_InitStructure);
+
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_7;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(GPIOA, &GPIO_InitStructure);
+
+    SPI_InitStructure.SPI_Direction = SPI_Direction_2Lines_FullDuplex;
+    SPI_InitStructure.SPI_Mode = SPI_Mode_Master;
+    SPI_InitStructure.SPI_DataSize = SPI_DataSize_8b;
+    SPI_InitStructure.SPI_CPOL = SPI_CPOL_High;
+    SPI_InitStructure.SPI_CPHA = SPI_CPHA_2Edge;
+    SPI_InitStructure.SPI_NSS = SPI_NSS_Soft;
+    SPI_InitStructure.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_4;
+    SPI_InitStructure.SPI_FirstBit = SPI_FirstBit_MSB;
+    SPI_InitStructure.SPI_CRCPolynomial = 7;
+    SPI_Init(SPI1, &SPI_InitStructure);
+
+    SPI_Cmd(SPI1, ENABLE);
+}
+
+/*********************************************************************
+ * @fn      SPI_Flash_ReadSR
+ *
+ * @brief   Read W25Qxx status register.
+ *        ！！BIT7  6   5   4   3   2   1   0
+ *        ！！SPR   RV  TB  BP2 BP1 BP0 WEL BUSY
+ *
+ * @return  byte - status register value.
+ */
+u8 SPI_Flash_ReadSR(void)
+{
+    u8 byte = 0;
+
+    FLASH_CS_LOW( );
+    SPI1_ReadWriteByte(W25X_ReadStatusReg);
+    byte = SPI1_ReadWriteByte(0Xff);
+    FLASH_CS_HIGH( );
+
+    return byte;
+}
+
+/*********************************************************************
+ * @fn      SPI_Flash_Wait_Busy
+ *
+ * @brief   Wait flash free.
+ *
+ * @return  none
+ */
+void SPI_Flash_Wait_Busy(void)
+{
+    while((SPI_Flash_ReadSR() & 0x01) == 0x01);
+}
+
+/*********************************************************************
+ * @fn      SPI_FLASH_Write_Enable
+ *
+ * @brief   Enable flash write.
+ *
+ * @return  none
+ */
+static void SPI_FLASH_Write_Enable(void)
+{
+    FLASH_CS_LOW( );
+    SPI1_ReadWriteByte(W25X_WriteEnable);
+    FLASH_CS_HIGH( );
+}
+
+/*********************************************************************
+ * @fn      SPI_Flash_ReadID
+ *
+ * @brief   Read flash ID.
+ *
+ * @return  Temp - FLASH ID.
+ */
+u16 SPI_Flash_ReadID(void)
+{
+    u16 Temp = 0;
+
+    FLASH_CS_LOW( );
+    SPI1_ReadWriteByte(W25X_ManufactDeviceID);
+    SPI1_ReadWriteByte(0x00);
+    SPI1_ReadWriteByte(0x00);
+    SPI1_ReadWriteByte(0x00);
+    Temp |= SPI1_ReadWriteByte(0xFF) << 8;
+    Temp |= SPI1_ReadWriteByte(0xFF);
+    FLASH_CS_HIGH( );
+
+    return Temp;
+}
+
+/*********************************************************************
+ * @fn      SPI_Flash_Capacity
+ *
+ * @brief   Size of a W25Q80 - W25Q128 from its ID, the low byte is
+ *          log2 of the size in bytes minus one.
+ *
+ * @return  size in bytes, 0 - unknown chip
+ */
+u32 SPI_Flash_Capacity(u16 id)
+{
+    if((id < W25Q80) || (id > W25Q128))
+    {
+        return 0;
+    }
+    return (u32)1 << ((id & 0xFF) + 1);
+}
+
+/*********************************************************************
+ * @fn      SPI_Flash_Erase_Sector
+ *
+ * @brief   Erase one sector(4Kbyte).
+ *
+ * @param   Dst_Addr - sector number
+ *
+ * @return  none
+ */
+void SPI_Flash_Erase_Sector(u32 Dst_Addr)
+{
+    Dst_Addr *= DEF_FLASH_SECTOR_SIZE;
+    SPI_FLASH_Write_Enable();
+    SPI_Flash_Wait_Busy();
+    FLASH_CS_LOW( );
+    SPI1_ReadWriteByte(W25X_SectorErase);
+    SPI1_ReadWriteByte((u8)((Dst_Addr) >> 16));
+    SPI1_ReadWriteByte((u8)((Dst_Addr) >> 8));
+    SPI1_ReadWriteByte((u8)Dst_Addr);
+    FLASH_CS_HIGH( );
+    SPI_Flash_Wait_Busy();
+}
+
+/*********************************************************************
+ * @fn      SPI_Flash_Read
+ *
+ * @brief   Read data from flash. The data phase keeps the transmit
+ *          register full, so the clock runs without gaps between bytes.
+ *
+ * @param   pBuffer -
+ *          ReadAddr -Initial address(24bit).
+ *          size - Data length.
+ *
+ * @return  none
+ */
+void SPI_Flash_Read(u8 *pBuffer, u32 ReadAddr, u16 size)
+{
+    u16 tx;
+    u16 rx;
+
+    FLASH_CS_LOW( );
+    SPI1_ReadWriteByte(W25X_ReadData);
+    SPI1_ReadWriteByte((u8)((ReadAddr) >> 16));
+    SPI1_ReadWriteByte((u8)((ReadAddr) >> 8));
+    SPI1_ReadWriteByte((u8)ReadAddr);
+
+    /* At most two bytes in flight, one shifting and one in the data register */
+    for(tx = 0, rx = 0; rx < size;)
+    {
+        if((tx < size) && (tx - rx < 2) && (SPI1->STATR & SPI_I2S_FLAG_TXE))
+        {
+            SPI1->DATAR = 0xFF;
+            tx++;
+        }
+        if(SPI1->STATR & SPI_I2S_FLAG_RXNE)
+        {
+            pBuffer[rx++] = (u8)SPI1->DATAR;
+        }
+    }
+
+    FLASH_CS_HIGH( );
+}
+
+/*********************************************************************
+ * @fn      SPI_Flash_Write_Page
+ *
+ * @brief   Write data by one page.
+ *
+ * @param   pBuffer -
+ *          WriteAddr - Initial address(24bit).
+ *          size - Data length.
+ *
+ * @return  none
+ */
+void SPI_Flash_Write_Page(u8 *pBuffer, u32 WriteAddr, u16 size)
+{
+    u16 i;
+
+    SPI_FLASH_Write_Enable();
+    FLASH_CS_LOW( );
+    SPI1_ReadWriteByte(W25X_PageProgram);
+    SPI1_ReadWriteByte((u8)((WriteAddr) >> 16));
+    SPI1_ReadWriteByte((u8)((WriteAddr) >> 8));
+    SPI1_ReadWriteByte((u8)WriteAddr);
+
+    for(i = 0; i < size; i++){
+        SPI1_ReadWriteByte(pBuffer[i]);
+    }
+
+    FLASH_CS_HIGH( );
+    SPI_Flash_Wait_Busy();
+}
+
+/*********************************************************************
+ * @fn      SPI_Flash_Write_NoCheck
+ *
+ * @brief   Write data to flash.(need Erase)
+ *          All data in address rang is 0xFF. Pages that stay all 0xFF
+ *          are not programmed.
+ *
+ * @param   pBuffer -
+ *          WriteAddr - Initial address(24bit).
+ *          size - Data length.
+ *
+ * @return  none
+ */
+void SPI_Flash_Write_NoCheck(u8 *pBuffer, u32 WriteAddr, u16 size)
+{
+    u16 pageremain;
+    u16 i;
+
+    pageremain = DEF_FLASH_PAGE_SIZE - WriteAddr % DEF_FLASH_PAGE_SIZE;
+
+    if(size <= pageremain)
+        pageremain = size;
+
+    while(1)
+    {
+        for(i = 0; i < pageremain; i++)
+        {
+            if(pBuffer[i] != 0xFF)
+            {
+                SPI_Flash_Write_Page(pBuffer, WriteAddr, pageremain);
+                break;
+            }
+        }
+
+        if(size == pageremain)
+        {
+            break;
+        }
+        else
+        {
+            pBuffer += pageremain;
+            WriteAddr += pageremain;
+            size -= pageremain;
+
+            if(size > DEF_FLASH_PAGE_SIZE)
+                pageremain = DEF_FLASH_PAGE_SIZE;
+            else
+                pageremain = size;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : SPI_FLASH.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : header file of SPI_FLASH.c
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef USER_SPI_FLASH_H_
+#define USER_SPI_FLASH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "debug.h"
+
+/******************************************************************************/
+/* Winbond SPIFalsh ID */
+#define W25Q80                   0XEF13
+#define W25Q16                   0XEF14
+#define W25Q32                   0XEF15
+#define W25Q64                   0XEF16
+#define W25Q128                  0XEF17
+
+/* Winbond SPIFalsh Instruction List */
+#define W25X_WriteEnable         0x06
+#define W25X_WriteDisable        0x04
+#define W25X_ReadStatusReg       0x05
+#define W25X_WriteStatusReg      0x01
+#define W25X_ReadData            0x03
+#define W25X_FastReadData        0x0B
+#define W25X_FastReadDual        0x3B
+#define W25X_PageProgram         0x02
+#define W25X_BlockErase          0xD8
+#define W25X_SectorErase         0x20
+#define W25X_ChipErase           0xC7
+#define W25X_PowerDown           0xB9
+#define W25X_ReleasePowerDown    0xAB
+#define W25X_DeviceID            0xAB
+#define W25X_ManufactDeviceID    0x90
+#define W25X_JedecDeviceID       0x9F
+
+/* Geometry */
+#define DEF_FLASH_PAGE_SIZE      256
+#define DEF_FLASH_SECTOR_SIZE    4096
+
+/* Chip select, SPI1 on PA5(SCK)/PA6(MISO)/PA7(MOSI) */
+#define DEF_FLASH_CS_PORT        GPIOA
+#define DEF_FLASH_CS_PIN         GPIO_Pin_2
+#define FLASH_CS_LOW( )          ( DEF_FLASH_CS_PORT->BCR = DEF_FLASH_CS_PIN )
+#define FLASH_CS_HIGH( )         ( DEF_FLASH_CS_PORT->BSHR = DEF_FLASH_CS_PIN )
+
+/******************************************************************************/
+/* external functions */
+extern void SPI_Flash_Init( void );
+extern u8   SPI_Flash_ReadSR( void );
+extern void SPI_Flash_Wait_Busy( void );
+extern u16  SPI_Flash_ReadID( void );
+extern u32  SPI_Flash_Capacity( u16 id );
+extern void SPI_Flash_Erase_Sector( u32 Dst_Addr );
+extern void SPI_Flash_Read( u8 *pBuffer, u32 ReadAddr, u16 size );
+extern void SPI_Flash_Write_Page( u8 *pBuffer, u32 WriteAddr, u16 size );
+extern void SPI_Flash_Write_NoCheck( u8 *pBuffer, u32 WriteAddr, u16 size );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_SPI_FLASH_H_ */
@@ -0,0 +1,39 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : ch643_conf.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2023/04/06
+ * Description        : Library configuration file.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for 
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#ifndef __CH643_CONF_H
+#define __CH643_CONF_H
+
+#include "ch643_adc.h"
+#include "ch643_awu.h"
+#include "ch643_dbgmcu.h"
+#include "ch643_dma.h"
+#include "ch643_exti.h"
+#include "ch643_flash.h"
+#include "ch643_gpio.h"
+#include "ch643_i2c.h"
+#include "ch643_iwdg.h"
+#include "ch643_pwr.h"
+#include "ch643_rcc.h"
+#include "ch643_spi.h"
+#include "ch643_tim.h"
+#include "ch643_usart.h"
+#include "ch643_wwdg.h"
+#include "ch643_it.h"
+#include "ch643_misc.h"
+#include "ch643_usb.h"
+
+#endif
+
+
+	
+	
+	
@@ -0,0 +1,85 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : main.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Main program body.
+ *********************************************************************************
+ * Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+ * Attention: This software (modified or not) and binary are used for 
+ * microcontroller manufactured by Nanjing Qinheng Microelectronics.
+ *******************************************************************************/
+/*
+ *@Note
+  This routine demonstrates the use of USBFS to emulate a USB flash drive
+  (mass storage, Bulk-Only Transport, SCSI) on a Winbond W25Qxx SPI flash.
+  The mass storage class (usbd_msc.c) is a class driver on the shared USBFS
+  device core (../USBD_Lib). Endpoint 1 IN sends straight from, and endpoint 2
+  OUT receives straight into, a write-back cache of two 4K flash blocks
+  (msc_cache.c): a block is erased and programmed once when its buffer is
+  reused, on SYNCHRONIZE CACHE / eject / medium removal allowed, or after
+  200ms without commands, and the next block is read ahead during reads.
+  All flash work runs in the main loop, the endpoints NAK meanwhile.
+  Unplugging within 200ms of a write may lose the cached blocks.
+  The throughput and cache counters are printed once a second.
+  pins:
+    CS   -- PA2
+    DO   -- PA6(SPI1_MISO)
+    WP   -- 3.3V
+    DI   -- PA7(SPI1_MOSI)
+    CLK  -- PA5(SPI1_SCK)
+    HOLD -- 3.3V
+*/
+
+#include "usbd_msc.h"
+#include "debug.h"
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Main program.
+ *
+ * @return  none
+ */
+int main(void)
+{
+    uint16_t id;
+    uint32_t frame;
+    uint32_t rd_total, wr_total;
+
+    SystemCoreClockUpdate();
+    Delay_Init();
+    USART_Printf_Init(115200);
+    printf("SystemClk:%d\r\n", SystemCoreClock);
+    printf("ChipID:%08x\r\n", DBGMCU_GetCHIPID() );
+
+    /* Flash and cache Init */
+    id = Cache_Init( );
+    printf( "Flash ID:%04x, %d sectors\r\n", id, (int)Cache_Sec_Num );
+
+    /* Usb Init */
+    USBFS_Class_Register( &MSC_Class_Drv );
+    USBFS_RCC_Init( );
+    USBFS_Device_Init( ENABLE , PWR_VDD_SupplyVoltage());
+
+    frame = Msc.Frame_Cnt;
+    rd_total = Msc_Rd_Total;
+    wr_total = Msc_Wr_Total;
+    while(1)
+    {
+        MSC_Process( );
+
+        if( Msc.Frame_Cnt - frame >= 1000 )
+        {
+            frame = Msc.Frame_Cnt;
+            if( ( Msc_Rd_Total != rd_total ) || ( Msc_Wr_Total != wr_total ) )
+            {
+                printf( "Rd:%d KB/s Wr:%d KB/s Hit:%d Load:%d Ahead:%d Erase:%d Flush:%d\r\n",
+                        (int)( ( Msc_Rd_Total - rd_total ) >> 10 ), (int)( ( Msc_Wr_Total - wr_total ) >> 10 ),
+                        (int)Cache_Stat.Hit, (int)Cache_Stat.Load, (int)Cache_Stat.Ahead, (int)Cache_Stat.Erase, (int)Cache_Stat.Flush );
+                rd_total = Msc_Rd_Total;
+                wr_total = Msc_Wr_Total;
+            }
+        }
+    }
+}
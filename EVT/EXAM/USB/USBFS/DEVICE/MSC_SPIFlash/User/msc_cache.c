@@ -0,0 +1,271 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : msc_cache.c
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: Write-back 4K block cache of the SPI flash disk. Runs in the
+ *              main loop only; the usb interrupt just drops Ref.
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "msc_cache.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+CACHE_BLK  Cache_Blk[ DEF_CACHE_NUM ];
+__attribute__ ((aligned(4))) uint8_t Cache_Buf[ DEF_CACHE_NUM ][ DEF_CACHE_BLK_SIZE ];
+CACHE_STAT Cache_Stat;
+uint32_t   Cache_Sec_Num;
+static uint32_t Cache_Use_Stamp;
+
+/*********************************************************************
+ * @fn      Cache_Init
+ *
+ * @brief   Initialize the flash and empty the cache.
+ *
+ * @return  flash ID
+ */
+uint16_t Cache_Init( void )
+{
+    uint16_t id;
+
+    SPI_Flash_Init( );
+    id = SPI_Flash_ReadID( );
+    Cache_Sec_Num = SPI_Flash_Capacity( id ) / DEF_CACHE_SEC_SIZE;
+
+    memset( Cache_Blk, 0, sizeof( Cache_Blk ) );
+    memset( &Cache_Stat, 0, sizeof( Cache_Stat ) );
+    Cache_Use_Stamp = 0;
+
+    return id;
+}
+
+/*********************************************************************
+ * @fn      Cache_Find
+ *
+ * @brief   Buffer holding one block.
+ *
+ * @return  buffer index, DEF_CACHE_NONE - not cached
+ */
+static uint8_t Cache_Find( uint32_t blk )
+{
+    uint8_t i;
+
+    for( i = 0; i < DEF_CACHE_NUM; i++ )
+    {
+        if( Cache_Blk[ i ].Valid && ( Cache_Blk[ i ].Blk == blk ) )
+        {
+            return i;
+        }
+    }
+    return DEF_CACHE_NONE;
+}
+
+/*********************************************************************
+ * @fn      Cache_Victim
+ *
+ * @brief   Buffer to reuse, an empty one or else the least recently
+ *          used one no usb transfer refers to.
+ *
+ * @param   clean - skip dirty buffers
+ *
+ * @return  buffer index, DEF_CACHE_NONE - every buffer in use
+ */
+static uint8_t Cache_Victim( uint8_t clean )
+{
+    uint8_t i;
+    uint8_t idx = DEF_CACHE_NONE;
+
+    for( i = 0; i < DEF_CACHE_NUM; i++ )
+    {
+        if( Cache_Blk[ i ].Ref || ( clean && Cache_Blk[ i ].Dirty ) )
+        {
+            continue;
+        }
+        if( !Cache_Blk[ i ].Valid )
+        {
+            return i;
+        }
+        if( ( idx == DEF_CACHE_NONE ) || ( (int32_t)( Cache_Blk[ i ].Use - Cache_Blk[ idx ].Use ) < 0 ) )
+        {
+            idx = i;
+        }
+    }
+    return idx;
+}
+
+/*********************************************************************
+ * @fn      Cache_WriteBack
+ *
+ * @brief   Write one dirty buffer to the flash, erasing the block first
+ *          unless it was blank when loaded.
+ *
+ * @return  none
+ */
+static void Cache_WriteBack( uint8_t idx )
+{
+    CACHE_BLK *p = &Cache_Blk[ idx ];
+
+    if( !p->Valid || !p->Dirty )
+    {
+        return;
+    }
+    if( !p->Blank )
+    {
+        SPI_Flash_Erase_Sector( p->Blk );
+        Cache_Stat.Erase++;
+    }
+    SPI_Flash_Write_NoCheck( Cache_Buf[ idx ], p->Blk * DEF_CACHE_BLK_SIZE, DEF_CACHE_BLK_SIZE );
+    Cache_Stat.Flush++;
+    p->Dirty = 0;
+    p->Blank = 0;
+}
+
+/*********************************************************************
+ * @fn      Cache_Load
+ *
+ * @brief   Make one buffer hold another block, writing its old content
+ *          back first.
+ *
+ * @param   load - DEF_CACHE_LOAD, DEF_CACHE_NO_LOAD
+ *
+ * @return  none
+ */
+static void Cache_Load( uint8_t idx, uint32_t blk, uint8_t load )
+{
+    CACHE_BLK *p = &Cache_Blk[ idx ];
+    uint32_t  *pw;
+    uint16_t  i;
+
+    Cache_WriteBack( idx );
+
+    p->Valid = 0;
+    p->Blank = 0;
+    if( load )
+    {
+        SPI_Flash_Read( Cache_Buf[ idx ], blk * DEF_CACHE_BLK_SIZE, DEF_CACHE_BLK_SIZE );
+        Cache_Stat.Load++;
+
+        /* An erased block can be programmed without erasing it again */
+        pw = (uint32_t *)Cache_Buf[ idx ];
+        for( i = 0; i < DEF_CACHE_BLK_SIZE / 4; i++ )
+        {
+            if( pw[ i ] != 0xFFFFFFFF )
+            {
+                break;
+            }
+        }
+        p->Blank = ( i == DEF_CACHE_BLK_SIZE / 4 );
+    }
+    p->Blk = blk;
+    p->Valid = 1;
+    p->Use = ++Cache_Use_Stamp;
+}
+
+/*********************************************************************
+ * @fn      Cache_Get
+ *
+ * @brief   Buffer holding one block, loaded from the flash on a miss.
+ *
+ * @param   load - DEF_CACHE_NO_LOAD if the caller overwrites the whole
+ *          block, so a miss skips the flash read.
+ *
+ * @return  buffer index, DEF_CACHE_NONE - every buffer in use
+ */
+uint8_t Cache_Get( uint32_t blk, uint8_t load )
+{
+    uint8_t idx;
+
+    idx = Cache_Find( blk );
+    if( idx != DEF_CACHE_NONE )
+    {
+        Cache_Stat.Hit++;
+        Cache_Blk[ idx ].Use = ++Cache_Use_Stamp;
+        return idx;
+    }
+
+    idx = Cache_Victim( 0 );
+    if( idx != DEF_CACHE_NONE )
+    {
+        Cache_Load( idx, blk, load );
+    }
+    return idx;
+}
+
+/*********************************************************************
+ * @fn      Cache_ReadAhead
+ *
+ * @brief   Load one block the host is expected to read next into a
+ *          free clean buffer. Never writes back, so it costs one flash
+ *          read at most.
+ *
+ * @return  buffer index, DEF_CACHE_NONE - out of range or no buffer
+ */
+uint8_t Cache_ReadAhead( uint32_t blk )
+{
+    uint8_t idx;
+
+    if( blk >= Cache_Sec_Num / DEF_CACHE_SEC_PER_BLK )
+    {
+        return DEF_CACHE_NONE;
+    }
+    idx = Cache_Find( blk );
+    if( idx != DEF_CACHE_NONE )
+    {
+        return idx;
+    }
+
+    idx = Cache_Victim( 1 );
+    if( ( idx != DEF_CACHE_NONE ) && ( Cache_Blk[ idx ].Use == Cache_Use_Stamp ) && Cache_Blk[ idx ].Valid )
+    {
+        /* Keep the block used last */
+        return DEF_CACHE_NONE;
+    }
+    if( idx != DEF_CACHE_NONE )
+    {
+        Cache_Load( idx, blk, DEF_CACHE_LOAD );
+        Cache_Stat.Ahead++;
+    }
+    return idx;
+}
+
+/*********************************************************************
+ * @fn      Cache_Flush
+ *
+ * @brief   Write every dirty buffer back to the flash.
+ *
+ * @return  none
+ */
+void Cache_Flush( void )
+{
+    uint8_t i;
+
+    for( i = 0; i < DEF_CACHE_NUM; i++ )
+    {
+        Cache_WriteBack( i );
+    }
+}
+
+/*********************************************************************
+ * @fn      Cache_Dirty
+ *
+ * @brief   Whether any buffer is newer than the flash.
+ *
+ * @return  1 - dirty, 0 - clean
+ */
+uint8_t Cache_Dirty( void )
+{
+    uint8_t i;
+
+    for( i = 0; i < DEF_CACHE_NUM; i++ )
+    {
+        if( Cache_Blk[ i ].Valid && Cache_Blk[ i ].Dirty )
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : msc_cache.h
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: header file of msc_cache.c
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef USER_MSC_CACHE_H_
+#define USER_MSC_CACHE_H_
+
+#include "string.h"
+#include "SPI_FLASH.h"
+
+/******************************************************************************/
+/* The disk is made of 512-byte sectors, the flash is erased in 4K blocks.
+ * Whole blocks are held in RAM buffers and written back (one erase plus the
+ * programming of the pages) only when the buffer is needed for another block
+ * or on Cache_Flush, so the eight 512-byte writes of one block cost a single
+ * erase. Data written but not yet flushed is lost on power failure. */
+#define DEF_CACHE_SEC_SIZE         512
+#define DEF_CACHE_BLK_SIZE         DEF_FLASH_SECTOR_SIZE
+#define DEF_CACHE_SEC_PER_BLK      ( DEF_CACHE_BLK_SIZE / DEF_CACHE_SEC_SIZE )
+#define DEF_CACHE_NUM              2                                            /* Block buffers, one sent while the other is loaded */
+#define DEF_CACHE_NONE             0xFF
+
+/* Cache_Get load argument */
+#define DEF_CACHE_NO_LOAD          0x00                                         /* The whole block is about to be overwritten */
+#define DEF_CACHE_LOAD             0x01
+
+/* One block buffer */
+typedef struct _CACHE_BLK
+{
+    uint32_t Blk;                                                               /* Flash block held, valid if Valid */
+    uint8_t  Valid;
+    uint8_t  Dirty;                                                             /* Newer than the flash */
+    uint8_t  Blank;                                                             /* Block in flash is erased, no erase needed on write-back */
+    volatile uint8_t Ref;                                                       /* Usb transfers still using the buffer, not evicted while non-zero */
+    uint32_t Use;                                                               /* Last use stamp, the least recently used buffer is evicted */
+} CACHE_BLK;
+
+/* Counters */
+typedef struct _CACHE_STAT
+{
+    uint32_t Hit;                                                               /* Lookups found in RAM */
+    uint32_t Load;                                                              /* Blocks read from flash */
+    uint32_t Erase;                                                             /* Blocks erased */
+    uint32_t Flush;                                                             /* Blocks written back */
+    uint32_t Ahead;                                                             /* Blocks read ahead */
+} CACHE_STAT;
+
+/******************************************************************************/
+/* external variables */
+extern CACHE_BLK  Cache_Blk[ DEF_CACHE_NUM ];
+extern __attribute__ ((aligned(4))) uint8_t Cache_Buf[ DEF_CACHE_NUM ][ DEF_CACHE_BLK_SIZE ];
+extern CACHE_STAT Cache_Stat;
+extern uint32_t   Cache_Sec_Num;                                                /* Disk size in sectors, 0 - no flash found */
+
+/* external functions */
+extern uint16_t Cache_Init( void );
+extern uint8_t  Cache_Get( uint32_t blk, uint8_t load );
+extern uint8_t  Cache_ReadAhead( uint32_t blk );
+extern void     Cache_Flush( void );
+extern uint8_t  Cache_Dirty( void );
+
+#endif /* USER_MSC_CACHE_H_ */
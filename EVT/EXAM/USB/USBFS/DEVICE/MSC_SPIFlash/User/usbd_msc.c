@@ -0,0 +1,735 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : usbd_msc.c
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: Mass storage Bulk-Only Transport class driver on the shared
+ *              USBFS device core, SCSI transparent command set over the
+ *              SPI flash block cache.
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "usbd_msc.h"
+
+/*******************************************************************************/
+/* Big-endian fields of the command blocks and responses */
+#define MSC_GET_BE16( p )             ( ( (uint16_t)( p )[ 0 ] << 8 ) | ( p )[ 1 ] )
+#define MSC_GET_BE32( p )             ( ( (uint32_t)( p )[ 0 ] << 24 ) | ( (uint32_t)( p )[ 1 ] << 16 ) | ( (uint32_t)( p )[ 2 ] << 8 ) | ( p )[ 3 ] )
+#define MSC_PUT_BE32( p, v )          do{ ( p )[ 0 ] = (uint8_t)( ( v ) >> 24 ); ( p )[ 1 ] = (uint8_t)( ( v ) >> 16 ); \
+                                          ( p )[ 2 ] = (uint8_t)( ( v ) >> 8 ); ( p )[ 3 ] = (uint8_t)( v ); }while( 0 )
+
+/*******************************************************************************/
+/* Variable Definition */
+MSC_CTL Msc;
+volatile uint32_t Msc_Rd_Total;
+volatile uint32_t Msc_Wr_Total;
+
+/* Bulk OUT lands here while no WRITE(10) is running */
+static __attribute__ ((aligned(4))) uint8_t MSC_Cbw_Buf[ DEF_USBD_FS_PACK_SIZE ];
+static MSC_CBW Msc_Cbw;
+static MSC_CSW Msc_Csw;
+static __attribute__ ((aligned(4))) uint8_t MSC_Resp_Buf[ 36 ];
+static const uint8_t MSC_Max_Lun = 0;
+
+/* Standard INQUIRY data */
+static const uint8_t MSC_Inquiry_Data[ 36 ] =
+{
+    0x00,                                                                       /* Direct access block device */
+    0x80,                                                                       /* Removable medium */
+    0x02,                                                                       /* SPC-2 */
+    0x02,                                                                       /* Response data format */
+    0x1F,                                                                       /* Additional length */
+    0x00, 0x00, 0x00,
+    'W', 'C', 'H', ' ', ' ', ' ', ' ', ' ',                                     /* Vendor */
+    'S', 'P', 'I', ' ', 'F', 'l', 'a', 's', 'h', ' ', 'D', 'i', 's', 'k', ' ', ' ', /* Product */
+    '1', '.', '0', '0'                                                          /* Revision */
+};
+
+/*********************************************************************
+ * @fn      MSC_Endp_Reset
+ *
+ * @brief   (Re)open the bulk endpoints, dropping queued transfers, and
+ *          wait for a CBW. Called on bus reset and Bulk-Only Mass
+ *          Storage Reset.
+ *
+ * @return  none
+ */
+static void MSC_Endp_Reset( void )
+{
+    uint8_t i;
+
+    USBFS_Endp_Open( DEF_MSC_IN_EP, USBFSD_UEP_TX_EN, DEF_USBD_ENDP1_SIZE );
+    USBFS_Endp_Open( DEF_MSC_OUT_EP, USBFSD_UEP_RX_EN, DEF_USBD_ENDP2_SIZE );
+    USBFS_Endp_RxBuf_Set( DEF_MSC_OUT_EP, MSC_Cbw_Buf );
+
+    for( i = 0; i < DEF_CACHE_NUM; i++ )
+    {
+        Cache_Blk[ i ].Ref = 0;
+    }
+    Msc.Tx_Head = 0;
+    Msc.Tx_Cnt = 0;
+    Msc.Wr_Done = 0;
+    Msc.Sta = DEF_MSC_STA_CBW;
+}
+
+/*********************************************************************
+ * @fn      MSC_Init
+ *
+ * @brief   Open the mass storage endpoints, called on device init and
+ *          bus reset.
+ *
+ * @return  none
+ */
+static void MSC_Init( void )
+{
+    MSC_Endp_Reset( );
+    Msc.Sense_Key = SCSI_SENSE_NONE;
+    Msc.Sense_ASC = 0;
+    Msc.Ahead_Flag = 0;
+    Msc.Idle_Ms = 0;
+}
+
+/*********************************************************************
+ * @fn      MSC_Setup
+ *
+ * @brief   Bulk-Only class requests.
+ *
+ * @return  DEF_USBD_REQ_OK or DEF_USBD_REQ_ERR
+ */
+static uint8_t MSC_Setup( const uint8_t **ppbuf, uint16_t *plen )
+{
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) != USB_REQ_TYP_CLASS )
+    {
+        return DEF_USBD_REQ_ERR;
+    }
+
+    switch( USBFS_SetupReqCode )
+    {
+        case DEF_MSC_REQ_GET_MAX_LUN:
+            *ppbuf = &MSC_Max_Lun;
+            *plen = 1;
+            break;
+
+        case DEF_MSC_REQ_RESET:
+            MSC_Endp_Reset( );
+            break;
+
+        default:
+            return DEF_USBD_REQ_ERR;
+    }
+    return DEF_USBD_REQ_OK;
+}
+
+/*********************************************************************
+ * @fn      MSC_CSW_Send
+ *
+ * @brief   Queue the status of the current command.
+ *
+ * @return  none
+ */
+static void MSC_CSW_Send( uint8_t status )
+{
+    Msc_Csw.dSignature = DEF_MSC_CSW_SIG;
+    Msc_Csw.dTag = Msc_Cbw.dTag;
+    Msc_Csw.dDataResidue = Msc.Residue;
+    Msc_Csw.bStatus = status;
+    Msc.Sta = DEF_MSC_STA_CSW;
+    USBFS_Endp_Transmit( DEF_MSC_IN_EP, (const uint8_t *)&Msc_Csw, DEF_MSC_CSW_LEN, 0 );
+}
+
+/*********************************************************************
+ * @fn      MSC_Out
+ *
+ * @brief   Bulk OUT packet: a CBW, WRITE(10) data or data to discard.
+ *
+ * @return  none
+ */
+static void MSC_Out( uint8_t endp, uint8_t *pbuf, uint16_t len )
+{
+    switch( Msc.Sta )
+    {
+        case DEF_MSC_STA_CBW:
+            if( ( len == DEF_MSC_CBW_LEN ) && ( ( (MSC_CBW *)pbuf )->dSignature == DEF_MSC_CBW_SIG ) )
+            {
+                /* Held (NAK) until the command is done */
+                memcpy( &Msc_Cbw, pbuf, DEF_MSC_CBW_LEN );
+                Msc.Sta = DEF_MSC_STA_CMD;
+            }
+            else
+            {
+                Msc.Sta = DEF_MSC_STA_ERROR;
+                USBFS_Endp_Halt( DEF_UEP_IN | DEF_MSC_IN_EP, 1 );
+                USBFS_Endp_Halt( DEF_UEP_OUT | DEF_MSC_OUT_EP, 1 );
+            }
+            break;
+
+        case DEF_MSC_STA_WRITE:
+            if( len > Msc.Wr_Len )
+            {
+                len = Msc.Wr_Len;
+            }
+            Msc.Wr_Len -= len;
+            Msc.Wr_Ptr += len;
+            Msc.Residue -= len;
+            if( Msc.Wr_Len && ( len == DEF_USBD_FS_PACK_SIZE ) )
+            {
+                /* Next packet straight into the cache buffer */
+                USBFS_Endp_RxBuf_Set( DEF_MSC_OUT_EP, Msc.Wr_Ptr );
+                USBFS_Endp_RxDone( DEF_MSC_OUT_EP );
+            }
+            else
+            {
+                Msc.Wr_Done = 1;
+            }
+            break;
+
+        case DEF_MSC_STA_SINK:
+            Msc.Residue -= ( len < Msc.Residue ) ? len : Msc.Residue;
+            if( Msc.Residue && ( len == DEF_USBD_FS_PACK_SIZE ) )
+            {
+                USBFS_Endp_RxDone( DEF_MSC_OUT_EP );
+            }
+            else
+            {
+                MSC_CSW_Send( Msc_Csw.bStatus );
+            }
+            break;
+
+        default:
+            USBFS_Endp_RxDone( endp );
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      MSC_In
+ *
+ * @brief   Bulk IN transfer done.
+ *
+ * @return  none
+ */
+static void MSC_In( uint8_t endp )
+{
+    switch( Msc.Sta )
+    {
+        case DEF_MSC_STA_DATA_IN:
+            MSC_CSW_Send( Msc_Csw.bStatus );
+            break;
+
+        case DEF_MSC_STA_READ:
+            Cache_Blk[ Msc.Tx_Cache[ Msc.Tx_Head ] ].Ref--;
+            Msc.Tx_Head = ( Msc.Tx_Head + 1 ) % DEF_USBD_TXQ_DEPTH;
+            Msc.Tx_Cnt--;
+            break;
+
+        case DEF_MSC_STA_CSW:
+            /* Release the held packet and wait for the next CBW */
+            Msc.Sta = DEF_MSC_STA_CBW;
+            USBFS_Endp_RxBuf_Set( DEF_MSC_OUT_EP, MSC_Cbw_Buf );
+            USBFS_Endp_RxDone( DEF_MSC_OUT_EP );
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      MSC_SOF
+ *
+ * @brief   Start of frame, counts the idle time for the write-back
+ *          and the frames for the statistics.
+ *
+ * @return  none
+ */
+static void MSC_SOF( void )
+{
+    Msc.Frame_Cnt++;
+    if( Msc.Idle_Ms < 0xFFFF )
+    {
+        Msc.Idle_Ms++;
+    }
+}
+
+/*********************************************************************
+ * @fn      MSC_Data_In
+ *
+ * @brief   Send a command's response and then its status. The host may
+ *          ask for more, the transfer then ends with a short packet.
+ *
+ * @return  none
+ */
+static void MSC_Data_In( const uint8_t *pbuf, uint16_t len, uint8_t status )
+{
+    if( !( Msc_Cbw.bmFlags & DEF_MSC_CBW_DIR_IN ) || ( Msc.Residue == 0 ) )
+    {
+        MSC_CSW_Send( DEF_MSC_CSW_PHASE_ERR );
+        return;
+    }
+    if( len > Msc.Residue )
+    {
+        len = Msc.Residue;
+    }
+    Msc.Residue -= len;
+    Msc_Csw.bStatus = status;
+    Msc.Sta = DEF_MSC_STA_DATA_IN;
+    USBFS_Endp_Transmit( DEF_MSC_IN_EP, pbuf, len, Msc.Residue ? DEF_UEP_TX_ZLP : 0 );
+}
+
+/*********************************************************************
+ * @fn      MSC_Cmd_End
+ *
+ * @brief   End a command that moves no data. Data the host still
+ *          expects is an empty IN transfer or OUT packets discarded.
+ *
+ * @return  none
+ */
+static void MSC_Cmd_End( uint8_t status )
+{
+    if( Msc.Residue == 0 )
+    {
+        MSC_CSW_Send( status );
+    }
+    else if( Msc_Cbw.bmFlags & DEF_MSC_CBW_DIR_IN )
+    {
+        MSC_Data_In( MSC_Resp_Buf, 0, status );
+    }
+    else
+    {
+        Msc_Csw.bStatus = status;
+        Msc.Sta = DEF_MSC_STA_SINK;
+        USBFS_Endp_RxBuf_Set( DEF_MSC_OUT_EP, MSC_Cbw_Buf );
+        USBFS_Endp_RxDone( DEF_MSC_OUT_EP );
+    }
+}
+
+/*********************************************************************
+ * @fn      MSC_Cmd_Fail
+ *
+ * @brief   Fail the command, the host reads the reason by REQUEST SENSE.
+ *
+ * @return  none
+ */
+static void MSC_Cmd_Fail( uint8_t key, uint8_t asc )
+{
+    Msc.Sense_Key = key;
+    Msc.Sense_ASC = asc;
+    MSC_Cmd_End( DEF_MSC_CSW_FAIL );
+}
+
+/*********************************************************************
+ * @fn      MSC_Ready
+ *
+ * @brief   Whether the medium can be accessed.
+ *
+ * @return  1 - ready
+ */
+static uint8_t MSC_Ready( void )
+{
+    return ( Cache_Sec_Num != 0 ) && !Msc.Eject;
+}
+
+/*********************************************************************
+ * @fn      MSC_Read_Deal
+ *
+ * @brief   READ(10): queue the requested sectors block by block, each
+ *          sent straight from its cache buffer. With two buffers the
+ *          next block is read from the flash while one is on the bus.
+ *
+ * @return  none
+ */
+static void MSC_Read_Deal( void )
+{
+    uint32_t len;
+    uint16_t off;
+    uint16_t n;
+    uint8_t  idx;
+
+    while( Msc.Sec_Cnt && USBFS_Endp_TxFree( DEF_MSC_IN_EP ) )
+    {
+        idx = Cache_Get( Msc.Lba / DEF_CACHE_SEC_PER_BLK, DEF_CACHE_LOAD );
+        if( idx == DEF_CACHE_NONE )
+        {
+            break;
+        }
+        off = Msc.Lba % DEF_CACHE_SEC_PER_BLK;
+        n = DEF_CACHE_SEC_PER_BLK - off;
+        if( n > Msc.Sec_Cnt )
+        {
+            n = Msc.Sec_Cnt;
+        }
+        len = (uint32_t)n * DEF_CACHE_SEC_SIZE;
+
+        NVIC_DisableIRQ( USBFS_IRQn );
+        if( Msc.Sta != DEF_MSC_STA_READ )
+        {
+            /* Reset while the block was loaded */
+            NVIC_EnableIRQ( USBFS_IRQn );
+            return;
+        }
+        Msc.Lba += n;
+        Msc.Sec_Cnt -= n;
+        Msc.Residue -= len;
+        Cache_Blk[ idx ].Ref++;
+        Msc.Tx_Cache[ ( Msc.Tx_Head + Msc.Tx_Cnt ) % DEF_USBD_TXQ_DEPTH ] = idx;
+        Msc.Tx_Cnt++;
+        USBFS_Endp_Transmit( DEF_MSC_IN_EP, &Cache_Buf[ idx ][ off * DEF_CACHE_SEC_SIZE ], len,
+                             DEF_UEP_TX_DMA | ( ( ( Msc.Sec_Cnt == 0 ) && Msc.Residue ) ? DEF_UEP_TX_ZLP : 0 ) );
+        NVIC_EnableIRQ( USBFS_IRQn );
+        Msc_Rd_Total += len;
+
+        if( Msc.Sec_Cnt == 0 )
+        {
+            /* Hosts read files sequentially, fetch the block after this command */
+            Msc.Ahead_Blk = ( Msc.Lba + DEF_CACHE_SEC_PER_BLK - 1 ) / DEF_CACHE_SEC_PER_BLK;
+            Msc.Ahead_Flag = 1;
+        }
+    }
+
+    if( Msc.Sec_Cnt == 0 )
+    {
+        /* Still sending the last block. Tried again on each pass until the
+           buffer before it has been sent and can take the next block */
+        if( Msc.Ahead_Flag && ( Cache_ReadAhead( Msc.Ahead_Blk ) != DEF_CACHE_NONE ) )
+        {
+            Msc.Ahead_Flag = 0;
+        }
+        NVIC_DisableIRQ( USBFS_IRQn );
+        if( ( Msc.Sta == DEF_MSC_STA_READ ) && ( Msc.Tx_Cnt == 0 ) )
+        {
+            MSC_CSW_Send( DEF_MSC_CSW_PASS );
+        }
+        NVIC_EnableIRQ( USBFS_IRQn );
+    }
+}
+
+/*********************************************************************
+ * @fn      MSC_Write_Next
+ *
+ * @brief   WRITE(10): point the OUT endpoint at the cache buffer of the
+ *          next block and let the host send. A block written whole is
+ *          not read from the flash first.
+ *
+ * @return  none
+ */
+static void MSC_Write_Next( void )
+{
+    uint16_t off;
+    uint16_t n;
+    uint8_t  idx;
+
+    off = Msc.Lba % DEF_CACHE_SEC_PER_BLK;
+    n = DEF_CACHE_SEC_PER_BLK - off;
+    if( n > Msc.Sec_Cnt )
+    {
+        n = Msc.Sec_Cnt;
+    }
+    idx = Cache_Get( Msc.Lba / DEF_CACHE_SEC_PER_BLK, ( n == DEF_CACHE_SEC_PER_BLK ) ? DEF_CACHE_NO_LOAD : DEF_CACHE_LOAD );
+
+    /* Dirty from the first byte on, a reset half way leaves the buffer newer than the flash */
+    Cache_Blk[ idx ].Dirty = 1;
+    Msc.Wr_Cache = idx;
+    Msc.Wr_Ptr = &Cache_Buf[ idx ][ off * DEF_CACHE_SEC_SIZE ];
+    Msc.Wr_Len = n * DEF_CACHE_SEC_SIZE;
+    Msc.Wr_Sec = n;
+    Msc.Wr_Done = 0;
+
+    NVIC_DisableIRQ( USBFS_IRQn );
+    if( Msc.Sta == DEF_MSC_STA_WRITE )
+    {
+        USBFS_Endp_RxBuf_Set( DEF_MSC_OUT_EP, Msc.Wr_Ptr );
+        USBFS_Endp_RxDone( DEF_MSC_OUT_EP );
+    }
+    NVIC_EnableIRQ( USBFS_IRQn );
+}
+
+/*********************************************************************
+ * @fn      MSC_Write_Deal
+ *
+ * @brief   WRITE(10): one block part received into the cache.
+ *
+ * @return  none
+ */
+static void MSC_Write_Deal( void )
+{
+    Msc.Wr_Done = 0;
+    Msc_Wr_Total += (uint32_t)Msc.Wr_Sec * DEF_CACHE_SEC_SIZE - Msc.Wr_Len;
+    if( Msc.Wr_Len )
+    {
+        /* Short packet, the host sent less than it announced */
+        MSC_CSW_Send( DEF_MSC_CSW_PHASE_ERR );
+        return;
+    }
+
+    Msc.Lba += Msc.Wr_Sec;
+    Msc.Sec_Cnt -= Msc.Wr_Sec;
+    if( Msc.Sec_Cnt )
+    {
+        MSC_Write_Next( );
+    }
+    else
+    {
+        MSC_Cmd_End( DEF_MSC_CSW_PASS );
+    }
+}
+
+/*********************************************************************
+ * @fn      MSC_RW_Start
+ *
+ * @brief   Check and start READ(10) or WRITE(10).
+ *
+ * @return  none
+ */
+static void MSC_RW_Start( uint8_t write )
+{
+    uint32_t lba;
+    uint32_t cnt;
+
+    lba = MSC_GET_BE32( &Msc_Cbw.CB[ 2 ] );
+    cnt = MSC_GET_BE16( &Msc_Cbw.CB[ 7 ] );
+
+    if( !MSC_Ready( ) )
+    {
+        MSC_Cmd_Fail( SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT );
+        return;
+    }
+    if( ( lba >= Cache_Sec_Num ) || ( cnt > Cache_Sec_Num - lba ) )
+    {
+        MSC_Cmd_Fail( SCSI_SENSE_ILLEGAL_REQ, SCSI_ASC_LBA_OUT_OF_RANGE );
+        return;
+    }
+    if( ( cnt * DEF_CACHE_SEC_SIZE > Msc.Residue ) ||
+        ( cnt && ( ( ( Msc_Cbw.bmFlags & DEF_MSC_CBW_DIR_IN ) == 0 ) != write ) ) )
+    {
+        /* Host expects less data or the other direction */
+        MSC_CSW_Send( DEF_MSC_CSW_PHASE_ERR );
+        return;
+    }
+    if( cnt == 0 )
+    {
+        MSC_Cmd_End( DEF_MSC_CSW_PASS );
+        return;
+    }
+
+    Msc.Lba = lba;
+    Msc.Sec_Cnt = cnt;
+    if( write )
+    {
+        Msc.Sta = DEF_MSC_STA_WRITE;
+        MSC_Write_Next( );
+    }
+    else
+    {
+        Msc.Sta = DEF_MSC_STA_READ;
+        MSC_Read_Deal( );
+    }
+}
+
+/*********************************************************************
+ * @fn      MSC_SCSI_Cmd
+ *
+ * @brief   Execute the SCSI command of the received CBW.
+ *
+ * @return  none
+ */
+static void MSC_SCSI_Cmd( void )
+{
+    uint8_t  *cb = Msc_Cbw.CB;
+    uint32_t last;
+
+    Msc.Residue = Msc_Cbw.dDataLength;
+    if( ( Msc_Cbw.bLUN != 0 ) || ( Msc_Cbw.bCBLength == 0 ) || ( Msc_Cbw.bCBLength > 16 ) )
+    {
+        MSC_Cmd_Fail( SCSI_SENSE_ILLEGAL_REQ, SCSI_ASC_INVALID_FIELD );
+        return;
+    }
+
+    switch( cb[ 0 ] )
+    {
+        case SCSI_TEST_UNIT_READY:
+            if( !MSC_Ready( ) )
+            {
+                MSC_Cmd_Fail( SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT );
+                return;
+            }
+            MSC_Cmd_End( DEF_MSC_CSW_PASS );
+            break;
+
+        case SCSI_REQUEST_SENSE:
+            memset( MSC_Resp_Buf, 0, 18 );
+            MSC_Resp_Buf[ 0 ] = 0x70;                                           /* Current error, fixed format */
+            MSC_Resp_Buf[ 2 ] = Msc.Sense_Key;
+            MSC_Resp_Buf[ 7 ] = 0x0A;                                           /* Additional sense length */
+            MSC_Resp_Buf[ 12 ] = Msc.Sense_ASC;
+            Msc.Sense_Key = SCSI_SENSE_NONE;
+            Msc.Sense_ASC = 0;
+            MSC_Data_In( MSC_Resp_Buf, 18, DEF_MSC_CSW_PASS );
+            break;
+
+        case SCSI_INQUIRY:
+            if( cb[ 1 ] & 0x01 )
+            {
+                /* No vital product data pages */
+                MSC_Cmd_Fail( SCSI_SENSE_ILLEGAL_REQ, SCSI_ASC_INVALID_FIELD );
+                return;
+            }
+            MSC_Data_In( MSC_Inquiry_Data, sizeof( MSC_Inquiry_Data ), DEF_MSC_CSW_PASS );
+            break;
+
+        case SCSI_READ_FMT_CAPACITY:
+            if( !MSC_Ready( ) )
+            {
+                MSC_Cmd_Fail( SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT );
+                return;
+            }
+            memset( MSC_Resp_Buf, 0, 12 );
+            MSC_Resp_Buf[ 3 ] = 0x08;                                           /* Capacity list length */
+            MSC_PUT_BE32( &MSC_Resp_Buf[ 4 ], Cache_Sec_Num );
+            MSC_PUT_BE32( &MSC_Resp_Buf[ 8 ], DEF_CACHE_SEC_SIZE );
+            MSC_Resp_Buf[ 8 ] = 0x02;                                           /* Formatted media */
+            MSC_Data_In( MSC_Resp_Buf, 12, DEF_MSC_CSW_PASS );
+            break;
+
+        case SCSI_READ_CAPACITY10:
+            if( !MSC_Ready( ) )
+            {
+                MSC_Cmd_Fail( SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT );
+                return;
+            }
+            last = Cache_Sec_Num - 1;
+            MSC_PUT_BE32( &MSC_Resp_Buf[ 0 ], last );
+            MSC_PUT_BE32( &MSC_Resp_Buf[ 4 ], DEF_CACHE_SEC_SIZE );
+            MSC_Data_In( MSC_Resp_Buf, 8, DEF_MSC_CSW_PASS );
+            break;
+
+        case SCSI_MODE_SENSE6:
+            memset( MSC_Resp_Buf, 0, 4 );
+            MSC_Resp_Buf[ 0 ] = 0x03;                                           /* Mode data length, not write protected */
+            MSC_Data_In( MSC_Resp_Buf, 4, DEF_MSC_CSW_PASS );
+            break;
+
+        case SCSI_MODE_SENSE10:
+            memset( MSC_Resp_Buf, 0, 8 );
+            MSC_Resp_Buf[ 1 ] = 0x06;                                           /* Mode data length, not write protected */
+            MSC_Data_In( MSC_Resp_Buf, 8, DEF_MSC_CSW_PASS );
+            break;
+
+        case SCSI_START_STOP_UNIT:
+            Cache_Flush( );
+            if( cb[ 4 ] & 0x02 )
+            {
+                /* LoEj: eject on stop, load on start */
+                Msc.Eject = !( cb[ 4 ] & 0x01 );
+            }
+            MSC_Cmd_End( DEF_MSC_CSW_PASS );
+            break;
+
+        case SCSI_PREVENT_ALLOW:
+            if( !( cb[ 4 ] & 0x01 ) )
+            {
+                /* Removal allowed, the host may pull the plug next */
+                Cache_Flush( );
+            }
+            MSC_Cmd_End( DEF_MSC_CSW_PASS );
+            break;
+
+        case SCSI_SYNC_CACHE10:
+            Cache_Flush( );
+            MSC_Cmd_End( DEF_MSC_CSW_PASS );
+            break;
+
+        case SCSI_VERIFY10:
+            if( !MSC_Ready( ) )
+            {
+                MSC_Cmd_Fail( SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT );
+                return;
+            }
+            MSC_Cmd_End( DEF_MSC_CSW_PASS );
+            break;
+
+        case SCSI_READ10:
+            MSC_RW_Start( 0 );
+            break;
+
+        case SCSI_WRITE10:
+            MSC_RW_Start( 1 );
+            break;
+
+        default:
+            MSC_Cmd_Fail( SCSI_SENSE_ILLEGAL_REQ, SCSI_ASC_INVALID_CMD );
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      MSC_Process
+ *
+ * @brief   Mass storage work of the main loop: execute commands, move
+ *          READ/WRITE data between the flash and the cache, read ahead
+ *          and write dirty blocks back once the host goes idle.
+ *
+ * @return  none
+ */
+void MSC_Process( void )
+{
+    if( !USBFS_DevEnumStatus || ( USBFS_DevSleepStatus & 0x02 ) )
+    {
+        /* Detached or suspended, no SOF to time the write-back */
+        if( Cache_Dirty( ) )
+        {
+            Cache_Flush( );
+        }
+        return;
+    }
+
+    switch( Msc.Sta )
+    {
+        case DEF_MSC_STA_CMD:
+            Msc.Idle_Ms = 0;
+            MSC_SCSI_Cmd( );
+            break;
+
+        case DEF_MSC_STA_READ:
+            MSC_Read_Deal( );
+            break;
+
+        case DEF_MSC_STA_WRITE:
+            if( Msc.Wr_Done )
+            {
+                MSC_Write_Deal( );
+            }
+            break;
+
+        case DEF_MSC_STA_CBW:
+            if( Msc.Ahead_Flag )
+            {
+                Msc.Ahead_Flag = 0;
+                Cache_ReadAhead( Msc.Ahead_Blk );
+            }
+            else if( ( Msc.Idle_Ms >= DEF_MSC_FLUSH_IDLE_MS ) && Cache_Dirty( ) )
+            {
+                Cache_Flush( );
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Class driver */
+const USBFS_CLASS_DRV MSC_Class_Drv =
+{
+    0, 1,
+    ( 1 << DEF_MSC_IN_EP ) | ( 1 << DEF_MSC_OUT_EP ),
+    MSC_Init,
+    MSC_Setup,
+    NULL,
+    MSC_Out,
+    MSC_In,
+    MSC_SOF,
+    NULL,
+};
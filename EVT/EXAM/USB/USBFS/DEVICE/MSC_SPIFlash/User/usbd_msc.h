@@ -0,0 +1,140 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : usbd_msc.h
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: header file of usbd_msc.c
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef USER_USBD_MSC_H_
+#define USER_USBD_MSC_H_
+
+#include <ch643_usbfs_device.h>
+#include "msc_cache.h"
+
+/******************************************************************************/
+/* Endpoints: bulk IN 1 (single buffer, sent straight from the cache) and bulk
+ * OUT 2 (received straight into the cache) */
+#define DEF_MSC_IN_EP                 DEF_UEP1
+#define DEF_MSC_OUT_EP                DEF_UEP2
+
+/* Class requests */
+#define DEF_MSC_REQ_RESET             0xFF                                      /* Bulk-Only Mass Storage Reset */
+#define DEF_MSC_REQ_GET_MAX_LUN       0xFE
+
+/* Bulk-Only Transport wrappers */
+#define DEF_MSC_CBW_SIG               0x43425355                                /* "USBC" */
+#define DEF_MSC_CSW_SIG               0x53425355                                /* "USBS" */
+#define DEF_MSC_CBW_LEN               31
+#define DEF_MSC_CSW_LEN               13
+#define DEF_MSC_CBW_DIR_IN            0x80
+
+#define DEF_MSC_CSW_PASS              0x00
+#define DEF_MSC_CSW_FAIL              0x01
+#define DEF_MSC_CSW_PHASE_ERR         0x02
+
+/* SCSI operation codes */
+#define SCSI_TEST_UNIT_READY          0x00
+#define SCSI_REQUEST_SENSE            0x03
+#define SCSI_INQUIRY                  0x12
+#define SCSI_MODE_SENSE6              0x1A
+#define SCSI_START_STOP_UNIT          0x1B
+#define SCSI_PREVENT_ALLOW            0x1E
+#define SCSI_READ_FMT_CAPACITY        0x23
+#define SCSI_READ_CAPACITY10          0x25
+#define SCSI_READ10                   0x28
+#define SCSI_WRITE10                  0x2A
+#define SCSI_VERIFY10                 0x2F
+#define SCSI_SYNC_CACHE10             0x35
+#define SCSI_MODE_SENSE10             0x5A
+
+/* Sense key, additional sense code */
+#define SCSI_SENSE_NONE               0x00
+#define SCSI_SENSE_NOT_READY          0x02
+#define SCSI_SENSE_ILLEGAL_REQ        0x05
+#define SCSI_ASC_INVALID_CMD          0x20
+#define SCSI_ASC_LBA_OUT_OF_RANGE     0x21
+#define SCSI_ASC_INVALID_FIELD        0x24
+#define SCSI_ASC_MEDIUM_NOT_PRESENT   0x3A
+
+/* Transport state */
+#define DEF_MSC_STA_CBW               0x00                                      /* Waiting for a CBW */
+#define DEF_MSC_STA_CMD               0x01                                      /* CBW received, main loop to execute it */
+#define DEF_MSC_STA_DATA_IN           0x02                                      /* Response being sent */
+#define DEF_MSC_STA_READ              0x03                                      /* READ(10) data being sent */
+#define DEF_MSC_STA_WRITE             0x04                                      /* WRITE(10) data being received */
+#define DEF_MSC_STA_SINK              0x05                                      /* Discarding OUT data the command does not use */
+#define DEF_MSC_STA_CSW               0x06                                      /* CSW being sent */
+#define DEF_MSC_STA_ERROR             0x07                                      /* Invalid CBW, stalled until reset recovery */
+
+/* Dirty blocks are written back after the bus has been idle this long */
+#define DEF_MSC_FLUSH_IDLE_MS         200
+
+/******************************************************************************/
+/* Command block wrapper */
+typedef struct __attribute__((packed)) _MSC_CBW
+{
+    uint32_t dSignature;
+    uint32_t dTag;
+    uint32_t dDataLength;
+    uint8_t  bmFlags;
+    uint8_t  bLUN;
+    uint8_t  bCBLength;
+    uint8_t  CB[ 16 ];
+} MSC_CBW;
+
+/* Command status wrapper */
+typedef struct __attribute__((packed)) _MSC_CSW
+{
+    uint32_t dSignature;
+    uint32_t dTag;
+    uint32_t dDataResidue;
+    uint8_t  bStatus;
+} MSC_CSW;
+
+/* Transport control. The USBFS interrupt only moves packets and
+ * advances Sta, the SCSI commands and all flash work run in
+ * MSC_Process from the main loop. */
+typedef struct _MSC_CTL
+{
+    volatile uint8_t Sta;                                                       /* DEF_MSC_STA_xx */
+    uint8_t  Sense_Key;
+    uint8_t  Sense_ASC;
+    uint8_t  Eject;                                                             /* Medium ejected by START STOP UNIT */
+    uint32_t Residue;                                                           /* Bytes of dDataLength not transferred */
+    uint32_t Lba;                                                               /* READ/WRITE: next sector */
+    uint32_t Sec_Cnt;                                                           /* READ: sectors not queued, WRITE: sectors not received */
+
+    /* READ: cache buffer of each queued IN transfer, oldest first */
+    uint8_t  Tx_Cache[ DEF_USBD_TXQ_DEPTH ];
+    uint8_t  Tx_Head;
+    volatile uint8_t Tx_Cnt;
+    uint32_t Ahead_Blk;                                                         /* Block to read ahead while idle */
+    uint8_t  Ahead_Flag;
+
+    /* WRITE: part of one block being received */
+    uint8_t  Wr_Cache;
+    uint8_t  *Wr_Ptr;
+    volatile uint16_t Wr_Len;                                                   /* Bytes still expected for this part */
+    uint16_t Wr_Sec;                                                            /* Sectors in this part */
+    volatile uint8_t Wr_Done;                                                   /* Part received, main loop to commit */
+
+    volatile uint16_t Idle_Ms;                                                  /* Ms since the last command, counted on SOF */
+    volatile uint32_t Frame_Cnt;                                                /* Free running SOF count */
+} MSC_CTL;
+
+/******************************************************************************/
+/* external variables */
+extern const USBFS_CLASS_DRV MSC_Class_Drv;
+extern MSC_CTL Msc;
+extern volatile uint32_t Msc_Rd_Total;                                          /* Bytes read by the host */
+extern volatile uint32_t Msc_Wr_Total;                                          /* Bytes written by the host */
+
+/* external functions */
+extern void MSC_Process( void );
+
+#endif /* USER_USBD_MSC_H_ */
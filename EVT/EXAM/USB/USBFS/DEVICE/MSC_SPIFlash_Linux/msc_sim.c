@@ -0,0 +1,1284 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : msc_sim.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : MSC_SPIFlash built for the PC against a RAM model of
+ *                      the W25Q64 and a simulated USBFS device controller,
+ *                      with a simulated Bulk-Only host. Self-tests and a
+ *                      throughput benchmark of the SCSI and cache layers.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * usbd_msc.c, msc_cache.c and usb_desc.c of MSC_SPIFlash and the device
+ * core of USBD_Lib are compiled in as they are; SPI_FLASH.c is replaced by
+ * a RAM model of the flash:
+ *   - programming only clears bits, programming a 0 back to 1 without an
+ *     erase is an error; erasing sets a 4K sector to 0xFF.
+ *   - reads take ( 4 + n ) bytes at the SPI clock (HCLK / 4, 12 MHz),
+ *     page programs and sector erases take the W25Q64JV typical times,
+ *     -p and -e change them.
+ * The main loop of main.c (MSC_Process) runs as the only thread: time
+ * passes while it waits for the flash, one pass takes SIM_LOOP_NS. The
+ * USBFS SIE and the host run meanwhile in simulated time, as in
+ * SimulateCDC_Linux: USB transactions take their full-speed bus time, the
+ * SIE NAKs while a transfer interrupt is pending, the interrupt runs at the
+ * end of each acknowledged transaction unless the main loop has it masked.
+ * SOF comes every 1 ms. The host issues one command at a time, the next CBW
+ * straight after each CSW, and keeps a copy of the disk to check every
+ * sector read.
+ *
+ * Build:
+ *   gcc -O2 -Wall -I../MSC_SPIFlash/User -I../USBD_Lib -I../../../../SRC/Core
+ *       -I../../../../SRC/Debug -I../../../../SRC/Peripheral/inc
+ *       -o msc_sim msc_sim.c
+ *
+ * Usage:
+ *   msc_sim [-n KB] [-x sectors] [-p us] [-e ms]
+ *   -n  bytes written and read back by the benchmark, 1024 KB by default
+ *   -x  sectors per READ(10)/WRITE(10), 128 (64 KB) by default
+ *   -p  page program time, 700 us by default
+ *   -e  sector erase time, 45 ms by default
+ *   msc_sim -t runs the self-tests.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* The example and the peripheral headers as they are, minus the RISC-V bits */
+#define interrupt( x )      unused
+#include "debug.h"
+
+static USBFSD_TypeDef      Sim_Usbfsd;
+static GPIO_TypeDef        Sim_Gpioc;
+static AFIO_TypeDef        Sim_Afio;
+
+#undef USBFSD
+#define USBFSD              ( &Sim_Usbfsd )
+#undef GPIOC
+#define GPIOC               ( &Sim_Gpioc )
+#undef AFIO
+#define AFIO                ( &Sim_Afio )
+
+static void Sim_Nvic_Cmd( int irq, int en );
+#define NVIC_EnableIRQ( n ) Sim_Nvic_Cmd( ( n ), 1 )
+#define NVIC_DisableIRQ( n ) Sim_Nvic_Cmd( ( n ), 0 )
+
+/* The host never suspends the bus, USBFS_Device_Sleep has nothing to mask */
+#define __disable_irq( )    ( (void)0 )
+#define __enable_irq( )     ( (void)0 )
+
+/* The endpoint registers keep 32-bit addresses of buffers, Sim_Ptr finds
+ * the buffer behind one */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpointer-to-int-cast"
+#include "usb_desc.c"
+#include "ch643_usbfs_device.c"
+#include "msc_cache.c"
+#include "usbd_msc.c"
+#pragma GCC diagnostic pop
+
+#define SIM_FLASH_ID        W25Q64
+#define SIM_FLASH_SIZE      ( 8 * 1024 * 1024 )
+#define SIM_SPI_HZ          12000000                                            /* HCLK 48 MHz / SPI_BaudRatePrescaler_4 */
+#define SIM_LOOP_NS         2000                                                /* One pass of the main loop */
+#define SIM_USB_IRQ_NS      3000                                                /* SIE busy per USBFS interrupt */
+#define SIM_SOF_NS          1000000
+#define SIM_HOST_ADDR       5
+#define SIM_JITTER_NS       5000                                                /* Host delay before each transaction */
+#define SIM_CMD_NS          10000000000ull                                      /* A command not done by then fails */
+
+/* Host transaction results */
+#define SIM_ACK             0
+#define SIM_NAK             1
+#define SIM_STALL           2
+#define SIM_TIMEOUT         3
+
+/* Host Bulk-Only phases */
+#define SIM_PH_IDLE         0
+#define SIM_PH_CBW          1
+#define SIM_PH_DOUT         2
+#define SIM_PH_DIN          3
+#define SIM_PH_CSW          4
+
+typedef struct _SIM_OPT
+{
+    uint32_t Kb;
+    uint32_t Xfer;                                                              /* Sectors per command */
+    uint32_t Prog_Ns;
+    uint32_t Erase_Ns;
+} SIM_OPT;
+
+typedef struct _SIM_CTX
+{
+    uint64_t Now;                                                               /* ns */
+    uint8_t  Nvic[ 64 ];
+    uint8_t  In_Irq;
+    uint32_t Seed;
+
+    /* Flash model */
+    uint8_t  *pFlash;
+    uint32_t Prog_Ns, Erase_Ns;
+    uint32_t Flash_Rd, Flash_Prog, Flash_Erase;                                 /* Bytes read, pages programmed, sectors erased */
+
+    /* USBFS */
+    uint8_t  Usb_Flags;                                                         /* INT_FG as the hardware has it */
+    uint64_t Usb_Busy_Until;
+    uint64_t Sof_At;
+    uint8_t  Host_Addr;
+    uint8_t  Out_Tog[ 8 ], In_Tog[ 8 ];                                         /* Host side data toggles */
+    uint32_t Naks;
+
+    /* Host, the command running */
+    uint8_t  Ph;
+    uint64_t Host_At;                                                           /* Next transaction, or end of this one */
+    uint8_t  Tok_Pend;                                                          /* Transaction on the bus, interrupt at Host_At */
+    uint8_t  Tok_St;
+    uint16_t Tok_Len;
+    uint8_t  Cbw[ DEF_MSC_CBW_LEN ];
+    uint8_t  *pData;
+    uint32_t Len, Off;
+    uint8_t  Dir_In;
+    uint32_t Tag;
+    uint8_t  Csw_Status;
+    uint32_t Csw_Residue;
+    uint8_t  In_Buf[ DEF_USBFS_UEP_BUF_LEN ];
+
+    /* What the host wrote, sector by sector */
+    uint8_t  *pDisk;
+    uint32_t Errors;
+} SIM_CTX;
+
+static SIM_CTX Sim;
+
+/*********************************************************************
+ * @fn      Sim_Fail
+ *
+ * @brief   Count one error, and print the first few.
+ *
+ * @return  none
+ */
+static void Sim_Fail( const char *pmsg, uint32_t a, uint32_t b )
+{
+    if( Sim.Errors++ < 8 )
+    {
+        printf( "%10.3f ms  %s (%u, %u)\n", Sim.Now / 1e6, pmsg, a, b );
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Rand
+ *
+ * @brief   Pseudo-random number, the same every run.
+ *
+ * @return  0 - 0x7FFF
+ */
+static uint32_t Sim_Rand( void )
+{
+    Sim.Seed = Sim.Seed * 1103515245 + 12345;
+    return ( Sim.Seed >> 16 ) & 0x7FFF;
+}
+
+/*********************************************************************
+ * @fn      Sim_Ptr
+ *
+ * @brief   Buffer behind a 32-bit endpoint address written by the
+ *          example.
+ *
+ * @param   len - bytes that must lie inside the buffer
+ *
+ * @return  pointer, exits if the address is in no buffer
+ */
+static uint8_t *Sim_Ptr( uint32_t adr, uint32_t len )
+{
+    static uint8_t * const pbuf[ ] =
+    {
+        &Cache_Buf[ 0 ][ 0 ], MSC_Cbw_Buf, USBFS_EP0_4Buf, USBFS_EP1_Buf, USBFS_EP2_Buf, USBFS_EP3_Buf,
+    };
+    static const uint32_t size[ ] =
+    {
+        sizeof( Cache_Buf ), sizeof( MSC_Cbw_Buf ), sizeof( USBFS_EP0_4Buf ), sizeof( USBFS_EP1_Buf ),
+        sizeof( USBFS_EP2_Buf ), sizeof( USBFS_EP3_Buf ),
+    };
+    uint32_t i, off;
+
+    for( i = 0; i < sizeof( size ) / sizeof( size[ 0 ] ); i++ )
+    {
+        off = adr - (uint32_t)(uintptr_t)pbuf[ i ];
+        if( ( off < size[ i ] ) && ( len <= size[ i ] - off ) )
+        {
+            return pbuf[ i ] + off;
+        }
+    }
+    fprintf( stderr, "sim: endpoint address %08x+%u is in no buffer\n", adr, len );
+    exit( 2 );
+}
+
+static void Sim_Irq( void );
+
+/*********************************************************************
+ * @fn      Sim_Nvic_Cmd
+ *
+ * @brief   NVIC_EnableIRQ/NVIC_DisableIRQ, a pending interrupt runs as
+ *          soon as it is enabled.
+ *
+ * @return  none
+ */
+static void Sim_Nvic_Cmd( int irq, int en )
+{
+    Sim.Nvic[ irq & 63 ] = en;
+    if( en )
+    {
+        Sim_Irq( );
+    }
+}
+
+/* Peripheral library, the calls the example makes */
+void Delay_Us( uint32_t n ) { }
+void Delay_Ms( uint32_t n ) { }
+void RCC_APB2PeriphClockCmd( uint32_t RCC_APB2Periph, FunctionalState NewState ) { }
+void RCC_AHBPeriphClockCmd( uint32_t RCC_AHBPeriph, FunctionalState NewState ) { }
+void GPIO_Init( GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct ) { }
+void EXTI_Init( EXTI_InitTypeDef *EXTI_InitStruct ) { }
+void EXTI_ClearFlag( uint32_t EXTI_Line ) { }
+void PWR_EnterSTOPMode( uint8_t PWR_STOPEntry ) { }
+PWR_VDD PWR_VDD_SupplyVoltage( void ) { return PWR_VDD_5V; }
+void SystemInit( void ) { }
+void SystemCoreClockUpdate( void ) { }
+
+/*********************************************************************
+ * @fn      Sim_Irq
+ *
+ * @brief   Run the USBFS interrupt while it is pending and enabled. A
+ *          flag is cleared by writing it to INT_FG: the read-only
+ *          USBFS_U_SIE_FREE bit is set before the handler runs, so a
+ *          write shows as that bit gone.
+ *
+ * @return  none
+ */
+static void Sim_Irq( void )
+{
+    uint8_t v;
+
+    if( Sim.In_Irq )
+    {
+        return;
+    }
+    Sim.In_Irq = 1;
+    while( Sim.Nvic[ USBFS_IRQn ] && ( Sim.Usb_Flags & Sim_Usbfsd.INT_EN ) )
+    {
+        Sim_Usbfsd.INT_FG = Sim.Usb_Flags | USBFS_U_SIE_FREE;
+        USBFS_IRQHandler( );
+        v = Sim_Usbfsd.INT_FG;
+        if( v & USBFS_U_SIE_FREE )
+        {
+            fprintf( stderr, "sim: USBFS interrupt flag not cleared\n" );
+            exit( 2 );
+        }
+        Sim.Usb_Flags &= ~v;
+        Sim.Usb_Busy_Until = Sim.Now + SIM_USB_IRQ_NS;
+    }
+    Sim.In_Irq = 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Busy
+ *
+ * @brief   The SIE NAKs while a transfer interrupt is pending or being
+ *          handled (USBFS_UC_INT_BUSY).
+ *
+ * @return  1 - busy
+ */
+static int Sim_Busy( void )
+{
+    return ( Sim.Usb_Flags & USBFS_UIF_TRANSFER ) || ( Sim.Now < Sim.Usb_Busy_Until );
+}
+
+/*********************************************************************
+ * @fn      Sim_Done
+ *
+ * @brief   Transaction finished: set USBFS_UIF_TRANSFER and the status.
+ *
+ * @return  none
+ */
+static void Sim_Done( uint8_t st, uint16_t len )
+{
+    Sim_Usbfsd.INT_ST = st;
+    Sim_Usbfsd.RX_LEN = len;
+    Sim.Usb_Flags |= USBFS_UIF_TRANSFER;
+    Sim_Irq( );
+}
+
+/*********************************************************************
+ * @fn      Sim_Bus_Ns
+ *
+ * @brief   Full-speed bus time of a transaction with len data bytes,
+ *          -1 for a token and handshake only.
+ *
+ * @return  ns
+ */
+static uint64_t Sim_Bus_Ns( int len )
+{
+    return ( len < 0 ) ? 9000 : (uint64_t)( len + 18 ) * 8 * 1000 / 12 + 2000;
+}
+
+/*********************************************************************
+ * @fn      Sim_Sie
+ *
+ * @brief   What the SIE knows of one endpoint: its response byte and
+ *          the 32-bit address of its buffer.
+ *
+ * @param   in - 1 - IN token, 0 - OUT or SETUP
+ *
+ * @return  UEPn_CTRL_H, NULL if the endpoint does not answer
+ */
+static volatile uint16_t *Sim_Sie( uint8_t endp, int in, uint32_t *padr, volatile uint16_t **ptxlen )
+{
+    uint8_t mod;
+
+    if( ( Sim_Usbfsd.DEV_ADDR & 0x7F ) != Sim.Host_Addr )
+    {
+        return NULL;
+    }
+    if( endp == DEF_UEP0 )
+    {
+        *padr = Sim_Usbfsd.UEP0_DMA;
+        *ptxlen = &Sim_Usbfsd.UEP0_TX_LEN;
+        return &Sim_Usbfsd.UEP0_CTRL_H;
+    }
+    if( endp == DEF_UEP1 )
+    {
+        mod = Sim_Usbfsd.UEP4_1_MOD >> 4;
+    }
+    else if( endp == DEF_UEP2 )
+    {
+        mod = Sim_Usbfsd.UEP2_3_MOD & 0x0F;
+    }
+    else
+    {
+        return NULL;
+    }
+    if( !( mod & ( in ? USBFSD_UEP_TX_EN : USBFSD_UEP_RX_EN ) ) )
+    {
+        return NULL;
+    }
+    if( mod & USBFSD_UEP_BUF_MOD )
+    {
+        fprintf( stderr, "sim: endpoint %d double-buffered, not simulated\n", endp );
+        exit( 2 );
+    }
+    *padr = ( endp == DEF_UEP1 ) ? Sim_Usbfsd.UEP1_DMA : Sim_Usbfsd.UEP2_DMA;
+    if( in && ( mod & USBFSD_UEP_RX_EN ) )
+    {
+        *padr += DEF_USBFS_UEP_BUF_LEN;
+    }
+    *ptxlen = ( endp == DEF_UEP1 ) ? &Sim_Usbfsd.UEP1_TX_LEN : &Sim_Usbfsd.UEP2_TX_LEN;
+    return ( endp == DEF_UEP1 ) ? &Sim_Usbfsd.UEP1_CTRL_H : &Sim_Usbfsd.UEP2_CTRL_H;
+}
+
+/*********************************************************************
+ * @fn      Sim_Tok_Out
+ *
+ * @brief   Start of an OUT or SETUP transaction: the handshake, and the
+ *          data into the endpoint buffer if acknowledged. The interrupt
+ *          follows at the end of the transaction (Sim.Tok_St/Tok_Len).
+ *
+ * @return  SIM_ACK, SIM_NAK, SIM_STALL or SIM_TIMEOUT
+ */
+static int Sim_Tok_Out( uint8_t endp, const uint8_t *pdat, int len, int setup )
+{
+    volatile uint16_t *ctrl, *txlen;
+    uint32_t adr;
+    uint8_t  tog_ok;
+
+    ctrl = Sim_Sie( endp, 0, &adr, &txlen );
+    if( ctrl == NULL )
+    {
+        return SIM_TIMEOUT;
+    }
+    if( setup )
+    {
+        /* Never NAKed, the host waits until the SIE is free */
+        memcpy( Sim_Ptr( adr, 8 ), pdat, 8 );
+        Sim.Out_Tog[ 0 ] = 1;
+        Sim.In_Tog[ 0 ] = 1;
+        Sim.Tok_St = USBFS_UIS_TOKEN_SETUP | DEF_UEP0;
+        Sim.Tok_Len = 8;
+        return SIM_ACK;
+    }
+    if( Sim_Busy( ) )
+    {
+        Sim.Naks++;
+        return SIM_NAK;
+    }
+    if( ( *ctrl & USBFS_UEP_R_RES_MASK ) == USBFS_UEP_R_RES_STALL )
+    {
+        return SIM_STALL;
+    }
+    if( ( *ctrl & USBFS_UEP_R_RES_MASK ) != USBFS_UEP_R_RES_ACK )
+    {
+        Sim.Naks++;
+        return SIM_NAK;
+    }
+
+    tog_ok = ( ( *ctrl & USBFS_UEP_R_TOG ) ? 1 : 0 ) == Sim.Out_Tog[ endp ];
+    if( tog_ok )
+    {
+        memcpy( Sim_Ptr( adr, len ), pdat, len );
+    }
+    else
+    {
+        Sim_Fail( "host: OUT data toggle not taken, endpoint", endp, Sim.Out_Tog[ endp ] );
+    }
+    Sim.Out_Tog[ endp ] ^= 1;
+    Sim.Tok_St = USBFS_UIS_TOKEN_OUT | endp | ( tog_ok ? USBFS_UIS_TOG_OK : 0 );
+    Sim.Tok_Len = len;
+    return SIM_ACK;
+}
+
+/*********************************************************************
+ * @fn      Sim_Tok_In
+ *
+ * @brief   Start of an IN transaction: the handshake, and the data from
+ *          the endpoint buffer if the endpoint answers with it.
+ *
+ * @return  SIM_ACK, SIM_NAK, SIM_STALL or SIM_TIMEOUT
+ */
+static int Sim_Tok_In( uint8_t endp, uint8_t *pdat, int *plen )
+{
+    volatile uint16_t *ctrl, *txlen;
+    uint32_t adr;
+    int len;
+
+    ctrl = Sim_Sie( endp, 1, &adr, &txlen );
+    if( ctrl == NULL )
+    {
+        return SIM_TIMEOUT;
+    }
+    if( Sim_Busy( ) )
+    {
+        Sim.Naks++;
+        return SIM_NAK;
+    }
+    if( ( *ctrl & USBFS_UEP_T_RES_MASK ) == USBFS_UEP_T_RES_STALL )
+    {
+        return SIM_STALL;
+    }
+    if( ( *ctrl & USBFS_UEP_T_RES_MASK ) != USBFS_UEP_T_RES_ACK )
+    {
+        Sim.Naks++;
+        return SIM_NAK;
+    }
+
+    len = *txlen;
+    if( len > DEF_USBFS_UEP_BUF_LEN )
+    {
+        Sim_Fail( "device: IN packet too long, endpoint", endp, len );
+        len = DEF_USBFS_UEP_BUF_LEN;
+    }
+    memcpy( pdat, Sim_Ptr( adr, len ), len );
+    *plen = len;
+    if( ( ( *ctrl & USBFS_UEP_T_TOG ) ? 1 : 0 ) != Sim.In_Tog[ endp ] )
+    {
+        Sim_Fail( "host: IN data toggle repeated, endpoint", endp, Sim.In_Tog[ endp ] );
+    }
+    Sim.In_Tog[ endp ] ^= 1;
+    Sim.Tok_St = USBFS_UIS_TOKEN_IN | endp;
+    Sim.Tok_Len = 0;
+    return SIM_ACK;
+}
+
+/*********************************************************************
+ * @fn      Sim_Host_Step
+ *
+ * @brief   One transaction of the running Bulk-Only command, started
+ *          at Sim.Host_At.
+ *
+ * @return  none
+ */
+static void Sim_Host_Step( void )
+{
+    int r, n, len = -1;
+
+    switch( Sim.Ph )
+    {
+        case SIM_PH_CBW:
+            len = DEF_MSC_CBW_LEN;
+            r = Sim_Tok_Out( DEF_MSC_OUT_EP, Sim.Cbw, len, 0 );
+            if( r == SIM_ACK )
+            {
+                Sim.Ph = ( Sim.Len == 0 ) ? SIM_PH_CSW : Sim.Dir_In ? SIM_PH_DIN : SIM_PH_DOUT;
+            }
+            break;
+
+        case SIM_PH_DOUT:
+            len = ( Sim.Len - Sim.Off < DEF_USBD_ENDP2_SIZE ) ? Sim.Len - Sim.Off : DEF_USBD_ENDP2_SIZE;
+            r = Sim_Tok_Out( DEF_MSC_OUT_EP, Sim.pData + Sim.Off, len, 0 );
+            if( r == SIM_ACK )
+            {
+                Sim.Off += len;
+                if( Sim.Off >= Sim.Len )
+                {
+                    Sim.Ph = SIM_PH_CSW;
+                }
+            }
+            break;
+
+        case SIM_PH_DIN:
+            r = Sim_Tok_In( DEF_MSC_IN_EP, Sim.In_Buf, &len );
+            if( r == SIM_ACK )
+            {
+                n = ( (uint32_t)len < Sim.Len - Sim.Off ) ? len : (int)( Sim.Len - Sim.Off );
+                memcpy( Sim.pData + Sim.Off, Sim.In_Buf, n );
+                Sim.Off += len;
+                if( ( len < DEF_USBD_ENDP1_SIZE ) || ( Sim.Off >= Sim.Len ) )
+                {
+                    Sim.Ph = SIM_PH_CSW;
+                }
+            }
+            break;
+
+        case SIM_PH_CSW:
+            r = Sim_Tok_In( DEF_MSC_IN_EP, Sim.In_Buf, &len );
+            if( r == SIM_ACK )
+            {
+                if( ( len != DEF_MSC_CSW_LEN ) || ( ( (MSC_CSW *)Sim.In_Buf )->dSignature != DEF_MSC_CSW_SIG ) ||
+                    ( ( (MSC_CSW *)Sim.In_Buf )->dTag != Sim.Tag ) )
+                {
+                    Sim_Fail( "host: bad CSW, length, tag", len, Sim.Tag );
+                }
+                Sim.Csw_Status = ( (MSC_CSW *)Sim.In_Buf )->bStatus;
+                Sim.Csw_Residue = ( (MSC_CSW *)Sim.In_Buf )->dDataResidue;
+                Sim.Ph = SIM_PH_IDLE;
+            }
+            break;
+
+        default:
+            return;
+    }
+
+    if( ( r == SIM_STALL ) || ( r == SIM_TIMEOUT ) )
+    {
+        Sim_Fail( "host: endpoint stalled or not answering, phase", Sim.Ph, r );
+        Sim.Csw_Status = 0xFF;
+        Sim.Ph = SIM_PH_IDLE;
+        return;
+    }
+    Sim.Tok_Pend = ( r == SIM_ACK );
+    Sim.Host_At = Sim.Now + Sim_Bus_Ns( ( r == SIM_ACK ) ? len : ( Sim.Ph == SIM_PH_DOUT ) ? len : -1 );
+}
+
+/*********************************************************************
+ * @fn      Sim_Wait
+ *
+ * @brief   Let the bus run until time t: the host's transactions, their
+ *          interrupts and SOF.
+ *
+ * @return  none
+ */
+static void Sim_Wait( uint64_t t )
+{
+    uint64_t next;
+
+    for( ; ; )
+    {
+        next = Sim.Sof_At;
+        if( ( Sim.Ph != SIM_PH_IDLE || Sim.Tok_Pend ) && ( Sim.Host_At < next ) )
+        {
+            next = Sim.Host_At;
+        }
+        if( next > t )
+        {
+            break;
+        }
+        Sim.Now = next;
+
+        if( ( Sim.Ph != SIM_PH_IDLE || Sim.Tok_Pend ) && ( Sim.Host_At == next ) )
+        {
+            if( Sim.Tok_Pend )
+            {
+                Sim.Tok_Pend = 0;
+                Sim_Done( Sim.Tok_St, Sim.Tok_Len );
+                Sim.Host_At = Sim.Now + 1000 + Sim_Rand( ) % SIM_JITTER_NS;
+            }
+            else
+            {
+                Sim_Host_Step( );
+            }
+        }
+        if( Sim.Sof_At == next )
+        {
+            if( Sim.Tok_Pend || Sim_Busy( ) )
+            {
+                /* Bus or interrupt busy, start of frame a little later */
+                Sim.Sof_At += 1000;
+            }
+            else
+            {
+                Sim.Sof_At += SIM_SOF_NS;
+                if( ( Sim_Usbfsd.INT_EN & USBFS_UIE_DEV_SOF ) && Sim.Host_Addr )
+                {
+                    Sim_Done( USBFS_UIS_TOKEN_SOF, 0 );
+                }
+            }
+        }
+    }
+    Sim.Now = t;
+}
+
+/*********************************************************************
+ * @fn      Sim_Xfer
+ *
+ * @brief   One blocking transaction, for enumeration: retried while
+ *          NAKed for up to 100 ms.
+ *
+ * @return  SIM_ACK, SIM_NAK, SIM_STALL or SIM_TIMEOUT
+ */
+static int Sim_Xfer( uint8_t endp, int in, const uint8_t *pout, uint8_t *pin, int *plen, int setup )
+{
+    uint64_t end = Sim.Now + 100000000;
+    int r, len = 0;
+
+    do
+    {
+        while( setup && Sim_Busy( ) )
+        {
+            Sim_Wait( Sim.Now + 1000 );
+        }
+        r = in ? Sim_Tok_In( endp, pin, &len ) : Sim_Tok_Out( endp, pout, *plen, setup );
+        Sim_Wait( Sim.Now + Sim_Bus_Ns( in ? ( ( r == SIM_ACK ) ? len : -1 ) : *plen ) );
+        if( r == SIM_ACK )
+        {
+            Sim_Done( Sim.Tok_St, Sim.Tok_Len );
+        }
+    } while( ( r == SIM_NAK ) && ( Sim.Now < end ) );
+    if( in )
+    {
+        *plen = len;
+    }
+    return r;
+}
+
+/*********************************************************************
+ * @fn      Sim_Control
+ *
+ * @brief   Control transfer on endpoint 0.
+ *
+ * @param   pdat - data stage, wLength of the request bytes
+ *
+ * @return  bytes of the data stage, -1 on error
+ */
+static int Sim_Control( uint8_t type, uint8_t req, uint16_t value, uint16_t index, uint8_t *pdat, uint16_t wlen )
+{
+    uint8_t setup[ 8 ], buf[ DEF_USBFS_UEP_BUF_LEN ];
+    int r, len, n = 0;
+
+    setup[ 0 ] = type;
+    setup[ 1 ] = req;
+    setup[ 2 ] = (uint8_t)value;
+    setup[ 3 ] = (uint8_t)( value >> 8 );
+    setup[ 4 ] = (uint8_t)index;
+    setup[ 5 ] = (uint8_t)( index >> 8 );
+    setup[ 6 ] = (uint8_t)wlen;
+    setup[ 7 ] = (uint8_t)( wlen >> 8 );
+    len = 8;
+    if( Sim_Xfer( DEF_UEP0, 0, setup, NULL, &len, 1 ) != SIM_ACK )
+    {
+        return -1;
+    }
+
+    if( type & DEF_UEP_IN )
+    {
+        while( n < wlen )
+        {
+            if( Sim_Xfer( DEF_UEP0, 1, NULL, buf, &len, 0 ) != SIM_ACK )
+            {
+                return -1;
+            }
+            memcpy( pdat + n, buf, ( len < wlen - n ) ? len : wlen - n );
+            n += len;
+            if( len < DEF_USBD_UEP0_SIZE )
+            {
+                break;
+            }
+        }
+        len = 0;
+        r = Sim_Xfer( DEF_UEP0, 0, NULL, NULL, &len, 0 );
+    }
+    else
+    {
+        r = Sim_Xfer( DEF_UEP0, 1, NULL, buf, &len, 0 );
+    }
+    return ( r == SIM_ACK ) ? n : -1;
+}
+
+/*********************************************************************
+ * @fn      Sim_Enum
+ *
+ * @brief   Bus reset and enumeration as a host does it.
+ *
+ * @return  0 - ok
+ */
+static int Sim_Enum( void )
+{
+    uint8_t buf[ 256 ];
+    int len;
+
+    /* 10 ms of SE0 */
+    Sim.Usb_Flags |= USBFS_UIF_BUS_RST;
+    Sim_Irq( );
+    Sim_Wait( Sim.Now + 10000000 );
+    Sim.Host_Addr = 0;
+    memset( Sim.Out_Tog, 0, sizeof( Sim.Out_Tog ) );
+    memset( Sim.In_Tog, 0, sizeof( Sim.In_Tog ) );
+
+    len = Sim_Control( 0x80, USB_GET_DESCRIPTOR, USB_DESCR_TYP_DEVICE << 8, 0, buf, 64 );
+    if( ( len != 18 ) || memcmp( buf, MyDevDescr, 18 ) )
+    {
+        printf( "enum: device descriptor, %d bytes\n", len );
+        return -1;
+    }
+    if( Sim_Control( 0x00, USB_SET_ADDRESS, SIM_HOST_ADDR, 0, NULL, 0 ) != 0 )
+    {
+        printf( "enum: set address\n" );
+        return -1;
+    }
+    Sim.Host_Addr = SIM_HOST_ADDR;
+    len = Sim_Control( 0x80, USB_GET_DESCRIPTOR, USB_DESCR_TYP_CONFIG << 8, 0, buf, 255 );
+    if( ( len != DEF_USBD_CONFIG_DESC_LEN ) || memcmp( buf, MyCfgDescr, len ) )
+    {
+        printf( "enum: configuration descriptor, %d bytes\n", len );
+        return -1;
+    }
+    if( ( Sim_Control( 0x00, USB_SET_CONFIGURATION, 1, 0, NULL, 0 ) != 0 ) ||
+        ( Sim_Control( 0xA1, DEF_MSC_REQ_GET_MAX_LUN, 0, 0, buf, 1 ) != 1 ) || ( buf[ 0 ] != 0 ) )
+    {
+        printf( "enum: configuration or max LUN\n" );
+        return -1;
+    }
+    return 0;
+}
+
+/* Flash model, in place of SPI_FLASH.c */
+void SPI_Flash_Init( void ) { }
+u8 SPI_Flash_ReadSR( void ) { return 0; }
+void SPI_Flash_Wait_Busy( void ) { }
+u16 SPI_Flash_ReadID( void ) { return SIM_FLASH_ID; }
+
+u32 SPI_Flash_Capacity( u16 id )
+{
+    return ( id == SIM_FLASH_ID ) ? SIM_FLASH_SIZE : 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Spi_Ns
+ *
+ * @brief   Time to shift n bytes on the SPI bus.
+ *
+ * @return  ns
+ */
+static uint64_t Sim_Spi_Ns( uint32_t n )
+{
+    return (uint64_t)n * 8 * 1000000000 / SIM_SPI_HZ;
+}
+
+void SPI_Flash_Erase_Sector( u32 Dst_Addr )
+{
+    if( Dst_Addr >= SIM_FLASH_SIZE / DEF_FLASH_SECTOR_SIZE )
+    {
+        Sim_Fail( "flash: erase past the end, sector", Dst_Addr, 0 );
+        return;
+    }
+    Sim_Wait( Sim.Now + Sim_Spi_Ns( 5 ) + Sim.Erase_Ns );
+    memset( Sim.pFlash + Dst_Addr * DEF_FLASH_SECTOR_SIZE, 0xFF, DEF_FLASH_SECTOR_SIZE );
+    Sim.Flash_Erase++;
+}
+
+void SPI_Flash_Read( u8 *pBuffer, u32 ReadAddr, u16 size )
+{
+    if( ( ReadAddr >= SIM_FLASH_SIZE ) || ( size > SIM_FLASH_SIZE - ReadAddr ) )
+    {
+        Sim_Fail( "flash: read past the end, address", ReadAddr, size );
+        return;
+    }
+    Sim_Wait( Sim.Now + Sim_Spi_Ns( 4 + size ) );
+    memcpy( pBuffer, Sim.pFlash + ReadAddr, size );
+    Sim.Flash_Rd += size;
+}
+
+void SPI_Flash_Write_Page( u8 *pBuffer, u32 WriteAddr, u16 size )
+{
+    uint8_t *p = Sim.pFlash + WriteAddr;
+    uint16_t i;
+
+    if( ( size == 0 ) || ( WriteAddr / DEF_FLASH_PAGE_SIZE != ( WriteAddr + size - 1 ) / DEF_FLASH_PAGE_SIZE ) ||
+        ( WriteAddr + size > SIM_FLASH_SIZE ) )
+    {
+        Sim_Fail( "flash: page program across a page, address", WriteAddr, size );
+        return;
+    }
+    /* SPI1_ReadWriteByte waits for each byte, about twice the shift time */
+    Sim_Wait( Sim.Now + 2 * Sim_Spi_Ns( 5 + size ) + Sim.Prog_Ns );
+    for( i = 0; i < size; i++ )
+    {
+        if( pBuffer[ i ] & ~p[ i ] )
+        {
+            Sim_Fail( "flash: programmed without erase, address", WriteAddr + i, pBuffer[ i ] );
+        }
+        p[ i ] &= pBuffer[ i ];
+    }
+    Sim.Flash_Prog++;
+}
+
+void SPI_Flash_Write_NoCheck( u8 *pBuffer, u32 WriteAddr, u16 size )
+{
+    u16 n;
+    u16 i;
+
+    while( size )
+    {
+        n = DEF_FLASH_PAGE_SIZE - WriteAddr % DEF_FLASH_PAGE_SIZE;
+        if( n > size )
+        {
+            n = size;
+        }
+        for( i = 0; ( i < n ) && ( pBuffer[ i ] == 0xFF ); i++ );
+        if( i < n )
+        {
+            SPI_Flash_Write_Page( pBuffer, WriteAddr, n );
+        }
+        pBuffer += n;
+        WriteAddr += n;
+        size -= n;
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Loop
+ *
+ * @brief   The main loop of main.c, until the host has finished its
+ *          command or time t.
+ *
+ * @return  none
+ */
+static void Sim_Loop( uint64_t t )
+{
+    while( ( Sim.Ph != SIM_PH_IDLE ) || ( Sim.Now < t ) )
+    {
+        if( ( Sim.Ph != SIM_PH_IDLE ) && ( Sim.Now > t + SIM_CMD_NS ) )
+        {
+            Sim_Fail( "host: command timed out, phase", Sim.Ph, Sim.Cbw[ 15 ] );
+            Sim.Ph = SIM_PH_IDLE;
+            Sim.Csw_Status = 0xFF;
+            break;
+        }
+        MSC_Process( );
+        Sim_Wait( Sim.Now + SIM_LOOP_NS );
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Scsi
+ *
+ * @brief   One Bulk-Only command: CBW, data, CSW, with the main loop
+ *          running meanwhile.
+ *
+ * @param   pcb - command block, cblen bytes
+ *          pdat, len - data stage, dir_in - device to host
+ *
+ * @return  CSW status, 0xFF - transport failed
+ */
+static uint8_t Sim_Scsi( const uint8_t *pcb, uint8_t cblen, uint8_t *pdat, uint32_t len, uint8_t dir_in )
+{
+    MSC_CBW *pcbw = (MSC_CBW *)Sim.Cbw;
+
+    memset( Sim.Cbw, 0, sizeof( Sim.Cbw ) );
+    pcbw->dSignature = DEF_MSC_CBW_SIG;
+    pcbw->dTag = ++Sim.Tag;
+    pcbw->dDataLength = len;
+    pcbw->bmFlags = dir_in ? DEF_MSC_CBW_DIR_IN : 0;
+    pcbw->bCBLength = cblen;
+    memcpy( pcbw->CB, pcb, cblen );
+    Sim.pData = pdat;
+    Sim.Len = len;
+    Sim.Off = 0;
+    Sim.Dir_In = dir_in;
+    Sim.Ph = SIM_PH_CBW;
+    Sim.Host_At = Sim.Now;
+
+    Sim_Loop( Sim.Now );
+    return Sim.Csw_Status;
+}
+
+/*********************************************************************
+ * @fn      Sim_RW
+ *
+ * @brief   READ(10) or WRITE(10) of cnt sectors from lba. Writes update
+ *          the host's copy of the disk, reads are checked against it.
+ *
+ * @return  CSW status
+ */
+static uint8_t Sim_RW( uint8_t write, uint32_t lba, uint16_t cnt )
+{
+    static uint8_t buf[ 65535 * DEF_CACHE_SEC_SIZE / 16 ];
+    uint8_t  cb[ 10 ] = { write ? SCSI_WRITE10 : SCSI_READ10, 0, (uint8_t)( lba >> 24 ), (uint8_t)( lba >> 16 ),
+                          (uint8_t)( lba >> 8 ), (uint8_t)lba, 0, (uint8_t)( cnt >> 8 ), (uint8_t)cnt, 0 };
+    uint32_t len = (uint32_t)cnt * DEF_CACHE_SEC_SIZE, i;
+    uint8_t  st;
+
+    if( len > sizeof( buf ) )
+    {
+        fprintf( stderr, "sim: transfer too long\n" );
+        exit( 2 );
+    }
+    if( write )
+    {
+        for( i = 0; i < len; i++ )
+        {
+            buf[ i ] = (uint8_t)Sim_Rand( );
+        }
+        memcpy( Sim.pDisk + (size_t)lba * DEF_CACHE_SEC_SIZE, buf, len );
+    }
+    st = Sim_Scsi( cb, 10, buf, len, !write );
+    if( st != DEF_MSC_CSW_PASS )
+    {
+        Sim_Fail( write ? "host: WRITE(10) failed, lba" : "host: READ(10) failed, lba", lba, st );
+    }
+    else if( !write && memcmp( buf, Sim.pDisk + (size_t)lba * DEF_CACHE_SEC_SIZE, len ) )
+    {
+        for( i = 0; buf[ i ] == Sim.pDisk[ (size_t)lba * DEF_CACHE_SEC_SIZE + i ]; i++ );
+        Sim_Fail( "host: READ(10) data differs, lba", lba + i / DEF_CACHE_SEC_SIZE, i % DEF_CACHE_SEC_SIZE );
+    }
+    return st;
+}
+
+/*********************************************************************
+ * @fn      Sim_Simple
+ *
+ * @brief   A command of the 6 or 10-byte kind with one parameter byte
+ *          at offset 4.
+ *
+ * @return  CSW status
+ */
+static uint8_t Sim_Simple( uint8_t op, uint8_t b4, uint8_t *pdat, uint32_t len )
+{
+    uint8_t cb[ 10 ] = { op, 0, 0, 0, b4, 0, 0, 0, 0, 0 };
+
+    return Sim_Scsi( cb, ( op >= 0x20 ) ? 10 : 6, pdat, len, len != 0 );
+}
+
+/*********************************************************************
+ * @fn      Sim_Flash_Check
+ *
+ * @brief   After a flush, the flash holds what the host wrote.
+ *
+ * @return  none
+ */
+static void Sim_Flash_Check( const char *pwhen )
+{
+    uint32_t i;
+
+    if( memcmp( Sim.pFlash, Sim.pDisk, SIM_FLASH_SIZE ) )
+    {
+        for( i = 0; Sim.pFlash[ i ] == Sim.pDisk[ i ]; i++ );
+        printf( "  %s:\n", pwhen );
+        Sim_Fail( "flash: differs from the disk, sector, byte", i / DEF_CACHE_SEC_SIZE, i % DEF_CACHE_SEC_SIZE );
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Start
+ *
+ * @brief   Power up the example as main.c does, and enumerate it. The
+ *          flash starts with random data, so writes need erases.
+ *
+ * @return  0 - ok
+ */
+static int Sim_Start( const SIM_OPT *popt )
+{
+    uint32_t i;
+
+    memset( &Sim, 0, sizeof( Sim ) );
+    Sim.Seed = 1;
+    Sim.Sof_At = SIM_SOF_NS;
+    Sim.Prog_Ns = popt->Prog_Ns;
+    Sim.Erase_Ns = popt->Erase_Ns;
+    Sim.pFlash = malloc( SIM_FLASH_SIZE );
+    Sim.pDisk = malloc( SIM_FLASH_SIZE );
+    if( ( Sim.pFlash == NULL ) || ( Sim.pDisk == NULL ) )
+    {
+        return -1;
+    }
+    for( i = 0; i < SIM_FLASH_SIZE; i++ )
+    {
+        Sim.pFlash[ i ] = (uint8_t)Sim_Rand( );
+    }
+    memcpy( Sim.pDisk, Sim.pFlash, SIM_FLASH_SIZE );
+
+    if( Cache_Init( ) != SIM_FLASH_ID )
+    {
+        return -1;
+    }
+    USBFS_Class_Register( &MSC_Class_Drv );
+    USBFS_RCC_Init( );
+    USBFS_Device_Init( ENABLE, PWR_VDD_5V );
+    Sim_Wait( Sim.Now + 2000000 );
+    return Sim_Enum( );
+}
+
+/*********************************************************************
+ * @fn      Sim_Bench
+ *
+ * @brief   Sequential write of popt->Kb, SYNCHRONIZE CACHE, and read
+ *          back, popt->Xfer sectors per command.
+ *
+ * @param   pwr, prd - bytes per second
+ *
+ * @return  none
+ */
+static void Sim_Bench( const SIM_OPT *popt, uint32_t lba0, uint32_t *pwr, uint32_t *prd )
+{
+    uint32_t sec = popt->Kb * 2, n, lba;
+    uint64_t t;
+
+    t = Sim.Now;
+    for( lba = 0; lba < sec; lba += n )
+    {
+        n = ( sec - lba < popt->Xfer ) ? sec - lba : popt->Xfer;
+        Sim_RW( 1, lba0 + lba, n );
+    }
+    Sim_Simple( SCSI_SYNC_CACHE10, 0, NULL, 0 );
+    *pwr = (uint32_t)( (uint64_t)sec * DEF_CACHE_SEC_SIZE * 1000000000 / ( Sim.Now - t ) );
+
+    t = Sim.Now;
+    for( lba = 0; lba < sec; lba += n )
+    {
+        n = ( sec - lba < popt->Xfer ) ? sec - lba : popt->Xfer;
+        Sim_RW( 0, lba0 + lba, n );
+    }
+    *prd = (uint32_t)( (uint64_t)sec * DEF_CACHE_SEC_SIZE * 1000000000 / ( Sim.Now - t ) );
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Run
+ *
+ * @brief   The self-test cases, run in a child process each so that the
+ *          example starts from its initial globals.
+ *
+ * @return  0 - passed
+ */
+static int Sim_Test_Run( int n )
+{
+    SIM_OPT  opt = { 256, 128, 700000, 45000000 };
+    uint8_t  buf[ 36 ];
+    uint32_t wr, rd, i, lba, erase;
+
+    if( Sim_Start( &opt ) )
+    {
+        return -1;
+    }
+    switch( n )
+    {
+        case 0:
+            /* The commands a host sends after enumeration */
+            if( ( Sim_Simple( SCSI_INQUIRY, 36, buf, 36 ) != DEF_MSC_CSW_PASS ) || memcmp( buf, MSC_Inquiry_Data, 36 ) )
+            {
+                Sim_Fail( "host: INQUIRY", buf[ 0 ], 0 );
+            }
+            if( Sim_Simple( SCSI_TEST_UNIT_READY, 0, NULL, 0 ) != DEF_MSC_CSW_PASS )
+            {
+                Sim_Fail( "host: TEST UNIT READY", 0, 0 );
+            }
+            if( ( Sim_Simple( SCSI_READ_CAPACITY10, 0, buf, 8 ) != DEF_MSC_CSW_PASS ) ||
+                ( MSC_GET_BE32( &buf[ 0 ] ) != SIM_FLASH_SIZE / DEF_CACHE_SEC_SIZE - 1 ) ||
+                ( MSC_GET_BE32( &buf[ 4 ] ) != DEF_CACHE_SEC_SIZE ) )
+            {
+                Sim_Fail( "host: READ CAPACITY, last lba", MSC_GET_BE32( &buf[ 0 ] ), MSC_GET_BE32( &buf[ 4 ] ) );
+            }
+            if( Sim_Simple( SCSI_MODE_SENSE6, 0x3F, buf, 192 ) != DEF_MSC_CSW_PASS ||
+                ( Sim.Csw_Residue != 192 - 4 ) )
+            {
+                Sim_Fail( "host: MODE SENSE(6) residue", Sim.Csw_Residue, 0 );
+            }
+            memcpy( buf, "\x28\x00\x00\x00\x3F\xFF\x00\x00\x02\x00", 10 );  /* READ(10) of the last sector and one more */
+            if( Sim_Scsi( buf, 10, Sim.pDisk, 1024, 1 ) != DEF_MSC_CSW_FAIL )
+            {
+                Sim_Fail( "host: READ(10) past the end passed", 0, 0 );
+            }
+            if( ( Sim_Simple( SCSI_REQUEST_SENSE, 18, buf, 18 ) != DEF_MSC_CSW_PASS ) ||
+                ( buf[ 2 ] != SCSI_SENSE_ILLEGAL_REQ ) || ( buf[ 12 ] != SCSI_ASC_LBA_OUT_OF_RANGE ) )
+            {
+                Sim_Fail( "host: REQUEST SENSE, key, asc", buf[ 2 ], buf[ 12 ] );
+            }
+            if( Sim_Simple( 0xFF, 0, NULL, 0 ) != DEF_MSC_CSW_FAIL )
+            {
+                Sim_Fail( "host: unknown command passed", 0, 0 );
+            }
+            break;
+
+        case 1:
+            /* Sequential 64K writes: one erase per 4K block, none read
+               first; each READ(10) after the first starts on the block
+               read ahead, one block past the end is read ahead too */
+            Sim_Bench( &opt, 2048, &wr, &rd );
+            if( Cache_Stat.Erase != opt.Kb / 4 )
+            {
+                Sim_Fail( "cache: erases for the blocks written", Cache_Stat.Erase, opt.Kb / 4 );
+            }
+            if( Cache_Stat.Load > opt.Kb / 4 + 1 )
+            {
+                Sim_Fail( "cache: loads, blocks read back", Cache_Stat.Load, opt.Kb / 4 );
+            }
+            if( Cache_Stat.Ahead < opt.Kb * 2 / opt.Xfer - 1 )
+            {
+                Sim_Fail( "cache: blocks read ahead, commands", Cache_Stat.Ahead, opt.Kb * 2 / opt.Xfer );
+            }
+            Sim_Flash_Check( "after SYNCHRONIZE CACHE" );
+            printf( "  write %u KB/s, read %u KB/s\n", wr >> 10, rd >> 10 );
+            break;
+
+        case 2:
+            /* Single sectors and runs across block boundaries, as a file
+               system updates its tables; each block is written back once
+               per eviction, never programmed over old data */
+            for( i = 0; i < 400; i++ )
+            {
+                lba = ( Sim_Rand( ) % 64 ) * DEF_CACHE_SEC_PER_BLK + Sim_Rand( ) % DEF_CACHE_SEC_PER_BLK;
+                Sim_RW( 1, lba, 1 + ( ( i % 5 ) ? 0 : Sim_Rand( ) % 20 ) );
+                if( ( i % 7 ) == 0 )
+                {
+                    Sim_RW( 0, ( Sim_Rand( ) % 64 ) * DEF_CACHE_SEC_PER_BLK, 1 + Sim_Rand( ) % 24 );
+                }
+            }
+            Sim_Simple( SCSI_SYNC_CACHE10, 0, NULL, 0 );
+            Sim_Flash_Check( "after SYNCHRONIZE CACHE" );
+            for( lba = 0; lba < 64 * DEF_CACHE_SEC_PER_BLK; lba += 128 )
+            {
+                Sim_RW( 0, lba, 128 );
+            }
+            if( Cache_Stat.Erase > Cache_Stat.Flush )
+            {
+                Sim_Fail( "cache: more erases than write-backs", Cache_Stat.Erase, Cache_Stat.Flush );
+            }
+            printf( "  %u write-backs, %u erases, %u hits\n", Cache_Stat.Flush, Cache_Stat.Erase, Cache_Stat.Hit );
+            break;
+
+        default:
+            /* Written blocks reach the flash after DEF_MSC_FLUSH_IDLE_MS
+               without commands, not before; eject flushes too */
+            Sim_RW( 1, 100, 3 );
+            erase = Sim.Flash_Erase;
+            Sim_Loop( Sim.Now + ( DEF_MSC_FLUSH_IDLE_MS - 20 ) * 1000000ull );
+            if( Sim.Flash_Erase != erase )
+            {
+                Sim_Fail( "cache: written back before the idle time", Sim.Flash_Erase, erase );
+            }
+            Sim_Loop( Sim.Now + 100000000 );
+            Sim_Flash_Check( "after the idle time" );
+            Sim_RW( 1, 5000, 9 );
+            Sim_Simple( SCSI_START_STOP_UNIT, 0x02, NULL, 0 );
+            Sim_Flash_Check( "after eject" );
+            if( Sim_Simple( SCSI_TEST_UNIT_READY, 0, NULL, 0 ) != DEF_MSC_CSW_FAIL )
+            {
+                Sim_Fail( "host: ready after eject", 0, 0 );
+            }
+            break;
+    }
+    return Sim.Errors ? -1 : 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Self_Test
+ *
+ * @brief   Run every self-test case.
+ *
+ * @return  number of failed cases
+ */
+static int Sim_Self_Test( void )
+{
+    static const char *pname[ ] =
+    {
+        "INQUIRY, READ CAPACITY, sense data",
+        "256 KB sequential write and read back",
+        "scattered sectors across blocks",
+        "write-back on idle and eject",
+    };
+    pid_t pid;
+    int i, st, fail = 0;
+
+    for( i = 0; i < 4; i++ )
+    {
+        printf( "%s\n", pname[ i ] );
+        fflush( stdout );
+        pid = fork( );
+        if( pid == 0 )
+        {
+            st = Sim_Test_Run( i );
+            fflush( stdout );
+            _exit( st ? 1 : 0 );
+        }
+        if( ( pid < 0 ) || ( waitpid( pid, &st, 0 ) != pid ) || !WIFEXITED( st ) || WEXITSTATUS( st ) )
+        {
+            printf( "  FAIL\n" );
+            fail++;
+        }
+        else
+        {
+            printf( "  ok\n" );
+        }
+    }
+    printf( "%s\n", fail ? "self-test FAILED" : "self-test passed" );
+    return fail;
+}
+
+int main( int argc, char **argv )
+{
+    SIM_OPT  opt = { 1024, 128, 700000, 45000000 };
+    uint32_t wr = 0, rd = 0;
+    int c;
+
+    while( ( c = getopt( argc, argv, "n:x:p:e:t" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 'n':
+                opt.Kb = strtoul( optarg, NULL, 0 );
+                break;
+            case 'x':
+                opt.Xfer = strtoul( optarg, NULL, 0 );
+                break;
+            case 'p':
+                opt.Prog_Ns = strtoul( optarg, NULL, 0 ) * 1000;
+                break;
+            case 'e':
+                opt.Erase_Ns = strtoul( optarg, NULL, 0 ) * 1000000;
+                break;
+            case 't':
+                return Sim_Self_Test( ) ? 1 : 0;
+            default:
+                fprintf( stderr, "usage: %s [-n KB] [-x sectors] [-p us] [-e ms] | -t\n", argv[ 0 ] );
+                return 1;
+        }
+    }
+    if( ( opt.Kb == 0 ) || ( opt.Kb > SIM_FLASH_SIZE / 2048 ) || ( opt.Xfer == 0 ) || ( opt.Xfer > 4095 ) ||
+        Sim_Start( &opt ) )
+    {
+        return 1;
+    }
+    Sim_Bench( &opt, 0, &wr, &rd );
+    Sim_Flash_Check( "after SYNCHRONIZE CACHE" );
+    printf( "write %.3f MB/s, read %.3f MB/s, %u KB in %u-sector commands\n",
+            wr / 1048576.0, rd / 1048576.0, opt.Kb, opt.Xfer );
+    printf( "cache: %u hits, %u loads, %u read ahead, %u erases, %u write-backs; %u NAKs, %u errors\n",
+            Cache_Stat.Hit, Cache_Stat.Load, Cache_Stat.Ahead, Cache_Stat.Erase, Cache_Stat.Flush, Sim.Naks, Sim.Errors );
+    return Sim.Errors ? 1 : 0;
+}
@@ -314,18 +314,22 @@ void UART2_USB_Init( void )
     uint32_t baudrate;
     uint8_t  stopbits;
     uint8_t  parity;
+    uint8_t  stop;
 
     baudrate = ( uint32_t )( Uart.Com_Cfg[ 3 ] << 24 ) + ( uint32_t )( Uart.Com_Cfg[ 2 ] << 16 );
     baudrate += ( uint32_t )( Uart.Com_Cfg[ 1 ] << 8 ) + ( uint32_t )( Uart.Com_Cfg[ 0 ] );
     stopbits = Uart.Com_Cfg[ 4 ];
     parity = Uart.Com_Cfg[ 5 ];
+    stop = Uart.USB_Down_StopFlag;
 
     UART2_Init( 0, baudrate, stopbits, parity );
 
     /* restart usb receive  */
-    USBFSD->UEP2_DMA = (uint32_t)(uint8_t *)&UART2_Tx_Buf[ 0 ];
-    USBFSD->UEP2_CTRL_H &= ~USBFS_UEP_R_RES_MASK;
-    USBFSD->UEP2_CTRL_H |= USBFS_UEP_R_RES_ACK;
+    USBFS_Endp_RxBuf_Set( DEF_UEP2, &UART2_Tx_Buf[ 0 ] );
+    if( stop )
+    {
+        USBFS_Endp_RxDone( DEF_UEP2 );
+    }
 }
 
 /*********************************************************************
@@ -371,9 +375,8 @@ void UART2_DataTx_Deal( void )
             /* If the current serial port has suspended the downlink, restart the driver downlink */
             if( ( Uart.USB_Down_StopFlag == 0x01 ) && ( Uart.Tx_RemainNum < 2 ) )
             {
-                USBFSD->UEP2_CTRL_H &= ~USBFS_UEP_R_RES_MASK;
-                USBFSD->UEP2_CTRL_H |= USBFS_UEP_R_RES_ACK;
                 Uart.USB_Down_StopFlag = 0x00;
+                USBFS_Endp_RxDone( DEF_UEP2 );
             }
 
             NVIC_EnableIRQ( USBFS_IRQn );
@@ -478,21 +481,23 @@ void UART2_DataRx_Deal( void )
             {
                 NVIC_DisableIRQ( USBFS_IRQn );
                 NVIC_DisableIRQ( USBFS_IRQn );
-                Uart.USB_Up_IngFlag = 0x01;
-                Uart.USB_Up_TimeOut = 0x00;
-                USBFS_Endp_DataUp( DEF_UEP3, &UART2_Rx_Buf[ Uart.Rx_DealPtr ], packlen, DEF_UEP_CPY_LOAD );
-                /* Calculate the variables of interest */
-                Uart.Rx_RemainLen -= packlen;
-                Uart.Rx_DealPtr += packlen;
-                if( Uart.Rx_DealPtr >= DEF_UARTx_RX_BUF_LEN )
-                {
-                    Uart.Rx_DealPtr = 0x00;
-                }
-
-                /* Start 0-length packet timeout timer */
-                if( packlen == DEF_USBD_FS_PACK_SIZE )
+                if( USBFS_Endp_DataUp( DEF_UEP3, &UART2_Rx_Buf[ Uart.Rx_DealPtr ], packlen, DEF_UEP_CPY_LOAD ) == 0 )
                 {
-                    Uart.USB_Up_Pack0_Flag = 0x01;
+                    Uart.USB_Up_IngFlag = 0x01;
+                    Uart.USB_Up_TimeOut = 0x00;
+                    /* Calculate the variables of interest */
+                    Uart.Rx_RemainLen -= packlen;
+                    Uart.Rx_DealPtr += packlen;
+                    if( Uart.Rx_DealPtr >= DEF_UARTx_RX_BUF_LEN )
+                    {
+                        Uart.Rx_DealPtr = 0x00;
+                    }
+
+                    /* Start 0-length packet timeout timer */
+                    if( packlen == DEF_USBD_FS_PACK_SIZE )
+                    {
+                        Uart.USB_Up_Pack0_Flag = 0x01;
+                    }
                 }
 
                 NVIC_EnableIRQ( USBFS_IRQn );
@@ -500,11 +505,11 @@ void UART2_DataRx_Deal( void )
         }
         else
         {
-            /* Set the upload success flag directly if the upload is not successful after the timeout */
+            /* Set the upload success flag directly if the upload is not successful after the timeout,
+               the core keeps the packet queued and USBFS_Endp_DataUp stays busy until it has gone */
             if( Uart.USB_Up_TimeOut >= DEF_UARTx_USB_UP_TIMEOUT )
             {
                 Uart.USB_Up_IngFlag = 0x00;
-                USBFS_Endp_Busy[ DEF_UEP3 ] = 0;
             }
         }
     }
@@ -519,11 +524,11 @@ void UART2_DataRx_Deal( void )
             {
                 NVIC_DisableIRQ( USBFS_IRQn );
                 NVIC_DisableIRQ( USBFS_IRQn );
-                Uart.USB_Up_IngFlag = 0x01;
                 Uart.USB_Up_TimeOut = 0x00;
-                USBFS_Endp_DataUp( DEF_UEP3, &UART2_Rx_Buf[ Uart.Rx_DealPtr ], 0, DEF_UEP_CPY_LOAD );
-                Uart.USB_Up_IngFlag = 0;
-                Uart.USB_Up_Pack0_Flag = 0x00;
+                if( USBFS_Endp_DataUp( DEF_UEP3, &UART2_Rx_Buf[ Uart.Rx_DealPtr ], 0, DEF_UEP_CPY_LOAD ) == 0 )
+                {
+                    Uart.USB_Up_Pack0_Flag = 0x00;
+                }
                 NVIC_EnableIRQ( USBFS_IRQn );
             }
         }
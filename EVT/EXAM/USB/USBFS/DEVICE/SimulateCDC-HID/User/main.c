@@ -18,7 +18,7 @@
  *(2),Merged HID devices, using endpoint 4 data downlink to fetch reverse upload;
 */
 
-#include <ch643_usbfs_device.h>
+#include "usbd_cdc_hid.h"
 #include "debug.h"
 
 
@@ -47,6 +47,8 @@ int main(void)
     UART2_Init( 1, DEF_UARTx_BAUDRATE, DEF_UARTx_STOPBIT, DEF_UARTx_PARITY );
 
     /* Usb Init */
+    USBFS_Class_Register( &CDC_Class_Drv );
+    USBFS_Class_Register( &HID_Class_Drv );
     USBFS_RCC_Init( );
     USBFS_Device_Init( ENABLE , PWR_VDD_SupplyVoltage());
 
@@ -0,0 +1,336 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : usbd_cdc_hid.c
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: CDC-ACM and HID class drivers on the shared USBFS device core.
+ *              CDC interfaces 0/1: endpoint 1 IN is the notification
+ *              endpoint, endpoint 2 OUT feeds the USART2 send buffer and
+ *              endpoint 3 IN uploads the USART2 receive buffer.
+ *              HID interface 2: endpoint 4 OUT is inverted and sent back
+ *              on endpoint 4 IN.
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "usbd_cdc_hid.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+/* HID Class Command */
+volatile uint8_t  USBFS_HidIdle;
+volatile uint8_t  USBFS_HidProtocol;
+volatile uint16_t Hid_Report_Ptr;
+
+/* HID Report Buffer */
+__attribute__ ((aligned(4))) uint8_t  HID_Report_Buffer[DEF_USBD_FS_PACK_SIZE];
+
+/* Inverted data of endpoint 4 OUT, read by the core until endpoint 4 IN is done */
+__attribute__ ((aligned(4))) uint8_t  Endp4_Tx_Buf[DEF_USBD_ENDP4_SIZE];
+
+/*********************************************************************
+ * @fn      CDC_Init
+ *
+ * @brief   Reset the serial port state and open the CDC endpoints,
+ *          called on device init and bus reset.
+ *
+ * @return  none
+ */
+static void CDC_Init( void )
+{
+    UART2_ParaInit( 1 );
+
+    USBFS_Endp_Open( DEF_UEP1, USBFSD_UEP_TX_EN, DEF_USBD_ENDP1_SIZE );
+    USBFS_Endp_Open( DEF_UEP2, USBFSD_UEP_RX_EN, DEF_USBD_ENDP2_SIZE );
+    USBFS_Endp_Open( DEF_UEP3, USBFSD_UEP_TX_EN, DEF_USBD_ENDP3_SIZE );
+
+    /* Endpoint 2 receives straight into the send buffer */
+    USBFS_Endp_RxBuf_Set( DEF_UEP2, &UART2_Tx_Buf[ 0 ] );
+}
+
+/*********************************************************************
+ * @fn      CDC_Setup
+ *
+ * @brief   CDC class and vendor requests.
+ *
+ * @return  DEF_USBD_REQ_OK or DEF_USBD_REQ_ERR
+ */
+static uint8_t CDC_Setup( const uint8_t **ppbuf, uint16_t *plen )
+{
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_CLASS )
+    {
+        /* Class requests */
+        switch( USBFS_SetupReqCode )
+        {
+            case CDC_GET_LINE_CODING:
+                *ppbuf = (const uint8_t *)&Uart.Com_Cfg[ 0 ];
+                *plen = 7;
+                break;
+
+            case CDC_SET_LINE_CODING:
+            case CDC_SET_LINE_CTLSTE:
+            case CDC_SEND_BREAK:
+                break;
+
+            default:
+                return DEF_USBD_REQ_ERR;
+        }
+        return DEF_USBD_REQ_OK;
+    }
+    else if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_VENDOR )
+    {
+        /* Manufacturer request */
+        return DEF_USBD_REQ_OK;
+    }
+    return DEF_USBD_REQ_ERR;
+}
+
+/*********************************************************************
+ * @fn      CDC_EP0_Out
+ *
+ * @brief   Control OUT data, the new line coding.
+ *
+ * @return  none
+ */
+static void CDC_EP0_Out( uint8_t *pbuf, uint16_t len )
+{
+    if( ( USBFS_SetupReqCode == CDC_SET_LINE_CODING ) && ( len >= 7 ) )
+    {
+        /* Save relevant parameters such as serial port baud rate */
+        /* The 7 bytes of the downlink are, in order
+           4 bytes: baud rate value: lowest baud rate byte, next lowest baud rate byte, next highest baud rate byte, highest baud rate byte.
+           1 byte: number of stop bits (0: 1 stop bit; 1: 1.5 stop bit; 2: 2 stop bits).
+           1 byte: number of parity bits (0: None; 1: Odd; 2: Even; 3: Mark; 4: Space).
+           1 byte: number of data bits (5,6,7,8,16); */
+        memcpy( (uint8_t *)&Uart.Com_Cfg[ 0 ], pbuf, 7 );
+        Uart.Com_Cfg[ 7 ] = Uart.Rx_TimeOutMax;
+
+        /* UART initialization operation */
+        UART2_USB_Init( );
+    }
+}
+
+/*********************************************************************
+ * @fn      CDC_Out
+ *
+ * @brief   OUT packet received on endpoint 2, already in the send buffer.
+ *
+ * @return  none
+ */
+static void CDC_Out( uint8_t endp, uint8_t *pbuf, uint16_t len )
+{
+    if( endp != DEF_UEP2 )
+    {
+        USBFS_Endp_RxDone( endp );
+        return;
+    }
+
+    Uart.Tx_PackLen[ Uart.Tx_LoadNum ] = len;
+    Uart.Tx_LoadNum++;
+    if( Uart.Tx_LoadNum >= DEF_UARTx_TX_BUF_NUM_MAX )
+    {
+        Uart.Tx_LoadNum = 0x00;
+    }
+    USBFS_Endp_RxBuf_Set( DEF_UEP2, &UART2_Tx_Buf[ ( Uart.Tx_LoadNum * DEF_USB_FS_PACK_LEN ) ] );
+    Uart.Tx_RemainNum++;
+
+    if( Uart.Tx_RemainNum >= ( DEF_UARTx_TX_BUF_NUM_MAX - 2 ) )
+    {
+        /* Keep NAKing until UART2_DataTx_Deal has sent some slots */
+        Uart.USB_Down_StopFlag = 0x01;
+    }
+    else
+    {
+        USBFS_Endp_RxDone( DEF_UEP2 );
+    }
+}
+
+/*********************************************************************
+ * @fn      CDC_In
+ *
+ * @brief   IN transfer done on endpoint 1/3.
+ *
+ * @return  none
+ */
+static void CDC_In( uint8_t endp )
+{
+    if( endp == DEF_UEP3 )
+    {
+        Uart.USB_Up_IngFlag = 0x00;
+    }
+}
+
+/*********************************************************************
+ * @fn      HID_Init
+ *
+ * @brief   Open endpoint 4 OUT/IN, called on device init and bus reset.
+ *
+ * @return  none
+ */
+static void HID_Init( void )
+{
+    Hid_Report_Ptr = 0;
+    USBFS_Endp_Open( DEF_UEP4, USBFSD_UEP_RX_EN | USBFSD_UEP_TX_EN, DEF_USBD_ENDP4_SIZE );
+}
+
+/*********************************************************************
+ * @fn      HID_Setup
+ *
+ * @brief   HID class requests and the HID/report descriptors of
+ *          interface 2.
+ *
+ * @return  DEF_USBD_REQ_OK or DEF_USBD_REQ_ERR
+ */
+static uint8_t HID_Setup( const uint8_t **ppbuf, uint16_t *plen )
+{
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_STANDARD )
+    {
+        if( USBFS_SetupReqCode != USB_GET_DESCRIPTOR )
+        {
+            return DEF_USBD_REQ_ERR;
+        }
+        switch( (uint8_t)( USBFS_SetupReqValue >> 8 ) )
+        {
+            /* get hid report descriptor */
+            case USB_DESCR_TYP_REPORT:
+                *ppbuf = MyHIDReportDesc;
+                *plen = DEF_USBD_REPORT_DESC_LEN;
+                break;
+
+            /* get hid descriptor */
+            case USB_DESCR_TYP_HID:
+                *ppbuf = &MyCfgDescr[ 84 ];
+                *plen = 9;
+                break;
+
+            default:
+                return DEF_USBD_REQ_ERR;
+        }
+        return DEF_USBD_REQ_OK;
+    }
+
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) != USB_REQ_TYP_CLASS )
+    {
+        return DEF_USBD_REQ_ERR;
+    }
+    switch( USBFS_SetupReqCode )
+    {
+        case HID_SET_REPORT:                                                    /* 0x09: SET_REPORT */
+            Hid_Report_Ptr = 0;
+            break;
+
+        case HID_GET_REPORT:                                                    /* 0x01: GET_REPORT */
+            *ppbuf = HID_Report_Buffer;
+            *plen = sizeof( HID_Report_Buffer );
+            break;
+
+        case HID_SET_IDLE:                                                      /* 0x0A: SET_IDLE */
+            USBFS_HidIdle = (uint8_t)( USBFS_SetupReqValue >> 8 );
+            break;
+
+        case HID_SET_PROTOCOL:                                                  /* 0x0B: SET_PROTOCOL */
+            USBFS_HidProtocol = (uint8_t)USBFS_SetupReqValue;
+            break;
+
+        case HID_GET_IDLE:                                                      /* 0x02: GET_IDLE */
+            USBFS_EP0_4Buf[ 0 ] = USBFS_HidIdle;
+            if( USBFS_SetupReqLen > 1 )
+            {
+                USBFS_SetupReqLen = 1;
+            }
+            break;
+
+        case HID_GET_PROTOCOL:                                                  /* 0x03: GET_PROTOCOL */
+            USBFS_EP0_4Buf[ 0 ] = USBFS_HidProtocol;
+            if( USBFS_SetupReqLen > 1 )
+            {
+                USBFS_SetupReqLen = 1;
+            }
+            break;
+
+        default:
+            return DEF_USBD_REQ_ERR;
+    }
+    return DEF_USBD_REQ_OK;
+}
+
+/*********************************************************************
+ * @fn      HID_EP0_Out
+ *
+ * @brief   Set_Report data, appended to the report buffer.
+ *
+ * @return  none
+ */
+static void HID_EP0_Out( uint8_t *pbuf, uint16_t len )
+{
+    if( ( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_CLASS ) && ( USBFS_SetupReqCode == HID_SET_REPORT ) )
+    {
+        if( len > ( sizeof( HID_Report_Buffer ) - Hid_Report_Ptr ) )
+        {
+            len = sizeof( HID_Report_Buffer ) - Hid_Report_Ptr;
+        }
+        memcpy( &HID_Report_Buffer[ Hid_Report_Ptr ], pbuf, len );
+        Hid_Report_Ptr += len;
+    }
+}
+
+/*********************************************************************
+ * @fn      HID_Out
+ *
+ * @brief   Endpoint 4 OUT packet, inverted and sent back. The endpoint
+ *          stays NAK until the inverted data has gone.
+ *
+ * @return  none
+ */
+static void HID_Out( uint8_t endp, uint8_t *pbuf, uint16_t len )
+{
+    uint16_t i;
+
+    /* Reverse the data and re-upload */
+    for( i = 0; i < len; i++ )
+    {
+        Endp4_Tx_Buf[ i ] = ~pbuf[ i ];
+    }
+    USBFS_Endp_Transmit( DEF_UEP4, Endp4_Tx_Buf, len, 0 );
+}
+
+/*********************************************************************
+ * @fn      HID_In
+ *
+ * @brief   Endpoint 4 IN done, receive the next packet.
+ *
+ * @return  none
+ */
+static void HID_In( uint8_t endp )
+{
+    USBFS_Endp_RxDone( DEF_UEP4 );
+}
+
+/* Class drivers */
+const USBFS_CLASS_DRV CDC_Class_Drv =
+{
+    0, 2,
+    ( 1 << DEF_UEP1 ) | ( 1 << DEF_UEP2 ) | ( 1 << DEF_UEP3 ),
+    CDC_Init,
+    CDC_Setup,
+    CDC_EP0_Out,
+    CDC_Out,
+    CDC_In,
+    NULL,
+    NULL,
+};
+
+const USBFS_CLASS_DRV HID_Class_Drv =
+{
+    2, 1,
+    ( 1 << DEF_UEP4 ),
+    HID_Init,
+    HID_Setup,
+    HID_EP0_Out,
+    HID_Out,
+    HID_In,
+    NULL,
+    NULL,
+};
@@ -0,0 +1,588 @@
+/********************************** (C) COPYRIGHT *******************************
+* File Name          : UART.C
+* Author             : WCH
+* Version            : V1.0.0
+* Date               : 2026/10/19
+* Description        : uart serial port related initialization and processing,
+*                      USART1-4, each with its own DMA channels
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "usbd_cdc.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+/* Global */
+
+/* Serial port resources: USARTx, Tx DMA, Rx DMA, DMA flags, interrupts, Tx/Rx pins */
+const UART_PORT_CFG Uart_Port[ DEF_UART_PORT_NUM ] =
+{
+    { USART1, DMA1_Channel4, DMA1_Channel5, DMA1_IT_TC4, DMA1_IT_HT5, DMA1_IT_TC5,
+      USART1_IRQn, DMA1_Channel4_IRQn, DMA1_Channel5_IRQn, GPIOB, GPIO_Pin_10, GPIO_Pin_11 },
+    { USART2, DMA1_Channel7, DMA1_Channel6, DMA1_IT_TC7, DMA1_IT_HT6, DMA1_IT_TC6,
+      USART2_IRQn, DMA1_Channel7_IRQn, DMA1_Channel6_IRQn, GPIOA, GPIO_Pin_2, GPIO_Pin_3 },
+    { USART3, DMA1_Channel2, DMA1_Channel3, DMA1_IT_TC2, DMA1_IT_HT3, DMA1_IT_TC3,
+      USART3_IRQn, DMA1_Channel2_IRQn, DMA1_Channel3_IRQn, GPIOB, GPIO_Pin_3, GPIO_Pin_4 },
+    { USART4, DMA1_Channel1, DMA1_Channel8, DMA1_IT_TC1, DMA1_IT_HT8, DMA1_IT_TC8,
+      USART4_IRQn, DMA1_Channel1_IRQn, DMA1_Channel8_IRQn, GPIOB, GPIO_Pin_0, GPIO_Pin_1 },
+};
+
+/* The following are serial port transmit and receive related variables and buffers */
+volatile UART_CTL  Uart[ DEF_UART_PORT_NUM ];
+volatile UART_STAT Uart_Stat[ DEF_UART_PORT_NUM ];
+
+__attribute__ ((aligned(4))) uint8_t  UART_Tx_Buf[ DEF_UART_PORT_NUM ][ DEF_UARTx_TX_BUF_LEN ];  /* Serial port x transmit data buffer */
+__attribute__ ((aligned(4))) uint8_t  UART_Rx_Buf[ DEF_UART_PORT_NUM ][ DEF_UARTx_RX_BUF_LEN ];  /* Serial port x receive data buffer */
+
+/*********************************************************************
+ * @fn      RCC_Configuration
+ *
+ * @brief   Configures the different system clocks.
+ *
+ * @return  none
+ */
+uint8_t RCC_Configuration( void )
+{
+    RCC_APB2PeriphClockCmd( RCC_APB2Periph_GPIOA | RCC_APB2Periph_GPIOB | RCC_APB2Periph_USART1, ENABLE );
+    RCC_APB1PeriphClockCmd( RCC_APB1Periph_USART2 | RCC_APB1Periph_USART3 | RCC_APB1Periph_USART4, ENABLE );
+    RCC_AHBPeriphClockCmd( RCC_AHBPeriph_DMA1, ENABLE );
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      UART_CfgInit
+ *
+ * @brief   Uartx configuration initialization
+ *
+ * @return  none
+ */
+void UART_CfgInit( uint8_t port, uint32_t baudrate, uint8_t stopbits, uint8_t parity )
+{
+    const UART_PORT_CFG *pcfg = &Uart_Port[ port ];
+    USART_InitTypeDef USART_InitStructure = {0};
+    GPIO_InitTypeDef  GPIO_InitStructure = {0};
+
+    /* First set the serial port introduction to output high then close the TE and RE of CTLR1 register (note that USARTx->CTLR1 register setting 9 bits has a limit) */
+    /* Note: This operation must be performed, the TX pin otherwise the level will be pulled low */
+    GPIO_SetBits( pcfg->GPIOx, pcfg->Tx_Pin );
+    GPIO_InitStructure.GPIO_Pin   = pcfg->Tx_Pin;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_Out_PP;
+    GPIO_Init( pcfg->GPIOx, &GPIO_InitStructure );
+
+    /* clear te/re */
+    pcfg->USARTx->CTLR1 &= ~( USART_CTLR1_TE | USART_CTLR1_RE );
+
+    /* Configure Rx as input pull-up */
+    GPIO_InitStructure.GPIO_Pin   = pcfg->Rx_Pin;
+    GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_IPU;
+    GPIO_Init( pcfg->GPIOx, &GPIO_InitStructure );
+
+    /* Configure Tx as alternate function push-pull */
+    GPIO_InitStructure.GPIO_Pin   = pcfg->Tx_Pin;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_AF_PP;
+    GPIO_Init( pcfg->GPIOx, &GPIO_InitStructure );
+
+    USART_InitStructure.USART_BaudRate = baudrate;
+    USART_InitStructure.USART_WordLength = USART_WordLength_8b;
+
+    /* Number of stop bits (0: 1 stop bit; 1: 1.5 stop bits; 2: 2 stop bits). */
+    if( stopbits == 1 )
+    {
+        USART_InitStructure.USART_StopBits = USART_StopBits_1_5;
+    }
+    else if( stopbits == 2 )
+    {
+        USART_InitStructure.USART_StopBits = USART_StopBits_2;
+    }
+    else
+    {
+        USART_InitStructure.USART_StopBits = USART_StopBits_1;
+    }
+
+    /* Check digit (0: None; 1: Odd; 2: Even; 3: Mark; 4: Space); */
+    if( parity == 1 )
+    {
+        USART_InitStructure.USART_Parity = USART_Parity_Odd;
+        USART_InitStructure.USART_WordLength = USART_WordLength_9b;
+    }
+    else if( parity == 2 )
+    {
+        USART_InitStructure.USART_Parity = USART_Parity_Even;
+        USART_InitStructure.USART_WordLength = USART_WordLength_9b;
+    }
+    else
+    {
+        USART_InitStructure.USART_Parity = USART_Parity_No;
+    }
+    USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+    USART_InitStructure.USART_Mode = USART_Mode_Rx | USART_Mode_Tx;
+    USART_Init( pcfg->USARTx, &USART_InitStructure );
+    USART_ClearFlag( pcfg->USARTx, USART_FLAG_TC );
+
+    /* The idle line interrupt flushes a partial packet to usb */
+    USART_ITConfig( pcfg->USARTx, USART_IT_IDLE, ENABLE );
+
+    /* Enable USARTx */
+    USART_Cmd( pcfg->USARTx, ENABLE );
+}
+
+/*********************************************************************
+ * @fn      UART_ParaInit
+ *
+ * @brief   Uartx parameters initialization
+ *          mode = 0 : Used in usb modify initialization
+ *          mode = 1 : Used in default initializations
+ * @return  none
+ */
+void UART_ParaInit( uint8_t port, uint8_t mode )
+{
+    volatile UART_CTL *pu = &Uart[ port ];
+    uint8_t i;
+
+    pu->Rx_DealPtr = 0x00;
+    pu->Rx_RemainLen = 0x00;
+    pu->Rx_FlushFlag = 0x00;
+    pu->Rx_DMALastCount = DEF_UARTx_RX_BUF_LEN;
+
+    pu->Tx_LoadNum = 0x00;
+    pu->Tx_DealNum = 0x00;
+    pu->Tx_RemainNum = 0x00;
+    for( i = 0; i < DEF_UARTx_TX_BUF_NUM_MAX; i++ )
+    {
+        pu->Tx_PackLen[ i ] = 0x00;
+    }
+    pu->Tx_Flag = 0x00;
+    pu->Tx_CurPackNum = 0x00;
+    pu->Tx_CurPackLen = 0x00;
+
+    if( mode )
+    {
+        /* The endpoints are reset with the port, on a line coding change
+           queued uploads and held packets complete as usual */
+        pu->Rx_UpLen = 0x00;
+        pu->Rx_UpHead = 0x00;
+        pu->Rx_UpCnt = 0x00;
+        pu->USB_Down_StopCnt = 0x00;
+
+        pu->Com_Cfg[ 0 ] = (uint8_t)( DEF_UARTx_BAUDRATE );
+        pu->Com_Cfg[ 1 ] = (uint8_t)( DEF_UARTx_BAUDRATE >> 8 );
+        pu->Com_Cfg[ 2 ] = (uint8_t)( DEF_UARTx_BAUDRATE >> 16 );
+        pu->Com_Cfg[ 3 ] = (uint8_t)( DEF_UARTx_BAUDRATE >> 24 );
+        pu->Com_Cfg[ 4 ] = DEF_UARTx_STOPBIT;
+        pu->Com_Cfg[ 5 ] = DEF_UARTx_PARITY;
+        pu->Com_Cfg[ 6 ] = DEF_UARTx_DATABIT;
+        pu->Com_Cfg[ 7 ] = 0x00;
+    }
+}
+
+/*********************************************************************
+ * @fn      UART_DMAInit
+ *
+ * @brief   Uartx DMA configuration initialization
+ *          type = 0 : USARTx_TX
+ *          type = 1 : USARTx_RX
+ *          pbuf     : Tx/Rx Buffer, should be aligned(4)
+ *          len      : buffer size of Tx/Rx Buffer
+ *
+ * @return  none
+ */
+void UART_DMAInit( uint8_t port, uint8_t type, uint8_t *pbuf, uint32_t len )
+{
+    const UART_PORT_CFG *pcfg = &Uart_Port[ port ];
+    DMA_InitTypeDef DMA_InitStructure = {0};
+
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)(&pcfg->USARTx->DATAR);
+    DMA_InitStructure.DMA_MemoryBaseAddr = (u32)pbuf;
+    DMA_InitStructure.DMA_BufferSize = len;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    if( type == 0x00 )
+    {
+        /* Tx-DMA configuration */
+        DMA_DeInit( pcfg->Tx_DMA_CH );
+        DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+        DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+        DMA_Init( pcfg->Tx_DMA_CH, &DMA_InitStructure );
+        DMA_ITConfig( pcfg->Tx_DMA_CH, DMA_IT_TC, ENABLE );
+    }
+    else
+    {
+        /* Rx-DMA configuration */
+        DMA_DeInit( pcfg->Rx_DMA_CH );
+        DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+        DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+        DMA_Init( pcfg->Rx_DMA_CH, &DMA_InitStructure );
+        DMA_ITConfig( pcfg->Rx_DMA_CH, DMA_IT_HT | DMA_IT_TC, ENABLE );
+
+        DMA_Cmd( pcfg->Rx_DMA_CH, ENABLE );
+    }
+}
+
+/*********************************************************************
+ * @fn      UART_Init
+ *
+ * @brief   Uartx total initialization
+ *          mode     : See the useage of UART_ParaInit( port, mode )
+ *          baudrate : Serial port x default baud rate
+ *          stopbits : Serial port x default stop bits
+ *          parity   : Serial port x default parity
+ *
+ * @return  none
+ */
+void UART_Init( uint8_t port, uint8_t mode, uint32_t baudrate, uint8_t stopbits, uint8_t parity )
+{
+    const UART_PORT_CFG *pcfg = &Uart_Port[ port ];
+
+    USART_DMACmd( pcfg->USARTx, USART_DMAReq_Rx | USART_DMAReq_Tx, DISABLE );
+    DMA_Cmd( pcfg->Rx_DMA_CH, DISABLE );
+    DMA_Cmd( pcfg->Tx_DMA_CH, DISABLE );
+
+    UART_CfgInit( port, baudrate, stopbits, parity );
+    UART_DMAInit( port, 0, &UART_Tx_Buf[ port ][ 0 ], 0 );
+    UART_DMAInit( port, 1, &UART_Rx_Buf[ port ][ 0 ], DEF_UARTx_RX_BUF_LEN );
+    UART_ParaInit( port, mode );
+
+    USART_DMACmd( pcfg->USARTx, USART_DMAReq_Rx | USART_DMAReq_Tx, ENABLE );
+
+    /* Same priority as USBFS, see UART_CTL */
+    NVIC_EnableIRQ( pcfg->Rx_DMA_IRQ );
+    NVIC_EnableIRQ( pcfg->Tx_DMA_IRQ );
+    NVIC_EnableIRQ( pcfg->USART_IRQ );
+}
+
+/*********************************************************************
+ * @fn      UART_DataTx_Release
+ *
+ * @brief   Release held usb packets while the send buffer has a slot for
+ *          every endpoint buffer that could then be filled.
+ *
+ * @return  none
+ */
+static void UART_DataTx_Release( uint8_t port )
+{
+    volatile UART_CTL *pu = &Uart[ port ];
+
+    while( pu->USB_Down_StopCnt &&
+           ( ( DEF_UARTx_TX_BUF_NUM_MAX - pu->Tx_RemainNum ) >= ( pu->USB_Down_Halves - pu->USB_Down_StopCnt + 1 ) ) )
+    {
+        pu->USB_Down_StopCnt--;
+        USBFS_Endp_RxDone( DEF_CDC_DATA_EP( port ) );
+    }
+}
+
+/*********************************************************************
+ * @fn      UART_DataTx_Start
+ *
+ * @brief   Start the send DMA on the oldest loaded packets. Full packets
+ *          that follow each other in the buffer go out in one transfer.
+ *
+ * @return  none
+ */
+static void UART_DataTx_Start( uint8_t port )
+{
+    volatile UART_CTL *pu = &Uart[ port ];
+    DMA_Channel_TypeDef *pch = Uart_Port[ port ].Tx_DMA_CH;
+    uint16_t num;
+    uint16_t len;
+
+    if( pu->Tx_Flag || ( pu->Tx_RemainNum == 0 ) )
+    {
+        return;
+    }
+
+    num = 0;
+    len = 0;
+    do
+    {
+        len += pu->Tx_PackLen[ pu->Tx_DealNum + num ];
+        num++;
+    } while( ( num < pu->Tx_RemainNum ) && ( ( pu->Tx_DealNum + num ) < DEF_UARTx_TX_BUF_NUM_MAX ) &&
+             ( pu->Tx_PackLen[ pu->Tx_DealNum + num - 1 ] == DEF_USB_FS_PACK_LEN ) );
+    pu->Tx_CurPackNum = num;
+    pu->Tx_CurPackLen = len;
+
+    /* Configure DMA and send */
+    DMA_Cmd( pch, DISABLE );
+    pch->MADDR = (uint32_t)&UART_Tx_Buf[ port ][ pu->Tx_DealNum * DEF_USB_FS_PACK_LEN ];
+    pch->CNTR = len;
+    DMA_Cmd( pch, ENABLE );
+    pu->Tx_Flag = 0x01;
+}
+
+/*********************************************************************
+ * @fn      UART_DataTx_Load
+ *
+ * @brief   Copy a usb packet into the send buffer and start sending.
+ *          The endpoint buffer is released at once if the send buffer
+ *          can take a packet in every endpoint buffer, otherwise it is
+ *          held (NAK) until the DMA frees slots.
+ *
+ * @return  none
+ */
+void UART_DataTx_Load( uint8_t port, uint8_t *pbuf, uint16_t len )
+{
+    volatile UART_CTL *pu = &Uart[ port ];
+
+    if( len )
+    {
+        memcpy( &UART_Tx_Buf[ port ][ pu->Tx_LoadNum * DEF_USB_FS_PACK_LEN ], pbuf, len );
+        pu->Tx_PackLen[ pu->Tx_LoadNum ] = len;
+        pu->Tx_LoadNum++;
+        if( pu->Tx_LoadNum >= DEF_UARTx_TX_BUF_NUM_MAX )
+        {
+            pu->Tx_LoadNum = 0x00;
+        }
+        pu->Tx_RemainNum++;
+
+        UART_DataTx_Start( port );
+    }
+
+    /* Endpoint buffers are released in order, so even a zero-length
+       packet waits behind held ones */
+    pu->USB_Down_StopCnt++;
+    UART_DataTx_Release( port );
+}
+
+/*********************************************************************
+ * @fn      UART_Tx_DMA_IRQ
+ *
+ * @brief   Uartx send DMA done. Frees the sent packets and releases
+ *          held usb packets.
+ *
+ * @return  none
+ */
+void UART_Tx_DMA_IRQ( uint8_t port )
+{
+    volatile UART_CTL *pu = &Uart[ port ];
+    uint8_t i;
+
+    if( DMA_GetITStatus( Uart_Port[ port ].Tx_DMA_TC ) == RESET )
+    {
+        return;
+    }
+    DMA_ClearITPendingBit( Uart_Port[ port ].Tx_DMA_TC );
+    if( pu->Tx_Flag == 0 )
+    {
+        return;
+    }
+    pu->Tx_Flag = 0x00;
+
+    for( i = 0; i < pu->Tx_CurPackNum; i++ )
+    {
+        pu->Tx_PackLen[ pu->Tx_DealNum ] = 0x0000;
+        pu->Tx_DealNum++;
+        if( pu->Tx_DealNum >= DEF_UARTx_TX_BUF_NUM_MAX )
+        {
+            pu->Tx_DealNum = 0x00;
+        }
+    }
+    pu->Tx_RemainNum -= pu->Tx_CurPackNum;
+    Uart_Stat[ port ].Tx_Total += pu->Tx_CurPackLen;
+
+    UART_DataTx_Release( port );
+    UART_DataTx_Start( port );
+}
+
+/*********************************************************************
+ * @fn      UART_DataRx_Up
+ *
+ * @brief   Queue received data for upload on the port's bulk IN
+ *          endpoint. Only whole packets are queued until the line goes
+ *          idle, and no upload is longer than DEF_UARTx_UP_MAX_LEN so
+ *          that a busy port cannot hold the bus with one long transfer.
+ *
+ * @return  none
+ */
+static void UART_DataRx_Up( uint8_t port )
+{
+    volatile UART_CTL *pu = &Uart[ port ];
+    uint16_t len;
+    uint8_t  flag;
+
+    while( pu->Rx_RemainLen && ( pu->Rx_UpCnt < DEF_USBD_TXQ_DEPTH ) )
+    {
+        len = pu->Rx_RemainLen;
+        if( len > DEF_UARTx_UP_MAX_LEN )
+        {
+            len = DEF_UARTx_UP_MAX_LEN;
+        }
+        if( len >= ( DEF_UARTx_RX_BUF_LEN - pu->Rx_DealPtr ) )
+        {
+            /* Stop at the end of the buffer */
+            len = DEF_UARTx_RX_BUF_LEN - pu->Rx_DealPtr;
+        }
+        else if( pu->Rx_FlushFlag == 0 )
+        {
+            len -= len % DEF_USB_FS_PACK_LEN;
+            if( len == 0 )
+            {
+                break;
+            }
+        }
+
+        flag = 0;
+        if( pu->Rx_FlushFlag && ( len == pu->Rx_RemainLen ) )
+        {
+            /* Required for CDC mode, end the transfer */
+            flag |= DEF_UEP_TX_ZLP;
+        }
+        if( USBFS_Endp_Transmit( DEF_CDC_DATA_EP( port ), &UART_Rx_Buf[ port ][ pu->Rx_DealPtr ], len, flag ) )
+        {
+            break;
+        }
+
+        pu->Rx_UpPackLen[ ( pu->Rx_UpHead + pu->Rx_UpCnt ) % DEF_USBD_TXQ_DEPTH ] = len;
+        pu->Rx_UpCnt++;
+        pu->Rx_UpLen += len;
+        pu->Rx_RemainLen -= len;
+        pu->Rx_DealPtr += len;
+        if( pu->Rx_DealPtr >= DEF_UARTx_RX_BUF_LEN )
+        {
+            pu->Rx_DealPtr = 0x00;
+        }
+    }
+
+    if( pu->Rx_RemainLen == 0 )
+    {
+        pu->Rx_FlushFlag = 0x00;
+    }
+}
+
+/*********************************************************************
+ * @fn      UART_DataRx_Deal
+ *
+ * @brief   Uartx data receiving processing.
+ *
+ * @param   flush - line idle, upload the partial packet as well
+ *
+ * @return  none
+ */
+static void UART_DataRx_Deal( uint8_t port, uint8_t flush )
+{
+    volatile UART_CTL *pu = &Uart[ port ];
+    uint16_t count;
+    uint16_t len;
+
+    count = Uart_Port[ port ].Rx_DMA_CH->CNTR;
+    if( pu->Rx_DMALastCount >= count )
+    {
+        len = pu->Rx_DMALastCount - count;
+    }
+    else
+    {
+        len = pu->Rx_DMALastCount + DEF_UARTx_RX_BUF_LEN - count;
+    }
+    pu->Rx_DMALastCount = count;
+
+    if( ( pu->Rx_RemainLen + pu->Rx_UpLen + len ) > DEF_UARTx_RX_BUF_LEN )
+    {
+        /* Overflow handling, the oldest data has been overwritten.
+           Drop everything not yet queued and carry on from the DMA position */
+        Uart_Stat[ port ].Rx_Overrun += pu->Rx_RemainLen + len;
+        pu->Rx_RemainLen = 0x00;
+        pu->Rx_DealPtr = ( DEF_UARTx_RX_BUF_LEN - count ) % DEF_UARTx_RX_BUF_LEN;
+    }
+    else
+    {
+        pu->Rx_RemainLen += len;
+    }
+
+    if( flush )
+    {
+        pu->Rx_FlushFlag = 0x01;
+    }
+    UART_DataRx_Up( port );
+}
+
+/*********************************************************************
+ * @fn      UART_DataRx_UpDone
+ *
+ * @brief   One upload of port x is done, queue more.
+ *
+ * @return  none
+ */
+void UART_DataRx_UpDone( uint8_t port )
+{
+    volatile UART_CTL *pu = &Uart[ port ];
+
+    if( pu->Rx_UpCnt )
+    {
+        Uart_Stat[ port ].Rx_Total += pu->Rx_UpPackLen[ pu->Rx_UpHead ];
+        pu->Rx_UpLen -= pu->Rx_UpPackLen[ pu->Rx_UpHead ];
+        pu->Rx_UpHead = ( pu->Rx_UpHead + 1 ) % DEF_USBD_TXQ_DEPTH;
+        pu->Rx_UpCnt--;
+    }
+    UART_DataRx_Up( port );
+}
+
+/*********************************************************************
+ * @fn      UART_Rx_DMA_IRQ
+ *
+ * @brief   Uartx receive DMA half and full transfer.
+ *
+ * @return  none
+ */
+void UART_Rx_DMA_IRQ( uint8_t port )
+{
+    const UART_PORT_CFG *pcfg = &Uart_Port[ port ];
+
+    if( ( DMA_GetITStatus( pcfg->Rx_DMA_HT ) != RESET ) || ( DMA_GetITStatus( pcfg->Rx_DMA_TC ) != RESET ) )
+    {
+        DMA_ClearITPendingBit( pcfg->Rx_DMA_HT | pcfg->Rx_DMA_TC );
+        UART_DataRx_Deal( port, 0 );
+    }
+}
+
+/*********************************************************************
+ * @fn      UART_USART_IRQ
+ *
+ * @brief   Uartx idle line.
+ *
+ * @return  none
+ */
+void UART_USART_IRQ( uint8_t port )
+{
+    USART_TypeDef *pusart = Uart_Port[ port ].USARTx;
+
+    if( USART_GetITStatus( pusart, USART_IT_IDLE ) != RESET )
+    {
+        /* Clear interrupt flag, read STATR then DATAR */
+        (void)pusart->STATR;
+        (void)pusart->DATAR;
+        UART_DataRx_Deal( port, 1 );
+    }
+}
+
+/*********************************************************************
+ * @fn      UART_USB_Init
+ *
+ * @brief   Uartx initialization in usb interrupt
+ *
+ * @return  none
+ */
+void UART_USB_Init( uint8_t port )
+{
+    volatile UART_CTL *pu = &Uart[ port ];
+    uint32_t baudrate;
+    uint8_t  stopbits;
+    uint8_t  parity;
+
+    baudrate = ( uint32_t )( pu->Com_Cfg[ 3 ] << 24 ) + ( uint32_t )( pu->Com_Cfg[ 2 ] << 16 );
+    baudrate += ( uint32_t )( pu->Com_Cfg[ 1 ] << 8 ) + ( uint32_t )( pu->Com_Cfg[ 0 ] );
+    stopbits = pu->Com_Cfg[ 4 ];
+    parity = pu->Com_Cfg[ 5 ];
+
+    UART_Init( port, 0, baudrate, stopbits, parity );
+
+    /* restart usb receive */
+    UART_DataTx_Release( port );
+}
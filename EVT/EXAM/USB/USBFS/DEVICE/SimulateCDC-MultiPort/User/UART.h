@@ -0,0 +1,131 @@
+/********************************** (C) COPYRIGHT *******************************
+* File Name          : UART.H
+* Author             : WCH
+* Version            : V1.0.0
+* Date               : 2026/10/19
+* Description        : UART communication-related headers, USART1-4
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef __UART_H__
+#define __UART_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdio.h"
+#include "string.h"
+#include "debug.h"
+#include <ch643_usbfs_device.h>
+#include "ch643_conf.h"
+
+/******************************************************************************/
+/* Related macro definitions */
+/* Number of serial ports, port 0-3 is USART1-4 */
+#define DEF_UART_PORT_NUM          4
+
+/* Serial buffer related definitions */
+#define DEF_UARTx_RX_BUF_LEN       ( 2 * 512 )                                  /* Serial x receive buffer size */
+#define DEF_UARTx_TX_BUF_LEN       ( 1 * 512 )                                  /* Serial x transmit buffer size */
+#define DEF_USB_FS_PACK_LEN        DEF_USBD_FS_PACK_SIZE                        /* USB full speed mode packet size for serial x data */
+#define DEF_UARTx_TX_BUF_NUM_MAX   ( DEF_UARTx_TX_BUF_LEN / DEF_USB_FS_PACK_LEN ) /* Serial x transmit buffer size */
+#define DEF_UARTx_UP_MAX_LEN       ( 4 * DEF_USB_FS_PACK_LEN )                  /* Longest single upload, keeps the ports interleaved */
+
+/* Serial port default parameters */
+#define DEF_UARTx_BAUDRATE         115200                                       /* Default baud rate for serial port */
+#define DEF_UARTx_STOPBIT          0                                            /* Default stop bit for serial port */
+#define DEF_UARTx_PARITY           0                                            /* Default parity bit for serial port */
+#define DEF_UARTx_DATABIT          8                                            /* Default data bit for serial port */
+
+/************************************************************/
+/* Serial port X related structure definition */
+/* Fixed resources of one port */
+typedef struct _UART_PORT_CFG
+{
+    USART_TypeDef       *USARTx;
+    DMA_Channel_TypeDef *Tx_DMA_CH;
+    DMA_Channel_TypeDef *Rx_DMA_CH;
+    uint32_t            Tx_DMA_TC;                                               /* DMA1_IT_TCx of Tx_DMA_CH */
+    uint32_t            Rx_DMA_HT;                                               /* DMA1_IT_HTx of Rx_DMA_CH */
+    uint32_t            Rx_DMA_TC;                                               /* DMA1_IT_TCx of Rx_DMA_CH */
+    IRQn_Type           USART_IRQ;
+    IRQn_Type           Tx_DMA_IRQ;
+    IRQn_Type           Rx_DMA_IRQ;
+    GPIO_TypeDef        *GPIOx;
+    uint16_t            Tx_Pin;
+    uint16_t            Rx_Pin;
+} UART_PORT_CFG;
+
+/* Receive: the DMA fills the receive buffer circularly, and the received data
+ * is queued on the port's bulk IN endpoint.
+ * Transmit: each bulk OUT packet is copied into a 64-byte slot of the send
+ * buffer, and the DMA sends runs of loaded slots.
+ * Everything runs in the USBFS, DMA1 and USART interrupts, which must have
+ * the same priority so they never preempt each other. */
+typedef struct __attribute__((packed)) _UART_CTL
+{
+    uint16_t Rx_DealPtr;                                                         /* Serial x data receive buffer, next byte to upload */
+    volatile uint16_t Rx_RemainLen;                                              /* Received length not yet queued for upload */
+    uint16_t Rx_UpLen;                                                           /* Queued length not yet uploaded */
+    uint16_t Rx_UpPackLen[ DEF_USBD_TXQ_DEPTH ];                                 /* Length of each queued upload */
+    uint8_t  Rx_UpHead;                                                          /* Oldest queued upload */
+    uint8_t  Rx_UpCnt;                                                           /* Number of queued uploads */
+    uint8_t  Rx_FlushFlag;                                                       /* Line idle, upload the partial packet as well */
+    uint8_t  Recv1;
+    uint16_t Rx_DMALastCount;                                                    /* last count of DMA received by serial x */
+
+    volatile uint16_t Tx_LoadNum;                                                /* Serial x data send buffer load number */
+    volatile uint16_t Tx_DealNum;                                                /* Serial x data send buffer processing number */
+    volatile uint16_t Tx_RemainNum;                                              /* Serial x data send buffer remaining unprocessed number */
+    volatile uint16_t Tx_PackLen[ DEF_UARTx_TX_BUF_NUM_MAX ];                    /* The current packet length of the serial x data send buffer */
+    uint8_t  Tx_Flag;                                                            /* Serial x data send status */
+    uint8_t  Tx_CurPackNum;                                                      /* Number of packets in the current DMA transfer */
+    uint16_t Tx_CurPackLen;                                                      /* Length of the current DMA transfer */
+
+    uint8_t  USB_Down_StopCnt;                                                   /* Usb packets held (endpoint NAK) until the send buffer has room */
+    uint8_t  USB_Down_Halves;                                                    /* Receive buffers of the OUT endpoint, 1 or 2 */
+    uint8_t  Com_Cfg[ 8 ];                                                       /* Serial x parameter configuration (default baud rate is 115200, 1 stop bit, no parity, 8 data bits) */
+}UART_CTL, *PUART_CTL;
+
+/* Per-port counters, read by the vendor request */
+typedef struct _UART_STAT
+{
+    uint32_t Rx_Total;                                                           /* Bytes uploaded to usb */
+    uint32_t Tx_Total;                                                           /* Bytes sent on the serial port */
+    uint32_t Rx_Overrun;                                                         /* Bytes lost because the receive buffer was full */
+} UART_STAT;
+
+/***********************************************************************************************************************/
+/* Constant, variable extents */
+/* The following are serial port transmit and receive related variables and buffers */
+extern const UART_PORT_CFG Uart_Port[ DEF_UART_PORT_NUM ];                        /* Serial port resources */
+extern volatile UART_CTL Uart[ DEF_UART_PORT_NUM ];                               /* Serial x control related structure */
+extern volatile UART_STAT Uart_Stat[ DEF_UART_PORT_NUM ];                         /* Serial x counters */
+extern __attribute__ ((aligned(4))) uint8_t UART_Tx_Buf[ DEF_UART_PORT_NUM ][ DEF_UARTx_TX_BUF_LEN ]; /* Serial x transmit buffer */
+extern __attribute__ ((aligned(4))) uint8_t UART_Rx_Buf[ DEF_UART_PORT_NUM ][ DEF_UARTx_RX_BUF_LEN ]; /* Serial x receive buffer */
+
+/***********************************************************************************************************************/
+/* Function extensibility */
+extern uint8_t RCC_Configuration( void );
+extern void UART_CfgInit( uint8_t port, uint32_t baudrate, uint8_t stopbits, uint8_t parity ); /* Serial port x hardware initialization */
+extern void UART_ParaInit( uint8_t port, uint8_t mode );                          /* Serial port parameter initialization */
+extern void UART_DMAInit( uint8_t port, uint8_t type, uint8_t *pbuf, uint32_t len ); /* Serial port x related DMA initialization */
+extern void UART_Init( uint8_t port, uint8_t mode, uint32_t baudrate, uint8_t stopbits, uint8_t parity ); /* Serial port x initialization */
+extern void UART_USB_Init( uint8_t port );                                        /* USB serial port initialization*/
+extern void UART_DataTx_Load( uint8_t port, uint8_t *pbuf, uint16_t len );     /* Usb packet received */
+extern void UART_DataRx_UpDone( uint8_t port );                                   /* Usb upload done */
+extern void UART_Tx_DMA_IRQ( uint8_t port );                                      /* Send DMA interrupt */
+extern void UART_Rx_DMA_IRQ( uint8_t port );                                      /* Receive DMA interrupt */
+extern void UART_USART_IRQ( uint8_t port );                                       /* Serial port interrupt (idle line) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/***********************************************************************************************************************/
@@ -0,0 +1,201 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : ch643_it.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2024/10/30
+ * Description        : Main Interrupt Service Routines.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for 
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#include "ch643_it.h"
+#include "UART.h"
+
+void NMI_Handler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+void HardFault_Handler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel1_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel2_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel3_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel4_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel5_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel6_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel7_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel8_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void USART1_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void USART2_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void USART3_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void USART4_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+
+/*********************************************************************
+ * @fn      NMI_Handler
+ *
+ * @brief   This function handles NMI exception.
+ *
+ * @return  none
+ */
+void NMI_Handler(void)
+{
+  while (1)
+  {
+  }
+}
+
+/*********************************************************************
+ * @fn      HardFault_Handler
+ *
+ * @brief   This function handles Hard Fault exception.
+ *
+ * @return  none
+ */
+void HardFault_Handler(void)
+{
+  NVIC_SystemReset();
+  while (1)
+  {
+  }
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel1_IRQHandler
+ *
+ * @brief   This function handles DMA1 channel 1 (USART4 transmit) exception.
+ *
+ * @return  none
+ */
+void DMA1_Channel1_IRQHandler( void )
+{
+    UART_Tx_DMA_IRQ( 3 );
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel2_IRQHandler
+ *
+ * @brief   This function handles DMA1 channel 2 (USART3 transmit) exception.
+ *
+ * @return  none
+ */
+void DMA1_Channel2_IRQHandler( void )
+{
+    UART_Tx_DMA_IRQ( 2 );
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel3_IRQHandler
+ *
+ * @brief   This function handles DMA1 channel 3 (USART3 receive) exception.
+ *
+ * @return  none
+ */
+void DMA1_Channel3_IRQHandler( void )
+{
+    UART_Rx_DMA_IRQ( 2 );
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel4_IRQHandler
+ *
+ * @brief   This function handles DMA1 channel 4 (USART1 transmit) exception.
+ *
+ * @return  none
+ */
+void DMA1_Channel4_IRQHandler( void )
+{
+    UART_Tx_DMA_IRQ( 0 );
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel5_IRQHandler
+ *
+ * @brief   This function handles DMA1 channel 5 (USART1 receive) exception.
+ *
+ * @return  none
+ */
+void DMA1_Channel5_IRQHandler( void )
+{
+    UART_Rx_DMA_IRQ( 0 );
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel6_IRQHandler
+ *
+ * @brief   This function handles DMA1 channel 6 (USART2 receive) exception.
+ *
+ * @return  none
+ */
+void DMA1_Channel6_IRQHandler( void )
+{
+    UART_Rx_DMA_IRQ( 1 );
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel7_IRQHandler
+ *
+ * @brief   This function handles DMA1 channel 7 (USART2 transmit) exception.
+ *
+ * @return  none
+ */
+void DMA1_Channel7_IRQHandler( void )
+{
+    UART_Tx_DMA_IRQ( 1 );
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel8_IRQHandler
+ *
+ * @brief   This function handles DMA1 channel 8 (USART4 receive) exception.
+ *
+ * @return  none
+ */
+void DMA1_Channel8_IRQHandler( void )
+{
+    UART_Rx_DMA_IRQ( 3 );
+}
+
+/*********************************************************************
+ * @fn      USART1_IRQHandler
+ *
+ * @brief   This function handles USART1 idle line exception.
+ *
+ * @return  none
+ */
+void USART1_IRQHandler( void )
+{
+    UART_USART_IRQ( 0 );
+}
+
+/*********************************************************************
+ * @fn      USART2_IRQHandler
+ *
+ * @brief   This function handles USART2 idle line exception.
+ *
+ * @return  none
+ */
+void USART2_IRQHandler( void )
+{
+    UART_USART_IRQ( 1 );
+}
+
+/*********************************************************************
+ * @fn      USART3_IRQHandler
+ *
+ * @brief   This function handles USART3 idle line exception.
+ *
+ * @return  none
+ */
+void USART3_IRQHandler( void )
+{
+    UART_USART_IRQ( 2 );
+}
+
+/*********************************************************************
+ * @fn      USART4_IRQHandler
+ *
+ * @brief   This function handles USART4 idle line exception.
+ *
+ * @return  none
+ */
+void USART4_IRQHandler( void )
+{
+    UART_USART_IRQ( 3 );
+}
@@ -0,0 +1,50 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : main.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Main program body.
+ *********************************************************************************
+ * Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+ * Attention: This software (modified or not) and binary are used for 
+ * microcontroller manufactured by Nanjing Qinheng Microelectronics.
+ *******************************************************************************/
+
+/*
+ *@Note
+ *Example routine to emulate a four-port USB-CDC Device (composite, one IAD per port),
+ *port 0-3 bridged to USART1(PB10/PB11), USART2(PA2/PA3), USART3(PB3/PB4), USART4(PB0/PB1),
+ *the pins and DMA channels of each port are listed in Uart_Port (UART.c);
+ *Port 0-2 use endpoint 5-7 for notifications, port 3 has no notification endpoint
+ *since the USBFS has 7 IN endpoints only;
+ *Vendor request 0x01 (device to host, device recipient) reads the Rx/Tx byte and
+ *Rx overrun counters of every port, vendor request 0x02 clears them;
+ *Please note: USART1 is used by port 0, so this example does not print debug messages.
+*/
+
+#include "usbd_cdc.h"
+#include "debug.h"
+
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Main program.
+ *
+ * @return  none
+ */
+int main(void)
+{
+    NVIC_PriorityGroupConfig(NVIC_PriorityGroup_1);
+    SystemCoreClockUpdate();
+    Delay_Init();
+    RCC_Configuration( );
+
+    /* Usb Init, the CDC class driver initializes USART1-4 */
+    USBFS_Class_Register( &CDC_Class_Drv );
+    USBFS_RCC_Init( );
+    USBFS_Device_Init( ENABLE , PWR_VDD_SupplyVoltage());
+    while(1)
+    {
+    }
+}
@@ -0,0 +1,168 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : usb_desc.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : usb device descriptor,configuration descriptor,
+ *                      string descriptors and other descriptors.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for 
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "usb_desc.h"
+
+/* Device Descriptor */
+const uint8_t  MyDevDescr[] =
+{
+    0x12,       // bLength
+    0x01,       // bDescriptorType (Device)
+    0x10, 0x01, // bcdUSB 1.10
+    0xEF,       // bDeviceClass (Miscellaneous)
+    0x02,       // bDeviceSubClass (Common Class)
+    0x01,       // bDeviceProtocol (Interface Association Descriptor)
+    DEF_USBD_UEP0_SIZE,   // bMaxPacketSize0 64
+    (uint8_t)DEF_USB_VID, (uint8_t)(DEF_USB_VID >> 8),  // idVendor  0x1A86
+    (uint8_t)DEF_USB_PID, (uint8_t)(DEF_USB_PID >> 8),  // idProduct 0xFE0C
+    DEF_IC_PRG_VER, 0x00, // bcdDevice 0.01
+    0x01,       // iManufacturer (String Index)
+    0x02,       // iProduct (String Index)
+    0x00,       // iSerialNumber (String Index)
+    0x01,       // bNumConfigurations 1
+};
+
+/* Configuration Descriptor */
+const uint8_t  MyCfgDescr[] =
+{
+    /* Configure descriptor */
+    0x09, 0x02, 0x0A, 0x01, 0x08, 0x01, 0x00, 0x80, 0x32,
+
+    /* IAD Descriptor (interface 0/1), port 0, USART1 */
+    0x08, 0x0B, 0x00, 0x02, 0x02, 0x02, 0x01, 0x00,
+
+    /* Interface 0 (CDC) descriptor */
+    0x09, 0x04, 0x00, 0x00, 0x01, 0x02, 0x02, 0x01, 0x00,
+
+    /* Functional Descriptors */
+    0x05, 0x24, 0x00, 0x10, 0x01,
+
+    /* Length/management descriptor (data class interface 1) */
+    0x05, 0x24, 0x01, 0x00, 0x01,
+    0x04, 0x24, 0x02, 0x02,
+    0x05, 0x24, 0x06, 0x00, 0x01,
+
+    /* Interrupt upload endpoint descriptor */
+    0x07, 0x05, 0x85, 0x03, (uint8_t)DEF_USBD_ENDP5_SIZE, (uint8_t)( DEF_USBD_ENDP5_SIZE >> 8 ), 0x01,
+
+    /* Interface 1 (data interface) descriptor */
+    0x09, 0x04, 0x01, 0x00, 0x02, 0x0A, 0x00, 0x00, 0x00,
+
+    /* Endpoint descriptor */
+    0x07, 0x05, 0x01, 0x02, (uint8_t)DEF_USBD_ENDP1_SIZE, (uint8_t)( DEF_USBD_ENDP1_SIZE >> 8 ), 0x00,
+
+    /* Endpoint descriptor */
+    0x07, 0x05, 0x81, 0x02, (uint8_t)DEF_USBD_ENDP1_SIZE, (uint8_t)( DEF_USBD_ENDP1_SIZE >> 8 ), 0x00,
+
+    /* IAD Descriptor (interface 2/3), port 1, USART2 */
+    0x08, 0x0B, 0x02, 0x02, 0x02, 0x02, 0x01, 0x00,
+
+    /* Interface 2 (CDC) descriptor */
+    0x09, 0x04, 0x02, 0x00, 0x01, 0x02, 0x02, 0x01, 0x00,
+
+    /* Functional Descriptors */
+    0x05, 0x24, 0x00, 0x10, 0x01,
+
+    /* Length/management descriptor (data class interface 3) */
+    0x05, 0x24, 0x01, 0x00, 0x03,
+    0x04, 0x24, 0x02, 0x02,
+    0x05, 0x24, 0x06, 0x02, 0x03,
+
+    /* Interrupt upload endpoint descriptor */
+    0x07, 0x05, 0x86, 0x03, (uint8_t)DEF_USBD_ENDP6_SIZE, (uint8_t)( DEF_USBD_ENDP6_SIZE >> 8 ), 0x01,
+
+    /* Interface 3 (data interface) descriptor */
+    0x09, 0x04, 0x03, 0x00, 0x02, 0x0A, 0x00, 0x00, 0x00,
+
+    /* Endpoint descriptor */
+    0x07, 0x05, 0x02, 0x02, (uint8_t)DEF_USBD_ENDP2_SIZE, (uint8_t)( DEF_USBD_ENDP2_SIZE >> 8 ), 0x00,
+
+    /* Endpoint descriptor */
+    0x07, 0x05, 0x82, 0x02, (uint8_t)DEF_USBD_ENDP2_SIZE, (uint8_t)( DEF_USBD_ENDP2_SIZE >> 8 ), 0x00,
+
+    /* IAD Descriptor (interface 4/5), port 2, USART3 */
+    0x08, 0x0B, 0x04, 0x02, 0x02, 0x02, 0x01, 0x00,
+
+    /* Interface 4 (CDC) descriptor */
+    0x09, 0x04, 0x04, 0x00, 0x01, 0x02, 0x02, 0x01, 0x00,
+
+    /* Functional Descriptors */
+    0x05, 0x24, 0x00, 0x10, 0x01,
+
+    /* Length/management descriptor (data class interface 5) */
+    0x05, 0x24, 0x01, 0x00, 0x05,
+    0x04, 0x24, 0x02, 0x02,
+    0x05, 0x24, 0x06, 0x04, 0x05,
+
+    /* Interrupt upload endpoint descriptor */
+    0x07, 0x05, 0x87, 0x03, (uint8_t)DEF_USBD_ENDP7_SIZE, (uint8_t)( DEF_USBD_ENDP7_SIZE >> 8 ), 0x01,
+
+    /* Interface 5 (data interface) descriptor */
+    0x09, 0x04, 0x05, 0x00, 0x02, 0x0A, 0x00, 0x00, 0x00,
+
+    /* Endpoint descriptor */
+    0x07, 0x05, 0x03, 0x02, (uint8_t)DEF_USBD_ENDP3_SIZE, (uint8_t)( DEF_USBD_ENDP3_SIZE >> 8 ), 0x00,
+
+    /* Endpoint descriptor */
+    0x07, 0x05, 0x83, 0x02, (uint8_t)DEF_USBD_ENDP3_SIZE, (uint8_t)( DEF_USBD_ENDP3_SIZE >> 8 ), 0x00,
+
+    /* IAD Descriptor (interface 6/7), port 3, USART4 */
+    0x08, 0x0B, 0x06, 0x02, 0x02, 0x02, 0x01, 0x00,
+
+    /* Interface 6 (CDC) descriptor */
+    0x09, 0x04, 0x06, 0x00, 0x00, 0x02, 0x02, 0x01, 0x00,
+
+    /* Functional Descriptors */
+    0x05, 0x24, 0x00, 0x10, 0x01,
+
+    /* Length/management descriptor (data class interface 7) */
+    0x05, 0x24, 0x01, 0x00, 0x07,
+    0x04, 0x24, 0x02, 0x02,
+    0x05, 0x24, 0x06, 0x06, 0x07,
+
+    /* Interface 7 (data interface) descriptor */
+    0x09, 0x04, 0x07, 0x00, 0x02, 0x0A, 0x00, 0x00, 0x00,
+
+    /* Endpoint descriptor */
+    0x07, 0x05, 0x04, 0x02, (uint8_t)DEF_USBD_ENDP4_SIZE, (uint8_t)( DEF_USBD_ENDP4_SIZE >> 8 ), 0x00,
+
+    /* Endpoint descriptor */
+    0x07, 0x05, 0x84, 0x02, (uint8_t)DEF_USBD_ENDP4_SIZE, (uint8_t)( DEF_USBD_ENDP4_SIZE >> 8 ), 0x00,
+};
+
+/* Language Descriptor */
+const uint8_t  MyLangDescr[] =
+{
+    0x04, 0x03, 0x09, 0x04
+};
+
+/* Manufacturer Descriptor */
+const uint8_t  MyManuInfo[] =
+{
+    0x0E, 0x03, 'w', 0, 'c', 0, 'h', 0, '.', 0, 'c', 0, 'n', 0
+};
+
+/* Product Information */
+const uint8_t  MyProdInfo[] =
+{
+    0x16, 0x03, 'U', 0x00, 'S', 0x00, 'B', 0x00, ' ', 0x00, 'S', 0x00, 'e', 0x00,
+                    'r', 0x00, 'i', 0x00, 'a', 0x00, 'l', 0x00
+};
+
+/* Serial Number Information */
+const uint8_t  MySerNumInfo[] =
+{
+    0x16, 0x03, '0', 0, '1', 0, '2', 0, '3', 0, '4', 0, '5', 0
+              , '6', 0, '7', 0, '8', 0, '9', 0
+};
+
@@ -0,0 +1,186 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : usbd_cdc.c
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: Four-port CDC-ACM class driver on the shared USBFS device
+ *              core, port x (0-3) bridged to USART x+1.
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "usbd_cdc.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+/* Counters snapshot for DEF_CDC_VREQ_GET_STAT */
+static UART_STAT CDC_Stat_Buf[ DEF_UART_PORT_NUM ];
+
+/*********************************************************************
+ * @fn      CDC_Init
+ *
+ * @brief   Open the CDC endpoints and reset the serial ports, called on
+ *          device init and bus reset.
+ *
+ * @return  none
+ */
+static void CDC_Init( void )
+{
+    uint8_t port;
+    uint8_t endp;
+
+    for( port = 0; port < DEF_UART_PORT_NUM; port++ )
+    {
+        UART_Init( port, 1, DEF_UARTx_BAUDRATE, DEF_UARTx_STOPBIT, DEF_UARTx_PARITY );
+
+        /* Endpoint 1-3 double-buffered, endpoint 4 has a single buffer */
+        endp = DEF_CDC_DATA_EP( port );
+        if( endp <= DEF_UEP3 )
+        {
+            USBFS_Endp_Open( endp, USBFSD_UEP_RX_EN | USBFSD_UEP_TX_EN | USBFSD_UEP_BUF_MOD, DEF_USBD_FS_PACK_SIZE );
+            Uart[ port ].USB_Down_Halves = 2;
+        }
+        else
+        {
+            USBFS_Endp_Open( endp, USBFSD_UEP_RX_EN | USBFSD_UEP_TX_EN, DEF_USBD_FS_PACK_SIZE );
+            Uart[ port ].USB_Down_Halves = 1;
+        }
+
+        endp = DEF_CDC_NOTIFY_EP( port );
+        if( endp )
+        {
+            USBFS_Endp_Open( endp, USBFSD_UEP_TX_EN, DEF_USBD_FS_PACK_SIZE );
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      CDC_Setup
+ *
+ * @brief   CDC class requests of each port and the statistics vendor
+ *          requests.
+ *
+ * @return  DEF_USBD_REQ_OK or DEF_USBD_REQ_ERR
+ */
+static uint8_t CDC_Setup( const uint8_t **ppbuf, uint16_t *plen )
+{
+    uint8_t port;
+
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_CLASS )
+    {
+        port = DEF_CDC_ITF_PORT( (uint8_t)USBFS_SetupReqIndex );
+        if( port >= DEF_UART_PORT_NUM )
+        {
+            return DEF_USBD_REQ_ERR;
+        }
+
+        /* Class requests */
+        switch( USBFS_SetupReqCode )
+        {
+            case CDC_GET_LINE_CODING:
+                *ppbuf = (const uint8_t *)&Uart[ port ].Com_Cfg[ 0 ];
+                *plen = 7;
+                break;
+
+            case CDC_SET_LINE_CODING:
+            case CDC_SET_LINE_CTLSTE:
+            case CDC_SEND_BREAK:
+                break;
+
+            default:
+                return DEF_USBD_REQ_ERR;
+        }
+        return DEF_USBD_REQ_OK;
+    }
+    else if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_VENDOR )
+    {
+        /* Manufacturer request */
+        switch( USBFS_SetupReqCode )
+        {
+            case DEF_CDC_VREQ_GET_STAT:
+                memcpy( CDC_Stat_Buf, (const void *)Uart_Stat, sizeof( CDC_Stat_Buf ) );
+                *ppbuf = (const uint8_t *)CDC_Stat_Buf;
+                *plen = sizeof( CDC_Stat_Buf );
+                break;
+
+            case DEF_CDC_VREQ_CLR_STAT:
+                memset( (void *)Uart_Stat, 0, sizeof( Uart_Stat ) );
+                break;
+
+            default:
+                return DEF_USBD_REQ_ERR;
+        }
+        return DEF_USBD_REQ_OK;
+    }
+    return DEF_USBD_REQ_ERR;
+}
+
+/*********************************************************************
+ * @fn      CDC_EP0_Out
+ *
+ * @brief   Control OUT data, the new line coding of one port.
+ *
+ * @return  none
+ */
+static void CDC_EP0_Out( uint8_t *pbuf, uint16_t len )
+{
+    uint8_t port;
+
+    port = DEF_CDC_ITF_PORT( (uint8_t)USBFS_SetupReqIndex );
+    if( ( USBFS_SetupReqCode == CDC_SET_LINE_CODING ) && ( len >= 7 ) && ( port < DEF_UART_PORT_NUM ) )
+    {
+        /* 4 bytes baud rate (LSB first), stop bits, parity, data bits */
+        memcpy( (uint8_t *)&Uart[ port ].Com_Cfg[ 0 ], pbuf, 7 );
+        UART_USB_Init( port );
+    }
+}
+
+/*********************************************************************
+ * @fn      CDC_Out
+ *
+ * @brief   OUT packet received on the bulk endpoint of one port.
+ *
+ * @return  none
+ */
+static void CDC_Out( uint8_t endp, uint8_t *pbuf, uint16_t len )
+{
+    if( ( endp >= DEF_CDC_DATA_EP( 0 ) ) && ( endp < DEF_CDC_DATA_EP( DEF_UART_PORT_NUM ) ) )
+    {
+        UART_DataTx_Load( endp - DEF_CDC_DATA_EP( 0 ), pbuf, len );
+    }
+    else
+    {
+        USBFS_Endp_RxDone( endp );
+    }
+}
+
+/*********************************************************************
+ * @fn      CDC_In
+ *
+ * @brief   IN transfer done on the bulk or notification endpoint.
+ *
+ * @return  none
+ */
+static void CDC_In( uint8_t endp )
+{
+    if( ( endp >= DEF_CDC_DATA_EP( 0 ) ) && ( endp < DEF_CDC_DATA_EP( DEF_UART_PORT_NUM ) ) )
+    {
+        UART_DataRx_UpDone( endp - DEF_CDC_DATA_EP( 0 ) );
+    }
+}
+
+/* Class driver */
+const USBFS_CLASS_DRV CDC_Class_Drv =
+{
+    0, 2 * DEF_UART_PORT_NUM,
+    ( 1 << DEF_UEP1 ) | ( 1 << DEF_UEP2 ) | ( 1 << DEF_UEP3 ) | ( 1 << DEF_UEP4 ) | ( 1 << DEF_UEP5 ) | ( 1 << DEF_UEP6 ) | ( 1 << DEF_UEP7 ),
+    CDC_Init,
+    CDC_Setup,
+    CDC_EP0_Out,
+    CDC_Out,
+    CDC_In,
+    NULL,
+    NULL,
+};
@@ -0,0 +1,37 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : usbd_cdc.h
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: header file of usbd_cdc.c
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef USER_USBD_CDC_H_
+#define USER_USBD_CDC_H_
+
+#include <ch643_usbfs_device.h>
+#include "UART.h"
+
+/******************************************************************************/
+/* Endpoints of port x (0-3): bulk OUT and IN on endpoint x+1, notification IN
+ * on endpoint 5/6/7. The USBFS has 7 IN endpoints only, so port 3 has no
+ * notification endpoint (optional in CDC 1.2). */
+#define DEF_CDC_DATA_EP( port )       ( ( port ) + 1 )
+#define DEF_CDC_NOTIFY_EP( port )     ( ( port ) < 3 ? ( ( port ) + 5 ) : 0 )
+
+/* Interfaces of port x: communication 2x, data 2x+1 */
+#define DEF_CDC_ITF_PORT( itf )       ( ( itf ) >> 1 )
+
+/* Vendor requests, device recipient */
+#define DEF_CDC_VREQ_GET_STAT         0x01 /* IN, UART_STAT of every port */
+#define DEF_CDC_VREQ_CLR_STAT         0x02 /* no data, clear the counters */
+
+/******************************************************************************/
+/* external variables */
+extern const USBFS_CLASS_DRV CDC_Class_Drv;
+
+#endif /* USER_USBD_CDC_H_ */
@@ -21,8 +21,10 @@ volatile UART_CTL Uart;
 
 __attribute__ ((aligned(4))) uint8_t  UART2_Tx_Buf[ DEF_UARTx_TX_BUF_LEN ];  /* Serial port 2 transmit data buffer */
 __attribute__ ((aligned(4))) uint8_t  UART2_Rx_Buf[ DEF_UARTx_RX_BUF_LEN ];  /* Serial port 2 receive data buffer */
-volatile uint32_t UARTx_Rx_DMACurCount;                       /* Serial port 1 receive dma current counter */
-volatile uint32_t UARTx_Rx_DMALastCount;                      /* Serial port 1 receive dma last value counter  */
+volatile uint32_t UARTx_Rx_DMALastCount;                      /* Serial port 2 receive dma last value counter  */
+volatile uint32_t UARTx_Rx_Total;                             /* Serial port 2 bytes uploaded to usb */
+volatile uint32_t UARTx_Tx_Total;                             /* Serial port 2 bytes sent */
+volatile uint32_t UARTx_Rx_Overrun;                           /* Serial port 2 receive bytes lost */
 
 /*********************************************************************
  * @fn      RCC_Configuration
@@ -35,45 +37,10 @@ uint8_t RCC_Configuration( void )
 {
     RCC_APB2PeriphClockCmd( RCC_APB2Periph_GPIOA, ENABLE );
     RCC_APB1PeriphClockCmd( RCC_APB1Periph_USART2, ENABLE );
-    RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM3, ENABLE );
     RCC_AHBPeriphClockCmd( RCC_AHBPeriph_DMA1, ENABLE );
     return 0;
 }
 
-/*********************************************************************
- * @fn      TIM3_Init
- *
- * @brief   100us Timer
- *          144 * 100 * 13.8888 -----> 100uS
- *
- * @return  none
- */
-void TIM3_Init( void )
-{
-    TIM_TimeBaseInitTypeDef  TIM_TimeBaseStructure = {0};
-
-    TIM_DeInit( TIM3 );
-
-    /* Time base configuration */
-    TIM_TimeBaseStructure.TIM_Period = 100 - 1;
-    TIM_TimeBaseStructure.TIM_Prescaler = SystemCoreClock / 1000000 - 1;
-    TIM_TimeBaseStructure.TIM_ClockDivision = 0;
-    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
-    TIM_TimeBaseInit( TIM3, &TIM_TimeBaseStructure );
-
-    /* Clear TIM3 update pending flag */
-    TIM_ClearFlag( TIM3, TIM_FLAG_Update );
-
-    /* TIM IT enable */
-    TIM_ITConfig( TIM3, TIM_IT_Update, ENABLE );
-
-    /* Enable Interrupt */
-    NVIC_EnableIRQ( TIM3_IRQn );
-
-    /* TIM3 enable counter */
-    TIM_Cmd( TIM3, ENABLE );
-}
-
 /*********************************************************************
  * @fn      UART2_CfgInit
  *
@@ -167,6 +134,9 @@ void UART2_CfgInit( uint32_t baudrate, uint8_t stopbits, uint8_t parity )
     USART_Init( USART2, &USART_InitStructure );
     USART_ClearFlag( USART2, USART_FLAG_TC );
 
+    /* The idle line interrupt flushes a partial packet to usb */
+    USART_ITConfig( USART2, USART_IT_IDLE, ENABLE );
+
     /* Enable USART2 */
     USART_Cmd( USART2, ENABLE );
 }
@@ -183,11 +153,9 @@ void UART2_ParaInit( uint8_t mode )
 {
     uint8_t i;
 
-    Uart.Rx_LoadPtr = 0x00;
     Uart.Rx_DealPtr = 0x00;
     Uart.Rx_RemainLen = 0x00;
-    Uart.Rx_TimeOut = 0x00;
-    Uart.Rx_TimeOutMax = 30;
+    Uart.Rx_FlushFlag = 0x00;
 
     Uart.Tx_LoadNum = 0x00;
     Uart.Tx_DealNum = 0x00;
@@ -197,18 +165,20 @@ void UART2_ParaInit( uint8_t mode )
         Uart.Tx_PackLen[ i ] = 0x00;
     }
     Uart.Tx_Flag = 0x00;
+    Uart.Tx_CurPackNum = 0x00;
     Uart.Tx_CurPackLen = 0x00;
-    Uart.Tx_CurPackPtr = 0x00;
 
-    Uart.USB_Up_IngFlag = 0x00;
-    Uart.USB_Up_TimeOut = 0x00;
-    Uart.USB_Up_Pack0_Flag = 0x00;
     Uart.USB_Down_StopFlag = 0x00;
-    UARTx_Rx_DMACurCount = 0x00;
-    UARTx_Rx_DMALastCount = 0x00;
+    UARTx_Rx_DMALastCount = DEF_UARTx_RX_BUF_LEN;
 
     if( mode )
     {
+        /* Endpoint 3 is flushed on bus reset, uploads still queued on a line
+           coding change complete through UART2_DataRx_UpDone */
+        Uart.Rx_UpLen = 0x00;
+        Uart.Rx_UpHead = 0x00;
+        Uart.Rx_UpCnt = 0x00;
+
         Uart.Com_Cfg[ 0 ] = (uint8_t)( DEF_UARTx_BAUDRATE );
         Uart.Com_Cfg[ 1 ] = (uint8_t)( DEF_UARTx_BAUDRATE >> 8 );
         Uart.Com_Cfg[ 2 ] = (uint8_t)( DEF_UARTx_BAUDRATE >> 16 );
@@ -216,7 +186,7 @@ void UART2_ParaInit( uint8_t mode )
         Uart.Com_Cfg[ 4 ] = DEF_UARTx_STOPBIT;
         Uart.Com_Cfg[ 5 ] = DEF_UARTx_PARITY;
         Uart.Com_Cfg[ 6 ] = DEF_UARTx_DATABIT;
-        Uart.Com_Cfg[ 7 ] = DEF_UARTx_RX_TIMEOUT;
+        Uart.Com_Cfg[ 7 ] = 0x00;
     }
 }
 
@@ -252,8 +222,7 @@ void UART2_DMAInit( uint8_t type, uint8_t *pbuf, uint32_t len )
         DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
         DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
         DMA_Init( DMA1_Channel7, &DMA_InitStructure );
-
-        DMA_Cmd( DMA1_Channel7, ENABLE );
+        DMA_ITConfig( DMA1_Channel7, DMA_IT_TC, ENABLE );
     }
     else
     {
@@ -271,6 +240,7 @@ void UART2_DMAInit( uint8_t type, uint8_t *pbuf, uint32_t len )
         DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
         DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
         DMA_Init( DMA1_Channel6, &DMA_InitStructure );
+        DMA_ITConfig( DMA1_Channel6, DMA_IT_HT | DMA_IT_TC, ENABLE );
 
         DMA_Cmd( DMA1_Channel6, ENABLE );
     }
@@ -289,23 +259,28 @@ void UART2_DMAInit( uint8_t type, uint8_t *pbuf, uint32_t len )
  */
 void UART2_Init( uint8_t mode, uint32_t baudrate, uint8_t stopbits, uint8_t parity )
 {
-    USART_DMACmd( USART2, USART_DMAReq_Rx, DISABLE );
+    USART_DMACmd( USART2, USART_DMAReq_Rx | USART_DMAReq_Tx, DISABLE );
     DMA_Cmd( DMA1_Channel6, DISABLE );
     DMA_Cmd( DMA1_Channel7, DISABLE );
 
     UART2_CfgInit( baudrate, stopbits, parity );
     UART2_DMAInit( 0, &UART2_Tx_Buf[ 0 ], 0 );
     UART2_DMAInit( 1, &UART2_Rx_Buf[ 0 ], DEF_UARTx_RX_BUF_LEN );
+    UART2_ParaInit( mode );
 
-    USART_DMACmd( USART2, USART_DMAReq_Rx, ENABLE );
+    USART_DMACmd( USART2, USART_DMAReq_Rx | USART_DMAReq_Tx, ENABLE );
 
-    UART2_ParaInit( mode );
+    /* Same priority as USBFS, see UART_CTL */
+    NVIC_EnableIRQ( DMA1_Channel6_IRQn );
+    NVIC_EnableIRQ( DMA1_Channel7_IRQn );
+    NVIC_EnableIRQ( USART2_IRQn );
 }
 
 /*********************************************************************
  * @fn      UART2_USB_Init
  *
- * @brief   Uart2 initialization in usb interrupt
+ * @brief   Uart2 initialization with the line coding set by the host,
+ *          called from CDC_Uart_Deal
  *
  * @return  none
  */
@@ -314,218 +289,256 @@ void UART2_USB_Init( void )
     uint32_t baudrate;
     uint8_t  stopbits;
     uint8_t  parity;
+    uint8_t  stop;
 
     baudrate = ( uint32_t )( Uart.Com_Cfg[ 3 ] << 24 ) + ( uint32_t )( Uart.Com_Cfg[ 2 ] << 16 );
     baudrate += ( uint32_t )( Uart.Com_Cfg[ 1 ] << 8 ) + ( uint32_t )( Uart.Com_Cfg[ 0 ] );
     stopbits = Uart.Com_Cfg[ 4 ];
     parity = Uart.Com_Cfg[ 5 ];
+    stop = Uart.USB_Down_StopFlag;
 
     UART2_Init( 0, baudrate, stopbits, parity );
 
     /* restart usb receive  */
-    USBFSD->UEP2_DMA = (uint32_t)(uint8_t *)&UART2_Tx_Buf[ 0 ];
-    USBFSD->UEP2_CTRL_H &= ~USBFS_UEP_R_RES_MASK;
-    USBFSD->UEP2_CTRL_H |= USBFS_UEP_R_RES_ACK;
+    USBFS_Endp_RxBuf_Set( DEF_UEP2, &UART2_Tx_Buf[ 0 ] );
+    if( stop )
+    {
+        USBFS_Endp_RxDone( DEF_UEP2 );
+    }
 }
 
 /*********************************************************************
- * @fn      UART2_DataTx_Deal
+ * @fn      UART2_DataTx_Start
  *
- * @brief   Uart2 data transmission processing
+ * @brief   Start the send DMA on the oldest loaded packets. Full packets
+ *          that follow each other in the buffer go out in one transfer.
  *
  * @return  none
  */
-void UART2_DataTx_Deal( void )
+static void UART2_DataTx_Start( void )
 {
-    uint16_t  count;
+    uint16_t num;
+    uint16_t len;
 
-    /* uart1 transmission processing */
-    if( Uart.Tx_Flag )
+    if( Uart.Tx_Flag || ( Uart.Tx_RemainNum == 0 ) )
     {
-        /* Query whether the DMA transmission of the serial port is completed */
-        if( USART2->STATR & USART_FLAG_TC )
-        {
-            USART2->STATR = (uint16_t)( ~USART_FLAG_TC );
-            USART2->CTLR3 &= ( ~USART_DMAReq_Tx );
+        return;
+    }
 
-            Uart.Tx_Flag = 0x00;
+    num = 0;
+    len = 0;
+    do
+    {
+        len += Uart.Tx_PackLen[ Uart.Tx_DealNum + num ];
+        num++;
+    } while( ( num < Uart.Tx_RemainNum ) && ( ( Uart.Tx_DealNum + num ) < DEF_UARTx_TX_BUF_NUM_MAX ) &&
+             ( Uart.Tx_PackLen[ Uart.Tx_DealNum + num - 1 ] == DEF_USB_FS_PACK_LEN ) );
+    Uart.Tx_CurPackNum = num;
+    Uart.Tx_CurPackLen = len;
+
+    /* Configure DMA and send */
+    DMA_Cmd( DEF_UART2_TX_DMA_CH, DISABLE );
+    DEF_UART2_TX_DMA_CH->MADDR = (uint32_t)&UART2_Tx_Buf[ Uart.Tx_DealNum * DEF_USB_FS_PACK_LEN ];
+    DEF_UART2_TX_DMA_CH->CNTR = len;
+    DMA_Cmd( DEF_UART2_TX_DMA_CH, ENABLE );
+    Uart.Tx_Flag = 0x01;
+}
 
-            NVIC_DisableIRQ( USBFS_IRQn );
-            NVIC_DisableIRQ( USBFS_IRQn );
+/*********************************************************************
+ * @fn      UART2_DataTx_Load
+ *
+ * @brief   A usb packet has been received into the slot at Tx_LoadNum.
+ *          Point endpoint 2 at the next slot and start sending.
+ *
+ * @return  0 - next slot free, keep receiving
+ *          1 - send buffer full, endpoint 2 stays NAK
+ */
+uint8_t UART2_DataTx_Load( uint16_t len )
+{
+    Uart.Tx_PackLen[ Uart.Tx_LoadNum ] = len;
+    Uart.Tx_LoadNum++;
+    if( Uart.Tx_LoadNum >= DEF_UARTx_TX_BUF_NUM_MAX )
+    {
+        Uart.Tx_LoadNum = 0x00;
+    }
+    USBFS_Endp_RxBuf_Set( DEF_UEP2, &UART2_Tx_Buf[ Uart.Tx_LoadNum * DEF_USB_FS_PACK_LEN ] );
+    Uart.Tx_RemainNum++;
 
-            /* Calculate the variables of last data */
-            count = Uart.Tx_CurPackLen - DEF_UART2_TX_DMA_CH->CNTR;
-            Uart.Tx_CurPackLen -= count;
-            Uart.Tx_CurPackPtr += count;
-            if( Uart.Tx_CurPackLen == 0x00 )
-            {
-                Uart.Tx_PackLen[ Uart.Tx_DealNum ] = 0x0000;
-                Uart.Tx_DealNum++;
-                if( Uart.Tx_DealNum >= DEF_UARTx_TX_BUF_NUM_MAX )
-                {
-                    Uart.Tx_DealNum = 0x00;
-                }
-                Uart.Tx_RemainNum--;
-            }
+    UART2_DataTx_Start( );
 
-            /* If the current serial port has suspended the downlink, restart the driver downlink */
-            if( ( Uart.USB_Down_StopFlag == 0x01 ) && ( Uart.Tx_RemainNum < 2 ) )
-            {
-                USBFSD->UEP2_CTRL_H &= ~USBFS_UEP_R_RES_MASK;
-                USBFSD->UEP2_CTRL_H |= USBFS_UEP_R_RES_ACK;
-                Uart.USB_Down_StopFlag = 0x00;
-            }
+    if( Uart.Tx_RemainNum >= DEF_UARTx_TX_BUF_NUM_MAX )
+    {
+        Uart.USB_Down_StopFlag = 0x01;
+        return 1;
+    }
+    return 0;
+}
 
-            NVIC_EnableIRQ( USBFS_IRQn );
-        }
+/*********************************************************************
+ * @fn      UART2_DataTx_Deal
+ *
+ * @brief   Uart2 send DMA done, called in the DMA1 channel 7 interrupt.
+ *          Frees the sent packets and restarts usb receive if it was
+ *          stopped.
+ *
+ * @return  none
+ */
+void UART2_DataTx_Deal( void )
+{
+    uint8_t i;
+
+    if( Uart.Tx_Flag == 0 )
+    {
+        return;
     }
-    else
+    Uart.Tx_Flag = 0x00;
+
+    for( i = 0; i < Uart.Tx_CurPackNum; i++ )
     {
-        /* Load data from the serial port send buffer to send  */
-        if( Uart.Tx_RemainNum )
+        Uart.Tx_PackLen[ Uart.Tx_DealNum ] = 0x0000;
+        Uart.Tx_DealNum++;
+        if( Uart.Tx_DealNum >= DEF_UARTx_TX_BUF_NUM_MAX )
         {
-            /* Determine whether to load from the last unsent buffer or from a new buffer */
-            if( Uart.Tx_CurPackLen == 0x00 )
-            {
-                Uart.Tx_CurPackLen = Uart.Tx_PackLen[ Uart.Tx_DealNum ];
-                Uart.Tx_CurPackPtr = ( Uart.Tx_DealNum * DEF_USB_FS_PACK_LEN );
-            }
-            /* Configure DMA and send */
-            USART_ClearFlag( USART2, USART_FLAG_TC );
-            DMA_Cmd( DEF_UART2_TX_DMA_CH, DISABLE );
-            DEF_UART2_TX_DMA_CH->MADDR = (uint32_t)&UART2_Tx_Buf[ Uart.Tx_CurPackPtr ];
-            DEF_UART2_TX_DMA_CH->CNTR = Uart.Tx_CurPackLen;
-            DMA_Cmd( DEF_UART2_TX_DMA_CH, ENABLE );
-            USART2->CTLR3 |= USART_DMAReq_Tx;
-            Uart.Tx_Flag = 0x01;
+            Uart.Tx_DealNum = 0x00;
         }
     }
+    Uart.Tx_RemainNum -= Uart.Tx_CurPackNum;
+    UARTx_Tx_Total += Uart.Tx_CurPackLen;
+
+    /* If the current serial port has suspended the downlink, restart the driver downlink */
+    if( Uart.USB_Down_StopFlag )
+    {
+        Uart.USB_Down_StopFlag = 0x00;
+        USBFS_Endp_RxDone( DEF_UEP2 );
+    }
+
+    UART2_DataTx_Start( );
 }
 
 /*********************************************************************
- * @fn      UART2_DataRx_Deal
+ * @fn      UART2_DataRx_Up
  *
- * @brief   Uart2 data receiving processing
+ * @brief   Queue received data for upload on endpoint 3. Only whole
+ *          packets are queued until the line goes idle. The data is sent
+ *          straight from the receive buffer where it is word aligned.
  *
  * @return  none
  */
-void UART2_DataRx_Deal( void )
+static void UART2_DataRx_Up( void )
 {
-    uint16_t temp16;
-    uint32_t remain_len;
-    uint16_t packlen;
-
-    /* Serial port 1 data DMA receive processing */
-    NVIC_DisableIRQ( USBFS_IRQn );
-    NVIC_DisableIRQ( USBFS_IRQn );
-    UARTx_Rx_DMACurCount = DEF_UART2_RX_DMA_CH->CNTR;
-    if( UARTx_Rx_DMALastCount != UARTx_Rx_DMACurCount )
+    uint16_t len;
+    uint8_t  flag;
 
+    while( Uart.Rx_RemainLen && ( Uart.Rx_UpCnt < DEF_USBD_TXQ_DEPTH ) )
     {
-        if( UARTx_Rx_DMALastCount > UARTx_Rx_DMACurCount )
+        len = Uart.Rx_RemainLen;
+        if( len >= ( DEF_UARTx_RX_BUF_LEN - Uart.Rx_DealPtr ) )
         {
-            temp16 = UARTx_Rx_DMALastCount - UARTx_Rx_DMACurCount;
+            /* Stop at the end of the buffer */
+            len = DEF_UARTx_RX_BUF_LEN - Uart.Rx_DealPtr;
         }
-        else
+        else if( Uart.Rx_FlushFlag == 0 )
         {
-            temp16 = DEF_UARTx_RX_BUF_LEN - UARTx_Rx_DMACurCount;
-            temp16 += UARTx_Rx_DMALastCount;
+            len -= len % DEF_USB_FS_PACK_LEN;
+            if( len == 0 )
+            {
+                break;
+            }
         }
-        UARTx_Rx_DMALastCount = UARTx_Rx_DMACurCount;
-        if( ( Uart.Rx_RemainLen + temp16 ) > DEF_UARTx_RX_BUF_LEN )
+
+        flag = 0;
+        if( ( (uint32_t)&UART2_Rx_Buf[ Uart.Rx_DealPtr ] & 0x03 ) == 0 )
         {
-            /* Overflow handling */
-            /* Save frame error status */
-            printf("U0_O:%08lx\n",(uint32_t)Uart.Rx_RemainLen);
+            flag |= DEF_UEP_TX_DMA;
         }
-        else
+        if( Uart.Rx_FlushFlag && ( len == Uart.Rx_RemainLen ) )
         {
-            Uart.Rx_RemainLen += temp16;
+            /* Required for CDC mode, end the transfer */
+            flag |= DEF_UEP_TX_ZLP;
+        }
+        if( USBFS_Endp_Transmit( DEF_UEP3, &UART2_Rx_Buf[ Uart.Rx_DealPtr ], len, flag ) )
+        {
+            break;
         }
 
-        /* Setting reception status */
-        Uart.Rx_TimeOut = 0x00;
+        Uart.Rx_UpPackLen[ ( Uart.Rx_UpHead + Uart.Rx_UpCnt ) % DEF_USBD_TXQ_DEPTH ] = len;
+        Uart.Rx_UpCnt++;
+        Uart.Rx_UpLen += len;
+        Uart.Rx_RemainLen -= len;
+        Uart.Rx_DealPtr += len;
+        if( Uart.Rx_DealPtr >= DEF_UARTx_RX_BUF_LEN )
+        {
+            Uart.Rx_DealPtr = 0x00;
+        }
     }
-    NVIC_EnableIRQ( USBFS_IRQn );
 
-    /*****************************************************************/
-    /* Serial port 1 data processing via USB upload and reception */
-    if( Uart.Rx_RemainLen )
+    if( Uart.Rx_RemainLen == 0 )
     {
-        if( Uart.USB_Up_IngFlag == 0 )
-        {
-            /* Calculate the length of this upload */
-            remain_len = Uart.Rx_RemainLen;
-            packlen = 0x00;
-            if( remain_len >= DEF_USBD_FS_PACK_SIZE )
-            {
-                packlen = DEF_USBD_FS_PACK_SIZE;
-            }
-            else
-            {
-                if( Uart.Rx_TimeOut >= Uart.Rx_TimeOutMax )
-                {
-                    packlen = remain_len;
-                }
-            }
-            if( packlen > ( DEF_UARTx_RX_BUF_LEN - Uart.Rx_DealPtr ) )
-            {
-                packlen = ( DEF_UARTx_RX_BUF_LEN - Uart.Rx_DealPtr );
-            }
+        Uart.Rx_FlushFlag = 0x00;
+    }
+}
 
-            /* Upload serial data via usb */
-            if( packlen )
-            {
-                NVIC_DisableIRQ( USBFS_IRQn );
-                NVIC_DisableIRQ( USBFS_IRQn );
-                Uart.USB_Up_IngFlag = 0x01;
-                Uart.USB_Up_TimeOut = 0x00;
-                USBFS_Endp_DataUp( DEF_UEP3, &UART2_Rx_Buf[ Uart.Rx_DealPtr ], packlen, DEF_UEP_CPY_LOAD );
-                /* Calculate the variables of interest */
-                Uart.Rx_RemainLen -= packlen;
-                Uart.Rx_DealPtr += packlen;
-                if( Uart.Rx_DealPtr >= DEF_UARTx_RX_BUF_LEN )
-                {
-                    Uart.Rx_DealPtr = 0x00;
-                }
-
-                /* Start 0-length packet timeout timer */
-                if( packlen == DEF_USBD_FS_PACK_SIZE )
-                {
-                    Uart.USB_Up_Pack0_Flag = 0x01;
-                }
-
-                NVIC_EnableIRQ( USBFS_IRQn );
-            }
-        }
-        else
-        {
-            /* Set the upload success flag directly if the upload is not successful after the timeout */
-            if( Uart.USB_Up_TimeOut >= DEF_UARTx_USB_UP_TIMEOUT )
-            {
-                Uart.USB_Up_IngFlag = 0x00;
-                USBFS_Endp_Busy[ DEF_UEP3 ] = 0;
-            }
-        }
+/*********************************************************************
+ * @fn      UART2_DataRx_Deal
+ *
+ * @brief   Uart2 data receiving processing, called in the DMA1 channel 6
+ *          half/complete interrupt and the USART2 idle interrupt.
+ *
+ * @param   flush - line idle, upload the partial packet as well
+ *
+ * @return  none
+ */
+void UART2_DataRx_Deal( uint8_t flush )
+{
+    uint32_t count;
+    uint16_t len;
+
+    count = DEF_UART2_RX_DMA_CH->CNTR;
+    if( UARTx_Rx_DMALastCount >= count )
+    {
+        len = UARTx_Rx_DMALastCount - count;
     }
+    else
+    {
+        len = UARTx_Rx_DMALastCount + DEF_UARTx_RX_BUF_LEN - count;
+    }
+    UARTx_Rx_DMALastCount = count;
 
-    /*****************************************************************/
-    /* Determine if a 0-length packet needs to be uploaded (required for CDC mode) */
-    if( Uart.USB_Up_Pack0_Flag )
+    if( ( Uart.Rx_RemainLen + Uart.Rx_UpLen + len ) > DEF_UARTx_RX_BUF_LEN )
     {
-        if( Uart.USB_Up_IngFlag == 0 )
-        {
-            if( Uart.USB_Up_TimeOut >= ( DEF_UARTx_RX_TIMEOUT * 20 ) )
-            {
-                NVIC_DisableIRQ( USBFS_IRQn );
-                NVIC_DisableIRQ( USBFS_IRQn );
-                Uart.USB_Up_IngFlag = 0x01;
-                Uart.USB_Up_TimeOut = 0x00;
-                USBFS_Endp_DataUp( DEF_UEP3, &UART2_Rx_Buf[ Uart.Rx_DealPtr ], 0, DEF_UEP_CPY_LOAD );
-                Uart.USB_Up_IngFlag = 0;
-                Uart.USB_Up_Pack0_Flag = 0x00;
-                NVIC_EnableIRQ( USBFS_IRQn );
-            }
-        }
+        /* Overflow handling, the oldest data has been overwritten.
+           Drop everything not yet queued and carry on from the DMA position */
+        UARTx_Rx_Overrun += Uart.Rx_RemainLen + len;
+        Uart.Rx_RemainLen = 0x00;
+        Uart.Rx_DealPtr = ( DEF_UARTx_RX_BUF_LEN - count ) % DEF_UARTx_RX_BUF_LEN;
+    }
+    else
+    {
+        Uart.Rx_RemainLen += len;
+    }
+
+    if( flush )
+    {
+        Uart.Rx_FlushFlag = 0x01;
+    }
+    UART2_DataRx_Up( );
+}
+
+/*********************************************************************
+ * @fn      UART2_DataRx_UpDone
+ *
+ * @brief   One upload on endpoint 3 is done, queue more.
+ *
+ * @return  none
+ */
+void UART2_DataRx_UpDone( void )
+{
+    if( Uart.Rx_UpCnt )
+    {
+        UARTx_Rx_Total += Uart.Rx_UpPackLen[ Uart.Rx_UpHead ];
+        Uart.Rx_UpLen -= Uart.Rx_UpPackLen[ Uart.Rx_UpHead ];
+        Uart.Rx_UpHead = ( Uart.Rx_UpHead + 1 ) % DEF_USBD_TXQ_DEPTH;
+        Uart.Rx_UpCnt--;
     }
+    UART2_DataRx_Up( );
 }
@@ -32,69 +32,73 @@ extern "C" {
 #define DEF_USB_FS_PACK_LEN        DEF_USBD_FS_PACK_SIZE                        /* USB full speed mode packet size for serial x data */
 #define DEF_UARTx_TX_BUF_NUM_MAX   ( DEF_UARTx_TX_BUF_LEN / DEF_USB_FS_PACK_LEN ) /* Serial x transmit buffer size */
 
-/* Serial port receive timeout related macro definition */
+/* Serial port default parameters */
 #define DEF_UARTx_BAUDRATE         115200                                       /* Default baud rate for serial port */
 #define DEF_UARTx_STOPBIT          0                                            /* Default stop bit for serial port */
 #define DEF_UARTx_PARITY           0                                            /* Default parity bit for serial port */
 #define DEF_UARTx_DATABIT          8                                            /* Default data bit for serial port */
-#define DEF_UARTx_RX_TIMEOUT       30                                           /* Serial port receive timeout, in 100uS */
-#define DEF_UARTx_USB_UP_TIMEOUT   60000                                        /* Serial port receive upload timeout, in 100uS */
 
 /* Serial port transceiver DMA channel related macro definition */
 #define DEF_UART2_TX_DMA_CH        DMA1_Channel7                                /* Serial 2 transmit channel DMA channel */
-#define DEF_UART2_RX_DMA_CH        DMA1_Channel6                                /* Serial 1 transmit channel DMA channel */
+#define DEF_UART2_RX_DMA_CH        DMA1_Channel6                                /* Serial 2 receive channel DMA channel */
 
 /************************************************************/
 /* Serial port X related structure definition */
+/* Receive: the DMA fills UART2_Rx_Buf circularly, and the received data is
+ * sent on endpoint 3 straight from that buffer.
+ * Transmit: endpoint 2 receives each packet straight into a 64-byte slot of
+ * UART2_Tx_Buf, and the DMA sends runs of loaded slots.
+ * Everything runs in the USBFS, DMA1 channel 6/7 and USART2 interrupts,
+ * which must have the same priority so they never preempt each other.
+ * Only the re-initialization on bus reset and line coding changes is left
+ * to the main loop, with those interrupts off (CDC_Uart_Deal). */
 typedef struct __attribute__((packed)) _UART_CTL
 {
-    uint16_t Rx_LoadPtr;                                                         /* Serial x data receive buffer load pointer */
-    uint16_t Rx_DealPtr;                                                         /* Pointer to serial x data receive buffer processing */
-    volatile uint16_t Rx_RemainLen;                                              /* Remaining unprocessed length of the serial x data receive buffer */
-    uint8_t  Rx_TimeOut;                                                         /* Serial x data receive timeout */
-    uint8_t  Rx_TimeOutMax;                                                      /* Serial x data receive timeout maximum */
+    uint16_t Rx_DealPtr;                                                         /* Serial x data receive buffer, next byte to upload */
+    volatile uint16_t Rx_RemainLen;                                              /* Received length not yet queued for upload */
+    uint16_t Rx_UpLen;                                                           /* Queued length not yet uploaded */
+    uint16_t Rx_UpPackLen[ DEF_USBD_TXQ_DEPTH ];                                 /* Length of each queued upload */
+    uint8_t  Rx_UpHead;                                                          /* Oldest queued upload */
+    uint8_t  Rx_UpCnt;                                                           /* Number of queued uploads */
+    uint8_t  Rx_FlushFlag;                                                       /* Line idle, upload the partial packet as well */
+    uint8_t  Recv1;
 
     volatile uint16_t Tx_LoadNum;                                                /* Serial x data send buffer load number */
     volatile uint16_t Tx_DealNum;                                                /* Serial x data send buffer processing number */
     volatile uint16_t Tx_RemainNum;                                              /* Serial x data send buffer remaining unprocessed number */
     volatile uint16_t Tx_PackLen[ DEF_UARTx_TX_BUF_NUM_MAX ];                    /* The current packet length of the serial x data send buffer */
     uint8_t  Tx_Flag;                                                            /* Serial x data send status */
-    uint8_t  Recv1;
-    uint16_t Tx_CurPackLen;                                                      /* The current packet length sent by serial port x */
-    uint16_t Tx_CurPackPtr;                                                      /* Pointer to the packet currently being sent by serial port x */
+    uint8_t  Tx_CurPackNum;                                                      /* Number of packets in the current DMA transfer */
+    uint16_t Tx_CurPackLen;                                                      /* Length of the current DMA transfer */
 
-    uint8_t  USB_Up_IngFlag;                                                     /* Serial xUSB packet being uploaded flag */
-    uint8_t  Recv2;
-    uint16_t USB_Up_TimeOut;                                                     /* Serial xUSB packet upload timeout timer */
-    uint8_t  USB_Up_Pack0_Flag;                                                  /* Serial xUSB data needs to upload 0-length packet flag */
     uint8_t  USB_Down_StopFlag;                                                  /* Serial xUSB packet stop down flag */
-
+    uint8_t  Recv2;
     uint8_t  Com_Cfg[ 8 ];                                                       /* Serial x parameter configuration (default baud rate is 115200, 1 stop bit, no parity, 8 data bits) */
-    uint8_t  Recv3;
-    uint8_t  USB_Int_UpFlag;                                                     /* Serial x interrupt upload status */
-    uint16_t USB_Int_UpTimeCount;                                                /* Serial x interrupt upload timing */
 }UART_CTL, *PUART_CTL;
 
 /***********************************************************************************************************************/
 /* Constant, variable extents */
 /* The following are serial port transmit and receive related variables and buffers */
 extern volatile UART_CTL Uart;                                                    /* Serial x control related structure */
-extern volatile uint32_t UARTx_Rx_DMACurCount;                                    /* Serial x receive DMA current count */
 extern volatile uint32_t UARTx_Rx_DMALastCount;                                   /* last count of DMA received by serial x */
+extern volatile uint32_t UARTx_Rx_Total;                                          /* Bytes uploaded to usb */
+extern volatile uint32_t UARTx_Tx_Total;                                          /* Bytes sent on the serial port */
+extern volatile uint32_t UARTx_Rx_Overrun;                                        /* Bytes lost because the receive buffer was full */
 extern __attribute__ ((aligned(4))) uint8_t UART2_Tx_Buf[ DEF_UARTx_TX_BUF_LEN ]; /* Serial x transmit buffer */
-extern __attribute__ ((aligned(4))) uint8_t UART2_Rx_Buf[ DEF_UARTx_RX_BUF_LEN ]; /* Serial x transmit buffer */
+extern __attribute__ ((aligned(4))) uint8_t UART2_Rx_Buf[ DEF_UARTx_RX_BUF_LEN ]; /* Serial x receive buffer */
 
 /***********************************************************************************************************************/
 /* Function extensibility */
 extern uint8_t RCC_Configuration( void );
-extern void TIM3_Init( void );
-extern void UART2_CfgInit( uint32_t baudrate, uint8_t stopbits, uint8_t parity ); /* UART1 initialization */
+extern void UART2_CfgInit( uint32_t baudrate, uint8_t stopbits, uint8_t parity ); /* UART2 initialization */
 extern void UART2_ParaInit( uint8_t mode );                                       /* Serial port parameter initialization */
-extern void UART2_DMAInit( uint8_t type, uint8_t *pbuf, uint32_t len );           /* Serial port 1-related DMA initialization */
-extern void UART2_Init( uint8_t mode, uint32_t baudrate, uint8_t stopbits, uint8_t parity ); /* Serial port 1 initialization */
-extern void UART2_DataTx_Deal( void );                                            /* Serial port 1 data sending processing  */
-extern void UART2_DataRx_Deal( void );                                            /* Serial port 1 data reception processing */
+extern void UART2_DMAInit( uint8_t type, uint8_t *pbuf, uint32_t len );           /* Serial port 2-related DMA initialization */
+extern void UART2_Init( uint8_t mode, uint32_t baudrate, uint8_t stopbits, uint8_t parity ); /* Serial port 2 initialization */
 extern void UART2_USB_Init( void );                                               /* USB serial port initialization*/
+extern uint8_t UART2_DataTx_Load( uint16_t len );                                 /* Usb packet received into the send buffer */
+extern void UART2_DataTx_Deal( void );                                            /* Serial port 2 DMA send done */
+extern void UART2_DataRx_Deal( uint8_t flush );                                   /* Serial port 2 DMA receive progress */
+extern void UART2_DataRx_UpDone( void );                                          /* Usb upload done */
 
 #ifdef __cplusplus
 }
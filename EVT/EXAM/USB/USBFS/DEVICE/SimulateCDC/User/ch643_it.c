@@ -14,7 +14,9 @@
 
 void NMI_Handler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
 void HardFault_Handler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
-void TIM3_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel6_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel7_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
+void USART2_IRQHandler( void )__attribute__((interrupt("WCH-Interrupt-fast")));
 
 /*********************************************************************
  * @fn      NMI_Handler
@@ -46,23 +48,58 @@ void HardFault_Handler(void)
 }
 
 /*********************************************************************
- * @fn      TIM3_IRQHandler
+ * @fn      DMA1_Channel6_IRQHandler
  *
- * @brief   This function handles TIM3 exception.
+ * @brief   This function handles DMA1 channel 6 (USART2 receive)
+ *          half and full transfer exception.
  *
  * @return  none
  */
-void TIM3_IRQHandler( void )
+void DMA1_Channel6_IRQHandler( void )
 {
+    if( DMA_GetITStatus( DMA1_IT_HT6 ) != RESET || DMA_GetITStatus( DMA1_IT_TC6 ) != RESET )
+    {
+        /* Clear interrupt flag */
+        DMA_ClearITPendingBit( DMA1_IT_HT6 | DMA1_IT_TC6 );
+
+        UART2_DataRx_Deal( 0 );
+    }
+}
 
-    if( TIM_GetITStatus( TIM3, TIM_IT_Update ) != RESET )
+/*********************************************************************
+ * @fn      DMA1_Channel7_IRQHandler
+ *
+ * @brief   This function handles DMA1 channel 7 (USART2 transmit)
+ *          transfer complete exception.
+ *
+ * @return  none
+ */
+void DMA1_Channel7_IRQHandler( void )
+{
+    if( DMA_GetITStatus( DMA1_IT_TC7 ) != RESET )
     {
         /* Clear interrupt flag */
-        TIM_ClearITPendingBit( TIM3, TIM_IT_Update );
+        DMA_ClearITPendingBit( DMA1_IT_TC7 );
 
-        /* uart timeout counts */
-        Uart.Rx_TimeOut++;
-        Uart.USB_Up_TimeOut++;
+        UART2_DataTx_Deal( );
     }
+}
+
+/*********************************************************************
+ * @fn      USART2_IRQHandler
+ *
+ * @brief   This function handles USART2 idle line exception.
+ *
+ * @return  none
+ */
+void USART2_IRQHandler( void )
+{
+    if( USART_GetITStatus( USART2, USART_IT_IDLE ) != RESET )
+    {
+        /* Clear interrupt flag, read STATR then DATAR */
+        (void)USART2->STATR;
+        (void)USART2->DATAR;
 
+        UART2_DataRx_Deal( 1 );
+    }
 }
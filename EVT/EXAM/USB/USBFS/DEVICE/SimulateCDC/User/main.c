@@ -13,11 +13,14 @@
 /*
  *@Note
  *Example routine to emulate a simulate USB-CDC Device, USE USART2(PA2/PA3);
+ *Both directions are driven by the USBFS, DMA half/full transfer and USART2
+ *idle interrupts. The main loop re-initializes USART2 after a bus reset or
+ *a line coding change, and prints the throughput once a second.
  *Please note: This code uses the default serial port 1 for debugging,
  *if you need to modify the debugging serial port, please do not use USART2
 */
 
-#include <ch643_usbfs_device.h>
+#include "usbd_cdc.h"
 #include "debug.h"
 
 
@@ -30,6 +33,8 @@
  */
 int main(void)
 {
+    uint32_t rx_total, tx_total;
+    uint16_t ms = 0;
 
     NVIC_PriorityGroupConfig(NVIC_PriorityGroup_1);
     SystemCoreClockUpdate();
@@ -39,18 +44,24 @@ int main(void)
     printf("ChipID:%08x\r\n", DBGMCU_GetCHIPID() );
     RCC_Configuration( );
 
-    /* Tim3 init */
-    TIM3_Init( );
-
-    /* Usart1 init */
-    UART2_Init( 1, DEF_UARTx_BAUDRATE, DEF_UARTx_STOPBIT, DEF_UARTx_PARITY );
-
-    /* Usb Init */
+    /* Usb Init, the CDC class driver initializes USART2 */
+    USBFS_Class_Register( &CDC_Class_Drv );
     USBFS_RCC_Init( );
     USBFS_Device_Init( ENABLE , PWR_VDD_SupplyVoltage());
+
+    rx_total = UARTx_Rx_Total;
+    tx_total = UARTx_Tx_Total;
     while(1)
     {
-        UART2_DataRx_Deal( );
-        UART2_DataTx_Deal( );
+        CDC_Uart_Deal( );
+        Delay_Ms( 1 );
+        if( ++ms < 1000 )
+        {
+            continue;
+        }
+        ms = 0;
+        printf( "U2 Rx:%d B/s Tx:%d B/s Ovr:%d\r\n", (int)( UARTx_Rx_Total - rx_total ), (int)( UARTx_Tx_Total - tx_total ), (int)UARTx_Rx_Overrun );
+        rx_total = UARTx_Rx_Total;
+        tx_total = UARTx_Tx_Total;
     }
 }
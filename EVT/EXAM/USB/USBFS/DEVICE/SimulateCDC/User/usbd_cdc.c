@@ -0,0 +1,231 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : usbd_cdc.c
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: CDC-ACM class driver on the shared USBFS device core.
+ *              Endpoint 1 IN is the notification endpoint, endpoint 2 OUT
+ *              feeds the USART2 send buffer and endpoint 3 IN uploads the
+ *              USART2 receive buffer.
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "usbd_cdc.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+/* USART2 re-initialization asked for from the USBFS interrupt, done by
+ * CDC_Uart_Deal in the main loop */
+volatile uint8_t  CDC_Uart_Req;
+uint8_t  CDC_Line_Coding[ 8 ];                                                  /* Line coding of the last SET_LINE_CODING */
+volatile uint16_t CDC_Held_Len;                                                 /* Endpoint 2 packet held while a request is pending */
+volatile uint8_t  CDC_Held;
+
+/*********************************************************************
+ * @fn      CDC_Uart_Stop
+ *
+ * @brief   Keep the USART2 and DMA interrupts off until CDC_Uart_Deal
+ *          has re-initialized the serial port.
+ *
+ * @return  none
+ */
+static void CDC_Uart_Stop( void )
+{
+    NVIC_DisableIRQ( DMA1_Channel6_IRQn );
+    NVIC_DisableIRQ( DMA1_Channel7_IRQn );
+    NVIC_DisableIRQ( USART2_IRQn );
+}
+
+/*********************************************************************
+ * @fn      CDC_Init
+ *
+ * @brief   Open the CDC endpoints, called on device init and bus reset.
+ *          The serial port is reset later by CDC_Uart_Deal.
+ *
+ * @return  none
+ */
+static void CDC_Init( void )
+{
+    CDC_Uart_Stop( );
+    CDC_Uart_Req = DEF_CDC_UART_RESET;
+    CDC_Held = 0;
+
+    /* Single-buffered, so both directions can use the uart buffers directly */
+    USBFS_Endp_Open( DEF_UEP1, USBFSD_UEP_TX_EN, DEF_USBD_ENDP1_SIZE );
+    USBFS_Endp_Open( DEF_UEP2, USBFSD_UEP_RX_EN, DEF_USBD_ENDP2_SIZE );
+    USBFS_Endp_Open( DEF_UEP3, USBFSD_UEP_TX_EN, DEF_USBD_ENDP3_SIZE );
+
+    /* Endpoint 2 receives straight into the send buffer */
+    USBFS_Endp_RxBuf_Set( DEF_UEP2, &UART2_Tx_Buf[ 0 ] );
+}
+
+/*********************************************************************
+ * @fn      CDC_Setup
+ *
+ * @brief   CDC class and vendor requests.
+ *
+ * @return  DEF_USBD_REQ_OK or DEF_USBD_REQ_ERR
+ */
+static uint8_t CDC_Setup( const uint8_t **ppbuf, uint16_t *plen )
+{
+    if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_CLASS )
+    {
+        /* Class requests */
+        switch( USBFS_SetupReqCode )
+        {
+            case CDC_GET_LINE_CODING:
+                *ppbuf = (const uint8_t *)&Uart.Com_Cfg[ 0 ];
+                *plen = 7;
+                break;
+
+            case CDC_SET_LINE_CODING:
+            case CDC_SET_LINE_CTLSTE:
+            case CDC_SEND_BREAK:
+                break;
+
+            default:
+                return DEF_USBD_REQ_ERR;
+        }
+        return DEF_USBD_REQ_OK;
+    }
+    else if( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_VENDOR )
+    {
+        /* Manufacturer request */
+        return DEF_USBD_REQ_OK;
+    }
+    return DEF_USBD_REQ_ERR;
+}
+
+/*********************************************************************
+ * @fn      CDC_EP0_Out
+ *
+ * @brief   Control OUT data, the new line coding.
+ *
+ * @return  none
+ */
+static void CDC_EP0_Out( uint8_t *pbuf, uint16_t len )
+{
+    if( ( USBFS_SetupReqCode == CDC_SET_LINE_CODING ) && ( len >= 7 ) )
+    {
+        /* Save relevant parameters such as serial port baud rate */
+        /* The 7 bytes of the downlink are, in order
+           4 bytes: baud rate value: lowest baud rate byte, next lowest baud rate byte, next highest baud rate byte, highest baud rate byte.
+           1 byte: number of stop bits (0: 1 stop bit; 1: 1.5 stop bit; 2: 2 stop bits).
+           1 byte: number of parity bits (0: None; 1: Odd; 2: Even; 3: Mark; 4: Space).
+           1 byte: number of data bits (5,6,7,8,16); */
+        memcpy( (uint8_t *)&Uart.Com_Cfg[ 0 ], pbuf, 7 );
+        memcpy( CDC_Line_Coding, pbuf, 7 );
+        CDC_Uart_Stop( );
+        CDC_Uart_Req |= DEF_CDC_UART_CFG;
+    }
+}
+
+/*********************************************************************
+ * @fn      CDC_Out
+ *
+ * @brief   OUT packet received on endpoint 2, already in the send buffer.
+ *
+ * @return  none
+ */
+static void CDC_Out( uint8_t endp, uint8_t *pbuf, uint16_t len )
+{
+    if( ( endp == DEF_UEP2 ) && CDC_Uart_Req )
+    {
+        /* Keep it, endpoint 2 NAKs until the serial port is ready */
+        CDC_Held_Len = len;
+        CDC_Held = 1;
+        return;
+    }
+    if( ( endp == DEF_UEP2 ) && len )
+    {
+        /* NAK only when every slot of the send buffer is loaded */
+        if( UART2_DataTx_Load( len ) )
+        {
+            return;
+        }
+    }
+    USBFS_Endp_RxDone( endp );
+}
+
+/*********************************************************************
+ * @fn      CDC_In
+ *
+ * @brief   IN transfer done on endpoint 1/3.
+ *
+ * @return  none
+ */
+static void CDC_In( uint8_t endp )
+{
+    if( endp == DEF_UEP3 )
+    {
+        UART2_DataRx_UpDone( );
+    }
+}
+
+/*********************************************************************
+ * @fn      CDC_Uart_Deal
+ *
+ * @brief   Re-initialize USART2 after a bus reset or a line coding
+ *          change, called from the main loop. This takes too long for
+ *          the USBFS interrupt. A packet endpoint 2 received meanwhile
+ *          is moved to the first slot of the send buffer and sent.
+ *
+ * @return  none
+ */
+void CDC_Uart_Deal( void )
+{
+    uint8_t  req;
+    uint16_t len;
+
+    if( CDC_Uart_Req == 0 )
+    {
+        return;
+    }
+
+    NVIC_DisableIRQ( USBFS_IRQn );
+    req = CDC_Uart_Req;
+    CDC_Uart_Req = 0;
+    len = CDC_Held ? CDC_Held_Len : 0;
+    if( len )
+    {
+        memmove( &UART2_Tx_Buf[ 0 ], USBFS_Endp_RxBuf( DEF_UEP2 ), len );
+    }
+
+    if( req & DEF_CDC_UART_RESET )
+    {
+        UART2_Init( 1, DEF_UARTx_BAUDRATE, DEF_UARTx_STOPBIT, DEF_UARTx_PARITY );
+        USBFS_Endp_RxBuf_Set( DEF_UEP2, &UART2_Tx_Buf[ 0 ] );
+    }
+    if( req & DEF_CDC_UART_CFG )
+    {
+        memcpy( (uint8_t *)&Uart.Com_Cfg[ 0 ], CDC_Line_Coding, 7 );
+        UART2_USB_Init( );
+    }
+
+    if( CDC_Held )
+    {
+        CDC_Held = 0;
+        if( ( len == 0 ) || ( UART2_DataTx_Load( len ) == 0 ) )
+        {
+            USBFS_Endp_RxDone( DEF_UEP2 );
+        }
+    }
+    NVIC_EnableIRQ( USBFS_IRQn );
+}
+
+/* Class driver */
+const USBFS_CLASS_DRV CDC_Class_Drv =
+{
+    0, 2,
+    ( 1 << DEF_UEP1 ) | ( 1 << DEF_UEP2 ) | ( 1 << DEF_UEP3 ),
+    CDC_Init,
+    CDC_Setup,
+    CDC_EP0_Out,
+    CDC_Out,
+    CDC_In,
+    NULL,
+    NULL,
+};
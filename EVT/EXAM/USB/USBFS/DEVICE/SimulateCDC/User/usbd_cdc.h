@@ -0,0 +1,33 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name  : usbd_cdc.h
+ * Author     : WCH
+ * Version    : V1.0.0
+ * Date       : 2026/10/19
+ * Description: header file of usbd_cdc.c
+*******************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef USER_USBD_CDC_H_
+#define USER_USBD_CDC_H_
+
+#include <ch643_usbfs_device.h>
+#include "UART.h"
+
+/******************************************************************************/
+/* CDC_Uart_Req, USART2 re-initialization pending */
+#define DEF_CDC_UART_RESET          0x01                                        /* Bus reset, default line coding */
+#define DEF_CDC_UART_CFG            0x02                                        /* SET_LINE_CODING */
+
+/******************************************************************************/
+/* external variables */
+extern const USBFS_CLASS_DRV CDC_Class_Drv;
+extern volatile uint8_t CDC_Uart_Req;
+
+/******************************************************************************/
+/* external functions */
+extern void CDC_Uart_Deal( void );
+
+#endif /* USER_USBD_CDC_H_ */
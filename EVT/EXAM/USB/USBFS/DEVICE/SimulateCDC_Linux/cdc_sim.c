@@ -0,0 +1,1223 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : cdc_sim.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : SimulateCDC built for the PC against a simulated USBFS
+ *                      device controller, DMA1 channel 6/7 and USART2, with
+ *                      a simulated host on the USB side and a simulated peer
+ *                      on the serial line.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * UART.c, usbd_cdc.c, usb_desc.c and ch643_it.c of SimulateCDC and the
+ * device core of USBD_Lib are compiled in as they are. The peripherals they
+ * touch are plain structures driven by this file in simulated time:
+ *   USBFS  - the SIE answers the host from the UEPn_CTRL_H response and
+ *            toggle bits and the UEPn_DMA buffers, raises USBFS_UIF_TRANSFER
+ *            and NAKs everything until the interrupt has cleared it.
+ *            Single-buffered endpoints only.
+ *   DMA    - channel 7 feeds the USART2 transmitter, channel 6 fills the
+ *            receive ring, with the half/full transfer flags.
+ *   USART2 - one byte per 10 bit times (11 with parity or 2 stop bits),
+ *            idle line flag one byte time after the last byte.
+ *   NVIC   - the four interrupts have the same priority and run in IRQ
+ *            number order, never nested. Each USBFS interrupt keeps the SIE
+ *            busy for SIM_USB_IRQ_NS.
+ * The main loop of main.c, CDC_Uart_Deal once a millisecond, is run too.
+ * The host enumerates the device, sets the line coding, streams data to
+ * endpoint 2 and reads endpoint 3; the peer checks what comes out of the
+ * transmitter and streams into the receiver. Both streams are checked byte
+ * by byte. USB transactions take their full-speed bus time; the host polls
+ * again after a NAK, with up to SIM_JITTER_NS of delay.
+ *
+ * Build:
+ *   gcc -O2 -Wall -I../SimulateCDC/User -I../USBD_Lib -I../../../../SRC/Core
+ *       -I../../../../SRC/Debug -I../../../../SRC/Peripheral/inc
+ *       -o cdc_sim cdc_sim.c
+ *
+ * Usage:
+ *   cdc_sim [-b baud] [-T ms] [-g]
+ *   -b  line coding set by the host, 3000000 by default
+ *   -T  simulated time of streaming, 1000 ms by default
+ *   -g  the peer sends bursts with idle gaps and the host sends packets of
+ *       random length, instead of both streaming flat out
+ *   cdc_sim -t runs the self-tests.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* The example and the peripheral headers as they are, minus the RISC-V bits */
+#define interrupt( x )      unused
+#include "debug.h"
+
+static USBFSD_TypeDef      Sim_Usbfsd;
+static DMA_TypeDef         Sim_Dma1;
+static DMA_Channel_TypeDef Sim_Dma1_Ch[ 2 ];                                  /* Channel 6, 7 */
+static USART_TypeDef       Sim_Usart2;
+static GPIO_TypeDef        Sim_Gpioa, Sim_Gpioc;
+static AFIO_TypeDef        Sim_Afio;
+
+#undef USBFSD
+#define USBFSD              ( &Sim_Usbfsd )
+#undef DMA1
+#define DMA1                ( &Sim_Dma1 )
+#undef DMA1_Channel6
+#define DMA1_Channel6       ( &Sim_Dma1_Ch[ 0 ] )
+#undef DMA1_Channel7
+#define DMA1_Channel7       ( &Sim_Dma1_Ch[ 1 ] )
+#undef USART2
+#define USART2              ( &Sim_Usart2 )
+#undef GPIOA
+#define GPIOA               ( &Sim_Gpioa )
+#undef GPIOC
+#define GPIOC               ( &Sim_Gpioc )
+#undef AFIO
+#define AFIO                ( &Sim_Afio )
+
+static void Sim_Nvic_Cmd( int irq, int en );
+#define NVIC_EnableIRQ( n ) Sim_Nvic_Cmd( ( n ), 1 )
+#define NVIC_DisableIRQ( n ) Sim_Nvic_Cmd( ( n ), 0 )
+
+/* The host never suspends the bus, USBFS_Device_Sleep has nothing to mask */
+#define __disable_irq( )    ( (void)0 )
+#define __enable_irq( )     ( (void)0 )
+
+/* The DMA registers keep 32-bit addresses of buffers, Sim_Ptr finds the
+ * buffer behind one */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpointer-to-int-cast"
+#include "usb_desc.c"
+#include "ch643_usbfs_device.c"
+#include "UART.c"
+#include "usbd_cdc.c"
+#include "ch643_it.c"
+#pragma GCC diagnostic pop
+
+#define SIM_USB_IRQ_NS      3000                                                /* SIE busy per USBFS interrupt */
+#define SIM_TICK_NS         1000000                                             /* Main loop period */
+#define SIM_HOST_ADDR       5
+#define SIM_JITTER_NS       5000                                                /* Host delay before each OUT, 0 - this */
+#define SIM_BURST_MAX       600                                                 /* -g: bytes per peer burst */
+
+/* Host transaction results */
+#define SIM_ACK             0
+#define SIM_NAK             1
+#define SIM_STALL           2
+#define SIM_TIMEOUT         3
+
+typedef struct _SIM_OPT
+{
+    uint32_t Baud;
+    uint32_t Run_Ms;
+    int      Gaps;
+} SIM_OPT;
+
+typedef struct _SIM_CTX
+{
+    uint64_t Now;                                                               /* ns */
+    uint64_t Tick;                                                              /* Next main loop pass */
+    uint8_t  Nvic[ 64 ];
+    uint32_t Seed;
+
+    /* USBFS */
+    uint8_t  Usb_Flags;                                                         /* INT_FG as the hardware has it */
+    uint64_t Usb_Busy_Until;
+    uint8_t  Host_Addr;
+    uint8_t  Out_Tog[ 8 ], In_Tog[ 8 ];                                         /* Host side data toggles */
+    uint32_t Naks;
+
+    /* DMA channel 6/7 transfer length as enabled */
+    uint32_t Dma_Len[ 2 ];
+
+    /* USART2 */
+    uint32_t Byte_Ns;
+    uint8_t  Usart_On, Dma_Rx, Dma_Tx, Idle_Ie, Idle_Pend;
+    uint8_t  Tdr_Full, Tdr, Shift;
+    uint64_t Shift_End;                                                         /* 0 - transmitter idle */
+    uint64_t Rx_Next;                                                           /* Next byte from the peer, 0 - none */
+    uint64_t Idle_At;                                                           /* 0 - idle seen */
+
+    /* Streams */
+    uint32_t Out_Len;                                                           /* Host bytes acknowledged by endpoint 2 */
+    uint32_t Out_Stop;                                                          /* Host sends while Out_Len < Out_Stop */
+    uint32_t Peer_Got;                                                          /* Bytes out of the transmitter */
+    uint32_t Peer_Sent;                                                         /* Bytes into the receiver */
+    uint32_t Peer_Stop;
+    uint32_t Burst_Left;
+    uint32_t Host_Got;                                                          /* Bytes read from endpoint 3 */
+    uint32_t Line_Lost;                                                         /* Received with the DMA off */
+    uint32_t Errors;
+    int      Gaps;
+} SIM_CTX;
+
+static SIM_CTX Sim;
+
+/*********************************************************************
+ * @fn      Sim_Fail
+ *
+ * @brief   Count one error, and print the first few.
+ *
+ * @return  none
+ */
+static void Sim_Fail( const char *pmsg, uint32_t a, uint32_t b )
+{
+    if( Sim.Errors++ < 8 )
+    {
+        printf( "%10.3f ms  %s (%u, %u)\n", Sim.Now / 1e6, pmsg, a, b );
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Rand
+ *
+ * @brief   Pseudo-random number, the same every run.
+ *
+ * @return  0 - 0x7FFF
+ */
+static uint32_t Sim_Rand( void )
+{
+    Sim.Seed = Sim.Seed * 1103515245 + 12345;
+    return ( Sim.Seed >> 16 ) & 0x7FFF;
+}
+
+/*********************************************************************
+ * @fn      Sim_Pat
+ *
+ * @brief   Byte n of a test stream, seed tells the two streams apart.
+ *
+ * @return  byte
+ */
+static uint8_t Sim_Pat( uint32_t n, uint32_t seed )
+{
+    n = ( n ^ seed ) * 2654435761u;
+    return (uint8_t)( n >> 24 );
+}
+
+/*********************************************************************
+ * @fn      Sim_Ptr
+ *
+ * @brief   Buffer behind a 32-bit DMA address written by the example.
+ *
+ * @param   len - bytes that must lie inside the buffer
+ *
+ * @return  pointer, exits if the address is in no buffer
+ */
+static uint8_t *Sim_Ptr( uint32_t adr, uint32_t len )
+{
+    static uint8_t * const pbuf[ ] =
+    {
+        UART2_Tx_Buf, UART2_Rx_Buf, USBFS_EP0_4Buf, USBFS_EP1_Buf, USBFS_EP2_Buf,
+        USBFS_EP3_Buf, USBFS_EP5_Buf, USBFS_EP6_Buf, USBFS_EP7_Buf,
+    };
+    static const uint32_t size[ ] =
+    {
+        sizeof( UART2_Tx_Buf ), sizeof( UART2_Rx_Buf ), sizeof( USBFS_EP0_4Buf ), sizeof( USBFS_EP1_Buf ),
+        sizeof( USBFS_EP2_Buf ), sizeof( USBFS_EP3_Buf ), sizeof( USBFS_EP5_Buf ), sizeof( USBFS_EP6_Buf ),
+        sizeof( USBFS_EP7_Buf ),
+    };
+    uint32_t i, off;
+
+    for( i = 0; i < sizeof( size ) / sizeof( size[ 0 ] ); i++ )
+    {
+        off = adr - (uint32_t)(uintptr_t)pbuf[ i ];
+        if( ( off < size[ i ] ) && ( len <= size[ i ] - off ) )
+        {
+            return pbuf[ i ] + off;
+        }
+    }
+    fprintf( stderr, "sim: DMA address %08x+%u is in no buffer\n", adr, len );
+    exit( 2 );
+}
+
+/*********************************************************************
+ * @fn      Sim_Nvic_Cmd
+ *
+ * @brief   NVIC_EnableIRQ/NVIC_DisableIRQ.
+ *
+ * @return  none
+ */
+static void Sim_Nvic_Cmd( int irq, int en )
+{
+    Sim.Nvic[ irq & 63 ] = en;
+}
+
+/* Peripheral library, the calls the example makes */
+void Delay_Us( uint32_t n ) { }
+void Delay_Ms( uint32_t n ) { }
+void RCC_APB2PeriphClockCmd( uint32_t RCC_APB2Periph, FunctionalState NewState ) { }
+void RCC_APB1PeriphClockCmd( uint32_t RCC_APB1Periph, FunctionalState NewState ) { }
+void RCC_AHBPeriphClockCmd( uint32_t RCC_AHBPeriph, FunctionalState NewState ) { }
+void GPIO_Init( GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct ) { }
+void GPIO_SetBits( GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin ) { }
+void USART_ClearFlag( USART_TypeDef *USARTx, uint16_t USART_FLAG ) { }
+void EXTI_Init( EXTI_InitTypeDef *EXTI_InitStruct ) { }
+void EXTI_ClearFlag( uint32_t EXTI_Line ) { }
+void PWR_EnterSTOPMode( uint8_t PWR_STOPEntry ) { }
+PWR_VDD PWR_VDD_SupplyVoltage( void ) { return PWR_VDD_5V; }
+void SystemInit( void ) { }
+void SystemCoreClockUpdate( void ) { }
+
+void USART_Init( USART_TypeDef *USARTx, USART_InitTypeDef *USART_InitStruct )
+{
+    uint32_t bits = 10;
+
+    if( USART_InitStruct->USART_Parity != USART_Parity_No )
+    {
+        bits++;
+    }
+    if( USART_InitStruct->USART_StopBits == USART_StopBits_2 )
+    {
+        bits++;
+    }
+    Sim.Byte_Ns = (uint32_t)( 1000000000ull * bits / USART_InitStruct->USART_BaudRate );
+}
+
+void USART_Cmd( USART_TypeDef *USARTx, FunctionalState NewState ) { Sim.Usart_On = ( NewState != DISABLE ); }
+
+void USART_ITConfig( USART_TypeDef *USARTx, uint16_t USART_IT, FunctionalState NewState )
+{
+    if( USART_IT == USART_IT_IDLE )
+    {
+        Sim.Idle_Ie = ( NewState != DISABLE );
+    }
+}
+
+void USART_DMACmd( USART_TypeDef *USARTx, uint16_t USART_DMAReq, FunctionalState NewState )
+{
+    if( USART_DMAReq & USART_DMAReq_Rx )
+    {
+        Sim.Dma_Rx = ( NewState != DISABLE );
+    }
+    if( USART_DMAReq & USART_DMAReq_Tx )
+    {
+        Sim.Dma_Tx = ( NewState != DISABLE );
+    }
+}
+
+ITStatus USART_GetITStatus( USART_TypeDef *USARTx, uint16_t USART_IT )
+{
+    return ( ( USART_IT == USART_IT_IDLE ) && Sim.Idle_Pend ) ? SET : RESET;
+}
+
+void DMA_DeInit( DMA_Channel_TypeDef *DMAy_Channelx )
+{
+    memset( DMAy_Channelx, 0, sizeof( DMA_Channel_TypeDef ) );
+    Sim_Dma1.INTFR &= ( DMAy_Channelx == DMA1_Channel6 ) ? ~0x00F00000 : ~0x0F000000;
+}
+
+void DMA_Init( DMA_Channel_TypeDef *DMAy_Channelx, DMA_InitTypeDef *DMA_InitStruct )
+{
+    DMAy_Channelx->PADDR = DMA_InitStruct->DMA_PeripheralBaseAddr;
+    DMAy_Channelx->MADDR = DMA_InitStruct->DMA_MemoryBaseAddr;
+    DMAy_Channelx->CNTR = DMA_InitStruct->DMA_BufferSize;
+    DMAy_Channelx->CFGR = DMA_InitStruct->DMA_DIR | DMA_InitStruct->DMA_Mode;
+}
+
+void DMA_ITConfig( DMA_Channel_TypeDef *DMAy_Channelx, uint32_t DMA_IT, FunctionalState NewState )
+{
+    if( NewState != DISABLE )
+    {
+        DMAy_Channelx->CFGR |= DMA_IT;
+    }
+    else
+    {
+        DMAy_Channelx->CFGR &= ~DMA_IT;
+    }
+}
+
+void DMA_Cmd( DMA_Channel_TypeDef *DMAy_Channelx, FunctionalState NewState )
+{
+    if( NewState != DISABLE )
+    {
+        /* The channel counts from here, CNTR and MADDR as they are now */
+        DMAy_Channelx->CFGR |= DMA_CFGR1_EN;
+        Sim.Dma_Len[ DMAy_Channelx - Sim_Dma1_Ch ] = DMAy_Channelx->CNTR;
+    }
+    else
+    {
+        DMAy_Channelx->CFGR &= ~DMA_CFGR1_EN;
+    }
+}
+
+ITStatus DMA_GetITStatus( uint32_t DMAy_IT ) { return ( Sim_Dma1.INTFR & DMAy_IT ) ? SET : RESET; }
+void DMA_ClearITPendingBit( uint32_t DMAy_IT ) { Sim_Dma1.INTFR &= ~DMAy_IT; }
+
+/*********************************************************************
+ * @fn      Sim_Tx_Kick
+ *
+ * @brief   USART2 transmitter: DMA channel 7 refills the data register
+ *          whenever it is empty, the shift register takes it as soon as
+ *          it is free.
+ *
+ * @return  none
+ */
+static void Sim_Tx_Kick( void )
+{
+    DMA_Channel_TypeDef *ch = DMA1_Channel7;
+
+    if( !Sim.Tdr_Full && Sim.Usart_On && Sim.Dma_Tx && ( ch->CFGR & DMA_CFGR1_EN ) && ch->CNTR )
+    {
+        Sim.Tdr = *Sim_Ptr( ch->MADDR + Sim.Dma_Len[ 1 ] - ch->CNTR, 1 );
+        Sim.Tdr_Full = 1;
+        if( --ch->CNTR == 0 )
+        {
+            Sim_Dma1.INTFR |= DMA1_IT_TC7;
+        }
+    }
+    if( Sim.Tdr_Full && ( Sim.Shift_End == 0 ) )
+    {
+        Sim.Shift = Sim.Tdr;
+        Sim.Tdr_Full = 0;
+        Sim.Shift_End = Sim.Now + Sim.Byte_Ns;
+        Sim_Tx_Kick( );
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Irq
+ *
+ * @brief   Run the pending interrupts, lowest IRQ number first, until
+ *          none is left. A USBFS flag is cleared by writing it to INT_FG:
+ *          the read-only USBFS_U_SIE_FREE bit is set before the handler
+ *          runs, so a write shows as that bit gone.
+ *
+ * @return  none
+ */
+static void Sim_Irq( void )
+{
+    DMA_Channel_TypeDef *ch6 = DMA1_Channel6, *ch7 = DMA1_Channel7;
+    uint8_t v;
+    int n;
+
+    for( n = 0; n < 1000; n++ )
+    {
+        Sim_Tx_Kick( );
+        if( Sim.Nvic[ DMA1_Channel6_IRQn ] &&
+            ( ( ( Sim_Dma1.INTFR & DMA1_IT_HT6 ) && ( ch6->CFGR & DMA_IT_HT ) ) ||
+              ( ( Sim_Dma1.INTFR & DMA1_IT_TC6 ) && ( ch6->CFGR & DMA_IT_TC ) ) ) )
+        {
+            DMA1_Channel6_IRQHandler( );
+        }
+        else if( Sim.Nvic[ DMA1_Channel7_IRQn ] && ( Sim_Dma1.INTFR & DMA1_IT_TC7 ) && ( ch7->CFGR & DMA_IT_TC ) )
+        {
+            DMA1_Channel7_IRQHandler( );
+        }
+        else if( Sim.Nvic[ USART2_IRQn ] && Sim.Idle_Pend && Sim.Idle_Ie )
+        {
+            /* Cleared by the STATR, DATAR reads of the handler */
+            USART2_IRQHandler( );
+            Sim.Idle_Pend = 0;
+        }
+        else if( Sim.Nvic[ USBFS_IRQn ] && ( Sim.Usb_Flags & Sim_Usbfsd.INT_EN ) )
+        {
+            Sim_Usbfsd.INT_FG = Sim.Usb_Flags | USBFS_U_SIE_FREE;
+            USBFS_IRQHandler( );
+            v = Sim_Usbfsd.INT_FG;
+            if( !( v & USBFS_U_SIE_FREE ) )
+            {
+                Sim.Usb_Flags &= ~v;
+            }
+            Sim.Usb_Busy_Until = Sim.Now + SIM_USB_IRQ_NS;
+        }
+        else
+        {
+            Sim_Tx_Kick( );
+            return;
+        }
+    }
+    fprintf( stderr, "sim: an interrupt flag is never cleared\n" );
+    exit( 2 );
+}
+
+/*********************************************************************
+ * @fn      Sim_Peer_Byte
+ *
+ * @brief   The peer has sent one more byte into the receiver, DMA
+ *          channel 6 stores it in the circular buffer.
+ *
+ * @return  none
+ */
+static void Sim_Peer_Byte( void )
+{
+    DMA_Channel_TypeDef *ch = DMA1_Channel6;
+    uint8_t b = Sim_Pat( Sim.Peer_Sent++, 0xA5 );
+
+    if( Sim.Usart_On && Sim.Dma_Rx && ( ch->CFGR & DMA_CFGR1_EN ) && ch->CNTR )
+    {
+        *Sim_Ptr( ch->MADDR + Sim.Dma_Len[ 0 ] - ch->CNTR, 1 ) = b;
+        ch->CNTR--;
+        if( ch->CNTR == Sim.Dma_Len[ 0 ] / 2 )
+        {
+            Sim_Dma1.INTFR |= DMA1_IT_HT6;
+        }
+        if( ch->CNTR == 0 )
+        {
+            Sim_Dma1.INTFR |= DMA1_IT_TC6;
+            if( ch->CFGR & DMA_Mode_Circular )
+            {
+                ch->CNTR = Sim.Dma_Len[ 0 ];
+            }
+        }
+    }
+    else
+    {
+        Sim.Line_Lost++;
+    }
+
+    /* Next byte straight after, or a gap of 2-50 byte times */
+    Sim.Rx_Next = 0;
+    if( Sim.Peer_Sent < Sim.Peer_Stop )
+    {
+        if( !Sim.Gaps || --Sim.Burst_Left )
+        {
+            Sim.Rx_Next = Sim.Now + Sim.Byte_Ns;
+        }
+        else
+        {
+            Sim.Burst_Left = 1 + Sim_Rand( ) % SIM_BURST_MAX;
+            Sim.Rx_Next = Sim.Now + Sim.Byte_Ns * ( 2 + Sim_Rand( ) % 49 );
+        }
+    }
+    Sim.Idle_At = ( Sim.Rx_Next == Sim.Now + Sim.Byte_Ns ) ? 0 : Sim.Now + Sim.Byte_Ns;
+}
+
+/*********************************************************************
+ * @fn      Sim_Peer_Start
+ *
+ * @brief   Let the peer send up to byte stop of its stream. It starts
+ *          two main loop passes later, once CDC_Uart_Deal has set the
+ *          port up; bytes sent while it does so are lost, on the chip too.
+ *
+ * @return  none
+ */
+static void Sim_Peer_Start( uint32_t stop )
+{
+    Sim.Peer_Stop = stop;
+    Sim.Burst_Left = 1 + Sim_Rand( ) % SIM_BURST_MAX;
+    if( ( Sim.Rx_Next == 0 ) && ( Sim.Peer_Sent < stop ) )
+    {
+        Sim.Rx_Next = Sim.Now + 2 * SIM_TICK_NS;
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Wait
+ *
+ * @brief   Let the serial line, DMA and main loop run until time t.
+ *
+ * @return  none
+ */
+static void Sim_Wait( uint64_t t )
+{
+    uint64_t next;
+
+    for( ; ; )
+    {
+        next = Sim.Tick;
+        if( Sim.Shift_End && ( Sim.Shift_End < next ) )
+        {
+            next = Sim.Shift_End;
+        }
+        if( Sim.Rx_Next && ( Sim.Rx_Next < next ) )
+        {
+            next = Sim.Rx_Next;
+        }
+        if( Sim.Idle_At && ( Sim.Idle_At < next ) )
+        {
+            next = Sim.Idle_At;
+        }
+        if( next > t )
+        {
+            break;
+        }
+        Sim.Now = next;
+
+        if( Sim.Shift_End == next )
+        {
+            if( Sim.Shift != Sim_Pat( Sim.Peer_Got, 0x5A ) )
+            {
+                Sim_Fail( "peer: wrong byte", Sim.Peer_Got, Sim.Shift );
+            }
+            Sim.Peer_Got++;
+            Sim.Shift_End = 0;
+        }
+        if( Sim.Rx_Next == next )
+        {
+            Sim_Peer_Byte( );
+        }
+        if( Sim.Idle_At == next )
+        {
+            Sim.Idle_At = 0;
+            Sim.Idle_Pend = 1;
+        }
+        if( Sim.Tick == next )
+        {
+            /* The main loop of main.c */
+            Sim.Tick += SIM_TICK_NS;
+            CDC_Uart_Deal( );
+        }
+        Sim_Irq( );
+    }
+    Sim.Now = t;
+}
+
+/*********************************************************************
+ * @fn      Sim_Bus_Ns
+ *
+ * @brief   Full-speed bus time of a transaction with len data bytes,
+ *          -1 for a token and handshake only: sync, PIDs, CRCs, bit
+ *          stuffing and turnaround.
+ *
+ * @return  ns
+ */
+static uint64_t Sim_Bus_Ns( int len )
+{
+    return ( len < 0 ) ? 9000 : (uint64_t)( len + 18 ) * 8 * 1000 / 12 + 2000;
+}
+
+/*********************************************************************
+ * @fn      Sim_Sie
+ *
+ * @brief   What the SIE knows of one endpoint: its response byte and
+ *          the 32-bit address of its buffer.
+ *
+ * @param   in - 1 - IN token, 0 - OUT or SETUP
+ *
+ * @return  UEPn_CTRL_H, NULL if the endpoint does not answer
+ */
+static volatile uint16_t *Sim_Sie( uint8_t endp, int in, uint32_t *padr )
+{
+    uint8_t mod;
+
+    if( ( Sim_Usbfsd.DEV_ADDR & 0x7F ) != Sim.Host_Addr )
+    {
+        return NULL;
+    }
+    if( endp == DEF_UEP0 )
+    {
+        *padr = Sim_Usbfsd.UEP0_DMA;
+        return &Sim_Usbfsd.UEP0_CTRL_H;
+    }
+    if( endp == DEF_UEP1 )
+    {
+        mod = Sim_Usbfsd.UEP4_1_MOD >> 4;
+    }
+    else if( endp == DEF_UEP2 )
+    {
+        mod = Sim_Usbfsd.UEP2_3_MOD & 0x0F;
+    }
+    else if( endp == DEF_UEP3 )
+    {
+        mod = Sim_Usbfsd.UEP2_3_MOD >> 4;
+    }
+    else
+    {
+        return NULL;
+    }
+    if( !( mod & ( in ? USBFSD_UEP_TX_EN : USBFSD_UEP_RX_EN ) ) )
+    {
+        return NULL;
+    }
+    if( mod & USBFSD_UEP_BUF_MOD )
+    {
+        fprintf( stderr, "sim: endpoint %d double-buffered, not simulated\n", endp );
+        exit( 2 );
+    }
+    *padr = ( endp == DEF_UEP1 ) ? Sim_Usbfsd.UEP1_DMA : ( endp == DEF_UEP2 ) ? Sim_Usbfsd.UEP2_DMA : Sim_Usbfsd.UEP3_DMA;
+    if( in && ( mod & USBFSD_UEP_RX_EN ) )
+    {
+        *padr += DEF_USBFS_UEP_BUF_LEN;
+    }
+    return ( endp == DEF_UEP1 ) ? &Sim_Usbfsd.UEP1_CTRL_H : ( endp == DEF_UEP2 ) ? &Sim_Usbfsd.UEP2_CTRL_H : &Sim_Usbfsd.UEP3_CTRL_H;
+}
+
+/*********************************************************************
+ * @fn      Sim_Done
+ *
+ * @brief   Transaction finished: set USBFS_UIF_TRANSFER and the status.
+ *
+ * @return  none
+ */
+static void Sim_Done( uint8_t st, uint16_t len )
+{
+    Sim_Usbfsd.INT_ST = st;
+    Sim_Usbfsd.RX_LEN = len;
+    Sim.Usb_Flags |= USBFS_UIF_TRANSFER;
+    Sim_Irq( );
+}
+
+/*********************************************************************
+ * @fn      Sim_Busy
+ *
+ * @brief   The SIE NAKs while a transfer interrupt is pending or being
+ *          handled (USBFS_UC_INT_BUSY).
+ *
+ * @return  1 - busy
+ */
+static int Sim_Busy( void )
+{
+    return ( Sim.Usb_Flags & USBFS_UIF_TRANSFER ) || ( Sim.Now < Sim.Usb_Busy_Until );
+}
+
+/*********************************************************************
+ * @fn      Sim_Setup
+ *
+ * @brief   SETUP transaction to endpoint 0. It cannot be NAKed, the
+ *          host waits until the SIE is free.
+ *
+ * @return  SIM_ACK or SIM_TIMEOUT
+ */
+static int Sim_Setup( const uint8_t *preq )
+{
+    volatile uint16_t *ctrl;
+    uint32_t adr;
+
+    while( Sim_Busy( ) )
+    {
+        Sim_Wait( Sim.Now + 1000 );
+    }
+    ctrl = Sim_Sie( DEF_UEP0, 0, &adr );
+    Sim_Wait( Sim.Now + Sim_Bus_Ns( 8 ) );
+    if( ctrl == NULL )
+    {
+        return SIM_TIMEOUT;
+    }
+    memcpy( Sim_Ptr( adr, 8 ), preq, 8 );
+    Sim.Out_Tog[ 0 ] = 1;
+    Sim.In_Tog[ 0 ] = 1;
+    Sim_Done( USBFS_UIS_TOKEN_SETUP | DEF_UEP0, 8 );
+    return SIM_ACK;
+}
+
+/*********************************************************************
+ * @fn      Sim_Out
+ *
+ * @brief   OUT transaction with the host's data toggle. Data with the
+ *          wrong toggle is ACKed without USBFS_UIS_TOG_OK, as the SIE
+ *          does; the host counts that as an error.
+ *
+ * @return  SIM_ACK, SIM_NAK, SIM_STALL or SIM_TIMEOUT
+ */
+static int Sim_Out( uint8_t endp, const uint8_t *pdat, int len )
+{
+    volatile uint16_t *ctrl;
+    uint32_t adr;
+    uint8_t  tog_ok;
+    int busy;
+
+    busy = Sim_Busy( );
+    ctrl = Sim_Sie( endp, 0, &adr );
+    if( ( ctrl == NULL ) || busy || ( ( *ctrl & USBFS_UEP_R_RES_MASK ) != USBFS_UEP_R_RES_ACK ) )
+    {
+        Sim_Wait( Sim.Now + Sim_Bus_Ns( len ) );
+        if( ctrl == NULL )
+        {
+            return SIM_TIMEOUT;
+        }
+        if( !busy && ( ( *ctrl & USBFS_UEP_R_RES_MASK ) == USBFS_UEP_R_RES_STALL ) )
+        {
+            return SIM_STALL;
+        }
+        Sim.Naks++;
+        return SIM_NAK;
+    }
+
+    tog_ok = ( ( *ctrl & USBFS_UEP_R_TOG ) ? 1 : 0 ) == Sim.Out_Tog[ endp ];
+    Sim_Wait( Sim.Now + Sim_Bus_Ns( len ) );
+    if( tog_ok )
+    {
+        memcpy( Sim_Ptr( adr, len ), pdat, len );
+    }
+    else
+    {
+        Sim_Fail( "host: OUT data toggle not taken, endpoint", endp, Sim.Out_Tog[ endp ] );
+    }
+    Sim.Out_Tog[ endp ] ^= 1;
+    Sim_Done( USBFS_UIS_TOKEN_OUT | endp | ( tog_ok ? USBFS_UIS_TOG_OK : 0 ), len );
+    return SIM_ACK;
+}
+
+/*********************************************************************
+ * @fn      Sim_In
+ *
+ * @brief   IN transaction. A packet with the toggle already seen would
+ *          be dropped by a real host as a retry; here it is an error.
+ *
+ * @return  SIM_ACK, SIM_NAK, SIM_STALL or SIM_TIMEOUT
+ */
+static int Sim_In( uint8_t endp, uint8_t *pdat, int *plen )
+{
+    volatile uint16_t *ctrl;
+    volatile uint16_t *txlen;
+    uint32_t adr;
+    int busy, len;
+
+    busy = Sim_Busy( );
+    ctrl = Sim_Sie( endp, 1, &adr );
+    if( ( ctrl == NULL ) || busy || ( ( *ctrl & USBFS_UEP_T_RES_MASK ) != USBFS_UEP_T_RES_ACK ) )
+    {
+        Sim_Wait( Sim.Now + Sim_Bus_Ns( -1 ) );
+        if( ctrl == NULL )
+        {
+            return SIM_TIMEOUT;
+        }
+        if( !busy && ( ( *ctrl & USBFS_UEP_T_RES_MASK ) == USBFS_UEP_T_RES_STALL ) )
+        {
+            return SIM_STALL;
+        }
+        Sim.Naks++;
+        return SIM_NAK;
+    }
+
+    txlen = ( endp == DEF_UEP0 ) ? &Sim_Usbfsd.UEP0_TX_LEN : ( endp == DEF_UEP1 ) ? &Sim_Usbfsd.UEP1_TX_LEN :
+            ( endp == DEF_UEP2 ) ? &Sim_Usbfsd.UEP2_TX_LEN : &Sim_Usbfsd.UEP3_TX_LEN;
+    len = *txlen;
+    if( len > DEF_USBFS_UEP_BUF_LEN )
+    {
+        Sim_Fail( "device: IN packet too long, endpoint", endp, len );
+        len = DEF_USBFS_UEP_BUF_LEN;
+    }
+    memcpy( pdat, Sim_Ptr( adr, len ), len );
+    *plen = len;
+    if( ( ( *ctrl & USBFS_UEP_T_TOG ) ? 1 : 0 ) != Sim.In_Tog[ endp ] )
+    {
+        Sim_Fail( "host: IN data toggle repeated, endpoint", endp, Sim.In_Tog[ endp ] );
+    }
+    Sim.In_Tog[ endp ] ^= 1;
+    Sim_Wait( Sim.Now + Sim_Bus_Ns( len ) );
+    Sim_Done( USBFS_UIS_TOKEN_IN | endp, 0 );
+    return SIM_ACK;
+}
+
+/*********************************************************************
+ * @fn      Sim_Retry
+ *
+ * @brief   Repeat a NAKed transaction for up to 100 ms.
+ *
+ * @return  result of the last try
+ */
+#define Sim_Retry( r, call )                                                    \
+    do                                                                          \
+    {                                                                           \
+        uint64_t end_ = Sim.Now + 100000000;                                    \
+        while( ( ( r = ( call ) ) == SIM_NAK ) && ( Sim.Now < end_ ) );         \
+    } while( 0 )
+
+/*********************************************************************
+ * @fn      Sim_Control
+ *
+ * @brief   Control transfer on endpoint 0.
+ *
+ * @param   pdat - data stage, wLength of the request bytes
+ *
+ * @return  bytes of the data stage, -1 on error
+ */
+static int Sim_Control( uint8_t type, uint8_t req, uint16_t value, uint16_t index, uint8_t *pdat, uint16_t wlen )
+{
+    uint8_t setup[ 8 ], buf[ DEF_USBFS_UEP_BUF_LEN ];
+    int r, len, n = 0;
+
+    setup[ 0 ] = type;
+    setup[ 1 ] = req;
+    setup[ 2 ] = (uint8_t)value;
+    setup[ 3 ] = (uint8_t)( value >> 8 );
+    setup[ 4 ] = (uint8_t)index;
+    setup[ 5 ] = (uint8_t)( index >> 8 );
+    setup[ 6 ] = (uint8_t)wlen;
+    setup[ 7 ] = (uint8_t)( wlen >> 8 );
+    if( Sim_Setup( setup ) != SIM_ACK )
+    {
+        return -1;
+    }
+
+    if( type & DEF_UEP_IN )
+    {
+        while( n < wlen )
+        {
+            Sim_Retry( r, Sim_In( DEF_UEP0, buf, &len ) );
+            if( r != SIM_ACK )
+            {
+                return -1;
+            }
+            memcpy( pdat + n, buf, ( len < wlen - n ) ? len : wlen - n );
+            n += len;
+            if( len < DEF_USBD_UEP0_SIZE )
+            {
+                break;
+            }
+        }
+        Sim_Retry( r, Sim_Out( DEF_UEP0, NULL, 0 ) );
+    }
+    else
+    {
+        while( n < wlen )
+        {
+            len = ( wlen - n < DEF_USBD_UEP0_SIZE ) ? wlen - n : DEF_USBD_UEP0_SIZE;
+            Sim_Retry( r, Sim_Out( DEF_UEP0, pdat + n, len ) );
+            if( r != SIM_ACK )
+            {
+                return -1;
+            }
+            n += len;
+        }
+        Sim_Retry( r, Sim_In( DEF_UEP0, buf, &len ) );
+        if( ( r == SIM_ACK ) && len )
+        {
+            r = SIM_STALL;
+        }
+    }
+    return ( r == SIM_ACK ) ? n : -1;
+}
+
+/*********************************************************************
+ * @fn      Sim_Line_Coding
+ *
+ * @brief   SET_LINE_CODING, 8 data bits, 1 stop bit, no parity.
+ *
+ * @return  0 - ok
+ */
+static int Sim_Line_Coding( uint32_t baud )
+{
+    uint8_t lc[ 7 ] = { (uint8_t)baud, (uint8_t)( baud >> 8 ), (uint8_t)( baud >> 16 ), (uint8_t)( baud >> 24 ), 0, 0, 8 };
+
+    return ( Sim_Control( 0x21, CDC_SET_LINE_CODING, 0, 0, lc, 7 ) == 7 ) ? 0 : -1;
+}
+
+/*********************************************************************
+ * @fn      Sim_Enum
+ *
+ * @brief   Bus reset and enumeration as a host does it, then the line
+ *          coding.
+ *
+ * @return  0 - ok
+ */
+static int Sim_Enum( uint32_t baud )
+{
+    uint8_t buf[ 256 ];
+    int len;
+
+    /* 10 ms of SE0 */
+    Sim.Usb_Flags |= USBFS_UIF_BUS_RST;
+    Sim_Irq( );
+    Sim_Wait( Sim.Now + 10000000 );
+    Sim.Host_Addr = 0;
+    memset( Sim.Out_Tog, 0, sizeof( Sim.Out_Tog ) );
+    memset( Sim.In_Tog, 0, sizeof( Sim.In_Tog ) );
+
+    len = Sim_Control( 0x80, USB_GET_DESCRIPTOR, USB_DESCR_TYP_DEVICE << 8, 0, buf, 64 );
+    if( ( len != 18 ) || memcmp( buf, MyDevDescr, 18 ) )
+    {
+        printf( "enum: device descriptor, %d bytes\n", len );
+        return -1;
+    }
+    if( Sim_Control( 0x00, USB_SET_ADDRESS, SIM_HOST_ADDR, 0, NULL, 0 ) != 0 )
+    {
+        printf( "enum: set address\n" );
+        return -1;
+    }
+    Sim.Host_Addr = SIM_HOST_ADDR;
+    len = Sim_Control( 0x80, USB_GET_DESCRIPTOR, USB_DESCR_TYP_CONFIG << 8, 0, buf, 255 );
+    if( ( len != DEF_USBD_CONFIG_DESC_LEN ) || memcmp( buf, MyCfgDescr, len ) )
+    {
+        printf( "enum: configuration descriptor, %d bytes\n", len );
+        return -1;
+    }
+    if( ( Sim_Control( 0x00, USB_SET_CONFIGURATION, 1, 0, NULL, 0 ) != 0 ) ||
+        ( Sim_Line_Coding( baud ) != 0 ) ||
+        ( Sim_Control( 0x21, CDC_SET_LINE_CTLSTE, 3, 0, NULL, 0 ) != 0 ) )
+    {
+        printf( "enum: configuration or line coding\n" );
+        return -1;
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Stream
+ *
+ * @brief   Host and peer send for ms milliseconds (0 - just drain),
+ *          then stop and let what is on the way arrive, time enough to
+ *          empty both USART2 buffers. The host reads
+ *          endpoint 3 between its endpoint 2 packets, and keeps polling
+ *          when both are NAKed.
+ *
+ * @param   pout, pin - bytes per second out of the transmitter and read
+ *          from endpoint 3 while sending
+ *
+ * @return  none
+ */
+static void Sim_Stream( uint32_t ms, uint32_t *pout, uint32_t *pin )
+{
+    uint8_t  buf[ DEF_USBFS_UEP_BUF_LEN ];
+    uint64_t start = Sim.Now, end = Sim.Now + (uint64_t)ms * 1000000, drain;
+    uint32_t peer_got = Sim.Peer_Got, host_got = Sim.Host_Got;
+    int len, i;
+
+    Sim.Out_Stop = 0xFFFFFFFF;
+    Sim_Peer_Start( 0xFFFFFFFF );
+    if( ms == 0 )
+    {
+        Sim.Out_Stop = Sim.Out_Len;
+        Sim.Peer_Stop = Sim.Peer_Sent;
+    }
+    drain = end + 50000000 + (uint64_t)( DEF_UARTx_TX_BUF_LEN + DEF_UARTx_RX_BUF_LEN ) * Sim.Byte_Ns;
+    while( Sim.Now < drain )
+    {
+        if( ( Sim.Now >= end ) && ( Sim.Out_Stop == 0xFFFFFFFF ) )
+        {
+            if( pout )
+            {
+                *pout = (uint32_t)( ( Sim.Peer_Got - peer_got ) * 1000000000ull / ( Sim.Now - start ) );
+                *pin = (uint32_t)( ( Sim.Host_Got - host_got ) * 1000000000ull / ( Sim.Now - start ) );
+            }
+            Sim.Out_Stop = Sim.Out_Len;
+            Sim.Peer_Stop = Sim.Peer_Sent;
+            drain = Sim.Now + 50000000 + (uint64_t)( DEF_UARTx_TX_BUF_LEN + DEF_UARTx_RX_BUF_LEN ) * Sim.Byte_Ns;
+        }
+
+        /* Host scheduling jitter, or the OUT token after each acknowledged
+           IN would always hit the interrupt of that IN and be NAKed */
+        Sim_Wait( Sim.Now + Sim_Rand( ) % SIM_JITTER_NS );
+
+        if( Sim.Out_Len < Sim.Out_Stop )
+        {
+            len = Sim.Gaps ? 1 + Sim_Rand( ) % DEF_USBD_ENDP2_SIZE : DEF_USBD_ENDP2_SIZE;
+            for( i = 0; i < len; i++ )
+            {
+                buf[ i ] = Sim_Pat( Sim.Out_Len + i, 0x5A );
+            }
+            if( Sim_Out( DEF_UEP2, buf, len ) == SIM_ACK )
+            {
+                Sim.Out_Len += len;
+            }
+        }
+
+        if( Sim_In( DEF_UEP3, buf, &len ) == SIM_ACK )
+        {
+            for( i = 0; i < len; i++ )
+            {
+                if( buf[ i ] != Sim_Pat( Sim.Host_Got, 0xA5 ) )
+                {
+                    Sim_Fail( "host: wrong byte from endpoint 3", Sim.Host_Got, buf[ i ] );
+                }
+                Sim.Host_Got++;
+            }
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Check
+ *
+ * @brief   Everything sent has arrived, once.
+ *
+ * @return  0 - ok
+ */
+static int Sim_Check( void )
+{
+    if( Sim.Peer_Got != Sim.Out_Len )
+    {
+        Sim_Fail( "peer: bytes out of the transmitter, sent by the host", Sim.Peer_Got, Sim.Out_Len );
+    }
+    if( Sim.Host_Got != Sim.Peer_Sent )
+    {
+        Sim_Fail( "host: bytes read, sent by the peer", Sim.Host_Got, Sim.Peer_Sent );
+    }
+    if( UARTx_Rx_Overrun || Sim.Line_Lost )
+    {
+        Sim_Fail( "device: receive overrun, bytes lost with the DMA off", UARTx_Rx_Overrun, Sim.Line_Lost );
+    }
+    return Sim.Errors ? -1 : 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Start
+ *
+ * @brief   Power up the example as main.c does, and enumerate it.
+ *
+ * @return  0 - ok
+ */
+static int Sim_Start( const SIM_OPT *popt )
+{
+    memset( &Sim, 0, sizeof( Sim ) );
+    Sim.Seed = 1;
+    Sim.Gaps = popt->Gaps;
+    Sim.Tick = SIM_TICK_NS;
+
+    RCC_Configuration( );
+    USBFS_Class_Register( &CDC_Class_Drv );
+    USBFS_RCC_Init( );
+    USBFS_Device_Init( ENABLE, PWR_VDD_5V );
+    Sim_Wait( 2 * SIM_TICK_NS );
+    return Sim_Enum( popt->Baud );
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Run
+ *
+ * @brief   The self-test cases, run in a child process each so that the
+ *          example starts from its initial globals.
+ *
+ * @return  0 - passed
+ */
+static int Sim_Test_Run( int n )
+{
+    SIM_OPT  opt = { 3000000, 200, 0 };
+    uint32_t out, in, min;
+
+    switch( n )
+    {
+        case 0:
+            /* Both ways at the line rate, which is well under the bus rate */
+            if( Sim_Start( &opt ) )
+            {
+                return -1;
+            }
+            Sim_Stream( opt.Run_Ms, &out, &in );
+            min = opt.Baud / 10 * 97 / 100;
+            if( ( out < min ) || ( in < min ) )
+            {
+                Sim_Fail( "bytes/s below 97% of the line rate", out, in );
+            }
+            break;
+
+        case 1:
+            /* Partial packets flushed on idle, short OUT packets */
+            opt.Baud = 1000000;
+            opt.Gaps = 1;
+            if( Sim_Start( &opt ) )
+            {
+                return -1;
+            }
+            Sim_Stream( opt.Run_Ms, &out, &in );
+            break;
+
+        case 2:
+            /* OUT packets straight behind SET_LINE_CODING, before the main
+               loop has re-initialized USART2 */
+            opt.Baud = 1000000;
+            if( Sim_Start( &opt ) )
+            {
+                return -1;
+            }
+            Sim_Stream( 50, &out, &in );
+            if( Sim_Line_Coding( 3000000 ) )
+            {
+                Sim_Fail( "host: SET_LINE_CODING", 0, 0 );
+            }
+            Sim_Stream( 50, &out, &in );
+            if( Sim.Byte_Ns != 1000000000 / 300000 )
+            {
+                Sim_Fail( "device: byte time after SET_LINE_CODING, ns", Sim.Byte_Ns, 0 );
+            }
+            break;
+
+        default:
+            /* Bus reset and enumeration again, data flows again after it */
+            if( Sim_Start( &opt ) )
+            {
+                return -1;
+            }
+            Sim_Stream( 50, &out, &in );
+            if( Sim_Enum( opt.Baud ) )
+            {
+                Sim_Fail( "host: second enumeration", 0, 0 );
+            }
+            Sim_Stream( 50, &out, &in );
+            break;
+    }
+    printf( "  %u bytes to the line, %u bytes to the host, %u NAKs\n", Sim.Peer_Got, Sim.Host_Got, Sim.Naks );
+    return Sim_Check( );
+}
+
+/*********************************************************************
+ * @fn      Sim_Self_Test
+ *
+ * @brief   Run every self-test case.
+ *
+ * @return  number of failed cases
+ */
+static int Sim_Self_Test( void )
+{
+    static const char *pname[ ] =
+    {
+        "3 Mbps both ways",
+        "bursts, idle flush, short packets",
+        "data behind SET_LINE_CODING",
+        "bus reset while configured",
+    };
+    pid_t pid;
+    int i, st, fail = 0;
+
+    for( i = 0; i < 4; i++ )
+    {
+        printf( "%s\n", pname[ i ] );
+        fflush( stdout );
+        pid = fork( );
+        if( pid == 0 )
+        {
+            st = Sim_Test_Run( i );
+            fflush( stdout );
+            _exit( st ? 1 : 0 );
+        }
+        if( ( pid < 0 ) || ( waitpid( pid, &st, 0 ) != pid ) || !WIFEXITED( st ) || WEXITSTATUS( st ) )
+        {
+            printf( "  FAIL\n" );
+            fail++;
+        }
+        else
+        {
+            printf( "  ok\n" );
+        }
+    }
+    printf( "%s\n", fail ? "self-test FAILED" : "self-test passed" );
+    return fail;
+}
+
+int main( int argc, char **argv )
+{
+    SIM_OPT  opt = { 3000000, 1000, 0 };
+    uint32_t out = 0, in = 0;
+    int c;
+
+    while( ( c = getopt( argc, argv, "b:T:gt" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 'b':
+                opt.Baud = strtoul( optarg, NULL, 0 );
+                break;
+            case 'T':
+                opt.Run_Ms = strtoul( optarg, NULL, 0 );
+                break;
+            case 'g':
+                opt.Gaps = 1;
+                break;
+            case 't':
+                return Sim_Self_Test( ) ? 1 : 0;
+            default:
+                fprintf( stderr, "usage: %s [-b baud] [-T ms] [-g] | -t\n", argv[ 0 ] );
+                return 1;
+        }
+    }
+    if( ( opt.Baud == 0 ) || Sim_Start( &opt ) )
+    {
+        return 1;
+    }
+    Sim_Stream( opt.Run_Ms, &out, &in );
+    printf( "line %u B/s, USB to line %u B/s, line to USB %u B/s\n", opt.Baud / 10, out, in );
+    printf( "%u bytes to the line, %u bytes to the host, %u NAKs, %u errors\n",
+            Sim.Peer_Got, Sim.Host_Got, Sim.Naks, Sim.Errors );
+    return Sim_Check( ) ? 1 : 0;
+}
@@ -0,0 +1,1400 @@
+/********************************** (C) COPYRIGHT *******************************
+* File Name          : ch643_usbfs_device.c
+* Author             : WCH
+* Version            : V1.1.0
+* Date               : 2026/10/19
+* Description        : This file provides the shared USBFS device core: standard
+*                      requests, class-driver dispatch, per-endpoint transmit
+*                      queues and double-buffered endpoint 1/2/3.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include <ch643_usbfs_device.h>
+
+/*******************************************************************************/
+/* Variable Definition */
+/* Global */
+const    uint8_t  *pUSBFS_Descr;
+
+/* Setup Request */
+volatile uint8_t  USBFS_SetupReqCode;
+volatile uint8_t  USBFS_SetupReqType;
+volatile uint16_t USBFS_SetupReqValue;
+volatile uint16_t USBFS_SetupReqIndex;
+volatile uint16_t USBFS_SetupReqLen;
+
+/* USB Device Status */
+volatile uint8_t  USBFS_DevConfig;
+volatile uint8_t  USBFS_DevAddr;
+volatile uint8_t  USBFS_DevSleepStatus;
+volatile uint8_t  USBFS_DevEnumStatus;
+
+/* Endpoint Buffer */
+__attribute__ ((aligned(4))) uint8_t USBFS_EP0_4Buf[ DEF_USBFS_UEP_BUF_LEN * 3 ];  //ep0(64)+ep4_out(64)+ep4_in(64)
+__attribute__ ((aligned(4))) uint8_t USBFS_EP1_Buf[ DEF_USBFS_UEP_DBUF_LEN ];    //ep1_out(64*2)+ep1_in(64*2)
+__attribute__ ((aligned(4))) uint8_t USBFS_EP2_Buf[ DEF_USBFS_UEP_DBUF_LEN ];    //ep2_out(64*2)+ep2_in(64*2)
+__attribute__ ((aligned(4))) uint8_t USBFS_EP3_Buf[ DEF_USBFS_UEP_DBUF_LEN ];    //ep3_out(64*2)+ep3_in(64*2)
+__attribute__ ((aligned(4))) uint8_t USBFS_EP5_Buf[ DEF_USBFS_UEP_BUF_LEN * 2 ]; //ep5_out(64)+ep5_in(64)
+__attribute__ ((aligned(4))) uint8_t USBFS_EP6_Buf[ DEF_USBFS_UEP_BUF_LEN * 2 ]; //ep6_out(64)+ep6_in(64)
+__attribute__ ((aligned(4))) uint8_t USBFS_EP7_Buf[ DEF_USBFS_UEP_BUF_LEN * 2 ]; //ep7_out(64)+ep7_in(64)
+
+/* USB IN Endpoint Busy Flag */
+volatile uint8_t  USBFS_Endp_Busy[ DEF_UEP_NUM ];
+
+/* Endpoint state */
+USBFS_ENDP_STA USBFS_Endp_Sta[ DEF_UEP_NUM ];
+
+/* Current DMA base of each endpoint, end-point 4 lives behind end-point 0 */
+uint8_t *USBFS_Endp_Base[ DEF_UEP_NUM ];
+uint8_t * const USBFS_Endp_Buf[ DEF_UEP_NUM ] =
+{
+    USBFS_EP0_4Buf,
+    USBFS_EP1_Buf,
+    USBFS_EP2_Buf,
+    USBFS_EP3_Buf,
+    &USBFS_EP0_4Buf[ DEF_USBFS_UEP_BUF_LEN ],
+    USBFS_EP5_Buf,
+    USBFS_EP6_Buf,
+    USBFS_EP7_Buf,
+};
+
+/* Class drivers */
+const USBFS_CLASS_DRV *USBFS_Class_Drv[ DEF_USBD_CLASS_MAX ];
+uint8_t USBFS_Class_Num;
+const USBFS_CLASS_DRV *USBFS_Class_Req;                                         /* Owner of the current control transfer */
+volatile uint8_t USBFS_EP0_Hold;                                                /* Status stage left to USBFS_EP0_Status_Send */
+
+/******************************************************************************/
+/* Interrupt Service Routine Declaration*/
+void USBFS_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+
+
+/*********************************************************************
+ * @fn      USBFS_Endp_Ctrl
+ *
+ * @brief   Get the control register of one endpoint.
+ *
+ * @return  pointer to UEPn_CTRL_H
+ */
+static volatile uint16_t *USBFS_Endp_Ctrl( uint8_t endp )
+{
+    switch( endp )
+    {
+        case DEF_UEP1:  return &USBFSD->UEP1_CTRL_H;
+        case DEF_UEP2:  return &USBFSD->UEP2_CTRL_H;
+        case DEF_UEP3:  return &USBFSD->UEP3_CTRL_H;
+        case DEF_UEP4:  return &USBFSD->UEP4_CTRL_H;
+        case DEF_UEP5:  return &USBFSD->UEP5_CTRL_H;
+        case DEF_UEP6:  return &USBFSD->UEP6_CTRL_H;
+        case DEF_UEP7:  return &USBFSD->UEP7_CTRL_H;
+        default:        return &USBFSD->UEP0_CTRL_H;
+    }
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_TxLen
+ *
+ * @brief   Get the transmit length register of one endpoint.
+ *
+ * @return  pointer to UEPn_TX_LEN
+ */
+static volatile uint16_t *USBFS_Endp_TxLen( uint8_t endp )
+{
+    switch( endp )
+    {
+        case DEF_UEP1:  return &USBFSD->UEP1_TX_LEN;
+        case DEF_UEP2:  return &USBFSD->UEP2_TX_LEN;
+        case DEF_UEP3:  return &USBFSD->UEP3_TX_LEN;
+        case DEF_UEP4:  return &USBFSD->UEP4_TX_LEN;
+        case DEF_UEP5:  return &USBFSD->UEP5_TX_LEN;
+        case DEF_UEP6:  return &USBFSD->UEP6_TX_LEN;
+        case DEF_UEP7:  return &USBFSD->UEP7_TX_LEN;
+        default:        return &USBFSD->UEP0_TX_LEN;
+    }
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_Dma
+ *
+ * @brief   Get the DMA address register of one endpoint.
+ *
+ * @return  pointer to UEPn_DMA
+ */
+static volatile uint32_t *USBFS_Endp_Dma( uint8_t endp )
+{
+    switch( endp )
+    {
+        case DEF_UEP1:  return &USBFSD->UEP1_DMA;
+        case DEF_UEP2:  return &USBFSD->UEP2_DMA;
+        case DEF_UEP3:  return &USBFSD->UEP3_DMA;
+        case DEF_UEP5:  return &USBFSD->UEP5_DMA;
+        case DEF_UEP6:  return &USBFSD->UEP6_DMA;
+        case DEF_UEP7:  return &USBFSD->UEP7_DMA;
+        default:        return &USBFSD->UEP0_DMA;
+    }
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_Mod_Set
+ *
+ * @brief   Write the USBFSD_UEP_xx mode bits of one endpoint into
+ *          UEP4_1_MOD/UEP2_3_MOD/UEP567_MOD.
+ *
+ * @return  none
+ */
+static void USBFS_Endp_Mod_Set( uint8_t endp, uint8_t mod )
+{
+    switch( endp )
+    {
+        case DEF_UEP1:
+            USBFSD->UEP4_1_MOD = ( USBFSD->UEP4_1_MOD & 0x0F ) | (uint8_t)( mod << 4 );
+            break;
+        case DEF_UEP4:
+            USBFSD->UEP4_1_MOD = ( USBFSD->UEP4_1_MOD & 0xF0 ) | ( mod & 0x0C );
+            break;
+        case DEF_UEP2:
+            USBFSD->UEP2_3_MOD = ( USBFSD->UEP2_3_MOD & 0xF0 ) | mod;
+            break;
+        case DEF_UEP3:
+            USBFSD->UEP2_3_MOD = ( USBFSD->UEP2_3_MOD & 0x0F ) | (uint8_t)( mod << 4 );
+            break;
+        case DEF_UEP5:
+            USBFSD->UEP567_MOD = ( USBFSD->UEP567_MOD & ~0x03 ) | ( ( mod & 0x0C ) >> 2 );
+            break;
+        case DEF_UEP6:
+            USBFSD->UEP567_MOD = ( USBFSD->UEP567_MOD & ~0x0C ) | ( mod & 0x0C );
+            break;
+        case DEF_UEP7:
+            USBFSD->UEP567_MOD = ( USBFSD->UEP567_MOD & ~0x30 ) | ( ( mod & 0x0C ) << 2 );
+            break;
+        default:
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_TxAddr
+ *
+ * @brief   Address of one transmit buffer half. Receive halves come
+ *          first in the endpoint buffer, as laid out by the hardware.
+ *
+ * @return  buffer address
+ */
+static uint8_t *USBFS_Endp_TxAddr( uint8_t endp, uint8_t half )
+{
+    uint16_t offset = 0;
+
+    if( USBFS_Endp_Sta[ endp ].Mod & USBFSD_UEP_RX_EN )
+    {
+        offset = ( USBFS_Endp_Sta[ endp ].Mod & USBFSD_UEP_BUF_MOD ) ? ( DEF_USBFS_UEP_BUF_LEN * 2 ) : DEF_USBFS_UEP_BUF_LEN;
+    }
+    return &USBFS_Endp_Buf[ endp ][ offset + half * DEF_USBFS_UEP_BUF_LEN ];
+}
+
+/*********************************************************************
+ * @fn      USBFS_Class_Endp
+ *
+ * @brief   Find the class driver owning one endpoint.
+ *
+ * @return  class driver, NULL if none
+ */
+static const USBFS_CLASS_DRV *USBFS_Class_Endp( uint8_t endp )
+{
+    uint8_t i;
+
+    for( i = 0; i < USBFS_Class_Num; i++ )
+    {
+        if( USBFS_Class_Drv[ i ]->Endp_Mask & ( 1 << endp ) )
+        {
+            return USBFS_Class_Drv[ i ];
+        }
+    }
+    return NULL;
+}
+
+/*********************************************************************
+ * @fn      USBFS_Class_Setup
+ *
+ * @brief   Pass the current setup request to the class drivers.
+ *          Interface and endpoint requests go to their owner, device
+ *          requests to each driver in turn until one accepts it.
+ *
+ * @return  DEF_USBD_REQ_OK or DEF_USBD_REQ_ERR
+ */
+static uint8_t USBFS_Class_Setup( uint16_t *plen )
+{
+    const USBFS_CLASS_DRV *pdrv;
+    uint8_t i, itf;
+
+    for( i = 0; i < USBFS_Class_Num; i++ )
+    {
+        pdrv = USBFS_Class_Drv[ i ];
+        if( pdrv->Setup == NULL )
+        {
+            continue;
+        }
+        if( ( USBFS_SetupReqType & USB_REQ_RECIP_MASK ) == USB_REQ_RECIP_INTERF )
+        {
+            itf = (uint8_t)( USBFS_SetupReqIndex & 0xFF );
+            if( ( itf < pdrv->Itf_First ) || ( itf >= ( pdrv->Itf_First + pdrv->Itf_Num ) ) )
+            {
+                continue;
+            }
+        }
+        else if( ( USBFS_SetupReqType & USB_REQ_RECIP_MASK ) == USB_REQ_RECIP_ENDP )
+        {
+            if( ( pdrv->Endp_Mask & ( 1 << ( USBFS_SetupReqIndex & 0x0F ) ) ) == 0 )
+            {
+                continue;
+            }
+        }
+        if( pdrv->Setup( &pUSBFS_Descr, plen ) == DEF_USBD_REQ_OK )
+        {
+            USBFS_Class_Req = pdrv;
+            return DEF_USBD_REQ_OK;
+        }
+    }
+    return DEF_USBD_REQ_ERR;
+}
+
+/*********************************************************************
+ * @fn      USBFS_Class_Register
+ *
+ * @brief   Register one class driver, call before USBFS_Device_Init.
+ *
+ * @return  0 - success, 1 - no room left
+ */
+uint8_t USBFS_Class_Register( const USBFS_CLASS_DRV *pdrv )
+{
+    if( USBFS_Class_Num >= DEF_USBD_CLASS_MAX )
+    {
+        return 1;
+    }
+    USBFS_Class_Drv[ USBFS_Class_Num++ ] = pdrv;
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      USBFS_Class_Sleep
+ *
+ * @brief   Pass a sleep event to every class driver with a Sleep hook.
+ *
+ * @param   evt - DEF_USBD_SLEEP_xx
+ *
+ * @return  1 if any driver returned 1, else 0
+ */
+static uint8_t USBFS_Class_Sleep( uint8_t evt )
+{
+    uint8_t i;
+    uint8_t ret = 0;
+
+    for( i = 0; i < USBFS_Class_Num; i++ )
+    {
+        if( USBFS_Class_Drv[ i ]->Sleep && USBFS_Class_Drv[ i ]->Sleep( evt ) )
+        {
+            ret = 1;
+        }
+    }
+    return ret;
+}
+
+/*********************************************************************
+ * @fn      USBFS_RCC_Init
+ *
+ * @brief   Initializes the USBFS clock configuration.
+ *
+ * @return  none
+ */
+void USBFS_RCC_Init(void)
+{
+    RCC_APB2PeriphClockCmd( RCC_APB2Periph_AFIO, ENABLE );
+    RCC_AHBPeriphClockCmd( RCC_AHBPeriph_USBFS, ENABLE );
+}
+
+/*********************************************************************
+ * @fn      USBFS_Device_Endp_Init
+ *
+ * @brief   Initializes USB device endpoints. Closes every endpoint,
+ *          then lets the class drivers open theirs.
+ *
+ * @return  none
+ */
+void USBFS_Device_Endp_Init( void )
+{
+    uint8_t i;
+
+    USBFSD->UEP4_1_MOD = 0;
+    USBFSD->UEP2_3_MOD = 0;
+    USBFSD->UEP567_MOD = 0;
+
+    USBFSD->UEP0_DMA = (uint32_t)USBFS_EP0_4Buf;
+    USBFSD->UEP0_CTRL_H = USBFS_UEP_R_RES_ACK | USBFS_UEP_T_RES_NAK;
+
+    /* Clear End-points Busy Status */
+    for( i = 0; i < DEF_UEP_NUM; i++ )
+    {
+        memset( &USBFS_Endp_Sta[ i ], 0, sizeof( USBFS_ENDP_STA ) );
+        USBFS_Endp_Base[ i ] = USBFS_Endp_Buf[ i ];
+        USBFS_Endp_Busy[ i ] = 0;
+    }
+
+    for( i = 0; i < USBFS_Class_Num; i++ )
+    {
+        if( USBFS_Class_Drv[ i ]->Init )
+        {
+            USBFS_Class_Drv[ i ]->Init( );
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_Open
+ *
+ * @brief   Enable one endpoint.
+ *
+ * @param   endp - endpoint number 1-7
+ *          mod - USBFSD_UEP_RX_EN/USBFSD_UEP_TX_EN, plus USBFSD_UEP_BUF_MOD
+ *                for double buffering on end-point 1/2/3
+ *          pack_size - max packet size, 64 at most
+ *
+ * @return  0 - success, 1 - not supported
+ */
+uint8_t USBFS_Endp_Open( uint8_t endp, uint8_t mod, uint8_t pack_size )
+{
+    USBFS_ENDP_STA *p;
+
+    if( ( endp < DEF_UEP1 ) || ( endp > DEF_UEP7 ) )
+    {
+        return 1;
+    }
+    if( ( mod & USBFSD_UEP_BUF_MOD ) && ( endp > DEF_UEP3 ) )
+    {
+        return 1;
+    }
+
+    p = &USBFS_Endp_Sta[ endp ];
+    memset( p, 0, sizeof( USBFS_ENDP_STA ) );
+    p->Mod = mod;
+    p->Pack_Size = ( ( pack_size == 0 ) || ( pack_size > DEF_USBFS_UEP_BUF_LEN ) ) ? DEF_USBFS_UEP_BUF_LEN : pack_size;
+    USBFS_Endp_Base[ endp ] = USBFS_Endp_Buf[ endp ];
+    USBFS_Endp_Busy[ endp ] = 0;
+
+    if( endp != DEF_UEP4 )
+    {
+        *USBFS_Endp_Dma( endp ) = (uint32_t)USBFS_Endp_Base[ endp ];
+    }
+    *USBFS_Endp_TxLen( endp ) = 0;
+    *USBFS_Endp_Ctrl( endp ) = ( ( mod & USBFSD_UEP_RX_EN ) ? USBFS_UEP_R_RES_ACK : USBFS_UEP_R_RES_NAK ) | USBFS_UEP_T_RES_NAK;
+    USBFS_Endp_Mod_Set( endp, mod );
+
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_RxAck
+ *
+ * @brief   ACK the OUT endpoint if the half the hardware fills next is
+ *          free, otherwise NAK until the class driver releases it.
+ *
+ * @return  none
+ */
+static void USBFS_Endp_RxAck( uint8_t endp )
+{
+    USBFS_ENDP_STA *p = &USBFS_Endp_Sta[ endp ];
+    volatile uint16_t *ctrl = USBFS_Endp_Ctrl( endp );
+    uint8_t full;
+
+    if( p->Halt & 0x01 )
+    {
+        return;
+    }
+    full = ( p->Rx_Pend >= 2 ) || ( ( p->Rx_Pend == 1 ) && ( p->Rx_First == p->Rx_Half ) );
+    *ctrl = ( *ctrl & ~USBFS_UEP_R_RES_MASK ) | ( full ? USBFS_UEP_R_RES_NAK : USBFS_UEP_R_RES_ACK );
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_RxBuf
+ *
+ * @brief   Oldest received packet not yet released by USBFS_Endp_RxDone.
+ *
+ * @return  buffer address
+ */
+uint8_t *USBFS_Endp_RxBuf( uint8_t endp )
+{
+    return USBFS_Endp_Base[ endp ] + USBFS_Endp_Sta[ endp ].Rx_First * DEF_USBFS_UEP_BUF_LEN;
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_RxBuf_Set
+ *
+ * @brief   Receive straight into a caller's buffer (zero-copy), OUT-only
+ *          endpoint 1/2/3/5/6/7. 128 bytes are needed if double-buffered.
+ *
+ * @return  0 - success, 1 - not supported
+ */
+uint8_t USBFS_Endp_RxBuf_Set( uint8_t endp, uint8_t *pbuf )
+{
+    if( ( endp == DEF_UEP4 ) || ( ( USBFS_Endp_Sta[ endp ].Mod & ~USBFSD_UEP_BUF_MOD ) != USBFSD_UEP_RX_EN ) )
+    {
+        return 1;
+    }
+    USBFS_Endp_Base[ endp ] = pbuf;
+    *USBFS_Endp_Dma( endp ) = (uint32_t)pbuf;
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_RxDone
+ *
+ * @brief   Release the oldest received packet of one OUT endpoint.
+ *
+ * @return  none
+ */
+void USBFS_Endp_RxDone( uint8_t endp )
+{
+    USBFS_ENDP_STA *p = &USBFS_Endp_Sta[ endp ];
+
+    NVIC_DisableIRQ( USBFS_IRQn );
+    if( p->Rx_Pend )
+    {
+        p->Rx_Pend--;
+        if( p->Mod & USBFSD_UEP_BUF_MOD )
+        {
+            p->Rx_First ^= 1;
+        }
+    }
+    USBFS_Endp_RxAck( endp );
+    NVIC_EnableIRQ( USBFS_IRQn );
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_RxDeal
+ *
+ * @brief   OUT packet received on one endpoint, hand it to its class
+ *          driver. With double buffering the other half is ACKed
+ *          straight away, so the host can send on while it is handled.
+ *
+ * @return  none
+ */
+static void USBFS_Endp_RxDeal( uint8_t endp, uint16_t len )
+{
+    USBFS_ENDP_STA *p = &USBFS_Endp_Sta[ endp ];
+    const USBFS_CLASS_DRV *pdrv;
+    uint8_t half;
+
+    half = p->Rx_Half;
+    *USBFS_Endp_Ctrl( endp ) ^= USBFS_UEP_R_TOG;
+    if( p->Rx_Pend == 0 )
+    {
+        p->Rx_First = half;
+    }
+    p->Rx_Pend++;
+    if( p->Mod & USBFSD_UEP_BUF_MOD )
+    {
+        p->Rx_Half ^= 1;
+    }
+    USBFS_Endp_RxAck( endp );
+
+    pdrv = USBFS_Class_Endp( endp );
+    if( pdrv && pdrv->Out )
+    {
+        pdrv->Out( endp, USBFS_Endp_Base[ endp ] + half * DEF_USBFS_UEP_BUF_LEN, len );
+    }
+    else
+    {
+        USBFS_Endp_RxDone( endp );
+    }
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_TxLoad
+ *
+ * @brief   Move queued data into every free transmit half of one
+ *          endpoint, and start the endpoint if it was idle.
+ *          Call with the USBFS interrupt masked.
+ *
+ * @return  none
+ */
+static void USBFS_Endp_TxLoad( uint8_t endp )
+{
+    USBFS_ENDP_STA *p = &USBFS_Endp_Sta[ endp ];
+    USBFS_TX_REQ   *preq;
+    volatile uint16_t *ctrl = USBFS_Endp_Ctrl( endp );
+    uint8_t  halves, half;
+    uint16_t len;
+
+    halves = ( p->Mod & USBFSD_UEP_BUF_MOD ) ? 2 : 1;
+    while( p->Ld_Pend && ( p->Hw_Cnt < halves ) )
+    {
+        preq = &p->Tx_Q[ p->Ld_Idx ];
+        half = ( p->Hw_Half + p->Hw_Cnt ) & ( halves - 1 );
+        len = preq->Len - p->Ld_Off;
+        if( len > p->Pack_Size )
+        {
+            len = p->Pack_Size;
+        }
+
+        if( preq->Flag & DEF_UEP_TX_DMA )
+        {
+            /* zero-copy, point the DMA at the caller's data */
+            *USBFS_Endp_Dma( endp ) = (uint32_t)( preq->pBuf + p->Ld_Off );
+        }
+        else
+        {
+            if( endp != DEF_UEP4 )
+            {
+                *USBFS_Endp_Dma( endp ) = (uint32_t)USBFS_Endp_Base[ endp ];
+            }
+            memcpy( USBFS_Endp_TxAddr( endp, half ), preq->pBuf + p->Ld_Off, len );
+        }
+        p->Ld_Off += len;
+        p->Hw_Len[ half ] = len;
+        p->Hw_End[ half ] = ( p->Ld_Off >= preq->Len ) && ( ( len < p->Pack_Size ) || !( preq->Flag & DEF_UEP_TX_ZLP ) );
+        if( p->Hw_End[ half ] )
+        {
+            p->Ld_Idx = ( p->Ld_Idx + 1 ) % DEF_USBD_TXQ_DEPTH;
+            p->Ld_Off = 0;
+            p->Ld_Pend--;
+        }
+
+        p->Hw_Cnt++;
+        if( ( p->Hw_Cnt == 1 ) && !( p->Halt & 0x02 ) )
+        {
+            *USBFS_Endp_TxLen( endp ) = len;
+            *ctrl = ( *ctrl & ~USBFS_UEP_T_RES_MASK ) | USBFS_UEP_T_RES_ACK;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_TxDeal
+ *
+ * @brief   IN packet sent on one endpoint. Arm the already loaded half
+ *          if any, refill from the queue and tell the class driver
+ *          when a whole queued transfer is done.
+ *
+ * @return  none
+ */
+static void USBFS_Endp_TxDeal( uint8_t endp )
+{
+    USBFS_ENDP_STA *p = &USBFS_Endp_Sta[ endp ];
+    volatile uint16_t *ctrl = USBFS_Endp_Ctrl( endp );
+    const USBFS_CLASS_DRV *pdrv;
+    uint8_t halves, end;
+
+    *ctrl ^= USBFS_UEP_T_TOG;
+    if( p->Hw_Cnt == 0 )
+    {
+        *ctrl = ( *ctrl & ~USBFS_UEP_T_RES_MASK ) | USBFS_UEP_T_RES_NAK;
+        return;
+    }
+
+    halves = ( p->Mod & USBFSD_UEP_BUF_MOD ) ? 2 : 1;
+    end = p->Hw_End[ p->Hw_Half ];
+    p->Hw_Cnt--;
+    p->Hw_Half = ( p->Hw_Half + 1 ) & ( halves - 1 );
+    if( p->Hw_Cnt )
+    {
+        *USBFS_Endp_TxLen( endp ) = p->Hw_Len[ p->Hw_Half ];
+    }
+    else
+    {
+        *ctrl = ( *ctrl & ~USBFS_UEP_T_RES_MASK ) | USBFS_UEP_T_RES_NAK;
+    }
+    if( end )
+    {
+        p->Tx_Head = ( p->Tx_Head + 1 ) % DEF_USBD_TXQ_DEPTH;
+        p->Tx_Cnt--;
+    }
+    USBFS_Endp_TxLoad( endp );
+    USBFS_Endp_Busy[ endp ] = ( p->Tx_Cnt != 0 );
+
+    if( end )
+    {
+        pdrv = USBFS_Class_Endp( endp );
+        if( pdrv && pdrv->In )
+        {
+            pdrv->In( endp );
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_Transmit
+ *
+ * @brief   Queue one IN transfer of any length, sent in packets of the
+ *          endpoint's max packet size. The data must stay valid until
+ *          the class driver's In callback for it.
+ *
+ * @param   flag - DEF_UEP_TX_ZLP, DEF_UEP_TX_DMA
+ *
+ * @return  0 - queued, 1 - queue full or not supported
+ */
+uint8_t USBFS_Endp_Transmit( uint8_t endp, const uint8_t *pbuf, uint16_t len, uint8_t flag )
+{
+    USBFS_ENDP_STA *p = &USBFS_Endp_Sta[ endp ];
+    USBFS_TX_REQ   *preq;
+
+    if( ( endp < DEF_UEP1 ) || ( endp > DEF_UEP7 ) || !( p->Mod & USBFSD_UEP_TX_EN ) )
+    {
+        return 1;
+    }
+    if( ( flag & DEF_UEP_TX_DMA ) && ( ( endp == DEF_UEP4 ) || ( p->Mod != USBFSD_UEP_TX_EN ) ) )
+    {
+        return 1;
+    }
+
+    NVIC_DisableIRQ( USBFS_IRQn );
+    if( p->Tx_Cnt >= DEF_USBD_TXQ_DEPTH )
+    {
+        NVIC_EnableIRQ( USBFS_IRQn );
+        return 1;
+    }
+    preq = &p->Tx_Q[ ( p->Tx_Head + p->Tx_Cnt ) % DEF_USBD_TXQ_DEPTH ];
+    preq->pBuf = pbuf;
+    preq->Len = len;
+    preq->Flag = flag;
+    p->Tx_Cnt++;
+    p->Ld_Pend++;
+    USBFS_Endp_Busy[ endp ] = 0x01;
+    USBFS_Endp_TxLoad( endp );
+    NVIC_EnableIRQ( USBFS_IRQn );
+
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_TxFree
+ *
+ * @brief   Free entries in the transmit queue of one endpoint.
+ *
+ * @return  number of free entries
+ */
+uint8_t USBFS_Endp_TxFree( uint8_t endp )
+{
+    return DEF_USBD_TXQ_DEPTH - USBFS_Endp_Sta[ endp ].Tx_Cnt;
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_Halt
+ *
+ * @brief   Set or clear the halt feature of one endpoint. Clearing it
+ *          resets the data toggle, and an IN endpoint restarts its
+ *          oldest queued transfer.
+ *
+ * @param   endp - endpoint address, DEF_UEP_IN | n or DEF_UEP_OUT | n
+ *
+ * @return  0 - success, 1 - endpoint not open
+ */
+uint8_t USBFS_Endp_Halt( uint8_t endp, uint8_t sta )
+{
+    uint8_t num = endp & 0x0F;
+    USBFS_ENDP_STA *p = &USBFS_Endp_Sta[ num ];
+    volatile uint16_t *ctrl = USBFS_Endp_Ctrl( num );
+
+    if( ( num < DEF_UEP1 ) || ( num > DEF_UEP7 ) )
+    {
+        return 1;
+    }
+    if( !( p->Mod & ( ( endp & DEF_UEP_IN ) ? USBFSD_UEP_TX_EN : USBFSD_UEP_RX_EN ) ) )
+    {
+        return 1;
+    }
+
+    NVIC_DisableIRQ( USBFS_IRQn );
+    if( endp & DEF_UEP_IN )
+    {
+        if( sta )
+        {
+            p->Halt |= 0x02;
+            *ctrl = ( *ctrl & ~USBFS_UEP_T_RES_MASK ) | USBFS_UEP_T_RES_STALL;
+        }
+        else
+        {
+            p->Halt &= ~0x02;
+            p->Hw_Cnt = 0;
+            p->Hw_Half = 0;
+            p->Ld_Idx = p->Tx_Head;
+            p->Ld_Off = 0;
+            p->Ld_Pend = p->Tx_Cnt;
+            *ctrl = ( *ctrl & ~( USBFS_UEP_T_TOG | USBFS_UEP_T_RES_MASK ) ) | USBFS_UEP_T_RES_NAK;
+            USBFS_Endp_TxLoad( num );
+        }
+    }
+    else
+    {
+        if( sta )
+        {
+            p->Halt |= 0x01;
+            *ctrl = ( *ctrl & ~USBFS_UEP_R_RES_MASK ) | USBFS_UEP_R_RES_STALL;
+        }
+        else
+        {
+            p->Halt &= ~0x01;
+            p->Rx_Half = 0;
+            *ctrl &= ~USBFS_UEP_R_TOG;
+            USBFS_Endp_RxAck( num );
+        }
+    }
+    NVIC_EnableIRQ( USBFS_IRQn );
+
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      GPIO_USB_INIT
+ *
+ * @brief   Initializes USB GPIO.
+ *
+ * @return  none
+ */
+void GPIO_USB_INIT(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure = {0};
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOC, ENABLE);
+#if DEF_USBD_LOW_SPEED
+    /* Low speed idles with UDM high */
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_17;
+#else
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_16;
+#endif
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
+    GPIO_Init(GPIOC, &GPIO_InitStructure);
+
+#if DEF_USBD_LOW_SPEED
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_16;
+#else
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_17;
+#endif
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IPU;
+    GPIO_Init(GPIOC, &GPIO_InitStructure);
+}
+
+/*********************************************************************
+ * @fn      USBFS_Device_Init
+ *
+ * @brief   Initializes USB device.
+ *
+ * @return  none
+ */
+void USBFS_Device_Init( FunctionalState sta , PWR_VDD VDD_Voltage)
+{
+    EXTI_InitTypeDef EXTI_InitStructure = { 0 };
+    uint8_t i;
+
+    if( sta )
+    {
+        GPIO_USB_INIT();
+        if( VDD_Voltage == PWR_VDD_5V )
+        {
+            AFIO->CTLR = (AFIO->CTLR & ~(UDP_PUE_MASK | UDM_PUE_MASK | USB_PHY_V33)) | DEF_USBD_PUE_10K | USB_IOEN;
+        }
+        else
+        {
+            AFIO->CTLR = (AFIO->CTLR & ~(UDP_PUE_MASK | UDM_PUE_MASK )) | USB_PHY_V33 | DEF_USBD_PUE_1K5 | USB_IOEN;
+        }
+
+        /* Bus activity wakes the chip from Stop mode, see USBFS_Device_Sleep */
+        EXTI_InitStructure.EXTI_Line = EXTI_Line28;
+        EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Event;
+        EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising;
+        EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+        EXTI_Init( &EXTI_InitStructure );
+
+        USBFSD->BASE_CTRL = 0x00;
+        USBFS_Device_Endp_Init( );
+        USBFSD->DEV_ADDR = 0x00;
+        USBFSD->BASE_CTRL = USBFS_UC_DEV_PU_EN | USBFS_UC_INT_BUSY | USBFS_UC_DMA_EN | DEF_USBD_UC_SPEED;
+        USBFSD->INT_FG = 0xff;
+        USBFSD->UDEV_CTRL = USBFS_UD_PD_DIS | USBFS_UD_PORT_EN | DEF_USBD_UD_SPEED;
+        USBFSD->INT_EN = USBFS_UIE_SUSPEND | USBFS_UIE_BUS_RST | USBFS_UIE_TRANSFER;
+        for( i = 0; i < USBFS_Class_Num; i++ )
+        {
+            if( USBFS_Class_Drv[ i ]->SOF )
+            {
+                USBFSD->INT_EN |= USBFS_UIE_DEV_SOF;
+            }
+        }
+        NVIC_EnableIRQ( USBFS_IRQn );
+    }
+    else
+    {
+        AFIO->CTLR = AFIO->CTLR & ~(UDP_PUE_MASK | UDM_PUE_MASK | USB_IOEN);
+        USBFSD->BASE_CTRL = USBFS_UC_RESET_SIE | USBFS_UC_CLR_ALL;
+        Delay_Us( 10 );
+        USBFSD->BASE_CTRL = 0x00;
+        NVIC_DisableIRQ( USBFS_IRQn );
+    }
+}
+
+/*********************************************************************
+ * @fn      USBFS_Endp_DataUp
+ *
+ * @brief   USBFS device data upload, one packet copied (or pointed to
+ *          with DEF_UEP_DMA_LOAD) into a free transmit half.
+ *
+ * @return  0 - success, 1 - endpoint busy
+ */
+uint8_t USBFS_Endp_DataUp(uint8_t endp, uint8_t *pbuf, uint16_t len, uint8_t mod)
+{
+    USBFS_ENDP_STA *p = &USBFS_Endp_Sta[ endp ];
+    uint8_t halves, flag;
+
+    if( ( endp < DEF_UEP1 ) || ( endp > DEF_UEP7 ) )
+    {
+        return 1;
+    }
+    halves = ( p->Mod & USBFSD_UEP_BUF_MOD ) ? 2 : 1;
+    if( p->Ld_Pend || ( p->Hw_Cnt >= halves ) )
+    {
+        return 1;
+    }
+    flag = 0;
+    if( ( mod == DEF_UEP_DMA_LOAD ) && ( endp != DEF_UEP4 ) && ( p->Mod == USBFSD_UEP_TX_EN ) )
+    {
+        flag = DEF_UEP_TX_DMA;
+    }
+    return USBFS_Endp_Transmit( endp, pbuf, len, flag );
+}
+
+/*********************************************************************
+ * @fn      USBFS_EP0_Status_Hold
+ *
+ * @brief   Keep NAKing the status stage of the current OUT control
+ *          transfer until USBFS_EP0_Status_Send, call from EP0_Out.
+ *
+ * @return  none
+ */
+void USBFS_EP0_Status_Hold( void )
+{
+    USBFS_EP0_Hold = 1;
+}
+
+/*********************************************************************
+ * @fn      USBFS_EP0_Status_Send
+ *
+ * @brief   ACK the status stage held by USBFS_EP0_Status_Hold.
+ *
+ * @return  none
+ */
+void USBFS_EP0_Status_Send( void )
+{
+    NVIC_DisableIRQ( USBFS_IRQn );
+    if( USBFS_EP0_Hold )
+    {
+        USBFS_EP0_Hold = 0;
+        if( USBFS_SetupReqLen == 0 )
+        {
+            USBFSD->UEP0_TX_LEN  = 0;
+            USBFSD->UEP0_CTRL_H = (USBFSD->UEP0_CTRL_H & ~USBFS_UEP_T_RES_MASK) | USBFS_UEP_T_TOG | USBFS_UEP_T_RES_ACK;
+        }
+    }
+    NVIC_EnableIRQ( USBFS_IRQn );
+}
+
+/*********************************************************************
+ * @fn      USBFS_IRQHandler
+ *
+ * @brief   This function handles HD-FS exception.
+ *
+ * @return  none
+ */
+void USBFS_IRQHandler( void )
+{
+    uint8_t  intflag, intst, errflag, endp, i;
+    uint16_t len;
+
+    intflag = USBFSD->INT_FG;
+    intst   = USBFSD->INT_ST;
+
+    if( intflag & USBFS_UIF_TRANSFER )
+    {
+        endp = intst & USBFS_UIS_ENDP_MASK;
+        switch (intst & USBFS_UIS_TOKEN_MASK)
+        {
+            /* data-in stage processing */
+            case USBFS_UIS_TOKEN_IN:
+                if( endp == DEF_UEP0 )
+                {
+                    /* end-point 0 data in interrupt */
+                    if( USBFS_SetupReqLen == 0 )
+                    {
+                        USBFSD->UEP0_CTRL_H = (USBFSD->UEP0_CTRL_H & ~ USBFS_UEP_R_RES_MASK) | USBFS_UEP_R_TOG | USBFS_UEP_R_RES_ACK;
+                    }
+                    if( ( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) == USB_REQ_TYP_STANDARD ) && ( USBFS_SetupReqCode == USB_SET_ADDRESS ) )
+                    {
+                        USBFSD->DEV_ADDR = (USBFSD->DEV_ADDR & USBFS_UDA_GP_BIT) | USBFS_DevAddr;
+                    }
+                    else if( pUSBFS_Descr != NULL )
+                    {
+                        /* Descriptor or class data upload */
+                        len = USBFS_SetupReqLen >= DEF_USBD_UEP0_SIZE ? DEF_USBD_UEP0_SIZE : USBFS_SetupReqLen;
+                        memcpy( USBFS_EP0_4Buf, pUSBFS_Descr, len );
+                        USBFS_SetupReqLen -= len;
+                        pUSBFS_Descr += len;
+                        USBFSD->UEP0_TX_LEN   = len;
+                        USBFSD->UEP0_CTRL_H ^= USBFS_UEP_T_TOG;
+                    }
+                }
+                else if( endp <= DEF_UEP7 )
+                {
+                    USBFS_Endp_TxDeal( endp );
+                }
+                break;
+
+            /* data-out stage processing */
+            case USBFS_UIS_TOKEN_OUT:
+                len = USBFSD->RX_LEN;
+                if( endp == DEF_UEP0 )
+                {
+                    /* end-point 0 data out interrupt */
+                    if ( intst & USBFS_UIS_TOG_OK )
+                    {
+                        if( USBFS_Class_Req && USBFS_Class_Req->EP0_Out )
+                        {
+                            USBFS_Class_Req->EP0_Out( USBFS_EP0_4Buf, len );
+                        }
+                        USBFS_SetupReqLen = ( len >= USBFS_SetupReqLen ) ? 0 : ( USBFS_SetupReqLen - len );
+                        if( USBFS_SetupReqLen == 0 )
+                        {
+                            if( USBFS_EP0_Hold == 0 )
+                            {
+                                USBFSD->UEP0_TX_LEN  = 0;
+                                USBFSD->UEP0_CTRL_H = (USBFSD->UEP0_CTRL_H & ~USBFS_UEP_T_RES_MASK) | USBFS_UEP_T_TOG | USBFS_UEP_T_RES_ACK;
+                            }
+                        }
+                        else
+                        {
+                            USBFSD->UEP0_CTRL_H ^= USBFS_UEP_R_TOG;
+                        }
+                    }
+                }
+                else if( endp <= DEF_UEP7 )
+                {
+                    if ( intst & USBFS_UIS_TOG_OK )
+                    {
+                        USBFS_Endp_RxDeal( endp, len );
+                    }
+                }
+                break;
+
+            /* Setup stage processing */
+            case USBFS_UIS_TOKEN_SETUP:
+                USBFSD->UEP0_CTRL_H = USBFS_UEP_T_TOG|USBFS_UEP_T_RES_NAK|USBFS_UEP_R_TOG|USBFS_UEP_R_RES_NAK;
+                /* Store All Setup Values */
+                USBFS_SetupReqType  = pUSBFS_SetupReqPak->bRequestType;
+                USBFS_SetupReqCode  = pUSBFS_SetupReqPak->bRequest;
+                USBFS_SetupReqLen   = pUSBFS_SetupReqPak->wLength;
+                USBFS_SetupReqValue = pUSBFS_SetupReqPak->wValue;
+                USBFS_SetupReqIndex = pUSBFS_SetupReqPak->wIndex;
+                pUSBFS_Descr = NULL;
+                USBFS_Class_Req = NULL;
+                USBFS_EP0_Hold = 0;
+                len = 0;
+                errflag = 0;
+                if ( ( USBFS_SetupReqType & USB_REQ_TYP_MASK ) != USB_REQ_TYP_STANDARD )
+                {
+                    /* usb non-standard request processing */
+                    errflag = USBFS_Class_Setup( &len );
+                }
+                else
+                {
+                    /* usb standard request processing */
+                    switch( USBFS_SetupReqCode )
+                    {
+                        /* get device/configuration/string/report/... descriptors */
+                        case USB_GET_DESCRIPTOR:
+                            switch( (uint8_t)( USBFS_SetupReqValue >> 8 ) )
+                            {
+                                /* get usb device descriptor */
+                                case USB_DESCR_TYP_DEVICE:
+                                    pUSBFS_Descr = MyDevDescr;
+                                    len = DEF_USBD_DEVICE_DESC_LEN;
+                                    break;
+
+                                /* get usb configuration descriptor */
+                                case USB_DESCR_TYP_CONFIG:
+                                    pUSBFS_Descr = MyCfgDescr;
+                                    len = DEF_USBD_CONFIG_DESC_LEN;
+                                    break;
+
+                                /* get usb string descriptor */
+                                case USB_DESCR_TYP_STRING:
+                                    switch( (uint8_t)( USBFS_SetupReqValue & 0xFF ) )
+                                    {
+                                        /* Descriptor 0, Language descriptor */
+                                        case DEF_STRING_DESC_LANG:
+                                            pUSBFS_Descr = MyLangDescr;
+                                            len = DEF_USBD_LANG_DESC_LEN;
+                                            break;
+
+                                        /* Descriptor 1, Manufacturers String descriptor */
+                                        case DEF_STRING_DESC_MANU:
+                                            pUSBFS_Descr = MyManuInfo;
+                                            len = DEF_USBD_MANU_DESC_LEN;
+                                            break;
+
+                                        /* Descriptor 2, Product String descriptor */
+                                        case DEF_STRING_DESC_PROD:
+                                            pUSBFS_Descr = MyProdInfo;
+                                            len = DEF_USBD_PROD_DESC_LEN;
+                                            break;
+
+                                        /* Descriptor 3, Serial-number String descriptor */
+                                        case DEF_STRING_DESC_SERN:
+                                            pUSBFS_Descr = MySerNumInfo;
+                                            len = DEF_USBD_SN_DESC_LEN;
+                                            break;
+
+                                        default:
+                                            errflag = 0xFF;
+                                            break;
+                                    }
+                                    break;
+
+                                /* report, BOS, ... descriptors belong to the class drivers */
+                                default :
+                                    errflag = 0xFF;
+                                    break;
+                            }
+                            break;
+
+                        /* Set usb address */
+                        case USB_SET_ADDRESS:
+                            USBFS_DevAddr = (uint8_t)( USBFS_SetupReqValue & 0xFF );
+                            break;
+
+                        /* Get usb configuration now set */
+                        case USB_GET_CONFIGURATION:
+                            USBFS_EP0_4Buf[0] = USBFS_DevConfig;
+                            if ( USBFS_SetupReqLen > 1 )
+                            {
+                                USBFS_SetupReqLen = 1;
+                            }
+                            break;
+
+                        /* Set usb configuration to use */
+                        case USB_SET_CONFIGURATION:
+                            USBFS_DevConfig = (uint8_t)( USBFS_SetupReqValue & 0xFF );
+                            USBFS_DevEnumStatus = 0x01;
+                            break;
+
+                        /* Clear or disable one usb feature */
+                        case USB_CLEAR_FEATURE:
+                            if ( ( USBFS_SetupReqType & USB_REQ_RECIP_MASK ) == USB_REQ_RECIP_DEVICE )
+                            {
+                                /* clear one device feature */
+                                if( (uint8_t)( USBFS_SetupReqValue & 0xFF ) == USB_REQ_FEAT_REMOTE_WAKEUP )
+                                {
+                                    /* clear usb sleep status, device not prepare to sleep */
+                                    USBFS_DevSleepStatus &= ~0x01;
+                                }
+                            }
+                            else if( ( ( USBFS_SetupReqType & USB_REQ_RECIP_MASK ) == USB_REQ_RECIP_ENDP )
+                                     && ( (uint8_t)( USBFS_SetupReqValue & 0xFF ) == USB_REQ_FEAT_ENDP_HALT ) )
+                            {
+                                /* Clear End-point Feature */
+                                if( USBFS_Endp_Halt( (uint8_t)( USBFS_SetupReqIndex & 0xFF ), 0 ) )
+                                {
+                                    errflag = 0xFF;
+                                }
+                            }
+                            else
+                            {
+                                errflag = 0xFF;
+                            }
+                            break;
+
+                        /* set or enable one usb feature */
+                        case USB_SET_FEATURE:
+                            if( ( USBFS_SetupReqType & USB_REQ_RECIP_MASK ) == USB_REQ_RECIP_DEVICE )
+                            {
+                                /* Set Device Feature */
+                                if( ( (uint8_t)( USBFS_SetupReqValue & 0xFF ) == USB_REQ_FEAT_REMOTE_WAKEUP ) && ( MyCfgDescr[ 7 ] & 0x20 ) )
+                                {
+                                    /* Set Wake-up flag, device prepare to sleep */
+                                    USBFS_DevSleepStatus |= 0x01;
+                                }
+                                else
+                                {
+                                    errflag = 0xFF;
+                                }
+                            }
+                            else if( ( ( USBFS_SetupReqType & USB_REQ_RECIP_MASK ) == USB_REQ_RECIP_ENDP )
+                                     && ( (uint8_t)( USBFS_SetupReqValue & 0xFF ) == USB_REQ_FEAT_ENDP_HALT ) )
+                            {
+                                /* Set end-points status stall */
+                                if( USBFS_Endp_Halt( (uint8_t)( USBFS_SetupReqIndex & 0xFF ), 1 ) )
+                                {
+                                    errflag = 0xFF;
+                                }
+                            }
+                            else
+                            {
+                                errflag = 0xFF;
+                            }
+                            break;
+
+                        /* This request allows the host to select another setting for the specified interface  */
+                        case USB_GET_INTERFACE:
+                            USBFS_EP0_4Buf[0] = 0x00;
+                            if ( USBFS_SetupReqLen > 1 )
+                            {
+                                USBFS_SetupReqLen = 1;
+                            }
+                            break;
+
+                        case USB_SET_INTERFACE:
+                            break;
+
+                        /* host get status of specified device/interface/end-points */
+                        case USB_GET_STATUS:
+                            USBFS_EP0_4Buf[ 0 ] = 0x00;
+                            USBFS_EP0_4Buf[ 1 ] = 0x00;
+                            if ( ( USBFS_SetupReqType & USB_REQ_RECIP_MASK ) == USB_REQ_RECIP_DEVICE )
+                            {
+                                if( USBFS_DevSleepStatus & 0x01 )
+                                {
+                                    USBFS_EP0_4Buf[ 0 ] = 0x02;
+                                }
+                            }
+                            else if( ( USBFS_SetupReqType & USB_REQ_RECIP_MASK ) == USB_REQ_RECIP_ENDP )
+                            {
+                                endp = (uint8_t)( USBFS_SetupReqIndex & 0x0F );
+                                if( ( endp < DEF_UEP1 ) || ( endp > DEF_UEP7 ) || ( USBFS_Endp_Sta[ endp ].Mod == 0 ) )
+                                {
+                                    errflag = 0xFF;
+                                }
+                                else if( USBFS_Endp_Sta[ endp ].Halt & ( ( USBFS_SetupReqIndex & DEF_UEP_IN ) ? 0x02 : 0x01 ) )
+                                {
+                                    USBFS_EP0_4Buf[ 0 ] = 0x01;
+                                }
+                            }
+                            else if( ( USBFS_SetupReqType & USB_REQ_RECIP_MASK ) != USB_REQ_RECIP_INTERF )
+                            {
+                                errflag = 0xFF;
+                            }
+
+                            if( USBFS_SetupReqLen > 2 )
+                            {
+                                USBFS_SetupReqLen = 2;
+                            }
+
+                            break;
+
+                        default:
+                            errflag = 0xFF;
+                            break;
+                    }
+
+                    /* standard requests not handled here, e.g. HID report descriptor */
+                    if( errflag == 0xFF )
+                    {
+                        errflag = USBFS_Class_Setup( &len );
+                    }
+                }
+
+                /* Copy Descriptors or class data to Endp0 DMA buffer */
+                if( ( errflag != 0xFF ) && ( USBFS_SetupReqType & DEF_UEP_IN ) && ( pUSBFS_Descr != NULL ) )
+                {
+                    if( USBFS_SetupReqLen > len )
+                    {
+                        USBFS_SetupReqLen = len;
+                    }
+                    len = (USBFS_SetupReqLen >= DEF_USBD_UEP0_SIZE) ? DEF_USBD_UEP0_SIZE : USBFS_SetupReqLen;
+                    memcpy( USBFS_EP0_4Buf, pUSBFS_Descr, len );
+                    pUSBFS_Descr += len;
+                }
+
+                /* errflag = 0xFF means a request not support or some errors occurred, else correct */
+                if( errflag == 0xff)
+                {
+                    /* if one request not support, return stall */
+                    USBFSD->UEP0_CTRL_H = USBFS_UEP_T_TOG|USBFS_UEP_T_RES_STALL|USBFS_UEP_R_TOG|USBFS_UEP_R_RES_STALL;
+                }
+                else
+                {
+                    /* end-point 0 data Tx/Rx */
+                    if( USBFS_SetupReqType & DEF_UEP_IN )
+                    {
+                        /* tx */
+                        len = (USBFS_SetupReqLen>DEF_USBD_UEP0_SIZE) ? DEF_USBD_UEP0_SIZE : USBFS_SetupReqLen;
+                        USBFS_SetupReqLen -= len;
+                        USBFSD->UEP0_TX_LEN  = len;
+                        USBFSD->UEP0_CTRL_H = (USBFSD->UEP0_CTRL_H & ~USBFS_UEP_T_RES_MASK) | USBFS_UEP_T_TOG | USBFS_UEP_T_RES_ACK;
+                    }
+                    else
+                    {
+                        /* rx */
+                        if( USBFS_SetupReqLen == 0 )
+                        {
+                            USBFSD->UEP0_TX_LEN  = 0;
+                            USBFSD->UEP0_CTRL_H = (USBFSD->UEP0_CTRL_H & ~USBFS_UEP_T_RES_MASK) | USBFS_UEP_T_TOG | USBFS_UEP_T_RES_ACK;
+                        }
+                        else
+                        {
+                            USBFSD->UEP0_CTRL_H = (USBFSD->UEP0_CTRL_H & ~USBFS_UEP_R_RES_MASK) | USBFS_UEP_R_TOG | USBFS_UEP_R_RES_ACK;
+                        }
+                    }
+                }
+                break;
+
+            /* Sof pack processing */
+            case USBFS_UIS_TOKEN_SOF:
+                for( i = 0; i < USBFS_Class_Num; i++ )
+                {
+                    if( USBFS_Class_Drv[ i ]->SOF )
+                    {
+                        USBFS_Class_Drv[ i ]->SOF( );
+                    }
+                }
+                break;
+
+            default :
+                break;
+        }
+        USBFSD->INT_FG = USBFS_UIF_TRANSFER;
+    }
+    else if( intflag & USBFS_UIF_BUS_RST )
+    {
+        /* usb reset interrupt processing */
+        USBFS_DevConfig = 0;
+        USBFS_DevAddr = 0;
+        USBFS_DevSleepStatus = 0;
+        USBFS_DevEnumStatus = 0;
+        USBFS_EP0_Hold = 0;
+
+        USBFSD->DEV_ADDR = 0;
+        USBFS_Device_Endp_Init( );
+        USBFSD->INT_FG = USBFS_UIF_BUS_RST;
+    }
+    else if( intflag & USBFS_UIF_SUSPEND )
+    {
+        USBFSD->INT_FG = USBFS_UIF_SUSPEND;
+        Delay_Us(10);
+        /* usb suspend interrupt processing */
+        if ( USBFSD->MIS_ST & USBFS_UMS_SUSPEND )
+        {
+            /* Stop mode is entered from the main loop, see USBFS_Device_Sleep */
+            if( ( USBFS_DevSleepStatus & 0x02 ) == 0 )
+            {
+                USBFS_Class_Sleep( DEF_USBD_SLEEP_SUSPEND );
+            }
+            USBFS_DevSleepStatus |= 0x02;
+        }
+        else
+        {
+            USBFS_DevSleepStatus &= ~0x02;
+        }
+    }
+    else
+    {
+        /* other interrupts */
+        USBFSD->INT_FG = intflag;
+    }
+}
+
+/*********************************************************************
+ * @fn      USBFS_Send_Resume
+ *
+ * @brief   USBFS device sends wake-up signal to host, K state for 8ms.
+ *
+ * @return  none
+ */
+void USBFS_Send_Resume(void)
+{
+#if DEF_USBD_LOW_SPEED
+    if(PWR_VDD_SupplyVoltage() == PWR_VDD_5V)
+    {
+        GPIOC->BSXR = 0x00010002;
+        GPIOC->CFGXR = (GPIOC->CFGXR & ~0x000000FF) | 0x00000088;
+        AFIO->CTLR = (AFIO->CTLR & ~UDM_PUE_10K ) | UDP_PUE_10K;
+        Delay_Ms( 8 );
+        AFIO->CTLR = (AFIO->CTLR & ~UDP_PUE_10K ) | UDM_PUE_10K;
+        GPIOC->CFGXR = (GPIOC->CFGXR & ~0x000000FF) | 0x00000048;
+        GPIOC->BSXR = 0x00020001;
+    }
+    else
+    {
+        GPIOC->BSXR = 0x00010002;
+        GPIOC->CFGXR = (GPIOC->CFGXR & ~0x000000FF) | 0x00000088;
+        AFIO->CTLR = (AFIO->CTLR & ~UDM_PUE_1K5 ) | UDP_PUE_1K5;
+        Delay_Ms( 8 );
+        AFIO->CTLR = (AFIO->CTLR & ~UDP_PUE_1K5 ) | UDM_PUE_1K5;
+        GPIOC->CFGXR = (GPIOC->CFGXR & ~0x000000FF) | 0x00000048;
+        GPIOC->BSXR = 0x00020001;
+    }
+#else
+    if(PWR_VDD_SupplyVoltage() == PWR_VDD_5V)
+    {
+        GPIOC->BSXR = 0x00020001;
+        GPIOC->CFGXR = (GPIOC->CFGXR & ~0x000000FF) | 0x00000088;
+        AFIO->CTLR = (AFIO->CTLR & ~UDP_PUE_10K ) | UDM_PUE_10K;
+        Delay_Ms( 8 );
+        AFIO->CTLR = (AFIO->CTLR & ~UDM_PUE_10K ) | UDP_PUE_10K;
+        GPIOC->CFGXR = (GPIOC->CFGXR & ~0x000000FF) | 0x00000084;
+        GPIOC->BSXR = 0x00010002;
+    }
+    else
+    {
+        GPIOC->BSXR = 0x00020001;
+        GPIOC->CFGXR = (GPIOC->CFGXR & ~0x000000FF) | 0x00000088;
+        AFIO->CTLR = (AFIO->CTLR & ~UDP_PUE_1K5 ) | UDM_PUE_1K5;
+        Delay_Ms( 8 );
+        AFIO->CTLR = (AFIO->CTLR & ~UDM_PUE_1K5 ) | UDP_PUE_1K5;
+        GPIOC->CFGXR = (GPIOC->CFGXR & ~0x000000FF) | 0x00000084;
+        GPIOC->BSXR = 0x00010002;
+    }
+#endif
+}
+
+/*********************************************************************
+ * @fn      USBFS_Device_Sleep
+ *
+ * @brief   Enter Stop mode while the bus is suspended. Called from the main
+ *          loop, does nothing unless the suspend interrupt has set
+ *          USBFS_DevSleepStatus bit1. Bus activity from the host wakes the
+ *          chip through EXTI line 28; a class driver whose Sleep hook
+ *          reports input on WAKE makes the device signal remote wakeup if
+ *          the host enabled it, else the device goes back to Stop.
+ *
+ * @return  none
+ */
+void USBFS_Device_Sleep( void )
+{
+    uint8_t remote = 0;
+
+    if( ( USBFS_DevSleepStatus & 0x02 ) == 0 )
+    {
+        return;
+    }
+
+    __disable_irq( );
+    while( USBFSD->MIS_ST & USBFS_UMS_SUSPEND )
+    {
+        EXTI_ClearFlag( EXTI_Line28 );
+        USBFS_Class_Sleep( DEF_USBD_SLEEP_STOP );
+
+        /* Every clock but the LSI stops here, HSI restarts on the wake-up event */
+        PWR_EnterSTOPMode( PWR_STOPEntry_WFE );
+        USBFS_Class_Sleep( DEF_USBD_SLEEP_EXIT );
+        SystemInit( );
+        SystemCoreClockUpdate( );
+        USBFS_RCC_Init( );
+
+        if( USBFS_Class_Sleep( DEF_USBD_SLEEP_WAKE ) && ( USBFS_DevSleepStatus & 0x01 ) )
+        {
+            USBFS_Send_Resume( );
+            remote = 1;
+            break;
+        }
+    }
+    EXTI_ClearFlag( EXTI_Line28 );
+    USBFS_DevSleepStatus &= ~0x02;
+    USBFS_Class_Sleep( remote ? DEF_USBD_SLEEP_REMOTE : DEF_USBD_SLEEP_RESUME );
+    __enable_irq( );
+}
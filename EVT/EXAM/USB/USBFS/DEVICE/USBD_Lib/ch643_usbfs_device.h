@@ -0,0 +1,233 @@
+/********************************** (C) COPYRIGHT *******************************
+* File Name          : ch643_usbfs_device.h
+* Author             : WCH
+* Version            : V1.1.0
+* Date               : 2026/10/19
+* Description        : This file contains all the functions prototypes for the
+*                      shared USBFS device core and its class-driver interface.
+*                      Built into CH372Device, CompatibilityHID, CompositeKM,
+*                      CompositeKM_LowSpeed, SimulateCDC, SimulateCDC-HID,
+*                      SimulateCDC-MultiPort, MSC_SPIFlash and IAP/USB_UART
+*                      (CH643_IAP, CH643_APP).
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef __CH643_USBFS_DEVICE_H_
+#define __CH643_USBFS_DEVICE_H_
+
+#include <ch643_usb.h>
+#include "debug.h"
+#include "string.h"
+#include "usb_desc.h"
+
+/******************************************************************************/
+/* Global Define */
+#ifndef __PACKED
+  #define __PACKED   __attribute__((packed))
+#endif
+
+/* end-point number */
+#define DEF_UEP_IN                    0x80
+#define DEF_UEP_OUT                   0x00
+#define DEF_UEP0                      0x00
+#define DEF_UEP1                      0x01
+#define DEF_UEP2                      0x02
+#define DEF_UEP3                      0x03
+#define DEF_UEP4                      0x04
+#define DEF_UEP5                      0x05
+#define DEF_UEP6                      0x06
+#define DEF_UEP7                      0x07
+#define DEF_UEP_NUM                   8
+
+/* End-point mode, used by USBFS_Endp_Open */
+#define USBFSD_UEP_RX_EN            0x08
+#define USBFSD_UEP_TX_EN            0x04
+#define USBFSD_UEP_BUF_MOD          0x01 /* Double buffer, end-point 1/2/3 only */
+#define DEF_UEP_DMA_LOAD            0 /* Direct the DMA address to the data to be processed */
+#define DEF_UEP_CPY_LOAD            1 /* Use memcpy to move data to a buffer */
+
+/* Transmit flags, used by USBFS_Endp_Transmit */
+#define DEF_UEP_TX_ZLP              0x01 /* End with a zero-length packet if len is a multiple of the packet size */
+#define DEF_UEP_TX_DMA              0x02 /* Send straight from the caller's buffer, IN-only single-buffer end-point 1/2/3/5/6/7 */
+
+/* Per-endpoint transmit queue depth */
+#ifndef DEF_USBD_TXQ_DEPTH
+#define DEF_USBD_TXQ_DEPTH          4
+#endif
+
+/* Number of class drivers that can be registered */
+#ifndef DEF_USBD_CLASS_MAX
+#define DEF_USBD_CLASS_MAX          4
+#endif
+
+/* Endpoint buffer size */
+#define DEF_USBFS_UEP_BUF_LEN       64
+#define DEF_USBFS_UEP_DBUF_LEN      ( DEF_USBFS_UEP_BUF_LEN * 4 ) /* dual rx + dual tx */
+
+/* Full speed unless the project defines it as 1 */
+#ifndef DEF_USBD_LOW_SPEED
+#define DEF_USBD_LOW_SPEED          0
+#endif
+
+/* Return value of USBFS_CLASS_DRV.Setup */
+#define DEF_USBD_REQ_OK             0x00
+#define DEF_USBD_REQ_ERR            0xFF
+
+/* Event of USBFS_CLASS_DRV.Sleep */
+#define DEF_USBD_SLEEP_SUSPEND      0x01 /* Suspend interrupt, bus idle for 3ms */
+#define DEF_USBD_SLEEP_STOP         0x02 /* About to enter Stop mode */
+#define DEF_USBD_SLEEP_EXIT         0x03 /* Just out of Stop mode, still on HSI */
+#define DEF_USBD_SLEEP_WAKE         0x04 /* Clocks restored, return 1 if class input woke the chip */
+#define DEF_USBD_SLEEP_RESUME       0x05 /* Bus resumed by the host */
+#define DEF_USBD_SLEEP_REMOTE       0x06 /* Bus resumed by remote wakeup */
+
+/* Setup Request Packets */
+#define pUSBFS_SetupReqPak                 ((PUSB_SETUP_REQ)USBFS_EP0_4Buf)
+
+
+#define USB_IOEN                    0x00000080
+#define USB_PHY_V33                 0x00000040
+#define UDP_PUE_MASK                0x0000000C
+#define UDP_PUE_DISABLE             0x00000000
+#define UDP_PUE_35UA                0x00000004
+#define UDP_PUE_10K                 0x00000008
+#define UDP_PUE_1K5                 0x0000000C
+
+#define UDM_PUE_MASK                0x00000003
+#define UDM_PUE_DISABLE             0x00000000
+#define UDM_PUE_35UA                0x00000001
+#define UDM_PUE_10K                 0x00000002
+#define UDM_PUE_1K5                 0x00000003
+
+/* Pull-up on UDP for full speed, on UDM for low speed */
+#if DEF_USBD_LOW_SPEED
+#define DEF_USBD_PUE_10K            UDM_PUE_10K
+#define DEF_USBD_PUE_1K5            UDM_PUE_1K5
+#define DEF_USBD_UC_SPEED           USBFS_UC_LOW_SPEED
+#define DEF_USBD_UD_SPEED           USBFS_UD_LOW_SPEED
+#else
+#define DEF_USBD_PUE_10K            UDP_PUE_10K
+#define DEF_USBD_PUE_1K5            UDP_PUE_1K5
+#define DEF_USBD_UC_SPEED           0
+#define DEF_USBD_UD_SPEED           0
+#endif
+
+/******************************************************************************/
+/* Class driver interface.
+ * Init is called at device init and on every bus reset, open the endpoints here.
+ * Setup gets class/vendor requests addressed to the driver and any standard
+ * request the core does not handle itself (e.g. HID report descriptor). For an
+ * IN data stage point *ppbuf at the data and set *plen; for an OUT data stage
+ * each packet is passed to EP0_Out. Return DEF_USBD_REQ_ERR to stall.
+ * The status stage of an OUT request is ACKed after its last packet, unless
+ * EP0_Out calls USBFS_EP0_Status_Hold; USBFS_EP0_Status_Send then ACKs it
+ * later, e.g. from the main loop once the data has been dealt with.
+ * Out gets every OUT packet of the driver's endpoints; the buffer stays owned by
+ * the driver, and the endpoint may NAK, until USBFS_Endp_RxDone is called.
+ * In is called each time one queued IN transfer has been fully sent.
+ * Sleep follows USBFS_Device_Sleep through suspend, Stop mode and resume, see
+ * DEF_USBD_SLEEP_xx. A driver that can wake the host arms its wake-up EXTI
+ * lines as events, clears them on STOP and returns 1 on WAKE if one fired;
+ * the core then signals remote wakeup if the host enabled it.
+ * All callbacks but Sleep run in the USBFS interrupt; Sleep runs in the
+ * interrupt for SUSPEND and with interrupts disabled otherwise.
+ * Unused callbacks may be NULL. */
+typedef struct _USBFS_CLASS_DRV
+{
+    uint8_t Itf_First;                                                          /* First interface number owned */
+    uint8_t Itf_Num;                                                            /* Number of interfaces owned */
+    uint8_t Endp_Mask;                                                          /* BITn: endpoint n owned */
+    void    ( *Init )( void );
+    uint8_t ( *Setup )( const uint8_t **ppbuf, uint16_t *plen );
+    void    ( *EP0_Out )( uint8_t *pbuf, uint16_t len );
+    void    ( *Out )( uint8_t endp, uint8_t *pbuf, uint16_t len );
+    void    ( *In )( uint8_t endp );
+    void    ( *SOF )( void );
+    uint8_t ( *Sleep )( uint8_t evt );
+} USBFS_CLASS_DRV, *PUSBFS_CLASS_DRV;
+
+/* IN transfer queued on an endpoint */
+typedef struct _USBFS_TX_REQ
+{
+    const uint8_t *pBuf;
+    uint16_t Len;
+    uint8_t  Flag;                                                              /* DEF_UEP_TX_xx */
+} USBFS_TX_REQ;
+
+/* Endpoint state */
+typedef struct _USBFS_ENDP_STA
+{
+    uint8_t  Mod;                                                               /* USBFSD_UEP_xx */
+    uint8_t  Pack_Size;                                                         /* Max packet size */
+    uint8_t  Halt;                                                              /* BIT0: OUT stall, BIT1: IN stall */
+
+    /* OUT: halves filled and not yet released by USBFS_Endp_RxDone */
+    uint8_t  Rx_Half;                                                           /* Half the hardware fills next */
+    uint8_t  Rx_First;                                                          /* Oldest pending half */
+    uint8_t  Rx_Pend;                                                           /* Pending halves, 0-2 */
+
+    /* IN: queue of transfers, Head is the oldest not yet completed */
+    USBFS_TX_REQ Tx_Q[ DEF_USBD_TXQ_DEPTH ];
+    uint8_t  Tx_Head;
+    uint8_t  Tx_Cnt;
+    uint8_t  Ld_Idx;                                                            /* Queue entry being loaded */
+    uint8_t  Ld_Pend;                                                           /* Queue entries not fully loaded */
+    uint16_t Ld_Off;                                                            /* Bytes of Ld_Idx already loaded */
+
+    /* IN: packets loaded into the endpoint buffer halves */
+    uint8_t  Hw_Half;                                                           /* Half on the bus, follows T_TOG */
+    uint8_t  Hw_Cnt;                                                            /* Loaded packets, 0-2 */
+    uint8_t  Hw_End[ 2 ];                                                       /* Packet ends a queue entry */
+    uint16_t Hw_Len[ 2 ];
+} USBFS_ENDP_STA;
+
+/*******************************************************************************/
+/* Variable Definition */
+/* Global */
+extern const    uint8_t  *pUSBFS_Descr;
+
+/* Setup Request */
+extern volatile uint8_t  USBFS_SetupReqCode;
+extern volatile uint8_t  USBFS_SetupReqType;
+extern volatile uint16_t USBFS_SetupReqValue;
+extern volatile uint16_t USBFS_SetupReqIndex;
+extern volatile uint16_t USBFS_SetupReqLen;
+
+/* USB Device Status */
+extern volatile uint8_t  USBFS_DevConfig;
+extern volatile uint8_t  USBFS_DevAddr;
+extern volatile uint8_t  USBFS_DevSleepStatus;
+extern volatile uint8_t  USBFS_DevEnumStatus;
+
+/* Endpoint Buffer */
+extern __attribute__ ((aligned(4))) uint8_t USBFS_EP0_4Buf[ ];
+
+/* USB IN Endpoint Busy Flag */
+extern volatile uint8_t  USBFS_Endp_Busy[ ];
+
+/* Endpoint state */
+extern USBFS_ENDP_STA USBFS_Endp_Sta[ ];
+
+/******************************************************************************/
+/* external functions */
+extern void USBFS_Device_Init( FunctionalState sta , PWR_VDD VDD_Voltage);
+extern void USBFS_Device_Endp_Init(void);
+extern void USBFS_RCC_Init(void);
+extern uint8_t USBFS_Class_Register( const USBFS_CLASS_DRV *pdrv );
+extern uint8_t USBFS_Endp_Open( uint8_t endp, uint8_t mod, uint8_t pack_size );
+extern uint8_t *USBFS_Endp_RxBuf( uint8_t endp );
+extern uint8_t USBFS_Endp_RxBuf_Set( uint8_t endp, uint8_t *pbuf );
+extern void USBFS_Endp_RxDone( uint8_t endp );
+extern uint8_t USBFS_Endp_Transmit( uint8_t endp, const uint8_t *pbuf, uint16_t len, uint8_t flag );
+extern uint8_t USBFS_Endp_TxFree( uint8_t endp );
+extern uint8_t USBFS_Endp_Halt( uint8_t endp, uint8_t sta );
+extern uint8_t USBFS_Endp_DataUp(uint8_t endp, uint8_t *pbuf, uint16_t len, uint8_t mod);
+extern void USBFS_EP0_Status_Hold( void );
+extern void USBFS_EP0_Status_Send( void );
+extern void USBFS_Send_Resume( void );
+extern void USBFS_Device_Sleep( void );
+
+#endif
@@ -0,0 +1,441 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : app_cdc.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : The USB host reads a CDC-ACM device or a USB-serial
+ *                      bridge and prints what comes in a line at a time.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+/********************************************************************************/
+/* Header File */
+#include "usb_host_config.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+uint8_t  DevDesc_Buf[ 18 ];                                                     // Device Descriptor Buffer
+uint8_t  Com_Buf[ DEF_COM_BUF_LEN ];                                            // General Buffer
+struct   _ROOT_HUB_DEVICE RootHubDev;
+volatile uint16_t CDC_Ms;
+
+char     CDC_Line[ DEF_CDC_LINE_LEN + 1 ];
+uint16_t CDC_Line_Len;
+
+/*******************************************************************************/
+/* Interrupt Function Declaration */
+void TIM3_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+
+/*********************************************************************
+ * @fn      TIM3_Init
+ *
+ * @brief   Initialize timer3 for the 1mS time base.
+ *
+ * @param   arr - The specific period value.
+ *          psc - The specifies prescaler value.
+ *
+ * @return  none
+ */
+void TIM3_Init( uint16_t arr, uint16_t psc )
+{
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure = { 0 };
+    NVIC_InitTypeDef NVIC_InitStructure = { 0 };
+
+    /* Enable timer3 clock */
+    RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM3, ENABLE );
+
+    /* Initialize timer3 */
+    TIM_TimeBaseStructure.TIM_Period = arr;
+    TIM_TimeBaseStructure.TIM_Prescaler = psc;
+    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseInit( TIM3, &TIM_TimeBaseStructure );
+
+    /* Enable updating timer3 interrupt */
+    TIM_ITConfig( TIM3, TIM_IT_Update, ENABLE );
+
+    /* Configure timer3 interrupt */
+    NVIC_InitStructure.NVIC_IRQChannel = TIM3_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 2;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init( &NVIC_InitStructure );
+
+    /* Enable timer3 */
+    TIM_Cmd( TIM3, ENABLE );
+
+    /* Enable timer3 interrupt */
+    NVIC_EnableIRQ( TIM3_IRQn );
+}
+
+/*********************************************************************
+ * @fn      TIM3_IRQHandler
+ *
+ * @brief   This function handles TIM3 global interrupt request.
+ *
+ * @return  none
+ */
+void TIM3_IRQHandler( void )
+{
+    if( TIM_GetITStatus( TIM3, TIM_IT_Update ) != RESET )
+    {
+        /* Clear interrupt flag */
+        TIM_ClearITPendingBit( TIM3, TIM_IT_Update );
+
+        CDC_Ms++;
+    }
+}
+
+/*********************************************************************
+ * @fn      USBH_AnalyseType
+ *
+ * @brief   Simply analyze USB device type.
+ *
+* @para     pdev_buf: Device descriptor buffer
+ *          pcfg_buf: Configuration descriptor buffer
+ *          ptype: Device type.
+ *
+ * @return  none
+ */
+void USBH_AnalyseType( uint8_t *pdev_buf, uint8_t *pcfg_buf, uint8_t *ptype )
+{
+    uint8_t  dv_cls, if_cls;
+
+    dv_cls = ( (PUSB_DEV_DESCR)pdev_buf )->bDeviceClass;
+    if_cls = ( (PUSB_CFG_DESCR_LONG)pcfg_buf )->itf_descr.bInterfaceClass;
+    if( ( dv_cls == USB_DEV_CLASS_STORAGE ) || ( if_cls == USB_DEV_CLASS_STORAGE ) )
+    {
+        *ptype = USB_DEV_CLASS_STORAGE;
+    }
+    else if( ( dv_cls == USB_DEV_CLASS_PRINTER ) || ( if_cls == USB_DEV_CLASS_PRINTER ) )
+    {
+        *ptype = USB_DEV_CLASS_PRINTER;
+    }
+    else if( ( dv_cls == USB_DEV_CLASS_HID ) || ( if_cls == USB_DEV_CLASS_HID ) )
+    {
+        *ptype = USB_DEV_CLASS_HID;
+    }
+    else if( ( dv_cls == USB_DEV_CLASS_HUB ) || ( if_cls == USB_DEV_CLASS_HUB ) )
+    {
+        *ptype = USB_DEV_CLASS_HUB;
+    }
+    else if( ( dv_cls == USB_DEV_CLASS_COMMUNIC ) || ( if_cls == USB_DEV_CLASS_COMMUNIC ) )
+    {
+        *ptype = USB_DEV_CLASS_COMMUNIC;
+    }
+    else if( ( dv_cls == USB_DEV_CLASS_VEN_SPEC ) || ( if_cls == USB_DEV_CLASS_VEN_SPEC ) )
+    {
+        *ptype = USB_DEV_CLASS_VEN_SPEC;
+    }
+    else
+    {
+        *ptype = DEF_DEV_TYPE_UNKNOWN;
+    }
+}
+
+/*********************************************************************
+ * @fn      USBH_EnumRootDevice
+ *
+ * @brief   Generally enumerate a device connected to host port.
+ *
+ * @return  Enumeration result
+ */
+uint8_t USBH_EnumRootDevice( void )
+{
+    uint8_t  s;
+    uint8_t  enum_cnt;
+    uint8_t  cfg_val;
+    uint16_t i;
+    uint16_t len;
+
+    DUG_PRINTF( "Enum:\r\n" );
+
+    enum_cnt = 0;
+ENUM_START:
+    /* Delay and wait for the device to stabilize */
+    Delay_Ms( 100 );
+    enum_cnt++;
+    Delay_Ms( 8 << enum_cnt );
+
+    /* Reset the USB device and wait for the USB device to reconnect */
+    USBFSH_ResetRootHubPort( 0 );
+    for( i = 0, s = 0; i < DEF_RE_ATTACH_TIMEOUT; i++ )
+    {
+        if( USBFSH_EnableRootHubPort( &RootHubDev.bSpeed ) == ERR_SUCCESS )
+        {
+            i = 0;
+            s++;
+            if( s > 6 )
+            {
+                break;
+            }
+        }
+        Delay_Ms( 1 );
+    }
+    if( i )
+    {
+        /* Determine whether the maximum number of retries has been reached, and retry if not reached */
+        if( enum_cnt <= 5 )
+        {
+            goto ENUM_START;
+        }
+        return ERR_USB_DISCON;
+    }
+
+    /* Get USB device device descriptor */
+    DUG_PRINTF("Get DevDesc: ");
+    s = USBFSH_GetDeviceDescr( &RootHubDev.bEp0MaxPks, DevDesc_Buf );
+    if( s == ERR_SUCCESS )
+    {
+        /* Print USB device device descriptor */
+#if DEF_DEBUG_PRINTF
+        for( i = 0; i < 18; i++ )
+        {
+            DUG_PRINTF( "%02x ", DevDesc_Buf[ i ] );
+        }
+        DUG_PRINTF("\r\n");
+#endif
+    }
+    else
+    {
+        /* Determine whether the maximum number of retries has been reached, and retry if not reached */
+        DUG_PRINTF( "Err(%02x)\r\n", s );
+        if( enum_cnt <= 5 )
+        {
+            goto ENUM_START;
+        }
+        return DEF_DEV_DESCR_GETFAIL;
+    }
+
+    /* Set the USB device address */
+    DUG_PRINTF("Set DevAddr: ");
+    RootHubDev.bAddress = (uint8_t)( USB_DEVICE_ADDR );
+
+    s = USBFSH_SetUsbAddress( RootHubDev.bEp0MaxPks, RootHubDev.bAddress );
+    if( s == ERR_SUCCESS )
+    {
+        DUG_PRINTF( "OK\r\n" );
+
+        RootHubDev.bAddress = USB_DEVICE_ADDR;
+    }
+    else
+    {
+        /* Determine whether the maximum number of retries has been reached, and retry if not reached */
+        DUG_PRINTF( "Err(%02x)\r\n", s );
+        if( enum_cnt <= 5 )
+        {
+            goto ENUM_START;
+        }
+        return DEF_DEV_ADDR_SETFAIL;
+    }
+    Delay_Ms( 5 );
+
+    /* Get the USB device configuration descriptor */
+    DUG_PRINTF("Get CfgDesc: ");
+    s = USBFSH_GetConfigDescr( RootHubDev.bEp0MaxPks, Com_Buf, DEF_COM_BUF_LEN, &len );
+    if( s == ERR_SUCCESS )
+    {
+        cfg_val = ( (PUSB_CFG_DESCR)Com_Buf )->bConfigurationValue;
+
+        /* Print USB device configuration descriptor  */
+#if DEF_DEBUG_PRINTF
+        for( i = 0; i < len; i++ )
+        {
+            DUG_PRINTF( "%02x ", Com_Buf[ i ] );
+        }
+        DUG_PRINTF("\r\n");
+#endif
+
+        /* Simply analyze USB device type  */
+        USBH_AnalyseType( DevDesc_Buf, Com_Buf, &RootHubDev.bType );
+        DUG_PRINTF( "DevType: %02x\r\n", RootHubDev.bType );
+    }
+    else
+    {
+        /* Determine whether the maximum number of retries has been reached, and retry if not reached */
+        DUG_PRINTF( "Err(%02x)\r\n", s );
+        if( enum_cnt <= 5 )
+        {
+            goto ENUM_START;
+        }
+        return DEF_CFG_DESCR_GETFAIL;
+    }
+
+    /* Set USB device configuration value */
+    DUG_PRINTF("Set Cfg: ");
+    s = USBFSH_SetUsbConfig( RootHubDev.bEp0MaxPks, cfg_val );
+    if( s == ERR_SUCCESS )
+    {
+        DUG_PRINTF( "OK\r\n" );
+    }
+    else
+    {
+        /* Determine whether the maximum number of retries has been reached, and retry if not reached */
+        DUG_PRINTF( "Err(%02x)\r\n", s );
+        if( enum_cnt <= 5 )
+        {
+            goto ENUM_START;
+        }
+        return ERR_USB_UNSUPPORT;
+    }
+
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      CDC_PrintLines
+ *
+ * @brief   Gather received text into lines and print each complete line
+ *          with the time it ended, as a GPS or sensor logger would.
+ *
+ * @para    pbuf: Received bytes.
+ *          len: Bytes.
+ *
+ * @return  none
+ */
+void CDC_PrintLines( uint8_t *pbuf, uint16_t len )
+{
+    uint16_t i;
+
+    for( i = 0; i < len; i++ )
+    {
+        if( ( pbuf[ i ] == '\r' ) || ( pbuf[ i ] == '\n' ) || ( CDC_Line_Len == DEF_CDC_LINE_LEN ) )
+        {
+            if( CDC_Line_Len )
+            {
+                CDC_Line[ CDC_Line_Len ] = 0;
+                printf( "[%5d] %s\r\n", CDC_Ms, CDC_Line );
+                CDC_Line_Len = 0;
+            }
+            if( ( pbuf[ i ] == '\r' ) || ( pbuf[ i ] == '\n' ) )
+            {
+                continue;
+            }
+        }
+        CDC_Line[ CDC_Line_Len++ ] = pbuf[ i ];
+    }
+}
+
+/*********************************************************************
+ * @fn      USBH_MainDeal
+ *
+ * @brief   Provide a simple enumeration process for USB devices, bring
+ *          up a serial port device and keep reading it.
+ *
+ * @return  none
+ */
+void USBH_MainDeal( void )
+{
+    uint8_t  s;
+    uint16_t len;
+#if DEF_CDC_STAT_PERIOD
+    static uint16_t Stat_Ms;
+#endif
+
+    s = USBFSH_CheckRootHubPortStatus( RootHubDev.bStatus ); // Check USB device connection or disconnection
+    if( s == ROOT_DEV_CONNECTED )
+    {
+        DUG_PRINTF( "USB Port Dev In.\r\n" );
+
+        /* Set root device state parameters */
+        RootHubDev.bStatus = ROOT_DEV_CONNECTED;
+        RootHubDev.DeviceIndex = DEF_USBFS_PORT_INDEX * DEF_ONE_USB_SUP_DEV_TOTAL;
+
+        s = USBH_EnumRootDevice( ); // Simply enumerate root device
+        if( s == ERR_SUCCESS )
+        {
+            /* The configuration descriptor is still in Com_Buf */
+            if( USBH_CDC_Probe( DevDesc_Buf, Com_Buf ) == ERR_SUCCESS )
+            {
+                DUG_PRINTF( "Root Device Is Serial Port(%d), IN %02x OUT %02x. ",
+                            USBH_CDC.Type, USBH_CDC.InEndpAddr, USBH_CDC.OutEndpAddr );
+
+                s = USBH_CDC_Init( RootHubDev.bEp0MaxPks, DEF_CDC_BAUDRATE );
+                DUG_PRINTF( "Further Enum Result: " );
+                if( s == ERR_SUCCESS )
+                {
+                    DUG_PRINTF( "OK, %d baud\r\n", USBH_CDC.Baud );
+
+                    /* Set the connection status of the device  */
+                    RootHubDev.bStatus = ROOT_DEV_SUCCESS;
+                    CDC_Line_Len = 0;
+                }
+                else if( s != ERR_USB_DISCON )
+                {
+                    DUG_PRINTF( "Err(%02x)\r\n", s );
+
+                    RootHubDev.bStatus = ROOT_DEV_FAILED;
+                }
+            }
+            else
+            {
+                DUG_PRINTF( "Root Device Is " );
+                switch( RootHubDev.bType )
+                {
+                    case USB_DEV_CLASS_STORAGE:
+                        DUG_PRINTF("Storage. ");
+                        break;
+                    case USB_DEV_CLASS_PRINTER:
+                        DUG_PRINTF("Printer. ");
+                        break;
+                    case USB_DEV_CLASS_HID:
+                        DUG_PRINTF("HID. ");
+                        break;
+                    case USB_DEV_CLASS_HUB:
+                        DUG_PRINTF("HUB. ");
+                        break;
+                    default:
+                        DUG_PRINTF("Unknown. ");
+                        break;
+                }
+                DUG_PRINTF( "End Enum.\r\n" );
+
+                RootHubDev.bStatus = ROOT_DEV_SUCCESS;
+            }
+        }
+        else if( s != ERR_USB_DISCON )
+        {
+            /* Enumeration failed */
+            DUG_PRINTF( "Enum Fail with Error Code:%x\r\n",s );
+            RootHubDev.bStatus = ROOT_DEV_FAILED;
+        }
+    }
+    else if( s == ROOT_DEV_DISCONNECT )
+    {
+        DUG_PRINTF( "USB Port Dev Out.\r\n" );
+
+        /* Clear parameters */
+        memset( &RootHubDev.bStatus, 0, sizeof( ROOT_HUB_DEVICE ) );
+        memset( &USBH_CDC, 0, sizeof( USBH_CDC ) );
+    }
+
+    if( ( RootHubDev.bStatus < ROOT_DEV_SUCCESS ) || ( USBH_CDC.Type == CDC_TYPE_NONE ) )
+    {
+        return;
+    }
+
+    /* Keep the bulk IN endpoint running, then print what came in */
+    s = USBH_CDC_Poll( );
+    if( s == ERR_USB_DISCON )
+    {
+        return;
+    }
+    len = USBH_CDC_Read( Com_Buf, DEF_COM_BUF_LEN );
+    if( len )
+    {
+        CDC_PrintLines( Com_Buf, len );
+    }
+
+#if DEF_CDC_STAT_PERIOD
+    /* Print the transfer counts */
+    if( (uint16_t)( CDC_Ms - Stat_Ms ) >= DEF_CDC_STAT_PERIOD )
+    {
+        Stat_Ms = CDC_Ms;
+        USBH_CDC_Stat_Print( );
+    }
+#endif
+}
@@ -0,0 +1,57 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : app_cdc.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : This file contains all the functions prototypes for the
+ *                      USB host serial port example.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+#ifndef __APP_CDC_H
+#define __APP_CDC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************/
+/* Header File */
+#include "stdint.h"
+
+/*******************************************************************************/
+/* Macro Definition */
+
+/* General */
+#define DEF_COM_BUF_LEN                 512
+
+/* Received text is printed a line at a time, longer lines in pieces */
+#define DEF_CDC_LINE_LEN                128
+
+/* Period of the transfer counts print, 0 - off */
+#define DEF_CDC_STAT_PERIOD             10000
+
+/*******************************************************************************/
+/* Variable Declaration */
+extern uint8_t  DevDesc_Buf[ ];
+extern uint8_t  Com_Buf[ ];
+extern volatile uint16_t CDC_Ms;
+
+/*******************************************************************************/
+/* Function Declaration */
+extern void TIM3_Init( uint16_t arr, uint16_t psc );
+extern void USBH_AnalyseType( uint8_t *pdev_buf, uint8_t *pcfg_buf, uint8_t *ptype );
+extern uint8_t USBH_EnumRootDevice( void );
+extern void CDC_PrintLines( uint8_t *pbuf, uint16_t len );
+extern void USBH_MainDeal( void );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
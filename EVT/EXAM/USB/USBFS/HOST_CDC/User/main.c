@@ -0,0 +1,74 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : main.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Main program body.
+ *********************************************************************************
+ * Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+ * Attention: This software (modified or not) and binary are used for 
+ * microcontroller manufactured by Nanjing Qinheng Microelectronics.
+ *******************************************************************************/
+
+/*
+ * @Note
+ * This example demonstrates a USB host reading a serial port device: CDC-ACM
+ * devices (CH343, CH9102, most microcontroller virtual COM ports) and the
+ * CH340/CH341, FTDI, CP210x and PL2303 bridges. The port is set to
+ * DEF_CDC_BAUDRATE 8N1 with DTR and RTS on, and what comes in is printed a
+ * line at a time, e.g. the NMEA sentences of a GPS receiver.
+ * USBH_CDC_Poll (usb_host_cdc.c) is called on every pass of the main loop and
+ * sends IN tokens back to back while the receive ring has room, so the bridge
+ * FIFO keeps draining; a NAK returns at once and the loop never waits on the
+ * device. Bytes queued with USBH_CDC_Write go out from the same poll.
+ * Set DEF_CDC_BENCH to measure receive throughput against a simulated device.
+ * Each transaction runs from the USBFS interrupt (USBH_Lib/usb_host_xfer.c) with
+ * the CPU in WFI while it is on the bus. DEF_USBH_XFER_EN 0 restores polling.
+*/
+
+
+#include "usb_host_config.h"
+
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Main program.
+ *
+ * @return  none
+ */
+int main(void)
+{
+
+    NVIC_PriorityGroupConfig(NVIC_PriorityGroup_1);
+    SystemCoreClockUpdate();
+    Delay_Init();
+    USART_Printf_Init(115200);
+    printf("SystemClk:%d\r\n", SystemCoreClock);
+    printf("ChipID:%08x\r\n", DBGMCU_GetCHIPID() );
+
+#if DEF_CDC_BENCH
+    USBH_CDC_Bench( );
+#endif
+
+    /* Initialize TIM3, 1mS */
+    TIM3_Init( 9, SystemCoreClock / 10000 - 1 );
+    printf( "TIM3 Init OK!\r\n" );
+
+    /* Initialize USBFS host */
+#if DEF_USBFS_PORT_EN
+    printf( "USBFS Host Init\r\n" );
+    USBFS_RCC_Init( );
+    USBFS_Host_Init( ENABLE , PWR_VDD_SupplyVoltage());
+#if DEF_USBH_XFER_EN
+    USBH_Xfer_Init( );
+#endif
+    memset( &RootHubDev.bStatus, 0, sizeof( ROOT_HUB_DEVICE ) );
+    memset( &USBH_CDC, 0, sizeof( USBH_CDC ) );
+#endif
+
+    while( 1 )
+    {
+        USBH_MainDeal( );
+    }
+}
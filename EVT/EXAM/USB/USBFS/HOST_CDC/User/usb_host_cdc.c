@@ -0,0 +1,958 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : usb_host_cdc.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : USB host CDC-ACM and USB-serial bridge class driver.
+ *                      The host controller runs one transaction at a time, so
+ *                      the bulk IN endpoint is kept busy by USBH_CDC_Poll
+ *                      sending IN tokens back to back from the main loop. A
+ *                      NAK returns at once and nothing here waits on the
+ *                      device.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Header File */
+#include "usb_host_config.h"
+
+/*******************************************************************************/
+/* Macro Definition */
+#define CDC_RX_MASK                     ( DEF_CDC_RX_RING_LEN - 1 )
+#define CDC_TX_MASK                     ( DEF_CDC_TX_RING_LEN - 1 )
+
+/* CDC-ACM Class Request */
+#define CDC_SET_LINE_CODING             0x20
+#define CDC_SET_CONTROL_LINE_STATE      0x22
+#define CDC_SUBCLASS_ACM                0x02
+#define CDC_DATA_INTERFACE_CLASS        0x0A
+
+/* CH34X Vendor Request */
+#define CH34X_REQ_READ_VERSION          0x5F
+#define CH34X_REQ_WRITE_REG             0x9A
+#define CH34X_REQ_SERIAL_INIT           0xA1
+#define CH34X_REQ_MODEM_CTRL            0xA4
+#define CH34X_REG_BAUD                  0x1312                                  // Divisor << 8 | prescaler
+#define CH34X_REG_LCR                   0x2518
+#define CH34X_LCR_8N1                   0xC3                                    // Receiver and transmitter on, 8 bits
+#define CH34X_CLKRATE                   48000000
+#define CH34X_CLK_DIV( ps, fact )       ( 1 << ( 12 - 3 * ( ps ) - ( fact ) ) )
+#define CH34X_MIN_RATE( ps )            ( CH34X_CLKRATE / ( CH34X_CLK_DIV( ( ps ), 1 ) * 512 ) )
+
+/* FTDI Vendor Request */
+#define FTDI_SIO_RESET                  0x00
+#define FTDI_SIO_MODEM_CTRL             0x01
+#define FTDI_SIO_SET_FLOW_CTRL          0x02
+#define FTDI_SIO_SET_BAUD_RATE          0x03
+#define FTDI_SIO_SET_DATA               0x04
+#define FTDI_SIO_SET_LATENCY_TIMER      0x09
+
+/* CP210X Vendor Request */
+#define CP210X_IFC_ENABLE               0x00
+#define CP210X_SET_LINE_CTL             0x03
+#define CP210X_SET_MHS                  0x07
+#define CP210X_SET_BAUDRATE             0x1E
+
+/* PL2303 Vendor Request */
+#define PL2303_VENDOR_REQ               0x01
+
+#define CDC_REQ_VENDOR_OUT              ( USB_REQ_TYP_OUT | USB_REQ_TYP_VENDOR | USB_REQ_RECIP_DEVICE )
+#define CDC_REQ_VENDOR_IN               ( USB_REQ_TYP_IN | USB_REQ_TYP_VENDOR | USB_REQ_RECIP_DEVICE )
+#define CDC_REQ_VENDOR_INTF             ( USB_REQ_TYP_OUT | USB_REQ_TYP_VENDOR | USB_REQ_RECIP_INTERF )
+#define CDC_REQ_CLASS_INTF              ( USB_REQ_TYP_OUT | USB_REQ_TYP_CLASS | USB_REQ_RECIP_INTERF )
+
+/*******************************************************************************/
+/* Constant Definition */
+/* Bridges that are not CDC-ACM class, by VID and PID */
+static const struct
+{
+    uint16_t Vid;
+    uint16_t Pid;
+    uint8_t  Type;
+} CDC_Vendor_Table[ ] =
+{
+    { 0x1A86, 0x7523, CDC_TYPE_CH34X  },
+    { 0x1A86, 0x7522, CDC_TYPE_CH34X  },
+    { 0x1A86, 0x5523, CDC_TYPE_CH34X  },
+    { 0x0403, 0x6001, CDC_TYPE_FTDI   },
+    { 0x0403, 0x6010, CDC_TYPE_FTDI   },
+    { 0x0403, 0x6014, CDC_TYPE_FTDI   },
+    { 0x0403, 0x6015, CDC_TYPE_FTDI   },
+    { 0x10C4, 0xEA60, CDC_TYPE_CP210X },
+    { 0x10C4, 0xEA70, CDC_TYPE_CP210X },
+    { 0x10C4, 0xEA71, CDC_TYPE_CP210X },
+    { 0x067B, 0x2303, CDC_TYPE_PL2303 },
+};
+
+/*******************************************************************************/
+/* Variable Definition */
+__attribute__((aligned(4))) USBH_CDC_DEV USBH_CDC;
+
+#if DEF_CDC_BENCH
+uint8_t  CDC_Sim;                                                               // Transactions go to the simulated device
+uint32_t Sim_Rate;                                                              // Bytes per second into the device, 0 - always full
+uint32_t Sim_Bus_Us;
+uint32_t Sim_Arrived;                                                           // Bytes that reached the device
+uint32_t Sim_Made;                                                              // Of those, taken into its FIFO
+uint32_t Sim_Sent;                                                              // Bytes the host acknowledged
+uint32_t Sim_Lost;                                                              // Bytes dropped on a full FIFO
+uint32_t Sim_Repeat;                                                            // Packets sent again after a lost handshake
+uint16_t Sim_Pend;                                                              // Packet waiting for its handshake
+uint16_t Sim_Lfsr;
+uint8_t  Sim_Tog;
+#endif
+
+#if DEF_CDC_BENCH
+/*********************************************************************
+ * @fn      Sim_Now
+ *
+ * @brief   Time of the simulated device: bus time of the transactions
+ *          plus the CPU time so far, SysTick counting HCLK / 8.
+ *
+ * @return  uS.
+ */
+static uint32_t Sim_Now( void )
+{
+    return Sim_Bus_Us + (uint32_t)SysTick->CNT / ( SystemCoreClock / 8000000 );
+}
+
+/*********************************************************************
+ * @fn      Sim_In
+ *
+ * @brief   Simulated device answering an IN token the way the bulk IN
+ *          endpoint of a bridge does. Byte n of the stream reads n. When
+ *          the handshake of a packet is lost the device sends it again
+ *          with the same toggle, which the host controller drops and
+ *          retries as USBFSH_Transact does.
+ *
+ * @return  ERR_SUCCESS, or USB_PID_NAK | ERR_USB_TRANSFER.
+ */
+static uint8_t Sim_In( uint8_t tog, uint16_t *plen )
+{
+    uint32_t now, room;
+    uint16_t i, n;
+
+    while( 1 )
+    {
+        /* Bytes come in at the line rate, the FIFO overruns when full */
+        if( Sim_Rate )
+        {
+            now = (uint32_t)( (uint64_t)Sim_Now( ) * Sim_Rate / 1000000 );
+            room = DEF_CDC_SIM_FIFO_LEN - ( Sim_Made - Sim_Sent );
+            if( ( now - Sim_Arrived ) > room )
+            {
+                Sim_Lost += now - Sim_Arrived - room;
+                Sim_Made += room;
+            }
+            else
+            {
+                Sim_Made += now - Sim_Arrived;
+            }
+            Sim_Arrived = now;
+        }
+        else
+        {
+            Sim_Made = Sim_Sent + DEF_CDC_SIM_FIFO_LEN;
+        }
+
+        n = Sim_Pend;
+        if( n == 0 )
+        {
+            n = ( ( Sim_Made - Sim_Sent ) < USBH_CDC.InEndpSize ) ? ( Sim_Made - Sim_Sent ) : USBH_CDC.InEndpSize;
+            if( n == 0 )
+            {
+                Sim_Bus_Us += DEF_CDC_SIM_NAK_US;
+                return ( USB_PID_NAK | ERR_USB_TRANSFER );
+            }
+        }
+        Sim_Bus_Us += DEF_CDC_SIM_NAK_US + (uint32_t)( DEF_CDC_SIM_PKT_US - DEF_CDC_SIM_NAK_US ) * n / 64;
+
+        if( tog != Sim_Tog )
+        {
+            /* Already taken by the host, acknowledged and dropped */
+            Sim_Sent += n;
+            Sim_Pend = 0;
+            Sim_Tog ^= USBFS_UH_R_TOG;
+            Sim_Repeat++;
+            Sim_Bus_Us += DEF_CDC_SIM_RETRY_US - DEF_CDC_SIM_PKT_US;
+            continue;
+        }
+
+        for( i = 0; i < n; i++ )
+        {
+            USBFS_RX_Buf[ i ] = (uint8_t)( Sim_Sent + i );
+        }
+        *plen = n;
+
+        Sim_Lfsr = ( Sim_Lfsr >> 1 ) ^ ( -( Sim_Lfsr & 1 ) & 0xB400 );
+        if( ( Sim_Lfsr % DEF_CDC_SIM_ACK_LOSS ) == 0 )
+        {
+            Sim_Pend = n;
+        }
+        else
+        {
+            Sim_Sent += n;
+            Sim_Pend = 0;
+            Sim_Tog ^= USBFS_UH_R_TOG;
+        }
+        return ERR_SUCCESS;
+    }
+}
+#endif
+
+/*********************************************************************
+ * @fn      CDC_In
+ *
+ * @brief   One IN transaction on the bulk IN endpoint, a NAK returns at
+ *          once. The data is left in USBFS_RX_Buf.
+ *
+ * @return  Result of the transaction.
+ */
+static uint8_t CDC_In( uint16_t *plen )
+{
+    uint8_t  s;
+
+#if DEF_CDC_BENCH
+    if( CDC_Sim )
+    {
+        return Sim_In( USBH_CDC.InEndpTog, plen );
+    }
+#endif
+    s = USBFSH_Transact( ( USB_PID_IN << 4 ) | USBH_CDC.InEndpAddr, USBH_CDC.InEndpTog, 0 );
+    *plen = USBFSH->RX_LEN;
+    return s;
+}
+
+/*********************************************************************
+ * @fn      CDC_Out
+ *
+ * @brief   One OUT transaction on the bulk OUT endpoint of the data in
+ *          USBFS_TX_Buf, a NAK returns at once.
+ *
+ * @return  Result of the transaction.
+ */
+static uint8_t CDC_Out( uint16_t len )
+{
+#if DEF_CDC_BENCH
+    if( CDC_Sim )
+    {
+        Sim_Bus_Us += DEF_CDC_SIM_NAK_US + (uint32_t)( DEF_CDC_SIM_PKT_US - DEF_CDC_SIM_NAK_US ) * len / 64;
+        return ERR_SUCCESS;
+    }
+#endif
+    USBFSH->HOST_TX_LEN = len;
+    return USBFSH_Transact( ( USB_PID_OUT << 4 ) | USBH_CDC.OutEndpAddr, USBH_CDC.OutEndpTog, 0 );
+}
+
+/*********************************************************************
+ * @fn      CDC_Ctrl
+ *
+ * @brief   Control request to the device.
+ *
+ * @para    type: bRequestType.
+ *          req: bRequest.
+ *          value: wValue.
+ *          index: wIndex.
+ *          pbuf: Data stage, NULL - none.
+ *          len: wLength.
+ *
+ * @return  Result of the control transfer.
+ */
+static uint8_t CDC_Ctrl( uint8_t type, uint8_t req, uint16_t value, uint16_t index, uint8_t *pbuf, uint16_t len )
+{
+    pUSBFS_SetupRequest->bRequestType = type;
+    pUSBFS_SetupRequest->bRequest = req;
+    pUSBFS_SetupRequest->wValue = value;
+    pUSBFS_SetupRequest->wIndex = index;
+    pUSBFS_SetupRequest->wLength = len;
+    return USBFSH_CtrlTransfer( USBH_CDC.Ep0_Size, pbuf, &len );
+}
+
+/*********************************************************************
+ * @fn      CH34X_Divisor
+ *
+ * @brief   Prescaler and divisor of the CH340/CH341 for a baud rate,
+ *          the highest base clock giving a divisor below 256 first.
+ *
+ * @return  ( 0x100 - divisor ) << 8 | fact << 2 | prescaler.
+ */
+static uint16_t CH34X_Divisor( uint32_t baud )
+{
+    uint32_t fact, div, clk_div;
+    int8_t   ps;
+
+    if( baud < CH34X_MIN_RATE( 0 ) )
+    {
+        baud = CH34X_MIN_RATE( 0 );
+    }
+    if( baud > CH34X_CLKRATE / ( CH34X_CLK_DIV( 3, 0 ) * 2 ) )
+    {
+        baud = CH34X_CLKRATE / ( CH34X_CLK_DIV( 3, 0 ) * 2 );
+    }
+
+    fact = 1;
+    for( ps = 3; ps > 0; ps-- )
+    {
+        if( baud > CH34X_MIN_RATE( ps ) )
+        {
+            break;
+        }
+    }
+    clk_div = CH34X_CLK_DIV( ps, fact );
+    div = CH34X_CLKRATE / ( clk_div * baud );
+    if( ( div < 9 ) || ( div > 255 ) )
+    {
+        div /= 2;
+        clk_div *= 2;
+        fact = 0;
+    }
+
+    /* Take the next divisor if its rate is closer */
+    if( ( 16 * CH34X_CLKRATE / ( clk_div * div ) - 16 * baud ) >= ( 16 * baud - 16 * CH34X_CLKRATE / ( clk_div * ( div + 1 ) ) ) )
+    {
+        div++;
+    }
+    if( ( fact == 1 ) && ( ( div & 1 ) == 0 ) )
+    {
+        div /= 2;
+        fact = 0;
+    }
+    return (uint16_t)( ( ( 0x100 - div ) << 8 ) | ( fact << 2 ) | ps );
+}
+
+/*********************************************************************
+ * @fn      FTDI_Divisor
+ *
+ * @brief   Divisor of the FTDI chips from the 3MHz base clock, with
+ *          fractions of eighths.
+ *
+ * @return  Divisor, the low 16 bits go in wValue and the rest in wIndex.
+ */
+static uint32_t FTDI_Divisor( uint32_t baud )
+{
+    static const uint8_t divfrac[ 8 ] = { 0, 3, 2, 4, 1, 5, 6, 7 };
+    uint32_t divisor3, divisor;
+
+    divisor3 = ( 24000000 + baud / 2 ) / baud;
+    divisor = divisor3 >> 3;
+    divisor |= (uint32_t)divfrac[ divisor3 & 0x07 ] << 14;
+    if( divisor == 1 )
+    {
+        divisor = 0;                                                            // 3M
+    }
+    else if( divisor == 0x4001 )
+    {
+        divisor = 1;                                                            // 2M
+    }
+    return divisor;
+}
+
+/*********************************************************************
+ * @fn      USBH_CDC_Probe
+ *
+ * @brief   Find out if the device is a serial port and take its bulk
+ *          endpoints: from the data class interface of a CDC-ACM device,
+ *          from the first interface of a known bridge.
+ *
+ * @para    pdev_buf: Device descriptor.
+ *          pcfg_buf: Whole configuration descriptor.
+ *
+ * @return  ERR_SUCCESS, ERR_USB_UNSUPPORT - not a serial port.
+ */
+uint8_t USBH_CDC_Probe( uint8_t *pdev_buf, uint8_t *pcfg_buf )
+{
+    PUSB_ITF_DESCR  pitf;
+    PUSB_ENDP_DESCR pep;
+    uint16_t i, total;
+    uint8_t  take = 0, alt = 0, intf_set = 0;
+
+    memset( &USBH_CDC, 0, sizeof( USBH_CDC ) );
+    for( i = 0; i < sizeof( CDC_Vendor_Table ) / sizeof( CDC_Vendor_Table[ 0 ] ); i++ )
+    {
+        if( ( ( (PUSB_DEV_DESCR)pdev_buf )->idVendor == CDC_Vendor_Table[ i ].Vid ) &&
+            ( ( (PUSB_DEV_DESCR)pdev_buf )->idProduct == CDC_Vendor_Table[ i ].Pid ) )
+        {
+            USBH_CDC.Type = CDC_Vendor_Table[ i ].Type;
+            if( ( (PUSB_DEV_DESCR)pdev_buf )->idProduct == 0x6010 )
+            {
+                USBH_CDC.Port = 1;                                              // FT2232, channel A
+            }
+            break;
+        }
+    }
+
+    total = ( (PUSB_CFG_DESCR)pcfg_buf )->wTotalLength;
+    if( total > DEF_COM_BUF_LEN )
+    {
+        total = DEF_COM_BUF_LEN;
+    }
+    for( i = 0; ( i + 2 ) <= total; i += pcfg_buf[ i ] )
+    {
+        if( pcfg_buf[ i ] < 2 )
+        {
+            break;
+        }
+        if( pcfg_buf[ i + 1 ] == USB_DESCR_TYP_INTERF )
+        {
+            pitf = (PUSB_ITF_DESCR)&pcfg_buf[ i ];
+            alt = pitf->bAlternateSetting;
+            if( ( USBH_CDC.Type == CDC_TYPE_NONE ) &&
+                ( pitf->bInterfaceClass == USB_DEV_CLASS_COMMUNIC ) && ( pitf->bInterfaceSubClass == CDC_SUBCLASS_ACM ) )
+            {
+                USBH_CDC.Type = CDC_TYPE_ACM;
+                USBH_CDC.Intf = pitf->bInterfaceNumber;
+                intf_set = 1;
+            }
+            else if( ( USBH_CDC.Type != CDC_TYPE_NONE ) && ( USBH_CDC.Type != CDC_TYPE_ACM ) && ( intf_set == 0 ) )
+            {
+                USBH_CDC.Intf = pitf->bInterfaceNumber;
+                intf_set = 1;
+            }
+
+            /* Bulk endpoints of the ACM data interface, or of the bridge interface */
+            if( USBH_CDC.Type == CDC_TYPE_ACM )
+            {
+                take = ( pitf->bInterfaceClass == CDC_DATA_INTERFACE_CLASS );
+            }
+            else
+            {
+                take = ( USBH_CDC.Type != CDC_TYPE_NONE ) && ( pitf->bInterfaceNumber == USBH_CDC.Intf );
+            }
+        }
+        else if( ( pcfg_buf[ i + 1 ] == USB_DESCR_TYP_ENDP ) && take && ( alt == 0 ) )
+        {
+            pep = (PUSB_ENDP_DESCR)&pcfg_buf[ i ];
+            if( ( pep->bmAttributes & 0x03 ) != 0x02 )
+            {
+                continue;
+            }
+            if( ( pep->bEndpointAddress & 0x80 ) && ( USBH_CDC.InEndpAddr == 0 ) )
+            {
+                USBH_CDC.InEndpAddr = pep->bEndpointAddress & 0x0F;
+                USBH_CDC.InEndpSize = pep->wMaxPacketSizeL | ( (uint16_t)pep->wMaxPacketSizeH << 8 );
+            }
+            else if( ( ( pep->bEndpointAddress & 0x80 ) == 0 ) && ( USBH_CDC.OutEndpAddr == 0 ) )
+            {
+                USBH_CDC.OutEndpAddr = pep->bEndpointAddress & 0x0F;
+                USBH_CDC.OutEndpSize = pep->wMaxPacketSizeL | ( (uint16_t)pep->wMaxPacketSizeH << 8 );
+            }
+        }
+    }
+
+    if( ( USBH_CDC.InEndpAddr == 0 ) || ( USBH_CDC.OutEndpAddr == 0 ) )
+    {
+        USBH_CDC.Type = CDC_TYPE_NONE;
+        return ERR_USB_UNSUPPORT;
+    }
+
+    /* Full speed packets, whatever a high speed capable chip reports */
+    if( ( USBH_CDC.InEndpSize == 0 ) || ( USBH_CDC.InEndpSize > 64 ) )
+    {
+        USBH_CDC.InEndpSize = 64;
+    }
+    if( ( USBH_CDC.OutEndpSize == 0 ) || ( USBH_CDC.OutEndpSize > 64 ) )
+    {
+        USBH_CDC.OutEndpSize = 64;
+    }
+    USBH_CDC.In_Burst = DEF_CDC_IN_BURST;
+    USBH_CDC.Rx_Skip = ( USBH_CDC.Type == CDC_TYPE_FTDI ) ? 2 : 0;
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      USBH_CDC_SetBaud
+ *
+ * @brief   Set the baud rate, 8 data bits, no parity, 1 stop bit.
+ *
+ * @return  Result of the control transfers.
+ */
+uint8_t USBH_CDC_SetBaud( uint32_t baud )
+{
+    uint8_t  buf[ 7 ];
+    uint32_t div;
+    uint8_t  s;
+
+    switch( USBH_CDC.Type )
+    {
+        case CDC_TYPE_ACM:
+        case CDC_TYPE_PL2303:
+            buf[ 0 ] = (uint8_t)baud;
+            buf[ 1 ] = (uint8_t)( baud >> 8 );
+            buf[ 2 ] = (uint8_t)( baud >> 16 );
+            buf[ 3 ] = (uint8_t)( baud >> 24 );
+            buf[ 4 ] = 0;                                                       // 1 stop bit
+            buf[ 5 ] = 0;                                                       // No parity
+            buf[ 6 ] = 8;
+            s = CDC_Ctrl( CDC_REQ_CLASS_INTF, CDC_SET_LINE_CODING, 0, USBH_CDC.Intf, buf, 7 );
+            break;
+
+        case CDC_TYPE_CH34X:
+            /* Bit 7: pass bytes on at once instead of waiting for 32 of them */
+            s = CDC_Ctrl( CDC_REQ_VENDOR_OUT, CH34X_REQ_WRITE_REG, CH34X_REG_BAUD, CH34X_Divisor( baud ) | 0x80, NULL, 0 );
+            if( ( s == ERR_SUCCESS ) && ( USBH_CDC.Version >= 0x30 ) )
+            {
+                s = CDC_Ctrl( CDC_REQ_VENDOR_OUT, CH34X_REQ_WRITE_REG, CH34X_REG_LCR, CH34X_LCR_8N1, NULL, 0 );
+            }
+            break;
+
+        case CDC_TYPE_FTDI:
+            div = FTDI_Divisor( baud );
+            s = CDC_Ctrl( CDC_REQ_VENDOR_OUT, FTDI_SIO_SET_BAUD_RATE, (uint16_t)div,
+                          ( USBH_CDC.Port ) ? ( ( ( div >> 16 ) << 8 ) | USBH_CDC.Port ) : ( div >> 16 ), NULL, 0 );
+            break;
+
+        case CDC_TYPE_CP210X:
+            buf[ 0 ] = (uint8_t)baud;
+            buf[ 1 ] = (uint8_t)( baud >> 8 );
+            buf[ 2 ] = (uint8_t)( baud >> 16 );
+            buf[ 3 ] = (uint8_t)( baud >> 24 );
+            s = CDC_Ctrl( CDC_REQ_VENDOR_INTF, CP210X_SET_BAUDRATE, 0, USBH_CDC.Intf, buf, 4 );
+            break;
+
+        default:
+            return ERR_USB_UNSUPPORT;
+    }
+    if( s == ERR_SUCCESS )
+    {
+        USBH_CDC.Baud = baud;
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      USBH_CDC_Init
+ *
+ * @brief   Bring up the serial port found by USBH_CDC_Probe: line
+ *          settings, DTR and RTS on.
+ *
+ * @para    ep0_size: Device endpoint 0 size.
+ *          baud: Baud rate.
+ *
+ * @return  Result of the control transfers.
+ */
+uint8_t USBH_CDC_Init( uint8_t ep0_size, uint32_t baud )
+{
+    /* PL2303 start-up, the same reads and writes as its vendor driver */
+    static const uint16_t pl2303_seq[ ][ 2 ] =
+    {
+        { 0x8484, 0xFFFF }, { 0x0404, 0 }, { 0x8484, 0xFFFF }, { 0x8383, 0xFFFF },
+        { 0x8484, 0xFFFF }, { 0x0404, 1 }, { 0x8484, 0xFFFF }, { 0x8383, 0xFFFF },
+        { 0x0000, 1 }, { 0x0001, 0 }, { 0x0002, 0x44 },
+    };
+    uint8_t  buf[ 2 ];
+    uint8_t  s, i;
+
+    USBH_CDC.Ep0_Size = ep0_size;
+    USBH_CDC.InEndpTog = 0;
+    USBH_CDC.OutEndpTog = 0;
+    USBH_CDC.Rx_Head = USBH_CDC.Rx_Tail = 0;
+    USBH_CDC.Tx_Head = USBH_CDC.Tx_Tail = 0;
+
+    switch( USBH_CDC.Type )
+    {
+        case CDC_TYPE_ACM:
+            s = USBH_CDC_SetBaud( baud );
+            if( s == ERR_SUCCESS )
+            {
+                s = CDC_Ctrl( CDC_REQ_CLASS_INTF, CDC_SET_CONTROL_LINE_STATE, 0x03, USBH_CDC.Intf, NULL, 0 );
+            }
+            break;
+
+        case CDC_TYPE_CH34X:
+            s = CDC_Ctrl( CDC_REQ_VENDOR_IN, CH34X_REQ_READ_VERSION, 0, 0, buf, 2 );
+            if( s != ERR_SUCCESS )
+            {
+                break;
+            }
+            USBH_CDC.Version = buf[ 0 ];
+            DUG_PRINTF( "CH34X Version: %02x\r\n", USBH_CDC.Version );
+            s = CDC_Ctrl( CDC_REQ_VENDOR_OUT, CH34X_REQ_SERIAL_INIT, 0, 0, NULL, 0 );
+            if( s == ERR_SUCCESS )
+            {
+                s = USBH_CDC_SetBaud( baud );
+            }
+            if( s == ERR_SUCCESS )
+            {
+                /* DTR and RTS on, active low */
+                s = CDC_Ctrl( CDC_REQ_VENDOR_OUT, CH34X_REQ_MODEM_CTRL, (uint8_t)~0x60, 0, NULL, 0 );
+            }
+            break;
+
+        case CDC_TYPE_FTDI:
+            s = CDC_Ctrl( CDC_REQ_VENDOR_OUT, FTDI_SIO_RESET, 0, USBH_CDC.Port, NULL, 0 );
+            if( s == ERR_SUCCESS )
+            {
+                s = CDC_Ctrl( CDC_REQ_VENDOR_OUT, FTDI_SIO_MODEM_CTRL, 0x0303, USBH_CDC.Port, NULL, 0 );
+            }
+            if( s == ERR_SUCCESS )
+            {
+                s = CDC_Ctrl( CDC_REQ_VENDOR_OUT, FTDI_SIO_SET_FLOW_CTRL, 0, USBH_CDC.Port, NULL, 0 );
+            }
+            if( s == ERR_SUCCESS )
+            {
+                s = CDC_Ctrl( CDC_REQ_VENDOR_OUT, FTDI_SIO_SET_DATA, 8, USBH_CDC.Port, NULL, 0 );
+            }
+            if( s == ERR_SUCCESS )
+            {
+                s = CDC_Ctrl( CDC_REQ_VENDOR_OUT, FTDI_SIO_SET_LATENCY_TIMER, DEF_CDC_FTDI_LATENCY, USBH_CDC.Port, NULL, 0 );
+            }
+            if( s == ERR_SUCCESS )
+            {
+                s = USBH_CDC_SetBaud( baud );
+            }
+            break;
+
+        case CDC_TYPE_CP210X:
+            s = CDC_Ctrl( CDC_REQ_VENDOR_INTF, CP210X_IFC_ENABLE, 1, USBH_CDC.Intf, NULL, 0 );
+            if( s == ERR_SUCCESS )
+            {
+                s = CDC_Ctrl( CDC_REQ_VENDOR_INTF, CP210X_SET_LINE_CTL, 0x0800, USBH_CDC.Intf, NULL, 0 );
+            }
+            if( s == ERR_SUCCESS )
+            {
+                s = CDC_Ctrl( CDC_REQ_VENDOR_INTF, CP210X_SET_MHS, 0x0303, USBH_CDC.Intf, NULL, 0 );
+            }
+            if( s == ERR_SUCCESS )
+            {
+                s = USBH_CDC_SetBaud( baud );
+            }
+            break;
+
+        case CDC_TYPE_PL2303:
+            for( i = 0, s = ERR_SUCCESS; ( i < sizeof( pl2303_seq ) / sizeof( pl2303_seq[ 0 ] ) ) && ( s == ERR_SUCCESS ); i++ )
+            {
+                if( pl2303_seq[ i ][ 1 ] == 0xFFFF )
+                {
+                    s = CDC_Ctrl( CDC_REQ_VENDOR_IN, PL2303_VENDOR_REQ, pl2303_seq[ i ][ 0 ], 0, buf, 1 );
+                }
+                else
+                {
+                    s = CDC_Ctrl( CDC_REQ_VENDOR_OUT, PL2303_VENDOR_REQ, pl2303_seq[ i ][ 0 ], pl2303_seq[ i ][ 1 ], NULL, 0 );
+                }
+            }
+            if( s == ERR_SUCCESS )
+            {
+                s = USBH_CDC_SetBaud( baud );
+            }
+            if( s == ERR_SUCCESS )
+            {
+                s = CDC_Ctrl( CDC_REQ_CLASS_INTF, CDC_SET_CONTROL_LINE_STATE, 0x03, USBH_CDC.Intf, NULL, 0 );
+            }
+            break;
+
+        default:
+            return ERR_USB_UNSUPPORT;
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      USBH_CDC_Poll
+ *
+ * @brief   Keep the bulk IN endpoint running: IN tokens back to back
+ *          while the receive ring has room for a whole packet, up to
+ *          In_Burst packets, stopping at a NAK or a short packet. Then
+ *          one packet of the transmit ring goes out. The toggle only
+ *          changes on a packet taken with the right one, so a packet
+ *          repeated after a lost handshake is dropped by the controller
+ *          and a NAK does not disturb the sequence. Call it from the main
+ *          loop as often as possible, it never waits on the device.
+ *
+ * @return  ERR_SUCCESS, or the error that ended the poll.
+ */
+uint8_t USBH_CDC_Poll( void )
+{
+    uint16_t len, ofs, n, used;
+    uint8_t  burst;
+    uint8_t  s = ERR_SUCCESS;
+
+    if( USBH_CDC.Type == CDC_TYPE_NONE )
+    {
+        return ERR_USB_UNSUPPORT;
+    }
+
+    /* Bulk IN */
+    for( burst = 0; burst < USBH_CDC.In_Burst; burst++ )
+    {
+        if( ( DEF_CDC_RX_RING_LEN - (uint16_t)( USBH_CDC.Rx_Head - USBH_CDC.Rx_Tail ) ) < USBH_CDC.InEndpSize )
+        {
+            USBH_CDC.Stat.Rx_Full++;
+            break;
+        }
+
+        s = CDC_In( &len );
+        if( s == ERR_SUCCESS )
+        {
+            USBH_CDC.InEndpTog ^= USBFS_UH_R_TOG;
+            USBH_CDC.Stat.In_Pkt++;
+            if( len > USBH_CDC.Rx_Skip )
+            {
+                /* Straight from the controller buffer into the ring */
+                n = len - USBH_CDC.Rx_Skip;
+                ofs = USBH_CDC.Rx_Head & CDC_RX_MASK;
+                if( ( ofs + n ) > DEF_CDC_RX_RING_LEN )
+                {
+                    memcpy( &USBH_CDC.Rx_Ring[ ofs ], &USBFS_RX_Buf[ USBH_CDC.Rx_Skip ], DEF_CDC_RX_RING_LEN - ofs );
+                    memcpy( USBH_CDC.Rx_Ring, &USBFS_RX_Buf[ USBH_CDC.Rx_Skip + DEF_CDC_RX_RING_LEN - ofs ], n - ( DEF_CDC_RX_RING_LEN - ofs ) );
+                }
+                else
+                {
+                    memcpy( &USBH_CDC.Rx_Ring[ ofs ], &USBFS_RX_Buf[ USBH_CDC.Rx_Skip ], n );
+                }
+                USBH_CDC.Rx_Head += n;
+                USBH_CDC.Stat.In_Byte += n;
+            }
+            if( len < USBH_CDC.InEndpSize )
+            {
+                break;
+            }
+        }
+        else if( s == ( USB_PID_NAK | ERR_USB_TRANSFER ) )
+        {
+            USBH_CDC.Stat.In_Nak++;
+            s = ERR_SUCCESS;
+            break;
+        }
+        else if( s == ( USB_PID_STALL | ERR_USB_TRANSFER ) )
+        {
+            USBH_CDC.Stat.In_Stall++;
+            s = USBFSH_ClearEndpStall( USBH_CDC.Ep0_Size, USBH_CDC.InEndpAddr | 0x80 );
+            USBH_CDC.InEndpTog = 0;
+            break;
+        }
+        else
+        {
+            USBH_CDC.Stat.In_Err++;
+            break;
+        }
+    }
+    used = USBH_CDC.Rx_Head - USBH_CDC.Rx_Tail;
+    if( used > USBH_CDC.Stat.Rx_Max )
+    {
+        USBH_CDC.Stat.Rx_Max = used;
+    }
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+
+    /* Bulk OUT, one packet */
+    used = USBH_CDC.Tx_Head - USBH_CDC.Tx_Tail;
+    if( used )
+    {
+        len = ( used < USBH_CDC.OutEndpSize ) ? used : USBH_CDC.OutEndpSize;
+        for( n = 0; n < len; n++ )
+        {
+            USBFS_TX_Buf[ n ] = USBH_CDC.Tx_Ring[ ( USBH_CDC.Tx_Tail + n ) & CDC_TX_MASK ];
+        }
+        s = CDC_Out( len );
+        if( s == ERR_SUCCESS )
+        {
+            USBH_CDC.OutEndpTog ^= USBFS_UH_T_TOG;
+            USBH_CDC.Tx_Tail += len;
+            USBH_CDC.Stat.Out_Pkt++;
+            USBH_CDC.Stat.Out_Byte += len;
+        }
+        else if( s == ( USB_PID_NAK | ERR_USB_TRANSFER ) )
+        {
+            USBH_CDC.Stat.Out_Nak++;
+            s = ERR_SUCCESS;
+        }
+        else if( s == ( USB_PID_STALL | ERR_USB_TRANSFER ) )
+        {
+            s = USBFSH_ClearEndpStall( USBH_CDC.Ep0_Size, USBH_CDC.OutEndpAddr );
+            USBH_CDC.OutEndpTog = 0;
+        }
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      USBH_CDC_RxCount
+ *
+ * @brief   Bytes waiting in the receive ring.
+ *
+ * @return  Bytes.
+ */
+uint16_t USBH_CDC_RxCount( void )
+{
+    return (uint16_t)( USBH_CDC.Rx_Head - USBH_CDC.Rx_Tail );
+}
+
+/*********************************************************************
+ * @fn      USBH_CDC_Read
+ *
+ * @brief   Take received bytes from the ring.
+ *
+ * @para    pbuf: Buffer.
+ *          len: Most bytes to take.
+ *
+ * @return  Bytes taken.
+ */
+uint16_t USBH_CDC_Read( uint8_t *pbuf, uint16_t len )
+{
+    uint16_t used, ofs, n;
+
+    used = USBH_CDC.Rx_Head - USBH_CDC.Rx_Tail;
+    if( len > used )
+    {
+        len = used;
+    }
+    ofs = USBH_CDC.Rx_Tail & CDC_RX_MASK;
+    n = ( ( ofs + len ) > DEF_CDC_RX_RING_LEN ) ? ( DEF_CDC_RX_RING_LEN - ofs ) : len;
+    memcpy( pbuf, &USBH_CDC.Rx_Ring[ ofs ], n );
+    memcpy( pbuf + n, USBH_CDC.Rx_Ring, len - n );
+    USBH_CDC.Rx_Tail += len;
+    return len;
+}
+
+/*********************************************************************
+ * @fn      USBH_CDC_Write
+ *
+ * @brief   Queue bytes for sending, they go out from USBH_CDC_Poll.
+ *
+ * @para    pbuf: Data.
+ *          len: Bytes.
+ *
+ * @return  Bytes queued, fewer than len when the ring is full.
+ */
+uint16_t USBH_CDC_Write( const uint8_t *pbuf, uint16_t len )
+{
+    uint16_t room, i;
+
+    room = DEF_CDC_TX_RING_LEN - (uint16_t)( USBH_CDC.Tx_Head - USBH_CDC.Tx_Tail );
+    if( len > room )
+    {
+        len = room;
+    }
+    for( i = 0; i < len; i++ )
+    {
+        USBH_CDC.Tx_Ring[ ( USBH_CDC.Tx_Head + i ) & CDC_TX_MASK ] = pbuf[ i ];
+    }
+    USBH_CDC.Tx_Head += len;
+    return len;
+}
+
+/*********************************************************************
+ * @fn      USBH_CDC_Stat_Print
+ *
+ * @brief   Print and clear the transfer counts.
+ *
+ * @return  none
+ */
+void USBH_CDC_Stat_Print( void )
+{
+    printf( "IN %d pkt %d B, NAK %d, err %d, stall %d, full %d, ring max %d; OUT %d pkt %d B, NAK %d\r\n",
+            USBH_CDC.Stat.In_Pkt, USBH_CDC.Stat.In_Byte, USBH_CDC.Stat.In_Nak, USBH_CDC.Stat.In_Err,
+            USBH_CDC.Stat.In_Stall, USBH_CDC.Stat.Rx_Full, USBH_CDC.Stat.Rx_Max,
+            USBH_CDC.Stat.Out_Pkt, USBH_CDC.Stat.Out_Byte, USBH_CDC.Stat.Out_Nak );
+    memset( &USBH_CDC.Stat, 0, sizeof( USBH_CDC.Stat ) );
+}
+
+#if DEF_CDC_BENCH
+/*********************************************************************
+ * @fn      Bench_Run
+ *
+ * @brief   Stream one second of simulated device time and print what
+ *          reached the reader. The reader takes what the ring holds after
+ *          every poll and checks the byte sequence, the main loop is
+ *          taken to do DEF_CDC_SIM_APP_US of other work per pass.
+ *
+ * @para    baud: Line rate into the device, 0 - device always full.
+ *          burst: IN packets per poll.
+ *          chunk: Most bytes the reader takes per pass.
+ *
+ * @return  none
+ */
+static void Bench_Run( uint32_t baud, uint8_t burst, uint16_t chunk )
+{
+    static __attribute__((aligned(4))) uint8_t buf[ 512 ];
+    uint32_t ticks, cpu_us, now, bytes = 0, err = 0;
+    uint16_t n, i;
+    uint8_t  expect = 0;
+
+    memset( &USBH_CDC.Stat, 0, sizeof( USBH_CDC.Stat ) );
+    USBH_CDC.Rx_Head = USBH_CDC.Rx_Tail = 0;
+    USBH_CDC.InEndpTog = 0;
+    USBH_CDC.In_Burst = burst;
+    Sim_Rate = baud / 10;
+    Sim_Bus_Us = Sim_Arrived = Sim_Made = Sim_Sent = Sim_Lost = Sim_Repeat = 0;
+    Sim_Pend = 0;
+    Sim_Tog = 0;
+    Sim_Lfsr = 0xACE1;
+
+    SysTick->SR &= ~( 1 << 0 );
+    SysTick->CMP = 0xFFFFFFFF;
+    SysTick->CTLR &= ~( 1 << 4 );
+    SysTick->CTLR |= ( 1 << 5 ) | ( 1 << 0 );
+
+    do
+    {
+        if( USBH_CDC_Poll( ) != ERR_SUCCESS )
+        {
+            err++;
+        }
+        do
+        {
+            n = USBH_CDC_Read( buf, ( chunk < sizeof( buf ) ) ? chunk : sizeof( buf ) );
+            for( i = 0; i < n; i++ )
+            {
+                if( buf[ i ] != expect )
+                {
+                    err++;
+                    expect = buf[ i ];
+                }
+                expect++;
+            }
+            bytes += n;
+        } while( ( n == sizeof( buf ) ) && ( chunk > sizeof( buf ) ) );
+        Sim_Bus_Us += DEF_CDC_SIM_APP_US;
+        now = Sim_Now( );
+    } while( now < 1000000 );
+
+    ticks = (uint32_t)SysTick->CNT;
+    SysTick->CTLR &= ~( 1 << 0 );
+    cpu_us = ticks / ( SystemCoreClock / 8000000 );
+
+    printf( "%7d baud, burst %d, read %4d: %4d.%02dKB/s, overrun %6d, IN %5d, NAK %6d, repeat %3d, ring max %4d, full %5d, cpu %dms, err %d\r\n",
+            baud, burst, chunk, bytes / 1000, ( bytes % 1000 ) / 10, Sim_Lost, USBH_CDC.Stat.In_Pkt,
+            USBH_CDC.Stat.In_Nak, Sim_Repeat, USBH_CDC.Stat.Rx_Max, USBH_CDC.Stat.Rx_Full, cpu_us / 1000, err );
+}
+
+/*********************************************************************
+ * @fn      USBH_CDC_Bench
+ *
+ * @brief   Receive throughput against a simulated device, so that no
+ *          serial adapter is needed: a GPS at 115200 baud, faster links,
+ *          a device that always has data, and a reader slower than the
+ *          line, over one second each. One handshake in
+ *          DEF_CDC_SIM_ACK_LOSS is lost to exercise the data toggle.
+ *
+ * @return  none
+ */
+void USBH_CDC_Bench( void )
+{
+    memset( &USBH_CDC, 0, sizeof( USBH_CDC ) );
+    USBH_CDC.Type = CDC_TYPE_ACM;
+    USBH_CDC.InEndpSize = 64;
+    USBH_CDC.OutEndpSize = 64;
+    CDC_Sim = 1;
+
+    printf( "CDC bulk IN, %dus per packet, %dus of other work per pass, ring %d\r\n",
+            DEF_CDC_SIM_PKT_US, DEF_CDC_SIM_APP_US, DEF_CDC_RX_RING_LEN );
+    Bench_Run( 115200, DEF_CDC_IN_BURST, 0xFFFF );
+    Bench_Run( 921600, DEF_CDC_IN_BURST, 0xFFFF );
+    Bench_Run( 3000000, 1, 0xFFFF );
+    Bench_Run( 3000000, DEF_CDC_IN_BURST, 0xFFFF );
+    Bench_Run( 0, 1, 0xFFFF );
+    Bench_Run( 0, DEF_CDC_IN_BURST, 0xFFFF );
+    Bench_Run( 3000000, DEF_CDC_IN_BURST, 32 );
+
+    CDC_Sim = 0;
+    memset( &USBH_CDC, 0, sizeof( USBH_CDC ) );
+}
+#endif
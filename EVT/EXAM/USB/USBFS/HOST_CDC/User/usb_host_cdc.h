@@ -0,0 +1,129 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : usb_host_cdc.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : USB host CDC-ACM and USB-serial bridge class driver,
+ *                      bulk IN kept running into a ring buffer.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+#ifndef __USB_HOST_CDC_H
+#define __USB_HOST_CDC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************/
+/* Header File */
+#include "stdint.h"
+
+/*******************************************************************************/
+/* Macro Definition */
+
+/* Serial Device Type */
+#define CDC_TYPE_NONE                   0x00
+#define CDC_TYPE_ACM                    0x01                                    // CDC-ACM class, CH343, CH9102, STM32 VCP...
+#define CDC_TYPE_CH34X                  0x02                                    // CH340, CH341
+#define CDC_TYPE_FTDI                   0x03                                    // FT232R, FT231X, FT2232
+#define CDC_TYPE_CP210X                 0x04                                    // CP2102, CP2104, CP2105
+#define CDC_TYPE_PL2303                 0x05                                    // PL2303HX
+
+/* Receive ring, a power of two. IN tokens are only sent while a whole packet
+ * fits, so a slow reader makes the device NAK instead of losing bytes. */
+#ifndef DEF_CDC_RX_RING_LEN
+#define DEF_CDC_RX_RING_LEN             2048
+#endif
+#ifndef DEF_CDC_TX_RING_LEN
+#define DEF_CDC_TX_RING_LEN             256
+#endif
+
+/* IN packets taken in one USBH_CDC_Poll, the burst ends early at a NAK or a
+ * short packet. One packet costs about 60us of bus time at full speed. */
+#ifndef DEF_CDC_IN_BURST
+#define DEF_CDC_IN_BURST                8
+#endif
+
+#ifndef DEF_CDC_BAUDRATE
+#define DEF_CDC_BAUDRATE                115200
+#endif
+#define DEF_CDC_FTDI_LATENCY            2                                       // mS, FTDI sends what it has after this
+
+/* Benchmark against a simulated device, see USBH_CDC_Bench */
+#ifndef DEF_CDC_BENCH
+#define DEF_CDC_BENCH                   0
+#endif
+#define DEF_CDC_SIM_PKT_US              60                                      // 64 bytes of bulk IN with token and handshake
+#define DEF_CDC_SIM_NAK_US              8                                       // IN token answered by NAK
+#define DEF_CDC_SIM_RETRY_US            80                                      // Repeated packet dropped and the IN sent again
+#define DEF_CDC_SIM_FIFO_LEN            512                                     // Receive FIFO of the bridge chip
+#define DEF_CDC_SIM_ACK_LOSS            97                                      // One handshake in this many is lost
+#define DEF_CDC_SIM_APP_US              200                                     // Work of the main loop between polls
+
+/*******************************************************************************/
+/* Struct Definition */
+typedef struct _USBH_CDC_STAT
+{
+    uint32_t In_Pkt;
+    uint32_t In_Byte;                                                           // Payload, FTDI status bytes not counted
+    uint32_t In_Nak;
+    uint32_t In_Err;
+    uint32_t In_Stall;
+    uint32_t Rx_Full;                                                           // Polls that sent no IN for lack of room
+    uint16_t Rx_Max;                                                            // Highest fill of the receive ring
+    uint32_t Out_Pkt;
+    uint32_t Out_Byte;
+    uint32_t Out_Nak;
+} USBH_CDC_STAT;
+
+typedef struct _USBH_CDC_DEV
+{
+    uint8_t  Type;
+    uint8_t  Intf;                                                              // Interface the requests go to, ACM - communication interface
+    uint8_t  Ep0_Size;
+    uint8_t  InEndpAddr;
+    uint8_t  InEndpTog;
+    uint8_t  OutEndpAddr;
+    uint8_t  OutEndpTog;
+    uint8_t  In_Burst;
+    uint8_t  Rx_Skip;                                                           // Status bytes heading every IN packet
+    uint8_t  Version;                                                           // CH34X chip version
+    uint8_t  Port;                                                              // FTDI channel, 0 - single port chip
+    uint16_t InEndpSize;
+    uint16_t OutEndpSize;
+    uint16_t Rx_Head;                                                           // Free running, masked on access
+    uint16_t Rx_Tail;
+    uint16_t Tx_Head;
+    uint16_t Tx_Tail;
+    uint32_t Baud;
+    USBH_CDC_STAT Stat;
+    __attribute__((aligned(4))) uint8_t Rx_Ring[ DEF_CDC_RX_RING_LEN ];
+    __attribute__((aligned(4))) uint8_t Tx_Ring[ DEF_CDC_TX_RING_LEN ];
+} USBH_CDC_DEV;
+
+/*******************************************************************************/
+/* Variable Declaration */
+extern USBH_CDC_DEV USBH_CDC;
+
+/*******************************************************************************/
+/* Function Declaration */
+extern uint8_t USBH_CDC_Probe( uint8_t *pdev_buf, uint8_t *pcfg_buf );
+extern uint8_t USBH_CDC_Init( uint8_t ep0_size, uint32_t baud );
+extern uint8_t USBH_CDC_SetBaud( uint32_t baud );
+extern uint8_t USBH_CDC_Poll( void );
+extern uint16_t USBH_CDC_RxCount( void );
+extern uint16_t USBH_CDC_Read( uint8_t *pbuf, uint16_t len );
+extern uint16_t USBH_CDC_Write( const uint8_t *pbuf, uint16_t len );
+extern void USBH_CDC_Stat_Print( void );
+extern void USBH_CDC_Bench( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -15,6 +15,7 @@
   *This routine is used in conjunction with HOST_IAP, as the APP demonstration code, and prints  
   *This is a APP code for a IAP application.
  *PA0 pulls the erase flag low, and jumps to IAP after soft reset.
+ *Once running, the APP confirms its image, or HOST_IAP stops starting it after IAP_BOOT_TRIES resets.
 */
 
 #include "debug.h"
@@ -25,17 +26,21 @@
 
 /* APP CODE ADDR Setting */
 #define DEF_APP_CODE_START_ADDR           0x08006000                             /* IAP Flash Operation start address, user code start address */
-#define DEF_APP_CODE_END_ADDR             0x08010000                             /* IAP Flash Operation end address, user code end address */
+#define DEF_APP_CODE_END_ADDR             0x0800F700                             /* IAP Flash Operation end address, user code end address, the verify-code page follows */
                                                                                  /* Please refer to link.ld file for accuracy flash size, the size here is the smallest available size */
 
 #define DEF_APP_CODE_MAXLEN               (DEF_APP_CODE_END_ADDR-DEF_APP_CODE_START_ADDR) /* IAP Flash Operation size, user code max size */
 
 /* Verify CODE ADDR Setting */
-#define DEF_VERIFY_CODE_START_ADDR        0x08007F00                             /* IAP Flash verify-code start address */
-#define DEF_VERIFY_CODE_END_ADDR          0x08008000                             /* IAP Flash verify-code end address */
+#define DEF_VERIFY_CODE_START_ADDR        0x0800F700                             /* IAP Flash verify-code start address, past the user code */
+#define DEF_VERIFY_CODE_END_ADDR          0x0800F800                             /* IAP Flash verify-code end address */
 #define DEF_VERIFY_CODE_MAXLEN            (DEF_VERIFY_CODE_END_ADDR-DEF_VERIFY_CODE_START_ADDR) /* IAP Flash verify-code max size */
 #define DEF_VERIFY_CODE_LEN               0x10                                   /* IAP Flash verify-code actual length, be careful not to exceed the DEF_VERIFY_CODE_MAXLEN */
 
+/* Image record kept in the verify-code page by HOST_IAP (see iap_image.h): Magic, Len, Crc, Boot */
+#define IAP_IMAGE_MAGIC                   0x49484357                             /* "WCHI" */
+#define IAP_BOOT_OK                       0x4B4F4B4F                             /* Boot word of a confirmed image */
+
 /* Flash Operation Key Setting */
 #define DEF_FLASH_OPERATION_KEY_CODE_0    0x1A86FF00                             /* IAP Flash operation Key-code 0 */
 #define DEF_FLASH_OPERATION_KEY_CODE_1    0x55AA55AA                             /* IAP Flash operation Key-code 1 */
@@ -50,6 +55,7 @@ volatile uint32_t Flash_Operation_Key1;
 void    GPIO_Cfg_init( void );
 uint8_t PA0_Check( void );
 uint8_t IAP_VerifyCode_Erase( void );
+uint8_t IAP_VerifyCode_Confirm( void );
 uint8_t IAP_Flash_Erase( uint32_t address, uint32_t length );
 
 /*********************************************************************
@@ -75,6 +81,9 @@ int main(void)
 
 	Flash_Operation_Key0 = DEF_FLASH_OPERATION_KEY_CODE_0;
 
+	/* Up and running: keep being started by the IAP */
+	IAP_VerifyCode_Confirm( );
+
 	while(1)
 	{
 	    ret = PA0_Check( );
@@ -172,6 +181,52 @@ uint8_t  IAP_VerifyCode_Erase( void )
     return 0;
 }
 
+/*********************************************************************
+ * @fn      IAP_VerifyCode_Confirm
+ *
+ * @brief   Confirm an image on trial, so HOST_IAP keeps starting it,
+ *          Based On Fast Flash Operation.
+ *          With address protection and program runaway protection.
+ *
+ * @return  ret : The meaning of 'ret' can be found in the notes of the
+ *          corresponding function.
+ */
+uint8_t IAP_VerifyCode_Confirm( void )
+{
+    uint32_t buf[ DEF_FLASH_PAGE_SIZE / 4 ];
+    uint16_t i;
+    uint8_t  ret;
+
+    if( ( *(__IO uint32_t*)DEF_VERIFY_CODE_START_ADDR != IAP_IMAGE_MAGIC ) ||
+        ( *(__IO uint32_t*)( DEF_VERIFY_CODE_START_ADDR + 12 ) == IAP_BOOT_OK ) )
+    {
+        return 0;
+    }
+    for( i = 0; i < DEF_FLASH_PAGE_SIZE / 4; i++ )
+    {
+        buf[ i ] = *(__IO uint32_t*)( DEF_VERIFY_CODE_START_ADDR + 4 * i );
+    }
+    buf[ 3 ] = IAP_BOOT_OK;
+
+    /* Verify Code Rewrite */
+    Flash_Operation_Key1 = DEF_FLASH_OPERATION_KEY_CODE_1;
+    ret = IAP_Flash_Erase( DEF_VERIFY_CODE_START_ADDR, DEF_FLASH_PAGE_SIZE );
+    if( ( ret == 0 ) && ( Flash_Operation_Key1 == DEF_FLASH_OPERATION_KEY_CODE_1 ) )
+    {
+        FLASH_Unlock_Fast( );
+        FLASH_BufReset( );
+        for( i = 0; i < DEF_FLASH_PAGE_SIZE / 4; i++ )
+        {
+            FLASH_BufLoad( DEF_VERIFY_CODE_START_ADDR + 4 * i, buf[ i ] );
+        }
+        FLASH_ProgramPage_Fast( DEF_VERIFY_CODE_START_ADDR );
+        FLASH_Lock_Fast( );
+    }
+    Flash_Operation_Key1 = 0;
+
+    return ret;
+}
+
 /*********************************************************************
  * @fn      GPIO_Cfg_init
  *
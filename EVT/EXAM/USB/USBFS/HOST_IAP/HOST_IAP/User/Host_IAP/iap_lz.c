@@ -0,0 +1,172 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_lz.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Streaming decoder of compressed IAP images, needs
+ *                      no RAM besides its state and the output ring.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#include "iap_lz.h"
+
+static const uint8_t IAP_LZ_Magic[ 4 ] = { 'W', 'C', 'H', 'Z' };
+
+/*********************************************************************
+ * @fn      IAP_LZ_Check
+ *
+ * @brief   Check whether received data starts a compressed image.
+ *
+ * @param   pbuf - first bytes of the image
+ *          len - length
+ *
+ * @return  1 - compressed, 0 - plain
+ */
+uint8_t IAP_LZ_Check(const uint8_t *pbuf, uint32_t len)
+{
+    uint8_t i;
+
+    if (len < sizeof(IAP_LZ_Magic)) {
+        return 0;
+    }
+    for (i = 0; i < sizeof(IAP_LZ_Magic); i++) {
+        if (pbuf[i] != IAP_LZ_Magic[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*********************************************************************
+ * @fn      IAP_LZ_Init
+ *
+ * @brief   Start decoding an image, header included.
+ *
+ * @param   pring - output ring
+ *          ring_len - its size, a power of two of at least IAP_LZ_WINDOW
+ *
+ * @return  none
+ */
+void IAP_LZ_Init(IAP_LZ_DEC *pdec, uint8_t *pring, uint16_t ring_len)
+{
+    pdec->pRing = pring;
+    pdec->Ring_Mask = ring_len - 1;
+    pdec->Len = 0;
+    pdec->State = IAP_LZ_ST_HEAD;
+    pdec->Cnt = 0;
+    pdec->Out = 0;
+    pdec->Limit = ring_len;
+    pdec->Size = 0;
+    pdec->Crc = 0;
+}
+
+/*********************************************************************
+ * @fn      IAP_LZ_Decode
+ *
+ * @brief   Decode into the ring until the input is used up, Limit is
+ *          reached or the image is complete. A match cut by Limit is
+ *          finished by the next call, which may pass no input.
+ *
+ * @param   pbuf - compressed data
+ *          len - length
+ *
+ * @return  bytes of input used
+ */
+uint32_t IAP_LZ_Decode(IAP_LZ_DEC *pdec, const uint8_t *pbuf, uint32_t len)
+{
+    uint8_t *ring = pdec->pRing;
+    uint16_t mask = pdec->Ring_Mask;
+    uint32_t n = 0;
+    uint8_t c;
+
+    while (pdec->State < IAP_LZ_ST_DONE) {
+        /* Match copy, bytes may overlap the ones being written */
+        while (pdec->Len && (pdec->Out != pdec->Limit)) {
+            ring[pdec->Out & mask] = ring[(pdec->Out - pdec->Dist) & mask];
+            pdec->Out++;
+            pdec->Len--;
+        }
+        if (pdec->Len) {
+            break;
+        }
+        if ((pdec->State != IAP_LZ_ST_HEAD) && (pdec->Out == pdec->Size)) {
+            pdec->State = IAP_LZ_ST_DONE;
+            break;
+        }
+        if ((n == len) || (pdec->Out == pdec->Limit)) {
+            break;
+        }
+        c = pbuf[n++];
+
+        switch (pdec->State) {
+        case IAP_LZ_ST_HEAD:
+            if (pdec->Cnt < 4) {
+                if (c != IAP_LZ_Magic[pdec->Cnt]) {
+                    pdec->State = IAP_LZ_ST_ERR;
+                }
+            } else if (pdec->Cnt < 8) {
+                pdec->Size |= (uint32_t)c << (8 * (pdec->Cnt - 4));
+            } else {
+                pdec->Crc |= (uint32_t)c << (8 * (pdec->Cnt - 8));
+            }
+            if (++pdec->Cnt == IAP_LZ_HEAD_LEN) {
+                pdec->State = pdec->Size ? IAP_LZ_ST_FLAG : IAP_LZ_ST_DONE;
+            }
+            break;
+
+        case IAP_LZ_ST_FLAG:
+            pdec->Flag = c;
+            pdec->Cnt = 8;
+            pdec->State = IAP_LZ_ST_ITEM;
+            break;
+
+        case IAP_LZ_ST_ITEM:
+            if (pdec->Flag & 1) {
+                pdec->Lo = c;
+                pdec->State = IAP_LZ_ST_MATCH;
+                break;
+            }
+            ring[pdec->Out++ & mask] = c;
+            goto next_item;
+
+        case IAP_LZ_ST_MATCH:
+            pdec->Dist = (((uint16_t)(c & 1) << 8) | pdec->Lo) + 1;
+            pdec->Len = (c >> 1) + IAP_LZ_MIN_MATCH;
+            if ((pdec->Dist > pdec->Out) || (pdec->Len > pdec->Size - pdec->Out)) {
+                pdec->State = IAP_LZ_ST_ERR;
+                break;
+            }
+        next_item:
+            pdec->Flag >>= 1;
+            pdec->State = --pdec->Cnt ? IAP_LZ_ST_ITEM : IAP_LZ_ST_FLAG;
+            break;
+        }
+    }
+
+    return n;
+}
+
+/*********************************************************************
+ * @fn      IAP_LZ_Crc32
+ *
+ * @brief   CRC32 (IEEE 802.3) without a table, can be chained.
+ *
+ * @param   crc - 0, or the result for the data before
+ *
+ * @return  CRC32
+ */
+uint32_t IAP_LZ_Crc32(uint32_t crc, const uint8_t *pbuf, uint32_t len)
+{
+    uint8_t i;
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *pbuf++;
+        for (i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
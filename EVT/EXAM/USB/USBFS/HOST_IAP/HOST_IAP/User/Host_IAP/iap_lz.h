@@ -0,0 +1,73 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : iap_lz.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Streaming decoder of compressed IAP images.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#ifndef __IAP_LZ_H
+#define __IAP_LZ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*
+ * Image format, all numbers little endian:
+ *   'W' 'C' 'H' 'Z' - magic, a plain image never starts like this
+ *   size (4 bytes)  - length of the decoded image
+ *   crc (4 bytes)   - CRC32 (IEEE 802.3) of the decoded image
+ *   then groups of a flag byte and 8 items, flag bit 0 first:
+ *   bit 0 - a literal byte
+ *   bit 1 - a match of 2 bytes: d[7:0], then l[6:0] d[8]; copy l+3 bytes
+ *           from d+1 bytes back in the decoded image
+ * Decoding stops at size, so the last group may be short.
+ */
+#define IAP_LZ_HEAD_LEN   12
+#define IAP_LZ_WINDOW     512
+#define IAP_LZ_MIN_MATCH  3
+#define IAP_LZ_MAX_MATCH  ( IAP_LZ_MIN_MATCH + 127 )
+
+/* State */
+#define IAP_LZ_ST_HEAD    0
+#define IAP_LZ_ST_FLAG    1
+#define IAP_LZ_ST_ITEM    2
+#define IAP_LZ_ST_MATCH   3
+#define IAP_LZ_ST_DONE    4
+#define IAP_LZ_ST_ERR     5
+
+/* The decoded image is written into a ring that also serves as the window:
+ * the caller programs it out and raises Limit, keeping at least the last
+ * IAP_LZ_WINDOW bytes in it. */
+typedef struct _IAP_LZ_DEC
+{
+    uint8_t  *pRing;
+    uint16_t Ring_Mask;                                       // Ring size - 1, a power of two >= IAP_LZ_WINDOW
+    uint16_t Dist;                                            // Match being copied
+    uint16_t Len;
+    uint8_t  State;
+    uint8_t  Cnt;                                             // Header bytes read or items left in the group
+    uint8_t  Flag;
+    uint8_t  Lo;
+    uint32_t Out;                                             // Bytes decoded
+    uint32_t Limit;                                           // Decoding pauses here, set by the caller
+    uint32_t Size;
+    uint32_t Crc;
+} IAP_LZ_DEC;
+
+extern uint8_t  IAP_LZ_Check( const uint8_t *pbuf, uint32_t len );
+extern void     IAP_LZ_Init( IAP_LZ_DEC *pdec, uint8_t *pring, uint16_t ring_len );
+extern uint32_t IAP_LZ_Decode( IAP_LZ_DEC *pdec, const uint8_t *pbuf, uint32_t len );
+extern uint32_t IAP_LZ_Crc32( uint32_t crc, const uint8_t *pbuf, uint32_t len );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
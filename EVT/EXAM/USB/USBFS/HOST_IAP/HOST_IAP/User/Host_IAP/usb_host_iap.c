@@ -19,13 +19,15 @@ __attribute__((aligned(4))) uint8_t  DevDesc_Buf[ 18 ];                 // Devic
 volatile   uint32_t  IAP_Load_Addr_Offset;
 volatile   uint32_t  IAP_WriteIn_Length;
 volatile   uint32_t  IAP_WriteIn_Count;
+IAP_LZ_DEC IAP_Lz_Dec;                                                  // Decoder of a compressed APP.BIN
+uint8_t    IAP_Lz_Flag;                                                 // 1 - APP.BIN is compressed
+uint32_t   IAP_Img_Crc;                                                 // CRC32 of the code programmed so far
+uint8_t    IAP_Head_Flag;                                               // 1 - APP.BIN starts with the IAP_IMAGE header
+uint32_t   IAP_Head_Len;
+uint32_t   IAP_Head_Crc;
 struct   _ROOT_HUB_DEVICE RootHubDev[ DEF_TOTAL_ROOT_HUB ];
 struct   __HOST_CTL HostCtl[ DEF_TOTAL_ROOT_HUB * DEF_ONE_USB_SUP_DEV_TOTAL ];
 
-/* Verify Code */
-const uint8_t Verify_Code[ DEF_VERIFY_CODE_LEN ] =
-{ '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
-
 /* Flash Operation Key */
 volatile uint32_t Flash_Operation_Key0;
 volatile uint32_t Flash_Operation_Key1;
@@ -407,20 +409,31 @@ uint32_t IAP_Flash_Program(uint32_t address, uint8_t* buff, uint32_t length)
  *          If an operation is unsuccessful,the code will repeat the
  *          operation up to 5 times and if it is still unsuccessful,
  *          an error code will be returned.
+ *          The verify-code is the record of the image just programmed,
+ *          on trial for IAP_BOOT_TRIES starts.
+ *
+ * @para    len: image length
+ *          crc: CRC32 of the image
  *
  * @return  ret : The meaning of 'ret' can be found in the notes of the
  *          corresponding function.
  */
-uint32_t IAP_VerifyCode_Write(void)
+uint32_t IAP_VerifyCode_Write(uint32_t len, uint32_t crc)
 {
     uint32_t ret;
     uint8_t  rty_cnts;
+    IAP_IMAGE_INFO info;
     rty_cnts = 0;
 
+    info.Magic = IAP_IMAGE_MAGIC;
+    info.Len = len;
+    info.Crc = crc;
+    info.Boot = IAP_BOOT_TRIES;
+
 IAP_VERIFYCODE_RTY:
     /* Verify Code Write-in */
     Flash_Operation_Key1 = DEF_FLASH_OPERATION_KEY_CODE_1;
-    ret = IAP_Flash_Write(DEF_VERIFY_CODE_START_ADDR, (uint8_t*)Verify_Code, DEF_VERIFY_CODE_LEN);
+    ret = IAP_Flash_Write(DEF_VERIFY_CODE_START_ADDR, (uint8_t*)&info, DEF_VERIFY_CODE_LEN);
     Flash_Operation_Key1 = 0;
     if(ret != 0)
     {
@@ -429,7 +442,7 @@ IAP_VERIFYCODE_RTY:
 
     /* Verify Code Check */
     Flash_Operation_Key1 = DEF_FLASH_OPERATION_KEY_CODE_1;
-    ret = IAP_Flash_Verify(DEF_VERIFY_CODE_START_ADDR, (uint8_t*)Verify_Code, DEF_VERIFY_CODE_LEN);
+    ret = IAP_Flash_Verify(DEF_VERIFY_CODE_START_ADDR, (uint8_t*)&info, DEF_VERIFY_CODE_LEN);
     Flash_Operation_Key1 = 0;
     if(ret != 0)
     {
@@ -449,23 +462,48 @@ IAP_VERIFYCODE_RTY:
  *
  * @brief   Check IAP VerifyCode,
  *          With address protection and program runaway protection.
+ *          The CRC32 of the user code must match the record, and an
+ *          image on trial must have a try left, which is used up here.
  *
- * @return  ret : The meaning of 'ret' can be found in the notes of the
- *          corresponding function.
+ * @return  0: start the user code
+ *          DEF_IAP_ERR_VERIFY: no valid image, or no try left
+ *          See notes of IAP_Flash_Read / IAP_Flash_Write for other errors
  */
 uint32_t IAP_VerifyCode_Check(void)
 {
     uint32_t ret;
-    /* Verify Code Check */
+    IAP_IMAGE_INFO info;
+
+    /* Verify Code Read */
     Flash_Operation_Key1 = DEF_FLASH_OPERATION_KEY_CODE_1;
-    ret = IAP_Flash_Verify(DEF_VERIFY_CODE_START_ADDR, (uint8_t*)Verify_Code, DEF_VERIFY_CODE_LEN);
+    ret = IAP_Flash_Read(DEF_VERIFY_CODE_START_ADDR, (uint8_t*)&info, DEF_VERIFY_CODE_LEN);
     Flash_Operation_Key1 = 0;
     if(ret != 0)
     {
         return ret;
     }
+    if((info.Magic != IAP_IMAGE_MAGIC) || (info.Len == 0) || (info.Len > DEF_APP_CODE_MAXLEN) ||
+       (IAP_LZ_Crc32(0, (const uint8_t *)DEF_APP_CODE_START_ADDR, info.Len) != info.Crc))
+    {
+        return DEF_IAP_ERR_VERIFY;
+    }
+    if(info.Boot == IAP_BOOT_OK)
+    {
+        return 0;
+    }
+    if((info.Boot == 0) || (info.Boot > IAP_BOOT_TRIES))
+    {
+        /* The image never confirmed itself */
+        return DEF_IAP_ERR_VERIFY;
+    }
 
-    return 0;
+    /* Use up a try */
+    info.Boot--;
+    Flash_Operation_Key1 = DEF_FLASH_OPERATION_KEY_CODE_1;
+    ret = IAP_Flash_Write(DEF_VERIFY_CODE_START_ADDR, (uint8_t*)&info, DEF_VERIFY_CODE_LEN);
+    Flash_Operation_Key1 = 0;
+
+    return ret;
 }
 
 /*********************************************************************
@@ -565,8 +603,8 @@ void mStopIfError( uint8_t iError )
 /*********************************************************************
  * @fn      IAP_Check_Verify_Code
  *
- * @brief   Check IAP Verify-Code if exists, if exists then jump to APP Code,
- *          else if stay in IAP code
+ * @brief   Check IAP Verify-Code if exists and matches the APP Code, if so
+ *          then jump to APP Code, else if stay in IAP code
  *
  * @return  none
  */
@@ -581,7 +619,7 @@ void IAP_Check_Verify_Code(void)
         /* Jump User Application */
         IAP_Jump_APP( );
     }
-    DUG_PRINTF( "Verify-Code Not Exists, Goto UDisk Operation.\r\n" );
+    DUG_PRINTF( "Verify-Code Not Exists Or Not Matching, Goto UDisk Operation.\r\n" );
 }
 
 /*********************************************************************
@@ -814,6 +852,193 @@ uint8_t IAP_USBH_PreDeal( void )
     return DEF_IAP_DEFAULT;
 }
 
+/*********************************************************************
+ * @fn      IAP_Get32
+ *
+ * @brief   Little endian word at any alignment.
+ *
+ * @return  word
+ */
+static uint32_t IAP_Get32( const uint8_t *p )
+{
+    return p[ 0 ] | ( (uint32_t)p[ 1 ] << 8 ) | ( (uint32_t)p[ 2 ] << 16 ) | ( (uint32_t)p[ 3 ] << 24 );
+}
+
+/*********************************************************************
+ * @fn      IAP_Load_Program
+ *
+ * @brief   Program a piece of the image and add it, as read back from
+ *          flash, to the CRC32 of the image.
+ *
+ * @para    offset: offset in the user code area
+ *          pbuf: code
+ *          len: length
+ *
+ * @return  0: Operation Success
+ *          DEF_IAP_ERR_LENGTH, or see notes of IAP_Flash_Program
+ */
+static uint32_t IAP_Load_Program( uint32_t offset, uint8_t *pbuf, uint32_t len )
+{
+    uint32_t ret;
+
+    if( offset + len > DEF_APP_CODE_MAXLEN )
+    {
+        return DEF_IAP_ERR_LENGTH;
+    }
+    ret = IAP_Flash_Program( DEF_APP_CODE_START_ADDR + offset, pbuf, len );
+    if( ret == 0 )
+    {
+        IAP_Img_Crc = IAP_LZ_Crc32( IAP_Img_Crc, (const uint8_t *)( DEF_APP_CODE_START_ADDR + offset ), len );
+    }
+    return ret;
+}
+
+/*********************************************************************
+ * @fn      IAP_Load_Data
+ *
+ * @brief   Take the next piece of APP.BIN and program the load buffer
+ *          whenever enough of it is filled. A file starting with the
+ *          IAP_LZ header is decoded into the buffer on the way, the
+ *          IAP_IMAGE header of a plain file is kept aside.
+ *
+ * @para    pbuf: file data
+ *          len: length
+ *
+ * @return  0: Operation Success
+ *          See notes of IAP_Flash_Program for other errors
+ */
+uint32_t IAP_Load_Data( uint8_t *pbuf, uint32_t len )
+{
+    uint32_t i, n, ret;
+
+    if( ( IAP_WriteIn_Count == 0 ) && ( IAP_WriteIn_Length == 0 ) && ( IAP_Lz_Flag == 0 ) && IAP_LZ_Check( pbuf, len ) )
+    {
+        DUG_PRINTF( "Compressed File.\r\n" );
+        IAP_LZ_Init( &IAP_Lz_Dec, IAPLoadBuffer, DEF_MAX_IAP_BUFFER_LEN );
+        IAP_Lz_Flag = 1;
+    }
+    if( ( IAP_WriteIn_Count == 0 ) && ( IAP_WriteIn_Length == 0 ) && ( IAP_Lz_Flag == 0 ) && ( IAP_Head_Flag == 0 ) &&
+        ( len >= IAP_IMAGE_HEAD_LEN ) && ( IAP_Get32( pbuf ) == IAP_IMAGE_MAGIC ) )
+    {
+        DUG_PRINTF( "File With Image Header.\r\n" );
+        IAP_Head_Len = IAP_Get32( pbuf + 4 );
+        IAP_Head_Crc = IAP_Get32( pbuf + 8 );
+        IAP_Head_Flag = 1;
+        pbuf += IAP_IMAGE_HEAD_LEN;
+        len -= IAP_IMAGE_HEAD_LEN;
+    }
+
+    if( IAP_Lz_Flag == 0 )
+    {
+        for( i = 0; i < len; i++ )
+        {
+            IAPLoadBuffer[ IAP_WriteIn_Length ] = pbuf[ i ];
+            IAP_WriteIn_Length++;
+            /* The whole package part of the IAP user file */
+            if( IAP_WriteIn_Length == DEF_MAX_IAP_BUFFER_LEN )
+            {
+                /* Write Data In Flash */
+                ret = IAP_Load_Program( IAP_Load_Addr_Offset, IAPLoadBuffer, IAP_WriteIn_Length );
+                if( ret != 0 )
+                {
+                    return ret;
+                }
+                IAP_Load_Addr_Offset += DEF_MAX_IAP_BUFFER_LEN;
+                IAP_WriteIn_Count += IAP_WriteIn_Length;
+                IAP_WriteIn_Length = 0;
+            }
+        }
+        return 0;
+    }
+
+    /* Decode until the input is used, programming a half of the buffer each
+     * time the decoder runs into the half not programmed yet */
+    do
+    {
+        IAP_Lz_Dec.Limit = IAP_WriteIn_Count + DEF_MAX_IAP_BUFFER_LEN;
+        n = IAP_LZ_Decode( &IAP_Lz_Dec, pbuf, len );
+        pbuf += n;
+        len -= n;
+        if( ( IAP_Lz_Dec.State == IAP_LZ_ST_ERR ) ||
+            ( ( IAP_Lz_Dec.State != IAP_LZ_ST_HEAD ) && ( IAP_Lz_Dec.Size > DEF_APP_CODE_MAXLEN ) ) )
+        {
+            return DEF_IAP_ERR_DECODE;
+        }
+        if( IAP_Lz_Dec.Out - IAP_WriteIn_Count >= DEF_IAP_LZ_FLUSH_LEN )
+        {
+            ret = IAP_Load_Program( IAP_WriteIn_Count,
+                                    &IAPLoadBuffer[ IAP_WriteIn_Count & ( DEF_MAX_IAP_BUFFER_LEN - 1 ) ], DEF_IAP_LZ_FLUSH_LEN );
+            if( ret != 0 )
+            {
+                return ret;
+            }
+            IAP_WriteIn_Count += DEF_IAP_LZ_FLUSH_LEN;
+        }
+    } while( ( len && ( IAP_Lz_Dec.State < IAP_LZ_ST_DONE ) ) || ( IAP_Lz_Dec.Out == IAP_Lz_Dec.Limit ) );
+
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      IAP_Load_End
+ *
+ * @brief   Program what is left in the load buffer and check the whole
+ *          file was written, and the CRC32 taken while programming against
+ *          the header of a compressed or headed file.
+ *
+ * @return  0: Operation Success
+ *          DEF_IAP_ERR_LENGTH, DEF_IAP_ERR_DECODE, DEF_IAP_ERR_VERIFY, or
+ *          see notes of IAP_Flash_Program for other errors
+ */
+uint32_t IAP_Load_End( void )
+{
+    uint32_t ret;
+
+    if( IAP_Lz_Flag == 0 )
+    {
+        /* Disposal of remaining package length  */
+        ret = IAP_Load_Program( IAP_Load_Addr_Offset, IAPLoadBuffer, IAP_WriteIn_Length );
+        if( ret != 0 )
+        {
+            return ret;
+        }
+        IAP_WriteIn_Count += IAP_WriteIn_Length;
+        /* Check actual write length and file length */
+        DUG_PRINTF( "\r\nFileSze : %d,%d.\r\n", (int)CHRV3vFileSize, IAP_WriteIn_Count );
+        if( CHRV3vFileSize != IAP_WriteIn_Count + ( IAP_Head_Flag ? IAP_IMAGE_HEAD_LEN : 0 ) )
+        {
+            return DEF_IAP_ERR_LENGTH;
+        }
+        if( IAP_Head_Flag && ( ( IAP_WriteIn_Count != IAP_Head_Len ) || ( IAP_Img_Crc != IAP_Head_Crc ) ) )
+        {
+            return DEF_IAP_ERR_VERIFY;
+        }
+        return 0;
+    }
+
+    if( IAP_Lz_Dec.State != IAP_LZ_ST_DONE )
+    {
+        return DEF_IAP_ERR_DECODE;
+    }
+    /* Less than a half is left, in the half being filled */
+    if( IAP_Lz_Dec.Out > IAP_WriteIn_Count )
+    {
+        ret = IAP_Load_Program( IAP_WriteIn_Count,
+                                &IAPLoadBuffer[ IAP_WriteIn_Count & ( DEF_MAX_IAP_BUFFER_LEN - 1 ) ], IAP_Lz_Dec.Out - IAP_WriteIn_Count );
+        if( ret != 0 )
+        {
+            return ret;
+        }
+        IAP_WriteIn_Count = IAP_Lz_Dec.Out;
+    }
+    DUG_PRINTF( "\r\nFileSze : %d,%d.\r\n", (int)CHRV3vFileSize, IAP_WriteIn_Count );
+    if( IAP_Img_Crc != IAP_Lz_Dec.Crc )
+    {
+        return DEF_IAP_ERR_VERIFY;
+    }
+    return 0;
+}
+
 /*********************************************************************
  * @fn      IAP_Main_Deal
  *
@@ -906,6 +1131,9 @@ void IAP_Main_Deal( void )
             IAP_Load_Addr_Offset = 0;
             IAP_WriteIn_Length = 0;
             IAP_WriteIn_Count = 0;
+            IAP_Lz_Flag = 0;
+            IAP_Img_Crc = 0;
+            IAP_Head_Flag = 0;
             /* Binary file read & iap write in */
             while ( totalcount )
             {
@@ -924,21 +1152,8 @@ void IAP_Main_Deal( void )
                 ret = CHRV3ByteRead( );                            //Read the data block in bytes, the length of a single read/write cannot exceed MAX_BYTE_IO, and the second call is followed by a backward read.
                 mStopIfError( ret );
                 totalcount -= mCmdParam.ByteRead.mByteCount;       //Counting, subtracting the number of characters that have actually been read out
-                for(i=0;i<mCmdParam.ByteRead.mByteCount;i++)
-                {
-                  IAPLoadBuffer[IAP_WriteIn_Length]=mCmdParam.ByteRead.mByteBuffer[i];
-                  IAP_WriteIn_Length++;
-                  /* The whole package part of the IAP user file */
-                  if( IAP_WriteIn_Length == DEF_MAX_IAP_BUFFER_LEN )
-                  {
-                      /* Write Data In Flash */
-                      ret = IAP_Flash_Program( DEF_APP_CODE_START_ADDR+IAP_Load_Addr_Offset, IAPLoadBuffer, IAP_WriteIn_Length );
-                      mStopIfError( ret );
-                      IAP_Load_Addr_Offset += DEF_MAX_IAP_BUFFER_LEN;
-                      IAP_WriteIn_Count += IAP_WriteIn_Length;
-                      IAP_WriteIn_Length = 0;
-                  }
-                }
+                ret = IAP_Load_Data( mCmdParam.ByteRead.mByteBuffer, mCmdParam.ByteRead.mByteCount );
+                mStopIfError( ret );
 
                 if ( mCmdParam.ByteRead.mByteCount < t )            //The actual number of characters read is less than the number of characters requested, which means that the end of the file has been reached.
                 {
@@ -948,15 +1163,11 @@ void IAP_Main_Deal( void )
             }
             /* Close the file be operated now */
             CHRV3FileClose( );
-            /* Disposal of remaining package length  */
-            ret = IAP_Flash_Program( DEF_APP_CODE_START_ADDR+IAP_Load_Addr_Offset, IAPLoadBuffer, IAP_WriteIn_Length );
-            mStopIfError( ret );
-            IAP_WriteIn_Count += IAP_WriteIn_Length;
-            /* Check actual write length and file length */
-            DUG_PRINTF( "\r\nFileSze : %d,%d.\r\n", (int)CHRV3vFileSize, IAP_WriteIn_Count );
-            if( CHRV3vFileSize == IAP_WriteIn_Count )
+            /* Disposal of remaining data, check the length, and the CRC32 of a compressed or headed file */
+            ret = IAP_Load_End( );
+            if( ret == ERR_SUCCESS )
             {
-                ret = IAP_VerifyCode_Write( );
+                ret = IAP_VerifyCode_Write( IAP_WriteIn_Count, IAP_Img_Crc );
                 if( ret != ERR_SUCCESS )
                 {
                     /* IAP Verify code error, stay in IAP */
@@ -969,7 +1180,7 @@ void IAP_Main_Deal( void )
             else
             {
                 /* IAP length checksum error */
-                DUG_PRINTF( "IAP length checksum ERR. \r\n" );
+                DUG_PRINTF( "IAP length checksum ERR %02x. \r\n", ret );
             }
         }
     }
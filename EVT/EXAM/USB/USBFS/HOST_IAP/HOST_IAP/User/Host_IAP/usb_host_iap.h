@@ -23,6 +23,8 @@ extern "C" {
 #include "ch643_usbfs_host.h"
 #include "usb_host_config.h"
 #include "CHRV3UFI.h"
+#include "iap_lz.h"
+#include "iap_image.h"
 
 /*******************************************************************************/
 /* File Descripton */
@@ -58,25 +60,31 @@ extern "C" {
 #define DEF_IAP_ERR_FLASH                 0xF4                                   /* IAP Operation, Flash operation failure */
 #define DEF_IAP_ERR_VERIFY                0xF5                                   /* IAP Operation, Flash data verify error */
 #define DEF_IAP_ERR_LENGTH                0xF6                                   /* IAP Operation, Flash data length verify error */
+#define DEF_IAP_ERR_DECODE                0xF7                                   /* IAP Operation, Compressed file damaged or too long */
 
 /* IAP Load buffer Definitions */
 #define DEF_MAX_IAP_BUFFER_LEN            1024                                   /* IAP Load buffer size */
+/* A compressed APP.BIN (see iap_lz.h) is decoded into the load buffer, which is
+ * programmed half at a time so the other half keeps the decoding window */
+#define DEF_IAP_LZ_FLUSH_LEN              ( DEF_MAX_IAP_BUFFER_LEN / 2 )
 
 /* Flash page size */
 #define DEF_FLASH_PAGE_SIZE               0x100                                  /* Flash Page size, refer to the data-sheet  for details */
 
 /* APP CODE ADDR Setting */
 #define DEF_APP_CODE_START_ADDR           0x08006000                             /* IAP Flash Operation start address, user code start address */
-#define DEF_APP_CODE_END_ADDR             0x08010000                             /* IAP Flash Operation end address, user code end address */
+#define DEF_APP_CODE_END_ADDR             0x0800F700                             /* IAP Flash Operation end address, user code end address, the verify-code page follows */
                                                                                  /* Please refer to link.ld file for accuracy flash size, the size here is the smallest available size */
 #endif
 #define DEF_APP_CODE_MAXLEN               (DEF_APP_CODE_END_ADDR-DEF_APP_CODE_START_ADDR) /* IAP Flash Operation size, user code max size */
 
 /* Verify CODE ADDR Setting */
-#define DEF_VERIFY_CODE_START_ADDR        0x08007F00                             /* IAP Flash verify-code start address */
-#define DEF_VERIFY_CODE_END_ADDR          0x08008000                             /* IAP Flash verify-code end address */
+/* The verify-code is the image record (see iap_image.h): the user code is started only while
+ * its CRC32 matches, and a new image only IAP_BOOT_TRIES times until it confirms itself */
+#define DEF_VERIFY_CODE_START_ADDR        0x0800F700                             /* IAP Flash verify-code start address, past the user code */
+#define DEF_VERIFY_CODE_END_ADDR          0x0800F800                             /* IAP Flash verify-code end address */
 #define DEF_VERIFY_CODE_MAXLEN            (DEF_VERIFY_CODE_END_ADDR-DEF_VERIFY_CODE_START_ADDR) /* IAP Flash verify-code max size */
-#define DEF_VERIFY_CODE_LEN               0x10                                   /* IAP Flash verify-code actual length, be careful not to exceed the DEF_VERIFY_CODE_MAXLEN */
+#define DEF_VERIFY_CODE_LEN               sizeof( IAP_IMAGE_INFO )               /* IAP Flash verify-code actual length, be careful not to exceed the DEF_VERIFY_CODE_MAXLEN */
 
 /* Flash Operation Key Setting */
 #define DEF_FLASH_OPERATION_KEY_CODE_0    0x1A86FF00                             /* IAP Flash operation Key-code 0 */
@@ -106,7 +114,7 @@ extern uint8_t  IAP_Flash_Write( uint32_t address, uint8_t *buff, uint32_t lengt
 extern uint32_t IAP_Flash_Verify( uint32_t address, uint8_t *buff, uint32_t length );
 extern uint32_t IAP_Flash_Program( uint32_t address, uint8_t *buff, uint32_t length );
 extern uint8_t  IAP_VerifyCode_Erase( void );
-extern uint32_t IAP_VerifyCode_Write( void );
+extern uint32_t IAP_VerifyCode_Write( uint32_t len, uint32_t crc );
 extern uint32_t IAP_VerifyCode_Check( void );
 extern void     IAP_Jump_APP( void );
 extern void     FLASH_ReadWordAdd(uint32_t address, u32 *buff, uint16_t length);
@@ -32,6 +32,10 @@ extern "C" {
 #define DEF_USB_PORT_FS_EN          1
 #define DEF_USB_PORT_FS             0x00
 
+/* U-disk Library: the IAP image is read once, front to back, so the sector
+ * cache of CH643UFI_Cache.c would only cost RAM */
+#define DEF_UDISK_CACHE_EN          0
+
 /* USB Root Device Status */
 #define ROOT_DEV_DISCONNECT         0
 #define ROOT_DEV_CONNECTED          1
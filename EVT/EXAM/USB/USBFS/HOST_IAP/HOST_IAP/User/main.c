@@ -16,6 +16,12 @@
   USBFS HOST USB drive enumeration and operation, read the APP.BIN file in the root directory inside the USB drive, write to location 0x08006000, after a successful check
   Write the flag data, then jump to the user code. The code will run IAP first to check the flag data, if the preparation data is normal, it will jump to the user code, otherwise
   If the compiled data is OK, it will jump to the user code, if not, it will stay in IAP again.
+    APP.BIN may also be packed by WCHMcuIAP_Linux/wch_lzpack (see iap_lz.h), it is then decoded while
+  it is programmed and checked against the CRC32 in its header.
+    The flag data is the image record (see iap_image.h) holding the length and CRC32 of the user code,
+  taken page by page while it is programmed and checked against the IAP_IMAGE header if APP.BIN has one.
+  The user code is started only while its CRC32 matches, and a new image only IAP_BOOT_TRIES times until
+  it confirms itself (IAP_VerifyCode_Confirm in APP).
     Support: FAT12/FAT16/FAT32
 */
 #include "debug.h"
@@ -82,52 +82,13 @@ void TIM3_Init( uint16_t arr, uint16_t psc )
  */
 void TIM3_IRQHandler( void )
 {
-    uint8_t index;
-    uint8_t hub_port;
-    uint8_t intf_num, in_num;
-
     if( TIM_GetITStatus( TIM3, TIM_IT_Update ) != RESET )
     {
         /* Clear interrupt flag */
         TIM_ClearITPendingBit( TIM3, TIM_IT_Update );
 
         /* USB HID Device Input Endpoint Timing */
-        if( RootHubDev.bStatus >= ROOT_DEV_SUCCESS )
-        {
-            index = RootHubDev.DeviceIndex;
-            if( RootHubDev.bType == USB_DEV_CLASS_HID )
-            {
-                for( intf_num = 0; intf_num < HostCtl[ index ].InterfaceNum; intf_num++ )
-                {
-                    for( in_num = 0; in_num < HostCtl[ index ].Interface[ intf_num ].InEndpNum; in_num++ )
-                    {
-                        HostCtl[ index ].Interface[ intf_num ].InEndpTimeCount[ in_num ]++;
-                    }
-                }
-            }
-            else if( RootHubDev.bType == USB_DEV_CLASS_HUB )
-            {
-                HostCtl[ index ].Interface[ 0 ].InEndpTimeCount[ 0 ]++;
-                for( hub_port = 0; hub_port < RootHubDev.bPortNum; hub_port++ )
-                {
-                    if( RootHubDev.Device[ hub_port ].bStatus >= ROOT_DEV_SUCCESS )
-                    {
-                        index = RootHubDev.Device[ hub_port ].DeviceIndex;
-
-                        if( RootHubDev.Device[ hub_port ].bType == USB_DEV_CLASS_HID )
-                        {
-                            for( intf_num = 0; intf_num < HostCtl[ index ].InterfaceNum; intf_num++ )
-                            {
-                                for( in_num = 0; in_num < HostCtl[ index ].Interface[ intf_num ].InEndpNum; in_num++ )
-                                {
-                                    HostCtl[ index ].Interface[ intf_num ].InEndpTimeCount[ in_num ]++;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        USBH_Sched_Tick( );
     }
 }
 
@@ -374,6 +335,10 @@ uint8_t KM_AnalyzeConfigDesc( uint8_t index, uint8_t ep0_size  )
                         HostCtl[ index ].Interface[ num ].Type = DEC_MOUSE;
                         HID_SetIdle( ep0_size, num, 0, 0 );
                     }
+                    else // Game controllers, barcode scanners, vendor HID
+                    {
+                        HostCtl[ index ].Interface[ num ].Type = DEC_GENERIC;
+                    }
                     s = ERR_SUCCESS;
                     i += Com_Buf[ i ];
                     innum = 0;
@@ -464,7 +429,8 @@ uint8_t KM_AnalyzeConfigDesc( uint8_t index, uint8_t ep0_size  )
 /*********************************************************************
  * @fn      KM_AnalyzeHidReportDesc
  *
- * @brief   Analyze keyboard and mouse report descriptor.
+ * @brief   Compile the report descriptor in Com_Buf into field tables and
+ *          take the keyboard lighting report from them.
  *
  * @para    index: USB host port
  *
@@ -472,136 +438,52 @@ uint8_t KM_AnalyzeConfigDesc( uint8_t index, uint8_t ep0_size  )
  */
 void KM_AnalyzeHidReportDesc( uint8_t index, uint8_t intf_num )
 {
-    uint8_t  id = 0x00;
-    uint8_t  led = 0x00;
-    uint8_t  size, type, tag;
-    uint8_t  report_size;
-    uint8_t  report_cnt;
-    uint16_t report_bits;
-
-    uint16_t i = 0;
-
-    /* Usage Page(Generic Desktop), Usage(Kyeboard) */
-    if( ( Com_Buf[ i + 0 ] == 0x05 ) && ( Com_Buf[ i + 1 ] == 0x01 ) &&
-        ( Com_Buf[ i + 2 ] == 0x09 ) && ( Com_Buf[ i + 3 ] == 0x06 ) )
+    const HID_REPORT *r;
+    const HID_FIELD  *f;
+    uint8_t  s;
+    uint8_t  i, j;
+
+    s = HID_Rpt_Compile( index, intf_num, Com_Buf, HostCtl[ index ].Interface[ intf_num ].HidDescLen );
+    if( s != DEF_HID_RPT_OK )
     {
-        i += 4;
-        report_size = 0;
-        report_cnt = 0;
-        report_bits = 0;
+        DUG_PRINTF( "RepDesc Compile Err(%02x)\r\n", s );
+        return;
+    }
+    HID_Rpt_Dump( index, intf_num );
+    HID_Rpt_Bench( index, intf_num );
 
-        while( i < HostCtl[ index ].Interface[ intf_num ].HidDescLen )
+    /* Output report carrying the LEDs */
+    for( i = 0; i < HID_Report_Num; i++ )
+    {
+        r = &HID_Report[ i ];
+        if( ( r->Dev != index ) || ( r->Intf != intf_num ) || ( r->Type != DEF_HID_RPT_OUTPUT ) )
         {
-            /* Item Size, Item Type, Item Tag */
-            size = Com_Buf[ i ] & 0x03;
-            type = Com_Buf[ i ] & 0x0C;
-            tag = Com_Buf[ i ] & 0xF0;
-
-            switch( type )
+            continue;
+        }
+        f = &HID_Field[ r->Field_First ];
+        for( j = 0; j < r->Field_Num; j++, f++ )
+        {
+            if( f->Usage_Page == DEF_HID_PAGE_LED )
             {
-                /* MAIN */
-                case 0x00:
-                    switch( tag )
-                    {
-                        /* Output */
-                        case 0x90:
-                            if( led )
-                            {
-                                report_bits += report_cnt * report_size;
-
-                                /* Save report ID for output */
-                                if( ( id != 0 ) && ( HostCtl[ index ].Interface[ intf_num ].IDFlag == 0 ) )
-                                {
-                                    HostCtl[ index ].Interface[ intf_num ].IDFlag = 1;
-                                    HostCtl[ index ].Interface[ intf_num ].ReportID = id;
-                                }
-                            }
-                            i++;
-                            break;
-
-                        default:
-                            i++;
-                            break;
-                    }
-                    break;
-
-                /* Global */
-                case 0x04:
-                    switch( tag )
-                    {
-                        /* Report ID */
-                        case 0x80:
-                            i++;
-                            id = Com_Buf[ i ];
-                            break;
-
-                        /* Report Count */
-                        case 0x90:
-                            i++;
-                            report_cnt = Com_Buf[ i ];
-                            break;
-
-                        /* Report Size */
-                        case 0x70:
-                            i++;
-                            report_size = Com_Buf[ i ];
-                            break;
-
-                        /* Usage Page */
-                        case 0x00:
-                            i++;
-                            if( Com_Buf[ i ] == 0x08 )      // LED
-                            {
-                                led = 1;
-                            }
-                            else
-                            {
-                                led = 0;
-                            }
-                            break;
-
-                        default:
-                            i++;
-                            break;
-                    }
-                    break;
-
-                /* Local */
-                case 0x08:
-                    switch( tag )
-                    {
-                        /* Usage Minimum */
-                        case 0x10:
-                            i++;
-                            if( led )
-                            {
-                                HostCtl[ index ].Interface[ intf_num ].LED_Usage_Min = Com_Buf[ i ];
-                            }
-                            break;
-
-                        /* Usage Maximum */
-                        case 0x20:
-                            i++;
-                            if( led )
-                            {
-                                HostCtl[ index ].Interface[ intf_num ].LED_Usage_Max = Com_Buf[ i ];
-                            }
-                            break;
+                break;
+            }
+        }
+        if( j == r->Field_Num )
+        {
+            continue;
+        }
 
-                        default:
-                            i++;
-                            break;
-                    }
-                    break;
+        HostCtl[ index ].Interface[ intf_num ].LED_Usage_Min = f->Usage_Min;
+        HostCtl[ index ].Interface[ intf_num ].LED_Usage_Max = f->Usage_Max;
 
-                default:
-                    i++;
-                    break;
-            }
-            i += size;
+        /* Save report ID for output */
+        if( r->ID != 0 )
+        {
+            HostCtl[ index ].Interface[ intf_num ].IDFlag = 1;
+            HostCtl[ index ].Interface[ intf_num ].ReportID = r->ID;
         }
 
-        if( report_bits == 8 )
+        if( r->Bits == 8 )
         {
             if( HostCtl[ index ].Interface[ intf_num ].SetReport_Swi == 0 )
             {
@@ -612,6 +494,7 @@ void KM_AnalyzeHidReportDesc( uint8_t index, uint8_t intf_num )
         {
             HostCtl[ index ].Interface[ intf_num ].SetReport_Swi = 0;
         }
+        break;
     }
 }
 
@@ -1390,31 +1273,36 @@ uint8_t USBH_EnumHubPortDevice( uint8_t hub_port, uint8_t *paddr, uint8_t *ptype
  */
 void KB_AnalyzeKeyValue( uint8_t index, uint8_t intf_num, uint8_t *pbuf, uint16_t len )
 {
+    const HID_REPORT *r;
+    const uint8_t *p = pbuf;
     uint8_t  i;
     uint8_t  value;
     uint8_t  bit_pos = 0x00;
 
+    /* Without a compiled report, look for the key codes anywhere in the data */
+    r = HID_Rpt_Match( index, intf_num, &p, len );
+
     value = HostCtl[ index ].Interface[ intf_num ].SetReport_Value;
 
     for( i = HostCtl[ index ].Interface[ intf_num ].LED_Usage_Min; i <= HostCtl[ index ].Interface[ intf_num ].LED_Usage_Max; i++ )
     {
         if( i == 0x01 )
         {
-            if( memchr( pbuf, DEF_KEY_NUM, len ) )
+            if( r ? HID_Rpt_Usage_On( r, p, DEF_HID_PAGE_KEYBOARD, DEF_KEY_NUM ) : ( memchr( pbuf, DEF_KEY_NUM, len ) != NULL ) )
             {
                 HostCtl[ index ].Interface[ intf_num ].SetReport_Value ^= ( 1 << bit_pos );
             }
         }
         else if( i == 0x02 )
         {
-            if( memchr( pbuf, DEF_KEY_CAPS, len ) )
+            if( r ? HID_Rpt_Usage_On( r, p, DEF_HID_PAGE_KEYBOARD, DEF_KEY_CAPS ) : ( memchr( pbuf, DEF_KEY_CAPS, len ) != NULL ) )
             {
                 HostCtl[ index ].Interface[ intf_num ].SetReport_Value ^= ( 1 << bit_pos );
             }
         }
         else if( i == 0x03 )
         {
-            if( memchr( pbuf, DEF_KEY_SCROLL, len ) )
+            if( r ? HID_Rpt_Usage_On( r, p, DEF_HID_PAGE_KEYBOARD, DEF_KEY_SCROLL ) : ( memchr( pbuf, DEF_KEY_SCROLL, len ) != NULL ) )
             {
                 HostCtl[ index ].Interface[ intf_num ].SetReport_Value ^= ( 1 << bit_pos );
             }
@@ -1475,6 +1363,30 @@ uint8_t KB_SetReport( uint8_t index, uint8_t ep0_size, uint8_t intf_num )
     return s;
 }
 
+/*********************************************************************
+ * @fn      KM_PrintReport
+ *
+ * @brief   Print an input report decoded by its compiled fields.
+ *
+ * @para    index: USB device number.
+ *          intf_num: Interface number.
+ *          pbuf: Data buffer.
+ *          len: Data length.
+ *
+ * @return  none
+ */
+void KM_PrintReport( uint8_t index, uint8_t intf_num, uint8_t *pbuf, uint16_t len )
+{
+    const HID_REPORT *r;
+    const uint8_t *p = pbuf;
+
+    r = HID_Rpt_Match( index, intf_num, &p, len );
+    if( r )
+    {
+        HID_Rpt_Print( r, p );
+    }
+}
+
 /*********************************************************************
  * @fn      USBH_MainDeal
  *
@@ -1490,10 +1402,16 @@ void USBH_MainDeal( void )
     uint8_t  hub_port;
     uint8_t  hub_dat;
     uint8_t  intf_num, in_num;
+    uint8_t  dev;
+    uint8_t  ep0_size;
     uint16_t len;
+    USBH_SLOT *slot;
 #if DEF_DEBUG_PRINTF
     uint16_t i;
 #endif
+#if DEF_SCHED_STAT_PERIOD
+    static uint16_t Stat_Ms;
+#endif
     
     s = USBFSH_CheckRootHubPortStatus( RootHubDev.bStatus ); // Check USB device connection or disconnection
     if( s == ROOT_DEV_CONNECTED )
@@ -1519,6 +1437,7 @@ void USBH_MainDeal( void )
 
                     /* Set the connection status of the device  */
                     RootHubDev.bStatus = ROOT_DEV_SUCCESS;
+                    USBH_Sched_Add_Dev( RootHubDev.DeviceIndex, DEF_SCHED_ROOT );
                 }
                 else if( s != ERR_USB_DISCON )
                 {
@@ -1539,6 +1458,7 @@ void USBH_MainDeal( void )
 
                     /* Set the connection status of the device  */
                     RootHubDev.bStatus = ROOT_DEV_SUCCESS;
+                    USBH_Sched_Add_Dev( RootHubDev.DeviceIndex, DEF_SCHED_ROOT );
                 }
                 else if( s != ERR_USB_DISCON )
                 {
@@ -1582,278 +1502,235 @@ void USBH_MainDeal( void )
         index = RootHubDev.DeviceIndex;
         memset( &RootHubDev.bStatus, 0, sizeof( ROOT_HUB_DEVICE ) );
         memset( &HostCtl[ index ].InterfaceNum, 0, sizeof( HOST_CTL ) );
+        for( dev = 0; dev < DEF_ONE_USB_SUP_DEV_TOTAL; dev++ )
+        {
+            HID_Rpt_Free( index + dev, 0xFF );
+        }
+        USBH_Sched_Remove( 0xFF );
     }
 
-    /* Get the data of the HID device connected to the USB host port */
-    if( RootHubDev.bStatus >= ROOT_DEV_SUCCESS )
+#if DEF_SCHED_STAT_PERIOD
+    /* Print the polling statistics */
+    if( (uint16_t)( USBH_Sched_Ms - Stat_Ms ) >= DEF_SCHED_STAT_PERIOD )
     {
-        index = RootHubDev.DeviceIndex;
+        Stat_Ms = USBH_Sched_Ms;
+        USBH_Sched_Stat_Print( );
+    }
+#endif
 
-        if( RootHubDev.bType == USB_DEV_CLASS_HID )
+    /* Poll the interrupt endpoint whose frame has come */
+    if( RootHubDev.bStatus < ROOT_DEV_SUCCESS )
+    {
+        return;
+    }
+    slot = USBH_Sched_Next( );
+    if( slot == NULL )
+    {
+        return;
+    }
+    index = slot->Dev;
+    intf_num = slot->Intf;
+    in_num = slot->In_Num;
+
+    /* Select the device, directly on the port or behind the HUB */
+    if( slot->Hub_Port == DEF_SCHED_ROOT )
+    {
+        USBFSH_SetSelfAddr( RootHubDev.bAddress );
+        USBFSH_SetSelfSpeed( RootHubDev.bSpeed );
+        ep0_size = RootHubDev.bEp0MaxPks;
+    }
+    else
+    {
+        USBFSH_SetSelfAddr( RootHubDev.Device[ slot->Hub_Port ].bAddress );
+        USBFSH_SetSelfSpeed( RootHubDev.Device[ slot->Hub_Port ].bSpeed );
+        if( RootHubDev.bSpeed != USB_LOW_SPEED )
+        {
+            USBFSH->HOST_CTRL &= ~USBFS_UH_LOW_SPEED;
+        }
+        ep0_size = RootHubDev.Device[ slot->Hub_Port ].bEp0MaxPks;
+    }
+
+    /* Get endpoint data, a NAK returns at once */
+    s = USBFSH_GetEndpData( HostCtl[ index ].Interface[ intf_num ].InEndpAddr[ in_num ],
+                            &HostCtl[ index ].Interface[ intf_num ].InEndpTog[ in_num ], Com_Buf, &len );
+    USBH_Sched_Done( slot, s );
+
+    if( ( RootHubDev.bType == USB_DEV_CLASS_HUB ) && ( index == RootHubDev.DeviceIndex ) )
+    {
+        /* Query port status change */
+        if( s == ERR_SUCCESS )
         {
-            for( intf_num = 0; intf_num < HostCtl[ index ].InterfaceNum; intf_num++ )
+            hub_dat = Com_Buf[ 0 ];
+            DUG_PRINTF( "Hub Int Data:%02x\r\n", hub_dat );
+
+            for( hub_port = 0; hub_port < RootHubDev.bPortNum; hub_port++ )
             {
-                for( in_num = 0; in_num < HostCtl[ index ].Interface[ intf_num ].InEndpNum; in_num++ )
+                /* HUB Port PreEnumate Step 1: C_PORT_CONNECTION */
+                s = HUB_Port_PreEnum1( ( hub_port + 1 ), &hub_dat );
+                if( s == ERR_USB_DISCON )
                 {
-                    /* Get endpoint data based on the interval time of the device */
-                    if( HostCtl[ index ].Interface[ intf_num ].InEndpTimeCount[ in_num ] >= HostCtl[ index ].Interface[ intf_num ].InEndpInterval[ in_num ] )
+                    hub_dat &= ~( 1 << ( hub_port + 1 ) );
+
+                    /* Clear parameters */
+                    if( RootHubDev.Device[ hub_port ].bStatus != ROOT_DEV_DISCONNECT )
                     {
-                        HostCtl[ index ].Interface[ intf_num ].InEndpTimeCount[ in_num ] %= HostCtl[ index ].Interface[ intf_num ].InEndpInterval[ in_num ];
+                        USBH_Sched_Remove( RootHubDev.Device[ hub_port ].DeviceIndex );
+                    }
+                    HID_Rpt_Free( RootHubDev.Device[ hub_port ].DeviceIndex, 0xFF );
+                    memset( &HostCtl[ RootHubDev.Device[ hub_port ].DeviceIndex ], 0, sizeof( HOST_CTL ) );
+                    memset( &RootHubDev.Device[ hub_port ].bStatus, 0, sizeof( HUB_DEVICE ) );
+                    continue;
+                }
+
+                /* HUB Port PreEnumate Step 2: Set/Clear PORT_RESET */
+                Delay_Ms( 100 );
+                s = HUB_Port_PreEnum2( ( hub_port + 1 ), &hub_dat );
+                if( s == ERR_USB_CONNECT )
+                {
+                    /* Set parameters */
+                    RootHubDev.Device[ hub_port ].bStatus = ROOT_DEV_CONNECTED;
+                    RootHubDev.Device[ hub_port ].bEp0MaxPks = DEFAULT_ENDP0_SIZE;
+                    RootHubDev.Device[ hub_port ].DeviceIndex = DEF_USBFS_PORT_INDEX * DEF_ONE_USB_SUP_DEV_TOTAL + hub_port + 1;
+                }
+                else
+                {
+                    hub_dat &= ~( 1 << ( hub_port + 1 ) );
+                }
+
+                /* Enumerate HUB Device */
+                if( RootHubDev.Device[ hub_port ].bStatus == ROOT_DEV_CONNECTED )
+                {
+                    /* Check device speed */
+                    RootHubDev.Device[ hub_port ].bSpeed = HUB_CheckPortSpeed( ( hub_port + 1 ), Com_Buf );
+                    DUG_PRINTF( "Dev Speed:%x\r\n", RootHubDev.Device[ hub_port ].bSpeed );
+
+                    /* Select the specified port */
+                    USBFSH_SetSelfAddr( RootHubDev.Device[ hub_port ].bAddress );
+                    USBFSH_SetSelfSpeed( RootHubDev.Device[ hub_port ].bSpeed );
+                    if( RootHubDev.bSpeed != USB_LOW_SPEED )
+                    {
+                        USBFSH->HOST_CTRL &= ~USBFS_UH_LOW_SPEED;
+                    }
 
-                        /* Get endpoint data */
-                        s = USBFSH_GetEndpData( HostCtl[ index ].Interface[ intf_num ].InEndpAddr[ in_num ],
-                                                &HostCtl[ index ].Interface[ intf_num ].InEndpTog[ in_num ], Com_Buf, &len );
-                        if( s == ERR_SUCCESS )
+                    /* Enumerate the USB device of the current HUB port */
+                    DUG_PRINTF("Enum_HubDevice\r\n");
+                    s = USBH_EnumHubPortDevice( hub_port, &RootHubDev.Device[ hub_port ].bAddress, \
+                                                &RootHubDev.Device[ hub_port ].bType );
+                    if( s == ERR_SUCCESS )
+                    {
+                        if( RootHubDev.Device[ hub_port ].bType == USB_DEV_CLASS_HID )
                         {
-#if DEF_DEBUG_PRINTF
-                            for( i = 0; i < len; i++ )
-                            {
-                                DUG_PRINTF( "%02x ", Com_Buf[ i ] );
-                            }
-                            DUG_PRINTF( "\r\n" );
-#endif
+                            DUG_PRINTF( "HUB port%x device is HID! Further Enum:\r\n", hub_port );
 
-                            /* Handle keyboard lighting */
-                            if( HostCtl[ index ].Interface[ intf_num ].Type == DEC_KEY )
+                            /* Perform HID class enumeration on the current device */
+                            s = USBH_EnumHidDevice( RootHubDev.Device[ hub_port ].DeviceIndex, \
+                                                    RootHubDev.Device[ hub_port ].bEp0MaxPks );
+                            if( s == ERR_SUCCESS )
                             {
-                                KB_AnalyzeKeyValue( index, intf_num, Com_Buf, len );
-
-                                if( HostCtl[ index ].Interface[ intf_num ].SetReport_Flag )
-                                {
-                                    KB_SetReport( index, RootHubDev.bEp0MaxPks, intf_num );
-                                }
+                                RootHubDev.Device[ hub_port ].bStatus = ROOT_DEV_SUCCESS;
+                                USBH_Sched_Add_Dev( RootHubDev.Device[ hub_port ].DeviceIndex, hub_port );
+                                DUG_PRINTF( "OK!\r\n" );
                             }
                         }
-                        else if( s == ERR_USB_DISCON )
-                        {
-                            break;
-                        }
-                        else if( s == ( USB_PID_STALL | ERR_USB_TRANSFER ) )
+                        else // Detect that this device is a Non-HID device
                         {
-                            /* USB device abnormal event */
-                            DUG_PRINTF("Abnormal\r\n");
-
-                            /* Clear endpoint */
-                            USBFSH_ClearEndpStall( RootHubDev.bEp0MaxPks, HostCtl[ index ].Interface[ intf_num ].InEndpAddr[ in_num ] | 0x80 );
-                            HostCtl[ index ].Interface[ intf_num ].InEndpTog[ in_num ] = 0x00;
-
-                            /* Judge the number of error */
-                            HostCtl[ index ].ErrorCount++;
-                            if( HostCtl[ index ].ErrorCount >= 10 )
+                            DUG_PRINTF( "HUB port%x device is ", hub_port );
+                            switch( RootHubDev.Device[ hub_port ].bType )
                             {
-                                /* Re-enumerate the device and clear the endpoint again */
-                                memset( &RootHubDev.bStatus, 0, sizeof( struct _ROOT_HUB_DEVICE ) );
-                                s = USBH_EnumRootDevice( );
-                                if( s == ERR_SUCCESS )
-                                {
-                                    USBFSH_ClearEndpStall( RootHubDev.bEp0MaxPks, HostCtl[ index ].Interface[ intf_num ].InEndpAddr[ in_num ] | 0x80 );
-                                    HostCtl[ index ].ErrorCount = 0x00;
-
-                                    RootHubDev.bStatus = ROOT_DEV_CONNECTED;
-                                    RootHubDev.DeviceIndex = DEF_USBFS_PORT_INDEX * DEF_ONE_USB_SUP_DEV_TOTAL;
-
-                                    memset( &HostCtl[ index ].InterfaceNum, 0, sizeof( struct __HOST_CTL ) );
-                                    s = USBH_EnumHidDevice( index, RootHubDev.bEp0MaxPks );
-                                    if( s == ERR_SUCCESS )
-                                    {
-                                        RootHubDev.bStatus = ROOT_DEV_SUCCESS;
-                                    }
-                                    else if( s != ERR_USB_DISCON )
-                                    {
-                                        RootHubDev.bStatus = ROOT_DEV_FAILED;
-                                    }
-                                }
-                                else if( s != ERR_USB_DISCON )
-                                {
-                                    RootHubDev.bStatus = ROOT_DEV_FAILED;
-                                }
+                                case USB_DEV_CLASS_STORAGE:
+                                    DUG_PRINTF("storage!\r\n");
+                                    break;
+                                case USB_DEV_CLASS_PRINTER:
+                                    DUG_PRINTF("printer!\r\n");
+                                    break;
+                                case USB_DEV_CLASS_HUB:
+                                    DUG_PRINTF("printer!\r\n");
+                                    break;
+                                case DEF_DEV_TYPE_UNKNOWN:
+                                    DUG_PRINTF("unknown!\r\n");
+                                    break;
                             }
+                            RootHubDev.Device[ hub_port ].bStatus = ROOT_DEV_SUCCESS;
                         }
                     }
-                }
-
-                if( s == ERR_USB_DISCON )
-                {
-                    break;
+                    else
+                    {
+                        RootHubDev.Device[ hub_port ].bStatus = ROOT_DEV_FAILED;
+                        DUG_PRINTF( "HUB Port%x Enum Err!\r\n", hub_port );
+                    }
                 }
             }
         }
-        else if( RootHubDev.bType == USB_DEV_CLASS_HUB )
-        {
-           /* Query port status change */
-           if( HostCtl[ index ].Interface[ 0 ].InEndpTimeCount[ 0 ] >= HostCtl[ index ].Interface[ 0 ].InEndpInterval[ 0 ] )
-           {
-               HostCtl[ index ].Interface[ 0 ].InEndpTimeCount[ 0 ] %= HostCtl[ index ].Interface[ 0 ].InEndpInterval[ 0 ];
-
-               /* Select HUB port */
-               USBFSH_SetSelfAddr( RootHubDev.bAddress );
-               USBFSH_SetSelfSpeed( RootHubDev.bSpeed );
-
-               /* Get HUB interrupt endpoint data */
-               s = USBFSH_GetEndpData( HostCtl[ index ].Interface[ 0 ].InEndpAddr[ 0 ], &HostCtl[ index ].Interface[ 0 ].InEndpTog[ 0 ], Com_Buf, &len );
-               if( s == ERR_SUCCESS )
-               {
-                   hub_dat = Com_Buf[ 0 ];
-                   DUG_PRINTF( "Hub Int Data:%02x\r\n", hub_dat );
-
-                   for( hub_port = 0; hub_port < RootHubDev.bPortNum; hub_port++ )
-                   {
-                       /* HUB Port PreEnumate Step 1: C_PORT_CONNECTION */
-                       s = HUB_Port_PreEnum1( ( hub_port + 1 ), &hub_dat );
-                       if( s == ERR_USB_DISCON )
-                       {
-                           hub_dat &= ~( 1 << ( hub_port + 1 ) );
-
-                           /* Clear parameters */
-                           memset( &HostCtl[ RootHubDev.Device[ hub_port ].DeviceIndex ], 0, sizeof( HOST_CTL ) );
-                           memset( &RootHubDev.Device[ hub_port ].bStatus, 0, sizeof( HUB_DEVICE ) );
-                           continue;
-                       }
-
-                       /* HUB Port PreEnumate Step 2: Set/Clear PORT_RESET */
-                       Delay_Ms( 100 );
-                       s = HUB_Port_PreEnum2( ( hub_port + 1 ), &hub_dat );
-                       if( s == ERR_USB_CONNECT )
-                       {
-                           /* Set parameters */
-                           RootHubDev.Device[ hub_port ].bStatus = ROOT_DEV_CONNECTED;
-                           RootHubDev.Device[ hub_port ].bEp0MaxPks = DEFAULT_ENDP0_SIZE;
-                           RootHubDev.Device[ hub_port ].DeviceIndex = DEF_USBFS_PORT_INDEX * DEF_ONE_USB_SUP_DEV_TOTAL + hub_port + 1;
-                       }
-                       else
-                       {
-                           hub_dat &= ~( 1 << ( hub_port + 1 ) );
-                       }
-
-                       /* Enumerate HUB Device */
-                       if( RootHubDev.Device[ hub_port ].bStatus == ROOT_DEV_CONNECTED )
-                       {
-                           /* Check device speed */
-                           RootHubDev.Device[ hub_port ].bSpeed = HUB_CheckPortSpeed( ( hub_port + 1 ), Com_Buf );
-                           DUG_PRINTF( "Dev Speed:%x\r\n", RootHubDev.Device[ hub_port ].bSpeed );
-
-                           /* Select the specified port */
-                           USBFSH_SetSelfAddr( RootHubDev.Device[ hub_port ].bAddress );
-                           USBFSH_SetSelfSpeed( RootHubDev.Device[ hub_port ].bSpeed );
-                           if( RootHubDev.bSpeed != USB_LOW_SPEED )
-                           {
-                               USBFSH->HOST_CTRL &= ~USBFS_UH_LOW_SPEED;
-                           }
-
-                           /* Enumerate the USB device of the current HUB port */
-                           DUG_PRINTF("Enum_HubDevice\r\n");
-                           s = USBH_EnumHubPortDevice( hub_port, &RootHubDev.Device[ hub_port ].bAddress, \
-                                                       &RootHubDev.Device[ hub_port ].bType );
-                           if( s == ERR_SUCCESS )
-                           {
-                               if( RootHubDev.Device[ hub_port ].bType == USB_DEV_CLASS_HID )
-                               {
-                                   DUG_PRINTF( "HUB port%x device is HID! Further Enum:\r\n", hub_port );
-
-                                   /* Perform HID class enumeration on the current device */
-                                   s = USBH_EnumHidDevice( RootHubDev.Device[ hub_port ].DeviceIndex, \
-                                                           RootHubDev.Device[ hub_port ].bEp0MaxPks );
-                                   if( s == ERR_SUCCESS )
-                                   {
-                                       RootHubDev.Device[ hub_port ].bStatus = ROOT_DEV_SUCCESS;
-                                       DUG_PRINTF( "OK!\r\n" );
-                                   }
-                               }
-                               else // Detect that this device is a Non-HID device
-                               {
-                                   DUG_PRINTF( "HUB port%x device is ", hub_port );
-                                   switch( RootHubDev.Device[ hub_port ].bType )
-                                   {
-                                       case USB_DEV_CLASS_STORAGE:
-                                           DUG_PRINTF("storage!\r\n");
-                                           break;
-                                       case USB_DEV_CLASS_PRINTER:
-                                           DUG_PRINTF("printer!\r\n");
-                                           break;
-                                       case USB_DEV_CLASS_HUB:
-                                           DUG_PRINTF("printer!\r\n");
-                                           break;
-                                       case DEF_DEV_TYPE_UNKNOWN:
-                                           DUG_PRINTF("unknown!\r\n");
-                                           break;
-                                   }
-                                   RootHubDev.Device[ hub_port ].bStatus = ROOT_DEV_SUCCESS;
-                               }
-                           }
-                           else
-                           {
-                               RootHubDev.Device[ hub_port ].bStatus = ROOT_DEV_FAILED;
-                               DUG_PRINTF( "HUB Port%x Enum Err!\r\n", hub_port );
-                           }
-                       }
-                   }
-               }
-           }
-
-           /* Get HUB port HID device data */
-           for( hub_port = 0; hub_port < RootHubDev.bPortNum; hub_port++ )
-           {
-               if( RootHubDev.Device[ hub_port ].bStatus == ROOT_DEV_SUCCESS )
-               {
-                   index = RootHubDev.Device[ hub_port ].DeviceIndex;
-
-                   if( RootHubDev.Device[ hub_port ].bType == USB_DEV_CLASS_HID )
-                   {
-                       for( intf_num = 0; intf_num < HostCtl[ index ].InterfaceNum; intf_num++ )
-                       {
-                           for( in_num = 0; in_num < HostCtl[ index ].Interface[ intf_num ].InEndpNum; in_num++ )
-                           {
-                               /* Get endpoint data based on the interval time of the device */
-                               if( HostCtl[ index ].Interface[ intf_num ].InEndpTimeCount[ in_num ] >= HostCtl[ index ].Interface[ intf_num ].InEndpInterval[ in_num ] )
-                               {
-                                   HostCtl[ index ].Interface[ intf_num ].InEndpTimeCount[ in_num ] %= HostCtl[ index ].Interface[ intf_num ].InEndpInterval[ in_num ];
-
-                                   /* Select HUB device port */
-                                   USBFSH_SetSelfAddr( RootHubDev.Device[ hub_port ].bAddress );
-                                   USBFSH_SetSelfSpeed( RootHubDev.Device[ hub_port ].bSpeed );
-                                   if( RootHubDev.bSpeed != USB_LOW_SPEED )
-                                   {
-                                       USBFSH->HOST_CTRL &= ~USBFS_UH_LOW_SPEED;
-                                   }
-
-                                   /* Get endpoint data */
-                                   s = USBFSH_GetEndpData( HostCtl[ index ].Interface[ intf_num ].InEndpAddr[ in_num ], \
-                                                           &HostCtl[ index ].Interface[ intf_num ].InEndpTog[ in_num ], Com_Buf, &len );
-                                   if( s == ERR_SUCCESS )
-                                   {
+    }
+    else if( s == ERR_SUCCESS )
+    {
 #if DEF_DEBUG_PRINTF
-                                       for( i = 0; i < len; i++ )
-                                       {
-                                           DUG_PRINTF( "%02x ", Com_Buf[ i ] );
-                                       }
-                                       DUG_PRINTF( "\r\n" );
+        for( i = 0; i < len; i++ )
+        {
+            DUG_PRINTF( "%02x ", Com_Buf[ i ] );
+        }
+        DUG_PRINTF( "\r\n" );
 #endif
 
-                                       if( HostCtl[ index ].Interface[ intf_num ].Type == DEC_KEY )
-                                       {
-                                           KB_AnalyzeKeyValue( index, intf_num, Com_Buf, len );
-
-                                           if( HostCtl[ index ].Interface[ intf_num ].SetReport_Flag )
-                                           {
-                                               KB_SetReport( index, RootHubDev.Device[ hub_port ].bEp0MaxPks, intf_num );
-                                           }
-                                       }
-                                   }
-                                   else if( s == ERR_USB_DISCON )
-                                   {
-                                       break;
-                                   }
-                               }
-                           }
-
-                           if( s == ERR_USB_DISCON )
-                           {
-                               break;
-                           }
-                       }
-                   }
-               }
-           }
+        /* Decode other HID devices through their compiled reports */
+        if( HostCtl[ index ].Interface[ intf_num ].Type == DEC_GENERIC )
+        {
+            KM_PrintReport( index, intf_num, Com_Buf, len );
+        }
+
+        /* Handle keyboard lighting */
+        if( HostCtl[ index ].Interface[ intf_num ].Type == DEC_KEY )
+        {
+            KB_AnalyzeKeyValue( index, intf_num, Com_Buf, len );
+
+            if( HostCtl[ index ].Interface[ intf_num ].SetReport_Flag )
+            {
+                KB_SetReport( index, ep0_size, intf_num );
+            }
+        }
+    }
+    else if( ( s == ( USB_PID_STALL | ERR_USB_TRANSFER ) ) && ( slot->Hub_Port == DEF_SCHED_ROOT ) )
+    {
+        /* USB device abnormal event */
+        DUG_PRINTF("Abnormal\r\n");
+
+        /* Clear endpoint */
+        USBFSH_ClearEndpStall( RootHubDev.bEp0MaxPks, HostCtl[ index ].Interface[ intf_num ].InEndpAddr[ in_num ] | 0x80 );
+        HostCtl[ index ].Interface[ intf_num ].InEndpTog[ in_num ] = 0x00;
+
+        /* Judge the number of error */
+        HostCtl[ index ].ErrorCount++;
+        if( HostCtl[ index ].ErrorCount >= 10 )
+        {
+            /* Re-enumerate the device and clear the endpoint again */
+            USBH_Sched_Remove( 0xFF );
+            memset( &RootHubDev.bStatus, 0, sizeof( struct _ROOT_HUB_DEVICE ) );
+            s = USBH_EnumRootDevice( );
+            if( s == ERR_SUCCESS )
+            {
+                USBFSH_ClearEndpStall( RootHubDev.bEp0MaxPks, HostCtl[ index ].Interface[ intf_num ].InEndpAddr[ in_num ] | 0x80 );
+                HostCtl[ index ].ErrorCount = 0x00;
+
+                RootHubDev.bStatus = ROOT_DEV_CONNECTED;
+                RootHubDev.DeviceIndex = DEF_USBFS_PORT_INDEX * DEF_ONE_USB_SUP_DEV_TOTAL;
+
+                memset( &HostCtl[ index ].InterfaceNum, 0, sizeof( struct __HOST_CTL ) );
+                HID_Rpt_Free( index, 0xFF );
+                s = USBH_EnumHidDevice( index, RootHubDev.bEp0MaxPks );
+                if( s == ERR_SUCCESS )
+                {
+                    RootHubDev.bStatus = ROOT_DEV_SUCCESS;
+                    USBH_Sched_Add_Dev( index, DEF_SCHED_ROOT );
+                }
+                else if( s != ERR_USB_DISCON )
+                {
+                    RootHubDev.bStatus = ROOT_DEV_FAILED;
+                }
+            }
+            else if( s != ERR_USB_DISCON )
+            {
+                RootHubDev.bStatus = ROOT_DEV_FAILED;
+            }
         }
     }
 }
@@ -32,6 +32,7 @@ extern "C" {
 /* USB HID Device Interface Type */
 #define DEC_KEY                         0x01
 #define DEC_MOUSE                       0x02
+#define DEC_GENERIC                     0x03                                    // Other HID, decoded from its report descriptor
 #define DEC_UNKNOW                      0xFF
 
 /* USB Keyboard Lighting Key */
@@ -59,6 +60,7 @@ extern uint8_t HUB_Port_PreEnum1( uint8_t hub_port, uint8_t *pbuf );
 extern uint8_t HUB_Port_PreEnum2( uint8_t hub_port, uint8_t *pbuf );
 extern uint8_t HUB_CheckPortSpeed( uint8_t hub_port, uint8_t *pbuf );
 extern uint8_t USBH_EnumHubPortDevice( uint8_t hub_port, uint8_t *paddr, uint8_t *ptype );
+extern void KM_PrintReport( uint8_t index, uint8_t intf_num, uint8_t *pbuf, uint16_t len );
 extern void KB_AnalyzeKeyValue( uint8_t index, uint8_t intf_num, uint8_t *pbuf, uint16_t len );
 extern uint8_t KB_SetReport( uint8_t index, uint8_t ep0_size, uint8_t intf_num );
 extern void USBH_MainDeal( void );
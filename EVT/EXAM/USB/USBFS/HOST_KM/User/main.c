@@ -17,6 +17,15 @@
  * of the keyboard and mouse.
  * The USBFS port also supports enumeration of keyboard and mouse attached at tier
  * level 2(Hub 1).
+ * Every HID report descriptor is compiled into field tables (usb_host_hid_rpt.c),
+ * which other HID devices such as game controllers and barcode scanners are
+ * decoded and printed with. Set DEF_HID_RPT_BENCH to time the decoding.
+ * The interrupt endpoints of all devices, hub included, are polled by one
+ * scheduler (usb_host_sched.c) that spreads them over the 1ms frames and prints
+ * per-endpoint NAK, error and latency counts every DEF_SCHED_STAT_PERIOD ms.
+ * Up to 7 devices behind one hub are supported.
+ * Transactions run from the USBFS interrupt (USBH_Lib/usb_host_xfer.c) with the
+ * CPU in WFI while they are on the bus. DEF_USBH_XFER_EN 0 restores polling.
 */
 
 
@@ -50,8 +59,13 @@ int main(void)
     printf( "USBFS Host Init\r\n" );
     USBFS_RCC_Init( );
     USBFS_Host_Init( ENABLE , PWR_VDD_SupplyVoltage());
+#if DEF_USBH_XFER_EN
+    USBH_Xfer_Init( );
+#endif
     memset( &RootHubDev.bStatus, 0, sizeof( ROOT_HUB_DEVICE ) );
     memset( &HostCtl[ DEF_USBFS_PORT_INDEX * DEF_ONE_USB_SUP_DEV_TOTAL ].InterfaceNum, 0, DEF_ONE_USB_SUP_DEV_TOTAL * sizeof( HOST_CTL ) );
+    HID_Rpt_Init( );
+    USBH_Sched_Init( );
 #endif
 
     while( 1 )
@@ -24,8 +24,11 @@ extern "C" {
 #include "debug.h"
 #include <ch643_usb.h>
 #include <ch643_usbfs_host.h>
+#include "usb_host_xfer.h"
 #include "usb_host_hid.h"
+#include "usb_host_hid_rpt.h"
 #include "usb_host_hub.h"
+#include "usb_host_sched.h"
 #include "app_km.h"
 
 
@@ -46,8 +49,8 @@ extern "C" {
 #define DEF_TOTAL_ROOT_HUB          1
 #define DEF_USBFS_PORT_EN           1
 #define DEF_USBFS_PORT_INDEX        0x00
-#define DEF_ONE_USB_SUP_DEV_TOTAL   5
-#define DEF_NEXT_HUB_PORT_NUM_MAX   4
+#define DEF_ONE_USB_SUP_DEV_TOTAL   8
+#define DEF_NEXT_HUB_PORT_NUM_MAX   7
 #define DEF_INTERFACE_NUM_MAX       4
 
 /* USB Root Device Status */
@@ -144,7 +147,6 @@ typedef struct __HOST_CTL
         uint16_t InEndpSize[ 4 ];
         uint8_t  InEndpTog[ 4 ];
         uint8_t  InEndpInterval[ 4 ];
-        uint8_t  InEndpTimeCount[ 4 ];
 
         uint8_t  OutEndpNum;
         uint8_t  OutEndpAddr[ 4 ];
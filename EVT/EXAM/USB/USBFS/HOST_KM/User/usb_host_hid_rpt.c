@@ -0,0 +1,828 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : usb_host_hid_rpt.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : HID report descriptor compiler and report decoding.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+/********************************************************************************/
+/* Header File */
+#include "usb_host_config.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+
+/* Reports and fields of all interfaces, kept packed: entries 0..Num-1 are
+ * in use, the fields of one report are consecutive. */
+HID_REPORT HID_Report[ DEF_HID_RPT_NUM_MAX ];
+HID_FIELD  HID_Field[ DEF_HID_FIELD_NUM_MAX ];
+uint8_t    HID_Report_Num;
+uint8_t    HID_Field_Num;
+
+/* Global item state, saved by Push */
+typedef struct _HID_GLOBAL
+{
+    uint16_t Page;
+    int32_t  Log_Min;
+    int32_t  Log_Max;
+    uint32_t Log_Max_U;                                                         // Logical Maximum read as unsigned
+    uint16_t Size;
+    uint16_t Count;
+    uint8_t  ID;
+} HID_GLOBAL;
+
+/* Local item state, cleared by every main item */
+typedef struct _HID_LOCAL
+{
+    uint32_t Usage[ DEF_HID_USAGE_NUM_MAX ];                                    // Page in bit16-31 once resolved
+    uint16_t Ext;                                                               // Bit n: Usage[ n ] carries its page
+    uint8_t  Num;
+    uint8_t  Min_Ext, Max_Ext;
+    uint8_t  Has_Min, Has_Max;
+    uint32_t Min, Max;
+} HID_LOCAL;
+
+/*********************************************************************
+ * @fn      HID_Rpt_Init
+ *
+ * @brief   Empty the report and field tables.
+ *
+ * @return  none
+ */
+void HID_Rpt_Init( void )
+{
+    HID_Report_Num = 0;
+    HID_Field_Num = 0;
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Free
+ *
+ * @brief   Remove the reports of one interface, or of all interfaces of
+ *          a device, and close the gaps they leave.
+ *
+ * @para    dev: HostCtl index.
+ *          intf: Interface number, 0xFF - all.
+ *
+ * @return  none
+ */
+void HID_Rpt_Free( uint8_t dev, uint8_t intf )
+{
+    uint8_t i, j;
+    uint8_t first, num;
+
+    i = 0;
+    while( i < HID_Report_Num )
+    {
+        if( ( HID_Report[ i ].Dev != dev ) || ( ( intf != 0xFF ) && ( HID_Report[ i ].Intf != intf ) ) )
+        {
+            i++;
+            continue;
+        }
+
+        /* Drop its fields */
+        first = HID_Report[ i ].Field_First;
+        num = HID_Report[ i ].Field_Num;
+        if( num )
+        {
+            memmove( &HID_Field[ first ], &HID_Field[ first + num ], ( HID_Field_Num - first - num ) * sizeof( HID_FIELD ) );
+            HID_Field_Num -= num;
+            for( j = 0; j < HID_Report_Num; j++ )
+            {
+                if( HID_Report[ j ].Field_First > first )
+                {
+                    HID_Report[ j ].Field_First -= num;
+                }
+            }
+        }
+
+        /* Drop the report */
+        HID_Report_Num--;
+        memmove( &HID_Report[ i ], &HID_Report[ i + 1 ], ( HID_Report_Num - i ) * sizeof( HID_REPORT ) );
+    }
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Item_Data
+ *
+ * @brief   Data of a short item, little endian.
+ *
+ * @para    p: First data byte.
+ *          size: Data size, 0, 1, 2 or 4.
+ *          sign: Sign-extend.
+ *
+ * @return  Item data.
+ */
+static uint32_t HID_Rpt_Item_Data( const uint8_t *p, uint8_t size, uint8_t sign )
+{
+    switch( size )
+    {
+        case 1:
+            return sign ? (uint32_t)(int32_t)(int8_t)p[ 0 ] : p[ 0 ];
+
+        case 2:
+            return sign ? (uint32_t)(int32_t)(int16_t)( p[ 0 ] | ( p[ 1 ] << 8 ) ) : (uint32_t)( p[ 0 ] | ( p[ 1 ] << 8 ) );
+
+        case 4:
+            return p[ 0 ] | ( (uint32_t)p[ 1 ] << 8 ) | ( (uint32_t)p[ 2 ] << 16 ) | ( (uint32_t)p[ 3 ] << 24 );
+
+        default:
+            return 0;
+    }
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Local_Usage
+ *
+ * @brief   Usage of element n of a main item: the n-th usage, the last one
+ *          if there are fewer, or Usage Minimum + n clamped to the maximum.
+ *
+ * @return  Usage page in bit16-31, usage id in bit0-15.
+ */
+static uint32_t HID_Rpt_Local_Usage( const HID_LOCAL *pl, uint16_t page, uint16_t n )
+{
+    uint32_t u;
+
+    if( pl->Num )
+    {
+        if( n >= pl->Num )
+        {
+            n = pl->Num - 1;
+        }
+        u = pl->Usage[ n ];
+        return ( pl->Ext & ( 1 << n ) ) ? u : ( ( (uint32_t)page << 16 ) | ( u & 0xFFFF ) );
+    }
+    if( pl->Has_Min )
+    {
+        u = pl->Min + n;
+        if( pl->Has_Max && ( ( u & 0xFFFF ) > ( pl->Max & 0xFFFF ) ) )
+        {
+            u = pl->Max;
+        }
+        return pl->Min_Ext ? u : ( ( (uint32_t)page << 16 ) | ( u & 0xFFFF ) );
+    }
+    return (uint32_t)page << 16;
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Add_Field
+ *
+ * @brief   Append one field to the table.
+ *
+ * @return  Field, NULL - table full.
+ */
+static HID_FIELD *HID_Rpt_Add_Field( const HID_GLOBAL *pg, uint8_t rpt, uint16_t ofs, uint16_t count, uint8_t flags, uint32_t usage )
+{
+    HID_FIELD *f;
+
+    if( HID_Field_Num >= DEF_HID_FIELD_NUM_MAX )
+    {
+        return NULL;
+    }
+    f = &HID_Field[ HID_Field_Num++ ];
+    f->Bit_Ofs = ofs;
+    f->Bit_Size = pg->Size;
+    f->Count = count;
+    f->Flags = flags;
+    f->Rpt = rpt;
+    f->Usage_Page = usage >> 16;
+    f->Usage_Min = usage;
+    f->Usage_Max = usage;
+    f->Log_Min = pg->Log_Min;
+
+    /* A maximum such as 255 coded in one byte reads as -1 */
+    f->Log_Max = ( ( pg->Log_Min >= 0 ) && ( pg->Log_Max < 0 ) ) ? (int32_t)pg->Log_Max_U : pg->Log_Max;
+    if( f->Log_Min < 0 )
+    {
+        f->Flags |= DEF_HID_FLD_SIGNED;
+    }
+    return f;
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Main
+ *
+ * @brief   Compile one Input, Output or Feature item into fields. Runs of
+ *          variable elements with consecutive usages share one field, an
+ *          array is one field whose usages are taken as a range.
+ *
+ * @return  DEF_HID_RPT_OK, DEF_HID_RPT_ERR_FORMAT, DEF_HID_RPT_ERR_FULL.
+ */
+static uint8_t HID_Rpt_Main( uint8_t dev, uint8_t intf, uint8_t type, uint8_t data,
+                             uint8_t rpt_base, const HID_GLOBAL *pg, const HID_LOCAL *pl )
+{
+    HID_REPORT *r = NULL;
+    HID_FIELD  *f = NULL;
+    uint32_t   u, u_last = 0;
+    uint16_t   n, cnt;
+    uint8_t    i;
+
+    /* Report of this type and ID */
+    for( i = rpt_base; i < HID_Report_Num; i++ )
+    {
+        if( ( HID_Report[ i ].Type == type ) && ( HID_Report[ i ].ID == pg->ID ) )
+        {
+            r = &HID_Report[ i ];
+            break;
+        }
+    }
+    if( r == NULL )
+    {
+        if( HID_Report_Num >= DEF_HID_RPT_NUM_MAX )
+        {
+            return DEF_HID_RPT_ERR_FULL;
+        }
+        r = &HID_Report[ HID_Report_Num++ ];
+        r->Dev = dev;
+        r->Intf = intf;
+        r->Type = type;
+        r->ID = pg->ID;
+        r->Bits = 0;
+        r->Field_First = 0;
+        r->Field_Num = 0;
+    }
+    i = r - &HID_Report[ rpt_base ];
+
+    if( (uint32_t)r->Bits + (uint32_t)pg->Size * pg->Count > 0xFFFF )
+    {
+        return DEF_HID_RPT_ERR_FORMAT;
+    }
+
+    /* Padding, and elements too wide to decode, only move the offset */
+    if( ( data & DEF_HID_FLD_CONST ) || ( pg->Size == 0 ) || ( pg->Size > 32 ) || ( pg->Count == 0 ) )
+    {
+        r->Bits += pg->Size * pg->Count;
+        return DEF_HID_RPT_OK;
+    }
+
+    data &= DEF_HID_FLD_CONST | DEF_HID_FLD_VAR | DEF_HID_FLD_REL;
+    if( data & DEF_HID_FLD_VAR )
+    {
+        for( n = 0; n < pg->Count; n++ )
+        {
+            u = HID_Rpt_Local_Usage( pl, pg->Page, n );
+            if( f && ( u == u_last + 1 ) && ( f->Count < 0xFF ) )
+            {
+                f->Count++;
+                f->Usage_Max = u;
+            }
+            else
+            {
+                f = HID_Rpt_Add_Field( pg, i, r->Bits + n * pg->Size, 1, data, u );
+                if( f == NULL )
+                {
+                    return DEF_HID_RPT_ERR_FULL;
+                }
+            }
+            u_last = u;
+        }
+    }
+    else
+    {
+        for( n = 0; n < pg->Count; n += cnt )
+        {
+            cnt = ( pg->Count - n > 0xFF ) ? 0xFF : ( pg->Count - n );
+            f = HID_Rpt_Add_Field( pg, i, r->Bits + n * pg->Size, cnt, data, HID_Rpt_Local_Usage( pl, pg->Page, 0 ) );
+            if( f == NULL )
+            {
+                return DEF_HID_RPT_ERR_FULL;
+            }
+            if( pl->Has_Max )
+            {
+                f->Usage_Max = pl->Max;
+            }
+            else if( pl->Num )
+            {
+                f->Usage_Max = pl->Usage[ pl->Num - 1 ];
+            }
+        }
+    }
+    r->Bits += pg->Size * pg->Count;
+
+    return DEF_HID_RPT_OK;
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Compile
+ *
+ * @brief   Compile the report descriptor of one interface, replacing the
+ *          tables it had before.
+ *
+ * @para    dev: HostCtl index.
+ *          intf: Interface number.
+ *          pdesc: Report descriptor.
+ *          len: Descriptor length.
+ *
+ * @return  DEF_HID_RPT_OK, DEF_HID_RPT_ERR_FORMAT, DEF_HID_RPT_ERR_FULL.
+ */
+uint8_t HID_Rpt_Compile( uint8_t dev, uint8_t intf, const uint8_t *pdesc, uint16_t len )
+{
+    HID_GLOBAL g;
+    HID_GLOBAL stack[ DEF_HID_STACK_DEPTH ];
+    HID_LOCAL  l;
+    HID_FIELD  tmp;
+    uint32_t   val;
+    uint16_t   i;
+    uint8_t    size, type, tag;
+    uint8_t    sp = 0;
+    uint8_t    rpt_base, fld_base;
+    uint8_t    j, k;
+    uint8_t    s = DEF_HID_RPT_OK;
+
+    HID_Rpt_Free( dev, intf );
+    rpt_base = HID_Report_Num;
+    fld_base = HID_Field_Num;
+    memset( &g, 0, sizeof( g ) );
+    memset( &l, 0, sizeof( l ) );
+
+    for( i = 0; ( i < len ) && ( s == DEF_HID_RPT_OK ); i += 1 + size )
+    {
+        /* Long item: skipped */
+        if( pdesc[ i ] == 0xFE )
+        {
+            if( i + 1 >= len )
+            {
+                s = DEF_HID_RPT_ERR_FORMAT;
+                break;
+            }
+            size = pdesc[ i + 1 ] + 2;
+            continue;
+        }
+
+        /* Short item: Item Size, Item Type, Item Tag */
+        size = pdesc[ i ] & 0x03;
+        size = ( size == 3 ) ? 4 : size;
+        type = pdesc[ i ] & 0x0C;
+        tag = pdesc[ i ] & 0xF0;
+        if( i + size >= len )
+        {
+            s = DEF_HID_RPT_ERR_FORMAT;
+            break;
+        }
+        val = HID_Rpt_Item_Data( &pdesc[ i + 1 ], size, 0 );
+
+        switch( type )
+        {
+            /* Main */
+            case 0x00:
+                switch( tag )
+                {
+                    case 0x80:  // Input
+                        s = HID_Rpt_Main( dev, intf, DEF_HID_RPT_INPUT, val, rpt_base, &g, &l );
+                        break;
+                    case 0x90:  // Output
+                        s = HID_Rpt_Main( dev, intf, DEF_HID_RPT_OUTPUT, val, rpt_base, &g, &l );
+                        break;
+                    case 0xB0:  // Feature
+                        s = HID_Rpt_Main( dev, intf, DEF_HID_RPT_FEATURE, val, rpt_base, &g, &l );
+                        break;
+                    default:    // Collection, End Collection
+                        break;
+                }
+                memset( &l, 0, sizeof( l ) );
+                break;
+
+            /* Global */
+            case 0x04:
+                switch( tag )
+                {
+                    case 0x00:  // Usage Page
+                        g.Page = val;
+                        break;
+                    case 0x10:  // Logical Minimum
+                        g.Log_Min = HID_Rpt_Item_Data( &pdesc[ i + 1 ], size, 1 );
+                        break;
+                    case 0x20:  // Logical Maximum
+                        g.Log_Max = HID_Rpt_Item_Data( &pdesc[ i + 1 ], size, 1 );
+                        g.Log_Max_U = val;
+                        break;
+                    case 0x70:  // Report Size
+                        g.Size = val;
+                        break;
+                    case 0x80:  // Report ID
+                        if( ( val == 0 ) || ( val > 0xFF ) )
+                        {
+                            s = DEF_HID_RPT_ERR_FORMAT;
+                        }
+                        g.ID = val;
+                        break;
+                    case 0x90:  // Report Count
+                        g.Count = val;
+                        break;
+                    case 0xA0:  // Push
+                        if( sp >= DEF_HID_STACK_DEPTH )
+                        {
+                            s = DEF_HID_RPT_ERR_FORMAT;
+                            break;
+                        }
+                        stack[ sp++ ] = g;
+                        break;
+                    case 0xB0:  // Pop
+                        if( sp == 0 )
+                        {
+                            s = DEF_HID_RPT_ERR_FORMAT;
+                            break;
+                        }
+                        g = stack[ --sp ];
+                        break;
+                    default:    // Physical range, unit
+                        break;
+                }
+                break;
+
+            /* Local */
+            case 0x08:
+                switch( tag )
+                {
+                    case 0x00:  // Usage
+                        if( l.Num < DEF_HID_USAGE_NUM_MAX )
+                        {
+                            l.Usage[ l.Num ] = val;
+                            l.Ext |= ( size == 4 ) ? ( 1 << l.Num ) : 0;
+                            l.Num++;
+                        }
+                        break;
+                    case 0x10:  // Usage Minimum
+                        l.Min = val;
+                        l.Min_Ext = ( size == 4 );
+                        l.Has_Min = 1;
+                        break;
+                    case 0x20:  // Usage Maximum
+                        l.Max = val;
+                        l.Max_Ext = ( size == 4 );
+                        l.Has_Max = 1;
+                        break;
+                    default:    // Designators, strings, delimiters
+                        break;
+                }
+                break;
+
+            default:
+                s = DEF_HID_RPT_ERR_FORMAT;
+                break;
+        }
+    }
+
+    if( s != DEF_HID_RPT_OK )
+    {
+        /* New entries are at the end and not linked yet */
+        HID_Report_Num = rpt_base;
+        HID_Field_Num = fld_base;
+        return s;
+    }
+
+    /* Group the new fields by report, keeping descriptor order */
+    for( j = fld_base + 1; j < HID_Field_Num; j++ )
+    {
+        tmp = HID_Field[ j ];
+        for( k = j; ( k > fld_base ) && ( HID_Field[ k - 1 ].Rpt > tmp.Rpt ); k-- )
+        {
+            HID_Field[ k ] = HID_Field[ k - 1 ];
+        }
+        HID_Field[ k ] = tmp;
+    }
+    for( j = fld_base; j < HID_Field_Num; j++ )
+    {
+        if( HID_Report[ rpt_base + HID_Field[ j ].Rpt ].Field_Num++ == 0 )
+        {
+            HID_Report[ rpt_base + HID_Field[ j ].Rpt ].Field_First = j;
+        }
+    }
+    for( j = rpt_base; j < HID_Report_Num; j++ )
+    {
+        if( HID_Report[ j ].Field_Num == 0 )
+        {
+            HID_Report[ j ].Field_First = HID_Field_Num;
+        }
+    }
+
+    return DEF_HID_RPT_OK;
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Find
+ *
+ * @brief   Look up a compiled report.
+ *
+ * @para    dev: HostCtl index.
+ *          intf: Interface number.
+ *          type: DEF_HID_RPT_INPUT, DEF_HID_RPT_OUTPUT, DEF_HID_RPT_FEATURE.
+ *          id: Report ID, 0 - none.
+ *
+ * @return  Report, NULL - not found.
+ */
+const HID_REPORT *HID_Rpt_Find( uint8_t dev, uint8_t intf, uint8_t type, uint8_t id )
+{
+    uint8_t i;
+
+    for( i = 0; i < HID_Report_Num; i++ )
+    {
+        if( ( HID_Report[ i ].Dev == dev ) && ( HID_Report[ i ].Intf == intf ) &&
+            ( HID_Report[ i ].Type == type ) && ( HID_Report[ i ].ID == id ) )
+        {
+            return &HID_Report[ i ];
+        }
+    }
+    return NULL;
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Match
+ *
+ * @brief   Find the input report a received packet holds, and step past
+ *          its report ID.
+ *
+ * @para    dev: HostCtl index.
+ *          intf: Interface number.
+ *          ppdata: Received data, moved to the first byte after the ID.
+ *          len: Received length.
+ *
+ * @return  Report, NULL - unknown or too short.
+ */
+const HID_REPORT *HID_Rpt_Match( uint8_t dev, uint8_t intf, const uint8_t **ppdata, uint16_t len )
+{
+    const HID_REPORT *r;
+
+    if( len == 0 )
+    {
+        return NULL;
+    }
+
+    /* Interfaces numbering their reports prefix every report with its ID */
+    r = HID_Rpt_Find( dev, intf, DEF_HID_RPT_INPUT, 0 );
+    if( r == NULL )
+    {
+        r = HID_Rpt_Find( dev, intf, DEF_HID_RPT_INPUT, **ppdata );
+        if( r == NULL )
+        {
+            return NULL;
+        }
+        ( *ppdata )++;
+        len--;
+    }
+    if( ( (uint32_t)len << 3 ) < r->Bits )
+    {
+        return NULL;
+    }
+    return r;
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Raw
+ *
+ * @brief   Bits of element n of a field, at most 32.
+ *
+ * @para    pfld: Field.
+ *          pdata: Report data after the report ID.
+ *          n: Element, below Count.
+ *
+ * @return  Element bits, zero-extended.
+ */
+uint32_t HID_Rpt_Raw( const HID_FIELD *pfld, const uint8_t *pdata, uint8_t n )
+{
+    uint32_t pos = pfld->Bit_Ofs + (uint32_t)n * pfld->Bit_Size;
+    const uint8_t *p = pdata + ( pos >> 3 );
+    uint8_t  sh = pos & 7;
+    uint8_t  nb = ( sh + pfld->Bit_Size + 7 ) >> 3;
+    uint32_t v;
+
+    v = p[ 0 ];
+    if( nb > 1 )
+    {
+        v |= (uint32_t)p[ 1 ] << 8;
+        if( nb > 2 )
+        {
+            v |= (uint32_t)p[ 2 ] << 16;
+            if( nb > 3 )
+            {
+                v |= (uint32_t)p[ 3 ] << 24;
+            }
+        }
+    }
+    v >>= sh;
+    if( nb > 4 )
+    {
+        v |= (uint32_t)p[ 4 ] << ( 32 - sh );
+    }
+    if( pfld->Bit_Size < 32 )
+    {
+        v &= ( 1UL << pfld->Bit_Size ) - 1;
+    }
+    return v;
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Value
+ *
+ * @brief   Element n of a field, sign-extended if the logical range is.
+ *
+ * @return  Element value.
+ */
+int32_t HID_Rpt_Value( const HID_FIELD *pfld, const uint8_t *pdata, uint8_t n )
+{
+    uint32_t v = HID_Rpt_Raw( pfld, pdata, n );
+
+    if( ( pfld->Flags & DEF_HID_FLD_SIGNED ) && ( pfld->Bit_Size < 32 ) && ( v & ( 1UL << ( pfld->Bit_Size - 1 ) ) ) )
+    {
+        v |= ~( ( 1UL << pfld->Bit_Size ) - 1 );
+    }
+    return (int32_t)v;
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Usage
+ *
+ * @brief   Usage of element n: fixed for a variable field, selected by the
+ *          element value for an array.
+ *
+ * @return  Usage id, 0 - array element empty or out of range.
+ */
+uint16_t HID_Rpt_Usage( const HID_FIELD *pfld, const uint8_t *pdata, uint8_t n )
+{
+    int32_t v;
+
+    if( pfld->Flags & DEF_HID_FLD_VAR )
+    {
+        return pfld->Usage_Min + n;
+    }
+    v = HID_Rpt_Value( pfld, pdata, n );
+    if( ( v < pfld->Log_Min ) || ( v > pfld->Log_Max ) || ( v - pfld->Log_Min > pfld->Usage_Max - pfld->Usage_Min ) )
+    {
+        return 0;
+    }
+    return pfld->Usage_Min + (uint16_t)( v - pfld->Log_Min );
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Usage_On
+ *
+ * @brief   Whether a usage, e.g. a key or a button, is active in a report.
+ *
+ * @para    prpt: Report.
+ *          pdata: Report data after the report ID.
+ *          page: Usage page.
+ *          usage: Usage id.
+ *
+ * @return  1 - active, 0 - not.
+ */
+uint8_t HID_Rpt_Usage_On( const HID_REPORT *prpt, const uint8_t *pdata, uint16_t page, uint16_t usage )
+{
+    const HID_FIELD *f = &HID_Field[ prpt->Field_First ];
+    uint8_t i, n;
+
+    for( i = 0; i < prpt->Field_Num; i++, f++ )
+    {
+        if( ( f->Usage_Page != page ) || ( usage < f->Usage_Min ) || ( usage > f->Usage_Max ) )
+        {
+            continue;
+        }
+        if( f->Flags & DEF_HID_FLD_VAR )
+        {
+            return HID_Rpt_Raw( f, pdata, usage - f->Usage_Min ) ? 1 : 0;
+        }
+        for( n = 0; n < f->Count; n++ )
+        {
+            if( HID_Rpt_Usage( f, pdata, n ) == usage )
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Print
+ *
+ * @brief   Print a decoded report as page:usage=value. One-bit elements
+ *          and array entries are printed only when active.
+ *
+ * @return  none
+ */
+void HID_Rpt_Print( const HID_REPORT *prpt, const uint8_t *pdata )
+{
+    const HID_FIELD *f = &HID_Field[ prpt->Field_First ];
+    uint16_t u;
+    uint8_t  i, n;
+
+    DUG_PRINTF( "ID%02x:", prpt->ID );
+    for( i = 0; i < prpt->Field_Num; i++, f++ )
+    {
+        for( n = 0; n < f->Count; n++ )
+        {
+            if( ( f->Flags & DEF_HID_FLD_VAR ) == 0 )
+            {
+                u = HID_Rpt_Usage( f, pdata, n );
+                if( u )
+                {
+                    DUG_PRINTF( " %02x:%02x", f->Usage_Page, u );
+                }
+            }
+            else if( f->Bit_Size == 1 )
+            {
+                if( HID_Rpt_Raw( f, pdata, n ) )
+                {
+                    DUG_PRINTF( " %02x:%02x", f->Usage_Page, f->Usage_Min + n );
+                }
+            }
+            else
+            {
+                DUG_PRINTF( " %02x:%02x=%d", f->Usage_Page, f->Usage_Min + n, (int)HID_Rpt_Value( f, pdata, n ) );
+            }
+        }
+    }
+    DUG_PRINTF( "\r\n" );
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Dump
+ *
+ * @brief   Print the compiled tables of one interface.
+ *
+ * @return  none
+ */
+void HID_Rpt_Dump( uint8_t dev, uint8_t intf )
+{
+    const HID_FIELD *f;
+    uint8_t i, j;
+
+    for( i = 0; i < HID_Report_Num; i++ )
+    {
+        if( ( HID_Report[ i ].Dev != dev ) || ( HID_Report[ i ].Intf != intf ) )
+        {
+            continue;
+        }
+        DUG_PRINTF( "%s ID%02x %d bits\r\n", ( HID_Report[ i ].Type == DEF_HID_RPT_INPUT ) ? "In" :
+                    ( HID_Report[ i ].Type == DEF_HID_RPT_OUTPUT ) ? "Out" : "Feature", HID_Report[ i ].ID, HID_Report[ i ].Bits );
+        f = &HID_Field[ HID_Report[ i ].Field_First ];
+        for( j = 0; j < HID_Report[ i ].Field_Num; j++, f++ )
+        {
+            DUG_PRINTF( "  @%d %dx%d %s page %02x usage %02x-%02x range %d..%d\r\n",
+                        f->Bit_Ofs, f->Count, f->Bit_Size, ( f->Flags & DEF_HID_FLD_VAR ) ? "var" : "arr",
+                        f->Usage_Page, f->Usage_Min, f->Usage_Max, (int)f->Log_Min, (int)f->Log_Max );
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      HID_Rpt_Bench
+ *
+ * @brief   Time the decoding of every input report of one interface,
+ *          each element of each field being extracted. SysTick is used
+ *          the same way as by Delay_Us.
+ *
+ * @return  none
+ */
+void HID_Rpt_Bench( uint8_t dev, uint8_t intf )
+{
+#if DEF_HID_RPT_BENCH
+    static uint8_t   buf[ 64 ];
+    volatile int32_t sum = 0;
+    const HID_REPORT *r;
+    const HID_FIELD  *f;
+    const uint8_t    *p;
+    uint32_t loop, ticks;
+    uint8_t  i, j, n;
+
+    for( i = 0; i < HID_Report_Num; i++ )
+    {
+        if( ( HID_Report[ i ].Dev != dev ) || ( HID_Report[ i ].Intf != intf ) ||
+            ( HID_Report[ i ].Type != DEF_HID_RPT_INPUT ) || ( HID_Report[ i ].Bits > ( sizeof( buf ) - 1 ) * 8 ) )
+        {
+            continue;
+        }
+        memset( buf, 0x5A, sizeof( buf ) );
+        buf[ 0 ] = HID_Report[ i ].ID;
+
+        SysTick->SR &= ~( 1 << 0 );
+        SysTick->CMP = 0xFFFFFFFF;
+        SysTick->CTLR &= ~( 1 << 4 );
+        SysTick->CTLR |= ( 1 << 5 ) | ( 1 << 0 );
+        for( loop = 0; loop < DEF_HID_RPT_BENCH_LOOPS; loop++ )
+        {
+            p = HID_Report[ i ].ID ? buf : &buf[ 1 ];
+            r = HID_Rpt_Match( dev, intf, &p, sizeof( buf ) - 1 );
+            f = &HID_Field[ r->Field_First ];
+            for( j = 0; j < r->Field_Num; j++, f++ )
+            {
+                for( n = 0; n < f->Count; n++ )
+                {
+                    sum += HID_Rpt_Value( f, p, n );
+                }
+            }
+        }
+        ticks = (uint32_t)SysTick->CNT;
+        SysTick->CTLR &= ~( 1 << 0 );
+
+        /* SysTick counts HCLK / 8 */
+        DUG_PRINTF( "ID%02x: %d reports/s\r\n", HID_Report[ i ].ID,
+                    (uint32_t)( (uint64_t)DEF_HID_RPT_BENCH_LOOPS * ( SystemCoreClock / 8 ) / ( ticks ? ticks : 1 ) ) );
+    }
+#endif
+}
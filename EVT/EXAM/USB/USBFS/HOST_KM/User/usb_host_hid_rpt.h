@@ -0,0 +1,121 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : usb_host_hid_rpt.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : HID report descriptor compiler. Each report is turned
+ *                      into a table of fields (bit offset, size, usage and
+ *                      logical range) so that incoming reports are decoded
+ *                      without walking the descriptor again.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+#ifndef __USB_HOST_HID_RPT_H
+#define __USB_HOST_HID_RPT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************/
+/* Header File */
+#include "stdint.h"
+
+/*******************************************************************************/
+/* Macro Definition */
+
+/* Tables shared by all interfaces of all devices */
+#define DEF_HID_RPT_NUM_MAX             24                                      // Reports
+#define DEF_HID_FIELD_NUM_MAX           64                                      // Fields
+#define DEF_HID_USAGE_NUM_MAX           16                                      // Usages before one main item
+#define DEF_HID_STACK_DEPTH             2                                       // Push/Pop levels
+
+/* Decode and time every compiled input report after enumeration */
+#define DEF_HID_RPT_BENCH               0
+#define DEF_HID_RPT_BENCH_LOOPS         10000
+
+/* Report Type */
+#define DEF_HID_RPT_INPUT               0x00
+#define DEF_HID_RPT_OUTPUT              0x01
+#define DEF_HID_RPT_FEATURE             0x02
+
+/* Field Flags, bit0-bit2 as in the Input/Output/Feature item */
+#define DEF_HID_FLD_CONST               0x01                                    // Constant, never stored
+#define DEF_HID_FLD_VAR                 0x02                                    // Variable, else array
+#define DEF_HID_FLD_REL                 0x04                                    // Relative
+#define DEF_HID_FLD_SIGNED              0x80                                    // Logical minimum below 0
+
+/* Usage Pages */
+#define DEF_HID_PAGE_DESKTOP            0x01
+#define DEF_HID_PAGE_KEYBOARD           0x07
+#define DEF_HID_PAGE_LED                0x08
+#define DEF_HID_PAGE_BUTTON             0x09
+
+/* Compile Result */
+#define DEF_HID_RPT_OK                  0x00
+#define DEF_HID_RPT_ERR_FORMAT          0x01                                    // Malformed descriptor
+#define DEF_HID_RPT_ERR_FULL            0x02                                    // Tables full
+
+/*******************************************************************************/
+/* Struct Definition */
+
+/* One field: Count elements of Bit_Size bits from Bit_Ofs. Element n of a
+ * variable field has usage Usage_Min + n; an array element holds an index,
+ * Log_Min standing for Usage_Min. */
+typedef struct _HID_FIELD
+{
+    uint16_t Bit_Ofs;                                                           // From the first byte after the report ID
+    uint8_t  Bit_Size;
+    uint8_t  Count;
+    uint8_t  Flags;
+    uint8_t  Rpt;                                                               // Report of the field, used while compiling
+    uint16_t Usage_Page;
+    uint16_t Usage_Min;
+    uint16_t Usage_Max;
+    int32_t  Log_Min;
+    int32_t  Log_Max;
+} HID_FIELD, *PHID_FIELD;
+
+/* One report of one interface; its fields are Field_First.. in HID_Field[ ] */
+typedef struct _HID_REPORT
+{
+    uint8_t  Dev;                                                               // HostCtl index
+    uint8_t  Intf;
+    uint8_t  Type;
+    uint8_t  ID;                                                                // 0 - no report ID
+    uint16_t Bits;                                                              // Length without the report ID
+    uint8_t  Field_First;
+    uint8_t  Field_Num;
+} HID_REPORT, *PHID_REPORT;
+
+/*******************************************************************************/
+/* Variable Declaration */
+extern HID_REPORT HID_Report[ DEF_HID_RPT_NUM_MAX ];
+extern HID_FIELD  HID_Field[ DEF_HID_FIELD_NUM_MAX ];
+extern uint8_t    HID_Report_Num;
+extern uint8_t    HID_Field_Num;
+
+/*******************************************************************************/
+/* Function Declaration */
+extern void HID_Rpt_Init( void );
+extern void HID_Rpt_Free( uint8_t dev, uint8_t intf );
+extern uint8_t HID_Rpt_Compile( uint8_t dev, uint8_t intf, const uint8_t *pdesc, uint16_t len );
+extern const HID_REPORT *HID_Rpt_Find( uint8_t dev, uint8_t intf, uint8_t type, uint8_t id );
+extern const HID_REPORT *HID_Rpt_Match( uint8_t dev, uint8_t intf, const uint8_t **ppdata, uint16_t len );
+extern uint32_t HID_Rpt_Raw( const HID_FIELD *pfld, const uint8_t *pdata, uint8_t n );
+extern int32_t HID_Rpt_Value( const HID_FIELD *pfld, const uint8_t *pdata, uint8_t n );
+extern uint16_t HID_Rpt_Usage( const HID_FIELD *pfld, const uint8_t *pdata, uint8_t n );
+extern uint8_t HID_Rpt_Usage_On( const HID_REPORT *prpt, const uint8_t *pdata, uint16_t page, uint16_t usage );
+extern void HID_Rpt_Print( const HID_REPORT *prpt, const uint8_t *pdata );
+extern void HID_Rpt_Dump( uint8_t dev, uint8_t intf );
+extern void HID_Rpt_Bench( uint8_t dev, uint8_t intf );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
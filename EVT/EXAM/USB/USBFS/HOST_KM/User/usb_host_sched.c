@@ -0,0 +1,318 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : usb_host_sched.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Interrupt IN endpoint scheduler of the USB host. As in
+ *                      an OHCI interrupt tree, every interval is rounded down
+ *                      to a power of two and given the frame phase carrying
+ *                      the fewest endpoints, so that the devices of a hub
+ *                      tree are spread over the frames instead of all being
+ *                      polled in the same one.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+/********************************************************************************/
+/* Header File */
+#include "usb_host_config.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+volatile uint16_t USBH_Sched_Ms;                                                // Frame counter, TIM3
+USBH_SLOT USBH_Slot[ DEF_SCHED_SLOT_MAX ];
+uint8_t   USBH_Slot_Num;
+uint8_t   USBH_Frame_Load[ DEF_SCHED_FRAMES ];                                  // Endpoints polled in each frame
+
+/*********************************************************************
+ * @fn      USBH_Sched_Init
+ *
+ * @brief   Remove every endpoint from the schedule.
+ *
+ * @return  none
+ */
+void USBH_Sched_Init( void )
+{
+    USBH_Slot_Num = 0;
+    memset( USBH_Frame_Load, 0, sizeof( USBH_Frame_Load ) );
+}
+
+/*********************************************************************
+ * @fn      USBH_Sched_Tick
+ *
+ * @brief   Start of a frame, called every 1ms from the TIM3 interrupt.
+ *
+ * @return  none
+ */
+void USBH_Sched_Tick( void )
+{
+    USBH_Sched_Ms++;
+}
+
+/*********************************************************************
+ * @fn      USBH_Sched_Us
+ *
+ * @brief   Current time, 100us resolution from the TIM3 counter.
+ *
+ * @return  Time in us, wraps with the frame counter.
+ */
+uint32_t USBH_Sched_Us( void )
+{
+    uint16_t ms;
+    uint16_t cnt;
+
+    do
+    {
+        ms = USBH_Sched_Ms;
+        cnt = TIM3->CNT;
+    } while( ms != USBH_Sched_Ms );
+
+    return (uint32_t)ms * 1000 + (uint32_t)cnt * 100;
+}
+
+/*********************************************************************
+ * @fn      USBH_Sched_Add
+ *
+ * @brief   Schedule one interrupt IN endpoint.
+ *
+ * @para    dev: HostCtl index.
+ *          hub_port: RootHubDev.Device[ ] index, DEF_SCHED_ROOT.
+ *          intf: Interface number.
+ *          in_num: Index in InEndpAddr[ ].
+ *          interval: bInterval in ms.
+ *
+ * @return  ERR_SUCCESS, ERR_USB_BUF_OVER - schedule full.
+ */
+uint8_t USBH_Sched_Add( uint8_t dev, uint8_t hub_port, uint8_t intf, uint8_t in_num, uint8_t interval )
+{
+    USBH_SLOT *p;
+    uint8_t  period = 1;
+    uint8_t  phase, best_phase = 0;
+    uint8_t  load, best_load = 0xFF;
+    uint8_t  f;
+
+    if( USBH_Slot_Num >= DEF_SCHED_SLOT_MAX )
+    {
+        return ERR_USB_BUF_OVER;
+    }
+
+    /* Polling more often than asked is allowed, less often is not */
+    while( ( period * 2 <= interval ) && ( period * 2 <= DEF_SCHED_FRAMES ) )
+    {
+        period *= 2;
+    }
+
+    /* Phase whose busiest frame is the least busy */
+    for( phase = 0; phase < period; phase++ )
+    {
+        load = 0;
+        for( f = phase; f < DEF_SCHED_FRAMES; f += period )
+        {
+            if( USBH_Frame_Load[ f ] > load )
+            {
+                load = USBH_Frame_Load[ f ];
+            }
+        }
+        if( load < best_load )
+        {
+            best_load = load;
+            best_phase = phase;
+        }
+    }
+    for( f = best_phase; f < DEF_SCHED_FRAMES; f += period )
+    {
+        USBH_Frame_Load[ f ]++;
+    }
+
+    p = &USBH_Slot[ USBH_Slot_Num++ ];
+    memset( p, 0, sizeof( USBH_SLOT ) );
+    p->Dev = dev;
+    p->Hub_Port = hub_port;
+    p->Intf = intf;
+    p->In_Num = in_num;
+    p->Interval = period;
+    p->Phase = best_phase;
+    p->Due = USBH_Sched_Ms + 1;
+    p->Due += ( best_phase - p->Due ) & ( period - 1 );
+
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      USBH_Sched_Add_Dev
+ *
+ * @brief   Schedule every interrupt IN endpoint of an enumerated device.
+ *
+ * @para    dev: HostCtl index.
+ *          hub_port: RootHubDev.Device[ ] index, DEF_SCHED_ROOT.
+ *
+ * @return  none
+ */
+void USBH_Sched_Add_Dev( uint8_t dev, uint8_t hub_port )
+{
+    uint8_t intf_num, in_num;
+
+    USBH_Sched_Remove( dev );
+    for( intf_num = 0; intf_num < HostCtl[ dev ].InterfaceNum; intf_num++ )
+    {
+        for( in_num = 0; in_num < HostCtl[ dev ].Interface[ intf_num ].InEndpNum; in_num++ )
+        {
+            if( ( HostCtl[ dev ].Interface[ intf_num ].InEndpType[ in_num ] & 0x03 ) != 0x03 )     // Interrupt only
+            {
+                continue;
+            }
+            if( USBH_Sched_Add( dev, hub_port, intf_num, in_num, HostCtl[ dev ].Interface[ intf_num ].InEndpInterval[ in_num ] ) != ERR_SUCCESS )
+            {
+                DUG_PRINTF( "Sched Full\r\n" );
+                return;
+            }
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      USBH_Sched_Remove
+ *
+ * @brief   Remove the endpoints of one device from the schedule.
+ *
+ * @para    dev: HostCtl index, 0xFF - all devices.
+ *
+ * @return  none
+ */
+void USBH_Sched_Remove( uint8_t dev )
+{
+    uint8_t i, f;
+
+    i = 0;
+    while( i < USBH_Slot_Num )
+    {
+        if( ( dev != 0xFF ) && ( USBH_Slot[ i ].Dev != dev ) )
+        {
+            i++;
+            continue;
+        }
+        for( f = USBH_Slot[ i ].Phase; f < DEF_SCHED_FRAMES; f += USBH_Slot[ i ].Interval )
+        {
+            USBH_Frame_Load[ f ]--;
+        }
+        USBH_Slot_Num--;
+        memmove( &USBH_Slot[ i ], &USBH_Slot[ i + 1 ], ( USBH_Slot_Num - i ) * sizeof( USBH_SLOT ) );
+    }
+}
+
+/*********************************************************************
+ * @fn      USBH_Sched_Next
+ *
+ * @brief   Endpoint to poll now: of those whose frame has come, the one
+ *          waiting longest.
+ *
+ * @return  Endpoint, NULL - none due.
+ */
+USBH_SLOT *USBH_Sched_Next( void )
+{
+    USBH_SLOT *p = NULL;
+    uint16_t now = USBH_Sched_Ms;
+    int16_t  late, late_max = -1;
+    uint8_t  i;
+
+    for( i = 0; i < USBH_Slot_Num; i++ )
+    {
+        late = (int16_t)( now - USBH_Slot[ i ].Due );
+        if( late > late_max )
+        {
+            late_max = late;
+            p = &USBH_Slot[ i ];
+        }
+    }
+    return p;
+}
+
+/*********************************************************************
+ * @fn      USBH_Sched_Done
+ *
+ * @brief   Account for one poll and move the endpoint to its next frame.
+ *          Frames the main loop was too late for are skipped, not made
+ *          up for with back-to-back polls.
+ *
+ * @para    pslot: Endpoint returned by USBH_Sched_Next.
+ *          s: Transfer result.
+ *
+ * @return  none
+ */
+void USBH_Sched_Done( USBH_SLOT *pslot, uint8_t s )
+{
+    uint32_t late;
+    uint16_t now;
+
+    /* Us since the start of the due frame, the frame counter wrapping at 65536 */
+    late = USBH_Sched_Us( ) + 65536000UL - (uint32_t)pslot->Due * 1000;
+    if( late >= 65536000UL )
+    {
+        late -= 65536000UL;
+    }
+    if( late > 0xFFFF )
+    {
+        late = 0xFFFF;
+    }
+    if( late > pslot->Late_Max )
+    {
+        pslot->Late_Max = late;
+    }
+    pslot->Late_Sum += late;
+
+    pslot->Polls++;
+    if( s == ERR_SUCCESS )
+    {
+        pslot->Data++;
+    }
+    else if( s == ( USB_PID_NAK | ERR_USB_TRANSFER ) )
+    {
+        pslot->Nak++;
+    }
+    else
+    {
+        pslot->Err++;
+    }
+
+    now = USBH_Sched_Ms;
+    pslot->Due += pslot->Interval;
+    while( (int16_t)( now - pslot->Due ) >= 0 )
+    {
+        pslot->Due += pslot->Interval;
+        pslot->Missed++;
+    }
+}
+
+/*********************************************************************
+ * @fn      USBH_Sched_Stat_Print
+ *
+ * @brief   Print the polling statistics of every scheduled endpoint since
+ *          the last print, and restart them.
+ *
+ * @return  none
+ */
+void USBH_Sched_Stat_Print( void )
+{
+    USBH_SLOT *p;
+    uint8_t  i;
+
+    for( i = 0; i < USBH_Slot_Num; i++ )
+    {
+        p = &USBH_Slot[ i ];
+        DUG_PRINTF( "Dev%d Port%d If%d Ep%02x %dms/%d: poll %d data %d nak %d err %d missed %d late avg %dus max %dus\r\n",
+                    p->Dev, ( p->Hub_Port == DEF_SCHED_ROOT ) ? 0 : ( p->Hub_Port + 1 ), p->Intf,
+                    HostCtl[ p->Dev ].Interface[ p->Intf ].InEndpAddr[ p->In_Num ] | 0x80, p->Interval, p->Phase,
+                    p->Polls, p->Data, p->Nak, p->Err, p->Missed,
+                    p->Polls ? ( p->Late_Sum / p->Polls ) : 0, p->Late_Max );
+        p->Polls = 0;
+        p->Data = 0;
+        p->Nak = 0;
+        p->Err = 0;
+        p->Missed = 0;
+        p->Late_Sum = 0;
+        p->Late_Max = 0;
+    }
+}
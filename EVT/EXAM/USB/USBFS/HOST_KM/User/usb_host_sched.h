@@ -0,0 +1,83 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : usb_host_sched.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Interrupt IN endpoint scheduler of the USB host.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+#ifndef __USB_HOST_SCHED_H
+#define __USB_HOST_SCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************/
+/* Header File */
+#include "stdint.h"
+
+/*******************************************************************************/
+/* Macro Definition */
+#define DEF_SCHED_SLOT_MAX              24                                      // Interrupt IN endpoints of all devices
+#define DEF_SCHED_FRAMES                32                                      // Longest interval, 1ms frames
+
+/* Hub_Port of a device on the root port */
+#define DEF_SCHED_ROOT                  0xFF
+
+/* Statistics print period in ms, 0 - off */
+#define DEF_SCHED_STAT_PERIOD           10000
+
+/*******************************************************************************/
+/* Struct Definition */
+
+/* One interrupt IN endpoint, polled in the frames where
+ * ( frame & ( Interval - 1 ) ) == Phase */
+typedef struct _USBH_SLOT
+{
+    uint8_t  Dev;                                                               // HostCtl index
+    uint8_t  Hub_Port;                                                          // RootHubDev.Device[ ] index, DEF_SCHED_ROOT
+    uint8_t  Intf;
+    uint8_t  In_Num;
+    uint8_t  Interval;                                                          // bInterval rounded down to a power of two
+    uint8_t  Phase;
+    uint16_t Due;                                                               // Frame of the next poll
+
+    /* Statistics */
+    uint32_t Polls;
+    uint32_t Data;
+    uint32_t Nak;
+    uint32_t Err;
+    uint32_t Missed;                                                            // Frames skipped because the loop was late
+    uint32_t Late_Sum;                                                          // Us, due frame start to transaction
+    uint16_t Late_Max;
+} USBH_SLOT, *PUSBH_SLOT;
+
+/*******************************************************************************/
+/* Variable Declaration */
+extern volatile uint16_t USBH_Sched_Ms;
+extern USBH_SLOT USBH_Slot[ DEF_SCHED_SLOT_MAX ];
+extern uint8_t   USBH_Slot_Num;
+
+/*******************************************************************************/
+/* Function Declaration */
+extern void USBH_Sched_Init( void );
+extern void USBH_Sched_Tick( void );
+extern uint32_t USBH_Sched_Us( void );
+extern uint8_t USBH_Sched_Add( uint8_t dev, uint8_t hub_port, uint8_t intf, uint8_t in_num, uint8_t interval );
+extern void USBH_Sched_Add_Dev( uint8_t dev, uint8_t hub_port );
+extern void USBH_Sched_Remove( uint8_t dev );
+extern USBH_SLOT *USBH_Sched_Next( void );
+extern void USBH_Sched_Done( USBH_SLOT *pslot, uint8_t s );
+extern void USBH_Sched_Stat_Print( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
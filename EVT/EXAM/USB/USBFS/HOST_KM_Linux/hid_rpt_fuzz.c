@@ -0,0 +1,506 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : hid_rpt_fuzz.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Fuzz target of the HID report descriptor compiler and
+ *                      report decoder of HOST_KM, built for the PC.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * usb_host_hid_rpt.c of HOST_KM is compiled in as it is. One input is a
+ * sequence of records, each one standing for something a device does:
+ *   ctl, len_lo, len_hi, descriptor[ len ], rpt_len, report[ rpt_len ]
+ *   ctl bit0-2  HostCtl index
+ *       bit3-4  interface
+ *       bit5    the device disconnects after the record
+ *       bit6    only the interface is freed after the record
+ * A length running past the end of the input is cut to what is left. The
+ * descriptor is compiled, the report is matched and every element of every
+ * field decoded, printed and looked up by usage. The descriptor and report
+ * are copied to buffers of their exact size, so AddressSanitizer sees any
+ * read past them. After each record the tables are checked:
+ *   - the field ranges of the reports tile HID_Field[ 0..HID_Field_Num-1 ],
+ *   - every field lies inside its report, with 1..32 bit elements,
+ *   - a descriptor that fails to compile leaves no report behind,
+ *   - a freed device or interface leaves no report behind.
+ * A failed check calls abort( ).
+ *
+ * libFuzzer build (clang):
+ *   clang -g -O1 -fsanitize=fuzzer,address,undefined -DHID_FUZZ_LIBFUZZER
+ *       -I../HOST_KM/User -I../../../SRC/Core -I../../../SRC/Debug
+ *       -I../../../SRC/Peripheral/inc -o hid_rpt_fuzz hid_rpt_fuzz.c
+ *   hid_rpt_fuzz corpus_dir
+ *
+ * Stand-alone build (gcc or clang), with a built-in mutator:
+ *   gcc -g -O1 -fsanitize=address,undefined -fno-sanitize-recover=all
+ *       -I../HOST_KM/User -I../../../SRC/Core -I../../../SRC/Debug
+ *       -I../../../SRC/Peripheral/inc -o hid_rpt_fuzz hid_rpt_fuzz.c
+ *
+ * Usage (stand-alone):
+ *   hid_rpt_fuzz [-n runs] [-s seed] [file...]
+ *   file  inputs to replay, e.g. a crash written by libFuzzer
+ *   -n    mutated inputs to run when no file is given, 1000000 by default
+ *   -s    seed of the mutator, 1 by default
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#ifndef HID_FUZZ_LIBFUZZER
+#include <unistd.h>
+#endif
+
+/* The example and the peripheral headers as they are, minus the RISC-V bits */
+#define interrupt( x )      unused
+#include "debug.h"
+
+/* Printed reports go through vsnprintf only */
+static int Fuzz_Printf( const char *fmt, ... )
+{
+    char buf[ 256 ];
+    va_list ap;
+    int n;
+
+    va_start( ap, fmt );
+    n = vsnprintf( buf, sizeof( buf ), fmt, ap );
+    va_end( ap );
+    return n;
+}
+#define printf              Fuzz_Printf
+
+#include "../HOST_KM/User/usb_host_hid_rpt.c"
+
+#undef printf
+
+/*********************************************************************
+ * @fn      Fuzz_Check
+ *
+ * @brief   Check the report and field tables.
+ *
+ * @return  none, abort( ) on a broken table
+ */
+static void Fuzz_Check( void )
+{
+    const HID_REPORT *r;
+    const HID_FIELD *f;
+    uint8_t i, j;
+    uint16_t next = 0;
+
+    if( ( HID_Report_Num > DEF_HID_RPT_NUM_MAX ) || ( HID_Field_Num > DEF_HID_FIELD_NUM_MAX ) )
+    {
+        fprintf( stderr, "table count %d reports %d fields\n", HID_Report_Num, HID_Field_Num );
+        abort( );
+    }
+    for( i = 0; i < HID_Report_Num; i++ )
+    {
+        r = &HID_Report[ i ];
+        if( r->Field_Num == 0 )
+        {
+            continue;
+        }
+        if( r->Field_First != next )
+        {
+            fprintf( stderr, "report %d: fields from %d, expected %d\n", i, r->Field_First, next );
+            abort( );
+        }
+        next += r->Field_Num;
+        for( j = 0, f = &HID_Field[ r->Field_First ]; j < r->Field_Num; j++, f++ )
+        {
+            if( ( f->Bit_Size == 0 ) || ( f->Bit_Size > 32 ) || ( f->Count == 0 ) ||
+                ( f->Bit_Ofs + (uint32_t)f->Count * f->Bit_Size > r->Bits ) )
+            {
+                fprintf( stderr, "report %d field %d: @%d %dx%d in %d bits\n",
+                         i, j, f->Bit_Ofs, f->Count, f->Bit_Size, r->Bits );
+                abort( );
+            }
+        }
+    }
+    if( next != HID_Field_Num )
+    {
+        fprintf( stderr, "reports hold %d fields of %d\n", next, HID_Field_Num );
+        abort( );
+    }
+}
+
+/*********************************************************************
+ * @fn      Fuzz_None
+ *
+ * @brief   Check that no report is left of a device or an interface.
+ *
+ * @param   dev - HostCtl index
+ *          intf - interface, 0xFF - all
+ *
+ * @return  none, abort( ) if one is
+ */
+static void Fuzz_None( uint8_t dev, uint8_t intf )
+{
+    uint8_t i;
+
+    for( i = 0; i < HID_Report_Num; i++ )
+    {
+        if( ( HID_Report[ i ].Dev == dev ) && ( ( intf == 0xFF ) || ( HID_Report[ i ].Intf == intf ) ) )
+        {
+            fprintf( stderr, "report %d of dev %d intf %d left\n", i, dev, HID_Report[ i ].Intf );
+            abort( );
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      Fuzz_Decode
+ *
+ * @brief   Match a report and decode all of it.
+ *
+ * @param   dev - HostCtl index
+ *          intf - interface
+ *          pdata - report, exactly len bytes
+ *          len - report length
+ *
+ * @return  none
+ */
+static void Fuzz_Decode( uint8_t dev, uint8_t intf, const uint8_t *pdata, uint16_t len )
+{
+    const HID_REPORT *r;
+    const HID_FIELD *f;
+    const uint8_t *p = pdata;
+    volatile uint32_t sink = 0;
+    uint8_t i, n;
+
+    r = HID_Rpt_Match( dev, intf, &p, len );
+    if( r == NULL )
+    {
+        return;
+    }
+    if( ( p - pdata ) + ( ( r->Bits + 7 ) >> 3 ) > len )
+    {
+        fprintf( stderr, "report ID%02x: %d bits matched in %d bytes\n", r->ID, r->Bits, len );
+        abort( );
+    }
+    for( i = 0, f = &HID_Field[ r->Field_First ]; i < r->Field_Num; i++, f++ )
+    {
+        for( n = 0; n < f->Count; n++ )
+        {
+            sink += HID_Rpt_Raw( f, p, n );
+            sink += (uint32_t)HID_Rpt_Value( f, p, n );
+            sink += HID_Rpt_Usage( f, p, n );
+        }
+        sink += HID_Rpt_Usage_On( r, p, f->Usage_Page, f->Usage_Min );
+        sink += HID_Rpt_Usage_On( r, p, f->Usage_Page, f->Usage_Max );
+    }
+    sink += HID_Rpt_Usage_On( r, p, DEF_HID_PAGE_KEYBOARD, 0x39 );
+    HID_Rpt_Print( r, p );
+    (void)sink;
+}
+
+/*********************************************************************
+ * @fn      LLVMFuzzerTestOneInput
+ *
+ * @brief   Run one input, starting from empty tables.
+ *
+ * @param   data - input
+ *          size - input length
+ *
+ * @return  0
+ */
+int LLVMFuzzerTestOneInput( const uint8_t *data, size_t size )
+{
+    const uint8_t *end = data + size;
+    uint8_t *buf;
+    uint8_t ctl, dev, intf, s;
+    uint16_t len;
+
+    HID_Rpt_Init( );
+    while( end - data >= 3 )
+    {
+        ctl = data[ 0 ];
+        dev = ctl & 0x07;
+        intf = ( ctl >> 3 ) & 0x03;
+        len = data[ 1 ] | ( data[ 2 ] << 8 );
+        data += 3;
+        len = ( len > end - data ) ? (uint16_t)( end - data ) : len;
+
+        buf = malloc( len ? len : 1 );
+        memcpy( buf, data, len );
+        s = HID_Rpt_Compile( dev, intf, buf, len );
+        free( buf );
+        data += len;
+        Fuzz_Check( );
+        if( s != DEF_HID_RPT_OK )
+        {
+            Fuzz_None( dev, intf );
+        }
+
+        if( data < end )
+        {
+            len = *data++;
+            len = ( len > end - data ) ? (uint16_t)( end - data ) : len;
+            buf = malloc( len ? len : 1 );
+            memcpy( buf, data, len );
+            Fuzz_Decode( dev, intf, buf, len );
+            free( buf );
+            data += len;
+        }
+        HID_Rpt_Dump( dev, intf );
+
+        if( ctl & 0x20 )
+        {
+            HID_Rpt_Free( dev, 0xFF );
+            Fuzz_None( dev, 0xFF );
+        }
+        else if( ctl & 0x40 )
+        {
+            HID_Rpt_Free( dev, intf );
+            Fuzz_None( dev, intf );
+        }
+        Fuzz_Check( );
+    }
+    return 0;
+}
+
+#ifndef HID_FUZZ_LIBFUZZER
+
+/* Seeds: a boot keyboard, a mouse with a consumer control report, a pad */
+static const uint8_t Fuzz_Seed_KB[ ] =
+{
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x95, 0x01, 0x75, 0x08, 0x81, 0x01, 0x95, 0x05, 0x75, 0x01,
+    0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x91, 0x02, 0x95, 0x01, 0x75, 0x03, 0x91, 0x01, 0x95, 0x06,
+    0x75, 0x08, 0x15, 0x00, 0x25, 0xFF, 0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00, 0xC0
+};
+
+static const uint8_t Fuzz_Seed_MS[ ] =
+{
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x85, 0x02, 0x09, 0x01, 0xA1, 0x00, 0x05, 0x09, 0x19, 0x01,
+    0x29, 0x05, 0x15, 0x00, 0x25, 0x01, 0x95, 0x05, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x03,
+    0x81, 0x01, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x16, 0x01, 0x80, 0x26, 0xFF, 0x7F, 0x75, 0x10,
+    0x95, 0x02, 0x81, 0x06, 0x09, 0x38, 0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x01, 0x81, 0x06,
+    0xC0, 0xC0,
+    0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01, 0x85, 0x03, 0x19, 0x00, 0x2A, 0x3C, 0x02, 0x15, 0x00, 0x26,
+    0x3C, 0x02, 0x95, 0x01, 0x75, 0x10, 0x81, 0x00, 0xC0
+};
+
+static const uint8_t Fuzz_Seed_Pad[ ] =
+{
+    0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0xA4, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x04,
+    0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x81, 0x02, 0xB4, 0x05, 0x09, 0x19, 0x01, 0x29,
+    0x0C, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x0C, 0x81, 0x02, 0x75, 0x04, 0x95, 0x01, 0x81,
+    0x03, 0x05, 0x01, 0x09, 0x39, 0x15, 0x00, 0x25, 0x07, 0x35, 0x00, 0x46, 0x3B, 0x01, 0x65, 0x14,
+    0x75, 0x04, 0x95, 0x01, 0x81, 0x42, 0x75, 0x04, 0x81, 0x01, 0x0B, 0x01, 0x00, 0xFF, 0x00, 0x75,
+    0x20, 0x95, 0x01, 0x81, 0x02, 0xC0
+};
+
+#define FUZZ_MAX            2048
+
+/*********************************************************************
+ * @fn      Fuzz_Rand
+ *
+ * @brief   xorshift32.
+ *
+ * @return  next random number
+ */
+static uint32_t Fuzz_Seed = 1;
+
+static uint32_t Fuzz_Rand( void )
+{
+    Fuzz_Seed ^= Fuzz_Seed << 13;
+    Fuzz_Seed ^= Fuzz_Seed >> 17;
+    Fuzz_Seed ^= Fuzz_Seed << 5;
+    return Fuzz_Seed;
+}
+
+/*********************************************************************
+ * @fn      Fuzz_Record
+ *
+ * @brief   Append one record built from a seed descriptor.
+ *
+ * @param   pbuf - input being built
+ *          pos - its length
+ *
+ * @return  new length
+ */
+static size_t Fuzz_Record( uint8_t *pbuf, size_t pos )
+{
+    static const struct
+    {
+        const uint8_t *Desc;
+        uint16_t Len;
+    } seed[ ] =
+    {
+        { Fuzz_Seed_KB, sizeof( Fuzz_Seed_KB ) },
+        { Fuzz_Seed_MS, sizeof( Fuzz_Seed_MS ) },
+        { Fuzz_Seed_Pad, sizeof( Fuzz_Seed_Pad ) },
+    };
+    uint32_t k = Fuzz_Rand( ) % 3;
+    uint16_t len = seed[ k ].Len;
+    uint8_t rlen = 1 + Fuzz_Rand( ) % 16;
+    uint8_t i;
+
+    if( pos + 3 + len + 1 + rlen > FUZZ_MAX )
+    {
+        return pos;
+    }
+    pbuf[ pos++ ] = (uint8_t)Fuzz_Rand( );
+    pbuf[ pos++ ] = (uint8_t)len;
+    pbuf[ pos++ ] = (uint8_t)( len >> 8 );
+    memcpy( &pbuf[ pos ], seed[ k ].Desc, len );
+    pos += len;
+    pbuf[ pos++ ] = rlen;
+    for( i = 0; i < rlen; i++ )
+    {
+        pbuf[ pos++ ] = (uint8_t)Fuzz_Rand( );
+    }
+    return pos;
+}
+
+/*********************************************************************
+ * @fn      Fuzz_Mutate
+ *
+ * @brief   Build an input of one to four seed records and mutate it:
+ *          flip bits, set bytes to interesting values, insert, delete
+ *          or duplicate ranges.
+ *
+ * @param   pbuf - FUZZ_MAX bytes
+ *
+ * @return  input length
+ */
+static size_t Fuzz_Mutate( uint8_t *pbuf )
+{
+    static const uint8_t magic[ ] = { 0x00, 0x01, 0x03, 0x7F, 0x80, 0xFE, 0xFF, 0x20, 0x21, 0x40 };
+    size_t len = 0, i, n, a, b;
+    uint32_t k;
+
+    n = 1 + Fuzz_Rand( ) % 4;
+    for( i = 0; i < n; i++ )
+    {
+        len = Fuzz_Record( pbuf, len );
+    }
+
+    n = 1 + Fuzz_Rand( ) % 8;
+    for( i = 0; ( i < n ) && len; i++ )
+    {
+        a = Fuzz_Rand( ) % len;
+        k = Fuzz_Rand( ) % 6;
+        switch( k )
+        {
+            case 0:
+                pbuf[ a ] ^= 1 << ( Fuzz_Rand( ) % 8 );
+                break;
+            case 1:
+                pbuf[ a ] = magic[ Fuzz_Rand( ) % sizeof( magic ) ];
+                break;
+            case 2:
+                pbuf[ a ] = (uint8_t)Fuzz_Rand( );
+                break;
+            case 3:
+                b = 1 + Fuzz_Rand( ) % 8;
+                if( len + b <= FUZZ_MAX )
+                {
+                    memmove( &pbuf[ a + b ], &pbuf[ a ], len - a );
+                    for( k = 0; k < b; k++ )
+                    {
+                        pbuf[ a + k ] = (uint8_t)Fuzz_Rand( );
+                    }
+                    len += b;
+                }
+                break;
+            case 4:
+                b = 1 + Fuzz_Rand( ) % 8;
+                b = ( b > len - a ) ? len - a : b;
+                memmove( &pbuf[ a ], &pbuf[ a + b ], len - a - b );
+                len -= b;
+                break;
+            default:
+                b = 1 + Fuzz_Rand( ) % 32;
+                b = ( b > len - a ) ? len - a : b;
+                if( len + b <= FUZZ_MAX )
+                {
+                    memmove( &pbuf[ a + b ], &pbuf[ a ], len - a );
+                    len += b;
+                }
+                break;
+        }
+    }
+    return len;
+}
+
+/*********************************************************************
+ * @fn      Fuzz_File
+ *
+ * @brief   Replay one input file.
+ *
+ * @param   name - file
+ *
+ * @return  0 - run, 1 - unreadable
+ */
+static int Fuzz_File( const char *name )
+{
+    FILE *fp = fopen( name, "rb" );
+    uint8_t *buf;
+    size_t len;
+
+    if( fp == NULL )
+    {
+        perror( name );
+        return 1;
+    }
+    buf = malloc( 1 << 20 );
+    len = fread( buf, 1, 1 << 20, fp );
+    fclose( fp );
+    LLVMFuzzerTestOneInput( buf, len );
+    free( buf );
+    printf( "%s: %u bytes ok\n", name, (unsigned)len );
+    return 0;
+}
+
+int main( int argc, char **argv )
+{
+    uint8_t *buf;
+    unsigned long runs = 1000000, i;
+    size_t len;
+    int c, fail = 0;
+
+    while( ( c = getopt( argc, argv, "n:s:" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 'n':
+                runs = strtoul( optarg, NULL, 0 );
+                break;
+            case 's':
+                Fuzz_Seed = strtoul( optarg, NULL, 0 );
+                Fuzz_Seed = Fuzz_Seed ? Fuzz_Seed : 1;
+                break;
+            default:
+                fprintf( stderr, "usage: %s [-n runs] [-s seed] [file...]\n", argv[ 0 ] );
+                return 2;
+        }
+    }
+    if( optind < argc )
+    {
+        for( ; optind < argc; optind++ )
+        {
+            fail |= Fuzz_File( argv[ optind ] );
+        }
+        return fail;
+    }
+
+    buf = malloc( FUZZ_MAX );
+    for( i = 0; i < runs; i++ )
+    {
+        len = Fuzz_Mutate( buf );
+        LLVMFuzzerTestOneInput( buf, len );
+    }
+    free( buf );
+    printf( "%lu inputs ok\n", runs );
+    return 0;
+}
+
+#endif
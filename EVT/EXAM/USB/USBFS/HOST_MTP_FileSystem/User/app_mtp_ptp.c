@@ -567,6 +567,11 @@ uint8_t USBH_PTP_GetResponse( void )
     uint32_t len;
 
     s = MTP_RecvData( (uint8_t *)&PTP_RespContainer, &len );
+    if( ( s == ERR_SUCCESS ) && ( len == 0 ) )
+    {
+        /* Zero-length packet ending a data phase that filled its last packet */
+        s = MTP_RecvData( (uint8_t *)&PTP_RespContainer, &len );
+    }
     if( s == ERR_SUCCESS )
     {
         if( PTP_RespContainer.code == PTP_RC_OK )
@@ -668,6 +673,21 @@ uint8_t USBH_PTP_GetDeviceInfo( void )
     PTP_DeviceInfo.VendorExtensionID = LE32( PTP_Handle.data_ptr + PTP_di_VendorExtensionID );
     DUG_PRINTF( "StandardVersion: %02x, VendorExtensionID: %2x\r\n", PTP_DeviceInfo.StandardVersion, PTP_DeviceInfo.VendorExtensionID );
 
+    /* Operations supported, after the vendor extension description and the functional mode */
+    len = PTP_di_VendorExtensionDesc + 1 + ( (uint32_t)PTP_Handle.data_ptr[ PTP_di_VendorExtensionDesc ] << 1 ) + 2;
+    PTP_DeviceInfo.OperationsSupported_len = 0;
+    if( ( len + 4 ) <= ( PTP_Handle.data_length - 12 ) )
+    {
+        temp = LE32( PTP_Handle.data_ptr + len );
+        len += 4;
+        while( temp-- && ( PTP_DeviceInfo.OperationsSupported_len < PTP_SUPPORTED_OPERATIONS_NBR ) &&
+               ( ( len + 2 ) <= ( PTP_Handle.data_length - 12 ) ) )
+        {
+            PTP_DeviceInfo.OperationsSupported[ PTP_DeviceInfo.OperationsSupported_len++ ] = LE16( PTP_Handle.data_ptr + len );
+            len += 2;
+        }
+    }
+
     /* Status Phase */
     return USBH_PTP_GetResponse( );
 }
@@ -1257,6 +1277,791 @@ uint8_t USBH_PTP_GetPartialObject( void )
     return USBH_PTP_GetResponse( );
 }
 
+/*********************************************************************
+ * @fn      USBH_PTP_OperationSupported
+ *
+ * @brief   Check the operations the device listed in its DeviceInfo.
+ *
+ * @para    code: Operation code.
+ *
+ * @return  1 - supported, 0 - not supported or DeviceInfo not read
+ */
+uint8_t USBH_PTP_OperationSupported( uint16_t code )
+{
+    uint32_t i;
+
+    for( i = 0; i != PTP_DeviceInfo.OperationsSupported_len; i++ )
+    {
+        if( PTP_DeviceInfo.OperationsSupported[ i ] == code )
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      USBH_PTP_RecvDataStream
+ *
+ * @brief   Receive the data phase of the current transaction and hand the
+ *          payload of each packet to a sink as it arrives, straight from the
+ *          USB receive buffer, without gathering it anywhere first.
+ *
+ * @para    sink: Called for every packet with payload, NULL - drop the data.
+ *          ctx: Passed to sink.
+ *          plen: Payload bytes received.
+ *
+ * @return  PTP_OK - go on with USBH_PTP_GetResponse, PTP_FAIL - the device
+ *          answered with a response instead (in PTP_RespContainer), else USB
+ *          error.
+ */
+uint8_t USBH_PTP_RecvDataStream( PTP_DataSinkTypeDef sink, void *ctx, uint32_t *plen )
+{
+    uint8_t  s, first, stop;
+    uint8_t  index;
+    uint8_t  *pbuf;
+    uint32_t len, pkt_len, left;
+
+    index = RootHubDev.DeviceIndex;
+    *plen = 0;
+    left = 0;
+    first = 1;
+    stop = 0;
+    while( 1 )
+    {
+        s = USBFSH_Transact( ( USB_PID_IN << 4 ) | HostCtl[ index ].Interface[ 0 ].InEndpAddr[ 0 ],
+                             HostCtl[ index ].Interface[ 0 ].InEndpTog[ 0 ], 20000 );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        HostCtl[ index ].Interface[ 0 ].InEndpTog[ 0 ] ^= USBFS_UH_R_TOG;
+
+        pbuf = USBFS_RX_Buf;
+        pkt_len = USBFSH->RX_LEN;
+        len = pkt_len;
+        if( first ) // First packet, behind the container header
+        {
+            first = 0;
+            if( len < PTP_USB_BULK_HDR_LEN )
+            {
+                return PTP_FAIL;
+            }
+            if( LE16( pbuf + 4 ) == PTP_USB_CONTAINER_RESPONSE )
+            {
+                memcpy( &PTP_RespContainer, pbuf, ( len < sizeof( PTP_RespContainer ) ) ? len : sizeof( PTP_RespContainer ) );
+                return PTP_FAIL;
+            }
+            left = LE32( pbuf ); // 0xFFFFFFFF - 4GB or more, ends with a short packet
+            if( left != 0xFFFFFFFF )
+            {
+                left = ( left > PTP_USB_BULK_HDR_LEN ) ? ( left - PTP_USB_BULK_HDR_LEN ) : 0;
+            }
+            pbuf += PTP_USB_BULK_HDR_LEN;
+            len -= PTP_USB_BULK_HDR_LEN;
+        }
+
+        if( len && ( stop == 0 ) && sink )
+        {
+            stop = sink( pbuf, len, ctx );
+        }
+        *plen += len;
+
+        if( left != 0xFFFFFFFF )
+        {
+            left = ( left > len ) ? ( left - len ) : 0;
+            if( left == 0 )
+            {
+                break;
+            }
+        }
+        if( pkt_len < PTP_Handle.data_packet )
+        {
+            break;
+        }
+    }
+
+    return PTP_OK;
+}
+
+/*********************************************************************
+ * @fn      USBH_PTP_GetObjectStream
+ *
+ * @brief   Read an object, or part of it, packet by packet into a sink,
+ *          e.g. one that programs SPI flash, so any size is read in one
+ *          transaction without a buffer for it.
+ *
+ * @para    objecthandle: Object.
+ *          offset: First byte.
+ *          maxlen: Bytes to read, 0xFFFFFFFF with offset 0 - the whole
+ *                  object by GetObject, else by GetPartialObject.
+ *          sink: Called with each packet of object data.
+ *          ctx: Passed to sink.
+ *          plen: Bytes read.
+ *
+ * @return  PTP_OK - done, else error.
+ */
+uint8_t USBH_PTP_GetObjectStream( uint32_t objecthandle, uint32_t offset, uint32_t maxlen,
+                                  PTP_DataSinkTypeDef sink, void *ctx, uint32_t *plen )
+{
+    uint8_t  s;
+
+    *plen = 0;
+    PTP_Container.Param1 = objecthandle;
+    if( ( offset == 0 ) && ( maxlen == 0xFFFFFFFF ) )
+    {
+        PTP_Container.Code = PTP_OC_GetObject;
+        PTP_Container.Nparam = 1;
+    }
+    else
+    {
+        PTP_Container.Code = PTP_OC_GetPartialObject;
+        PTP_Container.Param2 = offset;
+        PTP_Container.Param3 = maxlen;
+        PTP_Container.Nparam = 3;
+    }
+    s = USBH_PTP_SendRequest( );
+    if( s != PTP_OK )
+    {
+        return s;
+    }
+
+    PTP_Container.Transaction_ID++;
+    s = USBH_PTP_RecvDataStream( sink, ctx, plen );
+    if( s != PTP_OK )
+    {
+        return s;
+    }
+    return USBH_PTP_GetResponse( );
+}
+
+/*********************************************************************
+ * @fn      MTP_Utf8_Put
+ *
+ * @brief   Append a UCS-2 character to a UTF-8 string, as far as it fits.
+ *
+ * @para    str: String, kept terminated.
+ *          plen: Bytes in str.
+ *          max: Size of str.
+ *          ch: Character, 0 is ignored.
+ *
+ * @return  none
+ */
+void MTP_Utf8_Put( char *str, uint8_t *plen, uint32_t max, uint16_t ch )
+{
+    uint32_t n;
+
+    if( ch == 0 )
+    {
+        return;
+    }
+    if( ( ch >= 0xD800 ) && ( ch <= 0xDFFF ) ) // Half of a character beyond the BMP
+    {
+        ch = '?';
+    }
+    n = ( ch < 0x80 ) ? 1 : ( ( ch < 0x800 ) ? 2 : 3 );
+    if( ( *plen + n ) >= max )
+    {
+        return;
+    }
+    if( n == 1 )
+    {
+        str[ (*plen)++ ] = (char)ch;
+    }
+    else if( n == 2 )
+    {
+        str[ (*plen)++ ] = (char)( 0xC0 | ( ch >> 6 ) );
+        str[ (*plen)++ ] = (char)( 0x80 | ( ch & 0x3F ) );
+    }
+    else
+    {
+        str[ (*plen)++ ] = (char)( 0xE0 | ( ch >> 12 ) );
+        str[ (*plen)++ ] = (char)( 0x80 | ( ( ch >> 6 ) & 0x3F ) );
+        str[ (*plen)++ ] = (char)( 0x80 | ( ch & 0x3F ) );
+    }
+    str[ *plen ] = 0;
+}
+
+/*********************************************************************
+ * @fn      MTP_PropList_Emit
+ *
+ * @brief   Pass the object gathered so far to the listing sink.
+ *
+ * @para    pp: Parser.
+ *
+ * @return  none
+ */
+void MTP_PropList_Emit( MTP_PropListTypeDef *pp )
+{
+    if( pp->Obj_Valid )
+    {
+        pp->Obj_Valid = 0;
+        if( ( pp->Storage == 0xFFFFFFFF ) || ( pp->Obj.StorageID == 0 ) || ( pp->Obj.StorageID == pp->Storage ) )
+        {
+            pp->Count++;
+            pp->Sink( &pp->Obj, pp->Ctx );
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      MTP_PropList_Next
+ *
+ * @brief   Finish a property quadruple.
+ *
+ * @para    pp: Parser.
+ *
+ * @return  none
+ */
+void MTP_PropList_Next( MTP_PropListTypeDef *pp )
+{
+    if( --pp->Elem_Left == 0 )
+    {
+        MTP_PropList_Emit( pp );
+        pp->State = MTP_PL_DONE;
+    }
+    else
+    {
+        pp->State = MTP_PL_HEAD;
+        pp->Acc_Need = 8;
+    }
+}
+
+/*********************************************************************
+ * @fn      MTP_PropList_Field
+ *
+ * @brief   Act on a fixed-size field gathered in Acc.
+ *
+ * @para    pp: Parser.
+ *
+ * @return  none
+ */
+void MTP_PropList_Field( MTP_PropListTypeDef *pp )
+{
+    uint32_t handle, type;
+
+    if( pp->State == MTP_PL_COUNT )
+    {
+        pp->Elem_Left = LE32( pp->Acc );
+        pp->State = pp->Elem_Left ? MTP_PL_HEAD : MTP_PL_DONE;
+        pp->Acc_Need = 8;
+    }
+    else if( pp->State == MTP_PL_HEAD )
+    {
+        /* Devices send the properties of an object together, so a new handle
+         * means the last object is complete */
+        handle = LE32( pp->Acc );
+        if( pp->Obj_Valid && ( handle != pp->Obj.Handle ) )
+        {
+            MTP_PropList_Emit( pp );
+        }
+        if( pp->Obj_Valid == 0 )
+        {
+            memset( &pp->Obj, 0, sizeof( pp->Obj ) );
+            pp->Obj.Handle = handle;
+            pp->Obj_Valid = 1;
+        }
+        pp->Code = LE16( pp->Acc + 4 );
+        pp->Type = LE16( pp->Acc + 6 );
+        type = pp->Type & ~PTP_DTC_ARRAY_MASK;
+        if( pp->Type == PTP_DTC_STR )
+        {
+            pp->State = MTP_PL_STR_LEN;
+        }
+        else if( ( type < PTP_DTC_INT8 ) || ( type > PTP_DTC_UINT128 ) )
+        {
+            pp->State = MTP_PL_ERROR; // Size of the value unknown, cannot go on
+        }
+        else if( pp->Type & PTP_DTC_ARRAY_MASK )
+        {
+            pp->State = MTP_PL_ARR_LEN;
+            pp->Acc_Need = 4;
+        }
+        else
+        {
+            pp->State = MTP_PL_VALUE;
+            pp->Val_Left = 1 << ( ( type - 1 ) >> 1 );
+            pp->Val_Ofs = 0;
+        }
+    }
+    else // MTP_PL_ARR_LEN
+    {
+        pp->Val_Left = LE32( pp->Acc ) << ( ( ( pp->Type & ~PTP_DTC_ARRAY_MASK ) - 1 ) >> 1 );
+        pp->Val_Ofs = 0;
+        pp->State = MTP_PL_VALUE;
+        if( pp->Val_Left == 0 )
+        {
+            MTP_PropList_Next( pp );
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      MTP_PropList_Value
+ *
+ * @brief   Store a value of the object gathered in Acc, if it is one of
+ *          those listed.
+ *
+ * @para    pp: Parser.
+ *
+ * @return  none
+ */
+void MTP_PropList_Value( MTP_PropListTypeDef *pp )
+{
+    uint64_t val;
+    uint8_t  i;
+
+    if( pp->Type & PTP_DTC_ARRAY_MASK )
+    {
+        return;
+    }
+    val = 0;
+    for( i = ( pp->Val_Ofs < 8 ) ? pp->Val_Ofs : 8; i; i-- )
+    {
+        val = ( val << 8 ) | pp->Acc[ i - 1 ];
+    }
+    switch( pp->Code )
+    {
+        case PTP_OPC_StorageID:
+            pp->Obj.StorageID = (uint32_t)val;
+            break;
+        case PTP_OPC_ObjectFormat:
+            pp->Obj.Format = (uint16_t)val;
+            break;
+        case PTP_OPC_ObjectSize:
+            pp->Obj.Size = val;
+            break;
+        case PTP_OPC_ParentObject:
+            pp->Obj.Parent = (uint32_t)val;
+            break;
+        default:
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      MTP_PropList_Sink
+ *
+ * @brief   Data phase sink parsing GetObjPropList data a packet at a time,
+ *          so a listing of any length needs no more than the parser. Each
+ *          object is passed on once all its properties are in.
+ *
+ * @para    pbuf: Packet payload.
+ *          len: Bytes.
+ *          ctx: Parser, MTP_PropListTypeDef.
+ *
+ * @return  0 - go on, 1 - done or not parsable, drop the rest
+ */
+uint8_t MTP_PropList_Sink( uint8_t *pbuf, uint32_t len, void *ctx )
+{
+    MTP_PropListTypeDef *pp = (MTP_PropListTypeDef *)ctx;
+    uint8_t  c;
+
+    while( len-- )
+    {
+        c = *pbuf++;
+        switch( pp->State )
+        {
+            case MTP_PL_COUNT:
+            case MTP_PL_HEAD:
+            case MTP_PL_ARR_LEN:
+                pp->Acc[ pp->Acc_Cnt++ ] = c;
+                if( pp->Acc_Cnt == pp->Acc_Need )
+                {
+                    pp->Acc_Cnt = 0;
+                    MTP_PropList_Field( pp );
+                }
+                break;
+
+            case MTP_PL_VALUE:
+                if( pp->Val_Ofs < 8 )
+                {
+                    pp->Acc[ pp->Val_Ofs ] = c;
+                }
+                pp->Val_Ofs++;
+                if( --pp->Val_Left == 0 )
+                {
+                    MTP_PropList_Value( pp );
+                    MTP_PropList_Next( pp );
+                }
+                break;
+
+            case MTP_PL_STR_LEN:
+                pp->Val_Left = (uint32_t)c << 1;
+                pp->Val_Ofs = 0;
+                pp->Str_Len = 0;
+                pp->State = MTP_PL_STR;
+                if( pp->Val_Left == 0 )
+                {
+                    MTP_PropList_Next( pp );
+                }
+                break;
+
+            case MTP_PL_STR:
+                if( pp->Val_Ofs & 1 )
+                {
+                    if( pp->Code == PTP_OPC_ObjectFileName )
+                    {
+                        MTP_Utf8_Put( pp->Obj.Name, &pp->Str_Len, DEF_MTP_NAME_LEN, pp->Acc[ 0 ] | ( (uint16_t)c << 8 ) );
+                    }
+                    else if( ( pp->Code == PTP_OPC_DateModified ) && ( c == 0 ) && ( pp->Acc[ 0 ] < 0x80 ) )
+                    {
+                        MTP_Utf8_Put( pp->Obj.Modified, &pp->Str_Len, sizeof( pp->Obj.Modified ), pp->Acc[ 0 ] );
+                    }
+                }
+                else
+                {
+                    pp->Acc[ 0 ] = c;
+                }
+                pp->Val_Ofs++;
+                if( --pp->Val_Left == 0 )
+                {
+                    MTP_PropList_Next( pp );
+                }
+                break;
+
+            default:
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      USBH_MTP_ListByPropList
+ *
+ * @brief   List the objects in a folder with one GetObjPropList, all
+ *          properties of all objects at depth 1 in a single transaction.
+ *
+ * @para    storage_id: Storage, 0xFFFFFFFF - any.
+ *          parent: Folder, MTP_ROOT_HANDLE - root.
+ *          sink: Called for each object.
+ *          ctx: Passed to sink.
+ *          pnum: Objects passed to sink.
+ *
+ * @return  PTP_OK - done, PTP_FAIL - refused by the device, else error.
+ */
+uint8_t USBH_MTP_ListByPropList( uint32_t storage_id, uint32_t parent, MTP_ObjectSinkTypeDef sink, void *ctx, uint32_t *pnum )
+{
+    MTP_PropListTypeDef parse;
+    uint8_t  s;
+    uint32_t len;
+
+    memset( &parse, 0, sizeof( parse ) );
+    parse.State = MTP_PL_COUNT;
+    parse.Acc_Need = 4;
+    parse.Storage = storage_id;
+    parse.Sink = sink;
+    parse.Ctx = ctx;
+    *pnum = 0;
+
+    PTP_Container.Code = PTP_OC_GetObjPropList;
+    PTP_Container.Param1 = ( parent == MTP_ROOT_HANDLE ) ? 0x00000000 : parent;
+    PTP_Container.Param2 = 0x00000000;                                          // Any format
+    PTP_Container.Param3 = 0xFFFFFFFF;                                          // All properties
+    PTP_Container.Param4 = 0x00000000;
+    PTP_Container.Param5 = 0x00000001;                                          // Depth, the children
+    PTP_Container.Nparam = 5;
+    s = USBH_PTP_SendRequest( );
+    if( s != PTP_OK )
+    {
+        return s;
+    }
+
+    PTP_Container.Transaction_ID++;
+    s = USBH_PTP_RecvDataStream( MTP_PropList_Sink, &parse, &len );
+    *pnum = parse.Count;
+    if( s != PTP_OK )
+    {
+        return s;
+    }
+    s = USBH_PTP_GetResponse( );
+    if( ( s == PTP_OK ) && ( parse.State != MTP_PL_DONE ) )
+    {
+        DUG_PRINTF( "PropList parse state %d\r\n", parse.State );
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      MTP_Buf_Sink
+ *
+ * @brief   Data phase sink gathering a small dataset into a buffer, the
+ *          part that does not fit is dropped.
+ *
+ * @para    pbuf: Packet payload.
+ *          len: Bytes.
+ *          ctx: Buffer, MTP_BufTypeDef.
+ *
+ * @return  0
+ */
+uint8_t MTP_Buf_Sink( uint8_t *pbuf, uint32_t len, void *ctx )
+{
+    MTP_BufTypeDef *pb = (MTP_BufTypeDef *)ctx;
+
+    if( len > ( pb->Size - pb->Len ) )
+    {
+        len = pb->Size - pb->Len;
+    }
+    memcpy( pb->pbuf + pb->Len, pbuf, len );
+    pb->Len += len;
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      MTP_Handle_Sink
+ *
+ * @brief   Data phase sink keeping the handles of an object handle array
+ *          from First on, behind the ObjectInfo part of Com_Buf.
+ *
+ * @para    pbuf: Packet payload.
+ *          len: Bytes.
+ *          ctx: Window, MTP_HandleWinTypeDef.
+ *
+ * @return  0
+ */
+uint8_t MTP_Handle_Sink( uint8_t *pbuf, uint32_t len, void *ctx )
+{
+    MTP_HandleWinTypeDef *pw = (MTP_HandleWinTypeDef *)ctx;
+    uint32_t *phandle = (uint32_t *)(void *)( Com_Buf + DEF_MTP_INFO_BUF_LEN );
+
+    while( len-- )
+    {
+        pw->Acc = ( pw->Acc >> 8 ) | ( (uint32_t)*pbuf++ << 24 );
+        if( ++pw->Acc_Cnt == 4 )
+        {
+            pw->Acc_Cnt = 0;
+            if( pw->Idx == 0xFFFFFFFF )
+            {
+                pw->Total = pw->Acc;
+            }
+            else if( ( pw->Idx >= pw->First ) && ( pw->Num < DEF_MTP_HANDLE_WIN ) )
+            {
+                phandle[ pw->Num++ ] = pw->Acc;
+            }
+            pw->Idx++;
+        }
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      USBH_MTP_ListByObjectInfo
+ *
+ * @brief   List the objects in a folder on devices without GetObjPropList:
+ *          the handles come with one GetObjectHandles into Com_Buf, then
+ *          GetObjectInfo is read for each. Folders with more handles than
+ *          Com_Buf holds take one GetObjectHandles per batch.
+ *
+ * @para    storage_id: Storage.
+ *          parent: Folder, MTP_ROOT_HANDLE - root.
+ *          sink: Called for each object.
+ *          ctx: Passed to sink.
+ *          pnum: Objects passed to sink.
+ *
+ * @return  PTP_OK - done, else error.
+ */
+uint8_t USBH_MTP_ListByObjectInfo( uint32_t storage_id, uint32_t parent, MTP_ObjectSinkTypeDef sink, void *ctx, uint32_t *pnum )
+{
+    MTP_ObjectTypeDef obj;
+    MTP_HandleWinTypeDef win;
+    MTP_BufTypeDef info;
+    uint32_t *phandle = (uint32_t *)(void *)( Com_Buf + DEF_MTP_INFO_BUF_LEN );
+    uint32_t i, len, ofs;
+    uint8_t  *pinfo;
+    uint8_t  s, n, str_len;
+
+    *pnum = 0;
+    win.First = 0;
+    do
+    {
+        /* Handles from win.First on, as many as fit */
+        PTP_Container.Code = PTP_OC_GetObjectHandles;
+        PTP_Container.Param1 = storage_id;
+        PTP_Container.Param2 = 0x00000000;
+        PTP_Container.Param3 = parent;
+        PTP_Container.Nparam = 3;
+        s = USBH_PTP_SendRequest( );
+        if( s != PTP_OK )
+        {
+            return s;
+        }
+        PTP_Container.Transaction_ID++;
+        win.Num = 0;
+        win.Total = 0;
+        win.Idx = 0xFFFFFFFF;
+        win.Acc_Cnt = 0;
+        s = USBH_PTP_RecvDataStream( MTP_Handle_Sink, &win, &len );
+        if( s != PTP_OK )
+        {
+            return s;
+        }
+        s = USBH_PTP_GetResponse( );
+        if( s != PTP_OK )
+        {
+            return s;
+        }
+
+        for( i = 0; i != win.Num; i++ )
+        {
+            PTP_Container.Code = PTP_OC_GetObjectInfo;
+            PTP_Container.Param1 = phandle[ i ];
+            PTP_Container.Nparam = 1;
+            s = USBH_PTP_SendRequest( );
+            if( s != PTP_OK )
+            {
+                return s;
+            }
+            PTP_Container.Transaction_ID++;
+            info.pbuf = Com_Buf;
+            info.Size = DEF_MTP_INFO_BUF_LEN;
+            info.Len = 0;
+            s = USBH_PTP_RecvDataStream( MTP_Buf_Sink, &info, &len );
+            if( s != PTP_OK )
+            {
+                return s;
+            }
+            s = USBH_PTP_GetResponse( );
+            if( s != PTP_OK )
+            {
+                return s;
+            }
+            if( info.Len <= PTP_oi_Filename )
+            {
+                continue;
+            }
+
+            pinfo = Com_Buf;
+            memset( &obj, 0, sizeof( obj ) );
+            obj.Handle = phandle[ i ];
+            obj.StorageID = LE32( pinfo + PTP_oi_StorageID );
+            obj.Format = LE16( pinfo + PTP_oi_ObjectFormat );
+            obj.Size = LE32( pinfo + PTP_oi_ObjectCompressedSize );
+            obj.Parent = LE32( pinfo + PTP_oi_ParentObject );
+
+            /* For Samsung Galaxy, as USBH_MTP_GetObjectInfo */
+            if( ( pinfo[ PTP_oi_filenamelen ] == 0 ) && ( info.Len > ( PTP_oi_filenamelen + 4 ) ) &&
+                ( pinfo[ PTP_oi_filenamelen + 4 ] != 0 ) )
+            {
+                pinfo += 4;
+                info.Len -= 4;
+            }
+
+            /* Filename, CaptureDate, ModificationDate */
+            ofs = PTP_oi_filenamelen;
+            for( n = 0; n != 3; n++ )
+            {
+                if( ofs >= info.Len )
+                {
+                    break;
+                }
+                len = (uint32_t)pinfo[ ofs++ ] << 1;
+                if( ( ofs + len ) > info.Len )
+                {
+                    len = ( info.Len - ofs ) & ~1;
+                }
+                if( n != 1 )
+                {
+                    str_len = 0;
+                    for( ; len; len -= 2, ofs += 2 )
+                    {
+                        if( n == 0 )
+                        {
+                            MTP_Utf8_Put( obj.Name, &str_len, DEF_MTP_NAME_LEN, LE16( pinfo + ofs ) );
+                        }
+                        else if( LE16( pinfo + ofs ) < 0x80 )
+                        {
+                            MTP_Utf8_Put( obj.Modified, &str_len, sizeof( obj.Modified ), LE16( pinfo + ofs ) );
+                        }
+                    }
+                }
+                ofs += len;
+            }
+
+            (*pnum)++;
+            sink( &obj, ctx );
+        }
+        win.First += win.Num;
+    } while( win.Num && ( win.First < win.Total ) );
+
+    return PTP_OK;
+}
+
+/*********************************************************************
+ * @fn      USBH_MTP_ListObjects
+ *
+ * @brief   List the objects in a folder, by GetObjPropList where the device
+ *          has it, else by GetObjectHandles and GetObjectInfo.
+ *
+ * @para    storage_id: Storage.
+ *          parent: Folder, MTP_ROOT_HANDLE - root.
+ *          sink: Called for each object.
+ *          ctx: Passed to sink.
+ *          pnum: Objects passed to sink.
+ *
+ * @return  PTP_OK - done, else error.
+ */
+uint8_t USBH_MTP_ListObjects( uint32_t storage_id, uint32_t parent, MTP_ObjectSinkTypeDef sink, void *ctx, uint32_t *pnum )
+{
+    uint8_t  s;
+
+    if( USBH_PTP_OperationSupported( PTP_OC_GetObjPropList ) )
+    {
+        s = USBH_MTP_ListByPropList( storage_id, parent, sink, ctx, pnum );
+        if( ( s != PTP_FAIL ) || *pnum )
+        {
+            return s;
+        }
+        DUG_PRINTF( "GetObjPropList refused(%04x)\r\n", PTP_RespContainer.code ); // E.g. depth not supported
+    }
+    return USBH_MTP_ListByObjectInfo( storage_id, parent, sink, ctx, pnum );
+}
+
+/*********************************************************************
+ * @fn      MTP_Demo_ObjectSink
+ *
+ * @brief   Print an object found by listing and remember the first file.
+ *
+ * @para    pobj: Object.
+ *          ctx: Handle of the first file, 0 - none yet.
+ *
+ * @return  none
+ */
+void MTP_Demo_ObjectSink( MTP_ObjectTypeDef *pobj, void *ctx )
+{
+    uint32_t *pfile = (uint32_t *)ctx;
+
+    DUG_PRINTF( "%08x %04x %10u %s %s%s\r\n", pobj->Handle, pobj->Format, (uint32_t)pobj->Size, pobj->Modified,
+                pobj->Name, ( pobj->Format == PTP_OFC_Association ) ? "/" : "" );
+    if( ( *pfile == 0 ) && ( pobj->Format != PTP_OFC_Association ) )
+    {
+        *pfile = pobj->Handle;
+    }
+}
+
+/*********************************************************************
+ * @fn      MTP_Demo_DataSink
+ *
+ * @brief   Take object data as it arrives, here only summed. This is
+ *          where it would be programmed to SPI flash or written to a file.
+ *
+ * @para    pbuf: Data.
+ *          len: Bytes.
+ *          ctx: Sum.
+ *
+ * @return  0 - go on
+ */
+uint8_t MTP_Demo_DataSink( uint8_t *pbuf, uint32_t len, void *ctx )
+{
+    uint32_t *psum = (uint32_t *)ctx;
+
+    while( len-- )
+    {
+        *psum += *pbuf++;
+    }
+    return 0;
+}
+
 /*********************************************************************
  * @fn      MTP_Init_Process
  *
@@ -1268,7 +2073,8 @@ uint8_t USBH_PTP_GetPartialObject( void )
  */
 void MTP_Init_Process( void )
 {
-    uint32_t i, total_num, s;
+    uint32_t total_num, file, len, sum;
+    uint8_t  s;
 
     MTP_PTP_ParaInit( );
     USBH_PTP_OpenSession( 0x01 );
@@ -1282,59 +2088,19 @@ void MTP_Init_Process( void )
         DUG_PRINTF( "FreeSpaceInBytes = %08x, %08x\r\n", (uint32_t)PTP_StorageInfo.FreeSpaceInBytes,
                                                        (uint32_t)( PTP_StorageInfo.FreeSpaceInBytes >> 32 ) );
 
-        /* Enumerate all files under the root directory */
-        USBH_PTP_GetNumObjects( PTP_StorageIDs.Storage[ 0 ], 0x00000000, 0xFFFFFFFF, &total_num ); // Get the number of files under the root directory
-        DUG_PRINTF( " total_num = %02x\r\n", total_num );
-        for( i = 0; i != total_num; i++ )
-        {
-            MTP_Para.mtp_handle.Handle_cur_num = 0;
-            MTP_Para.mtp_handle.Handle_locate_num = i;
-            MTP_Para.mtp_handle.flag = 0;
-            USBH_MTP_GetObjectHandles( PTP_StorageIDs.Storage[ 0 ], 0x00000000, 0xFFFFFFFF );
-            DUG_PRINTF( "handle = %08x\r\n", MTP_Para.mtp_handle.Handle_num );
-            USBH_MTP_GetObjectInfo( MTP_Para.mtp_handle.Handle_num );
-            DUG_PRINTF( "obj_info.ObjectFormat = %02x\r\n", PTP_ObjectInfo.ObjectFormat );
-            DUG_PRINTF( "obj_info.FileName:" );
-            for( s = 0; s != PTP_ObjectInfo.FileName_len; s++ )
-            {
-                DUG_PRINTF( "%02x ", PTP_ObjectInfo.Filename[ s ] );
-            }
-            DUG_PRINTF( "\r\n" );
-            DUG_PRINTF( "obj_info.Data_Creat:" );
-            for( s = 0; s != PTP_ObjectInfo.FileName_len; s++ )
-            {
-                DUG_PRINTF( "%02x ", PTP_ObjectInfo.Data_Creat_Time[ s ] );
-            }
-            DUG_PRINTF( "\r\n" );
-            DUG_PRINTF( "obj_info.Data_Modified:" );
-            for( s = 0; s != PTP_ObjectInfo.FileName_len; s++ )
-            {
-                DUG_PRINTF( "%02x ", PTP_ObjectInfo.Data_Modified_Time[ s ] );
-            }
-            DUG_PRINTF( "\r\n" );
+        /* List the root directory, one transaction for all of it where the device has GetObjPropList */
+        file = 0;
+        s = USBH_MTP_ListObjects( PTP_StorageIDs.Storage[ 0 ], MTP_ROOT_HANDLE, MTP_Demo_ObjectSink, &file, &total_num );
+        DUG_PRINTF( "s = %02x, total_num = %d\r\n", s, total_num );
 
-            USBH_MTP_GetObjectSize( MTP_Para.mtp_handle.Handle_num );
-            DUG_PRINTF( "obj_info.File_Size = %08lx\r\n", (uint32_t)PTP_ObjectInfo.File_Size );
-        }
-
-        /* The following demonstrates how to read data */
-        MTP_Para.get_data.Handle_locate = 0;
-        MTP_Para.get_data.Handle_maxlen = 0;
-        while( 1 )
+        /* Read the first file in one transaction, each packet going straight to the sink */
+        if( file )
         {
-            MTP_Para.get_data.Handle_num = 0x16; // Handle number
-            MTP_Para.get_data.Handle_locate += MTP_Para.get_data.Handle_maxlen; // Locate
-            MTP_Para.get_data.Handle_maxlen = 8192; // File size to read
-            MTP_Para.get_data.data_str.pdata = Com_Buf; // Read data, the data starts from the Com_Buf[12] position, and the front is the packet header
-            s = USBH_PTP_GetPartialObject( );
-            DUG_PRINTF( "s = %02x\r\n", s );
-            DUG_PRINTF( "MTP_Para.get_data.Handle_maxlen=%d\r\n", MTP_Para.get_data.Handle_maxlen );
-            if( MTP_Para.get_data.Handle_maxlen < 8192 )
-            {
-                break;
-            }
-       }
-       DUG_PRINTF( "end\r\n" );
+            sum = 0;
+            s = USBH_PTP_GetObjectStream( file, 0, 0xFFFFFFFF, MTP_Demo_DataSink, &sum, &len );
+            DUG_PRINTF( "s = %02x, read %d bytes, sum %08x\r\n", s, len, sum );
+        }
+        DUG_PRINTF( "end\r\n" );
     }
 }
 
@@ -30,6 +30,23 @@
 /* Common Buffer Size */
 #define DEF_COM_BUF_LEN                                   ( 8192 + 12 )
 
+/* Object Listing */
+#define DEF_MTP_NAME_LEN                                  64                    // UTF-8 bytes of an object name with its terminator
+#define DEF_MTP_INFO_BUF_LEN                              512                   // Com_Buf bytes for one ObjectInfo when listing without GetObjPropList,
+                                                                                // the rest of Com_Buf holds object handles
+#define DEF_MTP_HANDLE_WIN                                ( ( DEF_COM_BUF_LEN - DEF_MTP_INFO_BUF_LEN ) / 4 )
+#define MTP_ROOT_HANDLE                                   0xFFFFFFFF            // Parent of the objects in the root of a storage
+
+/* GetObjPropList Parser State */
+#define MTP_PL_COUNT                                      0
+#define MTP_PL_HEAD                                       1                     // Handle, property code, data type
+#define MTP_PL_ARR_LEN                                    2
+#define MTP_PL_STR_LEN                                    3
+#define MTP_PL_VALUE                                      4
+#define MTP_PL_STR                                        5
+#define MTP_PL_DONE                                       6
+#define MTP_PL_ERROR                                      7
+
 /* PTP V1.0 Operation Code */
 #define PTP_OC_Undefined                                  0x1000
 #define PTP_OC_GetDeviceInfo                              0x1001
@@ -868,6 +885,65 @@ typedef union _MTP_ParaTypeDef
     } get_data;
 } MTP_ParaTypeDef, *PMTP_ParaTypeDef;
 
+/* Data Phase Sink, called with the payload of each packet as it arrives, straight
+ * from the USB receive buffer. Returns 0 to go on, else the rest of the data
+ * phase is received and dropped */
+typedef uint8_t (*PTP_DataSinkTypeDef)( uint8_t *pbuf, uint32_t len, void *ctx );
+
+/* Object Found by Listing */
+typedef struct _MTP_ObjectTypeDef
+{
+    uint32_t Handle;
+    uint32_t Parent;
+    uint32_t StorageID;
+    uint16_t Format;                                                            // PTP_OFC_Association - folder
+    uint64_t Size;
+    char     Name[ DEF_MTP_NAME_LEN ];                                          // UTF-8, cut short if too long
+    char     Modified[ 16 ];                                                    // "YYYYMMDDThhmmss", empty if not given
+} MTP_ObjectTypeDef, *PMTP_ObjectTypeDef;
+
+typedef void (*MTP_ObjectSinkTypeDef)( MTP_ObjectTypeDef *pobj, void *ctx );
+
+/* GetObjPropList Data Parser, fed a packet at a time */
+typedef struct _MTP_PropListTypeDef
+{
+    uint8_t  State;
+    uint8_t  Acc_Cnt;                                                           // Bytes gathered in Acc
+    uint8_t  Acc_Need;
+    uint8_t  Str_Len;                                                           // Bytes of the string being stored
+    uint8_t  Acc[ 8 ];
+    uint16_t Code;
+    uint16_t Type;
+    uint32_t Elem_Left;                                                         // Property quadruples left
+    uint32_t Val_Left;                                                          // Value bytes left
+    uint32_t Val_Ofs;
+    uint32_t Storage;                                                           // Objects of other storages are skipped
+    uint32_t Count;                                                             // Objects passed to Sink
+    uint8_t  Obj_Valid;
+    MTP_ObjectTypeDef Obj;
+    MTP_ObjectSinkTypeDef Sink;
+    void     *Ctx;
+} MTP_PropListTypeDef, *PMTP_PropListTypeDef;
+
+/* Part of an Object Handle Array Kept while Listing */
+typedef struct _MTP_HandleWinTypeDef
+{
+    uint32_t First;                                                             // Index of the first handle kept
+    uint32_t Num;                                                               // Handles kept
+    uint32_t Total;                                                             // Handles in the array
+    uint32_t Idx;                                                               // Handle being received, 0xFFFFFFFF - the count
+    uint32_t Acc;
+    uint8_t  Acc_Cnt;
+} MTP_HandleWinTypeDef, *PMTP_HandleWinTypeDef;
+
+/* Buffer Filled by a Data Phase */
+typedef struct _MTP_BufTypeDef
+{
+    uint8_t  *pbuf;
+    uint32_t Size;
+    uint32_t Len;
+} MTP_BufTypeDef, *PMTP_BufTypeDef;
+
 /*******************************************************************************/
 /* Variable Declaration */
 extern uint8_t  DevDesc_Buf[ ];
@@ -897,6 +973,23 @@ extern void PTP_GetDevicePropValue( uint8_t *data, uint32_t *offset, uint16_t da
 extern uint32_t PTP_GetObjectPropList( uint8_t *data, uint32_t len, uint16_t propval );
 extern uint8_t USBH_MTP_GetObjectSize( uint32_t objecthandle );
 extern uint8_t USBH_PTP_GetPartialObject( void );
+extern uint8_t USBH_PTP_OperationSupported( uint16_t code );
+extern uint8_t USBH_PTP_RecvDataStream( PTP_DataSinkTypeDef sink, void *ctx, uint32_t *plen );
+extern uint8_t USBH_PTP_GetObjectStream( uint32_t objecthandle, uint32_t offset, uint32_t maxlen,
+                                         PTP_DataSinkTypeDef sink, void *ctx, uint32_t *plen );
+extern void MTP_Utf8_Put( char *str, uint8_t *plen, uint32_t max, uint16_t ch );
+extern void MTP_PropList_Emit( MTP_PropListTypeDef *pp );
+extern void MTP_PropList_Next( MTP_PropListTypeDef *pp );
+extern void MTP_PropList_Field( MTP_PropListTypeDef *pp );
+extern void MTP_PropList_Value( MTP_PropListTypeDef *pp );
+extern uint8_t MTP_PropList_Sink( uint8_t *pbuf, uint32_t len, void *ctx );
+extern uint8_t USBH_MTP_ListByPropList( uint32_t storage_id, uint32_t parent, MTP_ObjectSinkTypeDef sink, void *ctx, uint32_t *pnum );
+extern uint8_t MTP_Buf_Sink( uint8_t *pbuf, uint32_t len, void *ctx );
+extern uint8_t MTP_Handle_Sink( uint8_t *pbuf, uint32_t len, void *ctx );
+extern uint8_t USBH_MTP_ListByObjectInfo( uint32_t storage_id, uint32_t parent, MTP_ObjectSinkTypeDef sink, void *ctx, uint32_t *pnum );
+extern uint8_t USBH_MTP_ListObjects( uint32_t storage_id, uint32_t parent, MTP_ObjectSinkTypeDef sink, void *ctx, uint32_t *pnum );
+extern void MTP_Demo_ObjectSink( MTP_ObjectTypeDef *pobj, void *ctx );
+extern uint8_t MTP_Demo_DataSink( uint8_t *pbuf, uint32_t len, void *ctx );
 extern void MTP_Init_Process( void );
 extern void USBH_MainDeal( void );
 
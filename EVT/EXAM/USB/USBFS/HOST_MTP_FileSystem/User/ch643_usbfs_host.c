@@ -286,6 +286,9 @@ uint8_t USBFSH_Transact( uint8_t endp_pid, uint8_t endp_tog, uint16_t timeout )
     uint8_t  r, trans_retry;
     uint16_t i;
 
+#if DEF_USBH_XFER_EN
+    return USBH_Xfer_Transact( endp_pid, endp_tog, timeout );
+#endif
     USBFSH->HOST_TX_CTRL = USBFSH->HOST_RX_CTRL = endp_tog;
     trans_retry = 0;
     do
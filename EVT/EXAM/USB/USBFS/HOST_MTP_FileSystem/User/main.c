@@ -14,6 +14,12 @@
  * @Note
  * This example demonstrates the enumeration process of a USB host to a device that
  * supports MTP and PTP protocols, and reads its files.
+ * The root directory is listed with one GetObjPropList where the device supports it
+ * (else GetObjectHandles once and GetObjectInfo per object), and the first file is read
+ * in one transaction, each packet going straight to a sink (MTP_Demo_DataSink) that
+ * can program SPI flash or write a file instead of filling a buffer.
+ * Transactions run from the USBFS interrupt (USBH_Lib/usb_host_xfer.c) with the
+ * CPU in WFI while they are on the bus. DEF_USBH_XFER_EN 0 restores polling.
 */
 
 
@@ -40,6 +46,9 @@ int main(void)
     DUG_PRINTF( "USBFS Host Init\r\n" );
     USBFS_RCC_Init( );
     USBFS_Host_Init( ENABLE , PWR_VDD_SupplyVoltage());
+#if DEF_USBH_XFER_EN
+    USBH_Xfer_Init( );
+#endif
     memset( &RootHubDev.bStatus, 0, sizeof( ROOT_HUB_DEVICE ) );
     memset( &HostCtl[ DEF_USBFS_PORT_INDEX * DEF_ONE_USB_SUP_DEV_TOTAL ].InterfaceNum, 0, DEF_ONE_USB_SUP_DEV_TOTAL * sizeof( HOST_CTL ) );
 #endif
@@ -23,6 +23,7 @@ extern "C" {
 #include "debug.h"
 #include <ch643_usb.h>
 #include <ch643_usbfs_host.h>
+#include "usb_host_xfer.h"
 #include "app_mtp_ptp.h"
 
 
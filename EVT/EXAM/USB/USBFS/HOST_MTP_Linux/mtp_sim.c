@@ -0,0 +1,1079 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : mtp_sim.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : The MTP/PTP layer of HOST_MTP_FileSystem built for the
+ *                      PC against a simulated MTP device.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * app_mtp_ptp.c of HOST_MTP_FileSystem is compiled in as it is. The USBFS
+ * host functions it calls are replaced: USBFSH_Transact hands OUT packets
+ * to a simulated device and takes IN packets from it, checking the data
+ * toggle of both. The device answers GetObjPropList, GetObjectHandles,
+ * GetObjectInfo, GetObject and GetPartialObject for a folder of generated
+ * objects, and every other operation with OperationNotSupported. A data
+ * phase filling its last packet is ended with a zero-length packet.
+ * Object names hold Latin-1 and CJK characters and characters beyond the
+ * BMP, some are longer than DEF_MTP_NAME_LEN, a few objects are folders,
+ * some are larger than 4 GB and some are on a second storage. The property
+ * list interleaves array, 128-bit and unused properties with those the
+ * listing keeps, in an order changing from object to object.
+ * Each object listed is checked field by field against what the device
+ * holds, each object read byte by byte, and after each transaction no
+ * packet may be left unread.
+ *
+ * mtp_sim -t runs the self-tests:
+ *   - Listing by GetObjPropList, 0 to 2000 objects, 16, 32 and 64 byte
+ *     packets.
+ *   - Listing by GetObjectHandles and GetObjectInfo, 0 to 4000 objects,
+ *     around and across the handle window (DEF_MTP_HANDLE_WIN).
+ *   - GetObjPropList refused by the device, listed the other way.
+ *   - Objects of 0 to 10000 bytes and parts of them streamed to a sink.
+ *   - Refused operations: PTP_FAIL with the response code in
+ *     PTP_RespContainer, and the next transaction still works.
+ * Without -t, a folder is listed both ways and the transactions and IN
+ * packets each way are counted.
+ *
+ * Build:
+ *   gcc -O2 -Wall -I../HOST_MTP_FileSystem/User -I../../../SRC/Core
+ *       -I../../../SRC/Debug -I../../../SRC/Peripheral/inc
+ *       -o mtp_sim mtp_sim.c
+ *
+ * Usage:
+ *   mtp_sim [-n objects] [-p packet size] | -t
+ *   -n  objects in the folder, 2000 by default
+ *   -p  bulk IN packet size, 64 by default
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* The example and the peripheral headers as they are, minus the RISC-V bits */
+#define interrupt( x )      unused
+#include "debug.h"
+
+static USBFSH_TypeDef Sim_Usbfsh;
+
+#undef USBFSH
+#define USBFSH              ( &Sim_Usbfsh )
+
+/* USBH_PTP_GetStorageInfo takes the address of data_ptr, not used here */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Warray-bounds"
+#pragma GCC diagnostic ignored "-Wstringop-overread"
+#include "app_mtp_ptp.c"
+#pragma GCC diagnostic pop
+
+#define SIM_STORAGE         0x00010001
+#define SIM_STORAGE_2       0x00020001
+#define SIM_PKT_MAX         64
+#define SIM_NAME_MAX        80                                                  /* UTF-16 units of a name */
+#define SIM_RC_DEPTH        0xA808                                              /* Specification_By_Depth_Unsupported */
+
+/* An object on the simulated device */
+typedef struct _SIM_OBJ
+{
+    uint32_t Handle;
+    uint32_t Storage;
+    uint16_t Format;
+    uint64_t Size;
+    uint16_t Name[ SIM_NAME_MAX ];
+    uint8_t  Name_Len;
+    char     Modified[ 16 ];
+    uint8_t  Seen;
+} SIM_OBJ;
+
+typedef struct _SIM_DEV
+{
+    SIM_OBJ  *Obj;
+    uint32_t Num;
+    uint8_t  Pkt;                                                               /* Bulk IN packet size */
+    uint8_t  Refuse_Prop_List;
+
+    /* IN packets queued by the last operation */
+    uint8_t  *Q;
+    uint32_t Q_Len, Q_Size, Q_Pos;
+    uint32_t *Q_Pkt;
+    uint32_t Q_Pkt_Num, Q_Pkt_Max, Q_Pkt_Idx;
+
+    /* Command container being received */
+    uint8_t  Cmd[ 64 ];
+    uint32_t Cmd_Len;
+    uint32_t Trans_Id;
+
+    uint8_t  In_Tog, Out_Tog;
+    uint32_t Ops[ 4 ];                                                          /* GetObjPropList, GetObjectHandles, GetObjectInfo, other */
+    uint32_t In_Pkts;
+    int      Err;
+} SIM_DEV;
+
+static SIM_DEV Sim_Dev;
+
+static void Sim_Error( const char *what )
+{
+    if( Sim_Dev.Err++ < 5 )
+    {
+        printf( "  device: %s\n", what );
+    }
+}
+
+/*******************************************************************************/
+/* USBFS host functions app_mtp_ptp.c calls */
+__attribute__( ( aligned( 4 ) ) ) uint8_t RxBuffer[ USBFS_MAX_PACKET_SIZE ];
+__attribute__( ( aligned( 4 ) ) ) uint8_t TxBuffer[ USBFS_MAX_PACKET_SIZE ];
+
+static void Sim_Dev_Command( void );
+
+/*********************************************************************
+ * @fn      USBFSH_Transact
+ *
+ * @brief   One bulk transaction with the simulated device.
+ *
+ * @return  ERR_SUCCESS, ERR_USB_TRANSFER - the device NAKs, nothing to send
+ */
+uint8_t USBFSH_Transact( uint8_t endp_pid, uint8_t endp_tog, uint16_t timeout )
+{
+    uint32_t len;
+
+    if( ( endp_pid >> 4 ) == USB_PID_OUT )
+    {
+        if( ( ( endp_tog & USBFS_UH_T_TOG ) ? 1 : 0 ) != Sim_Dev.Out_Tog )
+        {
+            Sim_Error( "OUT with the wrong toggle" );
+        }
+        Sim_Dev.Out_Tog ^= 1;
+        len = USBFSH->HOST_TX_LEN;
+        if( Sim_Dev.Cmd_Len + len > sizeof( Sim_Dev.Cmd ) )
+        {
+            Sim_Error( "command container too long" );
+            return ERR_SUCCESS;
+        }
+        memcpy( &Sim_Dev.Cmd[ Sim_Dev.Cmd_Len ], TxBuffer, len );
+        Sim_Dev.Cmd_Len += len;
+        if( ( Sim_Dev.Cmd_Len >= 12 ) && ( Sim_Dev.Cmd_Len >= LE32( Sim_Dev.Cmd ) ) )
+        {
+            Sim_Dev_Command( );
+            Sim_Dev.Cmd_Len = 0;
+        }
+        return ERR_SUCCESS;
+    }
+
+    if( Sim_Dev.Q_Pkt_Idx == Sim_Dev.Q_Pkt_Num )
+    {
+        return ERR_USB_TRANSFER;
+    }
+    if( ( ( endp_tog & USBFS_UH_R_TOG ) ? 1 : 0 ) != Sim_Dev.In_Tog )
+    {
+        Sim_Error( "IN with the wrong toggle" );
+    }
+    Sim_Dev.In_Tog ^= 1;
+    len = Sim_Dev.Q_Pkt[ Sim_Dev.Q_Pkt_Idx++ ];
+    memcpy( RxBuffer, &Sim_Dev.Q[ Sim_Dev.Q_Pos ], len );
+    Sim_Dev.Q_Pos += len;
+    USBFSH->RX_LEN = len;
+    Sim_Dev.In_Pkts++;
+    return ERR_SUCCESS;
+}
+
+uint8_t USBFSH_CheckRootHubPortStatus( uint8_t dev_sta )
+{
+    return ROOT_DEV_CONNECTED;
+}
+
+void USBFSH_ResetRootHubPort( uint8_t mode )
+{
+}
+
+uint8_t USBFSH_EnableRootHubPort( uint8_t *pspeed )
+{
+    return ERR_SUCCESS;
+}
+
+uint8_t USBFSH_GetDeviceDescr( uint8_t *pep0_size, uint8_t *pbuf )
+{
+    return ERR_USB_UNSUPPORT;
+}
+
+uint8_t USBFSH_GetConfigDescr( uint8_t ep0_size, uint8_t *pbuf, uint16_t buf_len, uint16_t *pcfg_len )
+{
+    return ERR_USB_UNSUPPORT;
+}
+
+uint8_t USBFSH_GetStrDescr( uint8_t ep0_size, uint8_t str_num, uint8_t *pbuf )
+{
+    return ERR_USB_UNSUPPORT;
+}
+
+uint8_t USBFSH_SetUsbAddress( uint8_t ep0_size, uint8_t addr )
+{
+    return ERR_USB_UNSUPPORT;
+}
+
+uint8_t USBFSH_SetUsbConfig( uint8_t ep0_size, uint8_t cfg_val )
+{
+    return ERR_USB_UNSUPPORT;
+}
+
+void Delay_Ms( uint32_t n )
+{
+}
+
+/*******************************************************************************/
+/* Simulated device */
+
+static void Q_Put( const void *p, uint32_t n )
+{
+    if( Sim_Dev.Q_Len + n > Sim_Dev.Q_Size )
+    {
+        Sim_Dev.Q_Size = ( Sim_Dev.Q_Len + n ) * 2;
+        Sim_Dev.Q = realloc( Sim_Dev.Q, Sim_Dev.Q_Size );
+    }
+    memcpy( &Sim_Dev.Q[ Sim_Dev.Q_Len ], p, n );
+    Sim_Dev.Q_Len += n;
+}
+
+static void Q_8( uint8_t v )
+{
+    Q_Put( &v, 1 );
+}
+
+static void Q_16( uint16_t v )
+{
+    Q_8( (uint8_t)v );
+    Q_8( (uint8_t)( v >> 8 ) );
+}
+
+static void Q_32( uint32_t v )
+{
+    Q_16( (uint16_t)v );
+    Q_16( (uint16_t)( v >> 16 ) );
+}
+
+static void Q_64( uint64_t v )
+{
+    Q_32( (uint32_t)v );
+    Q_32( (uint32_t)( v >> 32 ) );
+}
+
+/* PTP string: length in characters with the terminator, UTF-16, terminator */
+static void Q_Str( const uint16_t *s, uint8_t n )
+{
+    uint8_t i;
+
+    if( n == 0 )
+    {
+        Q_8( 0 );
+        return;
+    }
+    Q_8( n + 1 );
+    for( i = 0; i < n; i++ )
+    {
+        Q_16( s[ i ] );
+    }
+    Q_16( 0 );
+}
+
+static void Q_Ascii( const char *s )
+{
+    uint16_t u[ 32 ];
+    uint8_t n;
+
+    for( n = 0; s[ n ]; n++ )
+    {
+        u[ n ] = (uint8_t)s[ n ];
+    }
+    Q_Str( u, n );
+}
+
+static void Q_Pkt_Add( uint32_t n )
+{
+    if( Sim_Dev.Q_Pkt_Num == Sim_Dev.Q_Pkt_Max )
+    {
+        Sim_Dev.Q_Pkt_Max = Sim_Dev.Q_Pkt_Max ? Sim_Dev.Q_Pkt_Max * 2 : 1024;
+        Sim_Dev.Q_Pkt = realloc( Sim_Dev.Q_Pkt, Sim_Dev.Q_Pkt_Max * sizeof( uint32_t ) );
+    }
+    Sim_Dev.Q_Pkt[ Sim_Dev.Q_Pkt_Num++ ] = n;
+}
+
+/*********************************************************************
+ * @fn      Q_Container
+ *
+ * @brief   Finish a container started at start with room for its
+ *          header and cut it into packets, with a zero-length packet
+ *          after a full last packet.
+ *
+ * @return  none
+ */
+static void Q_Container( uint32_t start, uint16_t type, uint16_t code )
+{
+    uint32_t len = Sim_Dev.Q_Len - start, n;
+    uint8_t *h = &Sim_Dev.Q[ start ];
+
+    h[ 0 ] = (uint8_t)len;
+    h[ 1 ] = (uint8_t)( len >> 8 );
+    h[ 2 ] = (uint8_t)( len >> 16 );
+    h[ 3 ] = (uint8_t)( len >> 24 );
+    h[ 4 ] = (uint8_t)type;
+    h[ 5 ] = 0;
+    h[ 6 ] = (uint8_t)code;
+    h[ 7 ] = (uint8_t)( code >> 8 );
+    memcpy( h + 8, &Sim_Dev.Trans_Id, 4 );
+    while( 1 )
+    {
+        n = ( len > Sim_Dev.Pkt ) ? Sim_Dev.Pkt : len;
+        Q_Pkt_Add( n );
+        len -= n;
+        if( n < Sim_Dev.Pkt )
+        {
+            break;
+        }
+    }
+}
+
+static uint32_t Q_Begin( void )
+{
+    uint32_t start = Sim_Dev.Q_Len;
+
+    Q_32( 0 );
+    Q_32( 0 );
+    Q_32( 0 );
+    return start;
+}
+
+static void Q_Response( uint16_t code )
+{
+    Q_Container( Q_Begin( ), PTP_USB_CONTAINER_RESPONSE, code );
+}
+
+/* Byte k of an object */
+static uint8_t Sim_Obj_Byte( const SIM_OBJ *po, uint64_t k )
+{
+    return (uint8_t)( po->Handle * 31 + k * 7 + ( k >> 8 ) );
+}
+
+static SIM_OBJ *Sim_Find( uint32_t handle )
+{
+    uint32_t i;
+
+    for( i = 0; i < Sim_Dev.Num; i++ )
+    {
+        if( Sim_Dev.Obj[ i ].Handle == handle )
+        {
+            return &Sim_Dev.Obj[ i ];
+        }
+    }
+    return NULL;
+}
+
+/*********************************************************************
+ * @fn      Sim_Prop_List
+ *
+ * @brief   Queue the GetObjPropList dataset of every object, the
+ *          properties in an order changing from object to object.
+ *
+ * @return  none
+ */
+static void Sim_Prop_List( void )
+{
+    static const uint16_t date[ 3 ] = { '2', '0', '2' };
+    uint32_t start = Q_Begin( ), i, h;
+    uint8_t  k, j, n;
+    SIM_OBJ  *po;
+
+    Q_32( Sim_Dev.Num * 10 );
+    for( i = 0; i < Sim_Dev.Num; i++ )
+    {
+        po = &Sim_Dev.Obj[ i ];
+        h = po->Handle;
+        for( k = 0; k < 10; k++ )
+        {
+            Q_32( h );
+            switch( ( k + i ) % 10 )
+            {
+                case 0:
+                    Q_16( PTP_OPC_StorageID );
+                    Q_16( PTP_DTC_UINT32 );
+                    Q_32( po->Storage );
+                    break;
+                case 1:
+                    Q_16( PTP_OPC_ObjectFormat );
+                    Q_16( PTP_DTC_UINT16 );
+                    Q_16( po->Format );
+                    break;
+                case 2:
+                    Q_16( PTP_OPC_ObjectSize );
+                    Q_16( PTP_DTC_UINT64 );
+                    Q_64( po->Size );
+                    break;
+                case 3:
+                    Q_16( PTP_OPC_ObjectFileName );
+                    Q_16( PTP_DTC_STR );
+                    Q_Str( po->Name, po->Name_Len );
+                    break;
+                case 4:
+                    Q_16( PTP_OPC_DateModified );
+                    Q_16( PTP_DTC_STR );
+                    Q_Ascii( po->Modified );
+                    break;
+                case 5:
+                    Q_16( PTP_OPC_ParentObject );
+                    Q_16( PTP_DTC_UINT32 );
+                    Q_32( 0 );
+                    break;
+                case 6:
+                    Q_16( PTP_OPC_PersistantUniqueObjectIdentifier );
+                    Q_16( PTP_DTC_UINT128 );
+                    Q_64( 0x1122334455667788ULL * h );
+                    Q_64( ~(uint64_t)h );
+                    break;
+                case 7:
+                    /* Array of 0 to 4 UINT16 */
+                    Q_16( PTP_OPC_RepresentativeSampleData );
+                    Q_16( PTP_DTC_AUINT16 );
+                    n = i % 5;
+                    Q_32( n );
+                    for( j = 0; j < n; j++ )
+                    {
+                        Q_16( 0xDC00 + j );
+                    }
+                    break;
+                case 8:
+                    /* Another string, sometimes empty, not to be taken for the name */
+                    Q_16( PTP_OPC_Name );
+                    Q_16( PTP_DTC_STR );
+                    Q_Str( date, ( i % 3 ) ? 3 : 0 );
+                    break;
+                default:
+                    Q_16( PTP_OPC_ProtectionStatus );
+                    Q_16( PTP_DTC_UINT16 );
+                    Q_16( 0 );
+                    break;
+            }
+        }
+    }
+    Q_Container( start, PTP_USB_CONTAINER_DATA, PTP_OC_GetObjPropList );
+    Q_Response( PTP_RC_OK );
+}
+
+/*********************************************************************
+ * @fn      Sim_Dev_Command
+ *
+ * @brief   Act on a command container: queue the data phase, if any, and
+ *          the response.
+ *
+ * @return  none
+ */
+static void Sim_Dev_Command( void )
+{
+    const uint8_t *c = Sim_Dev.Cmd;
+    uint32_t len = LE32( c ), np = ( len - 12 ) / 4, p[ 5 ] = { 0 }, i, start, n;
+    uint16_t code = LE16( c + 6 );
+    uint64_t k, end;
+    SIM_OBJ  *po;
+
+    if( Sim_Dev.Q_Pkt_Idx != Sim_Dev.Q_Pkt_Num )
+    {
+        Sim_Error( "command before the last transaction was read out" );
+    }
+    Sim_Dev.Q_Len = Sim_Dev.Q_Pos = 0;
+    Sim_Dev.Q_Pkt_Num = Sim_Dev.Q_Pkt_Idx = 0;
+    if( ( LE16( c + 4 ) != PTP_USB_CONTAINER_COMMAND ) || ( len < 12 ) || ( np > 5 ) || ( len & 3 ) )
+    {
+        Sim_Error( "bad command container" );
+        return;
+    }
+    if( LE32( c + 8 ) != Sim_Dev.Trans_Id + 1 )
+    {
+        Sim_Error( "transaction ID out of sequence" );
+    }
+    Sim_Dev.Trans_Id = LE32( c + 8 );
+    for( i = 0; i < np; i++ )
+    {
+        p[ i ] = LE32( c + 12 + i * 4 );
+    }
+
+    switch( code )
+    {
+        case PTP_OC_GetObjPropList:
+            Sim_Dev.Ops[ 0 ]++;
+            if( ( np != 5 ) || ( p[ 0 ] != 0 ) || ( p[ 2 ] != 0xFFFFFFFF ) || ( p[ 4 ] != 1 ) )
+            {
+                Sim_Error( "GetObjPropList parameters" );
+            }
+            if( Sim_Dev.Refuse_Prop_List )
+            {
+                Q_Response( SIM_RC_DEPTH );
+            }
+            else
+            {
+                Sim_Prop_List( );
+            }
+            break;
+
+        case PTP_OC_GetObjectHandles:
+            Sim_Dev.Ops[ 1 ]++;
+            if( ( np != 3 ) || ( p[ 2 ] != MTP_ROOT_HANDLE ) )
+            {
+                Sim_Error( "GetObjectHandles parameters" );
+            }
+            start = Q_Begin( );
+            for( i = 0, n = 0; i < Sim_Dev.Num; i++ )
+            {
+                n += ( Sim_Dev.Obj[ i ].Storage == p[ 0 ] );
+            }
+            Q_32( n );
+            for( i = 0; i < Sim_Dev.Num; i++ )
+            {
+                if( Sim_Dev.Obj[ i ].Storage == p[ 0 ] )
+                {
+                    Q_32( Sim_Dev.Obj[ i ].Handle );
+                }
+            }
+            Q_Container( start, PTP_USB_CONTAINER_DATA, code );
+            Q_Response( PTP_RC_OK );
+            break;
+
+        case PTP_OC_GetObjectInfo:
+            Sim_Dev.Ops[ 2 ]++;
+            po = Sim_Find( p[ 0 ] );
+            if( po == NULL )
+            {
+                Q_Response( PTP_RC_InvalidObjectHandle );
+                break;
+            }
+            start = Q_Begin( );
+            Q_32( po->Storage );
+            Q_16( po->Format );
+            Q_16( 0 );
+            Q_32( ( po->Size >> 32 ) ? 0xFFFFFFFF : (uint32_t)po->Size );
+            Q_16( 0 );                                                          /* Thumb format */
+            for( i = 0; i < 6; i++ )                                            /* Thumb and image sizes, bit depth */
+            {
+                Q_32( 0 );
+            }
+            Q_32( 0 );                                                          /* Parent */
+            Q_16( ( po->Format == PTP_OFC_Association ) ? 1 : 0 );
+            Q_32( 0 );
+            Q_32( 0 );
+            Q_Str( po->Name, po->Name_Len );
+            Q_Ascii( "20240101T000000" );
+            Q_Ascii( po->Modified );
+            Q_8( 0 );
+            Q_Container( start, PTP_USB_CONTAINER_DATA, code );
+            Q_Response( PTP_RC_OK );
+            break;
+
+        case PTP_OC_GetObject:
+        case PTP_OC_GetPartialObject:
+            Sim_Dev.Ops[ 3 ]++;
+            po = Sim_Find( p[ 0 ] );
+            if( ( po == NULL ) || ( po->Format == PTP_OFC_Association ) )
+            {
+                Q_Response( PTP_RC_InvalidObjectHandle );
+                break;
+            }
+            k = ( code == PTP_OC_GetObject ) ? 0 : p[ 1 ];
+            end = ( code == PTP_OC_GetObject ) ? po->Size : k + p[ 2 ];
+            end = ( end > po->Size ) ? po->Size : end;
+            k = ( k > end ) ? end : k;
+            start = Q_Begin( );
+            for( ; k < end; k++ )
+            {
+                Q_8( Sim_Obj_Byte( po, k ) );
+            }
+            Q_Container( start, PTP_USB_CONTAINER_DATA, code );
+            Q_Response( PTP_RC_OK );
+            break;
+
+        default:
+            Sim_Dev.Ops[ 3 ]++;
+            Q_Response( PTP_RC_OperationNotSupported );
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Dev_Init
+ *
+ * @brief   A device with a folder of num objects, and the host state as
+ *          after enumeration and OpenSession.
+ *
+ * @param   num - objects
+ *          pkt - bulk IN packet size
+ *          prop_list - 1 - GetObjPropList listed in DeviceInfo
+ *
+ * @return  none
+ */
+static void Sim_Dev_Init( uint32_t num, uint8_t pkt, uint8_t prop_list )
+{
+    static const uint16_t tail[ 5 ][ 3 ] =
+    {
+        { 0 }, { 0x00E9 }, { 0x65E5, 0x672C }, { 0xD83D, 0xDE00 }, { 'x', 0x0416 }
+    };
+    static const uint8_t tail_len[ 5 ] = { 0, 1, 2, 2, 2 };
+    char     a[ SIM_NAME_MAX ];
+    uint32_t i, t;
+    uint8_t  n;
+    SIM_OBJ  *po;
+
+    free( Sim_Dev.Obj );
+    free( Sim_Dev.Q );
+    free( Sim_Dev.Q_Pkt );
+    memset( &Sim_Dev, 0, sizeof( Sim_Dev ) );
+    Sim_Dev.Pkt = pkt;
+    Sim_Dev.Num = num;
+    Sim_Dev.Obj = calloc( num + 1, sizeof( SIM_OBJ ) );
+    for( i = 0; i < num; i++ )
+    {
+        po = &Sim_Dev.Obj[ i ];
+        po->Handle = 0x100 + i * 3;
+        po->Storage = ( i % 11 == 10 ) ? SIM_STORAGE_2 : SIM_STORAGE;
+        po->Format = ( i % 7 == 6 ) ? PTP_OFC_Association : PTP_OFC_EXIF_JPEG;
+        po->Size = ( po->Format == PTP_OFC_Association ) ? 0 :
+                   ( i % 13 == 12 ) ? ( 5ULL << 32 ) + i : (uint64_t)i * 1000 + 7;
+        if( i % 50 == 49 )
+        {
+            snprintf( a, sizeof( a ), "A name longer than the host keeps, object number %u ", i );
+        }
+        else
+        {
+            snprintf( a, sizeof( a ), ( po->Format == PTP_OFC_Association ) ? "Folder %u" : "IMG_%05u_", i );
+        }
+        for( n = 0; a[ n ]; n++ )
+        {
+            po->Name[ n ] = (uint8_t)a[ n ];
+        }
+        for( t = 0; t < tail_len[ i % 5 ]; t++ )
+        {
+            po->Name[ n++ ] = tail[ i % 5 ][ t ];
+        }
+        if( po->Format != PTP_OFC_Association )
+        {
+            po->Name[ n++ ] = '.';
+            po->Name[ n++ ] = 'j';
+            po->Name[ n++ ] = 'p';
+            po->Name[ n++ ] = 'g';
+        }
+        po->Name_Len = n;
+        snprintf( po->Modified, sizeof( po->Modified ), "2025%02u%02uT%02u%02u%02u",
+                  1 + i % 12, 1 + i % 28, i % 24, i % 60, ( i / 60 ) % 60 );
+    }
+
+    memset( &PTP_Container, 0, sizeof( PTP_Container ) );
+    memset( &PTP_DeviceInfo, 0, sizeof( PTP_DeviceInfo ) );
+    memset( HostCtl, 0, sizeof( HostCtl ) );
+    RootHubDev.DeviceIndex = 0;
+    HostCtl[ 0 ].Interface[ 0 ].InEndpAddr[ 0 ] = 1;
+    HostCtl[ 0 ].Interface[ 0 ].OutEndpAddr[ 0 ] = 2;
+    HostCtl[ 0 ].Interface[ 0 ].InEndpSize[ 0 ] = pkt;
+    HostCtl[ 0 ].Interface[ 0 ].OutEndpSize[ 0 ] = pkt;
+    MTP_PTP_ParaInit( );
+    PTP_DeviceInfo.OperationsSupported[ PTP_DeviceInfo.OperationsSupported_len++ ] = PTP_OC_GetObjectHandles;
+    PTP_DeviceInfo.OperationsSupported[ PTP_DeviceInfo.OperationsSupported_len++ ] = PTP_OC_GetObjectInfo;
+    PTP_DeviceInfo.OperationsSupported[ PTP_DeviceInfo.OperationsSupported_len++ ] = PTP_OC_GetObject;
+    if( prop_list )
+    {
+        PTP_DeviceInfo.OperationsSupported[ PTP_DeviceInfo.OperationsSupported_len++ ] = PTP_OC_GetObjPropList;
+    }
+
+    /* OpenSession was transaction 1 */
+    PTP_Container.Transaction_ID = 2;
+    Sim_Dev.Trans_Id = 1;
+}
+
+/*********************************************************************
+ * @fn      Sim_Name_Utf8
+ *
+ * @brief   Name of an object as the host should keep it: UTF-8, cut at a
+ *          character, halves of characters beyond the BMP as '?'.
+ *
+ * @return  none
+ */
+static void Sim_Name_Utf8( const SIM_OBJ *po, char *out )
+{
+    uint32_t o = 0, i, n;
+    uint16_t c;
+
+    for( i = 0; i < po->Name_Len; i++ )
+    {
+        c = po->Name[ i ];
+        c = ( ( c >= 0xD800 ) && ( c <= 0xDFFF ) ) ? '?' : c;
+        n = ( c < 0x80 ) ? 1 : ( c < 0x800 ) ? 2 : 3;
+        if( o + n >= DEF_MTP_NAME_LEN )
+        {
+            break;
+        }
+        if( n == 1 )
+        {
+            out[ o++ ] = (char)c;
+        }
+        else if( n == 2 )
+        {
+            out[ o++ ] = (char)( 0xC0 | ( c >> 6 ) );
+            out[ o++ ] = (char)( 0x80 | ( c & 0x3F ) );
+        }
+        else
+        {
+            out[ o++ ] = (char)( 0xE0 | ( c >> 12 ) );
+            out[ o++ ] = (char)( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+            out[ o++ ] = (char)( 0x80 | ( c & 0x3F ) );
+        }
+    }
+    out[ o ] = 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Object_Sink
+ *
+ * @brief   Listing sink: check an object against the device.
+ *
+ * @param   ctx - 1 - the size is only known to 32 bits (ObjectInfo)
+ *
+ * @return  none
+ */
+static void Sim_Object_Sink( MTP_ObjectTypeDef *pobj, void *ctx )
+{
+    char     name[ DEF_MTP_NAME_LEN ];
+    uint64_t size;
+    SIM_OBJ  *po = Sim_Find( pobj->Handle );
+
+    if( po == NULL )
+    {
+        Sim_Error( "unknown handle listed" );
+        return;
+    }
+    if( po->Seen++ )
+    {
+        Sim_Error( "object listed twice" );
+    }
+    Sim_Name_Utf8( po, name );
+    size = ( *(uint8_t *)ctx && ( po->Size >> 32 ) ) ? 0xFFFFFFFF : po->Size;
+    if( ( pobj->StorageID != po->Storage ) || ( pobj->Format != po->Format ) || ( pobj->Size != size ) ||
+        ( pobj->Parent != 0 ) || strcmp( pobj->Name, name ) || strcmp( pobj->Modified, po->Modified ) )
+    {
+        if( Sim_Dev.Err < 5 )
+        {
+            printf( "  %08x: %04x %llu \"%s\" %s, the device has %04x %llu \"%s\" %s\n", pobj->Handle, pobj->Format,
+                    (unsigned long long)pobj->Size, pobj->Name, pobj->Modified, po->Format,
+                    (unsigned long long)size, name, po->Modified );
+        }
+        Sim_Error( "object listed wrong" );
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_List
+ *
+ * @brief   List the folder and check that every object of the storage
+ *          came exactly once.
+ *
+ * @return  0 - passed
+ */
+static int Sim_List( uint8_t by_info )
+{
+    uint32_t num, i, want = 0;
+    uint8_t  s;
+
+    s = USBH_MTP_ListObjects( SIM_STORAGE, MTP_ROOT_HANDLE, Sim_Object_Sink, &by_info, &num );
+    for( i = 0; i < Sim_Dev.Num; i++ )
+    {
+        if( Sim_Dev.Obj[ i ].Storage == SIM_STORAGE )
+        {
+            want++;
+            if( !Sim_Dev.Obj[ i ].Seen )
+            {
+                Sim_Error( "object not listed" );
+            }
+        }
+        Sim_Dev.Obj[ i ].Seen = 0;
+    }
+    if( ( s != PTP_OK ) || ( num != want ) || ( Sim_Dev.Q_Pkt_Idx != Sim_Dev.Q_Pkt_Num ) )
+    {
+        printf( "  status %d, %u of %u objects, %u packets left\n", s, num, want, Sim_Dev.Q_Pkt_Num - Sim_Dev.Q_Pkt_Idx );
+        return 1;
+    }
+    return Sim_Dev.Err;
+}
+
+/* Stream sink: check every byte against the object */
+typedef struct _SIM_READ
+{
+    const SIM_OBJ *Obj;
+    uint64_t Pos;
+    int      Bad;
+} SIM_READ;
+
+static uint8_t Sim_Data_Sink( uint8_t *pbuf, uint32_t len, void *ctx )
+{
+    SIM_READ *pr = (SIM_READ *)ctx;
+
+    while( len-- )
+    {
+        pr->Bad += ( *pbuf++ != Sim_Obj_Byte( pr->Obj, pr->Pos++ ) );
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Read
+ *
+ * @brief   Stream an object, or part of it, and check it.
+ *
+ * @return  0 - passed
+ */
+static int Sim_Read( uint32_t idx, uint32_t offset, uint32_t maxlen, uint32_t want )
+{
+    SIM_READ rd;
+    uint32_t len;
+    uint8_t  s;
+
+    rd.Obj = &Sim_Dev.Obj[ idx ];
+    rd.Pos = offset;
+    rd.Bad = 0;
+    s = USBH_PTP_GetObjectStream( rd.Obj->Handle, offset, maxlen, Sim_Data_Sink, &rd, &len );
+    if( ( s != PTP_OK ) || ( len != want ) || rd.Bad || ( Sim_Dev.Q_Pkt_Idx != Sim_Dev.Q_Pkt_Num ) || Sim_Dev.Err )
+    {
+        printf( "  object %u from %u: status %d, %u of %u bytes, %d wrong\n", idx, offset, s, len, want, rd.Bad );
+        return 1;
+    }
+    return 0;
+}
+
+static int Sim_Test_Prop_List( void )
+{
+    static const uint32_t num[ ] = { 0, 1, 2, 7, 100, 2000 };
+    static const uint8_t pkt[ ] = { 16, 32, 64 };
+    uint32_t i, j;
+
+    for( i = 0; i < sizeof( num ) / sizeof( num[ 0 ] ); i++ )
+    {
+        for( j = 0; j < sizeof( pkt ); j++ )
+        {
+            Sim_Dev_Init( num[ i ], pkt[ j ], 1 );
+            if( Sim_List( 0 ) || ( Sim_Dev.Ops[ 0 ] != 1 ) || ( Sim_Dev.Ops[ 1 ] + Sim_Dev.Ops[ 2 ] ) )
+            {
+                printf( "  %u objects in %u byte packets\n", num[ i ], pkt[ j ] );
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int Sim_Test_Info( void )
+{
+    const uint32_t num[ ] = { 0, 1, 2, 100, DEF_MTP_HANDLE_WIN, DEF_MTP_HANDLE_WIN + 1,
+                              ( DEF_MTP_HANDLE_WIN + 1 ) * 11 / 10, 2 * DEF_MTP_HANDLE_WIN + 5, 4000 };
+    uint32_t i, k, want, batches;
+
+    for( i = 0; i < sizeof( num ) / sizeof( num[ 0 ] ); i++ )
+    {
+        Sim_Dev_Init( num[ i ], 64, 0 );
+        for( k = 0, want = 0; k < num[ i ]; k++ )
+        {
+            want += ( Sim_Dev.Obj[ k ].Storage == SIM_STORAGE );
+        }
+        batches = want ? ( want + DEF_MTP_HANDLE_WIN - 1 ) / DEF_MTP_HANDLE_WIN : 1;
+        if( Sim_List( 1 ) || Sim_Dev.Ops[ 0 ] || ( Sim_Dev.Ops[ 1 ] != batches ) || ( Sim_Dev.Ops[ 2 ] != want ) )
+        {
+            printf( "  %u objects: %u GetObjectHandles, %u GetObjectInfo\n", num[ i ], Sim_Dev.Ops[ 1 ], Sim_Dev.Ops[ 2 ] );
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int Sim_Test_Refused_List( void )
+{
+    Sim_Dev_Init( 300, 64, 1 );
+    Sim_Dev.Refuse_Prop_List = 1;
+    if( Sim_List( 1 ) || ( Sim_Dev.Ops[ 0 ] != 1 ) || ( Sim_Dev.Ops[ 1 ] != 1 ) )
+    {
+        return 1;
+    }
+    return 0;
+}
+
+static int Sim_Test_Stream( void )
+{
+    static const uint8_t pkt[ ] = { 16, 64 };
+    uint32_t j, i;
+
+    for( j = 0; j < sizeof( pkt ); j++ )
+    {
+        Sim_Dev_Init( 20, pkt[ j ], 1 );
+        Sim_Dev.Obj[ 0 ].Size = 0;
+        Sim_Dev.Obj[ 1 ].Size = 10000;
+        Sim_Dev.Obj[ 2 ].Size = 4096 - 12;                                      /* Container of whole packets */
+        Sim_Dev.Obj[ 3 ].Size = pkt[ j ] - 12;
+        Sim_Dev.Obj[ 4 ].Size = pkt[ j ] - 13;
+        for( i = 0; i < 5; i++ )
+        {
+            if( Sim_Read( i, 0, 0xFFFFFFFF, (uint32_t)Sim_Dev.Obj[ i ].Size ) )
+            {
+                return 1;
+            }
+        }
+        /* GetPartialObject, inside, across and beyond the end */
+        if( Sim_Read( 1, 3333, 1000, 1000 ) || Sim_Read( 1, 9500, 1000, 500 ) ||
+            Sim_Read( 1, 10000, 1000, 0 ) || Sim_Read( 2, 1, 4096 - 12 - 1, 4096 - 12 - 1 ) )
+        {
+            return 1;
+        }
+        /* And listing still in step */
+        if( Sim_List( 0 ) )
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int Sim_Test_Refused( void )
+{
+    uint32_t sum = 0, len;
+    uint8_t  s;
+
+    Sim_Dev_Init( 20, 64, 1 );
+
+    /* Folder, then unknown handle */
+    s = USBH_PTP_GetObjectStream( Sim_Dev.Obj[ 6 ].Handle, 0, 0xFFFFFFFF, MTP_Demo_DataSink, &sum, &len );
+    if( ( s != PTP_FAIL ) || ( PTP_RespContainer.code != PTP_RC_InvalidObjectHandle ) || len )
+    {
+        printf( "  folder read: status %d, code %04x\n", s, PTP_RespContainer.code );
+        return 1;
+    }
+    s = USBH_PTP_GetObjectStream( 0x12345, 0, 100, MTP_Demo_DataSink, &sum, &len );
+    if( ( s != PTP_FAIL ) || ( PTP_RespContainer.code != PTP_RC_InvalidObjectHandle ) )
+    {
+        printf( "  unknown handle: status %d, code %04x\n", s, PTP_RespContainer.code );
+        return 1;
+    }
+
+    /* An operation the device does not have */
+    PTP_Container.Code = PTP_OC_GetThumb;
+    PTP_Container.Param1 = Sim_Dev.Obj[ 1 ].Handle;
+    PTP_Container.Nparam = 1;
+    s = USBH_PTP_SendRequest( );
+    PTP_Container.Transaction_ID++;
+    if( s == PTP_OK )
+    {
+        s = USBH_PTP_RecvDataStream( NULL, NULL, &len );
+    }
+    if( ( s != PTP_FAIL ) || ( PTP_RespContainer.code != PTP_RC_OperationNotSupported ) )
+    {
+        printf( "  GetThumb: status %d, code %04x\n", s, PTP_RespContainer.code );
+        return 1;
+    }
+    return Sim_Read( 1, 0, 0xFFFFFFFF, 1007 ) || Sim_List( 0 ) || Sim_Dev.Err;
+}
+
+/*********************************************************************
+ * @fn      Sim_Self_Test
+ *
+ * @brief   Run every self-test case, each in its own process.
+ *
+ * @return  number of failed cases
+ */
+static int Sim_Self_Test( void )
+{
+    static const struct
+    {
+        const char *Name;
+        int ( *Run )( void );
+    } test[ ] =
+    {
+        { "GetObjPropList, 0 to 2000 objects, 16/32/64 byte packets", Sim_Test_Prop_List },
+        { "GetObjectHandles and GetObjectInfo, 0 to 4000 objects", Sim_Test_Info },
+        { "GetObjPropList refused, listed by GetObjectInfo", Sim_Test_Refused_List },
+        { "objects and parts of objects streamed", Sim_Test_Stream },
+        { "refused operations", Sim_Test_Refused },
+    };
+    pid_t pid;
+    int i, st, fail = 0;
+
+    for( i = 0; i < (int)( sizeof( test ) / sizeof( test[ 0 ] ) ); i++ )
+    {
+        printf( "%s\n", test[ i ].Name );
+        fflush( stdout );
+        pid = fork( );
+        if( pid == 0 )
+        {
+            st = test[ i ].Run( );
+            fflush( stdout );
+            _exit( st ? 1 : 0 );
+        }
+        if( ( pid < 0 ) || ( waitpid( pid, &st, 0 ) != pid ) || !WIFEXITED( st ) || WEXITSTATUS( st ) )
+        {
+            printf( "  FAIL\n" );
+            fail++;
+        }
+        else
+        {
+            printf( "  ok\n" );
+        }
+    }
+    printf( "%s\n", fail ? "self-test FAILED" : "self-test passed" );
+    return fail;
+}
+
+int main( int argc, char **argv )
+{
+    int c, test = 0, bad;
+    uint32_t num = 2000;
+    uint8_t pkt = 64, way;
+
+    while( ( c = getopt( argc, argv, "n:p:t" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 'n':
+                num = strtoul( optarg, NULL, 0 );
+                break;
+            case 'p':
+                pkt = atoi( optarg );
+                break;
+            case 't':
+                test = 1;
+                break;
+            default:
+                fprintf( stderr, "usage: %s [-n objects] [-p packet size] | -t\n", argv[ 0 ] );
+                return 2;
+        }
+    }
+    if( test )
+    {
+        return Sim_Self_Test( ) ? 1 : 0;
+    }
+    if( ( pkt < 16 ) || ( pkt > SIM_PKT_MAX ) )
+    {
+        fprintf( stderr, "packet size 16 to %d\n", SIM_PKT_MAX );
+        return 2;
+    }
+
+    printf( "%u objects, %u byte packets\n", num, pkt );
+    for( way = 0; way < 2; way++ )
+    {
+        Sim_Dev_Init( num, pkt, !way );
+        bad = Sim_List( way );
+        printf( "  %-32s %5u transactions, %6u IN packets%s\n",
+                way ? "GetObjectHandles, GetObjectInfo:" : "GetObjPropList:",
+                Sim_Dev.Ops[ 0 ] + Sim_Dev.Ops[ 1 ] + Sim_Dev.Ops[ 2 ], Sim_Dev.In_Pkts, bad ? ", listed WRONG" : "" );
+        if( bad )
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
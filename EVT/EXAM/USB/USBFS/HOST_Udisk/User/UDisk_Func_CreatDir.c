@@ -189,6 +189,7 @@ void UDisk_USBH_CreatDirectory( void )
         mCmdParam.Close.mUpdateLen = 0;                               //Ŀ¼ҪԶļ
         ret = CHRV3FileClose( );                                      //رĿ¼,Ŀ¼Ҫر,رֻΪ˷ֹ
         mStopIfError( ret );
+        mStopIfError( CHRV3CacheFlush( ) );     // Write back the sectors held by the cache
     }
 }
 
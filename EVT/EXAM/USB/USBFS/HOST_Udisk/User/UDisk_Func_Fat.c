@@ -0,0 +1,212 @@
+/********************************** (C) COPYRIGHT *******************************
+* File Name          : UDisk_Func_Fat.c
+* Author             : WCH
+* Version            : V1.0.0
+* Date               : 2026/10/19
+* Description        : U-disk file operations through the FAT layer in source
+*                      (Udisk_Lib/CH643UFI_Fat.c) instead of the file library.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*******************************************************************************/
+/* Header File */
+#include "Udisk_Operation.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+__attribute__((aligned(4))) uint8_t Fat_Demo_Buf[ DEF_FAT_DEMO_BUF_LEN ];
+
+/*********************************************************************
+ * @fn      UDisk_Fat_ReadAll
+ *
+ * @brief   Read a file to its end through the FAT layer.
+ *
+ * @para    path: File.
+ *          pcmd: READ(10) commands sent.
+ *
+ * @return  Bytes read.
+ */
+uint32_t UDisk_Fat_ReadAll( const char *path, uint32_t *pcmd )
+{
+    UFAT_FILE File;
+    uint32_t  total = 0, len;
+    uint8_t   ret;
+
+    *pcmd = Udisk_Cache_Stat.Rd_Cmd;
+    ret = UFAT_Open( &File, path, UFAT_READ );
+    if( ret == ERR_SUCCESS )
+    {
+        do
+        {
+            ret = UFAT_Read( &File, Fat_Demo_Buf, DEF_FAT_DEMO_BUF_LEN, &len );
+            total += len;
+        } while( ( ret == ERR_SUCCESS ) && len );
+        UFAT_Close( &File );
+    }
+    *pcmd = Udisk_Cache_Stat.Rd_Cmd - *pcmd;
+    return total;
+}
+
+/*********************************************************************
+ * @fn      UDisk_Lib_ReadAll
+ *
+ * @brief   Read a file to its end through the file library, by bytes.
+ *
+ * @para    path: File, 8.3 upper-case names only.
+ *          pcmd: READ(10) commands sent.
+ *
+ * @return  Bytes read, 0 - no such file.
+ */
+uint32_t UDisk_Lib_ReadAll( const char *path, uint32_t *pcmd )
+{
+    uint32_t total = 0;
+
+    *pcmd = Udisk_Cache_Stat.Rd_Cmd;
+    strcpy( (char *)mCmdParam.Open.mPathName, path );
+    if( CHRV3FileOpen( ) == ERR_SUCCESS )
+    {
+        do
+        {
+            mCmdParam.ByteRead.mByteCount = DEF_FAT_DEMO_BUF_LEN;
+            mCmdParam.ByteRead.mByteBuffer = Fat_Demo_Buf;
+            if( CHRV3ByteRead( ) != ERR_SUCCESS )
+            {
+                break;
+            }
+            total += mCmdParam.ByteRead.mByteCount;
+        } while( mCmdParam.ByteRead.mByteCount == DEF_FAT_DEMO_BUF_LEN );
+        CHRV3FileClose( );
+    }
+    *pcmd = Udisk_Cache_Stat.Rd_Cmd - *pcmd;
+    return total;
+}
+
+/*********************************************************************
+ * @fn      UDisk_USBH_FatOperation
+ *
+ * @brief   Demo Function For the FAT layer (EXAM 20): long names in UTF-8,
+ *          directories, byte and whole-sector file access, listing and
+ *          free space, and the READ(10) commands a file costs through the
+ *          FAT layer and through the file library.
+ *
+ * @return  none
+ */
+void UDisk_USBH_FatOperation( void )
+{
+    UFAT_FILE File;
+    UFAT_DIR  Dir;
+    UFAT_INFO Info;
+    uint32_t  len, total, cmd_lib, cmd_fat, free_sect;
+#if DEF_USBH_XFER_EN && DEF_USBH_XFER_STAT
+    uint32_t  t, idle;
+#endif
+    uint16_t  i;
+    uint8_t   ret;
+
+    ret = UDisk_USBH_DiskReady( );
+    if( ( ret == DISK_READY ) && ( UDisk_Opeation_Flag == 1 ) )
+    {
+        UDisk_Opeation_Flag = 0;
+
+        /* The library reads the test file left by the last run, before the
+         * FAT layer has touched the disk */
+        total = UDisk_Lib_ReadAll( "/UFAT/SPEED.BIN", &cmd_lib );
+
+        ret = UFAT_Mount( );
+        mStopIfError( ret );
+        printf( "FAT%d, %d sectors per cluster, %d clusters\r\n",
+                ( UFAT_Vol.Type == DISK_FAT12 ) ? 12 : ( ( UFAT_Vol.Type == DISK_FAT16 ) ? 16 : 32 ),
+                1 << UFAT_Vol.Clus_Shift, UFAT_Vol.Clus_Max - 2 );
+        UFAT_Time = ( (uint32_t)MAKE_FILE_DATE( 2026, 10, 19 ) << 16 ) | MAKE_FILE_TIME( 12, 0, 0 );
+
+        ret = UFAT_Mkdir( "/UFAT" );
+        if( ret != ERR_UFAT_EXIST )
+        {
+            mStopIfError( ret );
+        }
+
+        /* Long name, written a line at a time */
+        printf( "Write /UFAT/Long file name, 長い名前.txt\r\n" );
+        ret = UFAT_Open( &File, "/UFAT/Long file name, 長い名前.txt", UFAT_CREATE | UFAT_TRUNC );
+        mStopIfError( ret );
+        for( i = 0; i < 10; i++ )
+        {
+            len = sprintf( (char *)Com_Buffer, "Line %d, written through the FAT layer.\r\n", i );
+            ret = UFAT_Write( &File, Com_Buffer, len, &len );
+            mStopIfError( ret );
+        }
+        ret = UFAT_Close( &File );
+        mStopIfError( ret );
+
+        /* Read back from the middle */
+        ret = UFAT_Open( &File, "/ufat/long FILE name, 長い名前.TXT", UFAT_READ );
+        mStopIfError( ret );
+        UFAT_Seek( &File, File.Size / 2 );
+        ret = UFAT_Read( &File, Com_Buffer, DEF_COM_BUF_LEN - 1, &len );
+        mStopIfError( ret );
+        Com_Buffer[ len ] = 0;
+        printf( "Read %d bytes from %d:\r\n%s\r\n", len, File.Size / 2, Com_Buffer );
+        UFAT_Close( &File );
+
+        /* Whole sectors go straight between the buffer and the disk */
+        if( total == 0 )
+        {
+            printf( "Write /UFAT/SPEED.BIN, %d KB\r\n", DEF_FAT_DEMO_FILE_LEN / 1024 );
+            ret = UFAT_Open( &File, "/UFAT/SPEED.BIN", UFAT_CREATE | UFAT_TRUNC );
+            mStopIfError( ret );
+            for( i = 0; i < DEF_FAT_DEMO_BUF_LEN; i++ )
+            {
+                Fat_Demo_Buf[ i ] = (uint8_t)i;
+            }
+            for( total = 0; total < DEF_FAT_DEMO_FILE_LEN; total += len )
+            {
+                ret = UFAT_Write( &File, Fat_Demo_Buf, DEF_FAT_DEMO_BUF_LEN, &len );
+                mStopIfError( ret );
+            }
+            ret = UFAT_Close( &File );
+            mStopIfError( ret );
+            printf( "Remove and insert the disk again to compare with the library\r\n" );
+        }
+#if DEF_USBH_XFER_EN && DEF_USBH_XFER_STAT
+        t = USBH_Xfer_Us( );
+        idle = USBH_Xfer_Stat.Idle_Us;
+#endif
+        total = UDisk_Fat_ReadAll( "/UFAT/SPEED.BIN", &cmd_fat );
+#if DEF_USBH_XFER_EN && DEF_USBH_XFER_STAT
+        t = USBH_Xfer_Us( ) - t;
+        idle = USBH_Xfer_Stat.Idle_Us - idle;
+#endif
+        printf( "SPEED.BIN, %d bytes in %d byte reads: FAT layer %d READ(10)", total, DEF_FAT_DEMO_BUF_LEN, cmd_fat );
+        if( cmd_lib )
+        {
+            printf( ", library %d READ(10)", cmd_lib );
+        }
+        printf( "\r\n" );
+#if DEF_USBH_XFER_EN && DEF_USBH_XFER_STAT
+        /* The CPU sleeps while the packets of a sector move */
+        if( t >= 1000 )
+        {
+            printf( "Read in %dms, %d KB/s, CPU busy %d%%\r\n", t / 1000,
+                    total / 1024 * 1000 / ( t / 1000 ), ( t - idle ) / ( t / 100 ) );
+        }
+#endif
+
+        /* Listing */
+        ret = UFAT_OpenDir( &Dir, "/UFAT" );
+        mStopIfError( ret );
+        while( UFAT_ReadDir( &Dir, &Info ) == ERR_SUCCESS )
+        {
+            printf( "  %-12s %10d  %s%s\r\n", Info.Short, Info.Size, Info.Name, ( Info.Attr & ATTR_DIRECTORY ) ? "/" : "" );
+        }
+
+        ret = UFAT_Free( &free_sect );
+        mStopIfError( ret );
+        printf( "Free %d KB\r\n", free_sect / 2 );
+
+        ret = UFAT_Unmount( );
+        mStopIfError( ret );
+    }
+}
@@ -73,6 +73,7 @@ void UDisk_USBH_Longname( void )
         // óļANSIļ(8+3ʽ)
         strcpy( mCmdParam.Create.mPathName, "\\ļ.TXT" );
         i = CHRV3CreateLongName( );
+        CHRV3CacheFlush( );                                 // Write back the sectors held by the cache
         if( i == ERR_SUCCESS )
         {
             DUG_PRINTF( "Created Long Name OK!\r\n" );
@@ -69,6 +69,9 @@ void Udisk_USBH_Initialization( void )
     DUG_PRINTF( "USBFS Host Init\r\n" );
     USBFS_RCC_Init( );
     USBFS_Host_Init( ENABLE , PWR_VDD_SupplyVoltage());
+#if DEF_USBH_XFER_EN
+    USBH_Xfer_Init( );
+#endif
     memset( &RootHubDev[ DEF_USB_PORT_FS ].bStatus, 0, sizeof( struct _ROOT_HUB_DEVICE ) );
     memset( &HostCtl[ DEF_USB_PORT_FS ].InterfaceNum, 0, sizeof( struct __HOST_CTL ) );
 	
@@ -50,6 +50,10 @@ extern uint8_t LongName[ ];
 #define     ERR_LONG_NAME           0X46        // 错误的长文件名
 #define     ERR_NAME_EXIST          0X47        // 此短文件名存在
 
+/* FAT layer demo */
+#define     DEF_FAT_DEMO_BUF_LEN    2048        // Bytes per read and write, whole sectors go straight to the disk
+#define     DEF_FAT_DEMO_FILE_LEN   ( 64 * 1024 )
+
 /*******************************************************************************/
 /* Extern UDisk Operation Functions */
 extern void mStopIfError( uint8_t iError );
@@ -75,4 +79,9 @@ extern void UDisk_USBH_ByteOperation( void );
 extern void UDisk_USBH_SectorOperation( void );
 extern void UDisk_USBH_EnumFiles( void );
 
+/* Extern FAT Layer Functions */
+extern void UDisk_USBH_FatOperation( void );
+extern uint32_t UDisk_Fat_ReadAll( const char *path, uint32_t *pcmd );
+extern uint32_t UDisk_Lib_ReadAll( const char *path, uint32_t *pcmd );
+
 #endif /* USER_UDISK_OPERATION_H_ */
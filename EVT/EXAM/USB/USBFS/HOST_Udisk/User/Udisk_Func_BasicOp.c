@@ -71,6 +71,7 @@ void UDisk_USBH_ByteOperation( void )
             mCmdParam.Close.mUpdateLen = 1;     //Զļ,ֽΪλдļ,óرļԱԶļ
             i = CHRV3FileClose( );
             mStopIfError( i );
+            mStopIfError( CHRV3CacheFlush( ) );     // Write back the sectors held by the cache
 
             /* ɾĳļ */
 //            printf( "Erase\n" );
@@ -106,6 +107,7 @@ void UDisk_USBH_ByteOperation( void )
             mCmdParam.Close.mUpdateLen = 1;     //Զļ,ֽΪλдļ,óرļԱԶļ
             i = CHRV3FileClose( );
             mStopIfError( i );
+            mStopIfError( CHRV3CacheFlush( ) );     // Write back the sectors held by the cache
 
             /* ȡļǰNֽ */
             TotalCount = 60;                                                  //׼ȡܳ100ֽ
@@ -249,6 +251,7 @@ void UDisk_USBH_SectorOperation( void )
             printf( "Close\r\n" );
             i = CHRV3FileClose( );                            //رļ
             mStopIfError( i );
+            mStopIfError( CHRV3CacheFlush( ) );     // Write back the sectors held by the cache
         }
         printf( "Create\r\n" );
         strcpy( mCmdParam.Create.mPathName, "/NEWFILE.TXT" );//ļ,ڸĿ¼,ļ
@@ -286,6 +289,7 @@ void UDisk_USBH_SectorOperation( void )
         mCmdParam.Close.mUpdateLen = 1;                        //Զļ,ֽΪλдļ,óرļԱԶļ
         i = CHRV3FileClose( );
         mStopIfError( i );
+        mStopIfError( CHRV3CacheFlush( ) );     // Write back the sectors held by the cache
         /* ɾĳļ */
         /*printf( "Erase\n" );
           strcpy( mCmdParam.Create.mPathName, "/OLD.TXT" );  ɾļ,ڸĿ¼
@@ -354,6 +358,7 @@ void UDisk_USBH_EnumFiles( void )
         }
         printf( "Close\r\n" );
         CHRV3FileClose( );                            //رļ
+        CHRV3CacheFlush( );                           // Write back the sectors held by the cache
         printf( "Uʾ\r\n" );
     }
 }
@@ -284,6 +284,9 @@ uint8_t USBFSH_Transact( uint8_t endp_pid, uint8_t endp_tog, uint16_t timeout )
     uint8_t  r, trans_rerty;
     uint16_t i;
 
+#if DEF_USBH_XFER_EN
+    return USBH_Xfer_Transact( endp_pid, endp_tog, timeout );
+#endif
     USBFSH->HOST_TX_CTRL = USBFSH->HOST_RX_CTRL = endp_tog;
     trans_rerty = 0;
     do
@@ -333,7 +336,7 @@ uint8_t USBFSH_Transact( uint8_t endp_pid, uint8_t endp_tog, uint16_t timeout )
                     }
                     break;
                 case USB_PID_IN:
-                    if( ( r == USB_PID_DATA0 ) && ( r == USB_PID_DATA1 ) )
+                    if( ( r == USB_PID_DATA0 ) || ( r == USB_PID_DATA1 ) )
                     {
                         ;
                     }
@@ -26,6 +26,17 @@
  the first 1000 files on the drive.
    5,Exam 13 :USBFS host controller enumerates USB drives to create long filename files,
  or to get long filename files.
+   6,Exam 20 :
+   Files on the drive through the FAT12/FAT16/FAT32 layer in source (Udisk_Lib/CH643UFI_Fat.c)
+ instead of the file library: UTF-8 long names, directories, listing, and whole sectors of a
+ file moved with one command per contiguous cluster run. The library still does the Bulk-Only
+ transport and readies the disk.
+  Sector reads and writes of the file library pass through a cache (Udisk_Lib/CH643UFI_Cache.c)
+ that reads ahead, keeps FAT and directory sectors and gathers writes; call CHRV3CacheFlush
+ after closing a written file. Set DEF_UDISK_CACHE_BENCH to measure it on a simulated disk.
+  USB transactions run from the USBFS interrupt (USBH_Lib/usb_host_xfer.c): a packet that completes
+starts the next one, a NAKed token is sent again on the next SOF, and the waiting code sleeps
+in WFI. Exam 20 prints the CPU busy share of its file read. DEF_USBH_XFER_EN 0 restores polling.
   Important: Only FAT12/FAT16/FAT32 formats are supported:
 */
 
@@ -65,6 +76,11 @@ int main(void)
     /* General USB Host UDisk Operation Initialization */
     Udisk_USBH_Initialization( );
 
+#if DEF_UDISK_CACHE_BENCH
+    /* Sector cache throughput on a simulated disk */
+    CHRV3CacheBench( );
+#endif
+
     while(1)
     {
 #if DEF_TEST_FUNC_NUM == DEF_TEST_FUNC_1
@@ -77,6 +93,8 @@ int main(void)
         UDisk_USBH_EnumFiles( );
 #elif DEF_TEST_FUNC_NUM == DEF_TEST_FUNC_13
         UDisk_USBH_Longname( );
+#elif DEF_TEST_FUNC_NUM == DEF_TEST_FUNC_20
+        UDisk_USBH_FatOperation( );
 #endif
     }
 }
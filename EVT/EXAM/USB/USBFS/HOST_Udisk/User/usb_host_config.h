@@ -23,6 +23,7 @@ extern "C" {
 #include "debug.h"
 #include <ch643_usb.h>
 #include <ch643_usbfs_host.h>
+#include "usb_host_xfer.h"
 
 /******************************************************************************/
 /* USB Host Communication Related Macro Definition */
@@ -0,0 +1,1732 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : ufat_sim.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : The FAT layer of Udisk_Lib built for the PC against a
+ *                      disk image in RAM.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * CH643UFI_Fat.c is compiled in as it is, with UFAT_DISK_READ/WRITE/SYNC
+ * pointed at a disk image in RAM that counts commands and sectors and
+ * fails on any access past its end. Images are formatted here, FAT12,
+ * FAT16 or FAT32, bare or behind an MBR.
+ * The checks do not trust the layer: Chk_Volume walks the image with its
+ * own FAT code and
+ *   - compares every FAT copy with the first one,
+ *   - follows every chain, reporting bad links, cross-linked and lost
+ *     clusters and chains not matching the file size,
+ *   - checks long name sets (order, checksum), "." and "..", duplicate
+ *     long and 8.3 names and the FAT32 FSInfo free count,
+ *   - lists every directory and file with its size and a hash of its data.
+ * Chk_Put writes files the same way, without the layer: fragmented chains,
+ * long names in UTF-16, a deleted entry, a volume label and a name too
+ * long for DEF_UFAT_LFN_CHARS.
+ *
+ * ufat_sim -t runs the self-tests:
+ *   - FAT12, FAT16 behind an MBR and FAT32 with 2, 4 and 1 sectors per
+ *     cluster: random create, write at random positions (in pieces, from
+ *     unaligned buffers), read, truncate, delete, mkdir, directory
+ *     listing, case-insensitive stat and remount, each compared with a
+ *     model in RAM. At every remount and at the end the image is checked
+ *     and its listing compared with the model.
+ *   - A small FAT12 volume written until it is full: ERR_DISK_FULL, the
+ *     bytes written so far kept, all space back after deleting.
+ *   - Files put on FAT16 and FAT32 images by Chk_Put listed and read back
+ *     through the layer.
+ * DEF_UFAT_RUN_NUM and DEF_UFAT_XFER_MAX can be given on the command line
+ * to run the self-tests with fewer runs or shorter transfers.
+ * Without -t, 1 MB is written in 64 KB pieces and read back in 64 KB, 4 KB
+ * and 512 byte pieces, and the READ(10)/WRITE(10) commands are counted.
+ *
+ * Build:
+ *   gcc -O2 -Wall -I../Udisk_Lib -I../HOST_Udisk/User -I../../../SRC/Core
+ *       -I../../../SRC/Debug -I../../../SRC/Peripheral/inc
+ *       -o ufat_sim ufat_sim.c
+ *
+ * Usage:
+ *   ufat_sim [-f 12|16|32] [-c sectors per cluster] | -t [-n ops] [-s seed]
+ *   -f  FAT type of the image of the command count, 16 by default
+ *   -c  sectors per cluster, 4 by default
+ *   -n  operations of each random self-test, 4000 by default
+ *   -s  seed of the random self-tests, 1 by default
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* Sector access of the layer */
+static uint8_t Sim_Read( uint32_t lba, uint8_t cnt, uint8_t *buf );
+static uint8_t Sim_Write( uint32_t lba, uint8_t cnt, uint8_t *buf );
+#define UFAT_DISK_READ( lba, cnt, buf )     Sim_Read( lba, cnt, buf )
+#define UFAT_DISK_WRITE( lba, cnt, buf )    Sim_Write( lba, cnt, buf )
+#define UFAT_DISK_SYNC( )                   ERR_SUCCESS
+
+/* The layer and the peripheral headers as they are, minus the RISC-V bits */
+#define interrupt( x )      unused
+#include "debug.h"
+#include "../Udisk_Lib/CH643UFI_Fat.c"
+
+/*******************************************************************************/
+/* Disk image */
+static uint8_t  *Sim_Disk;
+static uint32_t Sim_Sectors;
+static uint32_t Sim_Rd_Cmd, Sim_Rd_Sect, Sim_Wr_Cmd, Sim_Wr_Sect;
+
+/*********************************************************************
+ * @fn      Sim_Read
+ *
+ * @brief   READ(10) of cnt sectors from lba.
+ *
+ * @return  ERR_SUCCESS, exit on an access past the end of the disk
+ */
+static uint8_t Sim_Read( uint32_t lba, uint8_t cnt, uint8_t *buf )
+{
+    if( ( cnt == 0 ) || ( lba >= Sim_Sectors ) || ( cnt > Sim_Sectors - lba ) )
+    {
+        printf( "  read of %u sectors at %u, disk of %u\n", cnt, lba, Sim_Sectors );
+        exit( 1 );
+    }
+    Sim_Rd_Cmd++;
+    Sim_Rd_Sect += cnt;
+    memcpy( buf, &Sim_Disk[ (size_t)lba * 512 ], (size_t)cnt * 512 );
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Sim_Write
+ *
+ * @brief   WRITE(10) of cnt sectors to lba.
+ *
+ * @return  ERR_SUCCESS, exit on an access past the end of the disk
+ */
+static uint8_t Sim_Write( uint32_t lba, uint8_t cnt, uint8_t *buf )
+{
+    if( ( cnt == 0 ) || ( lba >= Sim_Sectors ) || ( cnt > Sim_Sectors - lba ) )
+    {
+        printf( "  write of %u sectors at %u, disk of %u\n", cnt, lba, Sim_Sectors );
+        exit( 1 );
+    }
+    Sim_Wr_Cmd++;
+    Sim_Wr_Sect += cnt;
+    memcpy( &Sim_Disk[ (size_t)lba * 512 ], buf, (size_t)cnt * 512 );
+    return ERR_SUCCESS;
+}
+
+static void Put16( uint8_t *p, uint16_t v )
+{
+    p[ 0 ] = (uint8_t)v;
+    p[ 1 ] = (uint8_t)( v >> 8 );
+}
+
+static void Put32( uint8_t *p, uint32_t v )
+{
+    Put16( p, (uint16_t)v );
+    Put16( p + 2, (uint16_t)( v >> 16 ) );
+}
+
+static uint16_t Get16( const uint8_t *p )
+{
+    return p[ 0 ] | ( p[ 1 ] << 8 );
+}
+
+static uint32_t Get32( const uint8_t *p )
+{
+    return Get16( p ) | ( (uint32_t)Get16( p + 2 ) << 16 );
+}
+
+/*********************************************************************
+ * @fn      Sim_Format
+ *
+ * @brief   Allocate and format a disk image.
+ *
+ * @param   mb - disk size in MB
+ *          fat - 12, 16 or 32
+ *          spc - sectors per cluster
+ *          mbr - 1 - volume in the first partition of an MBR at sector 2048
+ *
+ * @return  clusters of the volume
+ */
+static uint32_t Sim_Format( uint32_t mb, uint8_t fat, uint8_t spc, uint8_t mbr )
+{
+    uint32_t off = mbr ? 2048 : 0;
+    uint32_t n, rsvd, root_sect, fsz = 1, need, clus = 0, bytes;
+    uint8_t  *b, *p;
+    uint8_t  k;
+
+    free( Sim_Disk );
+    Sim_Sectors = mb * 2048;
+    Sim_Disk = calloc( Sim_Sectors, 512 );
+    n = Sim_Sectors - off;
+    rsvd = ( fat == 32 ) ? 32 : 1;
+    root_sect = ( fat == 32 ) ? 0 : 512 * 32 / 512;
+
+    /* FAT size: grow until it covers the clusters left beside it */
+    while( 1 )
+    {
+        clus = ( n - rsvd - 2 * fsz - root_sect ) / spc;
+        bytes = ( fat == 32 ) ? ( clus + 2 ) * 4 : ( fat == 16 ) ? ( clus + 2 ) * 2 : ( ( clus + 2 ) * 3 + 1 ) / 2;
+        need = ( bytes + 511 ) / 512;
+        if( need <= fsz )
+        {
+            break;
+        }
+        fsz = need;
+    }
+
+    b = &Sim_Disk[ (size_t)off * 512 ];
+    memcpy( b, "\xEB\x58\x90MSWIN4.1", 11 );
+    Put16( b + 11, 512 );
+    b[ 13 ] = spc;
+    Put16( b + 14, rsvd );
+    b[ 16 ] = 2;
+    Put16( b + 17, ( fat == 32 ) ? 0 : 512 );
+    Put16( b + 19, ( ( fat != 32 ) && ( n < 65536 ) ) ? n : 0 );
+    b[ 21 ] = 0xF8;
+    Put16( b + 22, ( fat == 32 ) ? 0 : fsz );
+    Put16( b + 24, 63 );
+    Put16( b + 26, 255 );
+    Put32( b + 28, off );
+    Put32( b + 32, ( ( fat == 32 ) || ( n >= 65536 ) ) ? n : 0 );
+    if( fat == 32 )
+    {
+        Put32( b + 36, fsz );
+        Put32( b + 44, 2 );
+        Put16( b + 48, 1 );
+        Put16( b + 50, 6 );
+        b[ 64 ] = 0x80;
+        b[ 66 ] = 0x29;
+        Put32( b + 67, 0x1234 );
+        memcpy( b + 71, "NO NAME    FAT32   ", 19 );
+    }
+    else
+    {
+        b[ 36 ] = 0x80;
+        b[ 38 ] = 0x29;
+        Put32( b + 39, 0x1234 );
+        memcpy( b + 43, ( fat == 16 ) ? "NO NAME    FAT16   " : "NO NAME    FAT12   ", 19 );
+    }
+    b[ 510 ] = 0x55;
+    b[ 511 ] = 0xAA;
+
+    if( fat == 32 )
+    {
+        p = b + 512;
+        Put32( p, 0x41615252 );
+        Put32( p + 484, 0x61417272 );
+        Put32( p + 488, 0xFFFFFFFF );
+        Put32( p + 492, 0xFFFFFFFF );
+        Put32( p + 508, 0xAA550000 );
+        memcpy( b + 6 * 512, b, 512 );
+    }
+
+    /* Media and end-of-chain entries, and the FAT32 root directory cluster */
+    for( k = 0; k < 2; k++ )
+    {
+        p = b + ( rsvd + k * fsz ) * 512;
+        if( fat == 32 )
+        {
+            Put32( p, 0x0FFFFFF8 );
+            Put32( p + 4, 0x0FFFFFFF );
+            Put32( p + 8, 0x0FFFFFFF );
+        }
+        else if( fat == 16 )
+        {
+            Put16( p, 0xFFF8 );
+            Put16( p + 2, 0xFFFF );
+        }
+        else
+        {
+            memcpy( p, "\xF8\xFF\xFF", 3 );
+        }
+    }
+
+    if( mbr )
+    {
+        p = &Sim_Disk[ 446 ];
+        p[ 4 ] = ( fat == 32 ) ? 0x0C : ( fat == 16 ) ? 0x06 : 0x01;
+        Put32( p + 8, off );
+        Put32( p + 12, n );
+        Sim_Disk[ 510 ] = 0x55;
+        Sim_Disk[ 511 ] = 0xAA;
+    }
+    return clus;
+}
+
+/*******************************************************************************/
+/* Independent checker */
+
+/* One directory or file found on the image */
+typedef struct _CHK_ENT
+{
+    char     Path[ 512 ];
+    uint32_t Size;
+    uint32_t Hash;
+    uint8_t  Dir;
+} CHK_ENT;
+
+#define CHK_ENT_MAX         256
+
+typedef struct _CHK_VOL
+{
+    uint8_t  Fat;                                                               // 12, 16, 32
+    uint8_t  Spc;
+    uint8_t  Num_Fats;
+    uint32_t Boot;
+    uint32_t Fat_Lba;
+    uint32_t Fat_Size;
+    uint32_t Root_Lba;
+    uint32_t Root_Sect;
+    uint32_t Root_Clus;
+    uint32_t Data_Lba;
+    uint32_t Clus;                                                              // Clusters, numbered from 2
+    uint32_t Fsi_Lba;
+} CHK_VOL;
+
+static CHK_VOL  Chk_Vol;
+static uint16_t *Chk_Owner;                                                     // Entry owning each cluster + 1, 0xFFFF - root
+static CHK_ENT  Chk_Ent[ CHK_ENT_MAX ];
+static int      Chk_Num;
+static int      Chk_Err;
+static uint32_t Chk_Free;
+
+static void Chk_Error( const char *fmt, ... )
+{
+    va_list ap;
+
+    if( Chk_Err++ < 10 )
+    {
+        printf( "  check: " );
+        va_start( ap, fmt );
+        vprintf( fmt, ap );
+        va_end( ap );
+        printf( "\n" );
+    }
+}
+
+static uint32_t Chk_Hash( uint32_t h, const uint8_t *p, uint32_t len )
+{
+    while( len-- )
+    {
+        h = ( h ^ *p++ ) * 0x01000193;
+    }
+    return h;
+}
+
+#define CHK_HASH_INIT       0x811C9DC5
+#define CHK_EOC             0x0FFFFFFF
+
+/*********************************************************************
+ * @fn      Chk_Fat_Get
+ *
+ * @brief   FAT entry of a cluster in the first FAT, end of chain as
+ *          CHK_EOC.
+ *
+ * @return  next cluster
+ */
+static uint32_t Chk_Fat_Get( uint32_t c )
+{
+    const uint8_t *f = &Sim_Disk[ (size_t)Chk_Vol.Fat_Lba * 512 ];
+    uint32_t v;
+
+    if( Chk_Vol.Fat == 12 )
+    {
+        v = Get16( f + c + c / 2 );
+        v = ( c & 1 ) ? ( v >> 4 ) : ( v & 0xFFF );
+        return ( v >= 0xFF8 ) ? CHK_EOC : v;
+    }
+    if( Chk_Vol.Fat == 16 )
+    {
+        v = Get16( f + c * 2 );
+        return ( v >= 0xFFF8 ) ? CHK_EOC : v;
+    }
+    v = Get32( f + c * 4 ) & 0x0FFFFFFF;
+    return ( v >= 0x0FFFFFF8 ) ? CHK_EOC : v;
+}
+
+/*********************************************************************
+ * @fn      Chk_Fat_Set
+ *
+ * @brief   Set a FAT entry in every FAT, for Chk_Put.
+ *
+ * @return  none
+ */
+static void Chk_Fat_Set( uint32_t c, uint32_t v )
+{
+    uint8_t *f;
+    uint8_t k;
+
+    for( k = 0; k < Chk_Vol.Num_Fats; k++ )
+    {
+        f = &Sim_Disk[ (size_t)( Chk_Vol.Fat_Lba + k * Chk_Vol.Fat_Size ) * 512 ];
+        if( Chk_Vol.Fat == 12 )
+        {
+            f += c + c / 2;
+            if( c & 1 )
+            {
+                f[ 0 ] = ( f[ 0 ] & 0x0F ) | (uint8_t)( ( v << 4 ) & 0xF0 );
+                f[ 1 ] = (uint8_t)( v >> 4 );
+            }
+            else
+            {
+                f[ 0 ] = (uint8_t)v;
+                f[ 1 ] = ( f[ 1 ] & 0xF0 ) | (uint8_t)( ( v >> 8 ) & 0x0F );
+            }
+        }
+        else if( Chk_Vol.Fat == 16 )
+        {
+            Put16( f + c * 2, (uint16_t)v );
+        }
+        else
+        {
+            Put32( f + c * 4, ( Get32( f + c * 4 ) & 0xF0000000 ) | ( v & 0x0FFFFFFF ) );
+        }
+    }
+}
+
+static uint8_t *Chk_Clus_Ptr( uint32_t c )
+{
+    return &Sim_Disk[ (size_t)( Chk_Vol.Data_Lba + ( c - 2 ) * Chk_Vol.Spc ) * 512 ];
+}
+
+/*********************************************************************
+ * @fn      Chk_Open
+ *
+ * @brief   Read the boot sector, through the MBR if there is one.
+ *
+ * @return  0 - usable volume
+ */
+static int Chk_Open( void )
+{
+    const uint8_t *b = Sim_Disk;
+    uint32_t tot, sys;
+
+    memset( &Chk_Vol, 0, sizeof( Chk_Vol ) );
+    if( !( ( ( b[ 0 ] == 0xEB ) || ( b[ 0 ] == 0xE9 ) ) && ( Get16( b + 11 ) == 512 ) ) )
+    {
+        Chk_Vol.Boot = Get32( b + 446 + 8 );
+        b = &Sim_Disk[ (size_t)Chk_Vol.Boot * 512 ];
+    }
+    Chk_Vol.Spc = b[ 13 ];
+    Chk_Vol.Num_Fats = b[ 16 ];
+    Chk_Vol.Root_Sect = ( Get16( b + 17 ) * 32 + 511 ) / 512;
+    tot = Get16( b + 19 ) ? Get16( b + 19 ) : Get32( b + 32 );
+    Chk_Vol.Fat_Size = Get16( b + 22 ) ? Get16( b + 22 ) : Get32( b + 36 );
+    Chk_Vol.Fat_Lba = Chk_Vol.Boot + Get16( b + 14 );
+    sys = Get16( b + 14 ) + Chk_Vol.Num_Fats * Chk_Vol.Fat_Size + Chk_Vol.Root_Sect;
+    if( ( Chk_Vol.Spc == 0 ) || ( Chk_Vol.Num_Fats == 0 ) || ( sys >= tot ) )
+    {
+        Chk_Error( "bad boot sector" );
+        return 1;
+    }
+    Chk_Vol.Clus = ( tot - sys ) / Chk_Vol.Spc;
+    Chk_Vol.Fat = ( Chk_Vol.Clus < 4085 ) ? 12 : ( Chk_Vol.Clus < 65525 ) ? 16 : 32;
+    Chk_Vol.Root_Lba = Chk_Vol.Fat_Lba + Chk_Vol.Num_Fats * Chk_Vol.Fat_Size;
+    Chk_Vol.Data_Lba = Chk_Vol.Boot + sys;
+    if( Chk_Vol.Fat == 32 )
+    {
+        Chk_Vol.Root_Clus = Get32( b + 44 );
+        Chk_Vol.Fsi_Lba = Chk_Vol.Boot + Get16( b + 48 );
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Chk_Chain
+ *
+ * @brief   Follow a chain, mark its clusters and gather its data.
+ *
+ * @param   c - first cluster
+ *          owner - entry index + 1, 0xFFFF - root directory
+ *          ppdata - data of the chain, malloc'ed, NULL - not wanted
+ *
+ * @return  clusters in the chain
+ */
+static uint32_t Chk_Chain( uint32_t c, uint16_t owner, const char *who, uint8_t **ppdata )
+{
+    uint32_t n = 0, csz = Chk_Vol.Spc * 512;
+    uint8_t *d = NULL;
+
+    while( c != CHK_EOC )
+    {
+        if( ( c < 2 ) || ( c >= Chk_Vol.Clus + 2 ) )
+        {
+            Chk_Error( "%s: bad link %x", who, c );
+            break;
+        }
+        if( Chk_Owner[ c ] )
+        {
+            Chk_Error( "%s: cluster %u cross-linked with %s", who, c,
+                       ( Chk_Owner[ c ] == 0xFFFF ) ? "/" : Chk_Ent[ Chk_Owner[ c ] - 1 ].Path );
+            break;
+        }
+        Chk_Owner[ c ] = owner;
+        if( ppdata )
+        {
+            d = realloc( d, ( n + 1 ) * csz );
+            memcpy( d + n * csz, Chk_Clus_Ptr( c ), csz );
+        }
+        n++;
+        c = Chk_Fat_Get( c );
+    }
+    if( ppdata )
+    {
+        *ppdata = d;
+    }
+    return n;
+}
+
+static uint8_t Chk_Sum( const uint8_t *sfn )
+{
+    uint8_t s = 0, i;
+
+    for( i = 0; i < 11; i++ )
+    {
+        s = (uint8_t)( ( ( s & 1 ) << 7 ) + ( s >> 1 ) + sfn[ i ] );
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      Chk_Utf8
+ *
+ * @brief   UTF-16 characters of a long name to UTF-8.
+ *
+ * @return  none
+ */
+static void Chk_Utf8( const uint16_t *pu, uint16_t n, char *out, size_t max )
+{
+    size_t o = 0;
+    uint16_t i, c;
+
+    for( i = 0; ( i < n ) && pu[ i ] && ( o + 4 < max ); i++ )
+    {
+        c = pu[ i ];
+        if( c < 0x80 )
+        {
+            out[ o++ ] = (char)c;
+        }
+        else if( c < 0x800 )
+        {
+            out[ o++ ] = (char)( 0xC0 | ( c >> 6 ) );
+            out[ o++ ] = (char)( 0x80 | ( c & 0x3F ) );
+        }
+        else
+        {
+            out[ o++ ] = (char)( 0xE0 | ( c >> 12 ) );
+            out[ o++ ] = (char)( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+            out[ o++ ] = (char)( 0x80 | ( c & 0x3F ) );
+        }
+    }
+    out[ o ] = 0;
+}
+
+/*********************************************************************
+ * @fn      Chk_Short
+ *
+ * @brief   8.3 name of an entry, with the NT lower-case bits applied.
+ *
+ * @return  none
+ */
+static void Chk_Short( const uint8_t *e, char *out )
+{
+    int i, o = 0;
+
+    for( i = 0; ( i < 8 ) && ( e[ i ] != ' ' ); i++ )
+    {
+        out[ o ] = (char)( ( ( i == 0 ) && ( e[ 0 ] == 0x05 ) ) ? 0xE5 : e[ i ] );
+        if( ( e[ 12 ] & 0x08 ) && ( out[ o ] >= 'A' ) && ( out[ o ] <= 'Z' ) )
+        {
+            out[ o ] += 'a' - 'A';
+        }
+        o++;
+    }
+    if( e[ 8 ] != ' ' )
+    {
+        out[ o++ ] = '.';
+        for( i = 8; ( i < 11 ) && ( e[ i ] != ' ' ); i++ )
+        {
+            out[ o ] = (char)e[ i ];
+            if( ( e[ 12 ] & 0x10 ) && ( out[ o ] >= 'A' ) && ( out[ o ] <= 'Z' ) )
+            {
+                out[ o ] += 'a' - 'A';
+            }
+            o++;
+        }
+    }
+    out[ o ] = 0;
+}
+
+static int Chk_Same_Nocase( const char *a, const char *b )
+{
+    for( ; *a && *b; a++, b++ )
+    {
+        if( ( ( *a >= 'a' ) && ( *a <= 'z' ) ? *a - 32 : *a ) != ( ( *b >= 'a' ) && ( *b <= 'z' ) ? *b - 32 : *b ) )
+        {
+            return 0;
+        }
+    }
+    return *a == *b;
+}
+
+/*********************************************************************
+ * @fn      Chk_Dir
+ *
+ * @brief   Check a directory and everything below it.
+ *
+ * @param   d - directory entries
+ *          len - bytes
+ *          path - path of the directory, "" for the root
+ *          self - its first cluster, 0 for the root
+ *          parent - first cluster of its parent, 0 for the root
+ *
+ * @return  none
+ */
+static void Chk_Dir( const uint8_t *d, uint32_t len, const char *path, uint32_t self, uint32_t parent )
+{
+    uint16_t lfn[ 20 * 13 ];
+    uint8_t  lfn_num = 0, lfn_next = 0, lfn_sum = 0;
+    char     sfn[ 13 ], name[ 256 ];
+    int      first = Chk_Num, k;
+    uint32_t i, c, size, n, csz = Chk_Vol.Spc * 512;
+    const uint8_t *e;
+    uint8_t  *data;
+    CHK_ENT  *pe;
+
+    for( i = 0; i + 32 <= len; i += 32 )
+    {
+        e = d + i;
+        if( e[ 0 ] == 0 )
+        {
+            break;
+        }
+        if( e[ 0 ] == 0xE5 )
+        {
+            lfn_num = 0;
+            continue;
+        }
+        if( ( e[ 11 ] & 0x3F ) == 0x0F )
+        {
+            if( e[ 0 ] & 0x40 )
+            {
+                lfn_num = e[ 0 ] & 0x3F;
+                lfn_next = lfn_num;
+                lfn_sum = e[ 13 ];
+                memset( lfn, 0, sizeof( lfn ) );
+                if( ( lfn_num == 0 ) || ( lfn_num > 20 ) )
+                {
+                    Chk_Error( "%s: long name of %d entries", path, lfn_num );
+                    lfn_num = 0;
+                    continue;
+                }
+            }
+            if( ( lfn_num == 0 ) || ( ( e[ 0 ] & 0x3F ) != lfn_next ) || ( e[ 13 ] != lfn_sum ) )
+            {
+                Chk_Error( "%s: long name entry out of order at %u", path, i / 32 );
+                lfn_num = 0;
+                continue;
+            }
+            {
+                static const uint8_t ofs[ 13 ] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+                for( k = 0; k < 13; k++ )
+                {
+                    lfn[ ( lfn_next - 1 ) * 13 + k ] = Get16( e + ofs[ k ] );
+                }
+            }
+            lfn_next--;
+            continue;
+        }
+        if( e[ 11 ] & 0x08 )
+        {
+            lfn_num = 0;
+            continue;
+        }
+
+        Chk_Short( e, sfn );
+        strcpy( name, sfn );
+        if( lfn_num )
+        {
+            if( ( lfn_next != 0 ) || ( Chk_Sum( e ) != lfn_sum ) )
+            {
+                Chk_Error( "%s: long name does not belong to %s", path, sfn );
+            }
+            else
+            {
+                Chk_Utf8( lfn, lfn_num * 13, name, sizeof( name ) );
+            }
+            lfn_num = 0;
+        }
+        c = Get16( e + 26 ) | ( ( Chk_Vol.Fat == 32 ) ? (uint32_t)Get16( e + 20 ) << 16 : 0 );
+        size = Get32( e + 28 );
+
+        if( !strcmp( sfn, "." ) || !strcmp( sfn, ".." ) )
+        {
+            if( c != ( ( sfn[ 1 ] == 0 ) ? self : parent ) )
+            {
+                Chk_Error( "%s: %s points to %u, not %u", path, sfn, c, ( sfn[ 1 ] == 0 ) ? self : parent );
+            }
+            continue;
+        }
+        for( k = first; k < Chk_Num; k++ )
+        {
+            const char *q = strrchr( Chk_Ent[ k ].Path, '/' ) + 1;
+            if( Chk_Same_Nocase( q, name ) )
+            {
+                Chk_Error( "%s: %s twice", path, name );
+            }
+        }
+        if( Chk_Num >= CHK_ENT_MAX )
+        {
+            Chk_Error( "too many entries" );
+            return;
+        }
+        pe = &Chk_Ent[ Chk_Num++ ];
+        snprintf( pe->Path, sizeof( pe->Path ), "%s/%s", path, name );
+        pe->Dir = ( e[ 11 ] & 0x10 ) ? 1 : 0;
+        pe->Size = pe->Dir ? 0 : size;
+        n = c ? Chk_Chain( c, (uint16_t)( pe - Chk_Ent + 1 ), pe->Path, &data ) : ( data = NULL, 0 );
+        if( pe->Dir )
+        {
+            pe->Hash = 0;
+            if( n == 0 )
+            {
+                Chk_Error( "%s: directory without a cluster", pe->Path );
+            }
+            else
+            {
+                char sub[ 512 ];
+                strcpy( sub, pe->Path );
+                Chk_Dir( data, n * csz, sub, c, self );
+            }
+        }
+        else
+        {
+            if( n != ( size + csz - 1 ) / csz )
+            {
+                Chk_Error( "%s: %u clusters for %u bytes", pe->Path, n, size );
+            }
+            pe->Hash = Chk_Hash( CHK_HASH_INIT, data, ( size < n * csz ) ? size : n * csz );
+        }
+        free( data );
+    }
+}
+
+/*********************************************************************
+ * @fn      Chk_Volume
+ *
+ * @brief   Check the whole image and list what it holds in Chk_Ent.
+ *
+ * @return  errors found
+ */
+static int Chk_Volume( void )
+{
+    uint32_t c, n, fsi;
+    uint8_t  *data, k;
+
+    Chk_Err = 0;
+    Chk_Num = 0;
+    if( Chk_Open( ) )
+    {
+        return Chk_Err;
+    }
+    for( k = 1; k < Chk_Vol.Num_Fats; k++ )
+    {
+        if( memcmp( &Sim_Disk[ (size_t)Chk_Vol.Fat_Lba * 512 ],
+                    &Sim_Disk[ (size_t)( Chk_Vol.Fat_Lba + k * Chk_Vol.Fat_Size ) * 512 ], (size_t)Chk_Vol.Fat_Size * 512 ) )
+        {
+            Chk_Error( "FAT copy %d differs", k );
+        }
+    }
+    Chk_Owner = calloc( Chk_Vol.Clus + 2, sizeof( uint16_t ) );
+    if( Chk_Vol.Fat == 32 )
+    {
+        n = Chk_Chain( Chk_Vol.Root_Clus, 0xFFFF, "/", &data );
+        Chk_Dir( data, n * Chk_Vol.Spc * 512, "", 0, 0 );
+        free( data );
+    }
+    else
+    {
+        Chk_Dir( &Sim_Disk[ (size_t)Chk_Vol.Root_Lba * 512 ], Chk_Vol.Root_Sect * 512, "", 0, 0 );
+    }
+
+    Chk_Free = 0;
+    for( c = 2; c < Chk_Vol.Clus + 2; c++ )
+    {
+        if( Chk_Fat_Get( c ) == 0 )
+        {
+            Chk_Free++;
+        }
+        else if( Chk_Owner[ c ] == 0 )
+        {
+            Chk_Error( "cluster %u lost", c );
+        }
+    }
+    if( Chk_Vol.Fsi_Lba )
+    {
+        fsi = Get32( &Sim_Disk[ (size_t)Chk_Vol.Fsi_Lba * 512 + 488 ] );
+        if( ( fsi != 0xFFFFFFFF ) && ( fsi != Chk_Free ) )
+        {
+            Chk_Error( "FSInfo counts %u free clusters, the FAT %u", fsi, Chk_Free );
+        }
+    }
+    free( Chk_Owner );
+    return Chk_Err;
+}
+
+/*********************************************************************
+ * @fn      Chk_Put
+ *
+ * @brief   Put a file in the root directory without the layer: clusters
+ *          from the free list, in order or picked at random, a long name
+ *          unless the name is the 8.3 name.
+ *
+ * @param   name - UTF-8 name, ASCII and two-byte sequences
+ *          sfn - 8.3 name as stored, 11 bytes
+ *          data - contents
+ *          len - length
+ *          frag - 1 - scatter the clusters
+ *          pdir - root directory entries, advanced
+ *
+ * @return  none
+ */
+static void Chk_Put( const char *name, const char *sfn, const uint8_t *data, uint32_t len, uint8_t frag, uint8_t **pdir )
+{
+    static const uint8_t ofs[ 13 ] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+    uint16_t u[ 20 * 13 ];
+    uint32_t csz = Chk_Vol.Spc * 512, n = ( len + csz - 1 ) / csz, i, c, prev = 0, first = 0;
+    uint16_t nu = 0;
+    uint8_t  nl, k, *e, tmp[ 32 ] = { 0 };
+    char     disp[ 13 ];
+    const uint8_t *p;
+
+    for( i = 0; i < n; i++ )
+    {
+        do
+        {
+            c = frag ? 3 + rand( ) % ( Chk_Vol.Clus - 1 ) : 3;
+            while( Chk_Fat_Get( c ) != 0 )
+            {
+                c = ( c + 1 < Chk_Vol.Clus + 2 ) ? c + 1 : 3;
+            }
+        } while( 0 );
+        Chk_Fat_Set( c, CHK_EOC );
+        if( prev )
+        {
+            Chk_Fat_Set( prev, c );
+        }
+        else
+        {
+            first = c;
+        }
+        memcpy( Chk_Clus_Ptr( c ), data + i * csz, ( len - i * csz < csz ) ? len - i * csz : csz );
+        prev = c;
+    }
+
+    /* UTF-8 to UTF-16 */
+    for( p = (const uint8_t *)name; *p; )
+    {
+        if( *p < 0x80 )
+        {
+            u[ nu++ ] = *p++;
+        }
+        else
+        {
+            u[ nu++ ] = ( ( p[ 0 ] & 0x1F ) << 6 ) | ( p[ 1 ] & 0x3F );
+            p += 2;
+        }
+    }
+    memcpy( tmp, sfn, 11 );
+    Chk_Short( tmp, disp );
+    if( strcmp( name, disp ) )
+    {
+        nl = ( nu + 12 ) / 13;
+        u[ nu ] = 0;
+        for( i = nu + 1; i < nl * 13; i++ )
+        {
+            u[ i ] = 0xFFFF;
+        }
+        for( k = nl; k >= 1; k-- )
+        {
+            e = *pdir;
+            *pdir += 32;
+            memset( e, 0, 32 );
+            e[ 0 ] = k | ( ( k == nl ) ? 0x40 : 0 );
+            e[ 11 ] = 0x0F;
+            e[ 13 ] = Chk_Sum( (const uint8_t *)sfn );
+            for( i = 0; i < 13; i++ )
+            {
+                Put16( e + ofs[ i ], u[ ( k - 1 ) * 13 + i ] );
+            }
+        }
+    }
+    e = *pdir;
+    *pdir += 32;
+    memset( e, 0, 32 );
+    memcpy( e, sfn, 11 );
+    e[ 11 ] = 0x20;
+    Put16( e + 20, (uint16_t)( first >> 16 ) );
+    Put16( e + 26, (uint16_t)first );
+    Put32( e + 28, len );
+}
+
+/*******************************************************************************/
+/* Model of what the volume should hold */
+#define MOD_FILE_NUM        48
+#define MOD_DIR_NUM         5
+
+typedef struct _MOD_FILE
+{
+    char     Path[ 200 ];
+    uint8_t  *Data;
+    uint32_t Size;
+    uint8_t  Used;
+} MOD_FILE;
+
+static MOD_FILE Mod_File[ MOD_FILE_NUM ];
+static const char *Mod_Dir[ MOD_DIR_NUM ] = { "", "/Sub dir", "/DIR2", "/Sub dir/Nested \xC3\x9Cn\xC3\xAF", "/d3" };
+static int Mod_Dir_Num;
+static uint32_t Mod_Max;                                                        // Largest file
+
+static void Sim_Fail( const char *what, int op, uint8_t s )
+{
+    printf( "  %s failed at operation %d, status %02x\n", what, op, s );
+    exit( 1 );
+}
+
+static int Chk_Ent_Cmp( const void *a, const void *b )
+{
+    return strcmp( ( (const CHK_ENT *)a )->Path, ( (const CHK_ENT *)b )->Path );
+}
+
+/*********************************************************************
+ * @fn      Mod_Compare
+ *
+ * @brief   Check the image and compare its listing with the model.
+ *
+ * @return  0 - same
+ */
+static int Mod_Compare( void )
+{
+    static CHK_ENT m[ CHK_ENT_MAX ];
+    int n = 0, i, bad = 0;
+
+    if( Chk_Volume( ) )
+    {
+        return 1;
+    }
+    for( i = 1; i < Mod_Dir_Num; i++ )
+    {
+        memset( &m[ n ], 0, sizeof( m[ n ] ) );
+        strcpy( m[ n ].Path, Mod_Dir[ i ] );
+        m[ n++ ].Dir = 1;
+    }
+    for( i = 0; i < MOD_FILE_NUM; i++ )
+    {
+        if( Mod_File[ i ].Used )
+        {
+            strcpy( m[ n ].Path, Mod_File[ i ].Path );
+            m[ n ].Size = Mod_File[ i ].Size;
+            m[ n ].Hash = Chk_Hash( CHK_HASH_INIT, Mod_File[ i ].Data, Mod_File[ i ].Size );
+            m[ n++ ].Dir = 0;
+        }
+    }
+    qsort( m, n, sizeof( m[ 0 ] ), Chk_Ent_Cmp );
+    qsort( Chk_Ent, Chk_Num, sizeof( Chk_Ent[ 0 ] ), Chk_Ent_Cmp );
+    if( n != Chk_Num )
+    {
+        printf( "  image holds %d entries, the model %d\n", Chk_Num, n );
+        bad = 1;
+    }
+    for( i = 0; ( i < n ) && ( i < Chk_Num ); i++ )
+    {
+        if( strcmp( m[ i ].Path, Chk_Ent[ i ].Path ) || ( m[ i ].Dir != Chk_Ent[ i ].Dir ) ||
+            ( m[ i ].Size != Chk_Ent[ i ].Size ) || ( m[ i ].Hash != Chk_Ent[ i ].Hash ) )
+        {
+            printf( "  image: %s %u %08x, model: %s %u %08x\n", Chk_Ent[ i ].Path, Chk_Ent[ i ].Size,
+                    Chk_Ent[ i ].Hash, m[ i ].Path, m[ i ].Size, m[ i ].Hash );
+            bad = 1;
+            break;
+        }
+    }
+    return bad;
+}
+
+static void Mod_Name( char *out, int i )
+{
+    const char *d = Mod_Dir[ rand( ) % Mod_Dir_Num ];
+
+    switch( rand( ) % 6 )
+    {
+        case 0:
+            sprintf( out, "%s/readme%d.txt", d, i );
+            break;
+        case 1:
+            sprintf( out, "%s/FILE%d.BIN", d, i );
+            break;
+        case 2:
+            sprintf( out, "%s/Long file name number %d.data", d, i );
+            break;
+        case 3:
+            sprintf( out, "%s/\xC3\x84rger-%d-\xE6\x97\xA5\xE6\x9C\xAC.txt", d, i );
+            break;
+        case 4:
+            sprintf( out, "%s/mixedCase%d.c", d, i );
+            break;
+        default:
+            sprintf( out, "%s/a.b.c %d", d, i );
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      Mod_Run
+ *
+ * @brief   Random operations on the mounted volume, each checked
+ *          against the model.
+ *
+ * @param   ops - operations
+ *          full - 1 - writes may run out of space
+ *
+ * @return  none, exit on a failure
+ */
+static void Mod_Run( int ops, uint8_t full )
+{
+    static uint8_t wbuf[ 300000 + 4 ] __attribute__( ( aligned( 4 ) ) );
+    static uint8_t rbuf[ 300000 + 4 ] __attribute__( ( aligned( 4 ) ) );
+    UFAT_FILE f;
+    UFAT_DIR  dir;
+    UFAT_INFO inf;
+    MOD_FILE  *m;
+    char      path[ 256 ], *q;
+    uint32_t  n, pos, len, done, chunk, exp, sect;
+    uint8_t   s, off;
+    int       op, r, i, d, cnt;
+
+    for( op = 0; op < ops; op++ )
+    {
+        r = rand( ) % 100;
+        m = &Mod_File[ rand( ) % MOD_FILE_NUM ];
+        if( ( r < 3 ) && ( Mod_Dir_Num < MOD_DIR_NUM ) )
+        {
+            s = UFAT_Mkdir( Mod_Dir[ Mod_Dir_Num ] );
+            if( s )
+            {
+                Sim_Fail( "mkdir", op, s );
+            }
+            Mod_Dir_Num++;
+        }
+        else if( r < 30 )
+        {
+            /* Write at a random position, or append */
+            if( !m->Used )
+            {
+                Mod_Name( m->Path, (int)( m - Mod_File ) );
+                s = UFAT_Open( &f, m->Path, UFAT_CREATE | UFAT_READ );
+                if( full && ( ( s == ERR_DISK_FULL ) || ( s == ERR_FDT_OVER ) ) )
+                {
+                    continue;
+                }
+                if( s )
+                {
+                    Sim_Fail( "create", op, s );
+                }
+                m->Used = 1;
+                m->Size = 0;
+                m->Data = malloc( Mod_Max + 1 );
+            }
+            else
+            {
+                s = UFAT_Open( &f, m->Path, UFAT_WRITE | UFAT_READ );
+                if( s )
+                {
+                    Sim_Fail( "open for writing", op, s );
+                }
+            }
+            pos = ( ( rand( ) % 2 ) || ( m->Size == 0 ) ) ? m->Size : rand( ) % ( m->Size + 1 );
+            len = rand( ) % ( ( rand( ) % 4 ) ? 4000 : Mod_Max / 4 + 1 );
+            len = ( pos + len > Mod_Max ) ? Mod_Max - pos : len;
+            off = rand( ) % 2;
+            for( i = 0; i < (int)len; i++ )
+            {
+                wbuf[ off + i ] = (uint8_t)rand( );
+            }
+            s = UFAT_Seek( &f, pos );
+            if( s )
+            {
+                Sim_Fail( "seek", op, s );
+            }
+            if( rand( ) % 3 == 0 )
+            {
+                for( done = 0, s = 0; ( done < len ) && ( s == 0 ); done += n )
+                {
+                    chunk = 1 + rand( ) % 1500;
+                    chunk = ( chunk > len - done ) ? len - done : chunk;
+                    s = UFAT_Write( &f, &wbuf[ off + done ], chunk, &n );
+                }
+                n = done;
+            }
+            else
+            {
+                s = UFAT_Write( &f, &wbuf[ off ], len, &n );
+            }
+            if( s && !( full && ( s == ERR_DISK_FULL ) ) )
+            {
+                Sim_Fail( "write", op, s );
+            }
+            if( ( s == 0 ) && ( n != len ) )
+            {
+                Sim_Fail( "write length", op, 0 );
+            }
+            memcpy( m->Data + pos, &wbuf[ off ], n );
+            m->Size = ( pos + n > m->Size ) ? pos + n : m->Size;
+            if( rand( ) % 4 == 0 )
+            {
+                s = UFAT_Truncate( &f );
+                if( s )
+                {
+                    Sim_Fail( "truncate", op, s );
+                }
+                m->Size = pos + n;
+            }
+            s = UFAT_Close( &f );
+            if( s )
+            {
+                Sim_Fail( "close", op, s );
+            }
+        }
+        else if( r < 65 )
+        {
+            /* Read from a random position into a buffer that may be unaligned */
+            if( !m->Used )
+            {
+                continue;
+            }
+            s = UFAT_Open( &f, m->Path, UFAT_READ );
+            if( s )
+            {
+                Sim_Fail( "open for reading", op, s );
+            }
+            pos = rand( ) % ( m->Size + 1 );
+            len = rand( ) % ( Mod_Max / 2 + 1 );
+            off = rand( ) % 4 == 0;
+            exp = ( pos + len > m->Size ) ? m->Size - pos : len;
+            s = UFAT_Seek( &f, pos );
+            if( s == 0 )
+            {
+                s = UFAT_Read( &f, &rbuf[ off ], len, &n );
+            }
+            if( s )
+            {
+                Sim_Fail( "read", op, s );
+            }
+            if( ( n != exp ) || memcmp( &rbuf[ off ], m->Data + pos, n ) )
+            {
+                printf( "  %s: %u bytes at %u read as %u bytes\n", m->Path, len, pos, n );
+                Sim_Fail( "read compare", op, 0 );
+            }
+            UFAT_Close( &f );
+        }
+        else if( r < 72 )
+        {
+            if( !m->Used )
+            {
+                continue;
+            }
+            s = UFAT_Delete( m->Path );
+            if( s )
+            {
+                Sim_Fail( "delete", op, s );
+            }
+            free( m->Data );
+            m->Used = 0;
+            s = UFAT_Open( &f, m->Path, UFAT_READ );
+            if( s != ERR_MISS_FILE )
+            {
+                Sim_Fail( "open of a deleted file", op, s );
+            }
+        }
+        else if( r < 76 )
+        {
+            if( !m->Used )
+            {
+                continue;
+            }
+            s = UFAT_Open( &f, m->Path, UFAT_TRUNC );
+            if( s )
+            {
+                Sim_Fail( "open to truncate", op, s );
+            }
+            m->Size = 0;
+            UFAT_Close( &f );
+        }
+        else if( r < 80 )
+        {
+            /* Listing: every file of the model in the directory, with its size */
+            d = rand( ) % Mod_Dir_Num;
+            cnt = 0;
+            s = UFAT_OpenDir( &dir, Mod_Dir[ d ][ 0 ] ? Mod_Dir[ d ] : "/" );
+            if( s )
+            {
+                Sim_Fail( "opendir", op, s );
+            }
+            while( ( s = UFAT_ReadDir( &dir, &inf ) ) == ERR_SUCCESS )
+            {
+                if( inf.Attr & ATTR_DIRECTORY )
+                {
+                    continue;
+                }
+                snprintf( path, sizeof( path ), "%s/%s", Mod_Dir[ d ], inf.Name );
+                for( i = 0; i < MOD_FILE_NUM; i++ )
+                {
+                    if( Mod_File[ i ].Used && !strcmp( Mod_File[ i ].Path, path ) )
+                    {
+                        break;
+                    }
+                }
+                if( ( i == MOD_FILE_NUM ) || ( Mod_File[ i ].Size != inf.Size ) )
+                {
+                    printf( "  listed %s, %u bytes\n", path, inf.Size );
+                    Sim_Fail( "listing", op, 0 );
+                }
+                cnt++;
+            }
+            if( s != ERR_MISS_FILE )
+            {
+                Sim_Fail( "readdir", op, s );
+            }
+            for( i = 0; i < MOD_FILE_NUM; i++ )
+            {
+                q = strrchr( Mod_File[ i ].Path, '/' );
+                if( Mod_File[ i ].Used && ( q - Mod_File[ i ].Path == (int)strlen( Mod_Dir[ d ] ) ) &&
+                    !strncmp( Mod_File[ i ].Path, Mod_Dir[ d ], q - Mod_File[ i ].Path ) )
+                {
+                    cnt--;
+                }
+            }
+            if( cnt )
+            {
+                Sim_Fail( "listing count", op, 0 );
+            }
+        }
+        else if( r < 82 )
+        {
+            /* Remount, with the image checked in between */
+            s = UFAT_Unmount( );
+            if( s )
+            {
+                Sim_Fail( "unmount", op, s );
+            }
+            if( Mod_Compare( ) )
+            {
+                Sim_Fail( "image check", op, 0 );
+            }
+            s = UFAT_Mount( );
+            if( s )
+            {
+                Sim_Fail( "mount", op, s );
+            }
+            s = UFAT_Free( &sect );
+            if( s || ( sect != Chk_Free * Chk_Vol.Spc ) )
+            {
+                printf( "  %u sectors free, the FAT has %u\n", sect, Chk_Free * Chk_Vol.Spc );
+                Sim_Fail( "free space", op, s );
+            }
+        }
+        else if( r < 86 )
+        {
+            /* Lookup with the case of every letter swapped */
+            if( !m->Used )
+            {
+                continue;
+            }
+            strcpy( path, m->Path );
+            for( q = path; *q; q++ )
+            {
+                *q = ( ( *q >= 'a' ) && ( *q <= 'z' ) ) ? *q - 32 : ( ( *q >= 'A' ) && ( *q <= 'Z' ) ) ? *q + 32 : *q;
+            }
+            s = UFAT_Stat( path, &inf );
+            if( s || ( inf.Size != m->Size ) )
+            {
+                printf( "  %s\n", path );
+                Sim_Fail( "stat", op, s );
+            }
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Model
+ *
+ * @brief   Random operations on a fresh volume.
+ *
+ * @return  0 - passed
+ */
+static int Sim_Test_Model( uint32_t mb, uint8_t fat, uint8_t spc, uint8_t mbr, int ops )
+{
+    uint8_t s;
+
+    Sim_Format( mb, fat, spc, mbr );
+    Mod_Dir_Num = 1;
+    Mod_Max = 120000;
+    s = UFAT_Mount( );
+    if( s )
+    {
+        Sim_Fail( "mount", 0, s );
+    }
+    if( UFAT_Vol.Type != ( ( fat == 12 ) ? DISK_FAT12 : ( fat == 16 ) ? DISK_FAT16 : DISK_FAT32 ) )
+    {
+        Sim_Fail( "FAT type", 0, UFAT_Vol.Type );
+    }
+    Mod_Run( ops, 0 );
+    s = UFAT_Unmount( );
+    if( s )
+    {
+        Sim_Fail( "unmount", ops, s );
+    }
+    printf( "  %u READ(10), %u WRITE(10)\n", Sim_Rd_Cmd, Sim_Wr_Cmd );
+    return Mod_Compare( );
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Full
+ *
+ * @brief   Fill a small volume, check that what fitted was kept, then
+ *          delete everything and check that all space is back.
+ *
+ * @return  0 - passed
+ */
+static int Sim_Test_Full( int ops )
+{
+    static uint8_t wbuf[ 64000 ];
+    UFAT_FILE f;
+    MOD_FILE  *m;
+    uint32_t  clus, sect0, sect, n, j;
+    uint8_t   s = ERR_SUCCESS;
+    int i;
+
+    clus = Sim_Format( 1, 12, 1, 0 );
+    Mod_Dir_Num = 1;
+    Mod_Max = 200000;
+    if( UFAT_Mount( ) || UFAT_Free( &sect0 ) )
+    {
+        Sim_Fail( "mount", 0, 0 );
+    }
+    printf( "  %u clusters\n", clus );
+    Mod_Run( ops, 1 );
+
+    /* Then append to the files in turn until the volume is full */
+    for( i = 0; s != ERR_DISK_FULL; i = ( i + 1 ) % MOD_FILE_NUM )
+    {
+        m = &Mod_File[ i ];
+        if( !m->Used )
+        {
+            Mod_Name( m->Path, i );
+            s = UFAT_Open( &f, m->Path, UFAT_CREATE );
+            if( ( s == ERR_DISK_FULL ) || ( s == ERR_FDT_OVER ) )
+            {
+                break;
+            }
+            if( s )
+            {
+                Sim_Fail( "create", i, s );
+            }
+            m->Used = 1;
+            m->Size = 0;
+            m->Data = malloc( Mod_Max + 1 );
+        }
+        else if( ( s = UFAT_Open( &f, m->Path, UFAT_APPEND ) ) != ERR_SUCCESS )
+        {
+            Sim_Fail( "open to append", i, s );
+        }
+        n = rand( ) % sizeof( wbuf );
+        n = ( m->Size + n > Mod_Max ) ? Mod_Max - m->Size : n;
+        for( j = 0; j < n; j++ )
+        {
+            wbuf[ j ] = (uint8_t)rand( );
+        }
+        s = UFAT_Write( &f, wbuf, n, &n );
+        if( s && ( s != ERR_DISK_FULL ) )
+        {
+            Sim_Fail( "write", i, s );
+        }
+        memcpy( m->Data + m->Size, wbuf, n );
+        m->Size += n;
+        if( UFAT_Close( &f ) )
+        {
+            Sim_Fail( "close", i, 0 );
+        }
+    }
+    if( UFAT_Free( &sect ) )
+    {
+        Sim_Fail( "free", 0, 0 );
+    }
+    printf( "  %u sectors free when full\n", sect );
+    if( sect != 0 )
+    {
+        return 1;
+    }
+    if( UFAT_Unmount( ) || Mod_Compare( ) || UFAT_Mount( ) )
+    {
+        return 1;
+    }
+    for( i = 0; i < MOD_FILE_NUM; i++ )
+    {
+        if( Mod_File[ i ].Used )
+        {
+            s = UFAT_Delete( Mod_File[ i ].Path );
+            if( s )
+            {
+                Sim_Fail( "delete", i, s );
+            }
+            free( Mod_File[ i ].Data );
+            Mod_File[ i ].Used = 0;
+        }
+    }
+    if( UFAT_Free( &sect ) || UFAT_Unmount( ) || Mod_Compare( ) )
+    {
+        return 1;
+    }
+    /* Only the directories made by the run are left, the checker found no lost clusters */
+    if( sect != Chk_Free )
+    {
+        printf( "  %u sectors free after deleting everything, the FAT has %u\n", sect, Chk_Free );
+        return 1;
+    }
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Foreign
+ *
+ * @brief   Files put on the image by Chk_Put, listed and read back
+ *          through the layer in random pieces.
+ *
+ * @return  0 - passed
+ */
+static int Sim_Test_Foreign( uint32_t mb, uint8_t fat, uint8_t spc )
+{
+    static const struct
+    {
+        const char *Name;
+        const char *Listed;                                                     // NULL - same as Name
+        const char *Sfn;
+        uint32_t   Len;
+        uint8_t    Frag;
+    } file[ ] =
+    {
+        { "Contiguous file.bin", NULL, "CONTIG~1BIN", 70000, 0 },
+        { "Fragmented file with a long name.dat", NULL, "FRAGME~1DAT", 90001, 1 },
+        { "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 \xD0\xBC\xD0\xB8\xD1\x80.txt", NULL, "__~1    TXT", 1234, 1 },
+        { "SHORT.TXT", NULL, "SHORT   TXT", 700, 1 },
+        { "empty file", NULL, "EMPTYF~1   ", 0, 0 },
+        { "A name that is far too long to be kept in the small buffer of the layer, so it falls back.txt",
+          "ANAMET~1.TXT", "ANAMET~1TXT", 513, 1 },
+    };
+    static uint8_t buf[ 100000 ] __attribute__( ( aligned( 4 ) ) );
+    uint8_t  *data[ 6 ], *dir, *p;
+    uint32_t hash[ 6 ], h, tot, n, want, i, j, c, root_clus;
+    UFAT_DIR  d;
+    UFAT_INFO inf;
+    UFAT_FILE f;
+    char      path[ 128 ];
+    int       found = 0, bad = 0;
+
+    Sim_Format( mb, fat, spc, 0 );
+    Chk_Open( );
+
+    /* FAT32: a root directory of enough clusters for the entries below */
+    if( fat == 32 )
+    {
+        root_clus = ( 64 * 32 + spc * 512 - 1 ) / ( spc * 512 );
+        for( c = 2; c < 2 + root_clus; c++ )
+        {
+            Chk_Fat_Set( c, ( c + 1 < 2 + root_clus ) ? c + 1 : CHK_EOC );
+        }
+        dir = Chk_Clus_Ptr( 2 );
+    }
+    else
+    {
+        dir = &Sim_Disk[ (size_t)Chk_Vol.Root_Lba * 512 ];
+    }
+
+    /* A volume label and a deleted entry first */
+    memcpy( dir, "MYDISK     ", 11 );
+    dir[ 11 ] = 0x08;
+    dir += 32;
+    memcpy( dir, "\xE5" "ELETED TXT", 11 );
+    dir[ 11 ] = 0x20;
+    dir += 32;
+    for( i = 0; i < 6; i++ )
+    {
+        data[ i ] = malloc( file[ i ].Len + 1 );
+        for( j = 0; j < file[ i ].Len; j++ )
+        {
+            data[ i ][ j ] = (uint8_t)rand( );
+        }
+        hash[ i ] = Chk_Hash( CHK_HASH_INIT, data[ i ], file[ i ].Len );
+        Chk_Put( file[ i ].Name, file[ i ].Sfn, data[ i ], file[ i ].Len, file[ i ].Frag, &dir );
+    }
+    if( Chk_Volume( ) || ( Chk_Num != 6 ) )
+    {
+        printf( "  Chk_Put left a broken volume\n" );
+        return 1;
+    }
+
+    if( UFAT_Mount( ) || UFAT_OpenDir( &d, "/" ) )
+    {
+        Sim_Fail( "mount", 0, 0 );
+    }
+    while( UFAT_ReadDir( &d, &inf ) == ERR_SUCCESS )
+    {
+        for( i = 0; i < 6; i++ )
+        {
+            if( !strcmp( inf.Name, file[ i ].Listed ? file[ i ].Listed : file[ i ].Name ) )
+            {
+                break;
+            }
+        }
+        if( i == 6 )
+        {
+            printf( "  unknown entry %s\n", inf.Name );
+            bad = 1;
+            continue;
+        }
+        snprintf( path, sizeof( path ), "/%s", inf.Name );
+        if( UFAT_Open( &f, path, UFAT_READ ) )
+        {
+            printf( "  %s does not open\n", path );
+            bad = 1;
+            continue;
+        }
+        Sim_Rd_Cmd = 0;
+        tot = 0;
+        h = CHK_HASH_INIT;
+        do
+        {
+            want = 1 + rand( ) % 20000;
+            p = &buf[ rand( ) % 2 ];
+            if( UFAT_Read( &f, p, want, &n ) )
+            {
+                printf( "  %s: read error\n", path );
+                bad = 1;
+                break;
+            }
+            h = Chk_Hash( h, p, n );
+            tot += n;
+        } while( n );
+        UFAT_Close( &f );
+        if( ( tot != file[ i ].Len ) || ( h != hash[ i ] ) || ( inf.Size != file[ i ].Len ) )
+        {
+            printf( "  %s: %u bytes read, %u expected\n", path, tot, file[ i ].Len );
+            bad = 1;
+        }
+        printf( "  %-40.40s %6u bytes, %3u READ(10)\n", inf.Name, tot, Sim_Rd_Cmd );
+        found++;
+    }
+    UFAT_Unmount( );
+    for( i = 0; i < 6; i++ )
+    {
+        free( data[ i ] );
+    }
+    if( found != 6 )
+    {
+        printf( "  %d of 6 files listed\n", found );
+        bad = 1;
+    }
+    return bad;
+}
+
+/*********************************************************************
+ * @fn      Sim_Test_Run
+ *
+ * @brief   Run one self-test case.
+ *
+ * @return  0 - passed
+ */
+static int Sim_Test_Run( int idx, int ops )
+{
+    switch( idx )
+    {
+        case 0:
+            return Sim_Test_Model( 2, 12, 2, 0, ops );
+        case 1:
+            return Sim_Test_Model( 16, 16, 4, 1, ops );
+        case 2:
+            return Sim_Test_Model( 40, 32, 1, 0, ops );
+        case 3:
+            return Sim_Test_Full( ops );
+        case 4:
+            return Sim_Test_Foreign( 8, 16, 2 ) || Sim_Test_Foreign( 40, 32, 1 );
+        default:
+            return 1;
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Self_Test
+ *
+ * @brief   Run every self-test case.
+ *
+ * @return  number of failed cases
+ */
+static int Sim_Self_Test( int ops, unsigned seed )
+{
+    static const char *pname[ ] =
+    {
+        "FAT12, 2 sectors per cluster, random operations",
+        "FAT16 behind an MBR, 4 sectors per cluster, random operations",
+        "FAT32, 1 sector per cluster, random operations",
+        "FAT12 volume written full",
+        "files put on FAT16 and FAT32 without the layer",
+    };
+    pid_t pid;
+    int i, st, fail = 0;
+
+    for( i = 0; i < 5; i++ )
+    {
+        printf( "%s\n", pname[ i ] );
+        fflush( stdout );
+        pid = fork( );
+        if( pid == 0 )
+        {
+            srand( seed + i );
+            st = Sim_Test_Run( i, ops );
+            fflush( stdout );
+            _exit( st ? 1 : 0 );
+        }
+        if( ( pid < 0 ) || ( waitpid( pid, &st, 0 ) != pid ) || !WIFEXITED( st ) || WEXITSTATUS( st ) )
+        {
+            printf( "  FAIL\n" );
+            fail++;
+        }
+        else
+        {
+            printf( "  ok\n" );
+        }
+    }
+    printf( "%s\n", fail ? "self-test FAILED" : "self-test passed" );
+    return fail;
+}
+
+/*********************************************************************
+ * @fn      Sim_Count
+ *
+ * @brief   Commands for 1 MB written in 64 KB pieces and read back in
+ *          pieces of 64 KB, 4 KB and 512 bytes, from a fresh mount.
+ *
+ * @return  0 - data read back correctly
+ */
+static int Sim_Count( uint8_t fat, uint8_t spc )
+{
+    static const uint32_t piece[ 3 ] = { 65536, 4096, 512 };
+    static uint8_t buf[ 65536 ] __attribute__( ( aligned( 4 ) ) );
+    uint32_t n, i, j, h, tot;
+    UFAT_FILE f;
+    int k;
+
+    /* At least 2 MB, about 2040 clusters for FAT12 (4070 at 1 sector per
+     * cluster), 16380 for FAT16, 67570 for FAT32 */
+    Sim_Format( ( fat == 32 ) ? 33 * spc : ( fat == 16 ) ? 8 * spc : ( spc < 2 ) ? 2 : spc, fat, spc, 0 );
+    if( UFAT_Mount( ) || UFAT_Open( &f, "/big.bin", UFAT_CREATE ) )
+    {
+        printf( "mount failed\n" );
+        return 1;
+    }
+    Sim_Rd_Cmd = Sim_Wr_Cmd = 0;
+    for( i = 0; i < 16; i++ )
+    {
+        for( j = 0; j < sizeof( buf ); j++ )
+        {
+            buf[ j ] = (uint8_t)( i + j );
+        }
+        if( UFAT_Write( &f, buf, sizeof( buf ), &n ) )
+        {
+            printf( "write failed\n" );
+            return 1;
+        }
+    }
+    UFAT_Close( &f );
+    UFAT_Unmount( );
+    printf( "FAT%d, %d sectors per cluster\n", fat, spc );
+    printf( "  write 1 MB in 64 KB pieces: %u WRITE(10), %u READ(10)\n", Sim_Wr_Cmd, Sim_Rd_Cmd );
+
+    for( k = 0; k < 3; k++ )
+    {
+        UFAT_Mount( );
+        UFAT_Open( &f, "/big.bin", UFAT_READ );
+        Sim_Rd_Cmd = 0;
+        tot = 0;
+        h = 0;
+        do
+        {
+            UFAT_Read( &f, buf, piece[ k ], &n );
+            for( j = 0; j < n; j++ )
+            {
+                h |= buf[ j ] ^ (uint8_t)( ( tot + j ) / 65536 + ( tot + j ) % 65536 );
+            }
+            tot += n;
+        } while( n );
+        UFAT_Close( &f );
+        UFAT_Unmount( );
+        printf( "  read 1 MB in %5u byte pieces: %u READ(10)\n", piece[ k ], Sim_Rd_Cmd );
+        if( ( tot != 16 * 65536 ) || h )
+        {
+            printf( "  read back wrong\n" );
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main( int argc, char **argv )
+{
+    int c, test = 0, ops = 4000;
+    unsigned seed = 1;
+    uint8_t fat = 16, spc = 4;
+
+    while( ( c = getopt( argc, argv, "f:c:n:s:t" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 'f':
+                fat = atoi( optarg );
+                break;
+            case 'c':
+                spc = atoi( optarg );
+                break;
+            case 'n':
+                ops = atoi( optarg );
+                break;
+            case 's':
+                seed = strtoul( optarg, NULL, 0 );
+                break;
+            case 't':
+                test = 1;
+                break;
+            default:
+                fprintf( stderr, "usage: %s [-f 12|16|32] [-c spc] | -t [-n ops] [-s seed]\n", argv[ 0 ] );
+                return 2;
+        }
+    }
+    if( test )
+    {
+        return Sim_Self_Test( ops, seed ) ? 1 : 0;
+    }
+    if( ( ( fat != 12 ) && ( fat != 16 ) && ( fat != 32 ) ) || ( spc == 0 ) || ( spc & ( spc - 1 ) ) )
+    {
+        fprintf( stderr, "FAT 12, 16 or 32, sectors per cluster a power of 2\n" );
+        return 2;
+    }
+    return Sim_Count( fat, spc );
+}
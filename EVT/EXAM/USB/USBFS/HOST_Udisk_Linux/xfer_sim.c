@@ -0,0 +1,1380 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : xfer_sim.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : The USBFS host transaction engine of HOST_Udisk and the
+ *                      polled USBFSH_Transact built for the PC against a
+ *                      simulated host controller and device.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * usb_host_xfer.c and ch643_usbfs_host.c of HOST_Udisk are compiled in as
+ * they are, the latter with DEF_USBH_XFER_EN 0 so that USBFSH_Transact is
+ * the polled loop (USBHostTransact of CH643UFI.c is the same loop).
+ * The USBFS host registers are simulated: a token starts when HOST_EP_PID
+ * is set with the transfer flag clear, takes bus time (12Mbps plus
+ * handshake and gaps) and then raises the transfer flag; INT_FG is write
+ * 1 to clear; DMA goes through the 16-bit DMA registers into 64KB of RAM
+ * mapped at 0x20000000. SOF comes every 1ms. The interrupt is taken
+ * whenever it is enabled and pending (3us each by default), WFI sleeps to
+ * the next interrupt and TIM2 counts the simulated microseconds.
+ * The device behind the port is a bulk-only disk on endpoint 1 (OUT) and
+ * 2 (IN): each CBW queues its data packets and a CSW, one command in three
+ * NAKs for a while as if reading flash. Endpoint 3 is an interrupt IN
+ * counter, endpoint 4 stalls, the others never answer. NAKs, lost ACKs
+ * (host and device side), no answer, a stuck token and a disconnect can
+ * be injected.
+ * The library is modelled by Sim_Lib_Read: CBW, IN packets DMAed straight
+ * into the sector buffer with some work between them, CSW, as CH643UFI.c
+ * drives USBHostTransact.
+ *
+ * xfer_sim -t runs the self-tests:
+ *   - STALL, NAK at once, NAK limit, NAKed OUT, no answer on OUT and IN,
+ *     lost ACK on OUT, disconnect and stuck token: the polled loop and
+ *     USBH_Xfer_Transact return the same code after the same number of
+ *     tokens, the stuck token within 5ms. A repeated IN packet: both
+ *     retry and get the next packet.
+ *   - 400 sector reads through the engine with random NAKs and lost ACKs:
+ *     no data or CSW errors, each CBW taken once, and the engine's idle
+ *     time equal to the time spent in WFI.
+ *   - The same with an interrupt IN reader on endpoint 3 queued from the
+ *     idle hook: both data streams without a gap or an error.
+ *   - Buffered IN of 1000, 1024 and 37 bytes and buffered OUT of 200 bytes:
+ *     data, toggles, Actual, nothing written past the buffer, and the DMA,
+ *     length and toggle registers left as the caller had them.
+ * A run that is still waiting after 60s of simulated time fails.
+ * Without -t, sectors are read through the polled loop and through the
+ * engine, and the time, throughput and CPU busy share of each are printed.
+ *
+ * Build:
+ *   gcc -O2 -Wall -I../HOST_Udisk/User -I../USBH_Lib -I../../../SRC/Core
+ *       -I../../../SRC/Debug -I../../../SRC/Peripheral/inc
+ *       -o xfer_sim xfer_sim.c
+ *
+ * Usage:
+ *   xfer_sim [-n sectors] [-l us] [-i us] [-w us] | -t
+ *   -n  sectors read each way, 400 by default
+ *   -l  flash wait of one command in three, 300us by default
+ *   -i  time of one interrupt, 3us by default
+ *   -w  library work between two packets, 2us by default
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* The example and the peripheral headers as they are, minus the RISC-V bits */
+#define interrupt( x )      unused
+#define DEF_USBH_XFER_EN    0
+#include "debug.h"
+
+static USBFSH_TypeDef *Sim_Usbfsh_Get( void );
+static TIM_TypeDef *Sim_Tim2_Get( void );
+static void Sim_Nvic( uint8_t en );
+static void Sim_Wfi( void );
+
+static USBFSH_TypeDef Sim_Usbfsh;
+static TIM_TypeDef Sim_Tim2;
+static AFIO_TypeDef Sim_Afio;
+static uint8_t *Sim_Ram;
+
+/* Every register access of the code goes through Sim_Usbfsh_Get first */
+#undef USBFSH
+#define USBFSH              ( Sim_Usbfsh_Get( ) )
+#undef TIM2
+#define TIM2                ( Sim_Tim2_Get( ) )
+#undef AFIO
+#define AFIO                ( &Sim_Afio )
+#define NVIC_EnableIRQ( x ) Sim_Nvic( 1 )
+#define NVIC_DisableIRQ( x ) Sim_Nvic( 0 )
+#define __WFI( )            Sim_Wfi( )
+
+#include "usb_host_config.h"
+
+/* The packet buffers at the bottom of the simulated RAM */
+#define SIM_RAM_BASE        0x20000000
+#define SIM_RAM_SIZE        0x10000
+#define SIM_RX_BUF          0x0000
+#define SIM_TX_BUF          0x0040
+#define SIM_EP3_BUF         0x0100
+#define SIM_SECT_BUF        0x0400
+#define SIM_XFER_BUF        0x1000
+#undef USBFS_RX_Buf
+#undef USBFS_TX_Buf
+#define USBFS_RX_Buf        ( Sim_Ram + SIM_RX_BUF )
+#define USBFS_TX_Buf        ( Sim_Ram + SIM_TX_BUF )
+
+/* Both write RAM addresses to the 16-bit DMA registers through uint32_t */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpointer-to-int-cast"
+#include "ch643_usbfs_host.c"
+#include "usb_host_xfer.c"
+#pragma GCC diagnostic pop
+
+#define SIM_FRAME_US        1000
+#define SIM_NO_ANSWER_US    18                                                  /* Token and the host's answer timeout */
+#define SIM_BUS_US( n )     ( 3 + ( ( n ) * 2 + 2 ) / 3 )                      /* Token, handshake and gaps, then 12Mbps */
+#define SIM_FG_MARK         USBFS_U_IS_NAK                                      /* Device mode only, shows any write of INT_FG */
+#define SIM_NEVER           UINT64_MAX
+#define SIM_END_US          60000000                                            /* No run is that long, something hangs */
+#define SIM_MAX_PKT         64
+#define SIM_Q_NUM           64
+#define SIM_OUT_MAX         4096
+#define SIM_CSW             0xFFFF
+
+/* A packet queued on endpoint 2 */
+typedef struct _SIM_PKT
+{
+    uint32_t Tag;
+    uint16_t Off;                                                               /* Offset in the data of the command, SIM_CSW - the CSW */
+    uint8_t  Len;
+} SIM_PKT;
+
+typedef struct _SIM_DEV
+{
+    /* Endpoint 1, bulk OUT */
+    uint8_t  Out_Tog;
+    uint8_t  Out_Buf[ SIM_OUT_MAX ];                                            /* Data packets taken, CBWs excluded */
+    uint32_t Out_Len;
+    uint32_t Out_Pkts, Out_Dups;
+    uint32_t Cbw_Tag, Cbw_Num;
+
+    /* Endpoint 2, bulk IN */
+    uint8_t  In_Tog;
+    SIM_PKT  Q[ SIM_Q_NUM ];
+    uint8_t  Q_Head, Q_Num;
+    uint64_t Ready_At;                                                          /* NAK until then */
+
+    /* Endpoint 3, interrupt IN */
+    uint8_t  Int_Tog;
+    uint32_t Int_Pos;
+    uint8_t  Int_Nak_Pct;
+
+    /* Faults */
+    uint32_t Latency;                                                           /* Flash wait of one command in three */
+    uint8_t  Out_Nak_Pct;
+    uint16_t Ack_Loss;                                                          /* Per mille, both directions */
+    uint8_t  Out_Nak_Left;                                                      /* Next OUTs NAKed */
+    uint8_t  Out_Ack_Lose;                                                      /* Next ACKs of an OUT lost */
+    uint8_t  In_Ack_Lose;                                                       /* Next host ACKs of an IN lost */
+    uint8_t  Stuck, Unplug;
+
+    uint32_t Tokens;
+    int      Err;
+} SIM_DEV;
+
+/* The simulated library above the transact functions */
+typedef struct _SIM_HOST
+{
+    uint8_t  ( *Transact )( uint8_t endp_pid, uint8_t tog, uint32_t timeout );
+    uint8_t  Out_Tog, In_Tog;
+    uint32_t Tag;
+    uint32_t Bad;
+} SIM_HOST;
+
+static SIM_DEV  Sim_Dev;
+static SIM_HOST Sim_Host;
+
+/* Time and the controller */
+static uint64_t Sim_Now;
+static uint64_t Sim_Next_Sof = SIM_FRAME_US;
+static uint64_t Sim_Idle_Us;
+static uint32_t Sim_Isr_Us = 3;
+static uint32_t Sim_Work_Us = 2;
+static uint8_t  Sim_Int_Fg;                                                     /* The flags, INT_FG holds them plus SIM_FG_MARK */
+static uint8_t  Sim_Fg_Shown;
+static uint8_t  Sim_Irq_En, Sim_In_Isr;
+static uint32_t Sim_Isr_Num;
+
+/* The token on the bus */
+static uint8_t  Sim_Tok_On;
+static uint64_t Sim_Tok_End;
+static uint8_t  Sim_Tok_St;
+static uint16_t Sim_Tok_Dma;
+static uint8_t  Sim_Tok_Len;
+static uint8_t  Sim_Tok_In;
+static uint8_t  Sim_Tok_Data[ SIM_MAX_PKT ];
+
+static void Sim_Error( const char *what )
+{
+    if( Sim_Dev.Err++ < 5 )
+    {
+        printf( "  %s\n", what );
+    }
+}
+
+static void Sim_Fail( const char *what )
+{
+    printf( "  %s\n", what );
+    fflush( stdout );
+    exit( 1 );
+}
+
+static uint32_t Sim_Get32( const uint8_t *p )
+{
+    return p[ 0 ] | ( p[ 1 ] << 8 ) | ( p[ 2 ] << 16 ) | ( (uint32_t)p[ 3 ] << 24 );
+}
+
+static void Sim_Put32( uint8_t *p, uint32_t v )
+{
+    p[ 0 ] = (uint8_t)v;
+    p[ 1 ] = (uint8_t)( v >> 8 );
+    p[ 2 ] = (uint8_t)( v >> 16 );
+    p[ 3 ] = (uint8_t)( v >> 24 );
+}
+
+/* Data byte at off of the command with tag */
+static uint8_t Sim_Byte( uint32_t tag, uint32_t off )
+{
+    return (uint8_t)( tag * 131 + off * 7 + ( off >> 8 ) );
+}
+
+/*******************************************************************************/
+/* Device */
+
+/*********************************************************************
+ * @fn      Sim_Dev_Cbw
+ *
+ * @brief   Take a CBW: queue its data packets and the CSW on endpoint 2.
+ *
+ * @return  none
+ */
+static void Sim_Dev_Cbw( const uint8_t *cbw )
+{
+    uint32_t tag = Sim_Get32( cbw + 4 ), len = Sim_Get32( cbw + 8 ), off = 0;
+    SIM_PKT  *pq;
+
+    if( tag != Sim_Dev.Cbw_Tag + 1 )
+    {
+        Sim_Error( "device: CBW out of sequence" );
+    }
+    Sim_Dev.Cbw_Tag = tag;
+    if( ( ++Sim_Dev.Cbw_Num % 3 ) == 0 )
+    {
+        Sim_Dev.Ready_At = Sim_Now + Sim_Dev.Latency;
+    }
+    do
+    {
+        if( Sim_Dev.Q_Num == SIM_Q_NUM )
+        {
+            Sim_Error( "device: endpoint 2 queue full" );
+            return;
+        }
+        pq = &Sim_Dev.Q[ ( Sim_Dev.Q_Head + Sim_Dev.Q_Num++ ) % SIM_Q_NUM ];
+        pq->Tag = tag;
+        if( off < len )
+        {
+            pq->Off = off;
+            pq->Len = ( len - off < SIM_MAX_PKT ) ? len - off : SIM_MAX_PKT;
+            off += pq->Len;
+        }
+        else
+        {
+            pq->Off = SIM_CSW;
+            pq->Len = 13;
+            off++;
+        }
+    } while( off <= len );
+}
+
+/*********************************************************************
+ * @fn      Sim_Dev_In
+ *
+ * @brief   Answer an IN token with a data packet. A packet sent with the
+ *          toggle the host does not expect is taken by the host hardware
+ *          (ACKed) and reported without TOG_OK.
+ *
+ * @return  Bus time.
+ */
+static uint32_t Sim_Dev_In( uint8_t *tog, uint8_t host_tog, uint8_t lose_ack, uint8_t len, uint8_t *advance )
+{
+    Sim_Tok_Len = len;
+    if( host_tog != *tog )
+    {
+        Sim_Tok_St = *tog ? USB_PID_DATA1 : USB_PID_DATA0;
+        *advance = 1;
+    }
+    else
+    {
+        Sim_Tok_St = USBFS_UIS_TOG_OK | ( *tog ? USB_PID_DATA1 : USB_PID_DATA0 );
+        *advance = !lose_ack;
+    }
+    if( *advance )
+    {
+        *tog ^= 1;
+    }
+    return SIM_BUS_US( len );
+}
+
+/*********************************************************************
+ * @fn      Sim_Dev_Token
+ *
+ * @brief   The device's answer to the token in the registers, kept in
+ *          Sim_Tok_* until the end of the transaction.
+ *
+ * @return  Bus time, SIM_NEVER - the transfer flag is never raised.
+ */
+static uint64_t Sim_Dev_Token( void )
+{
+    uint8_t  pid = Sim_Usbfsh.HOST_EP_PID >> 4, ep = Sim_Usbfsh.HOST_EP_PID & 0x0F;
+    uint8_t  lose, adv, i;
+    uint32_t n;
+    SIM_PKT  *pq;
+
+    Sim_Dev.Tokens++;
+    Sim_Tok_St = 0;
+    Sim_Tok_Len = 0;
+    Sim_Tok_In = ( pid == USB_PID_IN );
+    Sim_Tok_Dma = Sim_Tok_In ? Sim_Usbfsh.HOST_RX_DMA : Sim_Usbfsh.HOST_TX_DMA;
+    if( Sim_Tok_Dma & 1 )
+    {
+        Sim_Error( "controller: DMA address odd" );
+    }
+    if( Sim_Dev.Stuck )
+    {
+        return SIM_NEVER;
+    }
+    if( Sim_Dev.Unplug )
+    {
+        Sim_Usbfsh.HOST_CTRL &= ~USBFS_UH_PORT_EN;
+        Sim_Int_Fg |= USBFS_UIF_DETECT;
+        return SIM_NO_ANSWER_US;
+    }
+
+    if( ( pid == USB_PID_OUT ) || ( pid == USB_PID_SETUP ) )
+    {
+        if( ep != 1 )
+        {
+            return SIM_NO_ANSWER_US;
+        }
+        if( Sim_Dev.Out_Nak_Left || ( ( rand( ) % 100 ) < Sim_Dev.Out_Nak_Pct ) )
+        {
+            if( Sim_Dev.Out_Nak_Left )
+            {
+                Sim_Dev.Out_Nak_Left--;
+            }
+            Sim_Tok_St = USB_PID_NAK;
+            return SIM_BUS_US( 0 );
+        }
+        n = Sim_Usbfsh.HOST_TX_LEN;
+        if( ( n > SIM_MAX_PKT ) || ( Sim_Tok_Dma + n > SIM_RAM_SIZE ) )
+        {
+            Sim_Error( "controller: OUT packet too long or past the RAM" );
+            return SIM_NO_ANSWER_US;
+        }
+        if( ( ( Sim_Usbfsh.HOST_TX_CTRL & USBFS_UH_T_TOG ) ? 1 : 0 ) == Sim_Dev.Out_Tog )
+        {
+            Sim_Dev.Out_Tog ^= 1;
+            Sim_Dev.Out_Pkts++;
+            if( ( n == 31 ) && ( memcmp( Sim_Ram + Sim_Tok_Dma, "USBC", 4 ) == 0 ) )
+            {
+                Sim_Dev_Cbw( Sim_Ram + Sim_Tok_Dma );
+            }
+            else if( Sim_Dev.Out_Len + n <= SIM_OUT_MAX )
+            {
+                memcpy( &Sim_Dev.Out_Buf[ Sim_Dev.Out_Len ], Sim_Ram + Sim_Tok_Dma, n );
+                Sim_Dev.Out_Len += n;
+            }
+        }
+        else
+        {
+            Sim_Dev.Out_Dups++;                                                 /* Sent again after a lost ACK, ACKed and dropped */
+        }
+        lose = Sim_Dev.Out_Ack_Lose || ( ( rand( ) % 1000 ) < Sim_Dev.Ack_Loss );
+        if( Sim_Dev.Out_Ack_Lose )
+        {
+            Sim_Dev.Out_Ack_Lose--;
+        }
+        Sim_Tok_St = lose ? 0 : ( USBFS_UIS_TOG_OK | USB_PID_ACK );
+        return SIM_BUS_US( n );
+    }
+
+    if( pid != USB_PID_IN )
+    {
+        return SIM_NO_ANSWER_US;
+    }
+    lose = Sim_Dev.In_Ack_Lose || ( ( rand( ) % 1000 ) < Sim_Dev.Ack_Loss );
+    if( ep == 2 )
+    {
+        if( ( Sim_Dev.Q_Num == 0 ) || ( Sim_Now < Sim_Dev.Ready_At ) )
+        {
+            Sim_Tok_St = USB_PID_NAK;
+            return SIM_BUS_US( 0 );
+        }
+        pq = &Sim_Dev.Q[ Sim_Dev.Q_Head ];
+        if( pq->Off == SIM_CSW )
+        {
+            memcpy( Sim_Tok_Data, "USBS", 4 );
+            Sim_Put32( Sim_Tok_Data + 4, pq->Tag );
+            Sim_Put32( Sim_Tok_Data + 8, 0 );
+            Sim_Tok_Data[ 12 ] = 0;
+        }
+        else
+        {
+            for( i = 0; i < pq->Len; i++ )
+            {
+                Sim_Tok_Data[ i ] = Sim_Byte( pq->Tag, pq->Off + i );
+            }
+        }
+        n = Sim_Dev_In( &Sim_Dev.In_Tog, ( Sim_Usbfsh.HOST_RX_CTRL & USBFS_UH_R_TOG ) ? 1 : 0, lose, pq->Len, &adv );
+        if( adv )
+        {
+            Sim_Dev.Q_Head = ( Sim_Dev.Q_Head + 1 ) % SIM_Q_NUM;
+            Sim_Dev.Q_Num--;
+        }
+    }
+    else if( ep == 3 )
+    {
+        if( ( rand( ) % 100 ) < Sim_Dev.Int_Nak_Pct )
+        {
+            Sim_Tok_St = USB_PID_NAK;
+            return SIM_BUS_US( 0 );
+        }
+        n = 1 + rand( ) % 8;
+        for( i = 0; i < n; i++ )
+        {
+            Sim_Tok_Data[ i ] = (uint8_t)( Sim_Dev.Int_Pos + i );
+        }
+        n = Sim_Dev_In( &Sim_Dev.Int_Tog, ( Sim_Usbfsh.HOST_RX_CTRL & USBFS_UH_R_TOG ) ? 1 : 0, lose, n, &adv );
+        if( adv )
+        {
+            Sim_Dev.Int_Pos += 8;                                               /* By 8, the reader knows where packets start */
+        }
+    }
+    else if( ep == 4 )
+    {
+        Sim_Tok_St = USB_PID_STALL;
+        return SIM_BUS_US( 0 );
+    }
+    else
+    {
+        return SIM_NO_ANSWER_US;
+    }
+    if( Sim_Dev.In_Ack_Lose )
+    {
+        Sim_Dev.In_Ack_Lose--;
+    }
+    return n;
+}
+
+/*******************************************************************************/
+/* Controller */
+
+static void Sim_Fg_Show( void )
+{
+    Sim_Fg_Shown = Sim_Int_Fg | SIM_FG_MARK;
+    Sim_Usbfsh.INT_FG = Sim_Fg_Shown;
+}
+
+/*********************************************************************
+ * @fn      Sim_Hw_Sync
+ *
+ * @brief   Apply what the code wrote since the last register access:
+ *          clear the INT_FG bits written with 1, stop the token when
+ *          HOST_EP_PID was cleared, start one when it is set with the
+ *          transfer flag clear.
+ *
+ * @return  none
+ */
+static void Sim_Hw_Sync( void )
+{
+    uint64_t t;
+
+    if( Sim_Usbfsh.INT_FG != Sim_Fg_Shown )
+    {
+        Sim_Int_Fg &= ~Sim_Usbfsh.INT_FG;
+    }
+    if( Sim_Tok_On && ( Sim_Usbfsh.HOST_EP_PID == 0 ) )
+    {
+        Sim_Tok_On = 0;
+    }
+    if( !Sim_Tok_On && Sim_Usbfsh.HOST_EP_PID && !( Sim_Int_Fg & USBFS_UIF_TRANSFER ) )
+    {
+        t = Sim_Dev_Token( );
+        Sim_Tok_On = 1;
+        Sim_Tok_End = ( t == SIM_NEVER ) ? SIM_NEVER : Sim_Now + t;
+    }
+    Sim_Fg_Show( );
+}
+
+static USBFSH_TypeDef *Sim_Usbfsh_Get( void )
+{
+    Sim_Hw_Sync( );
+    return &Sim_Usbfsh;
+}
+
+static TIM_TypeDef *Sim_Tim2_Get( void )
+{
+    Sim_Tim2.CNT = (uint16_t)Sim_Now;
+    return &Sim_Tim2;
+}
+
+static uint64_t Sim_Next_Event( void )
+{
+    return ( Sim_Tok_On && ( Sim_Tok_End < Sim_Next_Sof ) ) ? Sim_Tok_End : Sim_Next_Sof;
+}
+
+/*********************************************************************
+ * @fn      Sim_Step
+ *
+ * @brief   Go to the next event: the end of the token, whose answer is
+ *          then put in the registers and the RAM, or SOF. An event that
+ *          fell inside an interrupt handler is raised as it returns.
+ *
+ * @return  none
+ */
+static void Sim_Step( void )
+{
+    uint64_t t;
+
+    Sim_Hw_Sync( );
+    t = Sim_Next_Event( );
+    if( t > Sim_Now )
+    {
+        Sim_Now = t;
+    }
+    if( Sim_Now > SIM_END_US )
+    {
+        Sim_Fail( "still waiting after 60s" );
+    }
+    if( Sim_Tok_On && ( Sim_Tok_End <= Sim_Now ) )
+    {
+        Sim_Tok_On = 0;
+        if( Sim_Tok_In && Sim_Tok_Len )
+        {
+            if( Sim_Tok_Dma + Sim_Tok_Len > SIM_RAM_SIZE )
+            {
+                Sim_Fail( "controller: IN DMA past the RAM" );
+            }
+            memcpy( Sim_Ram + Sim_Tok_Dma, Sim_Tok_Data, Sim_Tok_Len );
+        }
+        if( Sim_Tok_In )
+        {
+            Sim_Usbfsh.RX_LEN = Sim_Tok_Len;
+        }
+        Sim_Usbfsh.INT_ST = Sim_Tok_St;
+        Sim_Int_Fg |= USBFS_UIF_TRANSFER;
+    }
+    if( Sim_Next_Sof <= Sim_Now )
+    {
+        Sim_Next_Sof += SIM_FRAME_US;
+        Sim_Int_Fg |= USBFS_UIF_HST_SOF;
+    }
+    Sim_Fg_Show( );
+}
+
+static uint8_t Sim_Irq_Pending( void )
+{
+    Sim_Hw_Sync( );
+    return Sim_Irq_En && !Sim_In_Isr && ( Sim_Int_Fg & Sim_Usbfsh.INT_EN & ( USBFS_UIF_TRANSFER | USBFS_UIF_HST_SOF | USBFS_UIF_DETECT ) );
+}
+
+/*********************************************************************
+ * @fn      Sim_Irq_Check
+ *
+ * @brief   Take the USBFS interrupt as long as it is pending.
+ *
+ * @return  Time spent in the handler.
+ */
+static uint32_t Sim_Irq_Check( void )
+{
+    uint32_t n = 0;
+
+    while( Sim_Irq_Pending( ) )
+    {
+        if( ++n > 50 )
+        {
+            Sim_Fail( "controller: interrupt pending after the handler" );
+        }
+        Sim_In_Isr = 1;
+        USBFS_IRQHandler( );
+        Sim_Hw_Sync( );
+        Sim_In_Isr = 0;
+        Sim_Isr_Num++;
+        Sim_Now += Sim_Isr_Us;
+    }
+    return n * Sim_Isr_Us;
+}
+
+/*********************************************************************
+ * @fn      Sim_Advance
+ *
+ * @brief   Let the CPU work for us, taking interrupts on the way.
+ *
+ * @return  none
+ */
+static void Sim_Advance( uint32_t us )
+{
+    uint64_t end = Sim_Now + us;
+
+    end += Sim_Irq_Check( );
+    while( Sim_Next_Event( ) <= end )
+    {
+        Sim_Step( );
+        end += Sim_Irq_Check( );
+    }
+    Sim_Now = end;
+}
+
+static void Sim_Nvic( uint8_t en )
+{
+    Sim_Irq_En = en;
+    if( en )
+    {
+        Sim_Irq_Check( );
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Wfi
+ *
+ * @brief   Sleep until the USBFS interrupt, then take it.
+ *
+ * @return  none
+ */
+static void Sim_Wfi( void )
+{
+    uint64_t t = Sim_Now;
+
+    if( !Sim_Irq_En )
+    {
+        Sim_Fail( "WFI with the USBFS interrupt masked" );
+    }
+    while( !Sim_Irq_Pending( ) )
+    {
+        Sim_Step( );
+    }
+    Sim_Idle_Us += Sim_Now - t;
+    Sim_Irq_Check( );
+}
+
+/*******************************************************************************/
+/* Functions the example calls */
+uint32_t SystemCoreClock = 96000000;
+
+void Delay_Us( uint32_t n )
+{
+    Sim_Advance( n );
+}
+
+void Delay_Ms( uint32_t n )
+{
+    Sim_Advance( n * 1000 );
+}
+
+void RCC_AHBPeriphClockCmd( uint32_t RCC_AHBPeriph, FunctionalState NewState )
+{
+}
+
+void RCC_APB1PeriphClockCmd( uint32_t RCC_APB1Periph, FunctionalState NewState )
+{
+}
+
+void RCC_APB2PeriphClockCmd( uint32_t RCC_APB2Periph, FunctionalState NewState )
+{
+}
+
+void GPIO_Init( GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct )
+{
+}
+
+void NVIC_Init( NVIC_InitTypeDef *NVIC_InitStruct )
+{
+}
+
+void TIM_TimeBaseInit( TIM_TypeDef *TIMx, TIM_TimeBaseInitTypeDef *TIM_TimeBaseInitStruct )
+{
+}
+
+void TIM_Cmd( TIM_TypeDef *TIMx, FunctionalState NewState )
+{
+}
+
+/*******************************************************************************/
+/* Harness */
+
+static uint8_t Sim_Poll_Transact( uint8_t endp_pid, uint8_t tog, uint32_t timeout )
+{
+    return USBFSH_Transact( endp_pid, tog, ( timeout > 0xFFFF ) ? 0xFFFF : timeout );
+}
+
+static uint8_t Sim_Xfer_Transact( uint8_t endp_pid, uint8_t tog, uint32_t timeout )
+{
+    return USBH_Xfer_Transact( endp_pid, tog, timeout );
+}
+
+/*********************************************************************
+ * @fn      Sim_Init
+ *
+ * @brief   Map the RAM, reset the device and bring the port up as
+ *          HOST_Udisk does, without the engine.
+ *
+ * @return  none
+ */
+static void Sim_Init( void )
+{
+    void *p;
+
+    if( Sim_Ram == NULL )
+    {
+        p = mmap( (void *)SIM_RAM_BASE, SIM_RAM_SIZE, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0 );
+        if( p != (void *)SIM_RAM_BASE )
+        {
+            printf( "cannot map the RAM at 0x%08X, the DMA registers hold its low 16 bits\n", SIM_RAM_BASE );
+            exit( 1 );
+        }
+        Sim_Ram = p;
+    }
+    memset( &Sim_Dev, 0, sizeof( Sim_Dev ) );
+    memset( &Sim_Host, 0, sizeof( Sim_Host ) );
+    Sim_Host.Transact = Sim_Poll_Transact;
+    srand( 1 );
+
+    USBFS_Host_Init( ENABLE, PWR_VDD_3V3 );
+    Sim_Usbfsh.MIS_ST = USBFS_UMS_DEV_ATTACH;
+    USBFSH->HOST_CTRL |= USBFS_UH_PORT_EN;
+}
+
+/*********************************************************************
+ * @fn      Sim_Lib_Read
+ *
+ * @brief   One READ(10) as the U-disk library runs it: CBW from
+ *          USBFS_TX_Buf, the data packets DMAed straight into buf with
+ *          Sim_Work_Us of work before each, and the CSW through
+ *          USBFS_RX_Buf. Checks the data and the CSW.
+ *
+ * @para    buf: len bytes plus room for the rest of a packet.
+ *
+ * @return  USB transfer result.
+ */
+static uint8_t Sim_Lib_Read( uint32_t len, uint8_t *buf )
+{
+    uint8_t  s;
+    uint32_t off = 0, i, tag = ++Sim_Host.Tag;
+
+    memset( USBFS_TX_Buf, 0, 31 );
+    memcpy( USBFS_TX_Buf, "USBC", 4 );
+    Sim_Put32( USBFS_TX_Buf + 4, tag );
+    Sim_Put32( USBFS_TX_Buf + 8, len );
+    USBFS_TX_Buf[ 12 ] = 0x80;
+    USBFS_TX_Buf[ 14 ] = 10;
+    USBFS_TX_Buf[ 15 ] = 0x28;
+    USBFSH->HOST_TX_DMA = (uint16_t)(uintptr_t)USBFS_TX_Buf;
+    USBFSH->HOST_TX_LEN = 31;
+    s = Sim_Host.Transact( USB_PID_OUT << 4 | 1, Sim_Host.Out_Tog ? USBFS_UH_T_TOG : 0, 0xFFFF );
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    Sim_Host.Out_Tog ^= 1;
+
+    while( off < len )
+    {
+        Sim_Advance( Sim_Work_Us );
+        USBFSH->HOST_RX_DMA = (uint16_t)(uintptr_t)( buf + off );
+        s = Sim_Host.Transact( USB_PID_IN << 4 | 2, Sim_Host.In_Tog ? USBFS_UH_R_TOG : 0, 0xFFFF );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        Sim_Host.In_Tog ^= 1;
+        off += USBFSH->RX_LEN;
+        if( USBFSH->RX_LEN < SIM_MAX_PKT )
+        {
+            break;
+        }
+    }
+
+    USBFSH->HOST_RX_DMA = (uint16_t)(uintptr_t)USBFS_RX_Buf;
+    s = Sim_Host.Transact( USB_PID_IN << 4 | 2, Sim_Host.In_Tog ? USBFS_UH_R_TOG : 0, 0xFFFF );
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    Sim_Host.In_Tog ^= 1;
+    if( ( USBFSH->RX_LEN != 13 ) || memcmp( USBFS_RX_Buf, "USBS", 4 ) || ( Sim_Get32( USBFS_RX_Buf + 4 ) != tag ) )
+    {
+        Sim_Host.Bad++;
+        return ERR_USB_DISK_ERR;
+    }
+    if( off != len )
+    {
+        Sim_Host.Bad++;
+        return ERR_USB_DISK_ERR;
+    }
+    for( i = 0; i < len; i++ )
+    {
+        if( buf[ i ] != Sim_Byte( tag, i ) )
+        {
+            Sim_Host.Bad++;
+            return ERR_USB_DISK_ERR;
+        }
+    }
+    return ERR_SUCCESS;
+}
+
+/* Interrupt IN reader of endpoint 3, run beside the library */
+static USBH_XFER Sim_Ep3;
+static uint32_t  Sim_Ep3_Pkts, Sim_Ep3_Bytes, Sim_Ep3_Pos, Sim_Ep3_Bad;
+
+static void Sim_Ep3_Done( USBH_XFER *pxfer )
+{
+    uint16_t i;
+
+    if( pxfer->Status != ERR_SUCCESS )
+    {
+        Sim_Ep3_Bad++;
+        return;
+    }
+    for( i = 0; i < pxfer->Actual; i++ )
+    {
+        if( pxfer->pBuf[ i ] != (uint8_t)( Sim_Ep3_Pos + i ) )
+        {
+            Sim_Ep3_Bad++;
+            break;
+        }
+    }
+    Sim_Ep3_Pos += 8;
+    Sim_Ep3_Pkts++;
+    Sim_Ep3_Bytes += pxfer->Actual;
+}
+
+static void Sim_Ep3_Hook( void )
+{
+    if( Sim_Ep3.Status != USBH_XFER_PENDING )
+    {
+        USBH_Xfer_Submit( &Sim_Ep3 );
+    }
+}
+
+static void Sim_Ep3_Start( void )
+{
+    memset( &Sim_Ep3, 0, sizeof( Sim_Ep3 ) );
+    Sim_Ep3.Endp_Pid = USB_PID_IN << 4 | 3;
+    Sim_Ep3.pBuf = Sim_Ram + SIM_EP3_BUF;
+    Sim_Ep3.Len = 8;
+    Sim_Ep3.Max_Pkt = 8;
+    Sim_Ep3.Nak_Limit = DEF_USBH_XFER_NAK_FOREVER;
+    Sim_Ep3.Done = Sim_Ep3_Done;
+    Sim_Dev.Int_Nak_Pct = 60;
+    USBH_Xfer_Idle_Hook = Sim_Ep3_Hook;
+}
+
+/*********************************************************************
+ * @fn      Sim_Read_Run
+ *
+ * @brief   Read num sectors through Sim_Host.Transact.
+ *
+ * @para    pus: Time taken.
+ *          pidle: Of it, time spent in WFI.
+ *
+ * @return  USB transfer result.
+ */
+static uint8_t Sim_Read_Run( uint32_t num, uint64_t *pus, uint64_t *pidle )
+{
+    uint64_t t = Sim_Now, idle = Sim_Idle_Us;
+    uint32_t i;
+    uint8_t  s = ERR_SUCCESS;
+
+    for( i = 0; ( i < num ) && ( s == ERR_SUCCESS ); i++ )
+    {
+        s = Sim_Lib_Read( 512, Sim_Ram + SIM_SECT_BUF );
+    }
+    *pus = Sim_Now - t;
+    *pidle = Sim_Idle_Us - idle;
+    return s;
+}
+
+/*******************************************************************************/
+/* Self-tests */
+
+/* One transaction of Sim_Test_Codes */
+typedef struct _SIM_CASE
+{
+    const char *Name;
+    uint8_t  Endp_Pid;
+    uint16_t Timeout;
+    uint8_t  Out_Nak, Out_Ack_Lose, Stuck, Unplug;
+    uint8_t  Code;                                                              /* Expected of both */
+    uint32_t Tokens;
+    uint32_t Max_Us;                                                            /* Time it may take, 0 - any */
+} SIM_CASE;
+
+static const SIM_CASE Sim_Case[ ] =
+{
+    { "STALL",              USB_PID_IN << 4 | 4,  0xFFFF, 0, 0, 0, 0, USB_PID_STALL | ERR_USB_TRANSFER, 1, 0 },
+    { "NAK, timeout 0",     USB_PID_IN << 4 | 2,  0,      0, 0, 0, 0, USB_PID_NAK | ERR_USB_TRANSFER,   1, 0 },
+    { "NAK, timeout 5",     USB_PID_IN << 4 | 2,  5,      0, 0, 0, 0, USB_PID_NAK | ERR_USB_TRANSFER,   6, 0 },
+    { "OUT NAKed 3 times",  USB_PID_OUT << 4 | 1, 0xFFFF, 3, 0, 0, 0, ERR_SUCCESS,                      4, 0 },
+    { "OUT ACK lost",       USB_PID_OUT << 4 | 1, 0xFFFF, 0, 1, 0, 0, ERR_SUCCESS,                      2, 0 },
+    { "no answer to OUT",   USB_PID_OUT << 4 | 5, 0xFFFF, 0, 0, 0, 0, ERR_USB_TRANSFER,                 10, 0 },
+    { "no answer to IN",    USB_PID_IN << 4 | 5,  0xFFFF, 0, 0, 0, 0, ERR_USB_TRANSFER,                 10, 0 },
+    { "disconnect",         USB_PID_OUT << 4 | 1, 0xFFFF, 0, 0, 0, 1, ERR_USB_DISCON,                   1, 0 },
+    { "stuck token",        USB_PID_IN << 4 | 2,  0xFFFF, 0, 0, 1, 0, ERR_USB_UNKNOWN,                  1, 5000 },
+};
+
+#define SIM_CASE_NUM        ( sizeof( Sim_Case ) / sizeof( Sim_Case[ 0 ] ) )
+
+/*********************************************************************
+ * @fn      Sim_Case_Run
+ *
+ * @brief   Run one case on a fresh device through Sim_Host.Transact.
+ *
+ * @return  Number of errors.
+ */
+static int Sim_Case_Run( const SIM_CASE *pc, const char *way )
+{
+    uint64_t t = Sim_Now;
+    uint8_t  s;
+    int      bad = 0;
+
+    memset( &Sim_Dev, 0, sizeof( Sim_Dev ) );
+    Sim_Usbfsh.HOST_CTRL |= USBFS_UH_PORT_EN;
+    Sim_Dev.Out_Nak_Left = pc->Out_Nak;
+    Sim_Dev.Out_Ack_Lose = pc->Out_Ack_Lose;
+    Sim_Dev.Stuck = pc->Stuck;
+    Sim_Dev.Unplug = pc->Unplug;
+    memcpy( USBFS_TX_Buf, "0123456789", 10 );
+    USBFSH->HOST_TX_DMA = (uint16_t)(uintptr_t)USBFS_TX_Buf;
+    USBFSH->HOST_RX_DMA = (uint16_t)(uintptr_t)USBFS_RX_Buf;
+    USBFSH->HOST_TX_LEN = 10;
+    s = Sim_Host.Transact( pc->Endp_Pid, 0, pc->Timeout );
+    if( ( s != pc->Code ) || ( Sim_Dev.Tokens != pc->Tokens ) || Sim_Dev.Err )
+    {
+        printf( "  %s, %s: %02X after %u tokens, expected %02X after %u\n",
+                way, pc->Name, s, Sim_Dev.Tokens, pc->Code, pc->Tokens );
+        bad++;
+    }
+    if( pc->Max_Us && ( Sim_Now - t > pc->Max_Us ) )
+    {
+        printf( "  %s, %s: took %uus\n", way, pc->Name, (uint32_t)( Sim_Now - t ) );
+        bad++;
+    }
+    if( ( ( pc->Endp_Pid & 0x0F ) == 1 ) && !pc->Unplug &&
+        ( ( Sim_Dev.Out_Len != 10 ) || memcmp( Sim_Dev.Out_Buf, "0123456789", 10 ) || ( Sim_Dev.Out_Pkts != 1 ) ) )
+    {
+        printf( "  %s, %s: the device took %u packets, %u bytes\n", way, pc->Name, Sim_Dev.Out_Pkts, Sim_Dev.Out_Len );
+        bad++;
+    }
+    Sim_Dev.Stuck = 0;
+    Sim_Dev.Unplug = 0;
+    Sim_Int_Fg &= ~USBFS_UIF_DETECT;
+    return bad;
+}
+
+/*********************************************************************
+ * @fn      Sim_Repeat_Run
+ *
+ * @brief   IN whose ACK is lost, then the next IN: the device sends the
+ *          packet again with the old toggle.
+ *
+ * @return  Result of the second IN.
+ */
+static uint8_t Sim_Repeat_Run( uint32_t *ptokens )
+{
+    uint8_t s;
+
+    memset( &Sim_Dev, 0, sizeof( Sim_Dev ) );
+    memset( USBFS_TX_Buf, 0, 31 );
+    memcpy( USBFS_TX_Buf, "USBC", 4 );
+    Sim_Put32( USBFS_TX_Buf + 4, 1 );
+    Sim_Put32( USBFS_TX_Buf + 8, 128 );
+    Sim_Dev_Cbw( USBFS_TX_Buf );
+    USBFSH->HOST_RX_DMA = (uint16_t)(uintptr_t)USBFS_RX_Buf;
+    Sim_Dev.In_Ack_Lose = 1;
+    s = Sim_Host.Transact( USB_PID_IN << 4 | 2, 0, 0xFFFF );
+    if( ( s != ERR_SUCCESS ) || ( USBFS_RX_Buf[ 0 ] != Sim_Byte( 1, 0 ) ) )
+    {
+        return ERR_USB_UNKNOWN;
+    }
+    Sim_Dev.Tokens = 0;
+    s = Sim_Host.Transact( USB_PID_IN << 4 | 2, USBFS_UH_R_TOG, 0xFFFF );
+    *ptokens = Sim_Dev.Tokens;
+    if( ( s == ERR_SUCCESS ) && ( ( USBFSH->RX_LEN != SIM_MAX_PKT ) || ( USBFS_RX_Buf[ 0 ] != Sim_Byte( 1, SIM_MAX_PKT ) ) ) )
+    {
+        return ERR_USB_UNKNOWN;
+    }
+    return s;
+}
+
+static int Sim_Test_Codes( void )
+{
+    uint32_t i, tok;
+    uint8_t  s;
+    int      bad = 0;
+
+    Sim_Init( );
+    for( i = 0; i < SIM_CASE_NUM; i++ )
+    {
+        bad += Sim_Case_Run( &Sim_Case[ i ], "polled" );
+    }
+    s = Sim_Repeat_Run( &tok );
+    if( ( s != ERR_SUCCESS ) || ( tok != 2 ) )
+    {
+        printf( "  polled, repeated IN packet: %02X after %u tokens\n", s, tok );
+        bad++;
+    }
+
+    USBH_Xfer_Init( );
+    Sim_Host.Transact = Sim_Xfer_Transact;
+    for( i = 0; i < SIM_CASE_NUM; i++ )
+    {
+        bad += Sim_Case_Run( &Sim_Case[ i ], "engine" );
+    }
+    s = Sim_Repeat_Run( &tok );
+    if( ( s != ERR_SUCCESS ) || ( tok != 2 ) )
+    {
+        printf( "  engine, repeated IN packet: %02X after %u tokens\n", s, tok );
+        bad++;
+    }
+    return bad;
+}
+
+/*********************************************************************
+ * @fn      Sim_Faulty_Reads
+ *
+ * @brief   Read num sectors through the engine with NAKs and lost ACKs.
+ *
+ * @return  Number of errors.
+ */
+static int Sim_Faulty_Reads( uint32_t num )
+{
+    uint64_t us, idle;
+    uint32_t xfer_idle = USBH_Xfer_Stat.Idle_Us;
+    uint8_t  s;
+    int      bad = 0;
+
+    Sim_Dev.Latency = 300;
+    Sim_Dev.Out_Nak_Pct = 10;
+    Sim_Dev.Ack_Loss = 50;
+    s = Sim_Read_Run( num, &us, &idle );
+    xfer_idle = USBH_Xfer_Stat.Idle_Us - xfer_idle;
+    if( s != ERR_SUCCESS )
+    {
+        printf( "  read: %02X\n", s );
+        bad++;
+    }
+    if( Sim_Host.Bad || Sim_Dev.Err || ( Sim_Dev.Cbw_Tag != num ) )
+    {
+        printf( "  %u bad sectors, %u device errors, %u of %u commands\n", Sim_Host.Bad, Sim_Dev.Err, Sim_Dev.Cbw_Tag, num );
+        bad++;
+    }
+    if( ( Sim_Dev.Out_Dups == 0 ) || ( USBH_Xfer_Stat.Nak == 0 ) )
+    {
+        printf( "  no lost ACK or no NAK injected\n" );
+        bad++;
+    }
+    if( xfer_idle != idle )
+    {
+        printf( "  engine idle %uus, in WFI %uus\n", xfer_idle, (uint32_t)idle );
+        bad++;
+    }
+    return bad;
+}
+
+static int Sim_Test_Reads( void )
+{
+    Sim_Init( );
+    USBH_Xfer_Init( );
+    Sim_Host.Transact = Sim_Xfer_Transact;
+    return Sim_Faulty_Reads( 400 );
+}
+
+static int Sim_Test_Ep3( void )
+{
+    int bad;
+
+    Sim_Init( );
+    USBH_Xfer_Init( );
+    Sim_Host.Transact = Sim_Xfer_Transact;
+    Sim_Ep3_Start( );
+    bad = Sim_Faulty_Reads( 200 );
+    USBH_Xfer_Idle_Hook = NULL;
+    Sim_Dev.Int_Nak_Pct = 0;
+    USBH_Xfer_Wait( &Sim_Ep3 );
+    if( ( Sim_Ep3_Pkts < 50 ) || Sim_Ep3_Bad || ( Sim_Ep3_Pos != Sim_Dev.Int_Pos ) )
+    {
+        printf( "  endpoint 3: %u packets, %u bad, at %u of %u\n", Sim_Ep3_Pkts, Sim_Ep3_Bad, Sim_Ep3_Pos, Sim_Dev.Int_Pos );
+        bad++;
+    }
+    return bad;
+}
+
+/*********************************************************************
+ * @fn      Sim_Buffered
+ *
+ * @brief   One buffered transfer between a CBW and a CSW sent raw,
+ *          with the caller's registers set to odd values around it.
+ *
+ * @return  Number of errors.
+ */
+static int Sim_Buffered( uint8_t pid, uint16_t len )
+{
+    USBH_XFER xfer;
+    uint8_t   *buf = Sim_Ram + SIM_XFER_BUF, tog, s;
+    uint16_t  i;
+    uint32_t  tag;
+    int       bad = 0;
+
+    memset( &xfer, 0, sizeof( xfer ) );
+    xfer.Endp_Pid = pid;
+    xfer.pBuf = buf;
+    xfer.Len = len;
+    xfer.Max_Pkt = SIM_MAX_PKT;
+    xfer.Nak_Limit = DEF_USBH_XFER_NAK_FOREVER;
+    memset( buf, 0xA5, len + 2 * SIM_MAX_PKT );
+    if( ( pid >> 4 ) == USB_PID_IN )
+    {
+        tag = Sim_Host.Tag + 1;
+        xfer.Tog = Sim_Host.In_Tog ? USBFS_UH_R_TOG : 0;
+        memset( USBFS_TX_Buf, 0, 31 );
+        memcpy( USBFS_TX_Buf, "USBC", 4 );
+        Sim_Put32( USBFS_TX_Buf + 4, ++Sim_Host.Tag );
+        Sim_Put32( USBFS_TX_Buf + 8, len );
+        USBFSH->HOST_TX_DMA = (uint16_t)(uintptr_t)USBFS_TX_Buf;
+        USBFSH->HOST_TX_LEN = 31;
+        s = USBH_Xfer_Transact( USB_PID_OUT << 4 | 1, Sim_Host.Out_Tog ? USBFS_UH_T_TOG : 0, 0xFFFF );
+        Sim_Host.Out_Tog ^= 1;
+        if( s != ERR_SUCCESS )
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        tag = 0;
+        xfer.Tog = Sim_Host.Out_Tog ? USBFS_UH_T_TOG : 0;
+        for( i = 0; i < len; i++ )
+        {
+            buf[ i ] = Sim_Byte( 77, i );
+        }
+        Sim_Dev.Out_Len = 0;
+    }
+
+    USBFSH->HOST_RX_DMA = 0x1234;
+    USBFSH->HOST_TX_DMA = 0x2468;
+    USBFSH->HOST_TX_LEN = 5;
+    USBFSH->HOST_RX_CTRL = USBFS_UH_R_AUTO_TOG;
+    USBFSH->HOST_TX_CTRL = USBFS_UH_T_AUTO_TOG;
+    tog = xfer.Tog;
+    USBH_Xfer_Submit( &xfer );
+    s = USBH_Xfer_Wait( &xfer );
+    if( ( s != ERR_SUCCESS ) || ( xfer.Actual != len ) )
+    {
+        printf( "  %u bytes: %02X, %u moved\n", len, s, xfer.Actual );
+        bad++;
+    }
+    if( ( USBFSH->HOST_RX_DMA != 0x1234 ) || ( USBFSH->HOST_TX_DMA != 0x2468 ) || ( USBFSH->HOST_TX_LEN != 5 ) ||
+        ( USBFSH->HOST_RX_CTRL != USBFS_UH_R_AUTO_TOG ) || ( USBFSH->HOST_TX_CTRL != USBFS_UH_T_AUTO_TOG ) )
+    {
+        printf( "  %u bytes: registers not restored\n", len );
+        bad++;
+    }
+    if( xfer.Tog != ( ( ( len + SIM_MAX_PKT - 1 ) / SIM_MAX_PKT ) & 1 ? tog ^ ( ( pid >> 4 ) == USB_PID_IN ? USBFS_UH_R_TOG : USBFS_UH_T_TOG ) : tog ) )
+    {
+        printf( "  %u bytes: toggle %02X after starting at %02X\n", len, xfer.Tog, tog );
+        bad++;
+    }
+    for( i = len; i < len + 2 * SIM_MAX_PKT; i++ )
+    {
+        if( buf[ i ] != 0xA5 )
+        {
+            printf( "  %u bytes: written past the buffer\n", len );
+            bad++;
+            break;
+        }
+    }
+
+    if( ( pid >> 4 ) == USB_PID_IN )
+    {
+        Sim_Host.In_Tog = ( xfer.Tog & USBFS_UH_R_TOG ) ? 1 : 0;
+        for( i = 0; i < len; i++ )
+        {
+            if( buf[ i ] != Sim_Byte( tag, i ) )
+            {
+                printf( "  %u bytes: data wrong at %u\n", len, i );
+                bad++;
+                break;
+            }
+        }
+        /* A whole last packet needs no short packet, the CSW follows */
+        USBFSH->HOST_RX_DMA = (uint16_t)(uintptr_t)USBFS_RX_Buf;
+        s = USBH_Xfer_Transact( USB_PID_IN << 4 | 2, Sim_Host.In_Tog ? USBFS_UH_R_TOG : 0, 0xFFFF );
+        Sim_Host.In_Tog ^= 1;
+        if( ( s != ERR_SUCCESS ) || ( USBFSH->RX_LEN != 13 ) || ( Sim_Get32( USBFS_RX_Buf + 4 ) != tag ) )
+        {
+            printf( "  %u bytes: no CSW after the data\n", len );
+            bad++;
+        }
+    }
+    else
+    {
+        Sim_Host.Out_Tog = ( xfer.Tog & USBFS_UH_T_TOG ) ? 1 : 0;
+        if( ( Sim_Dev.Out_Len != len ) || memcmp( Sim_Dev.Out_Buf, buf, len ) )
+        {
+            printf( "  %u bytes: the device took %u\n", len, Sim_Dev.Out_Len );
+            bad++;
+        }
+    }
+    return bad;
+}
+
+static int Sim_Test_Buffered( void )
+{
+    int bad = 0;
+
+    Sim_Init( );
+    USBH_Xfer_Init( );
+    Sim_Host.Transact = Sim_Xfer_Transact;
+    Sim_Dev.Ack_Loss = 100;
+    bad += Sim_Buffered( USB_PID_IN << 4 | 2, 1000 );
+    bad += Sim_Buffered( USB_PID_IN << 4 | 2, 1024 );
+    bad += Sim_Buffered( USB_PID_OUT << 4 | 1, 200 );
+    bad += Sim_Buffered( USB_PID_IN << 4 | 2, 37 );
+    if( Sim_Dev.Err )
+    {
+        bad++;
+    }
+    return bad;
+}
+
+/*********************************************************************
+ * @fn      Sim_Self_Test
+ *
+ * @brief   Run every self-test case, each in its own process.
+ *
+ * @return  number of failed cases
+ */
+static int Sim_Self_Test( void )
+{
+    static const struct
+    {
+        const char *Name;
+        int ( *Run )( void );
+    } test[ ] =
+    {
+        { "polled loop and engine: same codes after the same tokens", Sim_Test_Codes },
+        { "engine: 400 sector reads with NAKs and lost ACKs", Sim_Test_Reads },
+        { "engine: sector reads with an interrupt IN reader alongside", Sim_Test_Ep3 },
+        { "engine: buffered IN and OUT transfers", Sim_Test_Buffered },
+    };
+    pid_t pid;
+    int i, st, fail = 0;
+
+    for( i = 0; i < (int)( sizeof( test ) / sizeof( test[ 0 ] ) ); i++ )
+    {
+        printf( "%s\n", test[ i ].Name );
+        fflush( stdout );
+        pid = fork( );
+        if( pid == 0 )
+        {
+            st = test[ i ].Run( );
+            fflush( stdout );
+            _exit( st ? 1 : 0 );
+        }
+        if( ( pid < 0 ) || ( waitpid( pid, &st, 0 ) != pid ) || !WIFEXITED( st ) || WEXITSTATUS( st ) )
+        {
+            printf( "  FAIL\n" );
+            fail++;
+        }
+        else
+        {
+            printf( "  ok\n" );
+        }
+    }
+    printf( "%s\n", fail ? "self-test FAILED" : "self-test passed" );
+    return fail;
+}
+
+static void Sim_Report( const char *way, uint32_t num, uint64_t us, uint64_t idle )
+{
+    printf( "  %-28s %6u.%03ums, %4u KB/s, CPU busy %5.1f%%\n", way,
+            (uint32_t)( us / 1000 ), (uint32_t)( us % 1000 ), (uint32_t)( (uint64_t)num * 512 * 1000000 / 1024 / us ),
+            100.0 * ( us - idle ) / us );
+}
+
+int main( int argc, char **argv )
+{
+    int c, test = 0;
+    uint32_t num = 400, latency = 300;
+    uint64_t us, idle;
+    uint8_t s;
+
+    while( ( c = getopt( argc, argv, "n:l:i:w:t" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 'n':
+                num = strtoul( optarg, NULL, 0 );
+                break;
+            case 'l':
+                latency = strtoul( optarg, NULL, 0 );
+                break;
+            case 'i':
+                Sim_Isr_Us = strtoul( optarg, NULL, 0 );
+                break;
+            case 'w':
+                Sim_Work_Us = strtoul( optarg, NULL, 0 );
+                break;
+            case 't':
+                test = 1;
+                break;
+            default:
+                fprintf( stderr, "usage: %s [-n sectors] [-l us] [-i us] [-w us] | -t\n", argv[ 0 ] );
+                return 2;
+        }
+    }
+    if( test )
+    {
+        return Sim_Self_Test( ) ? 1 : 0;
+    }
+    if( num == 0 )
+    {
+        fprintf( stderr, "at least one sector\n" );
+        return 2;
+    }
+
+    printf( "%u sectors, one command in three waits %uus, %uus per interrupt, %uus work per packet\n",
+            num, latency, Sim_Isr_Us, Sim_Work_Us );
+    Sim_Init( );
+    Sim_Dev.Latency = latency;
+    s = Sim_Read_Run( num, &us, &idle );
+    if( ( s != ERR_SUCCESS ) || Sim_Host.Bad || Sim_Dev.Err )
+    {
+        printf( "polled loop failed: %02X\n", s );
+        return 1;
+    }
+    Sim_Report( "polled loop:", num, us, idle );
+
+    USBH_Xfer_Init( );
+    Sim_Host.Transact = Sim_Xfer_Transact;
+    s = Sim_Read_Run( num, &us, &idle );
+    if( ( s != ERR_SUCCESS ) || Sim_Host.Bad || Sim_Dev.Err )
+    {
+        printf( "engine failed: %02X\n", s );
+        return 1;
+    }
+    Sim_Report( "engine:", num, us, idle );
+
+    Sim_Ep3_Start( );
+    s = Sim_Read_Run( num, &us, &idle );
+    if( ( s != ERR_SUCCESS ) || Sim_Host.Bad || Sim_Dev.Err || Sim_Ep3_Bad )
+    {
+        printf( "engine with endpoint 3 failed: %02X\n", s );
+        return 1;
+    }
+    Sim_Report( "engine, endpoint 3 reader:", num, us, idle );
+    printf( "  endpoint 3: %u packets, %u bytes\n", Sim_Ep3_Pkts, Sim_Ep3_Bytes );
+    return 0;
+}
@@ -0,0 +1,634 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : usb_host_xfer.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Interrupt driven transaction engine of the USBFS host.
+ *                      Transfers are queued and run from the USBFS interrupt:
+ *                      every completed packet starts the next one at once, a
+ *                      NAKed transfer is set aside until the next SOF instead
+ *                      of being spun on, so the others keep the bus, and the
+ *                      waiting code sleeps in WFI.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+/********************************************************************************/
+/* Header File */
+#include "usb_host_config.h"
+
+/*******************************************************************************/
+/* Macro Definition */
+
+/* Engine State */
+#define XFER_IDLE                       0x00
+#define XFER_TOKEN                      0x01                                    // Token on the bus
+
+/*******************************************************************************/
+/* Variable Definition */
+volatile USBH_XFER_STAT USBH_Xfer_Stat;
+void ( *USBH_Xfer_Idle_Hook )( void );                                          // Other work done while waiting, may be NULL
+
+USBH_XFER *Xfer_Head;
+USBH_XFER *Xfer_Tail;
+USBH_XFER *Xfer_Nak_Head;                                                       // NAKed, queued again on the next SOF
+USBH_XFER *Xfer_Nak_Tail;
+volatile uint8_t Xfer_State;
+volatile uint8_t Xfer_Hold;                                                     // Registers still belong to a finished raw transfer
+uint8_t   Xfer_Token_Sof;                                                       // SOFs seen since the token was started
+volatile uint32_t Xfer_Time;
+uint16_t  Xfer_Tim_Last;
+volatile uint8_t Xfer_Sleeping;
+uint16_t  Xfer_Wake_Cnt;                                                        // TIM2 at the interrupt that ended WFI
+
+/* Registers of the synchronous callers, kept across buffered transfers */
+struct
+{
+    uint16_t Rx_Dma;
+    uint16_t Tx_Dma;
+    uint8_t  Tx_Len;
+    uint8_t  Rx_Ctrl;
+    uint8_t  Tx_Ctrl;
+} Xfer_Ctx;
+
+void USBFS_IRQHandler( void ) __attribute__((interrupt("WCH-Interrupt-fast")));
+
+/*********************************************************************
+ * @fn      Xfer_Time_Update
+ *
+ * @brief   Extend the 16-bit TIM2 count to the 32-bit time base. Called
+ *          with the USBFS interrupt masked or from it, at least every 65ms.
+ *
+ * @return  none
+ */
+static void Xfer_Time_Update( void )
+{
+#if DEF_USBH_XFER_STAT
+    uint16_t cnt;
+
+    cnt = TIM2->CNT;
+    Xfer_Time += (uint16_t)( cnt - Xfer_Tim_Last );
+    Xfer_Tim_Last = cnt;
+#endif
+}
+
+/*********************************************************************
+ * @fn      Xfer_Token
+ *
+ * @brief   Put the token of the head transfer on the bus. Buffered
+ *          transfers point the DMA at their own buffer, the last IN
+ *          packet of a buffer that cannot take a whole one goes through
+ *          USBFS_RX_Buf.
+ *
+ * @return  none
+ */
+static void Xfer_Token( void )
+{
+    USBH_XFER *px = Xfer_Head;
+    uint16_t  rem;
+
+    if( px->pBuf )
+    {
+        rem = px->Len - px->Actual;
+        if( ( px->Endp_Pid >> 4 ) == USB_PID_IN )
+        {
+            USBFSH->HOST_RX_DMA = ( rem < px->Max_Pkt )? (uint32_t)USBFS_RX_Buf : (uint32_t)( px->pBuf + px->Actual );
+        }
+        else
+        {
+            USBFSH->HOST_TX_DMA = (uint32_t)( px->pBuf + px->Actual );
+            USBFSH->HOST_TX_LEN = ( rem < px->Max_Pkt )? rem : px->Max_Pkt;
+        }
+    }
+    USBFSH->HOST_TX_CTRL = USBFSH->HOST_RX_CTRL = px->Tog;
+    Xfer_State = XFER_TOKEN;
+    Xfer_Token_Sof = 0;
+    USBH_Xfer_Stat.Pkt++;
+    USBFSH->HOST_EP_PID = px->Endp_Pid;                                         // Specify token PID and endpoint number
+    USBFSH->INT_FG = USBFS_UIF_TRANSFER;                                        // Allow transmission
+}
+
+/*********************************************************************
+ * @fn      Xfer_Start
+ *
+ * @brief   Start the transfer at the head of the queue.
+ *
+ * @return  none
+ */
+static void Xfer_Start( void )
+{
+    if( Xfer_Head->pBuf )
+    {
+        Xfer_Ctx.Rx_Dma = USBFSH->HOST_RX_DMA;
+        Xfer_Ctx.Tx_Dma = USBFSH->HOST_TX_DMA;
+        Xfer_Ctx.Tx_Len = USBFSH->HOST_TX_LEN;
+        Xfer_Ctx.Rx_Ctrl = USBFSH->HOST_RX_CTRL;
+        Xfer_Ctx.Tx_Ctrl = USBFSH->HOST_TX_CTRL;
+    }
+    Xfer_Token( );
+}
+
+/*********************************************************************
+ * @fn      Xfer_Unlink
+ *
+ * @brief   Take the head transfer off the bus and out of the queue,
+ *          giving the registers back to the synchronous callers.
+ *
+ * @return  The transfer.
+ */
+static USBH_XFER *Xfer_Unlink( void )
+{
+    USBH_XFER *px = Xfer_Head;
+
+    if( px->pBuf )
+    {
+        USBFSH->HOST_RX_DMA = Xfer_Ctx.Rx_Dma;
+        USBFSH->HOST_TX_DMA = Xfer_Ctx.Tx_Dma;
+        USBFSH->HOST_TX_LEN = Xfer_Ctx.Tx_Len;
+        USBFSH->HOST_RX_CTRL = Xfer_Ctx.Rx_Ctrl;
+        USBFSH->HOST_TX_CTRL = Xfer_Ctx.Tx_Ctrl;
+    }
+    Xfer_Head = px->Next;
+    if( Xfer_Head == NULL )
+    {
+        Xfer_Tail = NULL;
+    }
+    px->Next = NULL;
+    Xfer_State = XFER_IDLE;
+
+    return px;
+}
+
+/*********************************************************************
+ * @fn      Xfer_Park
+ *
+ * @brief   Set the NAKed head transfer aside until the next SOF and
+ *          give the bus to the next one.
+ *
+ * @return  none
+ */
+static void Xfer_Park( void )
+{
+    USBH_XFER *px = Xfer_Unlink( );
+
+    if( Xfer_Nak_Tail )
+    {
+        Xfer_Nak_Tail->Next = px;
+    }
+    else
+    {
+        Xfer_Nak_Head = px;
+    }
+    Xfer_Nak_Tail = px;
+
+    if( Xfer_Head )
+    {
+        Xfer_Start( );
+    }
+}
+
+/*********************************************************************
+ * @fn      Xfer_Finish
+ *
+ * @brief   Complete the head transfer and start the next one, unless
+ *          the finished one keeps the controller for its caller.
+ *
+ * @para    s: Transfer result.
+ *
+ * @return  none
+ */
+static void Xfer_Finish( uint8_t s )
+{
+    USBH_XFER *px = Xfer_Unlink( );
+
+    if( px->Hold )
+    {
+        Xfer_Hold = 1;
+    }
+
+    USBH_Xfer_Stat.Xfer++;
+    if( s != ERR_SUCCESS )
+    {
+        USBH_Xfer_Stat.Err++;
+    }
+    px->Status = s;
+    if( px->Done )
+    {
+        px->Done( px );
+    }
+
+    if( ( Xfer_Hold == 0 ) && Xfer_Head )
+    {
+        Xfer_Start( );
+    }
+}
+
+/*********************************************************************
+ * @fn      Xfer_Result
+ *
+ * @brief   Handle the end of a transaction, the same decisions as the
+ *          polled USBFSH_Transact.
+ *
+ * @para    st: INT_ST of the transaction.
+ *
+ * @return  none
+ */
+static void Xfer_Result( uint8_t st )
+{
+    USBH_XFER *px = Xfer_Head;
+    uint8_t   pid = px->Endp_Pid >> 4;
+    uint8_t   r;
+    uint16_t  n, rem;
+
+    if( st & USBFS_UIS_TOG_OK )
+    {
+        px->Retry = 0;
+        if( pid == USB_PID_IN )
+        {
+            n = USBFSH->RX_LEN;
+            if( px->pBuf )
+            {
+                rem = px->Len - px->Actual;
+                if( rem < px->Max_Pkt )
+                {
+                    memcpy( px->pBuf + px->Actual, USBFS_RX_Buf, ( n < rem )? n : rem );
+                }
+                px->Actual += ( n < rem )? n : rem;
+                px->Tog ^= USBFS_UH_R_TOG;
+                if( ( n == px->Max_Pkt ) && ( px->Actual < px->Len ) )
+                {
+                    Xfer_Token( );
+                    return;
+                }
+            }
+            else
+            {
+                px->Actual = n;
+            }
+        }
+        else
+        {
+            px->Actual += USBFSH->HOST_TX_LEN;
+            if( px->pBuf )
+            {
+                px->Tog ^= USBFS_UH_T_TOG;
+                if( px->Actual < px->Len )
+                {
+                    Xfer_Token( );
+                    return;
+                }
+            }
+        }
+        Xfer_Finish( ERR_SUCCESS );
+        return;
+    }
+
+    r = st & USBFS_UIS_H_RES_MASK;                                              // USB device answer status
+    if( r == USB_PID_NAK )
+    {
+        USBH_Xfer_Stat.Nak++;
+        if( ( px->Nak_Cnt >= px->Nak_Limit ) && ( px->Nak_Limit != DEF_USBH_XFER_NAK_FOREVER ) )
+        {
+            Xfer_Finish( r | ERR_USB_TRANSFER );
+        }
+        else
+        {
+            px->Nak_Cnt++;
+            USBH_Xfer_Stat.Sof_Retry++;
+            Xfer_Park( );
+        }
+    }
+    else if( ( r == 0 ) || ( ( pid == USB_PID_IN ) && ( ( r == USB_PID_DATA0 ) || ( r == USB_PID_DATA1 ) ) ) )
+    {
+        /* No answer, or a repeated IN packet whose ACK was lost */
+        if( ( USBFSH->INT_FG & USBFS_UIF_DETECT ) && ( USBFSH_CheckRootHubPortEnable( ) == 0 ) )
+        {
+            Xfer_Finish( ERR_USB_DISCON );                                      // USB device disconnect event
+        }
+        else if( ++px->Retry >= DEF_USBH_XFER_RETRY )
+        {
+            Xfer_Finish( ERR_USB_TRANSFER );                                    // Reply timeout
+        }
+        else
+        {
+            Xfer_Token( );
+        }
+    }
+    else
+    {
+        Xfer_Finish( r | ERR_USB_TRANSFER );                                    // STALL, or an answer that does not fit the token
+    }
+}
+
+/*********************************************************************
+ * @fn      USBFS_IRQHandler
+ *
+ * @brief   This function handles USBFS host interrupt request.
+ *
+ * @return  none
+ */
+void USBFS_IRQHandler( void )
+{
+    uint8_t fg = USBFSH->INT_FG;
+
+#if DEF_USBH_XFER_STAT
+    if( Xfer_Sleeping )
+    {
+        Xfer_Wake_Cnt = TIM2->CNT;
+        Xfer_Sleeping = 0;
+    }
+#endif
+    if( fg & USBFS_UIF_TRANSFER )
+    {
+        USBFSH->HOST_EP_PID = 0x00;                                             // Stop USB transfer
+        if( Xfer_State == XFER_TOKEN )
+        {
+            Xfer_Result( USBFSH->INT_ST );
+        }
+        if( Xfer_State != XFER_TOKEN )
+        {
+            USBFSH->INT_FG = USBFS_UIF_TRANSFER;
+        }
+    }
+
+    if( fg & USBFS_UIF_HST_SOF )
+    {
+        USBFSH->INT_FG = USBFS_UIF_HST_SOF;
+#if DEF_USBH_XFER_STAT
+        Xfer_Time_Update( );
+#else
+        Xfer_Time += 1000;
+#endif
+        if( ( Xfer_State == XFER_TOKEN ) && ( ++Xfer_Token_Sof >= DEF_USBH_XFER_STUCK_SOF ) )
+        {
+            USBFSH->HOST_EP_PID = 0x00;
+            Xfer_Finish( ERR_USB_UNKNOWN );
+            if( Xfer_State != XFER_TOKEN )
+            {
+                USBFSH->INT_FG = USBFS_UIF_TRANSFER;
+            }
+        }
+        if( Xfer_Nak_Head )
+        {
+            if( Xfer_Tail )
+            {
+                Xfer_Tail->Next = Xfer_Nak_Head;
+            }
+            else
+            {
+                Xfer_Head = Xfer_Nak_Head;
+            }
+            Xfer_Tail = Xfer_Nak_Tail;
+            Xfer_Nak_Head = NULL;
+            Xfer_Nak_Tail = NULL;
+            if( ( Xfer_State == XFER_IDLE ) && ( Xfer_Hold == 0 ) )
+            {
+                Xfer_Start( );
+            }
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      USBH_Xfer_Init
+ *
+ * @brief   Move the USBFS host from polling to the interrupt. Call after
+ *          USBFS_Host_Init. Device attach is still found by polling
+ *          INT_FG as before, so its interrupt stays disabled.
+ *
+ * @return  none
+ */
+void USBH_Xfer_Init( void )
+{
+    NVIC_InitTypeDef NVIC_InitStructure = { 0 };
+#if DEF_USBH_XFER_STAT
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure = { 0 };
+
+    /* Free running 1MHz counter for the time base */
+    RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM2, ENABLE );
+    TIM_TimeBaseStructure.TIM_Period = 0xFFFF;
+    TIM_TimeBaseStructure.TIM_Prescaler = SystemCoreClock / 1000000 - 1;
+    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseInit( TIM2, &TIM_TimeBaseStructure );
+    TIM_Cmd( TIM2, ENABLE );
+    Xfer_Tim_Last = TIM2->CNT;
+#endif
+
+    NVIC_DisableIRQ( USBFS_IRQn );
+    Xfer_Head = NULL;
+    Xfer_Tail = NULL;
+    Xfer_Nak_Head = NULL;
+    Xfer_Nak_Tail = NULL;
+    Xfer_State = XFER_IDLE;
+    Xfer_Hold = 0;
+    Xfer_Time = 0;
+    memset( (void *)&USBH_Xfer_Stat, 0, sizeof( USBH_Xfer_Stat ) );
+
+    USBFSH->HOST_EP_PID = 0x00;
+    USBFSH->INT_FG = USBFS_UIF_TRANSFER | USBFS_UIF_HST_SOF;
+    USBFSH->INT_EN = USBFS_UIE_TRANSFER | USBFS_UIE_HST_SOF;
+
+    NVIC_InitStructure.NVIC_IRQChannel = USBFS_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init( &NVIC_InitStructure );
+    NVIC_EnableIRQ( USBFS_IRQn );
+}
+
+/*********************************************************************
+ * @fn      USBH_Xfer_Submit
+ *
+ * @brief   Queue a transfer and start it if the bus is free. Endp_Pid,
+ *          Tog, pBuf, Len, Max_Pkt, Nak_Limit, Hold and Done are set by
+ *          the caller; the transfer must stay in place until it finishes.
+ *
+ * @para    pxfer: The transfer.
+ *
+ * @return  ERR_SUCCESS, or ERR_USB_UNKNOWN if it is already queued.
+ */
+uint8_t USBH_Xfer_Submit( USBH_XFER *pxfer )
+{
+    if( pxfer->Status == USBH_XFER_PENDING )
+    {
+        return ERR_USB_UNKNOWN;
+    }
+    pxfer->Next = NULL;
+    pxfer->Actual = 0;
+    pxfer->Nak_Cnt = 0;
+    pxfer->Retry = 0;
+    pxfer->Status = USBH_XFER_PENDING;
+
+    NVIC_DisableIRQ( USBFS_IRQn );
+    if( Xfer_Tail )
+    {
+        Xfer_Tail->Next = pxfer;
+    }
+    else
+    {
+        Xfer_Head = pxfer;
+    }
+    Xfer_Tail = pxfer;
+    Xfer_Hold = 0;
+    if( Xfer_State == XFER_IDLE )
+    {
+        Xfer_Start( );
+    }
+    NVIC_EnableIRQ( USBFS_IRQn );
+
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      USBH_Xfer_Release
+ *
+ * @brief   Give the controller back to the queue after a raw transfer
+ *          whose caller has read its results. Submit and Wait do this.
+ *
+ * @return  none
+ */
+void USBH_Xfer_Release( void )
+{
+    NVIC_DisableIRQ( USBFS_IRQn );
+    Xfer_Hold = 0;
+    if( ( Xfer_State == XFER_IDLE ) && Xfer_Head )
+    {
+        Xfer_Start( );
+    }
+    NVIC_EnableIRQ( USBFS_IRQn );
+}
+
+/*********************************************************************
+ * @fn      Xfer_Sleep
+ *
+ * @brief   Sleep until a transfer finishes. The SOF interrupt wakes the
+ *          CPU every 1ms, so a completion landing just before WFI costs
+ *          at most one frame. Idle time ends where the waking interrupt
+ *          starts, the handlers themselves count as busy.
+ *
+ * @para    pxfer: The transfer.
+ *
+ * @return  Transfer result.
+ */
+static uint8_t Xfer_Sleep( USBH_XFER *pxfer )
+{
+#if DEF_USBH_XFER_STAT
+    uint16_t cnt;
+#endif
+
+    while( pxfer->Status == USBH_XFER_PENDING )
+    {
+        if( USBH_Xfer_Idle_Hook )
+        {
+            USBH_Xfer_Idle_Hook( );
+            if( pxfer->Status != USBH_XFER_PENDING )
+            {
+                break;
+            }
+        }
+#if DEF_USBH_XFER_STAT
+        cnt = TIM2->CNT;
+        Xfer_Sleeping = 1;
+        __WFI( );
+        if( Xfer_Sleeping )
+        {
+            Xfer_Sleeping = 0;
+            Xfer_Wake_Cnt = TIM2->CNT;                                          // Woken by another interrupt
+        }
+        USBH_Xfer_Stat.Idle_Us += (uint16_t)( Xfer_Wake_Cnt - cnt );
+#else
+        __WFI( );
+#endif
+        USBH_Xfer_Stat.Wake++;
+    }
+
+    return pxfer->Status;
+}
+
+/*********************************************************************
+ * @fn      USBH_Xfer_Wait
+ *
+ * @brief   Wait for a submitted transfer, running USBH_Xfer_Idle_Hook
+ *          and sleeping in between.
+ *
+ * @para    pxfer: The transfer.
+ *
+ * @return  Transfer result.
+ */
+uint8_t USBH_Xfer_Wait( USBH_XFER *pxfer )
+{
+    USBH_Xfer_Release( );
+    return Xfer_Sleep( pxfer );
+}
+
+/*********************************************************************
+ * @fn      USBH_Xfer_Transact
+ *
+ * @brief   One transaction with the arguments and results of the polled
+ *          USBFSH_Transact: the caller sets the DMA and length registers
+ *          before, and reads RX_LEN and the buffers after it. Queued
+ *          transfers may run first; they leave those registers as found.
+ *
+ * @para    endp_pid: Token PID.
+ *          tog: Toggle.
+ *          timeout: NAKs accepted, 0 - return at the first one, 0xFFFF
+ *                   and above - wait for the device forever.
+ *
+ * @return  USB transfer result.
+ */
+uint8_t USBH_Xfer_Transact( uint8_t endp_pid, uint8_t tog, uint32_t timeout )
+{
+    USBH_XFER xfer;
+
+    xfer.pBuf = NULL;
+    xfer.Len = 0;
+    xfer.Max_Pkt = 0;
+    xfer.Endp_Pid = endp_pid;
+    xfer.Tog = tog;
+    xfer.Nak_Limit = ( timeout >= DEF_USBH_XFER_NAK_FOREVER )? DEF_USBH_XFER_NAK_FOREVER : timeout;
+    xfer.Hold = 1;
+    xfer.Done = NULL;
+    xfer.Status = ERR_SUCCESS;
+    USBH_Xfer_Submit( &xfer );
+
+    return Xfer_Sleep( &xfer );
+}
+
+/*********************************************************************
+ * @fn      USBH_Xfer_Us
+ *
+ * @brief   Current time, 1us resolution from TIM2 (1ms from the SOF
+ *          count with DEF_USBH_XFER_STAT off).
+ *
+ * @return  Time in us, wraps after about 71 minutes.
+ */
+uint32_t USBH_Xfer_Us( void )
+{
+    uint32_t t;
+
+    NVIC_DisableIRQ( USBFS_IRQn );
+    Xfer_Time_Update( );
+    t = Xfer_Time;
+    NVIC_EnableIRQ( USBFS_IRQn );
+
+    return t;
+}
+
+/*********************************************************************
+ * @fn      USBH_Xfer_Stat_Print
+ *
+ * @brief   Print the engine counters.
+ *
+ * @return  none
+ */
+void USBH_Xfer_Stat_Print( void )
+{
+    printf( "Xfer %d, Err %d, Pkt %d, NAK %d, SOF Retry %d, Wake %d, Idle %dms\r\n",
+            (int)USBH_Xfer_Stat.Xfer, (int)USBH_Xfer_Stat.Err, (int)USBH_Xfer_Stat.Pkt,
+            (int)USBH_Xfer_Stat.Nak, (int)USBH_Xfer_Stat.Sof_Retry, (int)USBH_Xfer_Stat.Wake,
+            (int)( USBH_Xfer_Stat.Idle_Us / 1000 ) );
+}
@@ -0,0 +1,108 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : usb_host_xfer.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Interrupt driven transaction engine of the USBFS host.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+#ifndef __USB_HOST_XFER_H
+#define __USB_HOST_XFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************/
+/* Header File */
+#include "stdint.h"
+
+/*******************************************************************************/
+/* Macro Definition */
+
+/* 1 - USBFSH_Transact, and the U-disk library through it, waits for its
+ * transactions in the USBFS interrupt with the CPU asleep, 0 - the polled
+ * loop as before. Uses TIM2 and USBFS_IRQHandler. */
+#ifndef DEF_USBH_XFER_EN
+#define DEF_USBH_XFER_EN                1
+#endif
+
+/* Transactions that got no answer or a repeated IN packet before giving up */
+#define DEF_USBH_XFER_RETRY             10
+
+/* Nak_Limit: retry on every frame until the device answers */
+#define DEF_USBH_XFER_NAK_FOREVER       0xFFFF
+
+/* Frames a token may stay unanswered before the transfer is failed */
+#define DEF_USBH_XFER_STUCK_SOF         3
+
+/* Idle and busy time counted with TIM2 running at 1MHz, 0 - off */
+#ifndef DEF_USBH_XFER_STAT
+#define DEF_USBH_XFER_STAT              1
+#endif
+
+/* Status while queued or on the bus, any other value is the result */
+#define USBH_XFER_PENDING               0xFF
+
+/*******************************************************************************/
+/* Struct Definition */
+
+/* One transfer. With pBuf set it is split into Max_Pkt packets that are moved
+ * by DMA straight from or to pBuf (RAM, 4-byte aligned), ending at Len or at a
+ * short IN packet; Tog follows the packets. With pBuf NULL it is a single
+ * transaction on whatever the caller left in the DMA and length registers,
+ * as USBFSH_Transact does. */
+typedef struct _USBH_XFER
+{
+    struct _USBH_XFER *Next;
+    uint8_t  *pBuf;
+    uint16_t Len;
+    uint16_t Actual;                                                            // Bytes moved so far
+    uint16_t Max_Pkt;
+    uint16_t Nak_Limit;                                                         // NAKs accepted, 0 - fail at the first one
+    uint16_t Nak_Cnt;
+    uint8_t  Endp_Pid;                                                          // Token PID << 4 | endpoint
+    uint8_t  Tog;                                                               // Written to HOST_RX_CTRL and HOST_TX_CTRL
+    uint8_t  Retry;
+    uint8_t  Hold;                                                              // Keep the controller until the next engine call
+    volatile uint8_t Status;
+    void     ( *Done )( struct _USBH_XFER *pxfer );                             // Called in the interrupt, may be NULL
+    void     *pCtx;
+} USBH_XFER, *PUSBH_XFER;
+
+typedef struct _USBH_XFER_STAT
+{
+    uint32_t Xfer;
+    uint32_t Err;
+    uint32_t Pkt;                                                               // Tokens put on the bus
+    uint32_t Nak;
+    uint32_t Sof_Retry;                                                         // Tokens sent again on the next frame
+    uint32_t Wake;                                                              // Returns from WFI while waiting
+    uint32_t Idle_Us;                                                           // Time spent in WFI while waiting
+} USBH_XFER_STAT;
+
+/*******************************************************************************/
+/* Variable Declaration */
+extern volatile USBH_XFER_STAT USBH_Xfer_Stat;
+extern void ( *USBH_Xfer_Idle_Hook )( void );
+
+/*******************************************************************************/
+/* Function Declaration */
+extern void USBH_Xfer_Init( void );
+extern uint8_t USBH_Xfer_Submit( USBH_XFER *pxfer );
+extern uint8_t USBH_Xfer_Wait( USBH_XFER *pxfer );
+extern void USBH_Xfer_Release( void );
+extern uint8_t USBH_Xfer_Transact( uint8_t endp_pid, uint8_t tog, uint32_t timeout );
+extern uint32_t USBH_Xfer_Us( void );
+extern void USBH_Xfer_Stat_Print( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -27,6 +27,9 @@ uint8_t USBHostTransact( uint8_t endp_pid, uint8_t tog, uint32_t timeout )
     uint8_t  r, trans_rerty;
     uint16_t i;
 
+#if DEF_USBH_XFER_EN
+    return USBH_Xfer_Transact( endp_pid, tog, timeout );
+#endif
     USBFSH->HOST_TX_CTRL = USBFSH->HOST_RX_CTRL = tog;
     trans_rerty = 0;
     do
@@ -76,7 +79,7 @@ uint8_t USBHostTransact( uint8_t endp_pid, uint8_t tog, uint32_t timeout )
                     }
                     break;
                 case USB_PID_IN:
-                    if( ( r == USB_PID_DATA0 ) && ( r == USB_PID_DATA1 ) )
+                    if( ( r == USB_PID_DATA0 ) || ( r == USB_PID_DATA1 ) )
                     {
                         ;
                     }
@@ -200,7 +203,12 @@ uint8_t	DISK_BASE_BUF[ DISK_BASE_BUF_LEN ] __attribute__((aligned (4)));
 //    CHRV3DiskStatus=DISK_MOUNTED;  // ǿƿ豸ӳɹ(ֻļϵͳ)
 //}
 
-uint8_t	CHRV3ReadSector( uint8_t SectCount, uint8_t *DataBuf )  /* Ӵ̶ȡݵ */
+uint8_t	CHRV3ReadSector( uint8_t SectCount, uint8_t *DataBuf )  /* Read CHRV3vLbaCurrent.., through the sector cache */
+{
+	return( CHRV3CacheRead( CHRV3vLbaCurrent, SectCount, DataBuf ) );
+}
+
+uint8_t	CHRV3ReadSectorRaw( uint32_t lba, uint8_t SectCount, uint8_t *DataBuf )  /* Ӵ̶ȡݵ */
 {
     uint8_t	retry;
 //	if ( use_external_interface ) return( extReadSector( CHRV3vLbaCurrent, SectCount, DataBuf ) );  /* ⲿӿ */
@@ -211,10 +219,10 @@ uint8_t	CHRV3ReadSector( uint8_t SectCount, uint8_t *DataBuf )  /* 
 		pCBW -> mCBW_CB_Len = 10;
 		pCBW -> mCBW_CB_Buf[ 0 ] = SPC_CMD_READ10;
 		pCBW -> mCBW_CB_Buf[ 1 ] = 0x00;
-		pCBW -> mCBW_CB_Buf[ 2 ] = (uint8_t)( CHRV3vLbaCurrent >> 24 );
-		pCBW -> mCBW_CB_Buf[ 3 ] = (uint8_t)( CHRV3vLbaCurrent >> 16 );
-		pCBW -> mCBW_CB_Buf[ 4 ] = (uint8_t)( CHRV3vLbaCurrent >> 8 );
-		pCBW -> mCBW_CB_Buf[ 5 ] = (uint8_t)( CHRV3vLbaCurrent );
+		pCBW -> mCBW_CB_Buf[ 2 ] = (uint8_t)( lba >> 24 );
+		pCBW -> mCBW_CB_Buf[ 3 ] = (uint8_t)( lba >> 16 );
+		pCBW -> mCBW_CB_Buf[ 4 ] = (uint8_t)( lba >> 8 );
+		pCBW -> mCBW_CB_Buf[ 5 ] = (uint8_t)( lba );
 		pCBW -> mCBW_CB_Buf[ 6 ] = 0x00;
 		pCBW -> mCBW_CB_Buf[ 7 ] = 0x00;
 		pCBW -> mCBW_CB_Buf[ 8 ] = SectCount;
@@ -232,7 +240,12 @@ uint8_t	CHRV3ReadSector( uint8_t SectCount, uint8_t *DataBuf )  /* 
 }
 
 #ifdef	EN_DISK_WRITE
-uint8_t	CHRV3WriteSector( uint8_t SectCount, uint8_t *DataBuf )  /* еĶݿд */
+uint8_t	CHRV3WriteSector( uint8_t SectCount, uint8_t *DataBuf )  /* Write CHRV3vLbaCurrent.., through the sector cache */
+{
+	return( CHRV3CacheWrite( CHRV3vLbaCurrent, SectCount, DataBuf ) );
+}
+
+uint8_t	CHRV3WriteSectorRaw( uint32_t lba, uint8_t SectCount, uint8_t *DataBuf )  /* еĶݿд */
 {
     uint8_t	retry;
 //	if ( use_external_interface ) return( extWriteSector( CHRV3vLbaCurrent, SectCount, DataBuf ) );  /* ⲿӿ */
@@ -243,10 +256,10 @@ uint8_t	CHRV3WriteSector( uint8_t SectCount, uint8_t *DataBuf )  /* 
 		pCBW -> mCBW_CB_Len = 10;
 		pCBW -> mCBW_CB_Buf[ 0 ] = SPC_CMD_WRITE10;
 		pCBW -> mCBW_CB_Buf[ 1 ] = 0x00;
-		pCBW -> mCBW_CB_Buf[ 2 ] = (uint8_t)( CHRV3vLbaCurrent >> 24 );
-		pCBW -> mCBW_CB_Buf[ 3 ] = (uint8_t)( CHRV3vLbaCurrent >> 16 );
-		pCBW -> mCBW_CB_Buf[ 4 ] = (uint8_t)( CHRV3vLbaCurrent >> 8 );
-		pCBW -> mCBW_CB_Buf[ 5 ] = (uint8_t)( CHRV3vLbaCurrent );
+		pCBW -> mCBW_CB_Buf[ 2 ] = (uint8_t)( lba >> 24 );
+		pCBW -> mCBW_CB_Buf[ 3 ] = (uint8_t)( lba >> 16 );
+		pCBW -> mCBW_CB_Buf[ 4 ] = (uint8_t)( lba >> 8 );
+		pCBW -> mCBW_CB_Buf[ 5 ] = (uint8_t)( lba );
 		pCBW -> mCBW_CB_Buf[ 6 ] = 0x00;
 		pCBW -> mCBW_CB_Buf[ 7 ] = 0x00;
 		pCBW -> mCBW_CB_Buf[ 8 ] = SectCount;
@@ -375,6 +388,7 @@ uint8_t	CHRV3LibInit( void )  /* 
 //	pDISK_FAT_BUF = & DISK_FAT_BUF[0];   /* ָⲿRAMĴFATݻ,pDISK_BASE_BUFٶ */
 /* ϣļȡٶ,ôеCHRV3LibInit֮,pDISK_FAT_BUFָһpDISK_BASE_BUFͬСĻ */
 #endif
+	CHRV3CacheInvalidate( );
 	CHRV3DiskStatus = DISK_UNKNOWN;  /* δ֪״̬ */
 	CHRV3vSectorSizeB = 9;  /* Ĭϵ̵512B */
 	CHRV3vSectorSize = 512; /* Ĭϵ̵512B,ֵǴ̵С */
@@ -0,0 +1,608 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : CH643UFI_Cache.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Sector cache between the U-disk file library and the
+ *                      Bulk-Only transport. The library asks for one sector
+ *                      at a time for FAT, directory and byte-mode file
+ *                      access; here sequential reads are turned into one
+ *                      READ(10) of a whole window, FAT and directory sectors
+ *                      are kept in a small LRU cache and consecutive writes
+ *                      are gathered into one WRITE(10).
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "debug.h"
+#include "string.h"
+#include "ch643.h"
+#include "usb_host_config.h"
+#include "CHRV3UFI.h"
+
+/*******************************************************************************/
+/* Variable Definition */
+UDISK_CACHE_STAT Udisk_Cache_Stat;
+
+#if DEF_UDISK_CACHE_EN
+/* LRU sectors */
+__attribute__((aligned(4))) uint8_t Cache_Line_Buf[ DEF_UDISK_CACHE_LINES ][ DEF_UDISK_CACHE_SECT_SIZE ];
+uint32_t Cache_Line_Lba[ DEF_UDISK_CACHE_LINES ];
+uint32_t Cache_Line_Use[ DEF_UDISK_CACHE_LINES ];                               // 0 - empty
+uint32_t Cache_Use;
+
+/* Window of Win_Cnt sectors from Win_Lba */
+__attribute__((aligned(4))) uint8_t Cache_Win_Buf[ DEF_UDISK_CACHE_WIN * DEF_UDISK_CACHE_SECT_SIZE ];
+uint32_t Cache_Win_Lba;
+uint8_t  Cache_Win_Cnt;
+uint8_t  Cache_Win_Dirty;
+
+uint32_t Cache_Seq_Lba;                                                         // Sector after the last read
+uint8_t  Cache_Lun;
+#endif
+
+#if DEF_UDISK_CACHE_BENCH
+uint8_t  Cache_Sim;                                                             // Sectors come from the simulated disk
+uint8_t  Cache_Bypass;
+uint32_t Sim_Bus_Us;
+#endif
+
+#if DEF_UDISK_CACHE_BENCH
+/*********************************************************************
+ * @fn      Sim_Read
+ *
+ * @brief   Simulated disk: word n of sector lba reads ( lba << 7 ) + n.
+ *          Only the bus time the transfer would have taken is counted.
+ *
+ * @return  ERR_SUCCESS, ERR_USB_DISK_ERR - past the end of the disk.
+ */
+static uint8_t Sim_Read( uint32_t lba, uint8_t cnt, uint8_t *buf )
+{
+    uint32_t *p = (uint32_t *)buf;
+    uint16_t i;
+
+    if( ( lba + cnt ) > DEF_UDISK_SIM_SECTORS )
+    {
+        return ( CHRV3IntStatus = ERR_USB_DISK_ERR );
+    }
+    Sim_Bus_Us += DEF_UDISK_SIM_CMD_US + (uint32_t)cnt * DEF_UDISK_SIM_SECT_US;
+    while( cnt-- )
+    {
+        for( i = 0; i < DEF_UDISK_CACHE_SECT_SIZE / 4; i++ )
+        {
+            *p++ = ( lba << 7 ) + i;
+        }
+        lba++;
+    }
+    return ERR_SUCCESS;
+}
+
+static uint8_t Sim_Write( uint32_t lba, uint8_t cnt, uint8_t *buf )
+{
+    if( ( lba + cnt ) > DEF_UDISK_SIM_SECTORS )
+    {
+        return ( CHRV3IntStatus = ERR_USB_DISK_ERR );
+    }
+    Sim_Bus_Us += DEF_UDISK_SIM_CMD_US + (uint32_t)cnt * DEF_UDISK_SIM_SECT_US;
+    return ERR_SUCCESS;
+}
+#endif
+
+/*********************************************************************
+ * @fn      Disk_Read
+ *
+ * @brief   Read sectors from the disk, one command.
+ *
+ * @return  Result of the command.
+ */
+static uint8_t Disk_Read( uint32_t lba, uint8_t cnt, uint8_t *buf )
+{
+    Udisk_Cache_Stat.Rd_Cmd++;
+#if DEF_UDISK_CACHE_BENCH
+    if( Cache_Sim )
+    {
+        return Sim_Read( lba, cnt, buf );
+    }
+#endif
+    return CHRV3ReadSectorRaw( lba, cnt, buf );
+}
+
+/*********************************************************************
+ * @fn      Disk_Write
+ *
+ * @brief   Write sectors to the disk, one command.
+ *
+ * @return  Result of the command.
+ */
+static uint8_t Disk_Write( uint32_t lba, uint8_t cnt, uint8_t *buf )
+{
+    Udisk_Cache_Stat.Wr_Cmd++;
+#if DEF_UDISK_CACHE_BENCH
+    if( Cache_Sim )
+    {
+        return Sim_Write( lba, cnt, buf );
+    }
+#endif
+    return CHRV3WriteSectorRaw( lba, cnt, buf );
+}
+
+#if DEF_UDISK_CACHE_EN
+/*********************************************************************
+ * @fn      CHRV3CacheInvalidate
+ *
+ * @brief   Forget every cached sector, written ones included. Called
+ *          when the disk goes away.
+ *
+ * @return  none
+ */
+void CHRV3CacheInvalidate( void )
+{
+    memset( Cache_Line_Use, 0, sizeof( Cache_Line_Use ) );
+    Cache_Use = 0;
+    Cache_Win_Cnt = 0;
+    Cache_Win_Dirty = 0;
+    Cache_Seq_Lba = 0xFFFFFFFF;
+}
+
+/*********************************************************************
+ * @fn      CHRV3CacheFlush
+ *
+ * @brief   Write the sectors held in the window to the disk. Call it
+ *          after closing a written file and before the disk is removed.
+ *
+ * @return  ERR_SUCCESS or the error of the write.
+ */
+uint8_t CHRV3CacheFlush( void )
+{
+    uint8_t s, lun;
+
+    if( ( Cache_Win_Dirty == 0 ) || ( Cache_Win_Cnt == 0 ) )
+    {
+        return ERR_SUCCESS;
+    }
+
+    /* The sectors belong to the unit they were written to */
+    lun = CHRV3vCurrentLun;
+    CHRV3vCurrentLun = Cache_Lun;
+    s = Disk_Write( Cache_Win_Lba, Cache_Win_Cnt, Cache_Win_Buf );
+    CHRV3vCurrentLun = lun;
+    if( s == ERR_SUCCESS )
+    {
+        Cache_Win_Dirty = 0;
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      Cache_Usable
+ *
+ * @brief   Caching only starts once the file system of the disk has been
+ *          analysed, so that a newly attached disk never sees sectors of
+ *          the one before it.
+ *
+ * @return  1 - cache the access, 0 - go straight to the disk.
+ */
+static uint8_t Cache_Usable( void )
+{
+#if DEF_UDISK_CACHE_BENCH
+    if( Cache_Bypass )
+    {
+        return 0;
+    }
+#endif
+    if( ( CHRV3DiskStatus < DISK_READY ) || ( CHRV3vSectorSize != DEF_UDISK_CACHE_SECT_SIZE ) )
+    {
+        CHRV3CacheInvalidate( );
+        return 0;
+    }
+    if( CHRV3vCurrentLun != Cache_Lun )
+    {
+        CHRV3CacheFlush( );
+        CHRV3CacheInvalidate( );
+        Cache_Lun = CHRV3vCurrentLun;
+    }
+    return 1;
+}
+
+/*********************************************************************
+ * @fn      Cache_Find
+ *
+ * @brief   Cached copy of one sector.
+ *
+ * @para    lba: Sector.
+ *          touch: 1 - count as a use of an LRU sector.
+ *
+ * @return  Sector data, NULL - not cached.
+ */
+static uint8_t *Cache_Find( uint32_t lba, uint8_t touch )
+{
+    uint8_t i;
+
+    if( ( lba - Cache_Win_Lba ) < Cache_Win_Cnt )
+    {
+        return &Cache_Win_Buf[ ( lba - Cache_Win_Lba ) * DEF_UDISK_CACHE_SECT_SIZE ];
+    }
+    for( i = 0; i < DEF_UDISK_CACHE_LINES; i++ )
+    {
+        if( Cache_Line_Use[ i ] && ( Cache_Line_Lba[ i ] == lba ) )
+        {
+            if( touch )
+            {
+                Cache_Line_Use[ i ] = ++Cache_Use;
+            }
+            return Cache_Line_Buf[ i ];
+        }
+    }
+    return NULL;
+}
+
+/*********************************************************************
+ * @fn      Cache_Fill_Line
+ *
+ * @brief   Read one sector into the least recently used line.
+ *
+ * @return  Result of the read.
+ */
+static uint8_t Cache_Fill_Line( uint32_t lba )
+{
+    uint8_t i, lru = 0;
+    uint8_t s;
+
+    for( i = 1; i < DEF_UDISK_CACHE_LINES; i++ )
+    {
+        if( Cache_Line_Use[ i ] < Cache_Line_Use[ lru ] )
+        {
+            lru = i;
+        }
+    }
+    Cache_Line_Use[ lru ] = 0;
+    s = Disk_Read( lba, 1, Cache_Line_Buf[ lru ] );
+    if( s == ERR_SUCCESS )
+    {
+        Cache_Line_Lba[ lru ] = lba;
+        Cache_Line_Use[ lru ] = ++Cache_Use;
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      Cache_Fill_Win
+ *
+ * @brief   Read a whole window from lba with one command. Near the end
+ *          of the disk the longer read fails, and only lba is read.
+ *
+ * @return  Result of the read.
+ */
+static uint8_t Cache_Fill_Win( uint32_t lba )
+{
+    uint8_t s;
+
+    s = CHRV3CacheFlush( );
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    Cache_Win_Cnt = 0;
+    s = Disk_Read( lba, DEF_UDISK_CACHE_WIN, Cache_Win_Buf );
+    if( s == ERR_SUCCESS )
+    {
+        Cache_Win_Lba = lba;
+        Cache_Win_Cnt = DEF_UDISK_CACHE_WIN;
+        Udisk_Cache_Stat.Rd_Ahead += DEF_UDISK_CACHE_WIN - 1;
+        return s;
+    }
+    if( s == ERR_USB_DISCON )
+    {
+        return s;
+    }
+    s = Disk_Read( lba, 1, Cache_Win_Buf );
+    if( s == ERR_SUCCESS )
+    {
+        Cache_Win_Lba = lba;
+        Cache_Win_Cnt = 1;
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      CHRV3CacheRead
+ *
+ * @brief   Read sectors for the file library. A sector missing from the
+ *          cache is read with the whole window after it if the library
+ *          is reading sequentially, into an LRU line if it is alone, and
+ *          together with the other missing sectors of a longer request
+ *          straight into DataBuf otherwise.
+ *
+ * @para    lba: First sector.
+ *          SectCount: Number of sectors.
+ *          DataBuf: Sector data.
+ *
+ * @return  ERR_SUCCESS or the error of the disk.
+ */
+uint8_t CHRV3CacheRead( uint32_t lba, uint8_t SectCount, uint8_t *DataBuf )
+{
+    uint8_t *p;
+    uint8_t  run, seq;
+    uint8_t  s;
+
+    if( Cache_Usable( ) == 0 )
+    {
+        return Disk_Read( lba, SectCount, DataBuf );
+    }
+
+    seq = ( lba == Cache_Seq_Lba );
+    Cache_Seq_Lba = lba + SectCount;
+    Udisk_Cache_Stat.Rd_Sect += SectCount;
+
+    while( SectCount )
+    {
+        p = Cache_Find( lba, 1 );
+        if( p )
+        {
+            memcpy( DataBuf, p, DEF_UDISK_CACHE_SECT_SIZE );
+            Udisk_Cache_Stat.Rd_Hit++;
+            lba++;
+            DataBuf += DEF_UDISK_CACHE_SECT_SIZE;
+            SectCount--;
+            continue;
+        }
+
+        /* Sectors missing from here on */
+        for( run = 1; ( run < SectCount ) && ( Cache_Find( lba + run, 0 ) == NULL ); run++ )
+        {
+            ;
+        }
+
+        if( seq && ( run < DEF_UDISK_CACHE_WIN ) )
+        {
+            s = Cache_Fill_Win( lba );
+        }
+        else if( run == 1 )
+        {
+            s = Cache_Fill_Line( lba );
+        }
+        else
+        {
+            s = Disk_Read( lba, run, DataBuf );
+            lba += run;
+            DataBuf += (uint32_t)run * DEF_UDISK_CACHE_SECT_SIZE;
+            SectCount -= run;
+        }
+        if( s != ERR_SUCCESS )
+        {
+            Cache_Seq_Lba = 0xFFFFFFFF;
+            return s;
+        }
+    }
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      CHRV3CacheWrite
+ *
+ * @brief   Write sectors for the file library. Cached copies are updated
+ *          first. A short write then joins the sectors held in the
+ *          window if it follows or overlaps them, else the window is
+ *          written out and starts again from this one; a long write goes
+ *          to the disk at once.
+ *
+ * @para    lba: First sector.
+ *          SectCount: Number of sectors.
+ *          DataBuf: Sector data.
+ *
+ * @return  ERR_SUCCESS or the error of the disk.
+ */
+uint8_t CHRV3CacheWrite( uint32_t lba, uint8_t SectCount, uint8_t *DataBuf )
+{
+    uint8_t *p;
+    uint8_t  i, j;
+    uint8_t  s;
+
+    if( Cache_Usable( ) == 0 )
+    {
+        return Disk_Write( lba, SectCount, DataBuf );
+    }
+
+    Udisk_Cache_Stat.Wr_Sect += SectCount;
+    for( i = 0; i < SectCount; i++ )
+    {
+        p = &DataBuf[ (uint32_t)i * DEF_UDISK_CACHE_SECT_SIZE ];
+        if( ( ( lba + i ) - Cache_Win_Lba ) < Cache_Win_Cnt )
+        {
+            memcpy( &Cache_Win_Buf[ ( lba + i - Cache_Win_Lba ) * DEF_UDISK_CACHE_SECT_SIZE ], p, DEF_UDISK_CACHE_SECT_SIZE );
+        }
+        /* An LRU copy may exist besides the window one */
+        for( j = 0; j < DEF_UDISK_CACHE_LINES; j++ )
+        {
+            if( Cache_Line_Use[ j ] && ( Cache_Line_Lba[ j ] == ( lba + i ) ) )
+            {
+                memcpy( Cache_Line_Buf[ j ], p, DEF_UDISK_CACHE_SECT_SIZE );
+            }
+        }
+    }
+
+#if DEF_UDISK_CACHE_WRITE_BACK
+    if( SectCount < DEF_UDISK_CACHE_WIN )
+    {
+        if( Cache_Win_Dirty && ( lba >= Cache_Win_Lba ) && ( ( lba - Cache_Win_Lba ) <= Cache_Win_Cnt ) &&
+            ( ( lba - Cache_Win_Lba + SectCount ) <= DEF_UDISK_CACHE_WIN ) )
+        {
+            /* Overlapping sectors were copied above */
+            memcpy( &Cache_Win_Buf[ ( lba - Cache_Win_Lba ) * DEF_UDISK_CACHE_SECT_SIZE ], DataBuf,
+                    (uint32_t)SectCount * DEF_UDISK_CACHE_SECT_SIZE );
+            if( ( lba - Cache_Win_Lba + SectCount ) > Cache_Win_Cnt )
+            {
+                Cache_Win_Cnt = lba - Cache_Win_Lba + SectCount;
+            }
+            Udisk_Cache_Stat.Wr_Merge += SectCount;
+            return ERR_SUCCESS;
+        }
+
+        s = CHRV3CacheFlush( );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        memcpy( Cache_Win_Buf, DataBuf, (uint32_t)SectCount * DEF_UDISK_CACHE_SECT_SIZE );
+        Cache_Win_Lba = lba;
+        Cache_Win_Cnt = SectCount;
+        Cache_Win_Dirty = 1;
+        return ERR_SUCCESS;
+    }
+#endif
+
+    return Disk_Write( lba, SectCount, DataBuf );
+}
+
+#else
+void CHRV3CacheInvalidate( void )
+{
+}
+
+uint8_t CHRV3CacheFlush( void )
+{
+    return ERR_SUCCESS;
+}
+
+uint8_t CHRV3CacheRead( uint32_t lba, uint8_t SectCount, uint8_t *DataBuf )
+{
+    Udisk_Cache_Stat.Rd_Sect += SectCount;
+    return Disk_Read( lba, SectCount, DataBuf );
+}
+
+uint8_t CHRV3CacheWrite( uint32_t lba, uint8_t SectCount, uint8_t *DataBuf )
+{
+    Udisk_Cache_Stat.Wr_Sect += SectCount;
+    return Disk_Write( lba, SectCount, DataBuf );
+}
+#endif
+
+/*********************************************************************
+ * @fn      CHRV3CacheStatPrint
+ *
+ * @brief   Print the cache counters and clear them.
+ *
+ * @return  none
+ */
+void CHRV3CacheStatPrint( void )
+{
+    printf( "Rd %d sect, %d hit, %d cmd, %d ahead; Wr %d sect, %d merged, %d cmd\r\n",
+            Udisk_Cache_Stat.Rd_Sect, Udisk_Cache_Stat.Rd_Hit, Udisk_Cache_Stat.Rd_Cmd, Udisk_Cache_Stat.Rd_Ahead,
+            Udisk_Cache_Stat.Wr_Sect, Udisk_Cache_Stat.Wr_Merge, Udisk_Cache_Stat.Wr_Cmd );
+    memset( &Udisk_Cache_Stat, 0, sizeof( Udisk_Cache_Stat ) );
+}
+
+#if DEF_UDISK_CACHE_BENCH
+/*********************************************************************
+ * @fn      Bench_Run
+ *
+ * @brief   Run one access pattern on the simulated disk and print the
+ *          throughput: bus time of the commands sent plus the measured
+ *          CPU time, SysTick counting HCLK / 8 as for Delay_Us.
+ *
+ * @para    name: Pattern name.
+ *          mode: 0 - sequential reads of cnt sectors,
+ *                1 - sequential reads with a FAT sector every 8 sectors,
+ *                2 - a directory scan, looking up the FAT between
+ *                    directory sectors,
+ *                3 - sequential single-sector writes.
+ *          cnt: Sectors per request.
+ *          num: Requests.
+ *
+ * @return  none
+ */
+static void Bench_Run( const char *name, uint8_t mode, uint8_t cnt, uint16_t num )
+{
+    static __attribute__((aligned(4))) uint8_t buf[ 2 * DEF_UDISK_CACHE_SECT_SIZE ];
+    uint32_t lba = 0x1000;
+    uint32_t req_lba;
+    uint32_t ticks, cpu_us, bytes, err = 0;
+    uint16_t n;
+    uint8_t  k, s;
+
+    CHRV3CacheInvalidate( );
+    memset( &Udisk_Cache_Stat, 0, sizeof( Udisk_Cache_Stat ) );
+    Sim_Bus_Us = 0;
+    bytes = 0;
+
+    SysTick->SR &= ~( 1 << 0 );
+    SysTick->CMP = 0xFFFFFFFF;
+    SysTick->CTLR &= ~( 1 << 4 );
+    SysTick->CTLR |= ( 1 << 5 ) | ( 1 << 0 );
+
+    for( n = 0; n < num; n++ )
+    {
+        if( ( mode == 1 ) && ( ( n & 7 ) == 0 ) )
+        {
+            /* Cluster chain lookup, one FAT sector per 128 clusters */
+            s = CHRV3CacheRead( 0x20 + ( n >> 10 ), 1, buf );
+            err += ( s != ERR_SUCCESS ) || ( *(uint32_t *)buf != ( ( 0x20 + ( n >> 10 ) ) << 7 ) );
+        }
+        req_lba = ( mode == 2 ) ? ( ( n & 1 ) ? 0x20 : ( 0x100 + ( ( n >> 1 ) & 15 ) ) ) : lba;
+        if( mode == 3 )
+        {
+            s = CHRV3CacheWrite( req_lba, cnt, buf );
+        }
+        else
+        {
+            s = CHRV3CacheRead( req_lba, cnt, buf );
+            for( k = 0; k < cnt; k++ )
+            {
+                err += ( *(uint32_t *)&buf[ k * DEF_UDISK_CACHE_SECT_SIZE ] != ( ( req_lba + k ) << 7 ) );
+            }
+        }
+        err += ( s != ERR_SUCCESS );
+        lba += cnt;
+        bytes += (uint32_t)cnt * DEF_UDISK_CACHE_SECT_SIZE;
+    }
+    CHRV3CacheFlush( );
+
+    ticks = (uint32_t)SysTick->CNT;
+    SysTick->CTLR &= ~( 1 << 0 );
+    cpu_us = ticks / ( SystemCoreClock / 8000000 );
+
+    printf( "%s: %dKB, %d cmd, bus %dms + cpu %dms, %d.%02dMB/s, err %d\r\n", name, bytes >> 10,
+            Udisk_Cache_Stat.Rd_Cmd + Udisk_Cache_Stat.Wr_Cmd, Sim_Bus_Us / 1000, cpu_us / 1000,
+            bytes / ( Sim_Bus_Us + cpu_us ), ( bytes % ( Sim_Bus_Us + cpu_us ) ) * 100 / ( Sim_Bus_Us + cpu_us ), err );
+}
+
+/*********************************************************************
+ * @fn      CHRV3CacheBench
+ *
+ * @brief   Compare the access patterns of the file library with and
+ *          without the cache on a simulated disk, so that no U-disk is
+ *          needed. Disk state of the library is restored afterwards.
+ *
+ * @return  none
+ */
+void CHRV3CacheBench( void )
+{
+    uint8_t  status = CHRV3DiskStatus;
+    uint16_t size = CHRV3vSectorSize;
+
+    CHRV3DiskStatus = DISK_READY;
+    CHRV3vSectorSize = DEF_UDISK_CACHE_SECT_SIZE;
+    Cache_Sim = 1;
+
+    for( Cache_Bypass = 1; ; Cache_Bypass = 0 )
+    {
+        printf( "Sector cache %s, window %d, lines %d\r\n", Cache_Bypass ? "off" : "on", DEF_UDISK_CACHE_WIN, DEF_UDISK_CACHE_LINES );
+        Bench_Run( "Seq 1 sect ", 0, 1, 2048 );
+        Bench_Run( "Seq 2 sect ", 0, 2, 1024 );
+        Bench_Run( "File + FAT ", 1, 1, 2048 );
+        Bench_Run( "FAT + dir  ", 2, 1, 1024 );
+        Bench_Run( "Write 1 sect", 3, 1, 2048 );
+        if( Cache_Bypass == 0 )
+        {
+            break;
+        }
+    }
+
+    Cache_Sim = 0;
+    CHRV3CacheInvalidate( );
+    CHRV3DiskStatus = status;
+    CHRV3vSectorSize = size;
+}
+#endif
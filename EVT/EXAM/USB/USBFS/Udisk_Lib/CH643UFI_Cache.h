@@ -0,0 +1,94 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : CH643UFI_Cache.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Sector cache between the U-disk file library and the
+ *                      Bulk-Only transport.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+#ifndef __CH643UFI_CACHE_H
+#define __CH643UFI_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************/
+/* Header File */
+#include "stdint.h"
+
+/*******************************************************************************/
+/* Macro Definition */
+
+/* 0 - every CHRV3ReadSector/CHRV3WriteSector goes straight to the disk */
+#ifndef DEF_UDISK_CACHE_EN
+#define DEF_UDISK_CACHE_EN              1
+#endif
+
+/* Single sectors kept by least recent use, for FAT and directory sectors */
+#ifndef DEF_UDISK_CACHE_LINES
+#define DEF_UDISK_CACHE_LINES           4
+#endif
+
+/* Window of consecutive sectors, filled by one READ(10) when reads are
+ * sequential and used to gather consecutive writes into one WRITE(10) */
+#ifndef DEF_UDISK_CACHE_WIN
+#define DEF_UDISK_CACHE_WIN             8
+#endif
+
+/* 1 - writes are held in the window until CHRV3CacheFlush or until the
+ *     window is needed, 0 - writes go to the disk at once */
+#ifndef DEF_UDISK_CACHE_WRITE_BACK
+#define DEF_UDISK_CACHE_WRITE_BACK      1
+#endif
+
+/* Only disks with this sector size are cached */
+#define DEF_UDISK_CACHE_SECT_SIZE       512
+
+/* Benchmark against a simulated disk, see CHRV3CacheBench */
+#ifndef DEF_UDISK_CACHE_BENCH
+#define DEF_UDISK_CACHE_BENCH           0
+#endif
+#define DEF_UDISK_SIM_SECTORS           0x10000                                 // 32MB
+#define DEF_UDISK_SIM_CMD_US            1000                                    // CBW, CSW and device latency of one command
+#define DEF_UDISK_SIM_SECT_US           600                                     // 512 bytes of bulk data at full speed
+
+/*******************************************************************************/
+/* Struct Definition */
+typedef struct _UDISK_CACHE_STAT
+{
+    uint32_t Rd_Sect;                                                           // Sectors asked for by the library
+    uint32_t Rd_Hit;                                                            // Of those, found in the cache
+    uint32_t Rd_Cmd;                                                            // READ(10) commands sent
+    uint32_t Rd_Ahead;                                                          // Sectors read ahead
+    uint32_t Wr_Sect;
+    uint32_t Wr_Merge;                                                          // Sectors written together with others or rewritten in the cache
+    uint32_t Wr_Cmd;                                                            // WRITE(10) commands sent
+} UDISK_CACHE_STAT;
+
+/*******************************************************************************/
+/* Variable Declaration */
+extern UDISK_CACHE_STAT Udisk_Cache_Stat;
+
+/*******************************************************************************/
+/* Function Declaration */
+extern uint8_t CHRV3ReadSectorRaw( uint32_t lba, uint8_t SectCount, uint8_t *DataBuf );
+extern uint8_t CHRV3WriteSectorRaw( uint32_t lba, uint8_t SectCount, uint8_t *DataBuf );
+extern void    CHRV3CacheInvalidate( void );
+extern uint8_t CHRV3CacheRead( uint32_t lba, uint8_t SectCount, uint8_t *DataBuf );
+extern uint8_t CHRV3CacheWrite( uint32_t lba, uint8_t SectCount, uint8_t *DataBuf );
+extern uint8_t CHRV3CacheFlush( void );
+extern void    CHRV3CacheStatPrint( void );
+extern void    CHRV3CacheBench( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,2260 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : CH643UFI_Fat.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : FAT12/FAT16/FAT32 file system with long names, in
+ *                      source, on top of the sector cache. Every file
+ *                      remembers the contiguous cluster runs of its chain,
+ *                      so that whole sectors of a file are read and written
+ *                      with one multi-sector command per run instead of one
+ *                      command and one FAT lookup per sector.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "debug.h"
+#include "string.h"
+#include "CHRV3UFI.h"
+
+/*******************************************************************************/
+/* Macro Definition */
+#define UFAT_EOC                        0x0FFFFFFF                              // End of chain, every FAT type
+#define UFAT_BAD                        0x0FFFFFF7
+#define UFAT_LBA_NONE                   0xFFFFFFFF
+#define UFAT_END                        0xFE                                    // Past the end of a chain or a directory
+#define UFAT_LFN_ENTS                   ( ( DEF_UFAT_LFN_CHARS + 12 ) / 13 )
+
+#define UFAT_CLUS_OK( c )               ( ( ( c ) >= 2 ) && ( ( c ) < UFAT_Vol.Clus_Max ) )
+
+/*******************************************************************************/
+/* Variable Definition */
+UFAT_VOL UFAT_Vol;
+uint32_t UFAT_Time = ( (uint32_t)MAKE_FILE_DATE( 2021, 1, 1 ) << 16 ) | MAKE_FILE_TIME( 0, 0, 0 );
+
+uint16_t Lfn_Buf[ UFAT_LFN_ENTS * 13 + 1 ];                                     // UCS-2 long name being read or created
+const uint8_t Lfn_Ofs[ 13 ] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+
+/*********************************************************************
+ * @fn      Ld16/Ld32/St16/St32
+ *
+ * @brief   Little-endian fields of on-disk structures.
+ */
+static uint16_t Ld16( const uint8_t *p )
+{
+    return (uint16_t)( p[ 0 ] | ( p[ 1 ] << 8 ) );
+}
+
+static uint32_t Ld32( const uint8_t *p )
+{
+    return (uint32_t)p[ 0 ] | ( (uint32_t)p[ 1 ] << 8 ) | ( (uint32_t)p[ 2 ] << 16 ) | ( (uint32_t)p[ 3 ] << 24 );
+}
+
+static void St16( uint8_t *p, uint16_t val )
+{
+    p[ 0 ] = (uint8_t)val;
+    p[ 1 ] = (uint8_t)( val >> 8 );
+}
+
+static void St32( uint8_t *p, uint32_t val )
+{
+    p[ 0 ] = (uint8_t)val;
+    p[ 1 ] = (uint8_t)( val >> 8 );
+    p[ 2 ] = (uint8_t)( val >> 16 );
+    p[ 3 ] = (uint8_t)( val >> 24 );
+}
+
+/*********************************************************************
+ * @fn      Win_Flush
+ *
+ * @brief   Write Win back if changed. A FAT sector is written to every
+ *          copy of the FAT.
+ *
+ * @return  ERR_SUCCESS, disk error.
+ */
+static uint8_t Win_Flush( void )
+{
+    uint32_t lba;
+    uint8_t  i, s;
+
+    if( UFAT_Vol.Win_Dirty == 0 )
+    {
+        return ERR_SUCCESS;
+    }
+    lba = UFAT_Vol.Win_Lba;
+    s = UFAT_DISK_WRITE( lba, 1, UFAT_Vol.Win );
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    UFAT_Vol.Win_Dirty = 0;
+    if( ( lba >= UFAT_Vol.Fat_Lba ) && ( lba < UFAT_Vol.Fat_Lba + UFAT_Vol.Fat_Size ) )
+    {
+        for( i = 1; i < UFAT_Vol.Num_Fats; i++ )
+        {
+            lba += UFAT_Vol.Fat_Size;
+            s = UFAT_DISK_WRITE( lba, 1, UFAT_Vol.Win );
+            if( s != ERR_SUCCESS )
+            {
+                return s;
+            }
+        }
+    }
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Win_Load
+ *
+ * @brief   Bring one sector into Win.
+ *
+ * @return  ERR_SUCCESS, disk error.
+ */
+static uint8_t Win_Load( uint32_t lba )
+{
+    uint8_t s;
+
+    if( lba == UFAT_Vol.Win_Lba )
+    {
+        return ERR_SUCCESS;
+    }
+    s = Win_Flush( );
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    s = UFAT_DISK_READ( lba, 1, UFAT_Vol.Win );
+    UFAT_Vol.Win_Lba = ( s == ERR_SUCCESS ) ? lba : UFAT_LBA_NONE;
+    return s;
+}
+
+/*********************************************************************
+ * @fn      Vol_Sync
+ *
+ * @brief   Write Win and the FSInfo free count back and flush the disk.
+ *
+ * @return  ERR_SUCCESS, disk error.
+ */
+static uint8_t Vol_Sync( void )
+{
+    uint8_t *p = UFAT_Vol.Win;
+    uint8_t  s;
+
+    s = Win_Flush( );
+    if( ( s == ERR_SUCCESS ) && UFAT_Vol.Fsi_Dirty && UFAT_Vol.Fsi_Lba )
+    {
+        s = Win_Load( UFAT_Vol.Fsi_Lba );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        if( ( Ld32( p ) == 0x41615252 ) && ( Ld32( p + 484 ) == 0x61417272 ) )
+        {
+            St32( p + 488, UFAT_Vol.Free_Num );
+            St32( p + 492, UFAT_Vol.Free_Hint );
+            UFAT_Vol.Win_Dirty = 1;
+            s = Win_Flush( );
+        }
+        UFAT_Vol.Fsi_Dirty = 0;
+    }
+    if( s == ERR_SUCCESS )
+    {
+        s = UFAT_DISK_SYNC( );
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      Clus_Lba
+ *
+ * @brief   First sector of a cluster.
+ */
+static uint32_t Clus_Lba( uint32_t clus )
+{
+    return UFAT_Vol.Data_Lba + ( ( clus - 2 ) << UFAT_Vol.Clus_Shift );
+}
+
+/*********************************************************************
+ * @fn      Fat_Get
+ *
+ * @brief   Read the FAT entry of a cluster.
+ *
+ * @para    pval: 0 - free, UFAT_EOC - end of chain, else next cluster.
+ *
+ * @return  ERR_SUCCESS, ERR_UFAT_CHAIN - no such cluster, disk error.
+ */
+static uint8_t Fat_Get( uint32_t clus, uint32_t *pval )
+{
+    uint32_t ofs, val;
+    uint8_t  s;
+
+    if( !UFAT_CLUS_OK( clus ) )
+    {
+        return ERR_UFAT_CHAIN;
+    }
+    if( UFAT_Vol.Type == DISK_FAT12 )
+    {
+        ofs = clus + ( clus >> 1 );
+        s = Win_Load( UFAT_Vol.Fat_Lba + ( ofs >> 9 ) );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        val = UFAT_Vol.Win[ ofs & 511 ];
+        ofs++;
+        s = Win_Load( UFAT_Vol.Fat_Lba + ( ofs >> 9 ) );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        val |= (uint32_t)UFAT_Vol.Win[ ofs & 511 ] << 8;
+        val = ( clus & 1 ) ? ( val >> 4 ) : ( val & 0x0FFF );
+        if( val >= 0x0FF7 )
+        {
+            val |= 0x0FFFF000;
+        }
+    }
+    else if( UFAT_Vol.Type == DISK_FAT16 )
+    {
+        s = Win_Load( UFAT_Vol.Fat_Lba + ( clus >> 8 ) );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        val = Ld16( &UFAT_Vol.Win[ ( clus & 255 ) << 1 ] );
+        if( val >= 0xFFF7 )
+        {
+            val |= 0x0FFF0000;
+        }
+    }
+    else
+    {
+        s = Win_Load( UFAT_Vol.Fat_Lba + ( clus >> 7 ) );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        val = Ld32( &UFAT_Vol.Win[ ( clus & 127 ) << 2 ] ) & 0x0FFFFFFF;
+    }
+    *pval = ( val > UFAT_BAD ) ? UFAT_EOC : val;
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Fat_Set
+ *
+ * @brief   Write the FAT entry of a cluster, in Win until it is flushed.
+ *
+ * @return  ERR_SUCCESS, disk error.
+ */
+static uint8_t Fat_Set( uint32_t clus, uint32_t val )
+{
+    uint32_t ofs;
+    uint8_t  *p;
+    uint8_t  s;
+
+    if( !UFAT_CLUS_OK( clus ) )
+    {
+        return ERR_UFAT_CHAIN;
+    }
+    if( UFAT_Vol.Type == DISK_FAT12 )
+    {
+        ofs = clus + ( clus >> 1 );
+        s = Win_Load( UFAT_Vol.Fat_Lba + ( ofs >> 9 ) );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        p = &UFAT_Vol.Win[ ofs & 511 ];
+        *p = ( clus & 1 ) ? ( ( *p & 0x0F ) | (uint8_t)( val << 4 ) ) : (uint8_t)val;
+        UFAT_Vol.Win_Dirty = 1;
+        ofs++;
+        s = Win_Load( UFAT_Vol.Fat_Lba + ( ofs >> 9 ) );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        p = &UFAT_Vol.Win[ ofs & 511 ];
+        *p = ( clus & 1 ) ? (uint8_t)( val >> 4 ) : ( ( *p & 0xF0 ) | ( ( val >> 8 ) & 0x0F ) );
+    }
+    else if( UFAT_Vol.Type == DISK_FAT16 )
+    {
+        s = Win_Load( UFAT_Vol.Fat_Lba + ( clus >> 8 ) );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        St16( &UFAT_Vol.Win[ ( clus & 255 ) << 1 ], (uint16_t)val );
+    }
+    else
+    {
+        s = Win_Load( UFAT_Vol.Fat_Lba + ( clus >> 7 ) );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        p = &UFAT_Vol.Win[ ( clus & 127 ) << 2 ];
+        St32( p, ( Ld32( p ) & 0xF0000000 ) | ( val & 0x0FFFFFFF ) );
+    }
+    UFAT_Vol.Win_Dirty = 1;
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Clus_Alloc
+ *
+ * @brief   Take a free cluster and append it to a chain. The search starts
+ *          right after prev, so that a file written sequentially gets
+ *          contiguous clusters.
+ *
+ * @para    prev: Last cluster of the chain, 0 - start a new chain.
+ *          pclus: New cluster.
+ *
+ * @return  ERR_SUCCESS, ERR_DISK_FULL, disk error.
+ */
+static uint8_t Clus_Alloc( uint32_t prev, uint32_t *pclus )
+{
+    uint32_t c, n, val;
+    uint8_t  s;
+
+    if( UFAT_Vol.Free_Num == 0 )
+    {
+        return ERR_DISK_FULL;
+    }
+    c = prev ? ( prev + 1 ) : UFAT_Vol.Free_Hint;
+    for( n = UFAT_Vol.Clus_Max - 2; n; n-- )
+    {
+        if( !UFAT_CLUS_OK( c ) )
+        {
+            c = 2;
+        }
+        s = Fat_Get( c, &val );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        if( val == 0 )
+        {
+            break;
+        }
+        c++;
+    }
+    if( n == 0 )
+    {
+        UFAT_Vol.Free_Num = 0;
+        UFAT_Vol.Fsi_Dirty = 1;
+        return ERR_DISK_FULL;
+    }
+
+    /* Link first, so that a run of allocations crossing into the next FAT
+     * sector leaves that sector in Win */
+    s = ERR_SUCCESS;
+    if( prev )
+    {
+        s = Fat_Set( prev, c );
+    }
+    if( s == ERR_SUCCESS )
+    {
+        s = Fat_Set( c, UFAT_EOC );
+    }
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    UFAT_Vol.Free_Hint = c + 1;
+    if( UFAT_Vol.Free_Num != 0xFFFFFFFF )
+    {
+        UFAT_Vol.Free_Num--;
+    }
+    UFAT_Vol.Fsi_Dirty = 1;
+    *pclus = c;
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Chain_Free
+ *
+ * @brief   Free a cluster chain.
+ *
+ * @para    clus: First cluster.
+ *
+ * @return  ERR_SUCCESS, ERR_UFAT_CHAIN, disk error.
+ */
+static uint8_t Chain_Free( uint32_t clus )
+{
+    uint32_t next;
+    uint8_t  s;
+
+    while( clus != UFAT_EOC )
+    {
+        s = Fat_Get( clus, &next );
+        if( s == ERR_SUCCESS )
+        {
+            s = Fat_Set( clus, 0 );
+        }
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        if( UFAT_Vol.Free_Num != 0xFFFFFFFF )
+        {
+            UFAT_Vol.Free_Num++;
+        }
+        UFAT_Vol.Fsi_Dirty = 1;
+        clus = next;
+    }
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Clus_Zero
+ *
+ * @brief   Clear a new directory cluster. Win is left holding its first
+ *          sector.
+ *
+ * @return  ERR_SUCCESS, disk error.
+ */
+static uint8_t Clus_Zero( uint32_t clus )
+{
+    uint32_t lba = Clus_Lba( clus );
+    uint8_t  i, s;
+
+    s = Win_Flush( );
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    memset( UFAT_Vol.Win, 0, DEF_UFAT_SECT_SIZE );
+    UFAT_Vol.Win_Lba = UFAT_LBA_NONE;
+    for( i = 0; i < ( 1 << UFAT_Vol.Clus_Shift ); i++ )
+    {
+        s = UFAT_DISK_WRITE( lba + i, 1, UFAT_Vol.Win );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+    }
+    UFAT_Vol.Win_Lba = lba;
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      File_Map
+ *
+ * @brief   Find the cluster holding cluster idx of a file and how many
+ *          clusters follow it contiguously. The runs of the chain are
+ *          found on the way and kept in the file; when they are all in
+ *          use the last one moves along with the file position.
+ *
+ * @para    idx: Cluster index in the file.
+ *          need: Clusters wanted from idx on, the run is not followed
+ *                further than that.
+ *          pclus: Cluster.
+ *          pcont: Contiguous clusters from pclus on, 1 or more.
+ *
+ * @return  ERR_SUCCESS, UFAT_END - the chain is shorter, ERR_UFAT_CHAIN,
+ *          disk error.
+ */
+static uint8_t File_Map( UFAT_FILE *pf, uint32_t idx, uint32_t need, uint32_t *pclus, uint32_t *pcont )
+{
+    UFAT_RUN *r;
+    uint32_t end, c, next;
+    uint8_t  k, s;
+
+    if( pf->Run_Num == 0 )
+    {
+        if( pf->Start_Clus == 0 )
+        {
+            return UFAT_END;
+        }
+        pf->Run[ 0 ].Idx = 0;
+        pf->Run[ 0 ].Clus = pf->Start_Clus;
+        pf->Run[ 0 ].Len = 1;
+        pf->Run_Num = 1;
+        pf->Run_Next = 0;
+    }
+
+    /* Last run starting at or before idx */
+    k = pf->Run_Num - 1;
+    while( pf->Run[ k ].Idx > idx )
+    {
+        k--;
+    }
+    r = &pf->Run[ k ];
+    if( k != pf->Run_Num - 1 )
+    {
+        if( idx < r->Idx + r->Len )
+        {
+            *pclus = r->Clus + ( idx - r->Idx );
+            *pcont = r->Idx + r->Len - idx;
+            return ERR_SUCCESS;
+        }
+
+        /* Between two runs that are not adjacent in the file: follow the
+         * chain again from run k */
+        pf->Run_Num = k + 1;
+        pf->Run_Next = 0;
+    }
+
+    /* Extend the last run */
+    while( idx + need > r->Idx + r->Len )
+    {
+        end = r->Idx + r->Len;
+        c = r->Clus + r->Len - 1;
+        next = pf->Run_Next;
+        if( next == 0 )
+        {
+            s = Fat_Get( c, &next );
+            if( s != ERR_SUCCESS )
+            {
+                return s;
+            }
+        }
+        if( next == c + 1 )
+        {
+            r->Len++;
+            pf->Run_Next = 0;
+            continue;
+        }
+        pf->Run_Next = next;
+        if( idx < end )
+        {
+            break;
+        }
+        if( next == UFAT_EOC )
+        {
+            return UFAT_END;
+        }
+        if( !UFAT_CLUS_OK( next ) )
+        {
+            return ERR_UFAT_CHAIN;
+        }
+        if( pf->Run_Num < DEF_UFAT_RUN_NUM )
+        {
+            k = pf->Run_Num++;
+        }
+        r = &pf->Run[ k ];
+        r->Idx = end;
+        r->Clus = next;
+        r->Len = 1;
+        pf->Run_Next = 0;
+    }
+    *pclus = r->Clus + ( idx - r->Idx );
+    *pcont = r->Idx + r->Len - idx;
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Dir_Start
+ *
+ * @brief   First cluster of a directory from its entry, 0 being the root.
+ */
+static uint32_t Dir_Start( uint32_t clus )
+{
+    return ( ( clus == 0 ) && ( UFAT_Vol.Type == DISK_FAT32 ) ) ? UFAT_Vol.Root_Clus : clus;
+}
+
+/*********************************************************************
+ * @fn      Dir_Rewind
+ *
+ * @brief   Point a directory at its first entry.
+ *
+ * @para    start: First cluster, 0 - FAT12/16 root directory.
+ */
+static void Dir_Rewind( UFAT_DIR *pd, uint32_t start )
+{
+    pd->Start_Clus = start;
+    pd->Clus = start;
+    pd->Lba = start ? Clus_Lba( start ) : UFAT_Vol.Root_Lba;
+    pd->Idx = 0;
+    pd->Lfn_Idx = 0;
+}
+
+/*********************************************************************
+ * @fn      Dir_Next
+ *
+ * @brief   Move to the next directory entry.
+ *
+ * @para    extend: 1 - add a cleared cluster at the end of the chain.
+ *
+ * @return  ERR_SUCCESS, UFAT_END - no more entries (pd->Lba is then
+ *          UFAT_LBA_NONE), ERR_FDT_OVER - directory full, disk error.
+ */
+static uint8_t Dir_Next( UFAT_DIR *pd, uint8_t extend )
+{
+    uint32_t next;
+    uint16_t idx = pd->Idx + 1;
+    uint8_t  s;
+
+    if( idx == 0 )
+    {
+        pd->Lba = UFAT_LBA_NONE;
+        return extend ? ERR_FDT_OVER : UFAT_END;
+    }
+    if( ( idx & 15 ) == 0 )
+    {
+        if( pd->Clus == 0 )
+        {
+            if( idx >= UFAT_Vol.Root_Ents )
+            {
+                pd->Lba = UFAT_LBA_NONE;
+                return extend ? ERR_FDT_OVER : UFAT_END;
+            }
+            pd->Lba++;
+        }
+        else if( ( ( idx >> 4 ) & ( ( 1 << UFAT_Vol.Clus_Shift ) - 1 ) ) == 0 )
+        {
+            s = Fat_Get( pd->Clus, &next );
+            if( s != ERR_SUCCESS )
+            {
+                return s;
+            }
+            if( next == UFAT_EOC )
+            {
+                if( extend == 0 )
+                {
+                    pd->Lba = UFAT_LBA_NONE;
+                    return UFAT_END;
+                }
+                s = Clus_Alloc( pd->Clus, &next );
+                if( s == ERR_SUCCESS )
+                {
+                    s = Clus_Zero( next );
+                }
+                if( s != ERR_SUCCESS )
+                {
+                    return s;
+                }
+            }
+            else if( !UFAT_CLUS_OK( next ) )
+            {
+                return ERR_UFAT_CHAIN;
+            }
+            pd->Clus = next;
+            pd->Lba = Clus_Lba( next );
+        }
+        else
+        {
+            pd->Lba++;
+        }
+    }
+    pd->Idx = idx;
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Dir_Seek
+ *
+ * @brief   Point a directory at entry idx.
+ *
+ * @return  ERR_SUCCESS, disk error.
+ */
+static uint8_t Dir_Seek( UFAT_DIR *pd, uint16_t idx )
+{
+    uint8_t s = ERR_SUCCESS;
+
+    Dir_Rewind( pd, pd->Start_Clus );
+    while( ( pd->Idx < idx ) && ( s == ERR_SUCCESS ) )
+    {
+        s = Dir_Next( pd, 0 );
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      Dir_Ent
+ *
+ * @brief   Load the current entry of a directory.
+ *
+ * @return  Entry in Win, NULL - disk error.
+ */
+static uint8_t *Dir_Ent( UFAT_DIR *pd )
+{
+    if( Win_Load( pd->Lba ) != ERR_SUCCESS )
+    {
+        return NULL;
+    }
+    return &UFAT_Vol.Win[ ( pd->Idx & 15 ) << 5 ];
+}
+
+/*********************************************************************
+ * @fn      Sfn_Sum
+ *
+ * @brief   Checksum of an 8.3 name, kept in its long name entries.
+ */
+static uint8_t Sfn_Sum( const uint8_t *sfn )
+{
+    uint8_t i, sum = 0;
+
+    for( i = 0; i < 11; i++ )
+    {
+        sum = (uint8_t)( ( ( sum & 1 ) << 7 ) + ( sum >> 1 ) + sfn[ i ] );
+    }
+    return sum;
+}
+
+/*********************************************************************
+ * @fn      Sfn_Name
+ *
+ * @brief   "NAME.EXT" form of an 8.3 entry.
+ *
+ * @para    ncase: NT case bits, 0x08 - lowercase name, 0x10 - lowercase
+ *                 extension.
+ */
+static void Sfn_Name( const uint8_t *p, char *dst, uint8_t ncase )
+{
+    uint8_t i, n = 0, c;
+
+    for( i = 0; i < 11; i++ )
+    {
+        if( i == 8 )
+        {
+            if( p[ 8 ] == ' ' )
+            {
+                break;
+            }
+            dst[ n++ ] = '.';
+        }
+        c = p[ i ];
+        if( c == ' ' )
+        {
+            if( i >= 8 )
+            {
+                break;
+            }
+            i = 7;
+            continue;
+        }
+        if( ( i == 0 ) && ( c == 0x05 ) )
+        {
+            c = 0xE5;
+        }
+        if( ( c >= 'A' ) && ( c <= 'Z' ) && ( ncase & ( ( i < 8 ) ? 0x08 : 0x10 ) ) )
+        {
+            c += 0x20;
+        }
+        dst[ n++ ] = c;
+    }
+    dst[ n ] = 0;
+}
+
+/*********************************************************************
+ * @fn      Lfn_Get
+ *
+ * @brief   Lfn_Buf in UTF-8.
+ *
+ * @return  0 - done, 1 - does not fit.
+ */
+static uint8_t Lfn_Get( char *dst, uint16_t size )
+{
+    uint16_t i, n = 0, c;
+
+    for( i = 0; ( c = Lfn_Buf[ i ] ) != 0; i++ )
+    {
+        if( c < 0x80 )
+        {
+            if( n + 1 >= size )
+            {
+                return 1;
+            }
+            dst[ n++ ] = (char)c;
+        }
+        else if( c < 0x800 )
+        {
+            if( n + 2 >= size )
+            {
+                return 1;
+            }
+            dst[ n++ ] = (char)( 0xC0 | ( c >> 6 ) );
+            dst[ n++ ] = (char)( 0x80 | ( c & 0x3F ) );
+        }
+        else
+        {
+            if( n + 3 >= size )
+            {
+                return 1;
+            }
+            dst[ n++ ] = (char)( 0xE0 | ( c >> 12 ) );
+            dst[ n++ ] = (char)( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+            dst[ n++ ] = (char)( 0x80 | ( c & 0x3F ) );
+        }
+    }
+    dst[ n ] = 0;
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      Lfn_Set
+ *
+ * @brief   UTF-8 name into Lfn_Buf.
+ *
+ * @para    plen: Characters.
+ *
+ * @return  ERR_SUCCESS, ERR_UFAT_NAME - bad UTF-8 or too long.
+ */
+static uint8_t Lfn_Set( const char *name, uint16_t *plen )
+{
+    const uint8_t *q = (const uint8_t *)name;
+    uint16_t n = 0;
+    uint32_t c;
+
+    while( *q )
+    {
+        c = *q++;
+        if( c >= 0x80 )
+        {
+            if( ( ( c & 0xE0 ) == 0xC0 ) && ( ( q[ 0 ] & 0xC0 ) == 0x80 ) )
+            {
+                c = ( ( c & 0x1F ) << 6 ) | ( q[ 0 ] & 0x3F );
+                q++;
+                if( c < 0x80 )
+                {
+                    return ERR_UFAT_NAME;
+                }
+            }
+            else if( ( ( c & 0xF0 ) == 0xE0 ) && ( ( q[ 0 ] & 0xC0 ) == 0x80 ) && ( ( q[ 1 ] & 0xC0 ) == 0x80 ) )
+            {
+                c = ( ( c & 0x0F ) << 12 ) | ( ( q[ 0 ] & 0x3F ) << 6 ) | ( q[ 1 ] & 0x3F );
+                q += 2;
+                if( ( c < 0x800 ) || ( ( c >= 0xD800 ) && ( c <= 0xDFFF ) ) )
+                {
+                    return ERR_UFAT_NAME;
+                }
+            }
+            else
+            {
+                return ERR_UFAT_NAME;
+            }
+        }
+        if( n >= DEF_UFAT_LFN_CHARS )
+        {
+            return ERR_UFAT_NAME;
+        }
+        Lfn_Buf[ n++ ] = (uint16_t)c;
+    }
+    Lfn_Buf[ n ] = 0;
+    *plen = n;
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Name_Cmp
+ *
+ * @brief   Compare two names, ASCII letters in either case.
+ *
+ * @return  1 - same.
+ */
+static uint8_t Name_Cmp( const char *a, const char *b )
+{
+    uint8_t ca, cb;
+
+    do
+    {
+        ca = (uint8_t)*a++;
+        cb = (uint8_t)*b++;
+        if( ( ca >= 'a' ) && ( ca <= 'z' ) )
+        {
+            ca -= 0x20;
+        }
+        if( ( cb >= 'a' ) && ( cb <= 'z' ) )
+        {
+            cb -= 0x20;
+        }
+        if( ca != cb )
+        {
+            return 0;
+        }
+    } while( ca );
+    return 1;
+}
+
+/*********************************************************************
+ * @fn      Dir_Read
+ *
+ * @brief   Next file or directory from the current entry on, with its
+ *          long name if it has a valid one.
+ *
+ * @para    pd: Left at the 8.3 entry, Lfn_Idx at its first long name
+ *              entry.
+ *
+ * @return  ERR_SUCCESS, UFAT_END, disk error.
+ */
+static uint8_t Dir_Read( UFAT_DIR *pd, UFAT_INFO *pinfo )
+{
+    uint8_t  *p;
+    uint16_t lfn_idx = 0, k;
+    uint8_t  ord = 0, sum = 0, lfn = 0, i, s;
+
+    if( pd->Lba == UFAT_LBA_NONE )
+    {
+        return UFAT_END;
+    }
+    for( ;; )
+    {
+        p = Dir_Ent( pd );
+        if( p == NULL )
+        {
+            return ERR_USB_DISK_ERR;
+        }
+        if( p[ 0 ] == 0 )
+        {
+            pd->Lba = UFAT_LBA_NONE;
+            return UFAT_END;
+        }
+        if( p[ 0 ] == 0xE5 )
+        {
+            ord = 0;
+            lfn = 0;
+        }
+        else if( ( p[ 11 ] & 0x3F ) == ATTR_LONG_NAME )
+        {
+            if( p[ 0 ] & 0x40 )
+            {
+                ord = p[ 0 ] & 0x3F;
+                sum = p[ 13 ];
+                lfn_idx = pd->Idx;
+                lfn = 0;
+                if( ord > UFAT_LFN_ENTS )
+                {
+                    ord = 0;
+                }
+                else
+                {
+                    Lfn_Buf[ ord * 13 ] = 0;
+                }
+            }
+            if( ord && ( ( p[ 0 ] & 0x3F ) == ord ) && ( p[ 13 ] == sum ) )
+            {
+                k = ( ord - 1 ) * 13;
+                for( i = 0; i < 13; i++ )
+                {
+                    Lfn_Buf[ k + i ] = Ld16( p + Lfn_Ofs[ i ] );
+                }
+                if( --ord == 0 )
+                {
+                    lfn = 1;
+                }
+            }
+            else
+            {
+                ord = 0;
+                lfn = 0;
+            }
+        }
+        else if( p[ 11 ] & ATTR_VOLUME_ID )
+        {
+            ord = 0;
+            lfn = 0;
+        }
+        else
+        {
+            Sfn_Name( p, pinfo->Short, 0 );
+            if( ( lfn == 0 ) || ( Sfn_Sum( p ) != sum ) || Lfn_Get( pinfo->Name, DEF_UFAT_NAME_MAX ) )
+            {
+                Sfn_Name( p, pinfo->Name, p[ 12 ] );
+                lfn = 0;
+            }
+            pinfo->Attr = p[ 11 ];
+            pinfo->Time = Ld16( p + 22 );
+            pinfo->Date = Ld16( p + 24 );
+            pinfo->Size = Ld32( p + 28 );
+            pinfo->Clus = Ld16( p + 26 );
+            if( UFAT_Vol.Type == DISK_FAT32 )
+            {
+                pinfo->Clus |= (uint32_t)Ld16( p + 20 ) << 16;
+            }
+            pd->Lfn_Idx = lfn ? lfn_idx : pd->Idx;
+            return ERR_SUCCESS;
+        }
+        s = Dir_Next( pd, 0 );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      Dir_Find
+ *
+ * @brief   Look a name up in a directory, by long or 8.3 name.
+ *
+ * @return  ERR_SUCCESS, ERR_MISS_FILE, disk error.
+ */
+static uint8_t Dir_Find( UFAT_DIR *pd, const char *name, UFAT_INFO *pinfo )
+{
+    uint8_t s;
+
+    for( ;; )
+    {
+        s = Dir_Read( pd, pinfo );
+        if( s == ERR_SUCCESS )
+        {
+            if( Name_Cmp( name, pinfo->Name ) || Name_Cmp( name, pinfo->Short ) )
+            {
+                return ERR_SUCCESS;
+            }
+            s = Dir_Next( pd, 0 );
+        }
+        if( s != ERR_SUCCESS )
+        {
+            return ( s == UFAT_END ) ? ERR_MISS_FILE : s;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      Path_Find
+ *
+ * @brief   Follow a path, '/' or '\\' separated, from the root.
+ *
+ * @para    pd: Entry found. When only the last component is missing it
+ *              is the parent directory, rewound.
+ *          name: Last component, empty for the root itself.
+ *
+ * @return  ERR_SUCCESS, ERR_MISS_FILE, ERR_MISS_DIR, ERR_UFAT_NAME,
+ *          disk error.
+ */
+static uint8_t Path_Find( const char *path, UFAT_DIR *pd, UFAT_INFO *pinfo, char *name )
+{
+    uint32_t dir;
+    uint16_t n;
+    uint8_t  s;
+
+    if( UFAT_Vol.Type == 0 )
+    {
+        return ERR_UFAT_NO_VOL;
+    }
+    dir = Dir_Start( 0 );
+    while( ( *path == '/' ) || ( *path == '\\' ) )
+    {
+        path++;
+    }
+    name[ 0 ] = 0;
+    if( *path == 0 )
+    {
+        Dir_Rewind( pd, dir );
+        memset( pinfo, 0, sizeof( UFAT_INFO ) );
+        pinfo->Name[ 0 ] = '/';
+        pinfo->Attr = ATTR_DIRECTORY;
+        return ERR_SUCCESS;
+    }
+    for( ;; )
+    {
+        n = 0;
+        while( *path && ( *path != '/' ) && ( *path != '\\' ) )
+        {
+            if( n >= DEF_UFAT_NAME_MAX - 1 )
+            {
+                return ERR_UFAT_NAME;
+            }
+            name[ n++ ] = *path++;
+        }
+        name[ n ] = 0;
+        while( ( *path == '/' ) || ( *path == '\\' ) )
+        {
+            path++;
+        }
+
+        Dir_Rewind( pd, dir );
+        s = Dir_Find( pd, name, pinfo );
+        if( s == ERR_MISS_FILE )
+        {
+            if( *path )
+            {
+                return ERR_MISS_DIR;
+            }
+            Dir_Rewind( pd, dir );
+            return ERR_MISS_FILE;
+        }
+        if( ( s != ERR_SUCCESS ) || ( *path == 0 ) )
+        {
+            return s;
+        }
+        if( ( pinfo->Attr & ATTR_DIRECTORY ) == 0 )
+        {
+            return ERR_MISS_DIR;
+        }
+        dir = Dir_Start( pinfo->Clus );
+    }
+}
+
+/*********************************************************************
+ * @fn      Sfn_Make
+ *
+ * @brief   8.3 name of a new entry. Names in one case only, such as
+ *          "readme.txt", are kept as 8.3 names with the NT case bits.
+ *
+ * @para    sfn: 11 bytes, space padded.
+ *          pncase: NT case bits.
+ *
+ * @return  0 - the name fits, 1 - a long name entry is needed and sfn is
+ *          the base for a numbered name.
+ */
+static uint8_t Sfn_Make( const char *name, uint8_t *sfn, uint8_t *pncase )
+{
+    const char *dot, *q;
+    uint8_t  i, n, max, c, lossy = 0;
+    uint8_t  lower[ 2 ] = { 0, 0 }, upper[ 2 ] = { 0, 0 };
+
+    memset( sfn, ' ', 11 );
+    dot = strrchr( name, '.' );
+    if( dot == name )
+    {
+        dot = NULL;
+    }
+    for( i = 0; i < 2; i++ )
+    {
+        q = i ? ( dot ? dot + 1 : "" ) : name;
+        n = 0;
+        max = i ? 3 : 8;
+        for( ; *q && ( i || ( q != dot ) ); q++ )
+        {
+            c = (uint8_t)*q;
+            if( ( c == ' ' ) || ( c == '.' ) || ( ( c & 0xC0 ) == 0x80 ) )
+            {
+                lossy = 1;
+                continue;
+            }
+            if( ( c >= 0x80 ) || strchr( "+,;=[]", c ) )
+            {
+                lossy = 1;
+                c = '_';
+            }
+            else if( ( c >= 'a' ) && ( c <= 'z' ) )
+            {
+                lower[ i ] = 1;
+                c -= 0x20;
+            }
+            else if( ( c >= 'A' ) && ( c <= 'Z' ) )
+            {
+                upper[ i ] = 1;
+            }
+            if( n < max )
+            {
+                sfn[ ( i ? 8 : 0 ) + n++ ] = c;
+            }
+            else
+            {
+                lossy = 1;
+            }
+        }
+        if( lower[ i ] && upper[ i ] )
+        {
+            lossy = 1;
+        }
+    }
+    if( sfn[ 0 ] == ' ' )
+    {
+        lossy = 1;
+    }
+    *pncase = lossy ? 0 : ( ( lower[ 0 ] ? 0x08 : 0 ) | ( lower[ 1 ] ? 0x10 : 0 ) );
+    return lossy;
+}
+
+/*********************************************************************
+ * @fn      Sfn_Number
+ *
+ * @brief   Numbered 8.3 name, "LONGNA~1.TXT".
+ */
+static void Sfn_Number( const uint8_t *base, uint8_t *sfn, uint16_t num )
+{
+    uint8_t tail[ 6 ];
+    uint8_t i, n, len;
+
+    n = sizeof( tail );
+    do
+    {
+        tail[ --n ] = '0' + ( num % 10 );
+        num /= 10;
+    } while( num );
+    tail[ --n ] = '~';
+
+    memcpy( sfn, base, 11 );
+    for( len = 0; ( len < 8 ) && ( base[ len ] != ' ' ); len++ );
+    if( len > n + 2 )
+    {
+        len = n + 2;
+    }
+    for( i = n; i < sizeof( tail ); i++ )
+    {
+        sfn[ len++ ] = tail[ i ];
+    }
+}
+
+/*********************************************************************
+ * @fn      Sfn_Exists
+ *
+ * @brief   Look an 8.3 name up in a directory.
+ *
+ * @return  ERR_SUCCESS - in use, ERR_MISS_FILE, disk error.
+ */
+static uint8_t Sfn_Exists( uint32_t start, const uint8_t *sfn )
+{
+    UFAT_DIR d;
+    uint8_t  *p;
+    uint8_t  s;
+
+    Dir_Rewind( &d, start );
+    for( ;; )
+    {
+        p = Dir_Ent( &d );
+        if( p == NULL )
+        {
+            return ERR_USB_DISK_ERR;
+        }
+        if( p[ 0 ] == 0 )
+        {
+            return ERR_MISS_FILE;
+        }
+        if( ( p[ 0 ] != 0xE5 ) && ( ( p[ 11 ] & 0x3F ) != ATTR_LONG_NAME ) && ( memcmp( p, sfn, 11 ) == 0 ) )
+        {
+            return ERR_SUCCESS;
+        }
+        s = Dir_Next( &d, 0 );
+        if( s != ERR_SUCCESS )
+        {
+            return ( s == UFAT_END ) ? ERR_MISS_FILE : s;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      Name_Check
+ *
+ * @brief   Check a name for a new entry.
+ *
+ * @return  ERR_SUCCESS, ERR_UFAT_NAME.
+ */
+static uint8_t Name_Check( const char *name )
+{
+    const char *q;
+    uint16_t n;
+
+    n = strlen( name );
+    if( ( n == 0 ) || ( name[ n - 1 ] == '.' ) || ( name[ n - 1 ] == ' ' ) )
+    {
+        return ERR_UFAT_NAME;
+    }
+    for( q = name; *q; q++ )
+    {
+        if( ( (uint8_t)*q < 0x20 ) || strchr( "\"*/:<>?\\|", *q ) )
+        {
+            return ERR_UFAT_NAME;
+        }
+    }
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Dir_Add
+ *
+ * @brief   Create an entry, with a long name if the name needs one.
+ *
+ * @para    pd: Parent directory, left at the new 8.3 entry.
+ *          attr: Attribute.
+ *          clus: First cluster.
+ *
+ * @return  ERR_SUCCESS, ERR_UFAT_NAME, ERR_UFAT_EXIST, ERR_FDT_OVER,
+ *          ERR_DISK_FULL, disk error.
+ */
+static uint8_t Dir_Add( UFAT_DIR *pd, const char *name, uint8_t attr, uint32_t clus )
+{
+    UFAT_DIR start;
+    uint8_t  sfn[ 11 ], base[ 11 ];
+    uint8_t  *p;
+    uint16_t len = 0, num, k;
+    uint8_t  ncase, lfn_num = 0, run, sum, i, s;
+
+    s = Name_Check( name );
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    if( Sfn_Make( name, base, &ncase ) )
+    {
+        s = Lfn_Set( name, &len );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        lfn_num = ( len + 12 ) / 13;
+        for( num = 1; ; num++ )
+        {
+            if( num > 999 )
+            {
+                return ERR_UFAT_EXIST;
+            }
+            Sfn_Number( base, sfn, num );
+            s = Sfn_Exists( pd->Start_Clus, sfn );
+            if( s == ERR_MISS_FILE )
+            {
+                break;
+            }
+            if( s != ERR_SUCCESS )
+            {
+                return s;
+            }
+        }
+    }
+    else
+    {
+        memcpy( sfn, base, 11 );
+        s = Sfn_Exists( pd->Start_Clus, sfn );
+        if( s != ERR_MISS_FILE )
+        {
+            return ( s == ERR_SUCCESS ) ? ERR_UFAT_EXIST : s;
+        }
+    }
+
+    /* Free entries for the long name and the 8.3 entry, in a row */
+    Dir_Rewind( pd, pd->Start_Clus );
+    run = 0;
+    for( ;; )
+    {
+        p = Dir_Ent( pd );
+        if( p == NULL )
+        {
+            return ERR_USB_DISK_ERR;
+        }
+        if( ( p[ 0 ] == 0 ) || ( p[ 0 ] == 0xE5 ) )
+        {
+            if( run++ == 0 )
+            {
+                start = *pd;
+            }
+            if( run == lfn_num + 1 )
+            {
+                break;
+            }
+        }
+        else
+        {
+            run = 0;
+        }
+        s = Dir_Next( pd, 1 );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+    }
+
+    *pd = start;
+    sum = Sfn_Sum( sfn );
+    for( k = lfn_num; k; k-- )
+    {
+        p = Dir_Ent( pd );
+        if( p == NULL )
+        {
+            return ERR_USB_DISK_ERR;
+        }
+        memset( p, 0, 32 );
+        p[ 0 ] = (uint8_t)k | ( ( k == lfn_num ) ? 0x40 : 0 );
+        p[ 11 ] = ATTR_LONG_NAME;
+        p[ 13 ] = sum;
+        for( i = 0; i < 13; i++ )
+        {
+            num = ( k - 1 ) * 13 + i;
+            St16( p + Lfn_Ofs[ i ], ( num < len ) ? Lfn_Buf[ num ] : ( ( num == len ) ? 0x0000 : 0xFFFF ) );
+        }
+        UFAT_Vol.Win_Dirty = 1;
+        s = Dir_Next( pd, 0 );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+    }
+
+    p = Dir_Ent( pd );
+    if( p == NULL )
+    {
+        return ERR_USB_DISK_ERR;
+    }
+    memset( p, 0, 32 );
+    memcpy( p, sfn, 11 );
+    p[ 11 ] = attr;
+    p[ 12 ] = ncase;
+    St16( p + 14, (uint16_t)UFAT_Time );
+    St16( p + 16, (uint16_t)( UFAT_Time >> 16 ) );
+    St16( p + 18, (uint16_t)( UFAT_Time >> 16 ) );
+    St16( p + 20, (uint16_t)( clus >> 16 ) );
+    St16( p + 22, (uint16_t)UFAT_Time );
+    St16( p + 24, (uint16_t)( UFAT_Time >> 16 ) );
+    St16( p + 26, (uint16_t)clus );
+    UFAT_Vol.Win_Dirty = 1;
+    pd->Lfn_Idx = start.Idx;
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Bpb_Check
+ *
+ * @brief   Check for a FAT boot sector with 512-byte sectors.
+ *
+ * @return  1 - boot sector.
+ */
+static uint8_t Bpb_Check( const uint8_t *p )
+{
+    return ( Ld16( p + 510 ) == 0xAA55 ) && ( ( p[ 0 ] == 0xEB ) || ( p[ 0 ] == 0xE9 ) )
+           && ( Ld16( p + 11 ) == DEF_UFAT_SECT_SIZE ) && p[ 13 ] && ( ( p[ 13 ] & ( p[ 13 ] - 1 ) ) == 0 )
+           && Ld16( p + 14 ) && ( p[ 16 ] >= 1 ) && ( p[ 16 ] <= 2 );
+}
+
+/*********************************************************************
+ * @fn      UFAT_Mount
+ *
+ * @brief   Mount the FAT volume of the disk: the disk itself if it starts
+ *          with a boot sector, else the first FAT partition of its MBR.
+ *
+ * @return  ERR_SUCCESS, ERR_MBR_ERROR, ERR_BPB_ERROR, ERR_FAT_ERROR,
+ *          disk error.
+ */
+uint8_t UFAT_Mount( void )
+{
+    uint8_t  *p = UFAT_Vol.Win;
+    uint32_t bs = 0, rsvd, tot, fat_size, sys, clus, need, val;
+    uint8_t  type, i, s;
+
+    memset( &UFAT_Vol, 0, sizeof( UFAT_Vol ) );
+    UFAT_Vol.Win_Lba = UFAT_LBA_NONE;
+
+    s = Win_Load( 0 );
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    if( Bpb_Check( p ) == 0 )
+    {
+        if( Ld16( p + 510 ) != 0xAA55 )
+        {
+            return ERR_MBR_ERROR;
+        }
+        for( i = 0; i < 4; i++ )
+        {
+            type = p[ 446 + 16 * i + 4 ];
+            if( ( type == 0x01 ) || ( type == 0x04 ) || ( type == 0x06 ) || ( type == 0x0B ) || ( type == 0x0C ) || ( type == 0x0E ) )
+            {
+                bs = Ld32( p + 446 + 16 * i + 8 );
+                break;
+            }
+        }
+        if( ( i == 4 ) || ( bs == 0 ) )
+        {
+            return ERR_MBR_ERROR;
+        }
+        s = Win_Load( bs );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        if( Bpb_Check( p ) == 0 )
+        {
+            return ERR_BPB_ERROR;
+        }
+    }
+
+    while( ( 1 << UFAT_Vol.Clus_Shift ) < p[ 13 ] )
+    {
+        UFAT_Vol.Clus_Shift++;
+    }
+    rsvd = Ld16( p + 14 );
+    UFAT_Vol.Num_Fats = p[ 16 ];
+    UFAT_Vol.Root_Ents = Ld16( p + 17 );
+    tot = Ld16( p + 19 ) ? Ld16( p + 19 ) : Ld32( p + 32 );
+    fat_size = Ld16( p + 22 ) ? Ld16( p + 22 ) : Ld32( p + 36 );
+    sys = rsvd + UFAT_Vol.Num_Fats * fat_size + ( ( UFAT_Vol.Root_Ents * 32 + 511 ) >> 9 );
+    if( ( fat_size == 0 ) || ( tot <= sys ) )
+    {
+        return ERR_BPB_ERROR;
+    }
+    UFAT_Vol.Fat_Lba = bs + rsvd;
+    UFAT_Vol.Fat_Size = fat_size;
+    UFAT_Vol.Data_Lba = bs + sys;
+    clus = ( tot - sys ) >> UFAT_Vol.Clus_Shift;
+    UFAT_Vol.Clus_Max = clus + 2;
+
+    /* The type follows from the cluster count alone */
+    if( clus < 4085 )
+    {
+        type = DISK_FAT12;
+        need = ( UFAT_Vol.Clus_Max * 3 + 1 ) / 2;
+    }
+    else if( clus < 65525 )
+    {
+        type = DISK_FAT16;
+        need = UFAT_Vol.Clus_Max * 2;
+    }
+    else
+    {
+        type = DISK_FAT32;
+        need = UFAT_Vol.Clus_Max * 4;
+    }
+    if( ( ( need + 511 ) >> 9 ) > fat_size )
+    {
+        return ERR_FAT_ERROR;
+    }
+    if( type == DISK_FAT32 )
+    {
+        if( UFAT_Vol.Root_Ents )
+        {
+            return ERR_FAT_ERROR;
+        }
+        UFAT_Vol.Root_Clus = Ld32( p + 44 );
+        if( !UFAT_CLUS_OK( UFAT_Vol.Root_Clus ) )
+        {
+            return ERR_BPB_ERROR;
+        }
+        val = Ld16( p + 48 );
+        if( val && ( val < rsvd ) )
+        {
+            UFAT_Vol.Fsi_Lba = bs + val;
+        }
+    }
+    else
+    {
+        if( UFAT_Vol.Root_Ents == 0 )
+        {
+            return ERR_FAT_ERROR;
+        }
+        UFAT_Vol.Root_Lba = UFAT_Vol.Fat_Lba + UFAT_Vol.Num_Fats * fat_size;
+    }
+
+    UFAT_Vol.Free_Num = 0xFFFFFFFF;
+    UFAT_Vol.Free_Hint = 2;
+    if( UFAT_Vol.Fsi_Lba )
+    {
+        s = Win_Load( UFAT_Vol.Fsi_Lba );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        if( ( Ld32( p ) == 0x41615252 ) && ( Ld32( p + 484 ) == 0x61417272 ) )
+        {
+            val = Ld32( p + 488 );
+            if( val <= clus )
+            {
+                UFAT_Vol.Free_Num = val;
+            }
+            val = Ld32( p + 492 );
+            if( UFAT_CLUS_OK( val ) )
+            {
+                UFAT_Vol.Free_Hint = val;
+            }
+        }
+    }
+    UFAT_Vol.Type = type;
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      UFAT_Unmount
+ *
+ * @brief   Write everything back and forget the volume. Files still open
+ *          are not synced.
+ *
+ * @return  ERR_SUCCESS, disk error.
+ */
+uint8_t UFAT_Unmount( void )
+{
+    uint8_t s = ERR_SUCCESS;
+
+    if( UFAT_Vol.Type )
+    {
+        s = Vol_Sync( );
+    }
+    UFAT_Vol.Type = 0;
+    UFAT_Vol.Win_Lba = UFAT_LBA_NONE;
+    UFAT_Vol.Win_Dirty = 0;
+    return s;
+}
+
+/*********************************************************************
+ * @fn      UFAT_Open
+ *
+ * @brief   Open a file.
+ *
+ * @para    mode: UFAT_READ, UFAT_WRITE, UFAT_CREATE, UFAT_TRUNC and
+ *                UFAT_APPEND combined. The last three imply UFAT_WRITE.
+ *
+ * @return  ERR_SUCCESS, ERR_MISS_FILE, ERR_MISS_DIR, ERR_UFAT_DENIED,
+ *          ERR_UFAT_NAME, ERR_FDT_OVER, disk error.
+ */
+uint8_t UFAT_Open( UFAT_FILE *pf, const char *path, uint8_t mode )
+{
+    UFAT_DIR  d;
+    UFAT_INFO info;
+    char      name[ DEF_UFAT_NAME_MAX ];
+    uint8_t   s;
+
+    pf->Mode = 0;
+    if( mode & ( UFAT_CREATE | UFAT_TRUNC | UFAT_APPEND ) )
+    {
+        mode |= UFAT_WRITE;
+    }
+    s = Path_Find( path, &d, &info, name );
+    if( ( s == ERR_MISS_FILE ) && ( mode & UFAT_CREATE ) )
+    {
+        s = Dir_Add( &d, name, ATTR_ARCHIVE, 0 );
+        info.Attr = ATTR_ARCHIVE;
+        info.Size = 0;
+        info.Clus = 0;
+    }
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    if( ( name[ 0 ] == 0 ) || ( info.Attr & ( ATTR_DIRECTORY | ATTR_VOLUME_ID ) )
+        || ( ( mode & UFAT_WRITE ) && ( info.Attr & ATTR_READ_ONLY ) ) )
+    {
+        return ERR_UFAT_DENIED;
+    }
+
+    pf->Dir_Lba = d.Lba;
+    pf->Dir_Ofs = ( d.Idx & 15 ) << 5;
+    pf->Size = info.Size;
+    pf->Pos = 0;
+    pf->Start_Clus = info.Clus;
+    pf->Run_Num = 0;
+    pf->Run_Next = 0;
+    pf->Dirty = 0;
+    pf->Mode = mode;
+    if( ( mode & UFAT_TRUNC ) && ( pf->Start_Clus || pf->Size ) )
+    {
+        s = UFAT_Truncate( pf );
+        if( s != ERR_SUCCESS )
+        {
+            pf->Mode = 0;
+            return s;
+        }
+    }
+    if( mode & UFAT_APPEND )
+    {
+        pf->Pos = pf->Size;
+    }
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      UFAT_Read
+ *
+ * @brief   Read from the file position on. Whole sectors go straight into
+ *          buf with one command per contiguous run when buf is word
+ *          aligned, the rest passes through Win.
+ *
+ * @para    plen: Bytes read, less than len at the end of the file.
+ *
+ * @return  ERR_SUCCESS, ERR_FILE_CLOSE, ERR_UFAT_CHAIN, disk error.
+ */
+uint8_t UFAT_Read( UFAT_FILE *pf, void *buf, uint32_t len, uint32_t *plen )
+{
+    uint8_t  *p = buf;
+    uint32_t sect, ofs, clus, cont, lba, n, step;
+    uint8_t  s = ERR_SUCCESS;
+
+    *plen = 0;
+    if( ( pf->Mode & UFAT_READ ) == 0 )
+    {
+        return ERR_FILE_CLOSE;
+    }
+    if( len > pf->Size - pf->Pos )
+    {
+        len = pf->Size - pf->Pos;
+    }
+    while( len )
+    {
+        sect = pf->Pos >> 9;
+        ofs = pf->Pos & 511;
+        step = ( len > DEF_UFAT_XFER_MAX * 512 ) ? ( DEF_UFAT_XFER_MAX * 512 ) : len;
+        n = ( ( pf->Pos & ( ( 512 << UFAT_Vol.Clus_Shift ) - 1 ) ) + step - 1 ) >> ( 9 + UFAT_Vol.Clus_Shift );
+        s = File_Map( pf, sect >> UFAT_Vol.Clus_Shift, n + 1, &clus, &cont );
+        if( s != ERR_SUCCESS )
+        {
+            s = ( s == UFAT_END ) ? ERR_UFAT_CHAIN : s;
+            break;
+        }
+        lba = Clus_Lba( clus ) + ( sect & ( ( 1 << UFAT_Vol.Clus_Shift ) - 1 ) );
+
+        if( ( ofs == 0 ) && ( step >= 512 ) && ( ( (uintptr_t)p & 3 ) == 0 ) )
+        {
+            n = ( cont << UFAT_Vol.Clus_Shift ) - ( sect & ( ( 1 << UFAT_Vol.Clus_Shift ) - 1 ) );
+            if( n > ( step >> 9 ) )
+            {
+                n = step >> 9;
+            }
+            if( UFAT_Vol.Win_Dirty && ( UFAT_Vol.Win_Lba >= lba ) && ( UFAT_Vol.Win_Lba < lba + n ) )
+            {
+                s = Win_Flush( );
+                if( s != ERR_SUCCESS )
+                {
+                    break;
+                }
+            }
+            s = UFAT_DISK_READ( lba, (uint8_t)n, p );
+            if( s != ERR_SUCCESS )
+            {
+                break;
+            }
+            step = n << 9;
+        }
+        else
+        {
+            s = Win_Load( lba );
+            if( s != ERR_SUCCESS )
+            {
+                break;
+            }
+            if( step > 512 - ofs )
+            {
+                step = 512 - ofs;
+            }
+            memcpy( p, &UFAT_Vol.Win[ ofs ], step );
+        }
+        p += step;
+        pf->Pos += step;
+        *plen += step;
+        len -= step;
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      UFAT_Write
+ *
+ * @brief   Write at the file position, growing the file as needed. Whole
+ *          sectors go straight from buf with one command per contiguous
+ *          run when buf is word aligned, the rest passes through Win.
+ *
+ * @para    plen: Bytes written, less than len when the disk is full.
+ *
+ * @return  ERR_SUCCESS, ERR_FILE_CLOSE, ERR_DISK_FULL, ERR_UFAT_CHAIN,
+ *          disk error.
+ */
+uint8_t UFAT_Write( UFAT_FILE *pf, const void *buf, uint32_t len, uint32_t *plen )
+{
+    const uint8_t *p = buf;
+    UFAT_RUN *r;
+    uint32_t sect, ofs, clus, cont, lba, n, step, last;
+    uint8_t  s = ERR_SUCCESS;
+
+    *plen = 0;
+    if( ( pf->Mode & UFAT_WRITE ) == 0 )
+    {
+        return ERR_FILE_CLOSE;
+    }
+    if( len > 0xFFFFFFFF - pf->Pos )
+    {
+        len = 0xFFFFFFFF - pf->Pos;
+    }
+    while( len )
+    {
+        sect = pf->Pos >> 9;
+        ofs = pf->Pos & 511;
+        step = ( len > DEF_UFAT_XFER_MAX * 512 ) ? ( DEF_UFAT_XFER_MAX * 512 ) : len;
+        n = ( ( pf->Pos & ( ( 512 << UFAT_Vol.Clus_Shift ) - 1 ) ) + step - 1 ) >> ( 9 + UFAT_Vol.Clus_Shift );
+        s = File_Map( pf, sect >> UFAT_Vol.Clus_Shift, n + 1, &clus, &cont );
+        if( s == UFAT_END )
+        {
+            /* Past the end of the chain, File_Map has left the last run
+             * ending at the last cluster. Every cluster this step needs is
+             * taken at once so that they come out contiguous and are
+             * written with one command, and the run is grown here rather
+             * than by reading the new FAT entries back. */
+            r = NULL;
+            cont = 0;
+            n += ( sect >> UFAT_Vol.Clus_Shift ) + 1;
+            if( pf->Run_Num )
+            {
+                r = &pf->Run[ pf->Run_Num - 1 ];
+                n -= r->Idx + r->Len;
+            }
+            do
+            {
+                last = r ? ( r->Clus + r->Len - 1 ) : 0;
+                s = Clus_Alloc( last, &clus );
+                if( s != ERR_SUCCESS )
+                {
+                    break;
+                }
+                cont++;
+                pf->Dirty = 1;
+                if( pf->Run_Num == 0 )
+                {
+                    pf->Start_Clus = clus;
+                    pf->Run_Num = 1;
+                    r = &pf->Run[ 0 ];
+                    r->Idx = 0;
+                    r->Clus = clus;
+                    r->Len = 1;
+                }
+                else if( clus == last + 1 )
+                {
+                    r->Len++;
+                }
+                else
+                {
+                    /* File_Map starts the next run from here */
+                    pf->Run_Next = clus;
+                    break;
+                }
+                pf->Run_Next = UFAT_EOC;
+            } while( --n );
+            if( cont == 0 )
+            {
+                break;
+            }
+            continue;
+        }
+        if( s != ERR_SUCCESS )
+        {
+            break;
+        }
+        lba = Clus_Lba( clus ) + ( sect & ( ( 1 << UFAT_Vol.Clus_Shift ) - 1 ) );
+
+        if( ( ofs == 0 ) && ( step >= 512 ) && ( ( (uintptr_t)p & 3 ) == 0 ) )
+        {
+            n = ( cont << UFAT_Vol.Clus_Shift ) - ( sect & ( ( 1 << UFAT_Vol.Clus_Shift ) - 1 ) );
+            if( n > ( step >> 9 ) )
+            {
+                n = step >> 9;
+            }
+            if( ( UFAT_Vol.Win_Lba >= lba ) && ( UFAT_Vol.Win_Lba < lba + n ) )
+            {
+                UFAT_Vol.Win_Lba = UFAT_LBA_NONE;
+                UFAT_Vol.Win_Dirty = 0;
+            }
+            s = UFAT_DISK_WRITE( lba, (uint8_t)n, (uint8_t *)p );
+            if( s != ERR_SUCCESS )
+            {
+                break;
+            }
+            step = n << 9;
+        }
+        else
+        {
+            if( step > 512 - ofs )
+            {
+                step = 512 - ofs;
+            }
+            if( ( ofs == 0 ) && ( pf->Pos >= pf->Size ) && ( UFAT_Vol.Win_Lba != lba ) )
+            {
+                /* Nothing of the file in this sector yet, no need to read it */
+                s = Win_Flush( );
+                if( s != ERR_SUCCESS )
+                {
+                    break;
+                }
+                memset( UFAT_Vol.Win, 0, DEF_UFAT_SECT_SIZE );
+                UFAT_Vol.Win_Lba = lba;
+            }
+            else
+            {
+                s = Win_Load( lba );
+                if( s != ERR_SUCCESS )
+                {
+                    break;
+                }
+            }
+            memcpy( &UFAT_Vol.Win[ ofs ], p, step );
+            UFAT_Vol.Win_Dirty = 1;
+        }
+        p += step;
+        pf->Pos += step;
+        *plen += step;
+        len -= step;
+        if( pf->Pos > pf->Size )
+        {
+            pf->Size = pf->Pos;
+        }
+        pf->Dirty = 1;
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      UFAT_Seek
+ *
+ * @brief   Move the file position, no further than the end of the file.
+ *
+ * @return  ERR_SUCCESS, ERR_FILE_CLOSE.
+ */
+uint8_t UFAT_Seek( UFAT_FILE *pf, uint32_t pos )
+{
+    if( pf->Mode == 0 )
+    {
+        return ERR_FILE_CLOSE;
+    }
+    pf->Pos = ( pos > pf->Size ) ? pf->Size : pos;
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      UFAT_Truncate
+ *
+ * @brief   Cut the file at the file position and free the clusters past
+ *          it.
+ *
+ * @return  ERR_SUCCESS, ERR_FILE_CLOSE, ERR_UFAT_CHAIN, disk error.
+ */
+uint8_t UFAT_Truncate( UFAT_FILE *pf )
+{
+    uint32_t clus, cont, next;
+    uint8_t  s;
+
+    if( ( pf->Mode & UFAT_WRITE ) == 0 )
+    {
+        return ERR_FILE_CLOSE;
+    }
+    if( pf->Pos == 0 )
+    {
+        s = ERR_SUCCESS;
+        if( pf->Start_Clus )
+        {
+            s = Chain_Free( pf->Start_Clus );
+        }
+        pf->Start_Clus = 0;
+    }
+    else
+    {
+        s = File_Map( pf, ( pf->Pos - 1 ) >> ( 9 + UFAT_Vol.Clus_Shift ), 1, &clus, &cont );
+        if( s == ERR_SUCCESS )
+        {
+            s = Fat_Get( clus, &next );
+        }
+        if( ( s == ERR_SUCCESS ) && ( next != UFAT_EOC ) )
+        {
+            s = Fat_Set( clus, UFAT_EOC );
+            if( s == ERR_SUCCESS )
+            {
+                s = Chain_Free( next );
+            }
+        }
+        if( s == UFAT_END )
+        {
+            s = ERR_UFAT_CHAIN;
+        }
+    }
+    pf->Size = pf->Pos;
+    pf->Run_Num = 0;
+    pf->Run_Next = 0;
+    pf->Dirty = 1;
+    return s;
+}
+
+/*********************************************************************
+ * @fn      UFAT_Sync
+ *
+ * @brief   Write the size, first cluster and time of a written file to
+ *          its directory entry and flush everything to the disk.
+ *
+ * @return  ERR_SUCCESS, ERR_FILE_CLOSE, disk error.
+ */
+uint8_t UFAT_Sync( UFAT_FILE *pf )
+{
+    uint8_t *p;
+    uint8_t s;
+
+    if( pf->Mode == 0 )
+    {
+        return ERR_FILE_CLOSE;
+    }
+    if( pf->Dirty )
+    {
+        s = Win_Load( pf->Dir_Lba );
+        if( s != ERR_SUCCESS )
+        {
+            return s;
+        }
+        p = &UFAT_Vol.Win[ pf->Dir_Ofs ];
+        p[ 11 ] |= ATTR_ARCHIVE;
+        St16( p + 18, (uint16_t)( UFAT_Time >> 16 ) );
+        St16( p + 20, (uint16_t)( pf->Start_Clus >> 16 ) );
+        St16( p + 22, (uint16_t)UFAT_Time );
+        St16( p + 24, (uint16_t)( UFAT_Time >> 16 ) );
+        St16( p + 26, (uint16_t)pf->Start_Clus );
+        St32( p + 28, pf->Size );
+        UFAT_Vol.Win_Dirty = 1;
+        pf->Dirty = 0;
+    }
+    return Vol_Sync( );
+}
+
+/*********************************************************************
+ * @fn      UFAT_Close
+ *
+ * @brief   Sync a written file and close it.
+ *
+ * @return  ERR_SUCCESS, ERR_FILE_CLOSE, disk error.
+ */
+uint8_t UFAT_Close( UFAT_FILE *pf )
+{
+    uint8_t s = ERR_SUCCESS;
+
+    if( pf->Mode == 0 )
+    {
+        return ERR_FILE_CLOSE;
+    }
+    if( pf->Mode & UFAT_WRITE )
+    {
+        s = UFAT_Sync( pf );
+    }
+    pf->Mode = 0;
+    return s;
+}
+
+/*********************************************************************
+ * @fn      UFAT_Delete
+ *
+ * @brief   Delete a file or an empty directory.
+ *
+ * @return  ERR_SUCCESS, ERR_MISS_FILE, ERR_MISS_DIR, ERR_UFAT_DENIED,
+ *          ERR_UFAT_NOT_EMPTY, disk error.
+ */
+uint8_t UFAT_Delete( const char *path )
+{
+    UFAT_DIR  d, sub;
+    UFAT_INFO info;
+    char      name[ DEF_UFAT_NAME_MAX ];
+    uint8_t   *p;
+    uint16_t  idx;
+    uint8_t   s;
+
+    s = Path_Find( path, &d, &info, name );
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    if( ( name[ 0 ] == 0 ) || ( info.Attr & ( ATTR_READ_ONLY | ATTR_VOLUME_ID ) ) )
+    {
+        return ERR_UFAT_DENIED;
+    }
+    idx = d.Idx;
+
+    if( info.Attr & ATTR_DIRECTORY )
+    {
+        if( info.Clus == 0 )
+        {
+            return ERR_UFAT_CHAIN;
+        }
+        Dir_Rewind( &sub, info.Clus );
+        for( ;; )
+        {
+            p = Dir_Ent( &sub );
+            if( p == NULL )
+            {
+                return ERR_USB_DISK_ERR;
+            }
+            if( p[ 0 ] == 0 )
+            {
+                break;
+            }
+            if( ( p[ 0 ] != 0xE5 ) && ( ( p[ 11 ] & 0x3F ) != ATTR_LONG_NAME ) && ( ( p[ 11 ] & ATTR_VOLUME_ID ) == 0 )
+                && ( memcmp( p, ".          ", 11 ) != 0 ) && ( memcmp( p, "..         ", 11 ) != 0 ) )
+            {
+                return ERR_UFAT_NOT_EMPTY;
+            }
+            s = Dir_Next( &sub, 0 );
+            if( s == UFAT_END )
+            {
+                break;
+            }
+            if( s != ERR_SUCCESS )
+            {
+                return s;
+            }
+        }
+    }
+
+    /* Long name entries, then the 8.3 entry */
+    s = Dir_Seek( &d, d.Lfn_Idx );
+    while( s == ERR_SUCCESS )
+    {
+        p = Dir_Ent( &d );
+        if( p == NULL )
+        {
+            return ERR_USB_DISK_ERR;
+        }
+        p[ 0 ] = 0xE5;
+        UFAT_Vol.Win_Dirty = 1;
+        if( d.Idx == idx )
+        {
+            break;
+        }
+        s = Dir_Next( &d, 0 );
+    }
+    if( ( s == ERR_SUCCESS ) && info.Clus )
+    {
+        s = Chain_Free( info.Clus );
+    }
+    if( s == ERR_SUCCESS )
+    {
+        s = Vol_Sync( );
+    }
+    return s;
+}
+
+/*********************************************************************
+ * @fn      UFAT_Mkdir
+ *
+ * @brief   Create a directory.
+ *
+ * @return  ERR_SUCCESS, ERR_UFAT_EXIST, ERR_MISS_DIR, ERR_UFAT_NAME,
+ *          ERR_FDT_OVER, ERR_DISK_FULL, disk error.
+ */
+uint8_t UFAT_Mkdir( const char *path )
+{
+    UFAT_DIR  d;
+    UFAT_INFO info;
+    char      name[ DEF_UFAT_NAME_MAX ];
+    uint32_t  clus, parent;
+    uint8_t   *p;
+    uint8_t   i, s;
+
+    s = Path_Find( path, &d, &info, name );
+    if( s != ERR_MISS_FILE )
+    {
+        return ( s == ERR_SUCCESS ) ? ERR_UFAT_EXIST : s;
+    }
+    s = Name_Check( name );
+    if( s == ERR_SUCCESS )
+    {
+        s = Clus_Alloc( 0, &clus );
+    }
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    s = Clus_Zero( clus );
+    if( s == ERR_SUCCESS )
+    {
+        /* "." and ".." in the first sector, left in Win by Clus_Zero */
+        parent = ( d.Start_Clus == UFAT_Vol.Root_Clus ) ? 0 : d.Start_Clus;
+        p = UFAT_Vol.Win;
+        for( i = 0; i < 2; i++, p += 32 )
+        {
+            memset( p, ' ', 11 );
+            memset( p, '.', i + 1 );
+            p[ 11 ] = ATTR_DIRECTORY;
+            St16( p + 14, (uint16_t)UFAT_Time );
+            St16( p + 16, (uint16_t)( UFAT_Time >> 16 ) );
+            St16( p + 18, (uint16_t)( UFAT_Time >> 16 ) );
+            St16( p + 20, (uint16_t)( ( i ? parent : clus ) >> 16 ) );
+            St16( p + 22, (uint16_t)UFAT_Time );
+            St16( p + 24, (uint16_t)( UFAT_Time >> 16 ) );
+            St16( p + 26, (uint16_t)( i ? parent : clus ) );
+        }
+        UFAT_Vol.Win_Dirty = 1;
+        s = Dir_Add( &d, name, ATTR_DIRECTORY, clus );
+    }
+    if( s != ERR_SUCCESS )
+    {
+        Chain_Free( clus );
+        return s;
+    }
+    return Vol_Sync( );
+}
+
+/*********************************************************************
+ * @fn      UFAT_Stat
+ *
+ * @brief   Directory entry of a file or directory.
+ *
+ * @return  ERR_SUCCESS, ERR_MISS_FILE, ERR_MISS_DIR, disk error.
+ */
+uint8_t UFAT_Stat( const char *path, UFAT_INFO *pinfo )
+{
+    UFAT_DIR d;
+    char     name[ DEF_UFAT_NAME_MAX ];
+
+    return Path_Find( path, &d, pinfo, name );
+}
+
+/*********************************************************************
+ * @fn      UFAT_OpenDir
+ *
+ * @brief   Start listing a directory, "/" or "" being the root.
+ *
+ * @return  ERR_SUCCESS, ERR_MISS_FILE, ERR_MISS_DIR, disk error.
+ */
+uint8_t UFAT_OpenDir( UFAT_DIR *pd, const char *path )
+{
+    UFAT_INFO info;
+    char      name[ DEF_UFAT_NAME_MAX ];
+    uint8_t   s;
+
+    s = Path_Find( path, pd, &info, name );
+    if( s != ERR_SUCCESS )
+    {
+        return s;
+    }
+    if( ( info.Attr & ATTR_DIRECTORY ) == 0 )
+    {
+        return ERR_MISS_DIR;
+    }
+    Dir_Rewind( pd, Dir_Start( info.Clus ) );
+    return ERR_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      UFAT_ReadDir
+ *
+ * @brief   Next entry of a directory, "." and ".." included.
+ *
+ * @return  ERR_SUCCESS, ERR_MISS_FILE - no more entries, disk error.
+ */
+uint8_t UFAT_ReadDir( UFAT_DIR *pd, UFAT_INFO *pinfo )
+{
+    uint8_t s;
+
+    s = Dir_Read( pd, pinfo );
+    if( s == ERR_SUCCESS )
+    {
+        s = Dir_Next( pd, 0 );
+        if( s == UFAT_END )
+        {
+            s = ERR_SUCCESS;
+        }
+    }
+    return ( s == UFAT_END ) ? ERR_MISS_FILE : s;
+}
+
+/*********************************************************************
+ * @fn      UFAT_Free
+ *
+ * @brief   Free space. Counted from the FAT on FAT12/16, and on FAT32
+ *          when FSInfo does not hold it.
+ *
+ * @para    psect: Free sectors.
+ *
+ * @return  ERR_SUCCESS, disk error.
+ */
+uint8_t UFAT_Free( uint32_t *psect )
+{
+    uint32_t c, val, n = 0;
+    uint8_t  s;
+
+    if( UFAT_Vol.Type == 0 )
+    {
+        return ERR_UFAT_NO_VOL;
+    }
+    if( UFAT_Vol.Free_Num == 0xFFFFFFFF )
+    {
+        for( c = 2; c < UFAT_Vol.Clus_Max; c++ )
+        {
+            s = Fat_Get( c, &val );
+            if( s != ERR_SUCCESS )
+            {
+                return s;
+            }
+            if( val == 0 )
+            {
+                n++;
+            }
+        }
+        UFAT_Vol.Free_Num = n;
+        UFAT_Vol.Fsi_Dirty = 1;
+    }
+    *psect = UFAT_Vol.Free_Num << UFAT_Vol.Clus_Shift;
+    return ERR_SUCCESS;
+}
@@ -0,0 +1,163 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : CH643UFI_Fat.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : FAT12/FAT16/FAT32 file system with long names, in
+ *                      source, on top of the sector cache.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+
+#ifndef __CH643UFI_FAT_H
+#define __CH643UFI_FAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************/
+/* Header File */
+#include "stdint.h"
+
+/*******************************************************************************/
+/* Macro Definition */
+
+/* Sector access, one command per call. Defined elsewhere to run the file
+ * system on something other than the U-disk, e.g. an image file. */
+#ifndef UFAT_DISK_READ
+#define UFAT_DISK_READ( lba, cnt, buf )     CHRV3CacheRead( lba, cnt, buf )
+#define UFAT_DISK_WRITE( lba, cnt, buf )    CHRV3CacheWrite( lba, cnt, buf )
+#define UFAT_DISK_SYNC( )                   CHRV3CacheFlush( )
+#endif
+
+#define DEF_UFAT_SECT_SIZE              512
+#ifndef DEF_UFAT_NAME_MAX
+#define DEF_UFAT_NAME_MAX               96                                      // Bytes of a UTF-8 name with its terminator
+#endif
+#ifndef DEF_UFAT_LFN_CHARS
+#define DEF_UFAT_LFN_CHARS              64                                      // Longest long name kept, longer ones show as 8.3
+#endif
+#ifndef DEF_UFAT_RUN_NUM
+#define DEF_UFAT_RUN_NUM                4                                       // Contiguous cluster runs remembered per file
+#endif
+#ifndef DEF_UFAT_XFER_MAX
+#define DEF_UFAT_XFER_MAX               128                                     // Sectors of one multi-sector transfer
+#endif
+
+/* Open Mode */
+#define UFAT_READ                       0x01
+#define UFAT_WRITE                      0x02
+#define UFAT_CREATE                     0x04                                    // Create the file if missing
+#define UFAT_TRUNC                      0x08                                    // Empty the file
+#define UFAT_APPEND                     0x10                                    // Start at the end
+
+/* Errors besides those of CHRV3UFI.h (ERR_MISS_FILE, ERR_MISS_DIR,
+ * ERR_DISK_FULL, ERR_FDT_OVER, ERR_MBR_ERROR, ERR_BPB_ERROR, ERR_FAT_ERROR)
+ * and those of the disk */
+#define ERR_UFAT_EXIST                  0x47                                    // Name in use
+#define ERR_UFAT_DENIED                 0x48                                    // Read-only, or file and directory mixed up
+#define ERR_UFAT_NOT_EMPTY              0x49                                    // Directory not empty
+#define ERR_UFAT_NAME                   0x4A                                    // Invalid or too long name
+#define ERR_UFAT_CHAIN                  0xA4                                    // Cluster chain broken or shorter than the file
+#define ERR_UFAT_NO_VOL                 0xA5                                    // Not mounted
+
+/*******************************************************************************/
+/* Struct Definition */
+
+/* Mounted volume, sectors of the FAT, directories and partial file sectors
+ * all pass through Win */
+typedef struct _UFAT_VOL
+{
+    uint8_t  Type;                                                              // DISK_FAT12/16/32, 0 - not mounted
+    uint8_t  Clus_Shift;                                                        // Sectors per cluster = 1 << Clus_Shift
+    uint8_t  Num_Fats;
+    uint8_t  Win_Dirty;
+    uint8_t  Fsi_Dirty;
+    uint16_t Root_Ents;                                                         // FAT12/16 root directory entries
+    uint32_t Win_Lba;
+    uint32_t Fat_Lba;
+    uint32_t Fat_Size;                                                          // Sectors of one FAT
+    uint32_t Root_Lba;                                                          // FAT12/16 root directory
+    uint32_t Root_Clus;                                                         // FAT32 root directory
+    uint32_t Data_Lba;                                                          // Cluster 2
+    uint32_t Clus_Max;                                                          // Clusters + 2
+    uint32_t Free_Hint;
+    uint32_t Free_Num;                                                          // 0xFFFFFFFF - not known
+    uint32_t Fsi_Lba;                                                           // FAT32 FSInfo sector, 0 - none
+    __attribute__((aligned(4))) uint8_t Win[ DEF_UFAT_SECT_SIZE ];
+} UFAT_VOL;
+
+/* Clusters Clus..Clus + Len - 1 hold file clusters Idx..Idx + Len - 1 */
+typedef struct _UFAT_RUN
+{
+    uint32_t Idx;
+    uint32_t Clus;
+    uint32_t Len;
+} UFAT_RUN;
+
+typedef struct _UFAT_FILE
+{
+    uint8_t  Mode;                                                              // 0 - closed
+    uint8_t  Dirty;                                                             // Directory entry to update
+    uint8_t  Run_Num;
+    uint16_t Dir_Ofs;                                                           // Directory entry in its sector
+    uint32_t Dir_Lba;
+    uint32_t Size;
+    uint32_t Pos;
+    uint32_t Start_Clus;
+    uint32_t Run_Next;                                                          // FAT entry after the last run, 0 - not read
+    UFAT_RUN Run[ DEF_UFAT_RUN_NUM ];
+} UFAT_FILE;
+
+typedef struct _UFAT_DIR
+{
+    uint32_t Start_Clus;                                                        // 0 - FAT12/16 root directory
+    uint32_t Clus;
+    uint32_t Lba;
+    uint16_t Idx;                                                               // Entry index in the directory
+    uint16_t Lfn_Idx;                                                           // First long name entry of the last entry read
+} UFAT_DIR;
+
+typedef struct _UFAT_INFO
+{
+    char     Name[ DEF_UFAT_NAME_MAX ];                                         // Long name, else the 8.3 name
+    char     Short[ 13 ];                                                       // 8.3 name
+    uint8_t  Attr;
+    uint16_t Date;
+    uint16_t Time;
+    uint32_t Size;
+    uint32_t Clus;
+} UFAT_INFO;
+
+/*******************************************************************************/
+/* Variable Declaration */
+extern UFAT_VOL UFAT_Vol;
+extern uint32_t UFAT_Time;                                                      // ( MAKE_FILE_DATE << 16 ) | MAKE_FILE_TIME, for new and written files
+
+/*******************************************************************************/
+/* Function Declaration */
+extern uint8_t UFAT_Mount( void );
+extern uint8_t UFAT_Unmount( void );
+extern uint8_t UFAT_Open( UFAT_FILE *pf, const char *path, uint8_t mode );
+extern uint8_t UFAT_Read( UFAT_FILE *pf, void *buf, uint32_t len, uint32_t *plen );
+extern uint8_t UFAT_Write( UFAT_FILE *pf, const void *buf, uint32_t len, uint32_t *plen );
+extern uint8_t UFAT_Seek( UFAT_FILE *pf, uint32_t pos );
+extern uint8_t UFAT_Truncate( UFAT_FILE *pf );
+extern uint8_t UFAT_Sync( UFAT_FILE *pf );
+extern uint8_t UFAT_Close( UFAT_FILE *pf );
+extern uint8_t UFAT_Delete( const char *path );
+extern uint8_t UFAT_Mkdir( const char *path );
+extern uint8_t UFAT_Stat( const char *path, UFAT_INFO *pinfo );
+extern uint8_t UFAT_OpenDir( UFAT_DIR *pd, const char *path );
+extern uint8_t UFAT_ReadDir( UFAT_DIR *pd, UFAT_INFO *pinfo );
+extern uint8_t UFAT_Free( uint32_t *psect );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
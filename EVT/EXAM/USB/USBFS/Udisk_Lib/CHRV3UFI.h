@@ -14,6 +14,9 @@
 #ifndef __CHRV3UFI_H__
 #define __CHRV3UFI_H__
 
+#include "CH643UFI_Cache.h"
+#include "CH643UFI_Fat.h"
+
 
 
 #define CHRV3_LIB_VER		0x10
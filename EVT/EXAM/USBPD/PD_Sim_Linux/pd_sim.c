@@ -0,0 +1,809 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : pd_sim.c
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Runs USBPD_SRC against USBPD_SNK on the PC: both
+ *                      examples talk through a simulated USBPD peripheral
+ *                      and cable, in simulated time.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+/*
+ *@Note
+ * main.c, PD_Process.c and PD_VDM.c of each example are built unchanged
+ * (pd_sim_port.cpp) and run as two coroutines. Each has its own clock in
+ * uS, Delay_Us/Delay_Ms and every pass of the main loop move it on, and
+ * the port that is behind runs next, in steps of at most SIM_STEP_US.
+ * TIM1 and USBPD interrupts are taken between steps.
+ * The PHY sends a packet in the time BMC at 300Kbps needs for it and puts
+ * it in the DMA buffer of the other port with BMC_BYTE_CNT and the status
+ * flags set as the chip does, if that port listens on the CC wire of the
+ * cable. The CC wires carry the pull-ups and pull-downs of both ports, so
+ * PD_Detect sees the comparator levels of a real attach.
+ * Packets can be lost on the wire to drive the retry, soft reset and
+ * hard reset paths. Times printed are those of PD_Stat, from attach.
+ * The Discover Identity ACK of SNK can be turned into BUSY on the wire,
+ * SRC has to wait tVDMBusy before it asks again.
+ *
+ * Build:
+ *   g++ -O2 -DPD_SIM_SRC -I../USBPD_SRC/User -I../../SRC/Core -I../../SRC/Debug
+ *       -I../../SRC/Peripheral/inc -c -o pd_src.o pd_sim_port.cpp
+ *   g++ -O2 -I../USBPD_SNK/User -I../../SRC/Core -I../../SRC/Debug
+ *       -I../../SRC/Peripheral/inc -c -o pd_snk.o pd_sim_port.cpp
+ *   objcopy -G Sim_Src_Port pd_src.o
+ *   objcopy -G Sim_Snk_Port pd_snk.o
+ *   gcc -O2 -I../USBPD_SRC/User -I../../SRC/Core -I../../SRC/Debug
+ *       -I../../SRC/Peripheral/inc -c -o pd_sim.o pd_sim.c
+ *   g++ -o pd_sim pd_sim.o pd_src.o pd_snk.o
+ *   Both examples define the same names, objcopy keeps only their SIM_PORT
+ *   global.
+ *
+ * Usage:
+ *   pd_sim [-T ms] [-f] [-d n] [-g n] [-m ms-ms] [-b n] [-v]
+ *   -T  simulated time, 1000 ms by default
+ *   -f  cable the other way round, SRC CC2 to SNK CC1
+ *   -d  lose every nth packet
+ *   -g  lose every nth GoodCRC
+ *   -m  lose every packet sent in this time window
+ *   -b  answer the first n Discover Identity requests with BUSY
+ *   -v  print the log of both ports and the packets on the wire
+ *   pd_sim -t runs the self-tests.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/wait.h>
+#include "pd_sim.h"
+#include "PD_VDM.h"
+
+#define SIM_STEP_US         5                       // Longest step of a port before the other runs
+#define SIM_LOOP_US         10                      // One pass of the main loop
+#define SIM_STACK_SIZE      ( 256 * 1024 )
+#define SIM_LINE_LEN        256
+
+typedef struct _SIM_PHY
+{
+    SIM_PORT      *Port;
+    ucontext_t     Ctx;
+    void          *Stack;
+    uint64_t       Now;                             // uS
+    unsigned long  Reg[ SIM_REG_NUM ];
+    uint32_t       Nvic[ 4 ];                       // Enabled interrupts
+    int            In_Irq;
+    int            Tx_Busy;
+    int            Tim_On, Tim_It, Tim_Flag;        // TIM1: counting, interrupt enabled, update pending
+    uint64_t       Tim_Next;
+    int            Wire[ 2 ];                       // CC pin of the other port on each CC pin, -1 - open
+    struct _SIM_PHY *Peer;
+    char           Line[ SIM_LINE_LEN ];
+    int            Line_Len;
+} SIM_PHY;
+
+typedef struct _SIM_OPT
+{
+    uint32_t Run_Ms;
+    int      Flip;
+    int      Drop_N;
+    int      Drop_GoodCRC_N;
+    uint32_t Mute_From, Mute_To;                    // ms
+    int      Busy_N;
+    int      Verbose;
+} SIM_OPT;
+
+static SIM_PHY Sim_Phy[ 2 ];
+static SIM_PHY *Sim_Cur;
+static ucontext_t Sim_Sched;
+static SIM_OPT Sim_Opt;
+static int Sim_Pkt_Cnt, Sim_GoodCRC_Cnt, Sim_Lost_Cnt;
+static int Sim_Busy_Cnt, Sim_Ident_Ack_Cnt;
+static uint64_t Sim_Busy_At;                        // uS, 0 - no BUSY waiting for the repeat
+static uint64_t Sim_Busy_Gap;                       // Shortest time from BUSY to the repeat, uS
+
+uint32_t SystemCoreClock = 48000000;
+
+/* Comparator thresholds of CC_CMP_xx in mV, 0 - comparator off */
+static const uint16_t Sim_Cmp_mV[ 8 ] = { 0, 0, 220, 450, 550, 660, 950, 1230 };
+/* Pull-up currents of CC_PU_xx in uA */
+static const uint16_t Sim_Pu_uA[ 4 ] = { 0, 330, 180, 80 };
+
+static const char *Sim_Ctrl_Name[ 32 ] =
+{
+    NULL, "GoodCRC", "GotoMin", "Accept", "Reject", "Ping", "PS_RDY", "Get_Source_Cap",
+    "Get_Sink_Cap", "DR_Swap", "PR_Swap", "VCONN_Swap", "Wait", "Soft_Reset", "Data_Reset",
+    "Data_Reset_Complete", "Not_Supported", "Get_Source_Cap_Extended", "Get_Status",
+};
+static const char *Sim_Data_Name[ 32 ] =
+{
+    NULL, "Source_Capabilities", "Request", "BIST", "Sink_Capabilities", "Battery_Status",
+    "Alert", "Get_Country_Info", "Enter_USB", "EPR_Request", "EPR_Mode", "Source_Info",
+    "Revision", NULL, NULL, "Vendor_Defined",
+};
+
+static void Sim_Irq( SIM_PHY *p );
+
+/*********************************************************************
+ * @fn      Sim_Wait
+ *
+ * @brief   Move the clock of the running port on, letting the other port
+ *          catch up at every step and taking interrupts in between.
+ *
+ * @return  none
+ */
+static void Sim_Wait( uint32_t us )
+{
+    SIM_PHY *p = Sim_Cur;
+    uint64_t end = p->Now + us;
+
+    while( p->Now < end )
+    {
+        p->Now = ( end - p->Now > SIM_STEP_US ) ? p->Now + SIM_STEP_US : end;
+        if( p->Tim_On && ( p->Now >= p->Tim_Next ) )
+        {
+            /* One update flag, ticks are lost while it is pending as on the chip */
+            p->Tim_Flag = 1;
+            p->Tim_Next += 1000 * ( ( p->Now - p->Tim_Next ) / 1000 + 1 );
+        }
+        swapcontext( &p->Ctx, &Sim_Sched );
+        Sim_Irq( p );
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Nvic_On
+ *
+ * @return  1 - the interrupt is enabled
+ */
+static int Sim_Nvic_On( SIM_PHY *p, int irq )
+{
+    return ( p->Nvic[ irq >> 5 ] >> ( irq & 0x1F ) ) & 1;
+}
+
+/*********************************************************************
+ * @fn      Sim_Irq
+ *
+ * @brief   Take the pending TIM1 and USBPD interrupts of a port. Handlers
+ *          do not nest, both have the same priority in the examples.
+ *
+ * @return  none
+ */
+static void Sim_Irq( SIM_PHY *p )
+{
+    unsigned long cfg, st;
+    int n;
+
+    if( p->In_Irq )
+    {
+        return;
+    }
+    p->In_Irq = 1;
+    for( n = 0; n < 16; n++ )
+    {
+        if( p->Tim_Flag && p->Tim_It && Sim_Nvic_On( p, TIM1_UP_IRQn ) )
+        {
+            p->Port->Tim1_Irq( );
+            continue;
+        }
+        cfg = p->Reg[ SIM_REG_CONFIG ];
+        st = p->Reg[ SIM_REG_STATUS ];
+        if( Sim_Nvic_On( p, USBPD_IRQn ) &&
+            ( ( ( cfg & IE_RX_ACT ) && ( st & IF_RX_ACT ) ) ||
+              ( ( cfg & IE_RX_RESET ) && ( st & IF_RX_RESET ) ) ||
+              ( ( cfg & IE_TX_END ) && ( st & IF_TX_END ) ) ) )
+        {
+            p->Port->Usbpd_Irq( );
+            continue;
+        }
+        break;
+    }
+    p->In_Irq = 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Cc_mV
+ *
+ * @brief   Voltage on a CC pin: the pull-up currents of the wire into the
+ *          5.1K pull-down (CC_PD) if there is one, else VDD or nothing.
+ *
+ * @return  mV
+ */
+static int Sim_Cc_mV( SIM_PHY *p, int pin )
+{
+    unsigned long cc = p->Reg[ SIM_REG_PORT_CC1 + pin ], peer;
+    int ua, rd;
+
+    ua = Sim_Pu_uA[ ( cc & CC_PU_Mask ) >> 2 ];
+    rd = ( cc & CC_PD ) != 0;
+    if( p->Wire[ pin ] >= 0 )
+    {
+        peer = p->Peer->Reg[ SIM_REG_PORT_CC1 + p->Wire[ pin ] ];
+        ua += Sim_Pu_uA[ ( peer & CC_PU_Mask ) >> 2 ];
+        rd |= ( peer & CC_PD ) != 0;
+    }
+    if( rd )
+    {
+        return ( ua * 51 / 10 < 3300 ) ? ua * 51 / 10 : 3300;
+    }
+    return ua ? 3300 : 0;
+}
+
+/*********************************************************************
+ * @fn      Sim_Log
+ *
+ * @brief   Print a line of the log with the time and the port.
+ *
+ * @return  none
+ */
+static void Sim_Log( SIM_PHY *p, const char *fmt, ... )
+{
+    va_list ap;
+
+    if( Sim_Opt.Verbose == 0 )
+    {
+        return;
+    }
+    printf( "%9.3f %s  ", p->Now / 1000.0, p->Port->Name );
+    va_start( ap, fmt );
+    vprintf( fmt, ap );
+    va_end( ap );
+    printf( "\n" );
+}
+
+/*********************************************************************
+ * @fn      Sim_Lose
+ *
+ * @brief   Decide whether the packet is lost on the wire.
+ *
+ * @return  1 - lost
+ */
+static int Sim_Lose( SIM_PHY *p, const uint8_t *pkt, int len, int hrst )
+{
+    uint32_t ms = p->Now / 1000;
+    int lost = 0;
+
+    Sim_Pkt_Cnt++;
+    if( ( Sim_Opt.Mute_To > Sim_Opt.Mute_From ) && ( ms >= Sim_Opt.Mute_From ) && ( ms < Sim_Opt.Mute_To ) )
+    {
+        lost = 1;
+    }
+    if( Sim_Opt.Drop_N && ( ( Sim_Pkt_Cnt % Sim_Opt.Drop_N ) == 0 ) )
+    {
+        lost = 1;
+    }
+    if( !hrst && ( len == 2 ) && ( ( pkt[ 0 ] & 0x1F ) == DEF_TYPE_GOODCRC ) )
+    {
+        if( Sim_Opt.Drop_GoodCRC_N && ( ( ++Sim_GoodCRC_Cnt % Sim_Opt.Drop_GoodCRC_N ) == 0 ) )
+        {
+            lost = 1;
+        }
+    }
+    Sim_Lost_Cnt += lost;
+    return lost;
+}
+
+/*********************************************************************
+ * @fn      Sim_Vdm
+ *
+ * @brief   Watch Discover Identity on SOP. The first Sim_Opt.Busy_N ACKs
+ *          of SNK go out as BUSY, and the shortest time from a BUSY to
+ *          the request SRC repeats is kept.
+ *
+ * @return  none
+ */
+static void Sim_Vdm( SIM_PHY *p, uint8_t *pkt, int *plen, int sop )
+{
+    uint64_t gap;
+
+    if( ( sop != UPD_SOP0 ) || ( *plen < 6 ) || ( ( pkt[ 1 ] & 0x70 ) == 0 ) ||
+        ( ( pkt[ 0 ] & 0x1F ) != DEF_TYPE_VENDOR_DEFINED ) || ( ( pkt[ 3 ] & DEF_VDM_STRUCTURED ) == 0 ) ||
+        ( ( pkt[ 2 ] & DEF_VDM_CMD_MASK ) != DEF_VDM_DISC_IDENT ) )
+    {
+        return;
+    }
+    if( ( p == &Sim_Phy[ 0 ] ) && ( ( pkt[ 2 ] & DEF_VDM_CMD_TYPE_MASK ) == DEF_VDM_CMD_TYPE_REQ ) )
+    {
+        if( Sim_Busy_At )
+        {
+            gap = p->Now - Sim_Busy_At;
+            if( ( Sim_Busy_Gap == 0 ) || ( gap < Sim_Busy_Gap ) )
+            {
+                Sim_Busy_Gap = gap;
+            }
+            Sim_Busy_At = 0;
+        }
+    }
+    else if( ( p == &Sim_Phy[ 1 ] ) && ( ( pkt[ 2 ] & DEF_VDM_CMD_TYPE_MASK ) == DEF_VDM_CMD_TYPE_ACK ) )
+    {
+        if( Sim_Busy_Cnt < Sim_Opt.Busy_N )
+        {
+            /* Keep the VDM header only */
+            pkt[ 1 ] = ( pkt[ 1 ] & 0x8F ) | 0x10;
+            pkt[ 2 ] |= DEF_VDM_CMD_TYPE_BUSY;
+            *plen = 6;
+            Sim_Busy_Cnt++;
+            Sim_Busy_At = p->Now;
+        }
+        else
+        {
+            Sim_Ident_Ack_Cnt++;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Tx
+ *
+ * @brief   Send the packet set up by PD_Phy_SendPack: BMC_TX_SZ bytes at
+ *          DMA as TX_SEL says. Takes the time of the packet, then hands
+ *          it to the other port and sets IF_TX_END.
+ *
+ * @return  none
+ */
+static void Sim_Tx( SIM_PHY *p )
+{
+    SIM_PHY *q = p->Peer;
+    uint8_t pkt[ 64 ];
+    int len = p->Reg[ SIM_REG_BMC_TX_SZ ] & 0x3F;
+    int sop = p->Reg[ SIM_REG_TX_SEL ];
+    int pin = ( p->Reg[ SIM_REG_CONFIG ] & CC_SEL ) ? 1 : 0;
+    int hrst = ( sop == UPD_HARD_RESET );
+    int qpin = p->Wire[ pin ], lost, type;
+    const char *pname;
+
+    if( !hrst && p->Reg[ SIM_REG_DMA ] )
+    {
+        memcpy( pkt, (const void *)p->Reg[ SIM_REG_DMA ], len );
+    }
+    else
+    {
+        len = 0;
+    }
+    Sim_Vdm( p, pkt, &len, sop );
+    lost = Sim_Lose( p, pkt, len, hrst );
+    if( Sim_Opt.Verbose )
+    {
+        if( hrst )
+        {
+            Sim_Log( p, "> Hard_Reset%s", lost ? " (lost)" : "" );
+        }
+        else if( len >= 2 )
+        {
+            type = pkt[ 0 ] & 0x1F;
+            pname = ( ( pkt[ 1 ] & 0x70 ) ? Sim_Data_Name : Sim_Ctrl_Name )[ type ];
+            Sim_Log( p, "> %s %s #%d, %d bytes%s", ( sop == UPD_SOP0 ) ? "SOP " : "SOP'",
+                     pname ? pname : "?", ( pkt[ 1 ] >> 1 ) & 7, len, lost ? " (lost)" : "" );
+        }
+    }
+
+    /* Preamble, SOP, 4b5b coded header and data, CRC and EOP at 3.33uS a bit */
+    p->Tx_Busy = 1;
+    Sim_Wait( hrst ? 84 * 10 / 3 : ( 129 + 10 * len ) * 10 / 3 );
+    p->Tx_Busy = 0;
+
+    if( !lost && ( qpin >= 0 ) && ( ( ( q->Reg[ SIM_REG_CONFIG ] & CC_SEL ) ? 1 : 0 ) == qpin ) && !q->Tx_Busy )
+    {
+        if( hrst )
+        {
+            q->Reg[ SIM_REG_STATUS ] |= IF_RX_RESET;
+        }
+        else if( ( ( q->Reg[ SIM_REG_CONTROL ] & ( PD_TX_EN | BMC_START ) ) == BMC_START ) && q->Reg[ SIM_REG_DMA ] )
+        {
+            memcpy( (void *)q->Reg[ SIM_REG_DMA ], pkt, len );
+            q->Reg[ SIM_REG_BMC_BYTE_CNT ] = len + 4;
+            q->Reg[ SIM_REG_STATUS ] &= ~MASK_PD_STAT;
+            q->Reg[ SIM_REG_STATUS ] |= IF_RX_ACT | ( ( sop == UPD_SOP0 ) ? PD_RX_SOP0 : PD_RX_SOP1_HRST );
+        }
+    }
+    p->Reg[ SIM_REG_STATUS ] |= IF_TX_END;
+    p->Reg[ SIM_REG_CONTROL ] &= ~BMC_START;
+}
+
+/*********************************************************************
+ * @fn      Sim_Reg_Read
+ *
+ * @brief   Read a register of the running port. PA_CC_AI and the CC pins
+ *          of GPIOC follow the voltage on the CC wires.
+ *
+ * @return  register value
+ */
+unsigned long Sim_Reg_Read( int reg )
+{
+    SIM_PHY *p = Sim_Cur;
+    unsigned long v = p->Reg[ reg ];
+    int pin, cmp;
+
+    if( ( reg == SIM_REG_PORT_CC1 ) || ( reg == SIM_REG_PORT_CC2 ) )
+    {
+        pin = reg - SIM_REG_PORT_CC1;
+        cmp = ( v & CC_CMP_Mask ) >> 5;
+        v &= ~PA_CC_AI;
+        if( Sim_Cmp_mV[ cmp ] && ( Sim_Cc_mV( p, pin ) > Sim_Cmp_mV[ cmp ] ) )
+        {
+            v |= PA_CC_AI;
+        }
+    }
+    else if( reg == SIM_REG_GPIOC_INDR )
+    {
+        /* USBPD_IN_HVT: 2.2V input threshold */
+        v = ( ( Sim_Cc_mV( p, 0 ) > 2200 ) ? PIN_CC1 : 0 ) | ( ( Sim_Cc_mV( p, 1 ) > 2200 ) ? PIN_CC2 : 0 );
+    }
+    return v;
+}
+
+/*********************************************************************
+ * @fn      Sim_Reg_Write
+ *
+ * @brief   Write a register of the running port. The status flags are
+ *          cleared by writing 1, PD_ALL_CLR clears them all and
+ *          BMC_START with PD_TX_EN sends a packet.
+ *
+ * @return  none
+ */
+void Sim_Reg_Write( int reg, unsigned long val )
+{
+    SIM_PHY *p = Sim_Cur;
+    unsigned long old;
+
+    switch( reg )
+    {
+        case SIM_REG_STATUS:
+            p->Reg[ reg ] = ( p->Reg[ reg ] & ~val & ~BMC_AUX_Mask & 0xFC ) | ( val & BMC_AUX_Mask );
+            break;
+
+        case SIM_REG_CONFIG:
+            p->Reg[ reg ] = val & 0xFFFF;
+            if( val & PD_ALL_CLR )
+            {
+                p->Reg[ SIM_REG_STATUS ] &= BMC_AUX_Mask;
+            }
+            break;
+
+        case SIM_REG_CONTROL:
+            /* BMC_START is still set from receiving when PD_TX_EN is set,
+             * sending starts once the port is a transmitter */
+            old = p->Reg[ reg ];
+            p->Reg[ reg ] = val & 0xFF;
+            if( ( old & PD_TX_EN ) && ( ( val & ( PD_TX_EN | BMC_START ) ) == ( PD_TX_EN | BMC_START ) ) )
+            {
+                Sim_Tx( p );
+            }
+            break;
+
+        case SIM_REG_DMA:
+            p->Reg[ reg ] = val;
+            break;
+
+        default:
+            p->Reg[ reg ] = val & 0xFFFF;
+            break;
+    }
+}
+
+void Sim_Nvic_Cmd( int irq, int en )
+{
+    if( en )
+    {
+        Sim_Cur->Nvic[ irq >> 5 ] |= 1u << ( irq & 0x1F );
+    }
+    else
+    {
+        Sim_Cur->Nvic[ irq >> 5 ] &= ~( 1u << ( irq & 0x1F ) );
+    }
+}
+
+/*********************************************************************
+ * @fn      Sim_Printf
+ *
+ * @brief   printf of the examples: whole lines go to the log.
+ *
+ * @return  characters printed
+ */
+int Sim_Printf( const char *fmt, ... )
+{
+    SIM_PHY *p = Sim_Cur;
+    char buf[ SIM_LINE_LEN ];
+    va_list ap;
+    int n, i;
+
+    va_start( ap, fmt );
+    n = vsnprintf( buf, sizeof( buf ), fmt, ap );
+    va_end( ap );
+    for( i = 0; buf[ i ]; i++ )
+    {
+        if( buf[ i ] == '\n' )
+        {
+            p->Line[ p->Line_Len ] = 0;
+            Sim_Log( p, "%s", p->Line );
+            p->Line_Len = 0;
+        }
+        else if( ( buf[ i ] != '\r' ) && ( p->Line_Len < SIM_LINE_LEN - 1 ) )
+        {
+            p->Line[ p->Line_Len++ ] = buf[ i ];
+        }
+    }
+    return n;
+}
+
+/* Delays, clocks and the peripherals the examples set up */
+void Delay_Init( void ) { }
+void Delay_Us( uint32_t n ) { Sim_Wait( n ); }
+void Delay_Ms( uint32_t n ) { Sim_Wait( n * 1000 ); }
+void USART_Printf_Init( uint32_t baudrate ) { }
+void SystemInit( void ) { }
+void SystemCoreClockUpdate( void ) { }
+uint32_t DBGMCU_GetCHIPID( void ) { return 0x64300000; }
+void NVIC_PriorityGroupConfig( uint32_t NVIC_PriorityGroup ) { }
+void NVIC_Init( NVIC_InitTypeDef *NVIC_InitStruct ) { Sim_Nvic_Cmd( NVIC_InitStruct->NVIC_IRQChannel, NVIC_InitStruct->NVIC_IRQChannelCmd ); }
+void RCC_AHBPeriphClockCmd( uint32_t RCC_AHBPeriph, FunctionalState NewState ) { }
+void RCC_APB1PeriphClockCmd( uint32_t RCC_APB1Periph, FunctionalState NewState ) { }
+void RCC_APB2PeriphClockCmd( uint32_t RCC_APB2Periph, FunctionalState NewState ) { }
+void GPIO_Init( GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct ) { }
+void GPIO_EXTILineConfig( uint8_t GPIO_PortSource, uint16_t GPIO_PinSource ) { }
+void EXTI_Init( EXTI_InitTypeDef *EXTI_InitStruct ) { }
+void EXTI_ClearITPendingBit( uint32_t EXTI_Line ) { }
+ITStatus EXTI_GetITStatus( uint32_t EXTI_Line ) { return RESET; }
+void TIM_TimeBaseInit( TIM_TypeDef *TIMx, TIM_TimeBaseInitTypeDef *TIM_TimeBaseInitStruct ) { }
+ITStatus TIM_GetITStatus( TIM_TypeDef *TIMx, uint16_t TIM_IT ) { return Sim_Cur->Tim_Flag ? SET : RESET; }
+void TIM_ClearITPendingBit( TIM_TypeDef *TIMx, uint16_t TIM_IT ) { Sim_Cur->Tim_Flag = 0; }
+
+void TIM_Cmd( TIM_TypeDef *TIMx, FunctionalState NewState )
+{
+    Sim_Cur->Tim_On = ( NewState != DISABLE );
+    Sim_Cur->Tim_Next = Sim_Cur->Now + 1000;
+}
+
+/* The main loop turns the TIM1 interrupt off and on again once a pass */
+void TIM_ITConfig( TIM_TypeDef *TIMx, uint16_t TIM_IT, FunctionalState NewState )
+{
+    Sim_Cur->Tim_It = ( NewState != DISABLE );
+    if( NewState != DISABLE )
+    {
+        Sim_Wait( SIM_LOOP_US );
+    }
+}
+
+/* The SRC example sleeps on detach until a CC pin wakes it up */
+void PWR_EnterSTANDBYMode( void )
+{
+    Sim_Log( Sim_Cur, "(standby)" );
+}
+
+/*********************************************************************
+ * @fn      Sim_Entry
+ *
+ * @brief   Coroutine of a port, runs main( ) of its example.
+ *
+ * @return  none
+ */
+static void Sim_Entry( void )
+{
+    Sim_Cur->Port->Main( );
+    Sim_Cur->Now = UINT64_MAX;
+}
+
+/*********************************************************************
+ * @fn      Sim_Run
+ *
+ * @brief   Attach SRC to SNK and run both for Sim_Opt.Run_Ms.
+ *
+ * @return  none
+ */
+static void Sim_Run( SIM_STAT *psrc, SIM_STAT *psnk )
+{
+    SIM_PHY *p;
+    int i;
+
+    memset( Sim_Phy, 0, sizeof( Sim_Phy ) );
+    Sim_Phy[ 0 ].Port = &Sim_Src_Port;
+    Sim_Phy[ 1 ].Port = &Sim_Snk_Port;
+    Sim_Phy[ 0 ].Peer = &Sim_Phy[ 1 ];
+    Sim_Phy[ 1 ].Peer = &Sim_Phy[ 0 ];
+    /* The cable has one CC wire, VCONN is not modelled */
+    Sim_Phy[ 0 ].Wire[ 0 ] = Sim_Opt.Flip ? -1 : 0;
+    Sim_Phy[ 0 ].Wire[ 1 ] = Sim_Opt.Flip ? 0 : -1;
+    Sim_Phy[ 1 ].Wire[ 0 ] = Sim_Opt.Flip ? 1 : 0;
+    Sim_Phy[ 1 ].Wire[ 1 ] = -1;
+    for( i = 0; i < 2; i++ )
+    {
+        p = &Sim_Phy[ i ];
+        p->Stack = malloc( SIM_STACK_SIZE );
+        getcontext( &p->Ctx );
+        p->Ctx.uc_stack.ss_sp = p->Stack;
+        p->Ctx.uc_stack.ss_size = SIM_STACK_SIZE;
+        p->Ctx.uc_link = &Sim_Sched;
+        makecontext( &p->Ctx, Sim_Entry, 0 );
+    }
+
+    for( ;; )
+    {
+        p = ( Sim_Phy[ 0 ].Now <= Sim_Phy[ 1 ].Now ) ? &Sim_Phy[ 0 ] : &Sim_Phy[ 1 ];
+        if( p->Now >= (uint64_t)Sim_Opt.Run_Ms * 1000 )
+        {
+            break;
+        }
+        Sim_Cur = p;
+        swapcontext( &Sim_Sched, &p->Ctx );
+    }
+    Sim_Src_Port.Get_Stat( psrc );
+    Sim_Snk_Port.Get_Stat( psnk );
+}
+
+/*********************************************************************
+ * @fn      Sim_Contract
+ *
+ * @return  1 - the port got to an explicit contract
+ */
+static int Sim_Contract( const SIM_STAT *ps )
+{
+    return ( ps->Contract_Timing == 0 ) && ( ps->Contract_Time != 0 );
+}
+
+static void Sim_Print_Stat( const char *pname, const SIM_STAT *ps )
+{
+    if( Sim_Contract( ps ) )
+    {
+        printf( "%s: contract in %u ms", pname, ps->Contract_Time );
+    }
+    else
+    {
+        printf( "%s: no contract", pname );
+    }
+    printf( ", state %u, retries %u, failed %u, soft resets %u, hard resets %u sent %u received\n",
+            ps->PD_State, ps->Tx_Retry_Cnt, ps->Tx_Fail_Cnt, ps->Soft_Reset_Cnt,
+            ps->Hard_Reset_Cnt, ps->Rx_Hard_Reset_Cnt );
+}
+
+/*********************************************************************
+ * @fn      Sim_Test
+ *
+ * @brief   Run one case in a child process, so that both examples start
+ *          from their initial globals, and check the outcome.
+ *
+ * @param   hrst - 0 - both ports must reach a contract, 1 - SRC must send
+ *          a hard reset and SNK receive it
+ *
+ * @return  0 - passed
+ */
+static int Sim_Test( const char *pname, const SIM_OPT *popt, int hrst )
+{
+    SIM_STAT src, snk;
+    pid_t pid;
+    int st, ok;
+
+    fflush( stdout );
+    pid = fork( );
+    if( pid == 0 )
+    {
+        Sim_Opt = *popt;
+        Sim_Run( &src, &snk );
+        if( hrst )
+        {
+            ok = ( src.Hard_Reset_Cnt != 0 ) && ( snk.Rx_Hard_Reset_Cnt != 0 );
+        }
+        else
+        {
+            ok = Sim_Contract( &src ) && Sim_Contract( &snk );
+        }
+        if( popt->Busy_N )
+        {
+            /* Each BUSY followed by a repeat no sooner than tVDMBusy, then the ACK */
+            ok = ok && ( Sim_Busy_Cnt == popt->Busy_N ) && ( Sim_Ident_Ack_Cnt == 1 ) &&
+                 ( Sim_Busy_Gap >= DEF_VDM_BUSY_TMR * 1000 );
+        }
+        printf( "%-28s %s, SRC %u ms, SNK %u ms, retries %u/%u, hard resets %u/%u, %d of %d packets lost\n",
+                pname, ok ? "ok  " : "FAIL", src.Contract_Time, snk.Contract_Time,
+                src.Tx_Retry_Cnt, snk.Tx_Retry_Cnt, src.Hard_Reset_Cnt, snk.Rx_Hard_Reset_Cnt,
+                Sim_Lost_Cnt, Sim_Pkt_Cnt );
+        if( popt->Busy_N )
+        {
+            printf( "%-28s %d BUSY, repeated after %.3f ms at the least\n", "",
+                    Sim_Busy_Cnt, Sim_Busy_Gap / 1000.0 );
+        }
+        fflush( stdout );
+        _exit( !ok );
+    }
+    if( ( pid < 0 ) || ( waitpid( pid, &st, 0 ) != pid ) || !WIFEXITED( st ) )
+    {
+        printf( "%-28s FAIL, crashed\n", pname );
+        return 1;
+    }
+    return WEXITSTATUS( st );
+}
+
+/*********************************************************************
+ * @fn      Sim_Self_Test
+ *
+ * @brief   Contract on a clean cable either way round and with packets
+ *          lost, the hard reset path when SNK cannot be heard, and the
+ *          Discover Identity of SRC repeated after BUSY.
+ *
+ * @return  number of failed cases
+ */
+static int Sim_Self_Test( void )
+{
+    SIM_OPT opt;
+    int fail = 0;
+
+    memset( &opt, 0, sizeof( opt ) );
+    opt.Run_Ms = 1000;
+    fail += Sim_Test( "clean", &opt, 0 );
+    opt.Flip = 1;
+    fail += Sim_Test( "cable flipped", &opt, 0 );
+    opt.Flip = 0;
+    opt.Drop_GoodCRC_N = 3;
+    fail += Sim_Test( "every 3rd GoodCRC lost", &opt, 0 );
+    opt.Drop_GoodCRC_N = 0;
+    /* Not every 2nd or 4th: SRC waits with Delay_Ms( 2 ) after a Request
+     * and does not listen, the retransmission of Accept is missed too */
+    opt.Drop_N = 5;
+    fail += Sim_Test( "every 5th packet lost", &opt, 0 );
+    opt.Drop_N = 0;
+    /* SNK's Request and its Soft_Reset and Hard_Reset after it are lost,
+     * SRC sends Hard_Reset when tSenderResponse runs out. Later the hard
+     * reset of SRC would fall while SNK polls with the interrupt off. */
+    opt.Mute_From = 346;
+    opt.Mute_To = 372;
+    fail += Sim_Test( "SNK not heard, hard reset", &opt, 1 );
+    memset( &opt, 0, sizeof( opt ) );
+    opt.Run_Ms = 1000;
+    opt.Busy_N = DEF_VDM_RETRY_MAX;
+    fail += Sim_Test( "Discover Identity BUSY", &opt, 0 );
+    printf( "%s\n", fail ? "self-test FAILED" : "self-test passed" );
+    return fail;
+}
+
+int main( int argc, char **argv )
+{
+    SIM_STAT src, snk;
+    int c;
+
+    Sim_Opt.Run_Ms = 1000;
+    while( ( c = getopt( argc, argv, "T:fd:g:m:b:vt" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 'T':
+                Sim_Opt.Run_Ms = strtoul( optarg, NULL, 0 );
+                break;
+            case 'f':
+                Sim_Opt.Flip = 1;
+                break;
+            case 'd':
+                Sim_Opt.Drop_N = atoi( optarg );
+                break;
+            case 'g':
+                Sim_Opt.Drop_GoodCRC_N = atoi( optarg );
+                break;
+            case 'm':
+                if( sscanf( optarg, "%u-%u", &Sim_Opt.Mute_From, &Sim_Opt.Mute_To ) != 2 )
+                {
+                    fprintf( stderr, "-m from-to, in ms\n" );
+                    return 1;
+                }
+                break;
+            case 'b':
+                Sim_Opt.Busy_N = atoi( optarg );
+                break;
+            case 'v':
+                Sim_Opt.Verbose = 1;
+                break;
+            case 't':
+                return Sim_Self_Test( ) ? 1 : 0;
+            default:
+                fprintf( stderr, "usage: %s [-T ms] [-f] [-d n] [-g n] [-m ms-ms] [-b n] [-v] | -t\n", argv[ 0 ] );
+                return 1;
+        }
+    }
+
+    Sim_Run( &src, &snk );
+    Sim_Print_Stat( "SRC", &src );
+    Sim_Print_Stat( "SNK", &snk );
+    printf( "wire: %d packets, %d lost\n", Sim_Pkt_Cnt, Sim_Lost_Cnt );
+    return 0;
+}
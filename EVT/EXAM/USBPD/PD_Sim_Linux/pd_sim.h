@@ -0,0 +1,129 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : pd_sim.h
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : Simulated USBPD peripheral shared by pd_sim.c and the
+ *                      PD code built for the PC by pd_sim_port.cpp.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#ifndef __PD_SIM_H
+#define __PD_SIM_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* The peripheral headers as they are, minus the RISC-V bits */
+#define interrupt( x )      unused
+#include "debug.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Registers of the simulated peripherals */
+#define SIM_REG_CONFIG          0
+#define SIM_REG_BMC_CLK_CNT     1
+#define SIM_REG_CONTROL         2
+#define SIM_REG_TX_SEL          3
+#define SIM_REG_BMC_TX_SZ       4
+#define SIM_REG_DATA_BUF        5
+#define SIM_REG_STATUS          6
+#define SIM_REG_BMC_BYTE_CNT    7
+#define SIM_REG_PORT_CC1        8
+#define SIM_REG_PORT_CC2        9
+#define SIM_REG_DMA             10
+#define SIM_REG_GPIOC_INDR      11
+#define SIM_REG_NUM             12
+
+/* What pd_sim.c reads of the PD_Stat and PD_Ctl of a port */
+typedef struct _SIM_STAT
+{
+    uint16_t Contract_Time;
+    uint16_t Tx_Retry_Cnt;
+    uint16_t Tx_Fail_Cnt;
+    uint16_t GoodCRC_Drop_Cnt;
+    uint8_t  Soft_Reset_Cnt;
+    uint8_t  Hard_Reset_Cnt;
+    uint8_t  Rx_Hard_Reset_Cnt;
+    uint8_t  Contract_Timing;
+    uint8_t  PD_State;
+} SIM_STAT;
+
+/* One build of the PD code, defined by pd_sim_port.cpp */
+typedef struct _SIM_PORT
+{
+    const char *Name;
+    int  ( *Main )( void );
+    void ( *Usbpd_Irq )( void );
+    void ( *Tim1_Irq )( void );
+    void ( *Get_Stat )( SIM_STAT *ps );
+} SIM_PORT;
+
+extern SIM_PORT Sim_Src_Port;
+extern SIM_PORT Sim_Snk_Port;
+
+extern unsigned long Sim_Reg_Read( int reg );
+extern void Sim_Reg_Write( int reg, unsigned long val );
+extern void Sim_Nvic_Cmd( int irq, int en );
+extern int  Sim_Printf( const char *fmt, ... );
+
+#ifdef __cplusplus
+}
+
+/* A register whose reads and writes go to pd_sim.c, which gives the status
+ * flags their write-1-to-clear behaviour and starts a transmission on
+ * BMC_START. Plain memory cannot do either. */
+namespace
+{
+template< int R, typename T > struct Sim_Reg
+{
+    operator T( ) const { return (T)Sim_Reg_Read( R ); }
+    Sim_Reg &operator=( unsigned long v ) { Sim_Reg_Write( R, v ); return *this; }
+    Sim_Reg &operator|=( unsigned long v ) { Sim_Reg_Write( R, Sim_Reg_Read( R ) | v ); return *this; }
+    Sim_Reg &operator&=( unsigned long v ) { Sim_Reg_Write( R, Sim_Reg_Read( R ) & v ); return *this; }
+};
+
+struct SIM_USBPD
+{
+    Sim_Reg< SIM_REG_CONFIG, uint16_t >       CONFIG;
+    Sim_Reg< SIM_REG_BMC_CLK_CNT, uint16_t >  BMC_CLK_CNT;
+    Sim_Reg< SIM_REG_CONTROL, uint8_t >       CONTROL;
+    Sim_Reg< SIM_REG_TX_SEL, uint8_t >        TX_SEL;
+    Sim_Reg< SIM_REG_BMC_TX_SZ, uint16_t >    BMC_TX_SZ;
+    Sim_Reg< SIM_REG_DATA_BUF, uint8_t >      DATA_BUF;
+    Sim_Reg< SIM_REG_STATUS, uint8_t >        STATUS;
+    Sim_Reg< SIM_REG_BMC_BYTE_CNT, uint16_t > BMC_BYTE_CNT;
+    Sim_Reg< SIM_REG_PORT_CC1, uint16_t >     PORT_CC1;
+    Sim_Reg< SIM_REG_PORT_CC2, uint16_t >     PORT_CC2;
+    Sim_Reg< SIM_REG_DMA, unsigned long >     DMA;
+};
+
+/* GPIO_Init( GPIOC, ... ) still takes it, INDR reads the CC pins */
+struct SIM_GPIO : GPIO_TypeDef
+{
+    Sim_Reg< SIM_REG_GPIOC_INDR, uint32_t >   INDR;
+};
+
+SIM_USBPD      Sim_Usbpd;
+SIM_GPIO       Sim_Gpioc;
+AFIO_TypeDef   Sim_Afio;
+}
+
+#undef USBPD
+#define USBPD               ( &Sim_Usbpd )
+#undef GPIOC
+#define GPIOC               ( &Sim_Gpioc )
+#undef AFIO
+#define AFIO                ( &Sim_Afio )
+
+#define NVIC_EnableIRQ( n ) Sim_Nvic_Cmd( ( n ), 1 )
+#define NVIC_DisableIRQ( n ) Sim_Nvic_Cmd( ( n ), 0 )
+#define printf              Sim_Printf
+
+#endif
+
+#endif
@@ -0,0 +1,48 @@
+/********************************** (C) COPYRIGHT  *******************************
+ * File Name          : pd_sim_port.cpp
+ * Author             : WCH
+ * Version            : V1.0.0
+ * Date               : 2026/10/19
+ * Description        : One PD example, USBPD_SRC or USBPD_SNK, built for the
+ *                      PC against the peripherals of pd_sim.h. The User
+ *                      directory of the example comes first in the include
+ *                      path, -DPD_SIM_SRC picks the source port.
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+#include "pd_sim.h"
+
+/* main.c, PD_Process.c and PD_VDM.c of the example as they are */
+#define main                PD_Sim_Main
+#include "main.c"
+#undef main
+#include "PD_Process.c"
+#include "PD_VDM.c"
+
+/*********************************************************************
+ * @fn      PD_Sim_Get_Stat
+ *
+ * @brief   Copy what pd_sim.c reports of this port.
+ *
+ * @return  none
+ */
+static void PD_Sim_Get_Stat( SIM_STAT *ps )
+{
+    ps->Contract_Time = PD_Stat.Contract_Time;
+    ps->Tx_Retry_Cnt = PD_Stat.Tx_Retry_Cnt;
+    ps->Tx_Fail_Cnt = PD_Stat.Tx_Fail_Cnt;
+    ps->GoodCRC_Drop_Cnt = PD_Stat.GoodCRC_Drop_Cnt;
+    ps->Soft_Reset_Cnt = PD_Stat.Soft_Reset_Cnt;
+    ps->Hard_Reset_Cnt = PD_Stat.Hard_Reset_Cnt;
+    ps->Rx_Hard_Reset_Cnt = PD_Stat.Rx_Hard_Reset_Cnt;
+    ps->Contract_Timing = PD_Stat.Contract_Timing;
+    ps->PD_State = PD_Ctl.PD_State;
+}
+
+#ifdef PD_SIM_SRC
+SIM_PORT Sim_Src_Port = { "SRC", PD_Sim_Main, USBPD_IRQHandler, TIM1_UP_IRQHandler, PD_Sim_Get_Stat };
+#else
+SIM_PORT Sim_Snk_Port = { "SNK", PD_Sim_Main, USBPD_IRQHandler, TIM1_UP_IRQHandler, PD_Sim_Get_Stat };
+#endif
@@ -13,6 +13,7 @@
 #include "debug.h"
 #include <string.h>
 #include "PD_Process.h"
+#include "PD_VDM.h"
 
 void USBPD_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
 
@@ -26,6 +27,7 @@ UINT8  Tmr_Ms_Cnt_Last;
 UINT8  Tmr_Ms_Dlt;                                                              /* System timer millisecond timing this interval value */
 
 PD_CONTROL PD_Ctl;                                                              /* PD Control Related Structures */
+PD_STATISTICS PD_Stat;                                                          /* PD negotiation statistics */
 
 UINT8  Adapter_SrcCap[ 30 ];                                                    /* SrcCap message from the adapter */
 
@@ -74,11 +76,23 @@ void USBPD_IRQHandler(void)
                 /* If GOODCRC, do not answer and ignore this reception */
                 if( ( USBPD->BMC_BYTE_CNT != 6 ) || ( ( PD_Rx_Buf[ 0 ] & 0x1F ) != DEF_TYPE_GOODCRC ) )
                 {
-                    Delay_Us(30);                       /* Delay 30us, answer GoodCRC */
-                    PD_Ack_Buf[ 0 ] = 0x41;
-                    PD_Ack_Buf[ 1 ] = ( PD_Rx_Buf[ 1 ] & 0x0E ) | PD_Ctl.Flag.Bit.Auto_Ack_PRRole;
-                    USBPD->CONFIG |= IE_TX_END ;
-                    PD_Phy_SendPack( 0, PD_Ack_Buf, 2, UPD_SOP0 );
+#if( PD_ERR_DROP_GOODCRC != 0 )
+                    static UINT8 drop_cnt = 0;
+                    if( ++drop_cnt >= PD_ERR_DROP_GOODCRC )
+                    {
+                        /* Do not answer, the partner has to retransmit this packet */
+                        drop_cnt = 0;
+                        PD_Stat.GoodCRC_Drop_Cnt++;
+                    }
+                    else
+#endif
+                    {
+                        Delay_Us(30);                       /* Delay 30us, answer GoodCRC */
+                        PD_Ack_Buf[ 0 ] = 0x41;
+                        PD_Ack_Buf[ 1 ] = ( PD_Rx_Buf[ 1 ] & 0x0E ) | PD_Ctl.Flag.Bit.Auto_Ack_PRRole;
+                        USBPD->CONFIG |= IE_TX_END ;
+                        PD_Phy_SendPack( 0, PD_Ack_Buf, 2, UPD_SOP0 );
+                    }
                 }
             }
         }
@@ -98,6 +112,7 @@ void USBPD_IRQHandler(void)
     if(USBPD->STATUS & IF_RX_RESET)
     {
         USBPD->STATUS |= IF_RX_RESET;
+        PD_Stat.Rx_Hard_Reset_Cnt++;
         PD_SINK_Init( );
         printf("IF_RX_RESET\r\n");
     }
@@ -315,6 +330,8 @@ void PD_Det_Proc( void )
                 }
 
                 PD_Ctl.PD_Comm_Timer = 0;
+                PD_Stat.Contract_Timer = 0;
+                PD_Stat.Contract_Timing = 1;
             }
         }
     }
@@ -453,6 +470,10 @@ UINT8 PD_Send_Handle( UINT8 *pbuf, UINT8 len )
     pd_tx_trycnt = 4;
     while( --pd_tx_trycnt )                                                     /* Maximum 3 executions */
     {
+        if( pd_tx_trycnt != 3 )
+        {
+            PD_Stat.Tx_Retry_Cnt++;
+        }
         NVIC_DisableIRQ( USBPD_IRQn );
         PD_Phy_SendPack( 0x01, PD_Tx_Buf, ( len + 2 ), UPD_SOP0 );
 
@@ -487,6 +508,7 @@ UINT8 PD_Send_Handle( UINT8 *pbuf, UINT8 len )
     else
     {
         /* Send failed */
+        PD_Stat.Tx_Fail_Cnt++;
         return( DEF_PD_TX_FAIL );
     }
 }
@@ -633,6 +655,12 @@ void PD_Main_Proc( )
     /* Receive idle timer count */
     PD_Ctl.PD_BusIdle_Timer += Tmr_Ms_Dlt;
 
+    /* Attach-to-contract timing */
+    if( PD_Stat.Contract_Timing )
+    {
+        PD_Stat.Contract_Timer += Tmr_Ms_Dlt;
+    }
+
     /* Status analysis processing */
     switch( PD_Ctl.PD_State )
     {
@@ -687,6 +715,7 @@ void PD_Main_Proc( )
         case STA_TX_SOFTRST:
             /* Status: send software reset */
             /* Send soft reset, if sent successfully, mode unchanged, count +1 for retry */
+            PD_Stat.Soft_Reset_Cnt++;
             PD_Load_Header( 0x00, DEF_TYPE_SOFT_RESET );
             status = PD_Send_Handle( NULL, 0 );
             if( status == DEF_PD_TX_OK )
@@ -705,6 +734,7 @@ void PD_Main_Proc( )
             /* Status: Sending a hardware reset */
             /* Sending a hard reset */
             PD_Ctl.Flag.Bit.Stop_Det_Chk = 1;
+            PD_Stat.Hard_Reset_Cnt++;
             PD_Phy_SendPack( 0x01, NULL, 0, UPD_HARD_RESET );                   /* send HRST */
             PD_Rx_Mode( );                                                      /* switch to rx mode */
             PD_Ctl.PD_State = STA_IDLE;
@@ -750,6 +780,10 @@ void PD_Main_Proc( )
             case DEF_TYPE_PS_RDY:
                 /* PS_RDY is received */
                 printf("Success\r\n");
+                PD_Stat.Contract_Time = PD_Stat.Contract_Timer;
+                PD_Stat.Contract_Timing = 0;
+                printf("Contract:%d ms, Retry:%d, SoftRst:%d, HardRst:%d\r\n", PD_Stat.Contract_Time,
+                        PD_Stat.Tx_Retry_Cnt, PD_Stat.Soft_Reset_Cnt, PD_Stat.Hard_Reset_Cnt );
                 PD_Ctl.PD_State = STA_RX_PS_RDY;
                 break;
 
@@ -789,26 +823,7 @@ void PD_Main_Proc( )
 
             case DEF_TYPE_VENDOR_DEFINED:
                 /* VDM message handling */
-                if( ( PD_Rx_Buf[ 2 ] & 0xC0 ) == 0 )
-                {
-                    /* REQ */
-                    Delay_Ms( 1 );
-
-                    /* Data to be sent is cached to PD_Tx_Buf */
-                    PD_Load_Header( 0x00, DEF_TYPE_VENDOR_DEFINED );
-
-                    /* Return to NAK */
-                    if( ( PD_Rx_Buf[ 3 ] & 0x60 ) == 0 )
-                    {
-                        PD_Ctl.Flag.Bit.VDM_Version = 0;
-                    }
-                    else
-                    {
-                        PD_Ctl.Flag.Bit.VDM_Version = 1;
-                    }
-                    PD_Rx_Buf[ 2 ] |= 0x80;
-                    PD_Send_Handle( &PD_Rx_Buf[ 2 ], 4 );
-                }
+                PD_VDM_Rx_Handle( );
                 break;
 
             default:
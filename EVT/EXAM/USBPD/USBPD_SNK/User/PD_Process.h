@@ -18,7 +18,26 @@
  extern "C" {
 #endif
 
+/* Error injection switch, used to exercise retry and reset paths against a partner board.
+ * Non-zero value N: every Nth received message is not answered with GoodCRC. */
+#ifndef PD_ERR_DROP_GOODCRC
+#define PD_ERR_DROP_GOODCRC 0
+#endif
 
+/******************************************************************************/
+/* PD negotiation statistics */
+typedef struct _PD_STATISTICS
+{
+    UINT16 Contract_Timer;                                                      /* Timing from attach to explicit contract */
+    UINT16 Contract_Time;                                                       /* Last attach-to-contract latency, in ms */
+    UINT16 Tx_Retry_Cnt;                                                        /* Retransmissions caused by missing GoodCRC */
+    UINT16 Tx_Fail_Cnt;                                                         /* Messages dropped after all retries */
+    UINT16 GoodCRC_Drop_Cnt;                                                    /* GoodCRC answers suppressed by error injection */
+    UINT8  Soft_Reset_Cnt;                                                      /* Soft resets sent */
+    UINT8  Hard_Reset_Cnt;                                                      /* Hard resets sent */
+    UINT8  Rx_Hard_Reset_Cnt;                                                   /* Hard resets received */
+    UINT8  Contract_Timing;                                                     /* 1-attach-to-contract timing in progress */
+}PD_STATISTICS;
 
 /******************************************************************************/
 /* Variable extents */
@@ -28,6 +47,7 @@ extern volatile UINT8  Tim_Ms_Cnt;
 
 extern UINT8  PDO_Len;
 extern PD_CONTROL PD_Ctl;
+extern PD_STATISTICS PD_Stat;
 
 extern UINT8 send_data[ ];
 extern UINT8 PD_Ack_Buf[ ];
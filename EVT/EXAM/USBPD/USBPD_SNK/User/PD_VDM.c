@@ -0,0 +1,140 @@
+/********************************** (C) COPYRIGHT *******************************
+* File Name          : PD_VDM.c
+* Author             : WCH
+* Version            : V1.0.0
+* Date               : 2026/10/19
+* Description        : This file provides the PD structured VDM functions,
+*                      answering Discover Identity/SVIDs/Modes as UFP.
+*********************************************************************************
+* Copyright (c) 2023 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "debug.h"
+#include <string.h>
+#include "PD_Process.h"
+#include "PD_VDM.h"
+
+/* Responder table entry */
+typedef struct _PD_VDM_RSP
+{
+    UINT8  Cmd;
+    UINT16 SVID;
+    const UINT8 *pVDO;
+    UINT8  Len;
+}PD_VDM_RSP;
+
+/******************************************************************************/
+/* Precomputed responder VDOs, the VDM header is echoed from the request */
+
+/* Discover Identity ACK
+   ID Header VDO: USB device, UFP peripheral, modal operation, Type-C receptacle, VID 0x1A86
+   Cert Stat VDO: no XID
+   Product VDO: PID 0x0643, bcdDevice 0x0100
+   UFP VDO: VDO version 1.3, USB2.0 device, USB2.0 signaling */
+const UINT8 VDM_Disc_Ident_Tab[ 16 ] =
+{
+    DEF_VDO( 0x54401A86 ),
+    DEF_VDO( 0x00000000 ),
+    DEF_VDO( 0x06430100 ),
+    DEF_VDO( 0x61000000 ),
+};
+
+/* Discover SVIDs ACK: SVID 0x1A86, list terminated with 0x0000 */
+const UINT8 VDM_Disc_SVID_Tab[ 4 ] =
+{
+    DEF_VDO( ( (UINT32)DEF_VDM_SVID_VENDOR << 16 ) ),
+};
+
+/* Discover Modes ACK for SVID 0x1A86: one vendor mode */
+const UINT8 VDM_Disc_Mode_Tab[ 4 ] =
+{
+    DEF_VDO( 0x00000001 ),
+};
+
+const PD_VDM_RSP VDM_Rsp_Tab[ ] =
+{
+    { DEF_VDM_DISC_IDENT, DEF_VDM_SVID_PD_SID, VDM_Disc_Ident_Tab, sizeof( VDM_Disc_Ident_Tab ) },
+    { DEF_VDM_DISC_SVID,  DEF_VDM_SVID_PD_SID, VDM_Disc_SVID_Tab,  sizeof( VDM_Disc_SVID_Tab )  },
+    { DEF_VDM_DISC_MODE,  DEF_VDM_SVID_VENDOR, VDM_Disc_Mode_Tab,  sizeof( VDM_Disc_Mode_Tab )  },
+    { DEF_VDM_ENTER_MODE, DEF_VDM_SVID_VENDOR, NULL,               0                            },
+    { DEF_VDM_EXIT_MODE,  DEF_VDM_SVID_VENDOR, NULL,               0                            },
+};
+
+/*********************************************************************
+ * @fn      PD_VDM_Rx_Handle
+ *
+ * @brief   This function uses to handle a received VDM in PD_Rx_Buf.
+ *          Requests are answered from the precomputed tables. As UFP
+ *          this port sends no requests, so responses are dropped.
+ *
+ * @return  none
+ */
+void PD_VDM_Rx_Handle( void )
+{
+    UINT8  i;
+    UINT8  cmd;
+    UINT16 svid;
+    const PD_VDM_RSP *rsp;
+
+    if( ( ( PD_Rx_Buf[ 1 ] >> 4 ) & 0x07 ) == 0 )
+    {
+        return;
+    }
+    cmd = PD_Rx_Buf[ 2 ] & DEF_VDM_CMD_MASK;
+    svid = PD_Rx_Buf[ 4 ] | ( (UINT16)PD_Rx_Buf[ 5 ] << 8 );
+
+    if( ( PD_Rx_Buf[ 3 ] & DEF_VDM_STRUCTURED ) == 0 )
+    {
+        /* Unstructured VDM is not supported */
+        if( PD_Ctl.Flag.Bit.PD_Version )
+        {
+            PD_Load_Header( 0x00, DEF_TYPE_NOT_SUPPORT );
+            PD_Send_Handle( NULL, 0 );
+        }
+        return;
+    }
+
+    if( ( ( PD_Rx_Buf[ 2 ] & DEF_VDM_CMD_TYPE_MASK ) != DEF_VDM_CMD_TYPE_REQ ) || ( cmd == DEF_VDM_ATTENTION ) )
+    {
+        return;
+    }
+    if( ( PD_Rx_Buf[ 3 ] & DEF_VDM_VER_MASK ) == 0 )
+    {
+        PD_Ctl.Flag.Bit.VDM_Version = 0;
+    }
+    else
+    {
+        PD_Ctl.Flag.Bit.VDM_Version = 1;
+    }
+
+    rsp = NULL;
+    for( i = 0; i < sizeof( VDM_Rsp_Tab ) / sizeof( VDM_Rsp_Tab[ 0 ] ); i++ )
+    {
+        if( ( VDM_Rsp_Tab[ i ].Cmd == cmd ) && ( VDM_Rsp_Tab[ i ].SVID == svid ) )
+        {
+            rsp = &VDM_Rsp_Tab[ i ];
+            break;
+        }
+    }
+
+    /* Echo the VDM header with the command type replaced */
+    PD_Load_Header( 0x00, DEF_TYPE_VENDOR_DEFINED );
+    memcpy( &PD_Tx_Buf[ 2 ], &PD_Rx_Buf[ 2 ], 4 );
+    PD_Tx_Buf[ 2 ] &= ~DEF_VDM_CMD_TYPE_MASK;
+    if( rsp )
+    {
+        PD_Tx_Buf[ 2 ] |= DEF_VDM_CMD_TYPE_ACK;
+        if( rsp->Len )
+        {
+            memcpy( &PD_Tx_Buf[ 6 ], rsp->pVDO, rsp->Len );
+        }
+        PD_Send_Handle( &PD_Tx_Buf[ 2 ], 4 + rsp->Len );
+    }
+    else
+    {
+        PD_Tx_Buf[ 2 ] |= DEF_VDM_CMD_TYPE_NAK;
+        PD_Send_Handle( &PD_Tx_Buf[ 2 ], 4 );
+    }
+}
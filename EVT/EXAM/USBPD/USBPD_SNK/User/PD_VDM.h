@@ -0,0 +1,56 @@
+/********************************** (C) COPYRIGHT *******************************
+* File Name          : PD_VDM.h
+* Author             : WCH
+* Version            : V1.0.0
+* Date               : 2026/10/19
+* Description        : This file contains all the functions prototypes for the
+*                      PD structured VDM responder (Discover Identity/SVIDs/Modes).
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef USER_PD_VDM_H_
+#define USER_PD_VDM_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/******************************************************************************/
+/* Structured VDM Header
+   BIT[31:16] - Standard or Vendor ID (SVID)
+   BIT15 - VDM Type, 1: Structured VDM
+   BIT[14:13] - Structured VDM Version (Major), 00: V1.0; 01: V2.x
+   BIT[12:11] - Structured VDM Version (Minor)
+   BIT[10:8] - Object Position
+   BIT[7:6] - Command Type, 00: REQ; 01: ACK; 10: NAK; 11: BUSY
+   BIT5 - Reserved
+   BIT[4:0] - Command
+*/
+#define DEF_VDM_SVID_PD_SID        0xFF00                                       /* PD Standard ID */
+#define DEF_VDM_SVID_VENDOR        0x1A86                                       /* SVID reported by this device */
+
+#define DEF_VDM_CMD_TYPE_MASK      0xC0
+#define DEF_VDM_CMD_TYPE_REQ       0x00
+#define DEF_VDM_CMD_TYPE_ACK       0x40
+#define DEF_VDM_CMD_TYPE_NAK       0x80
+#define DEF_VDM_CMD_TYPE_BUSY      0xC0
+#define DEF_VDM_CMD_MASK           0x1F
+
+#define DEF_VDM_STRUCTURED         0x80                                         /* VDM header byte 1 */
+#define DEF_VDM_VER_MASK           0x60                                         /* VDM header byte 1 */
+
+/* Build one little-endian VDO into a byte table */
+#define DEF_VDO( v )               (UINT8)( v ), (UINT8)( ( v ) >> 8 ), (UINT8)( ( v ) >> 16 ), (UINT8)( ( v ) >> 24 )
+
+/******************************************************************************/
+/* Function extensibility */
+extern void PD_VDM_Rx_Handle( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_PD_VDM_H_ */
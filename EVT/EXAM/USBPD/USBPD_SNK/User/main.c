@@ -27,6 +27,9 @@
  *
  * Modify "PDO_Request( PDO_INDEX_1 )" in pd process.c, line 753, to modify the request voltage.
  *
+ * Structured VDM requests (Discover Identity/SVIDs/Modes) are answered from the
+ * precomputed tables in PD_VDM.c.
+ *
  * According to the usage scenario of PD SNK, whether
  * it is removed or not should be determined by detecting
  * the Vbus voltage, this code only shows the detection
@@ -13,6 +13,7 @@
 #include "debug.h"
 #include <string.h>
 #include "PD_Process.h"
+#include "PD_VDM.h"
 
 void USBPD_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
 
@@ -21,10 +22,13 @@ __attribute__ ((aligned(4))) uint8_t PD_Tx_Buf[ 34 ];
 
 /******************************************************************************/
 UINT8 PD_Ack_Buf[ 2 ];                                                          /* PD-ACK buffer */
+UINT8 PD_Rx_Sop;                                                                /* SOP of the received packet */
+UINT8 PD_Msg_ID_Sop1;                                                           /* ID of the message sent to SOP' */
 
 UINT8  Tmr_Ms_Cnt_Last;                                                         /* System timer millisecond timing final value */
 UINT8  Tmr_Ms_Dlt;                                                              /* System timer millisecond timing this interval value */
 PD_CONTROL PD_Ctl;                                                              /* PD Control Related Structures */
+PD_STATISTICS PD_Stat;                                                          /* PD negotiation statistics */
 UINT8  Adapter_SrcCap[ 30 ];                                                    /* Contents of the SrcCap message for the adapter */
 
 UINT8  PDO_Len;
@@ -72,14 +76,42 @@ void USBPD_IRQHandler(void)
                 /* If GOODCRC, do not answer and ignore this reception */
                 if( ( USBPD->BMC_BYTE_CNT != 6 ) || ( ( PD_Rx_Buf[ 0 ] & 0x1F ) != DEF_TYPE_GOODCRC ) )
                 {
-                    Delay_Us(30);                       /* Delay 30us, answer GoodCRC */
-                    PD_Ack_Buf[ 0 ] = 0x61;
-                    PD_Ack_Buf[ 1 ] = ( PD_Rx_Buf[ 1 ] & 0x0E ) | PD_Ctl.Flag.Bit.Auto_Ack_PRRole;
-                    USBPD->CONFIG |= IE_TX_END ;
-                    PD_Phy_SendPack( 0, PD_Ack_Buf, 2, UPD_SOP0 );
+#if( PD_ERR_DROP_GOODCRC != 0 )
+                    static UINT8 drop_cnt = 0;
+                    if( ++drop_cnt >= PD_ERR_DROP_GOODCRC )
+                    {
+                        /* Do not answer, the partner has to retransmit this packet */
+                        drop_cnt = 0;
+                        PD_Stat.GoodCRC_Drop_Cnt++;
+                    }
+                    else
+#endif
+                    {
+                        Delay_Us(30);                       /* Delay 30us, answer GoodCRC */
+                        PD_Ack_Buf[ 0 ] = 0x61;
+                        PD_Ack_Buf[ 1 ] = ( PD_Rx_Buf[ 1 ] & 0x0E ) | PD_Ctl.Flag.Bit.Auto_Ack_PRRole;
+                        PD_Rx_Sop = UPD_SOP0;
+                        USBPD->CONFIG |= IE_TX_END ;
+                        PD_Phy_SendPack( 0, PD_Ack_Buf, 2, UPD_SOP0 );
+                    }
                 }
             }
         }
+        else if( ( USBPD->STATUS & MASK_PD_STAT ) == PD_RX_SOP1_HRST )
+        {
+            /* SOP' packet from the cable plug, answer GoodCRC on SOP'. One sent by
+             * the port partner to the cable (Cable Plug bit 0) is not for us */
+            if( ( PD_Rx_Buf[ 1 ] & 0x01 ) &&
+                ( ( USBPD->BMC_BYTE_CNT > 6 ) || ( ( USBPD->BMC_BYTE_CNT == 6 ) && ( ( PD_Rx_Buf[ 0 ] & 0x1F ) != DEF_TYPE_GOODCRC ) ) ) )
+            {
+                Delay_Us(30);
+                PD_Ack_Buf[ 0 ] = 0x41;
+                PD_Ack_Buf[ 1 ] = PD_Rx_Buf[ 1 ] & 0x0E;                        /* Cable Plug bit 0: sent by a port */
+                PD_Rx_Sop = UPD_SOP1;
+                USBPD->CONFIG |= IE_TX_END ;
+                PD_Phy_SendPack( 0, PD_Ack_Buf, 2, UPD_SOP1 );
+            }
+        }
     }
     if(USBPD->STATUS & IF_TX_END)
     {
@@ -95,6 +127,7 @@ void USBPD_IRQHandler(void)
     if(USBPD->STATUS & IF_RX_RESET)
     {
         USBPD->STATUS |= IF_RX_RESET;
+        PD_Stat.Rx_Hard_Reset_Cnt++;
         PD_SINK_Init( );
         printf("IF_RX_RESET\r\n");
     }
@@ -160,6 +193,7 @@ void PD_PHY_Reset( void )
 {
     PD_Ctl.Flag.Bit.Msg_Recvd = 0;
     PD_Ctl.Msg_ID = 0;
+    PD_Msg_ID_Sop1 = 0;
     PD_Ctl.Flag.Bit.PD_Version = 1;
     PD_Ctl.Det_Cnt = 0;
     PD_Ctl.Flag.Bit.Connected = 0;
@@ -171,6 +205,7 @@ void PD_PHY_Reset( void )
     PD_Ctl.PD_State = STA_IDLE;
     PD_Ctl.Flag.Bit.PD_Comm_Succ = 0;
     PD_SRC_Init( );
+    PD_VDM_Init( );
     PD_Rx_Mode( );
 }
 
@@ -424,6 +459,8 @@ void PD_Det_Proc( void )
                 }
 
                 PD_Ctl.PD_Comm_Timer = 0;
+                PD_Stat.Contract_Timer = 0;
+                PD_Stat.Contract_Timing = 1;
             }
         }
     }
@@ -537,6 +574,18 @@ void PD_Load_Header( UINT8 ex, UINT8 msg_type )
  * @return  0:success; 1:fail
  */
 UINT8 PD_Send_Handle( UINT8 *pbuf, UINT8 len )
+{
+    return PD_Send_Handle_Sop( pbuf, len, UPD_SOP0 );
+}
+
+/*********************************************************************
+ * @fn      PD_Send_Handle_Sop
+ *
+ * @brief   This function uses to handle sending transactions to SOP or SOP'.
+ *
+ * @return  0:success; 1:fail
+ */
+UINT8 PD_Send_Handle_Sop( UINT8 *pbuf, UINT8 len, UINT8 sop )
 {
     UINT8  pd_tx_trycnt;
     UINT8  cnt;
@@ -562,8 +611,12 @@ UINT8 PD_Send_Handle( UINT8 *pbuf, UINT8 len )
     pd_tx_trycnt = 4;
     while( --pd_tx_trycnt )                                                     /* Maximum 3 executions */
     {
+        if( pd_tx_trycnt != 3 )
+        {
+            PD_Stat.Tx_Retry_Cnt++;
+        }
         NVIC_DisableIRQ( USBPD_IRQn );
-        PD_Phy_SendPack( 0x01, PD_Tx_Buf, ( len + 2 ), UPD_SOP0 );
+        PD_Phy_SendPack( 0x01, PD_Tx_Buf, ( len + 2 ), sop );
 
         /* Set receive timeout 750US */
         cnt = 250;
@@ -574,7 +627,14 @@ UINT8 PD_Send_Handle( UINT8 *pbuf, UINT8 len )
                 USBPD->STATUS |= IF_RX_ACT;
                 if( ( USBPD->BMC_BYTE_CNT == 6 ) && ( ( PD_Rx_Buf[ 0 ] & 0x1F ) == DEF_TYPE_GOODCRC ) )
                 {
-                    PD_Ctl.Msg_ID += 2;
+                    if( sop == UPD_SOP0 )
+                    {
+                        PD_Ctl.Msg_ID += 2;
+                    }
+                    else
+                    {
+                        PD_Msg_ID_Sop1 += 2;
+                    }
                     break;
                 }
             }
@@ -596,6 +656,7 @@ UINT8 PD_Send_Handle( UINT8 *pbuf, UINT8 len )
     else
     {
         /* Send failed */
+        PD_Stat.Tx_Fail_Cnt++;
         return( DEF_PD_TX_FAIL );
     }
 }
@@ -638,6 +699,12 @@ void PD_Main_Proc( )
     /* Receive idle timer count */
     PD_Ctl.PD_BusIdle_Timer += Tmr_Ms_Dlt;
 
+    /* Attach-to-contract timing */
+    if( PD_Stat.Contract_Timing )
+    {
+        PD_Stat.Contract_Timer += Tmr_Ms_Dlt;
+    }
+
     /* Status analysis processing */
     switch( PD_Ctl.PD_State )
     {
@@ -721,6 +788,11 @@ void PD_Main_Proc( )
                 if( status == DEF_PD_TX_OK )
                 {
                     printf("PS ready\r\n");
+                    PD_VDM_Discovery_Start( 1 );                            /* Query cable (SOP') and partner (SOP) */
+                    PD_Stat.Contract_Time = PD_Stat.Contract_Timer;
+                    PD_Stat.Contract_Timing = 0;
+                    printf("Contract:%d ms, Retry:%d, SoftRst:%d, HardRst:%d\r\n", PD_Stat.Contract_Time,
+                            PD_Stat.Tx_Retry_Cnt, PD_Stat.Soft_Reset_Cnt, PD_Stat.Hard_Reset_Cnt );
                     PD_Ctl.PD_State = STA_IDLE;
                     PD_Ctl.PD_Comm_Timer = 0;
                 }
@@ -734,6 +806,7 @@ void PD_Main_Proc( )
 
         case STA_TX_SOFTRST:
             /* Send soft reset, if sent successfully, mode unchanged, count +1 for retry */
+            PD_Stat.Soft_Reset_Cnt++;
             PD_Load_Header( 0x00, DEF_TYPE_SOFT_RESET );
             status = PD_Send_Handle( NULL, 0 );
             if( status == DEF_PD_TX_OK )
@@ -751,6 +824,7 @@ void PD_Main_Proc( )
         case STA_TX_HRST:
             /* Sending a hard reset */
             PD_Ctl.Flag.Bit.Stop_Det_Chk = 1;
+            PD_Stat.Hard_Reset_Cnt++;
             PD_Phy_SendPack( 0x01, NULL, 0, UPD_HARD_RESET );                   /* send HRST */
             PD_Rx_Mode( );                                                      /* switch to rx mode */
             PD_Ctl.PD_State = STA_IDLE;
@@ -761,6 +835,12 @@ void PD_Main_Proc( )
             break;
     }
 
+    /* VDM discovery processing */
+    if( PD_Ctl.PD_State == STA_IDLE )
+    {
+        PD_VDM_Proc( );
+    }
+
     /* Receive message processing */
     if( PD_Ctl.Flag.Bit.Msg_Recvd )
     {
@@ -816,6 +896,11 @@ void PD_Main_Proc( )
                 PD_Send_Handle( NULL, 0 );
                 break;
 
+            case DEF_TYPE_VENDOR_DEFINED:
+                /* VDM message handling */
+                PD_VDM_Rx_Handle( PD_Rx_Sop );
+                break;
+
             default:
                 printf("Unsupported Command\r\n");
                 break;
@@ -22,6 +22,27 @@
 #define LowpowerOff 0
 #define Lowpower LowpowerON
 
+/* Error injection switch, used to exercise retry and reset paths against a partner board.
+ * Non-zero value N: every Nth received message is not answered with GoodCRC. */
+#ifndef PD_ERR_DROP_GOODCRC
+#define PD_ERR_DROP_GOODCRC 0
+#endif
+
+/******************************************************************************/
+/* PD negotiation statistics */
+typedef struct _PD_STATISTICS
+{
+    UINT16 Contract_Timer;                                                      /* Timing from attach to explicit contract */
+    UINT16 Contract_Time;                                                       /* Last attach-to-contract latency, in ms */
+    UINT16 Tx_Retry_Cnt;                                                        /* Retransmissions caused by missing GoodCRC */
+    UINT16 Tx_Fail_Cnt;                                                         /* Messages dropped after all retries */
+    UINT16 GoodCRC_Drop_Cnt;                                                    /* GoodCRC answers suppressed by error injection */
+    UINT8  Soft_Reset_Cnt;                                                      /* Soft resets sent */
+    UINT8  Hard_Reset_Cnt;                                                      /* Hard resets sent */
+    UINT8  Rx_Hard_Reset_Cnt;                                                   /* Hard resets received */
+    UINT8  Contract_Timing;                                                     /* 1-attach-to-contract timing in progress */
+}PD_STATISTICS;
+
 /******************************************************************************/
 /* Variable extents */
 extern UINT8  Tmr_Ms_Cnt_Last;
@@ -30,9 +51,12 @@ extern volatile UINT8  Tim_Ms_Cnt;
 
 extern UINT8  PDO_Len;
 extern PD_CONTROL PD_Ctl;
+extern PD_STATISTICS PD_Stat;
 
 extern UINT8 send_data[ ];
 extern UINT8 PD_Ack_Buf[ ];
+extern UINT8 PD_Rx_Sop;
+extern UINT8 PD_Msg_ID_Sop1;
 
 extern __attribute__ ((aligned(4))) UINT8 PD_Rx_Buf[ 34 ];
 extern __attribute__ ((aligned(4))) UINT8 PD_Tx_Buf[ 34 ];
@@ -49,6 +73,7 @@ extern UINT8 PD_Detect( void );
 extern void PD_Det_Proc( void );
 extern void PD_Load_Header( UINT8 ex, UINT8 msg_type );
 extern UINT8 PD_Send_Handle( UINT8 *pbuf, UINT8 len );
+extern UINT8 PD_Send_Handle_Sop( UINT8 *pbuf, UINT8 len, UINT8 sop );
 extern void PD_Phy_SendPack( UINT8 mode, UINT8 *pbuf, UINT8 len, UINT8 sop );
 extern void PD_Main_Proc( void );
 extern void PD_Request_Analyse( UINT8 pdo_idx, UINT8 *srccap, UINT16 *current );
@@ -0,0 +1,506 @@
+/********************************** (C) COPYRIGHT *******************************
+* File Name          : PD_VDM.c
+* Author             : WCH
+* Version            : V1.0.0
+* Date               : 2026/10/19
+* Description        : This file provides the PD structured VDM functions,
+*                      Discover Identity/SVIDs/Modes as initiator and responder.
+*********************************************************************************
+* Copyright (c) 2023 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#include "debug.h"
+#include <string.h>
+#include "PD_Process.h"
+#include "PD_VDM.h"
+
+/******************************************************************************/
+/* VDM initiator state machine */
+#define VDM_STA_IDLE               0x00
+#define VDM_STA_CABLE_IDENT        0x01                                         /* Send Discover Identity to SOP' */
+#define VDM_STA_PORT_IDENT         0x02                                         /* Send Discover Identity to SOP */
+#define VDM_STA_PORT_SVID          0x03                                         /* Send Discover SVIDs to SOP */
+#define VDM_STA_PORT_MODE          0x04                                         /* Send Discover Modes to SOP */
+#define VDM_STA_RSP_WAIT           0x05                                         /* Waiting for the response */
+#define VDM_STA_BUSY_WAIT          0x06                                         /* Waiting tVDMBusy to repeat the request */
+#define VDM_STA_DONE               0x07
+
+typedef struct _PD_VDM_CONTROL
+{
+    UINT8  State;                                                               /* Initiator state */
+    UINT8  Req_State;                                                           /* State that issued the pending request */
+    UINT8  Sop;                                                                 /* SOP of the pending request */
+    UINT8  Cmd;                                                                 /* Command of the pending request */
+    UINT8  Rsp;                                                                 /* Command type of the response, 0xFF: none */
+    UINT8  Retry;                                                               /* Retries of the pending request */
+    UINT8  SVID_Idx;                                                            /* SVID index for Discover Modes */
+    UINT8  SVID_More;                                                           /* 1-Discover SVIDs has to be sent again */
+    UINT16 Timer;                                                               /* Response or BUSY timer */
+}PD_VDM_CONTROL;
+
+/* Responder table entry */
+typedef struct _PD_VDM_RSP
+{
+    UINT8  Cmd;
+    UINT16 SVID;
+    const UINT8 *pVDO;
+    UINT8  Len;
+}PD_VDM_RSP;
+
+PD_VDM_PARTNER PD_VDM_Port;                                                     /* Port partner discovery results */
+PD_VDM_PARTNER PD_VDM_Cable;                                                    /* Cable plug discovery results */
+PD_VDM_CONTROL PD_VDM_Ctl;
+
+/******************************************************************************/
+/* Precomputed responder VDOs, the VDM header is echoed from the request */
+
+/* Discover Identity ACK
+   ID Header VDO: USB host, DFP PDUSB host, Type-C receptacle, VID 0x1A86
+   Cert Stat VDO: no XID
+   Product VDO: PID 0x0643, bcdDevice 0x0100
+   DFP VDO: VDO version 1.1, USB2.0 host, Type-C receptacle, port 0 */
+const UINT8 VDM_Disc_Ident_Tab[ 16 ] =
+{
+    DEF_VDO( 0x81401A86 ),
+    DEF_VDO( 0x00000000 ),
+    DEF_VDO( 0x06430100 ),
+    DEF_VDO( 0x41800000 ),
+};
+
+/* No modal operation, Discover SVIDs/Modes are answered with NAK */
+const PD_VDM_RSP VDM_Rsp_Tab[ ] =
+{
+    { DEF_VDM_DISC_IDENT, DEF_VDM_SVID_PD_SID, VDM_Disc_Ident_Tab, sizeof( VDM_Disc_Ident_Tab ) },
+};
+
+/*********************************************************************
+ * @fn      PD_VDM_Get_VDO
+ *
+ * @brief   This function uses to read a little-endian VDO.
+ *
+ * @return  VDO value
+ */
+static UINT32 PD_VDM_Get_VDO( UINT8 *pbuf )
+{
+    return ( (UINT32)pbuf[ 0 ] ) | ( (UINT32)pbuf[ 1 ] << 8 ) |
+           ( (UINT32)pbuf[ 2 ] << 16 ) | ( (UINT32)pbuf[ 3 ] << 24 );
+}
+
+/*********************************************************************
+ * @fn      PD_VDM_Init
+ *
+ * @brief   This function uses to clear the VDM discovery results.
+ *
+ * @return  none
+ */
+void PD_VDM_Init( void )
+{
+    memset( &PD_VDM_Port, 0x00, sizeof( PD_VDM_PARTNER ) );
+    memset( &PD_VDM_Cable, 0x00, sizeof( PD_VDM_PARTNER ) );
+    memset( &PD_VDM_Ctl, 0x00, sizeof( PD_VDM_CONTROL ) );
+    PD_VDM_Ctl.Rsp = 0xFF;
+}
+
+/*********************************************************************
+ * @fn      PD_VDM_Discovery_Start
+ *
+ * @brief   This function uses to start Discover Identity/SVIDs/Modes.
+ *
+ * @param   cable - 1: query the cable plug (SOP') first
+ *
+ * @return  none
+ */
+void PD_VDM_Discovery_Start( UINT8 cable )
+{
+    PD_VDM_Init( );
+    PD_VDM_Ctl.State = cable ? VDM_STA_CABLE_IDENT : VDM_STA_PORT_IDENT;
+}
+
+/*********************************************************************
+ * @fn      PD_VDM_Request
+ *
+ * @brief   This function uses to send a structured VDM request.
+ *
+ * @param   sop - UPD_SOP0 or UPD_SOP1
+ *          cmd - DEF_VDM_xx
+ *          svid - SVID of the request
+ *
+ * @return  DEF_PD_TX_OK or DEF_PD_TX_FAIL
+ */
+UINT8 PD_VDM_Request( UINT8 sop, UINT8 cmd, UINT16 svid )
+{
+    if( sop == UPD_SOP0 )
+    {
+        PD_Load_Header( 0x00, DEF_TYPE_VENDOR_DEFINED );
+    }
+    else
+    {
+        /* SOP' header: no data role, Cable Plug bit 0 (from a port) */
+        PD_Tx_Buf[ 0 ] = DEF_TYPE_VENDOR_DEFINED | ( PD_Ctl.Flag.Bit.PD_Version ? 0x80 : 0x40 );
+        PD_Tx_Buf[ 1 ] = PD_Msg_ID_Sop1 & 0x0E;
+    }
+
+    PD_Tx_Buf[ 2 ] = DEF_VDM_CMD_TYPE_REQ | ( cmd & DEF_VDM_CMD_MASK );
+    PD_Tx_Buf[ 3 ] = DEF_VDM_STRUCTURED;
+    if( PD_Ctl.Flag.Bit.PD_Version )
+    {
+        PD_Tx_Buf[ 3 ] |= DEF_VDM_VER_20;
+    }
+    PD_Tx_Buf[ 4 ] = (UINT8)svid;
+    PD_Tx_Buf[ 5 ] = (UINT8)( svid >> 8 );
+
+    PD_VDM_Ctl.Sop = sop;
+    PD_VDM_Ctl.Cmd = cmd;
+    PD_VDM_Ctl.Rsp = 0xFF;
+    PD_VDM_Ctl.Timer = 0;
+    return PD_Send_Handle_Sop( &PD_Tx_Buf[ 2 ], 4, sop );
+}
+
+/*********************************************************************
+ * @fn      PD_VDM_Save_Rsp
+ *
+ * @brief   This function uses to save the ACK of a discovery request.
+ *
+ * @return  none
+ */
+static void PD_VDM_Save_Rsp( PD_VDM_PARTNER *p, UINT8 cmd, UINT8 num )
+{
+    UINT8  i;
+    UINT16 svid;
+    UINT32 vdo;
+
+    switch( cmd )
+    {
+        case DEF_VDM_DISC_IDENT:
+            if( num >= 1 ) p->ID_Header = PD_VDM_Get_VDO( &PD_Rx_Buf[ 6 ] );
+            if( num >= 2 ) p->Cert_Stat = PD_VDM_Get_VDO( &PD_Rx_Buf[ 10 ] );
+            if( num >= 3 ) p->Product   = PD_VDM_Get_VDO( &PD_Rx_Buf[ 14 ] );
+            for( i = 3; ( i < num ) && ( i < 6 ); i++ )
+            {
+                p->Product_Type[ i - 3 ] = PD_VDM_Get_VDO( &PD_Rx_Buf[ 6 + ( i << 2 ) ] );
+            }
+            p->Product_Type_Num = ( num > 3 ) ? ( i - 3 ) : 0;
+            p->Status |= DEF_VDM_DISC_IDENT_OK;
+            break;
+
+        case DEF_VDM_DISC_SVID:
+            PD_VDM_Ctl.SVID_More = 0;
+            for( i = 0; i < ( num << 1 ); i++ )
+            {
+                vdo = PD_VDM_Get_VDO( &PD_Rx_Buf[ 6 + ( ( i >> 1 ) << 2 ) ] );
+                svid = ( i & 0x01 ) ? (UINT16)vdo : (UINT16)( vdo >> 16 );
+                if( svid == 0 )
+                {
+                    break;
+                }
+                if( p->SVID_Num >= DEF_VDM_SVID_MAX )
+                {
+                    break;
+                }
+                p->SVID[ p->SVID_Num++ ] = svid;
+            }
+            /* A full message without terminator means more SVIDs are pending */
+            if( ( num == 6 ) && ( i == 12 ) && ( p->SVID_Num < DEF_VDM_SVID_MAX ) )
+            {
+                PD_VDM_Ctl.SVID_More = 1;
+            }
+            p->Status |= DEF_VDM_DISC_SVID_OK;
+            break;
+
+        case DEF_VDM_DISC_MODE:
+            i = PD_VDM_Ctl.SVID_Idx;
+            if( i < p->SVID_Num )
+            {
+                if( num > DEF_VDM_MODE_MAX )
+                {
+                    num = DEF_VDM_MODE_MAX;
+                }
+                p->Mode_Num[ i ] = num;
+                memcpy( p->Mode[ i ], &PD_Rx_Buf[ 6 ], num << 2 );
+                p->Status |= DEF_VDM_DISC_MODE_OK;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      PD_VDM_Rx_Handle
+ *
+ * @brief   This function uses to handle a received VDM in PD_Rx_Buf.
+ *          Requests are answered from the precomputed tables, responses
+ *          to our own requests are saved.
+ *
+ * @param   sop - SOP of the received message
+ *
+ * @return  none
+ */
+void PD_VDM_Rx_Handle( UINT8 sop )
+{
+    UINT8  i;
+    UINT8  num;
+    UINT8  cmd;
+    UINT16 svid;
+    const PD_VDM_RSP *rsp;
+
+    num = ( PD_Rx_Buf[ 1 ] >> 4 ) & 0x07;
+    if( num == 0 )
+    {
+        return;
+    }
+    cmd = PD_Rx_Buf[ 2 ] & DEF_VDM_CMD_MASK;
+    svid = PD_Rx_Buf[ 4 ] | ( (UINT16)PD_Rx_Buf[ 5 ] << 8 );
+
+    if( ( PD_Rx_Buf[ 3 ] & DEF_VDM_STRUCTURED ) == 0 )
+    {
+        /* Unstructured VDM is not supported */
+        if( ( sop == UPD_SOP0 ) && PD_Ctl.Flag.Bit.PD_Version )
+        {
+            PD_Load_Header( 0x00, DEF_TYPE_NOT_SUPPORT );
+            PD_Send_Handle( NULL, 0 );
+        }
+        return;
+    }
+
+    if( ( PD_Rx_Buf[ 2 ] & DEF_VDM_CMD_TYPE_MASK ) == DEF_VDM_CMD_TYPE_REQ )
+    {
+        /* This device is not a cable plug, only answer SOP requests */
+        if( ( sop != UPD_SOP0 ) || ( cmd == DEF_VDM_ATTENTION ) )
+        {
+            return;
+        }
+        if( ( PD_Rx_Buf[ 3 ] & DEF_VDM_VER_MASK ) == 0 )
+        {
+            PD_Ctl.Flag.Bit.VDM_Version = 0;
+        }
+        else
+        {
+            PD_Ctl.Flag.Bit.VDM_Version = 1;
+        }
+
+        rsp = NULL;
+        for( i = 0; i < sizeof( VDM_Rsp_Tab ) / sizeof( VDM_Rsp_Tab[ 0 ] ); i++ )
+        {
+            if( ( VDM_Rsp_Tab[ i ].Cmd == cmd ) && ( VDM_Rsp_Tab[ i ].SVID == svid ) )
+            {
+                rsp = &VDM_Rsp_Tab[ i ];
+                break;
+            }
+        }
+
+        /* Echo the VDM header with the command type replaced */
+        PD_Load_Header( 0x00, DEF_TYPE_VENDOR_DEFINED );
+        memcpy( &PD_Tx_Buf[ 2 ], &PD_Rx_Buf[ 2 ], 4 );
+        PD_Tx_Buf[ 2 ] &= ~DEF_VDM_CMD_TYPE_MASK;
+        if( rsp )
+        {
+            PD_Tx_Buf[ 2 ] |= DEF_VDM_CMD_TYPE_ACK;
+            if( rsp->Len )
+            {
+                memcpy( &PD_Tx_Buf[ 6 ], rsp->pVDO, rsp->Len );
+            }
+            PD_Send_Handle( &PD_Tx_Buf[ 2 ], 4 + rsp->Len );
+        }
+        else
+        {
+            PD_Tx_Buf[ 2 ] |= DEF_VDM_CMD_TYPE_NAK;
+            PD_Send_Handle( &PD_Tx_Buf[ 2 ], 4 );
+        }
+    }
+    else
+    {
+        /* Response to a pending request */
+        if( ( PD_VDM_Ctl.State != VDM_STA_RSP_WAIT ) || ( sop != PD_VDM_Ctl.Sop ) || ( cmd != PD_VDM_Ctl.Cmd ) )
+        {
+            return;
+        }
+        PD_VDM_Ctl.Rsp = PD_Rx_Buf[ 2 ] & DEF_VDM_CMD_TYPE_MASK;
+        if( PD_VDM_Ctl.Rsp == DEF_VDM_CMD_TYPE_ACK )
+        {
+            PD_VDM_Save_Rsp( ( sop == UPD_SOP0 ) ? &PD_VDM_Port : &PD_VDM_Cable, cmd, num - 1 );
+        }
+        else if( PD_VDM_Ctl.Rsp == DEF_VDM_CMD_TYPE_NAK )
+        {
+            ( ( sop == UPD_SOP0 ) ? &PD_VDM_Port : &PD_VDM_Cable )->Status |= DEF_VDM_DISC_NAK;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      PD_VDM_Next_State
+ *
+ * @brief   This function uses to select the next discovery step after
+ *          the pending request finished.
+ *
+ * @param   ack - 1: the request was ACKed
+ *
+ * @return  none
+ */
+static void PD_VDM_Next_State( UINT8 ack )
+{
+    switch( PD_VDM_Ctl.Req_State )
+    {
+        case VDM_STA_CABLE_IDENT:
+            PD_VDM_Ctl.State = VDM_STA_PORT_IDENT;
+            break;
+
+        case VDM_STA_PORT_IDENT:
+            /* Discover SVIDs only if the partner supports modal operation */
+            if( ack && ( PD_VDM_Port.ID_Header & 0x04000000 ) )
+            {
+                PD_VDM_Ctl.State = VDM_STA_PORT_SVID;
+            }
+            else
+            {
+                PD_VDM_Ctl.State = VDM_STA_DONE;
+            }
+            break;
+
+        case VDM_STA_PORT_SVID:
+            if( ack && PD_VDM_Ctl.SVID_More )
+            {
+                PD_VDM_Ctl.State = VDM_STA_PORT_SVID;
+            }
+            else if( PD_VDM_Port.SVID_Num )
+            {
+                PD_VDM_Ctl.SVID_Idx = 0;
+                PD_VDM_Ctl.State = VDM_STA_PORT_MODE;
+            }
+            else
+            {
+                PD_VDM_Ctl.State = VDM_STA_DONE;
+            }
+            break;
+
+        case VDM_STA_PORT_MODE:
+            PD_VDM_Ctl.SVID_Idx++;
+            if( PD_VDM_Ctl.SVID_Idx < PD_VDM_Port.SVID_Num )
+            {
+                PD_VDM_Ctl.State = VDM_STA_PORT_MODE;
+            }
+            else
+            {
+                PD_VDM_Ctl.State = VDM_STA_DONE;
+            }
+            break;
+
+        default:
+            PD_VDM_Ctl.State = VDM_STA_DONE;
+            break;
+    }
+    PD_VDM_Ctl.Retry = 0;
+}
+
+/*********************************************************************
+ * @fn      PD_VDM_Proc
+ *
+ * @brief   This function uses to run the VDM discovery initiator,
+ *          called from the main loop.
+ *
+ * @return  none
+ */
+void PD_VDM_Proc( void )
+{
+    UINT8  status;
+
+    switch( PD_VDM_Ctl.State )
+    {
+        case VDM_STA_CABLE_IDENT:
+            PD_VDM_Ctl.Req_State = PD_VDM_Ctl.State;
+            status = PD_VDM_Request( UPD_SOP1, DEF_VDM_DISC_IDENT, DEF_VDM_SVID_PD_SID );
+            if( status == DEF_PD_TX_OK )
+            {
+                PD_VDM_Ctl.State = VDM_STA_RSP_WAIT;
+            }
+            else
+            {
+                /* No GoodCRC from SOP': no electronically marked cable */
+                PD_VDM_Cable.Status |= DEF_VDM_DISC_NO_RESP;
+                PD_VDM_Next_State( 0 );
+            }
+            break;
+
+        case VDM_STA_PORT_IDENT:
+        case VDM_STA_PORT_SVID:
+        case VDM_STA_PORT_MODE:
+            PD_VDM_Ctl.Req_State = PD_VDM_Ctl.State;
+            if( PD_VDM_Ctl.State == VDM_STA_PORT_IDENT )
+            {
+                status = PD_VDM_Request( UPD_SOP0, DEF_VDM_DISC_IDENT, DEF_VDM_SVID_PD_SID );
+            }
+            else if( PD_VDM_Ctl.State == VDM_STA_PORT_SVID )
+            {
+                status = PD_VDM_Request( UPD_SOP0, DEF_VDM_DISC_SVID, DEF_VDM_SVID_PD_SID );
+            }
+            else
+            {
+                status = PD_VDM_Request( UPD_SOP0, DEF_VDM_DISC_MODE, PD_VDM_Port.SVID[ PD_VDM_Ctl.SVID_Idx ] );
+            }
+            if( status == DEF_PD_TX_OK )
+            {
+                PD_VDM_Ctl.State = VDM_STA_RSP_WAIT;
+            }
+            else
+            {
+                PD_VDM_Port.Status |= DEF_VDM_DISC_NO_RESP;
+                PD_VDM_Ctl.State = VDM_STA_DONE;
+            }
+            break;
+
+        case VDM_STA_RSP_WAIT:
+            PD_VDM_Ctl.Timer += Tmr_Ms_Dlt;
+            if( PD_VDM_Ctl.Rsp == DEF_VDM_CMD_TYPE_ACK )
+            {
+                PD_VDM_Next_State( 1 );
+            }
+            else if( PD_VDM_Ctl.Rsp == DEF_VDM_CMD_TYPE_NAK )
+            {
+                PD_VDM_Next_State( 0 );
+            }
+            else if( ( PD_VDM_Ctl.Rsp == DEF_VDM_CMD_TYPE_BUSY ) || ( PD_VDM_Ctl.Timer > DEF_VDM_SENDER_RESP_TMR ) )
+            {
+                /* tVDMSenderResponse expired: repeat the request at once,
+                   BUSY: repeat it after tVDMBusy */
+                if( PD_VDM_Ctl.Retry < DEF_VDM_RETRY_MAX )
+                {
+                    PD_VDM_Ctl.Retry++;
+                    if( PD_VDM_Ctl.Rsp == DEF_VDM_CMD_TYPE_BUSY )
+                    {
+                        PD_VDM_Ctl.Timer = 0;
+                        PD_VDM_Ctl.State = VDM_STA_BUSY_WAIT;
+                    }
+                    else
+                    {
+                        PD_VDM_Ctl.State = PD_VDM_Ctl.Req_State;
+                    }
+                }
+                else
+                {
+                    ( ( PD_VDM_Ctl.Sop == UPD_SOP0 ) ? &PD_VDM_Port : &PD_VDM_Cable )->Status |= DEF_VDM_DISC_NO_RESP;
+                    PD_VDM_Next_State( 0 );
+                }
+            }
+            break;
+
+        case VDM_STA_BUSY_WAIT:
+            PD_VDM_Ctl.Timer += Tmr_Ms_Dlt;
+            if( PD_VDM_Ctl.Timer >= DEF_VDM_BUSY_TMR )
+            {
+                PD_VDM_Ctl.State = PD_VDM_Ctl.Req_State;
+            }
+            break;
+
+        case VDM_STA_DONE:
+            printf("VDM Discovery: Port ID:%08x SVIDs:%d, Cable ID:%08x\r\n",
+                   (unsigned)PD_VDM_Port.ID_Header, PD_VDM_Port.SVID_Num, (unsigned)PD_VDM_Cable.ID_Header );
+            PD_VDM_Ctl.State = VDM_STA_IDLE;
+            break;
+
+        default:
+            break;
+    }
+}
@@ -0,0 +1,100 @@
+/********************************** (C) COPYRIGHT *******************************
+* File Name          : PD_VDM.h
+* Author             : WCH
+* Version            : V1.0.0
+* Date               : 2026/10/19
+* Description        : This file contains all the functions prototypes for the
+*                      PD structured VDM (Discover Identity/SVIDs/Modes).
+*********************************************************************************
+* Copyright (c) 2021 Nanjing Qinheng Microelectronics Co., Ltd.
+* Attention: This software (modified or not) and binary are used for
+* microcontroller manufactured by Nanjing Qinheng Microelectronics.
+*******************************************************************************/
+
+#ifndef USER_PD_VDM_H_
+#define USER_PD_VDM_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/******************************************************************************/
+/* Structured VDM Header
+   BIT[31:16] - Standard or Vendor ID (SVID)
+   BIT15 - VDM Type, 1: Structured VDM
+   BIT[14:13] - Structured VDM Version (Major), 00: V1.0; 01: V2.x
+   BIT[12:11] - Structured VDM Version (Minor)
+   BIT[10:8] - Object Position
+   BIT[7:6] - Command Type, 00: REQ; 01: ACK; 10: NAK; 11: BUSY
+   BIT5 - Reserved
+   BIT[4:0] - Command
+*/
+#define DEF_VDM_SVID_PD_SID        0xFF00                                       /* PD Standard ID */
+#define DEF_VDM_SVID_VENDOR        0x1A86                                       /* SVID reported by this device */
+
+#define DEF_VDM_CMD_TYPE_MASK      0xC0
+#define DEF_VDM_CMD_TYPE_REQ       0x00
+#define DEF_VDM_CMD_TYPE_ACK       0x40
+#define DEF_VDM_CMD_TYPE_NAK       0x80
+#define DEF_VDM_CMD_TYPE_BUSY      0xC0
+#define DEF_VDM_CMD_MASK           0x1F
+
+#define DEF_VDM_STRUCTURED         0x80                                         /* VDM header byte 1 */
+#define DEF_VDM_VER_MASK           0x60                                         /* VDM header byte 1 */
+#define DEF_VDM_VER_20             0x20                                         /* VDM header byte 1 */
+
+/* Build one little-endian VDO into a byte table */
+#define DEF_VDO( v )               (UINT8)( v ), (UINT8)( ( v ) >> 8 ), (UINT8)( ( v ) >> 16 ), (UINT8)( ( v ) >> 24 )
+
+/* VDM response timeout, tVDMSenderResponse (ms) */
+#define DEF_VDM_SENDER_RESP_TMR    27
+/* Wait after a BUSY response before the request is repeated, tVDMBusy (ms) */
+#define DEF_VDM_BUSY_TMR           50
+/* Number of VDM request retries after a response timeout or BUSY */
+#define DEF_VDM_RETRY_MAX          2
+
+#define DEF_VDM_SVID_MAX           4                                            /* SVIDs kept per partner */
+#define DEF_VDM_MODE_MAX           6                                            /* Modes kept per SVID */
+
+/* Discovery status */
+#define DEF_VDM_DISC_NONE          0x00
+#define DEF_VDM_DISC_IDENT_OK      0x01
+#define DEF_VDM_DISC_SVID_OK       0x02
+#define DEF_VDM_DISC_MODE_OK       0x04
+#define DEF_VDM_DISC_NAK           0x40
+#define DEF_VDM_DISC_NO_RESP       0x80
+
+/******************************************************************************/
+/* Discovery results of the port partner (SOP) or cable plug (SOP') */
+typedef struct _PD_VDM_PARTNER
+{
+    UINT32 ID_Header;                                                           /* ID Header VDO */
+    UINT32 Cert_Stat;                                                           /* Cert Stat VDO */
+    UINT32 Product;                                                             /* Product VDO */
+    UINT32 Product_Type[ 3 ];                                                   /* Product Type VDOs, e.g. passive cable VDO */
+    UINT8  Product_Type_Num;
+    UINT8  SVID_Num;
+    UINT16 SVID[ DEF_VDM_SVID_MAX ];
+    UINT8  Mode_Num[ DEF_VDM_SVID_MAX ];
+    UINT32 Mode[ DEF_VDM_SVID_MAX ][ DEF_VDM_MODE_MAX ];
+    UINT8  Status;                                                              /* DEF_VDM_DISC_xx */
+}PD_VDM_PARTNER, *pPD_VDM_PARTNER;
+
+/******************************************************************************/
+/* Variable extents */
+extern PD_VDM_PARTNER PD_VDM_Port;
+extern PD_VDM_PARTNER PD_VDM_Cable;
+
+/******************************************************************************/
+/* Function extensibility */
+extern void PD_VDM_Init( void );
+extern void PD_VDM_Discovery_Start( UINT8 cable );
+extern UINT8 PD_VDM_Request( UINT8 sop, UINT8 cmd, UINT16 svid );
+extern void PD_VDM_Rx_Handle( UINT8 sop );
+extern void PD_VDM_Proc( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_PD_VDM_H_ */
@@ -22,6 +22,9 @@
  * The inability to control the VBUS voltage on the board may lead to some compatibility problems,
  * mainly manifested in the inability of some devices to complete the PD communication process.
  *
+ * After the explicit contract is established, Discover Identity is sent to the cable (SOP')
+ * and the port partner (SOP), followed by Discover SVIDs/Modes for modal partners (PD_VDM.c).
+ *
  */
 
 #include "debug.h"